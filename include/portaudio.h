@@ -471,8 +471,17 @@ typedef double PaTime;
  The standard formats paFloat32, paInt16, paInt32, paInt24, paInt8
  and aUInt8 are usually implemented by all implementations.
 
- The floating point representation (paFloat32) uses +1.0 and -1.0 as the
- maximum and minimum respectively.
+ The floating point representations (paFloat32 and paFloat64) use +1.0 and
+ -1.0 as the maximum and minimum respectively. paFloat64 is rarely supported
+ by host APIs, but is converted directly to the host format, so
+ applications which process audio in double precision don't need to convert
+ to paFloat32 first.
+
+ paInt24In32 holds a 24 bit sample in the least significant 24 bits of a
+ native endian 32 bit word (SND_PCM_FORMAT_S24 in ALSA). Samples written by
+ PortAudio are sign extended into the most significant byte, which is
+ ignored when samples are read. Many audio devices use this layout natively
+ instead of the packed 3 byte paInt24.
 
  paUInt8 is an unsigned 8 bit format where 128 is considered "ground"
 
@@ -483,7 +492,7 @@ typedef double PaTime;
 
  @see Pa_OpenStream, Pa_OpenDefaultStream, PaDeviceInfo
  @see paFloat32, paInt16, paInt32, paInt24, paInt8
- @see paUInt8, paCustomFormat, paNonInterleaved
+ @see paUInt8, paFloat64, paInt24In32, paCustomFormat, paNonInterleaved
 */
 typedef unsigned long PaSampleFormat;
 
@@ -494,6 +503,8 @@ typedef unsigned long PaSampleFormat;
 #define paInt16          ((PaSampleFormat) 0x00000008) /**< @see PaSampleFormat */
 #define paInt8           ((PaSampleFormat) 0x00000010) /**< @see PaSampleFormat */
 #define paUInt8          ((PaSampleFormat) 0x00000020) /**< @see PaSampleFormat */
+#define paFloat64        ((PaSampleFormat) 0x00000040) /**< @see PaSampleFormat */
+#define paInt24In32      ((PaSampleFormat) 0x00000080) /**< 24 bit samples in 32 bit words. @see PaSampleFormat */
 #define paCustomFormat   ((PaSampleFormat) 0x00010000) /**< @see PaSampleFormat */
 
 #define paNonInterleaved ((PaSampleFormat) 0x80000000) /**< @see PaSampleFormat */
@@ -652,7 +663,8 @@ typedef void PaStream;
 
  @see Pa_OpenStream, Pa_OpenDefaultStream
  @see paNoFlag, paClipOff, paDitherOff, paNeverDropInput,
-  paPrimeOutputBuffersUsingStreamCallback, paPlatformSpecificFlags
+  paPrimeOutputBuffersUsingStreamCallback, paNoiseShapedDither,
+  paPipelineCallback, paConvertSampleRate, paPlatformSpecificFlags
 */
 typedef unsigned long PaStreamFlags;
 
@@ -688,6 +700,76 @@ typedef unsigned long PaStreamFlags;
 */
 #define   paPrimeOutputBuffersUsingStreamCallback ((PaStreamFlags) 0x00000008)
 
+/** Use triangular dither with second order noise shaping, which moves the
+ dither and quantization noise towards high frequencies, instead of the
+ default triangular dither when converting paFloat32 samples to paInt16,
+ paInt8 or paUInt8. Each channel is dithered independently. Conversions to
+ other formats use the default dither. This flag has no effect when
+ paDitherOff is also specified.
+
+ @see PaStreamFlags, paDitherOff
+*/
+#define   paNoiseShapedDither ((PaStreamFlags) 0x00000010)
+
+/** Run the stream callback on a separate worker thread, a number of buffers
+ ahead of the host API's audio thread, so that an occasional slow callback
+ does not cause an output underflow. The stream callback is then always called
+ with the same number of frames, which is framesPerBuffer, or the host buffer
+ size when framesPerBuffer is paFramesPerBufferUnspecified. The added latency
+ is included in the outputLatency field of PaStreamInfo. The lookahead is two
+ buffers unless it is set with paPipelineLookahead(). This flag is only valid
+ for callback streams, and can not be combined with paNeverDropInput.
+ Host APIs which do not support it ignore it; the flags field of PaStreamInfo
+ contains paStreamInfoPipelinedCallback when it is in effect.
+
+ @see PaStreamFlags, paPipelineLookahead
+*/
+#define   paPipelineCallback ((PaStreamFlags) 0x00000020)
+
+/** The bits of PaStreamFlags which hold the lookahead set with
+ paPipelineLookahead().
+ @see PaStreamFlags
+*/
+#define   paPipelineLookaheadMask ((PaStreamFlags) 0x00000F00)
+
+/** Combined with paPipelineCallback, sets the number of buffers, from 1 to
+ 15, by which the stream callback runs ahead of the host API.
+ @see paPipelineCallback
+*/
+#define   paPipelineLookahead( buffers ) ((PaStreamFlags) (((buffers) & 0x0F) << 8))
+
+/** Open the devices at the closest rate they support when it differs from
+ the requested sample rate, and convert between the two rates with a
+ polyphase filter, so that the stream callback runs at the requested rate.
+ The filter delay is included in the latency fields of PaStreamInfo, and its
+ flags field contains paStreamInfoSampleRateConverted when a conversion takes
+ place. The quality is medium unless paSampleRateConversionFast or
+ paSampleRateConversionBest is also specified. This flag is only valid for
+ callback streams. Host APIs which do not support it ignore it.
+
+ @see PaStreamFlags, paSampleRateConversionQualityMask
+*/
+#define   paConvertSampleRate ((PaStreamFlags) 0x00000040)
+
+/** The bits of PaStreamFlags which select the sample rate conversion quality.
+ @see paConvertSampleRate
+*/
+#define   paSampleRateConversionQualityMask ((PaStreamFlags) 0x00003000)
+
+/** Combined with paConvertSampleRate, uses a shorter filter which costs about
+ a third of the default one, with about 60 dB of alias rejection and a narrower
+ passband.
+ @see paConvertSampleRate
+*/
+#define   paSampleRateConversionFast ((PaStreamFlags) 0x00001000)
+
+/** Combined with paConvertSampleRate, uses a longer filter which costs about
+ twice the default one, with about 105 dB of alias rejection and a wider
+ passband, instead of the default's 85 dB.
+ @see paConvertSampleRate
+*/
+#define   paSampleRateConversionBest ((PaStreamFlags) 0x00002000)
+
 /** A mask specifying the platform specific bits.
  @see PaStreamFlags
 */
@@ -1039,13 +1121,53 @@ PaError Pa_IsStreamActive( PaStream *stream );
 
 
 
-/** A structure containing unchanging information about an open stream.
+/** Flags describing how an open stream moves audio between the host API and
+ the stream callback, reported in the flags field of PaStreamInfo.
+ @see PaStreamInfo, paStreamInfoInputPassThrough, paStreamInfoOutputPassThrough,
+ paStreamInfoPipelinedCallback, paStreamInfoSampleRateConverted,
+ paStreamInfoAlignedBuffers
+*/
+typedef unsigned long PaStreamInfoFlags;
+
+/** The most recent input buffer was passed to the stream callback as a pointer
+ into the host API's buffer, without being copied. Samples are still converted
+ in place when the host format is paInt32 and the user format is paFloat32.
+*/
+#define paStreamInfoInputPassThrough   ((PaStreamInfoFlags) 0x00000001)
+
+/** The stream callback wrote the most recent output buffer directly into the
+ host API's buffer, without it being copied. Samples are still converted
+ in place when the user format is paFloat32 and the host format is paInt32.
+*/
+#define paStreamInfoOutputPassThrough  ((PaStreamInfoFlags) 0x00000002)
+
+/** The stream callback runs on a worker thread ahead of the host API.
+ @see paPipelineCallback
+*/
+#define paStreamInfoPipelinedCallback  ((PaStreamInfoFlags) 0x00000004)
+
+/** The host API runs at a different sample rate than the stream callback,
+ which is the sampleRate field of PaStreamInfo, and the buffer processor
+ converts between the two. The pass through flags are then never set.
+ @see paConvertSampleRate
+*/
+#define paStreamInfoSampleRateConverted  ((PaStreamInfoFlags) 0x00000008)
+
+/** Every buffer passed to the stream callback starts on a 64 byte boundary,
+ and so does every channel of a non-interleaved buffer, so that callbacks can
+ use aligned vector loads and stores. Host buffers are only passed through
+ when they are aligned too.
+*/
+#define paStreamInfoAlignedBuffers  ((PaStreamInfoFlags) 0x00000010)
+
+
+/** A structure containing information about an open stream.
  @see Pa_GetStreamInfo
 */
 
 typedef struct PaStreamInfo
 {
-    /** this is struct version 1 */
+    /** this is struct version 2 */
     int structVersion;
 
     /** The input latency of the stream in seconds. This value provides the most
@@ -1073,6 +1195,13 @@ typedef struct PaStreamInfo
     */
     double sampleRate;
 
+    /** A combination of PaStreamInfoFlags. The pass-through flags describe
+     the buffers most recently processed by the stream callback, and are
+     updated each time Pa_GetStreamInfo() is called.
+     Only present when structVersion is at least 2.
+    */
+    PaStreamInfoFlags flags;
+
 } PaStreamInfo;
 
 
@@ -1092,6 +1221,94 @@ typedef struct PaStreamInfo
 const PaStreamInfo* Pa_GetStreamInfo( PaStream *stream );
 
 
+/** A structure containing counters describing the operation of an open
+ stream, filled in by Pa_GetStreamStatistics().
+
+ @see Pa_GetStreamStatistics
+*/
+typedef struct PaStreamStatistics
+{
+    /** The version of this structure. The caller sets this to the version it
+     was compiled against (2) before calling Pa_GetStreamStatistics(), which
+     only fills in fields belonging to that version and sets structVersion to
+     the version it actually filled in.
+    */
+    int structVersion;
+
+    /** The number of input samples which were out of range of the user sample
+     format and were clipped when converting from the host sample format. Only
+     conversions to integer user formats clip. Always zero (0) for output-only
+     streams.
+    */
+    unsigned long inputClippedSamples;
+
+    /** The number of output samples which were out of range of the host
+     sample format and were clipped when converting from the user sample
+     format. Samples are not clipped, and so are not counted, when the stream
+     was opened with the paClipOff flag. Always zero (0) for input-only streams.
+    */
+    unsigned long outputClippedSamples;
+
+    /* The fields below were added in version 2. The timing fields are
+     estimated from histograms whose buckets are a quarter of an octave wide,
+     and report the upper limit of the bucket, so they may be up to 25% too
+     large. Times above about a second are reported as about a second. */
+
+    /** The number of times the stream callback was called. Host APIs which
+     measure the CPU load of blocking streams count reads or writes instead.
+    */
+    unsigned long callbackCount;
+
+    /** Percentiles and maximum of the time spent processing audio in each
+     callback, in seconds. */
+    PaTime medianCallbackDuration;
+    PaTime callbackDuration99thPercentile;
+    PaTime maxCallbackDuration;
+
+    /** The number of callbacks which took longer than the duration of the
+     frames they processed, and so risked an xrun. */
+    unsigned long deadlineMisses;
+
+    /** Percentiles and maximum of the wakeup jitter in seconds: the
+     difference between the time from the start of one callback to the start
+     of the next, and the duration of the frames processed by the first. */
+    PaTime medianWakeupJitter;
+    PaTime wakeupJitter99thPercentile;
+    PaTime maxWakeupJitter;
+
+    /** The number of times each kind of xrun was reported, see
+     PaStreamCallbackFlags. */
+    unsigned long inputUnderflows;
+    unsigned long inputOverflows;
+    unsigned long outputUnderflows;
+    unsigned long outputOverflows;
+
+} PaStreamStatistics;
+
+
+/** Retrieve counters describing the operation of a stream since it was
+ opened, or since the previous call to Pa_GetStreamStatistics() for that
+ stream. Reading the counters resets them to zero.
+
+ @param stream A pointer to an open stream previously created with Pa_OpenStream.
+
+ @param statistics A pointer to a PaStreamStatistics structure whose
+ structVersion field has been set by the caller, which receives the counters.
+
+ @return paNoError on success, or an error code if the stream parameter is
+ invalid or statistics is NULL.
+
+ @note The counters are updated by the thread which processes the stream's
+ audio, and may be read from any thread, but only from one at a time. Host
+ APIs which do not use the common buffer processor report zero for the sample
+ and xrun counters, and those which do not measure the CPU load report zero
+ for the timing fields.
+
+ @see PaStreamStatistics
+*/
+PaError Pa_GetStreamStatistics( PaStream *stream, PaStreamStatistics *statistics );
+
+
 /** Returns the current time in seconds for a stream according to the same clock used
  to generate callback PaStreamCallbackTimeInfo timestamps. The time values are
  monotonically increasing and have unspecified origin.
@@ -1190,6 +1407,58 @@ PaError Pa_WriteStream( PaStream* stream,
                         unsigned long frames );
 
 
+/** Read samples from an input stream like Pa_ReadStream(), but give up
+ waiting for them after a timeout, so that a stalled device can't block the
+ calling thread indefinitely.
+
+ Timed reads are supported by the ALSA, JACK, PulseAudio and OSS host APIs.
+
+ @param stream A pointer to an open blocking stream with input.
+
+ @param buffer Like the buffer of Pa_ReadStream().
+
+ @param frames The number of frames to read.
+
+ @param timeout The longest time to wait, in seconds. 0 reads only the
+ frames which are available already.
+
+ @param framesRead If not NULL, receives the number of frames which were read
+ into the beginning of the buffer, also when an error is returned.
+
+ @return paNoError when all frames were read, paTimedOut if the timeout
+ passed first, paIncompatibleStreamHostApi if the host API doesn't support
+ timed reads, or any error which Pa_ReadStream() returns.
+*/
+PaError Pa_ReadStreamTimeout( PaStream* stream, void *buffer, unsigned long frames,
+                              PaTime timeout, unsigned long *framesRead );
+
+
+/** Write samples to an output stream like Pa_WriteStream(), but give up
+ waiting for space after a timeout, so that a stalled device can't block the
+ calling thread indefinitely.
+
+ Timed writes are supported by the ALSA, JACK, PulseAudio and OSS host APIs.
+
+ @param stream A pointer to an open blocking stream with output.
+
+ @param buffer Like the buffer of Pa_WriteStream().
+
+ @param frames The number of frames to write.
+
+ @param timeout The longest time to wait, in seconds. 0 writes only as many
+ frames as there is space for already.
+
+ @param framesWritten If not NULL, receives the number of frames from the
+ beginning of the buffer which were written, also when an error is returned.
+
+ @return paNoError when all frames were written, paTimedOut if the timeout
+ passed first, paIncompatibleStreamHostApi if the host API doesn't support
+ timed writes, or any error which Pa_WriteStream() returns.
+*/
+PaError Pa_WriteStreamTimeout( PaStream* stream, const void *buffer, unsigned long frames,
+                               PaTime timeout, unsigned long *framesWritten );
+
+
 /** Retrieve the number of frames that can be read from the stream without
  waiting.
 
@@ -1218,6 +1487,136 @@ signed long Pa_GetStreamReadAvailable( PaStream* stream );
 signed long Pa_GetStreamWriteAvailable( PaStream* stream );
 
 
+/** Retrieve a file descriptor which becomes readable when at least 'frames'
+ frames can be read from a blocking stream, or written to it for output-only
+ streams, without blocking. Full-duplex streams are paced by their input. The
+ descriptor can be waited for with poll(), select() or epoll together with
+ other descriptors, so that a single thread can service many streams.
+
+ The descriptor belongs to the stream: it must not be read from or closed,
+ and it is closed by Pa_CloseStream(). It stays readable while the condition
+ holds, but it may also become readable spuriously, so check
+ Pa_GetStreamReadAvailable() or Pa_GetStreamWriteAvailable() before reading or
+ writing. The descriptor also becomes readable when the host API stops the
+ stream or detects an error, which the next Pa_ReadStream() or
+ Pa_WriteStream() reports.
+
+ Calling Pa_GetStreamReadyFileDescriptor() again changes the number of frames
+ and returns the same descriptor. Some host APIs can only wake up at a
+ multiple of their buffer size, and on ALSA the number of frames also becomes
+ the minimum transfer of Pa_ReadStream() and Pa_WriteStream().
+
+ @param stream A pointer to a blocking stream previously created with
+ Pa_OpenStream.
+
+ @param frames The number of frames at which the descriptor becomes readable.
+ 0 is treated as 1, and values larger than the host buffer are reduced to its
+ size.
+
+ @param fileDescriptor Receives the descriptor.
+
+ @return paNoError on success, paBadBufferPtr if fileDescriptor is NULL,
+ paIncompatibleStreamHostApi for callback streams and for host APIs or
+ platforms which can't provide a descriptor, or paUnanticipatedHostError.
+*/
+PaError Pa_GetStreamReadyFileDescriptor( PaStream* stream, unsigned long frames, int *fileDescriptor );
+
+
+/** Get a region which the application can fill with output for a blocking
+ stream, without first preparing the samples in a buffer of its own. Where
+ the sample format and channel layout of the stream match the host's, the
+ region is the host API's own memory: the ALSA mmap area, or the blocking
+ queue of JACK and PulseAudio. Otherwise it is a bounce buffer which
+ Pa_CommitWriteBuffer() passes to Pa_WriteStream().
+
+ Pa_AcquireWriteBuffer() never blocks, and may return fewer frames than
+ requested or none at all. Use Pa_GetStreamWriteAvailable() or
+ Pa_GetStreamReadyFileDescriptor() to wait for space. Every call which
+ returns frames must be followed by Pa_CommitWriteBuffer() before the next
+ one.
+
+ @param stream A pointer to an open blocking stream with output.
+
+ @param buffer Receives the region. For non-interleaved sample formats it is
+ an array of pointers to each channel, like the buffer of Pa_WriteStream().
+
+ @param frames On entry the largest number of frames wanted, on exit the
+ number of frames in the region.
+
+ @param isZeroCopy If not NULL, receives 1 if the region is host API memory
+ and 0 for a bounce buffer.
+
+ @return paNoError on success, paBadBufferPtr if buffer or frames is NULL or
+ the previous region wasn't committed, paStreamIsStopped, or an error from
+ the host API.
+
+ @see Pa_CommitWriteBuffer
+*/
+PaError Pa_AcquireWriteBuffer( PaStream* stream, void **buffer, unsigned long *frames, int *isZeroCopy );
+
+
+/** Queue the first frames of the region returned by the last call to
+ Pa_AcquireWriteBuffer() for output. The rest of the region is discarded.
+
+ @param stream A pointer to an open blocking stream with output.
+
+ @param frames The number of frames to queue, at most the number which was
+ acquired.
+
+ @return paNoError on success, paBufferTooBig if frames is larger than the
+ acquired region, paOutputUnderflowed if additional output data was inserted
+ after the previous call and before this call, or an error from the host API.
+*/
+PaError Pa_CommitWriteBuffer( PaStream* stream, unsigned long frames );
+
+
+/** Get a region holding input of a blocking stream which the application can
+ process in place. Where the sample format and channel layout of the stream
+ match the host's, the region is the host API's own memory, otherwise it is
+ a bounce buffer filled by Pa_ReadStream().
+
+ Pa_AcquireReadBuffer() never blocks, and may return fewer frames than
+ requested or none at all. Use Pa_GetStreamReadAvailable() or
+ Pa_GetStreamReadyFileDescriptor() to wait for input. Every call which
+ returns frames must be followed by Pa_ReleaseReadBuffer() before the next
+ one.
+
+ @param stream A pointer to an open blocking stream with input.
+
+ @param buffer Receives the region. For non-interleaved sample formats it is
+ an array of pointers to each channel, like the buffer of Pa_ReadStream().
+
+ @param frames On entry the largest number of frames wanted, on exit the
+ number of frames in the region.
+
+ @param isZeroCopy If not NULL, receives 1 if the region is host API memory
+ and 0 for a bounce buffer.
+
+ @return paNoError on success, paInputOverflowed if input data was discarded
+ before this call (the region is valid nevertheless), paBadBufferPtr if
+ buffer or frames is NULL or the previous region wasn't released,
+ paStreamIsStopped, or an error from the host API.
+
+ @see Pa_ReleaseReadBuffer
+*/
+PaError Pa_AcquireReadBuffer( PaStream* stream, const void **buffer, unsigned long *frames, int *isZeroCopy );
+
+
+/** Consume the first frames of the region returned by the last call to
+ Pa_AcquireReadBuffer(). Frames which are not consumed are returned again
+ by the next call to Pa_AcquireReadBuffer().
+
+ @param stream A pointer to an open blocking stream with input.
+
+ @param frames The number of frames to consume, at most the number which was
+ acquired.
+
+ @return paNoError on success, paBufferTooBig if frames is larger than the
+ acquired region, or an error from the host API.
+*/
+PaError Pa_ReleaseReadBuffer( PaStream* stream, unsigned long frames );
+
+
 /* Miscellaneous utilities */
 
 
@@ -1229,6 +1628,263 @@ signed long Pa_GetStreamWriteAvailable( PaStream* stream );
 PaError Pa_GetSampleSize( PaSampleFormat format );
 
 
+/** Opaque state passed to sample converters. */
+struct PaSampleConverterState;
+
+/** Functions of type PaSampleConverter convert count samples from
+ sourceBuffer to destinationBuffer. They are called by PortAudio's buffer
+ processor in place of its built-in converters, see Pa_RegisterConverter()
+ and Pa_SetStreamConverters().
+
+ @param destinationBuffer A pointer to the first destination sample.
+
+ @param destinationStride The distance between successive destination samples,
+ in samples. It may be negative.
+
+ @param sourceBuffer A pointer to the first source sample.
+
+ @param sourceStride The distance between successive source samples, in samples.
+ It may be negative.
+
+ @param count The number of samples to convert.
+
+ @param state State used by PortAudio's dithering converters. Converters
+ supplied by the application should ignore it.
+
+ @note Converters are called from the thread which processes the stream's
+ audio, with the same restrictions as PaStreamCallback.
+*/
+typedef void PaSampleConverter(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaSampleConverterState *state );
+
+
+/** Register a converter to be used by streams which are opened afterwards,
+ whenever they convert from sourceFormat to destinationFormat with the given
+ flags. A converter may also be registered for equal source and destination
+ formats, in which case it replaces the plain copy. Registered converters
+ remain registered until they are removed, including across Pa_Terminate()
+ and Pa_Initialize().
+
+ @param sourceFormat The format of the samples which are converted. For input
+ this is the host format, for output the user format passed to Pa_OpenStream().
+ paNonInterleaved is ignored. paCustomFormat is not supported because the size
+ of its samples is unknown.
+
+ @param destinationFormat The format the samples are converted to.
+
+ @param flags The combination of paClipOff, paDitherOff and
+ paNoiseShapedDither with which the stream was opened that the converter
+ applies to. Other flags are not allowed.
+
+ @param converter The converter, or NULL to remove the converter registered
+ for these formats and flags.
+
+ @return paNoError on success, paSampleFormatNotSupported or paInvalidFlag if a
+ parameter is invalid, or paInsufficientMemory if too many converters are
+ registered.
+
+ @note This function is not thread safe. It must not be called while another
+ thread opens a stream.
+
+ @see PaSampleConverter, Pa_SetStreamConverters
+*/
+PaError Pa_RegisterConverter( PaSampleFormat sourceFormat, PaSampleFormat destinationFormat,
+        PaStreamFlags flags, PaSampleConverter *converter );
+
+
+/** Replace the converters selected for an open stream when it was opened.
+
+ @param stream A pointer to a stopped stream previously created with
+ Pa_OpenStream.
+
+ @param inputConverter The converter from the host input format to the user
+ input format, or NULL to keep the current one. Ignored for output-only
+ streams.
+
+ @param outputConverter The converter from the user output format to the host
+ output format, or NULL to keep the current one. Ignored for input-only
+ streams.
+
+ @return paNoError on success, paStreamIsNotStopped if the stream is running,
+ paIncompatibleStreamHostApi if the stream's host API does not use
+ PortAudio's buffer processor, or paInvalidFlag if the stream's sample rate is
+ converted (see paStreamInfoSampleRateConverted).
+
+ @see PaSampleConverter, Pa_RegisterConverter
+*/
+PaError Pa_SetStreamConverters( PaStream *stream,
+        PaSampleConverter *inputConverter, PaSampleConverter *outputConverter );
+
+
+/** The channels processed by one call of a PaStreamChannelGroupCallback.
+
+ @see Pa_SetStreamChannelGroupCallback
+*/
+typedef struct PaStreamChannelGroup
+{
+    unsigned int groupIndex;        /**< the index of the group, starting at 0 */
+
+    int firstInputChannel;          /**< the stream input channel of input[0] */
+    int inputChannelCount;          /**< the number of input channels, may be 0 */
+    const void * const *input;      /**< non-interleaved input buffers, NULL if inputChannelCount is 0 */
+
+    int firstOutputChannel;         /**< the stream output channel of output[0] */
+    int outputChannelCount;         /**< the number of output channels, may be 0 */
+    void * const *output;           /**< non-interleaved output buffers, NULL if outputChannelCount is 0 */
+} PaStreamChannelGroup;
+
+
+/** Functions of type PaStreamChannelGroupCallback process one group of
+ channels of a stream in place of its PaStreamCallback. The groups of a
+ buffer are processed in parallel, so a callback must not access the
+ channels of other groups. The parameters and return value are those of
+ PaStreamCallback, except that input and output are replaced by group.
+
+ @see Pa_SetStreamChannelGroupCallback
+*/
+typedef int PaStreamChannelGroupCallback(
+    const PaStreamChannelGroup *group, unsigned long frameCount,
+    const PaStreamCallbackTimeInfo* timeInfo,
+    PaStreamCallbackFlags statusFlags,
+    void *userData );
+
+
+/** Split the processing of a callback stream with many channels between
+ several threads. Instead of calling the stream callback passed to
+ Pa_OpenStream, PortAudio divides the input and output channels into groups
+ of channelsPerGroup consecutive channels and calls groupCallback once for
+ every group of each buffer. The calls run in parallel on the stream's
+ audio thread and a pool of worker threads which, where the platform allows,
+ use real-time scheduling and are each pinned to a processor. All calls for
+ a buffer have returned before its output is converted to the host format.
+
+ The stream's result for a buffer is paAbort if any group returned
+ paAbort, otherwise paComplete if any group returned paComplete.
+
+ @param stream A pointer to a stopped callback stream previously created with
+ Pa_OpenStream. Both the input and output sample formats must include
+ paNonInterleaved.
+
+ @param groupCallback The group callback, which is passed the userData given
+ to Pa_OpenStream, or NULL to go back to the stream callback and release the
+ worker threads.
+
+ @param channelsPerGroup The number of input and of output channels in each
+ group. The last group holds the remaining channels.
+
+ @param threadCount The number of threads which process groups, including
+ the stream's audio thread, or 0 for one per processor. No more threads are
+ used than there are groups.
+
+ @return paNoError on success, paStreamIsNotStopped if the stream is running,
+ paIncompatibleStreamHostApi if the stream's host API does not use
+ PortAudio's buffer processor, paNullCallback for blocking streams,
+ paInvalidFlag for streams opened with paPipelineCallback or whose sample
+ rate is converted, paSampleFormatNotSupported if the user buffers are interleaved,
+ paInvalidChannelCount if channelsPerGroup is less than 1, or
+ paInsufficientMemory or paUnanticipatedHostError if the worker threads
+ could not be created.
+
+ @see PaStreamChannelGroupCallback
+*/
+PaError Pa_SetStreamChannelGroupCallback( PaStream *stream,
+        PaStreamChannelGroupCallback *groupCallback, int channelsPerGroup,
+        unsigned int threadCount );
+
+
+/** Route the output channels rendered by the stream callback to the device
+ channels through a matrix of gains, so that a callback can render fewer (or
+ more) channels than the device was opened with. The matrix is applied while
+ the output is converted to the host format. A device channel whose row is
+ all zeros is filled with silence without reading the callback's buffer, and
+ a row holding a single gain of 1 copies one callback channel, so sparse maps
+ work with every sample format. Rows which mix several channels, or scale
+ one, require paFloat32 output.
+
+ Once the matrix is set the output buffer passed to the callback holds
+ userChannelCount channels, in the sample format given to Pa_OpenStream.
+
+ @param stream A pointer to a stopped callback stream with output, previously
+ created with Pa_OpenStream.
+
+ @param userChannelCount The number of channels the callback renders.
+ Ignored when matrix is NULL.
+
+ @param matrix The gains, one row of userChannelCount gains for each of the
+ outputParameters->channelCount device channels. The gain of callback channel
+ u in device channel d is matrix[ d * userChannelCount + u ]. The matrix is
+ copied. NULL removes the matrix so that the callback renders every device
+ channel again.
+
+ @return paNoError on success, paStreamIsNotStopped if the stream is running,
+ paIncompatibleStreamHostApi if the stream's host API does not use
+ PortAudio's buffer processor, paNullCallback for blocking streams,
+ paInvalidFlag for streams opened with paPipelineCallback or whose sample
+ rate is converted, paInvalidChannelCount if the stream has no output or
+ userChannelCount is less than 1, paSampleFormatNotSupported if a row mixes
+ and the output format is not paFloat32, or paInsufficientMemory.
+*/
+PaError Pa_SetStreamOutputChannelMatrix( PaStream *stream,
+        int userChannelCount, const float *matrix );
+
+
+/** Set a gain which is applied to the output of a stream while it is
+ converted to the host format, so that it costs no extra pass over the
+ samples. The gain may be changed while the stream is running, without
+ locking: it takes effect at the start of the next host buffer and ramps
+ linearly from the current gain over rampFrames frames. A gain of 1.0, the
+ default, costs nothing.
+
+ Pa_SetStreamGain() may be called from any thread, but not from several
+ threads at the same time.
+
+ @param stream A pointer to a stream with output, previously created with
+ Pa_OpenStream.
+
+ @param gain The new gain, a linear factor. 0.0 fills the output with silence.
+
+ @param rampFrames The length of the ramp in frames. The last frame of the
+ ramp has the new gain. 0 applies the gain at once.
+
+ @return paNoError on success, paIncompatibleStreamHostApi if the stream's
+ host API does not use PortAudio's buffer processor, paInvalidChannelCount if
+ the stream has no output, or paSampleFormatNotSupported if the gain is not
+ 1.0 and the output sample format can not be converted to and from paFloat32.
+
+ @see Pa_SetStreamFades
+*/
+PaError Pa_SetStreamGain( PaStream *stream, float gain, unsigned long rampFrames );
+
+
+/** Fade the output of a stream in when it is started, and out when it is
+ stopped or aborted, so that it does not start or end with a click. The fades
+ are applied with the gain of Pa_SetStreamGain(): Pa_StartStream() ramps up
+ from silence to that gain, and Pa_StopStream() and Pa_AbortStream() ramp
+ down to silence and wait for the end of the ramp before stopping the
+ stream. Pa_AbortStream() also waits for the stream's output latency, so
+ that the fade is heard before the buffers are discarded. A stream stopped by
+ its callback is not faded out.
+
+ The fade out is only applied to callback streams. A call of Pa_SetStreamGain()
+ during the fade out replaces it.
+
+ @param stream A pointer to a stream with output, previously created with
+ Pa_OpenStream.
+
+ @param fadeInFrames The length of the fade in, in frames, 0 for none.
+
+ @param fadeOutFrames The length of the fade out, in frames, 0 for none.
+
+ @return paNoError on success, paIncompatibleStreamHostApi if the stream's
+ host API does not use PortAudio's buffer processor, paInvalidChannelCount if
+ the stream has no output, or paSampleFormatNotSupported if the output sample
+ format can not be converted to and from paFloat32.
+*/
+PaError Pa_SetStreamFades( PaStream *stream, unsigned long fadeInFrames, unsigned long fadeOutFrames );
+
+
 /** Put the caller to sleep for at least 'msec' milliseconds. This function is
  provided only as a convenience for authors of portable code (such as the tests
  and examples in the PortAudio distribution.)
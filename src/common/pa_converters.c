@@ -59,66 +59,148 @@
 */
 
 
+#include <string.h> /* for memset() */
+
 #include "pa_converters.h"
+#include "pa_simd_converters.h"
 #include "pa_dither.h"
 #include "pa_endianness.h"
 #include "pa_types.h"
 
 
+/* The sample formats from best to worst quality. paFloat64 and paInt24In32
+    were added after the other formats, so the order of their bit values can't
+    be relied upon. paInt24In32 comes before paInt24 because it is cheaper to
+    convert. */
+static const PaSampleFormat formatsByQuality_[] = {
+    paFloat64, paFloat32, paInt32, paInt24In32, paInt24, paInt16, paInt8, paUInt8, paCustomFormat };
+
+#define PA_FORMAT_COUNT_ (sizeof(formatsByQuality_) / sizeof(formatsByQuality_[0]))
+
 PaSampleFormat PaUtil_SelectClosestAvailableFormat(
         PaSampleFormat availableFormats, PaSampleFormat format )
 {
-    PaSampleFormat result;
+    unsigned int i, formatIndex;
 
     format &= ~paNonInterleaved;
     availableFormats &= ~paNonInterleaved;
 
-    if( (format & availableFormats) == 0 )
+    if( (format & availableFormats) != 0 )
+        return format;
+
+    for( formatIndex=0; formatIndex < PA_FORMAT_COUNT_; ++formatIndex )
     {
-        /* NOTE: this code depends on the sample format constants being in
-            descending order of quality - ie best quality is 0
-            FIXME: should write an assert which checks that all of the
-            known constants conform to that requirement.
-        */
+        if( formatsByQuality_[formatIndex] == format )
+            break;
+    }
+
+    if( formatIndex == PA_FORMAT_COUNT_ )
+        return paSampleFormatNotSupported;
+
+    /* scan for better formats */
+    for( i=formatIndex; i > 0; --i )
+    {
+        if( formatsByQuality_[i - 1] & availableFormats )
+            return formatsByQuality_[i - 1];
+    }
+
+    /* scan for worse formats */
+    for( i=formatIndex + 1; i < PA_FORMAT_COUNT_; ++i )
+    {
+        if( formatsByQuality_[i] & availableFormats )
+            return formatsByQuality_[i];
+    }
+
+    return paSampleFormatNotSupported;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Converters registered with Pa_RegisterConverter(). The table is only
+    searched when a stream is opened, so a linear search is fine. */
+
+#define PA_MAX_REGISTERED_CONVERTERS_   (32)
+
+/* the flags which select between converters for the same formats */
+#define PA_CONVERTER_FLAGS_     (paClipOff | paDitherOff | paNoiseShapedDither)
+
+typedef struct PaUtilRegisteredConverter
+{
+    PaSampleFormat sourceFormat;
+    PaSampleFormat destinationFormat;
+    PaStreamFlags flags;
+    PaUtilConverter *converter;
+} PaUtilRegisteredConverter;
+
+static PaUtilRegisteredConverter registeredConverters_[ PA_MAX_REGISTERED_CONVERTERS_ ];
+static int registeredConverterCount_ = 0;
+
+static int FindRegisteredConverterIndex( PaSampleFormat sourceFormat,
+        PaSampleFormat destinationFormat, PaStreamFlags flags )
+{
+    int i;
+
+    sourceFormat &= ~paNonInterleaved;
+    destinationFormat &= ~paNonInterleaved;
+    flags &= PA_CONVERTER_FLAGS_;
+
+    for( i=0; i < registeredConverterCount_; ++i )
+    {
+        if( registeredConverters_[i].sourceFormat == sourceFormat
+                && registeredConverters_[i].destinationFormat == destinationFormat
+                && registeredConverters_[i].flags == flags )
+            return i;
+    }
+
+    return -1;
+}
 
-        if( format != 0x01 )
+
+PaError PaUtil_RegisterConverter( PaSampleFormat sourceFormat,
+        PaSampleFormat destinationFormat, PaStreamFlags flags, PaUtilConverter *converter )
+{
+    int i = FindRegisteredConverterIndex( sourceFormat, destinationFormat, flags );
+
+    if( i >= 0 )
+    {
+        if( converter )
         {
-            /* scan for better formats */
-            result = format;
-            do
-            {
-                result >>= 1;
-            }
-            while( (result & availableFormats) == 0 && result != 0 );
+            registeredConverters_[i].converter = converter;
         }
         else
         {
-            result = 0;
-        }
-
-        if( result == 0 ){
-            /* scan for worse formats */
-            result = format;
-            do
-            {
-                result <<= 1;
-            }
-            while( (result & availableFormats) == 0 && result != paCustomFormat );
-
-            if( (result & availableFormats) == 0 )
-                result = paSampleFormatNotSupported;
+            /* unregister, keeping the table packed */
+            --registeredConverterCount_;
+            registeredConverters_[i] = registeredConverters_[ registeredConverterCount_ ];
         }
+    }
+    else if( converter )
+    {
+        if( registeredConverterCount_ == PA_MAX_REGISTERED_CONVERTERS_ )
+            return paInsufficientMemory;
 
-    }else{
-        result = format;
+        i = registeredConverterCount_++;
+        registeredConverters_[i].sourceFormat = sourceFormat & ~paNonInterleaved;
+        registeredConverters_[i].destinationFormat = destinationFormat & ~paNonInterleaved;
+        registeredConverters_[i].flags = flags & PA_CONVERTER_FLAGS_;
+        registeredConverters_[i].converter = converter;
     }
 
-    return result;
+    return paNoError;
+}
+
+
+PaUtilConverter* PaUtil_FindRegisteredConverter( PaSampleFormat sourceFormat,
+        PaSampleFormat destinationFormat, PaStreamFlags flags )
+{
+    int i = FindRegisteredConverterIndex( sourceFormat, destinationFormat, flags );
+
+    return ( i >= 0 ) ? registeredConverters_[i].converter : 0;
 }
 
 /* -------------------------------------------------------------------------- */
 
-#define PA_SELECT_FORMAT_( format, float32, int32, int24, int16, int8, uint8 ) \
+#define PA_SELECT_FORMAT_( format, float32, int32, int24, int16, int8, uint8, float64, int24In32 ) \
     switch( format & ~paNonInterleaved ){                                      \
     case paFloat32:                                                            \
         float32                                                                \
@@ -132,6 +214,10 @@ PaSampleFormat PaUtil_SelectClosestAvailableFormat(
         int8                                                                   \
     case paUInt8:                                                              \
         uint8                                                                  \
+    case paFloat64:                                                            \
+        float64                                                                \
+    case paInt24In32:                                                          \
+        int24In32                                                              \
     default: return 0;                                                         \
     }
 
@@ -154,6 +240,16 @@ PaSampleFormat PaUtil_SelectClosestAvailableFormat(
 
 /* -------------------------------------------------------------------------- */
 
+/* the noise shaping converters always clip, see NoiseShapeSample() */
+#define PA_SELECT_CONVERTER_NOISE_SHAPED_DITHER_CLIP_( flags, source, destination ) \
+    if( (flags & paNoiseShapedDither) && !(flags & paDitherOff) ){             \
+        return paConverters. source ## _To_ ## destination ## _NoiseShaped;    \
+    }else{                                                                     \
+        PA_SELECT_CONVERTER_DITHER_CLIP_( flags, source, destination )         \
+    }
+
+/* -------------------------------------------------------------------------- */
+
 #define PA_SELECT_CONVERTER_DITHER_( flags, source, destination )              \
     if( flags & paDitherOff ){ /* no dither */                                 \
         return paConverters. source ## _To_ ## destination;                    \
@@ -176,15 +272,22 @@ PaSampleFormat PaUtil_SelectClosestAvailableFormat(
 PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
         PaSampleFormat destinationFormat, PaStreamFlags flags )
 {
+    PaUtilConverter *registered = PaUtil_FindRegisteredConverter( sourceFormat, destinationFormat, flags );
+
+    if( registered )
+        return registered;
+
     PA_SELECT_FORMAT_( sourceFormat,
                        /* paFloat32: */
                        PA_SELECT_FORMAT_( destinationFormat,
                                           /* paFloat32: */        PA_UNITY_CONVERSION_( 32 ),
                                           /* paInt32: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float32, Int32 ),
                                           /* paInt24: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float32, Int24 ),
-                                          /* paInt16: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float32, Int16 ),
-                                          /* paInt8: */           PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float32, Int8 ),
-                                          /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float32, UInt8 )
+                                          /* paInt16: */          PA_SELECT_CONVERTER_NOISE_SHAPED_DITHER_CLIP_( flags, Float32, Int16 ),
+                                          /* paInt8: */           PA_SELECT_CONVERTER_NOISE_SHAPED_DITHER_CLIP_( flags, Float32, Int8 ),
+                                          /* paUInt8: */          PA_SELECT_CONVERTER_NOISE_SHAPED_DITHER_CLIP_( flags, Float32, UInt8 ),
+                                          /* paFloat64: */        PA_USE_CONVERTER_( Float32, Float64 ),
+                                          /* paInt24In32: */      PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float32, Int24In32 )
                                         ),
                        /* paInt32: */
                        PA_SELECT_FORMAT_( destinationFormat,
@@ -193,7 +296,9 @@ PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
                                           /* paInt24: */          PA_SELECT_CONVERTER_DITHER_( flags, Int32, Int24 ),
                                           /* paInt16: */          PA_SELECT_CONVERTER_DITHER_( flags, Int32, Int16 ),
                                           /* paInt8: */           PA_SELECT_CONVERTER_DITHER_( flags, Int32, Int8 ),
-                                          /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_( flags, Int32, UInt8 )
+                                          /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_( flags, Int32, UInt8 ),
+                                          /* paFloat64: */        PA_USE_CONVERTER_( Int32, Float64 ),
+                                          /* paInt24In32: */      PA_USE_CONVERTER_( Int32, Int24In32 )
                                         ),
                        /* paInt24: */
                        PA_SELECT_FORMAT_( destinationFormat,
@@ -202,7 +307,9 @@ PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
                                           /* paInt24: */          PA_UNITY_CONVERSION_( 24 ),
                                           /* paInt16: */          PA_SELECT_CONVERTER_DITHER_( flags, Int24, Int16 ),
                                           /* paInt8: */           PA_SELECT_CONVERTER_DITHER_( flags, Int24, Int8 ),
-                                          /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_( flags, Int24, UInt8 )
+                                          /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_( flags, Int24, UInt8 ),
+                                          /* paFloat64: */        PA_USE_CONVERTER_( Int24, Float64 ),
+                                          /* paInt24In32: */      PA_USE_CONVERTER_( Int24, Int24In32 )
                                         ),
                        /* paInt16: */
                        PA_SELECT_FORMAT_( destinationFormat,
@@ -211,7 +318,9 @@ PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
                                           /* paInt24: */          PA_USE_CONVERTER_( Int16, Int24 ),
                                           /* paInt16: */          PA_UNITY_CONVERSION_( 16 ),
                                           /* paInt8: */           PA_SELECT_CONVERTER_DITHER_( flags, Int16, Int8 ),
-                                          /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_( flags, Int16, UInt8 )
+                                          /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_( flags, Int16, UInt8 ),
+                                          /* paFloat64: */        PA_USE_CONVERTER_( Int16, Float64 ),
+                                          /* paInt24In32: */      PA_USE_CONVERTER_( Int16, Int24In32 )
                                         ),
                        /* paInt8: */
                        PA_SELECT_FORMAT_( destinationFormat,
@@ -220,7 +329,9 @@ PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
                                           /* paInt24: */          PA_USE_CONVERTER_( Int8, Int24 ),
                                           /* paInt16: */          PA_USE_CONVERTER_( Int8, Int16 ),
                                           /* paInt8: */           PA_UNITY_CONVERSION_( 8 ),
-                                          /* paUInt8: */          PA_USE_CONVERTER_( Int8, UInt8 )
+                                          /* paUInt8: */          PA_USE_CONVERTER_( Int8, UInt8 ),
+                                          /* paFloat64: */        PA_USE_CONVERTER_( Int8, Float64 ),
+                                          /* paInt24In32: */      PA_USE_CONVERTER_( Int8, Int24In32 )
                                         ),
                        /* paUInt8: */
                        PA_SELECT_FORMAT_( destinationFormat,
@@ -229,13 +340,79 @@ PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
                                           /* paInt24: */          PA_USE_CONVERTER_( UInt8, Int24 ),
                                           /* paInt16: */          PA_USE_CONVERTER_( UInt8, Int16 ),
                                           /* paInt8: */           PA_USE_CONVERTER_( UInt8, Int8 ),
-                                          /* paUInt8: */          PA_UNITY_CONVERSION_( 8 )
+                                          /* paUInt8: */          PA_UNITY_CONVERSION_( 8 ),
+                                          /* paFloat64: */        PA_USE_CONVERTER_( UInt8, Float64 ),
+                                          /* paInt24In32: */      PA_USE_CONVERTER_( UInt8, Int24In32 )
+                                        ),
+                       /* paFloat64: */
+                       PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat32: */        PA_USE_CONVERTER_( Float64, Float32 ),
+                                          /* paInt32: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float64, Int32 ),
+                                          /* paInt24: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float64, Int24 ),
+                                          /* paInt16: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float64, Int16 ),
+                                          /* paInt8: */           PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float64, Int8 ),
+                                          /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float64, UInt8 ),
+                                          /* paFloat64: */        PA_UNITY_CONVERSION_( 64 ),
+                                          /* paInt24In32: */      PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float64, Int24In32 )
+                                        ),
+                       /* paInt24In32: */
+                       PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat32: */        PA_USE_CONVERTER_( Int24In32, Float32 ),
+                                          /* paInt32: */          PA_USE_CONVERTER_( Int24In32, Int32 ),
+                                          /* paInt24: */          PA_USE_CONVERTER_( Int24In32, Int24 ),
+                                          /* paInt16: */          PA_SELECT_CONVERTER_DITHER_( flags, Int24In32, Int16 ),
+                                          /* paInt8: */           PA_SELECT_CONVERTER_DITHER_( flags, Int24In32, Int8 ),
+                                          /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_( flags, Int24In32, UInt8 ),
+                                          /* paFloat64: */        PA_USE_CONVERTER_( Int24In32, Float64 ),
+                                          /* paInt24In32: */      PA_UNITY_CONVERSION_( 32 )
                                         )
                      )
 }
 
 /* -------------------------------------------------------------------------- */
 
+#define PA_IS_CONVERTER_( entry )   ( converter == paConverters. entry )
+
+#define PA_IS_DITHER_CONVERTER_( source, destination )                      \
+        ( PA_IS_CONVERTER_( source ## _To_ ## destination ## _Dither )          \
+        || PA_IS_CONVERTER_( source ## _To_ ## destination ## _DitherClip ) )
+
+int PaUtil_ConverterDithers( PaUtilConverter *converter )
+{
+    if( !converter )
+        return 0;
+
+    return PA_IS_DITHER_CONVERTER_( Float32, Int32 )
+            || PA_IS_DITHER_CONVERTER_( Float32, Int24 )
+            || PA_IS_DITHER_CONVERTER_( Float32, Int24In32 )
+            || PA_IS_DITHER_CONVERTER_( Float32, Int16 )
+            || PA_IS_DITHER_CONVERTER_( Float32, Int8 )
+            || PA_IS_DITHER_CONVERTER_( Float32, UInt8 )
+            || PA_IS_CONVERTER_( Float32_To_Int16_NoiseShaped )
+            || PA_IS_CONVERTER_( Float32_To_Int8_NoiseShaped )
+            || PA_IS_CONVERTER_( Float32_To_UInt8_NoiseShaped )
+            || PA_IS_CONVERTER_( Int32_To_Int24_Dither )
+            || PA_IS_CONVERTER_( Int32_To_Int16_Dither )
+            || PA_IS_CONVERTER_( Int32_To_Int8_Dither )
+            || PA_IS_CONVERTER_( Int32_To_UInt8_Dither )
+            || PA_IS_CONVERTER_( Int24_To_Int16_Dither )
+            || PA_IS_CONVERTER_( Int24_To_Int8_Dither )
+            || PA_IS_CONVERTER_( Int24_To_UInt8_Dither )
+            || PA_IS_CONVERTER_( Int24In32_To_Int16_Dither )
+            || PA_IS_CONVERTER_( Int24In32_To_Int8_Dither )
+            || PA_IS_CONVERTER_( Int24In32_To_UInt8_Dither )
+            || PA_IS_CONVERTER_( Int16_To_Int8_Dither )
+            || PA_IS_CONVERTER_( Int16_To_UInt8_Dither )
+            || PA_IS_DITHER_CONVERTER_( Float64, Int32 )
+            || PA_IS_DITHER_CONVERTER_( Float64, Int24 )
+            || PA_IS_DITHER_CONVERTER_( Float64, Int24In32 )
+            || PA_IS_DITHER_CONVERTER_( Float64, Int16 )
+            || PA_IS_DITHER_CONVERTER_( Float64, Int8 )
+            || PA_IS_DITHER_CONVERTER_( Float64, UInt8 );
+}
+
+/* -------------------------------------------------------------------------- */
+
 #ifdef PA_NO_STANDARD_CONVERTERS
 
 /* -------------------------------------------------------------------------- */
@@ -251,24 +428,36 @@ PaUtilConverterTable paConverters = {
     0, /* PaUtilConverter *Float32_To_Int24_Clip; */
     0, /* PaUtilConverter *Float32_To_Int24_DitherClip; */
 
+    0, /* PaUtilConverter *Float32_To_Int24In32; */
+    0, /* PaUtilConverter *Float32_To_Int24In32_Dither; */
+    0, /* PaUtilConverter *Float32_To_Int24In32_Clip; */
+    0, /* PaUtilConverter *Float32_To_Int24In32_DitherClip; */
+
     0, /* PaUtilConverter *Float32_To_Int16; */
     0, /* PaUtilConverter *Float32_To_Int16_Dither; */
     0, /* PaUtilConverter *Float32_To_Int16_Clip; */
     0, /* PaUtilConverter *Float32_To_Int16_DitherClip; */
+    0, /* PaUtilConverter *Float32_To_Int16_NoiseShaped; */
 
     0, /* PaUtilConverter *Float32_To_Int8; */
     0, /* PaUtilConverter *Float32_To_Int8_Dither; */
     0, /* PaUtilConverter *Float32_To_Int8_Clip; */
     0, /* PaUtilConverter *Float32_To_Int8_DitherClip; */
+    0, /* PaUtilConverter *Float32_To_Int8_NoiseShaped; */
 
     0, /* PaUtilConverter *Float32_To_UInt8; */
     0, /* PaUtilConverter *Float32_To_UInt8_Dither; */
     0, /* PaUtilConverter *Float32_To_UInt8_Clip; */
     0, /* PaUtilConverter *Float32_To_UInt8_DitherClip; */
+    0, /* PaUtilConverter *Float32_To_UInt8_NoiseShaped; */
+
+    0, /* PaUtilConverter *Float32_To_Float64; */
 
     0, /* PaUtilConverter *Int32_To_Float32; */
+    0, /* PaUtilConverter *Int32_To_Float64; */
     0, /* PaUtilConverter *Int32_To_Int24; */
     0, /* PaUtilConverter *Int32_To_Int24_Dither; */
+    0, /* PaUtilConverter *Int32_To_Int24In32; */
     0, /* PaUtilConverter *Int32_To_Int16; */
     0, /* PaUtilConverter *Int32_To_Int16_Dither; */
     0, /* PaUtilConverter *Int32_To_Int8; */
@@ -277,7 +466,9 @@ PaUtilConverterTable paConverters = {
     0, /* PaUtilConverter *Int32_To_UInt8_Dither; */
 
     0, /* PaUtilConverter *Int24_To_Float32; */
+    0, /* PaUtilConverter *Int24_To_Float64; */
     0, /* PaUtilConverter *Int24_To_Int32; */
+    0, /* PaUtilConverter *Int24_To_Int24In32; */
     0, /* PaUtilConverter *Int24_To_Int16; */
     0, /* PaUtilConverter *Int24_To_Int16_Dither; */
     0, /* PaUtilConverter *Int24_To_Int8; */
@@ -285,30 +476,80 @@ PaUtilConverterTable paConverters = {
     0, /* PaUtilConverter *Int24_To_UInt8; */
     0, /* PaUtilConverter *Int24_To_UInt8_Dither; */
 
+    0, /* PaUtilConverter *Int24In32_To_Float32; */
+    0, /* PaUtilConverter *Int24In32_To_Float64; */
+    0, /* PaUtilConverter *Int24In32_To_Int32; */
+    0, /* PaUtilConverter *Int24In32_To_Int24; */
+    0, /* PaUtilConverter *Int24In32_To_Int16; */
+    0, /* PaUtilConverter *Int24In32_To_Int16_Dither; */
+    0, /* PaUtilConverter *Int24In32_To_Int8; */
+    0, /* PaUtilConverter *Int24In32_To_Int8_Dither; */
+    0, /* PaUtilConverter *Int24In32_To_UInt8; */
+    0, /* PaUtilConverter *Int24In32_To_UInt8_Dither; */
+
     0, /* PaUtilConverter *Int16_To_Float32; */
+    0, /* PaUtilConverter *Int16_To_Float64; */
     0, /* PaUtilConverter *Int16_To_Int32; */
     0, /* PaUtilConverter *Int16_To_Int24; */
+    0, /* PaUtilConverter *Int16_To_Int24In32; */
     0, /* PaUtilConverter *Int16_To_Int8; */
     0, /* PaUtilConverter *Int16_To_Int8_Dither; */
     0, /* PaUtilConverter *Int16_To_UInt8; */
     0, /* PaUtilConverter *Int16_To_UInt8_Dither; */
 
     0, /* PaUtilConverter *Int8_To_Float32; */
+    0, /* PaUtilConverter *Int8_To_Float64; */
     0, /* PaUtilConverter *Int8_To_Int32; */
     0, /* PaUtilConverter *Int8_To_Int24 */
+    0, /* PaUtilConverter *Int8_To_Int24In32; */
     0, /* PaUtilConverter *Int8_To_Int16; */
     0, /* PaUtilConverter *Int8_To_UInt8; */
 
     0, /* PaUtilConverter *UInt8_To_Float32; */
+    0, /* PaUtilConverter *UInt8_To_Float64; */
     0, /* PaUtilConverter *UInt8_To_Int32; */
     0, /* PaUtilConverter *UInt8_To_Int24; */
+    0, /* PaUtilConverter *UInt8_To_Int24In32; */
     0, /* PaUtilConverter *UInt8_To_Int16; */
     0, /* PaUtilConverter *UInt8_To_Int8; */
 
+    0, /* PaUtilConverter *Float64_To_Float32; */
+
+    0, /* PaUtilConverter *Float64_To_Int32; */
+    0, /* PaUtilConverter *Float64_To_Int32_Dither; */
+    0, /* PaUtilConverter *Float64_To_Int32_Clip; */
+    0, /* PaUtilConverter *Float64_To_Int32_DitherClip; */
+
+    0, /* PaUtilConverter *Float64_To_Int24; */
+    0, /* PaUtilConverter *Float64_To_Int24_Dither; */
+    0, /* PaUtilConverter *Float64_To_Int24_Clip; */
+    0, /* PaUtilConverter *Float64_To_Int24_DitherClip; */
+
+    0, /* PaUtilConverter *Float64_To_Int24In32; */
+    0, /* PaUtilConverter *Float64_To_Int24In32_Dither; */
+    0, /* PaUtilConverter *Float64_To_Int24In32_Clip; */
+    0, /* PaUtilConverter *Float64_To_Int24In32_DitherClip; */
+
+    0, /* PaUtilConverter *Float64_To_Int16; */
+    0, /* PaUtilConverter *Float64_To_Int16_Dither; */
+    0, /* PaUtilConverter *Float64_To_Int16_Clip; */
+    0, /* PaUtilConverter *Float64_To_Int16_DitherClip; */
+
+    0, /* PaUtilConverter *Float64_To_Int8; */
+    0, /* PaUtilConverter *Float64_To_Int8_Dither; */
+    0, /* PaUtilConverter *Float64_To_Int8_Clip; */
+    0, /* PaUtilConverter *Float64_To_Int8_DitherClip; */
+
+    0, /* PaUtilConverter *Float64_To_UInt8; */
+    0, /* PaUtilConverter *Float64_To_UInt8_Dither; */
+    0, /* PaUtilConverter *Float64_To_UInt8_Clip; */
+    0, /* PaUtilConverter *Float64_To_UInt8_DitherClip; */
+
     0, /* PaUtilConverter *Copy_8_To_8; */
     0, /* PaUtilConverter *Copy_16_To_16; */
     0, /* PaUtilConverter *Copy_24_To_24; */
-    0  /* PaUtilConverter *Copy_32_To_32; */
+    0, /* PaUtilConverter *Copy_32_To_32; */
+    0  /* PaUtilConverter *Copy_64_To_64; */
 };
 
 /* -------------------------------------------------------------------------- */
@@ -320,6 +561,13 @@ PaUtilConverterTable paConverters = {
 #define PA_CLIP_( val, min, max )\
     { val = ((val) < (min)) ? (min) : (((val) > (max)) ? (max) : (val)); }
 
+/* Clip val and increment count if it was out of range. A value is only
+    counted when truncating it to an integer would have overflowed (NaN
+    included), so that all converters, including the SIMD ones, count the
+    same samples. */
+#define PA_CLIP_AND_COUNT_( val, min, max, count )\
+    { count += !((val) > (min) - 1) | ((val) >= (max) + 1); PA_CLIP_( val, min, max ) }
+
 
 static const float const_1_div_128_ = 1.0f / 128.0f;  /* 8 bit multiplier */
 
@@ -327,12 +575,19 @@ static const float const_1_div_32768_ = 1.0f / 32768.f; /* 16 bit multiplier */
 
 static const double const_1_div_2147483648_ = 1.0 / 2147483648.0; /* 32 bit multiplier */
 
+static const double const_1_div_32768_double_ = 1.0 / 32768.0; /* 16 bit multiplier, double precision */
+
+static const double const_1_div_128_double_ = 1.0 / 128.0; /* 8 bit multiplier, double precision */
+
+/* Left justify a paInt24In32 sample, discarding its most significant byte. */
+#define PA_INT24_IN_32_TO_INT32_( sample ) ((PaInt32)((PaUint32)(sample) << 8))
+
 /* -------------------------------------------------------------------------- */
 
 static void Float32_To_Int32(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     PaInt32 *dest =  (PaInt32*)destinationBuffer;
@@ -354,7 +609,7 @@ static void Float32_To_Int32(
 static void Float32_To_Int32_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     PaInt32 *dest =  (PaInt32*)destinationBuffer;
@@ -377,22 +632,24 @@ static void Float32_To_Int32_Dither(
 static void Float32_To_Int32_Clip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     PaInt32 *dest =  (PaInt32*)destinationBuffer;
-    (void) ditherGenerator; /* unused parameter */
+    unsigned long clipped = 0;
 
     while( count-- )
     {
         /* REVIEW */
         double scaled = *src * 0x7FFFFFFF;
-        PA_CLIP_( scaled, -2147483648., 2147483647.  );
+        PA_CLIP_AND_COUNT_( scaled, -2147483648., 2147483647., clipped );
         *dest = (PaInt32) scaled;
 
         src += sourceStride;
         dest += destinationStride;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -400,10 +657,11 @@ static void Float32_To_Int32_Clip(
 static void Float32_To_Int32_DitherClip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     PaInt32 *dest =  (PaInt32*)destinationBuffer;
+    unsigned long clipped = 0;
 
     while( count-- )
     {
@@ -411,12 +669,14 @@ static void Float32_To_Int32_DitherClip(
         double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
         /* use smaller scaler to prevent overflow when we add the dither */
         double dithered = ((double)*src * (2147483646.0)) + dither;
-        PA_CLIP_( dithered, -2147483648., 2147483647.  );
+        PA_CLIP_AND_COUNT_( dithered, -2147483648., 2147483647., clipped );
         *dest = (PaInt32) dithered;
 
         src += sourceStride;
         dest += destinationStride;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -424,7 +684,7 @@ static void Float32_To_Int32_DitherClip(
 static void Float32_To_Int24(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
@@ -458,7 +718,7 @@ static void Float32_To_Int24(
 static void Float32_To_Int24_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
@@ -494,19 +754,18 @@ static void Float32_To_Int24_Dither(
 static void Float32_To_Int24_Clip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
     PaInt32 temp;
-
-    (void) ditherGenerator; /* unused parameter */
+    unsigned long clipped = 0;
 
     while( count-- )
     {
         /* convert to 32 bit and drop the low 8 bits */
         double scaled = *src * 0x7FFFFFFF;
-        PA_CLIP_( scaled, -2147483648., 2147483647.  );
+        PA_CLIP_AND_COUNT_( scaled, -2147483648., 2147483647., clipped );
         temp = (PaInt32) scaled;
 
 #if defined(PA_LITTLE_ENDIAN)
@@ -522,6 +781,8 @@ static void Float32_To_Int24_Clip(
         src += sourceStride;
         dest += destinationStride * 3;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -529,11 +790,12 @@ static void Float32_To_Int24_Clip(
 static void Float32_To_Int24_DitherClip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
     PaInt32 temp;
+    unsigned long clipped = 0;
 
     while( count-- )
     {
@@ -542,7 +804,7 @@ static void Float32_To_Int24_DitherClip(
         double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
         /* use smaller scaler to prevent overflow when we add the dither */
         double dithered = ((double)*src * (2147483646.0)) + dither;
-        PA_CLIP_( dithered, -2147483648., 2147483647.  );
+        PA_CLIP_AND_COUNT_( dithered, -2147483648., 2147483647., clipped );
 
         temp = (PaInt32) dithered;
 
@@ -559,6 +821,122 @@ static void Float32_To_Int24_DitherClip(
         src += sourceStride;
         dest += destinationStride * 3;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int24In32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaInt32 temp;
+
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        /* convert to 32 bit and shift out the low 8 bits */
+        double scaled = (double)(*src) * 2147483647.0;
+        temp = (PaInt32) scaled;
+
+        *dest = temp >> 8;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int24In32_Dither(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaInt32 temp;
+
+    while( count-- )
+    {
+        /* convert to 32 bit and shift out the low 8 bits */
+
+        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = ((double)*src * (2147483646.0)) + dither;
+
+        temp = (PaInt32) dithered;
+
+        *dest = temp >> 8;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int24In32_Clip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaInt32 temp;
+    unsigned long clipped = 0;
+
+    while( count-- )
+    {
+        /* convert to 32 bit and shift out the low 8 bits */
+        double scaled = *src * 0x7FFFFFFF;
+        PA_CLIP_AND_COUNT_( scaled, -2147483648., 2147483647., clipped );
+        temp = (PaInt32) scaled;
+
+        *dest = temp >> 8;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+
+    ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int24In32_DitherClip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaInt32 temp;
+    unsigned long clipped = 0;
+
+    while( count-- )
+    {
+        /* convert to 32 bit and shift out the low 8 bits */
+
+        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = ((double)*src * (2147483646.0)) + dither;
+        PA_CLIP_AND_COUNT_( dithered, -2147483648., 2147483647., clipped );
+
+        temp = (PaInt32) dithered;
+
+        *dest = temp >> 8;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+
+    ditherGenerator->clippedSampleCount += clipped;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -566,7 +944,7 @@ static void Float32_To_Int24_DitherClip(
 static void Float32_To_Int16(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     PaInt16 *dest =  (PaInt16*)destinationBuffer;
@@ -587,7 +965,7 @@ static void Float32_To_Int16(
 static void Float32_To_Int16_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     PaInt16 *dest = (PaInt16*)destinationBuffer;
@@ -611,22 +989,24 @@ static void Float32_To_Int16_Dither(
 static void Float32_To_Int16_Clip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     PaInt16 *dest =  (PaInt16*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    unsigned long clipped = 0;
 
     while( count-- )
     {
         long samp = (PaInt32) (*src * (32767.0f));
 
-        PA_CLIP_( samp, -0x8000, 0x7FFF );
+        PA_CLIP_AND_COUNT_( samp, -0x8000, 0x7FFF, clipped );
         *dest = (PaInt16) samp;
 
         src += sourceStride;
         dest += destinationStride;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -634,11 +1014,11 @@ static void Float32_To_Int16_Clip(
 static void Float32_To_Int16_DitherClip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     PaInt16 *dest =  (PaInt16*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    unsigned long clipped = 0;
 
     while( count-- )
     {
@@ -647,12 +1027,81 @@ static void Float32_To_Int16_DitherClip(
         /* use smaller scaler to prevent overflow when we add the dither */
         float dithered = (*src * (32766.0f)) + dither;
         PaInt32 samp = (PaInt32) dithered;
-        PA_CLIP_( samp, -0x8000, 0x7FFF );
+        PA_CLIP_AND_COUNT_( samp, -0x8000, 0x7FFF, clipped );
         *dest = (PaInt16) samp;
 
         src += sourceStride;
         dest += destinationStride;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+#define PA_NOISE_SHAPING_BLOCK_SIZE_   (64)
+
+/* Quantize value, already scaled to the destination range, with high pass
+    triangular dither and second order error feedback. This is the noise shaped
+    dither quoted from musicdsp.org in pa_dither.c, except that we round to
+    nearest. The feedback state lives in the dither generator, so every channel
+    needs its own generator. Clipped samples reset the feedback so that an
+    overload can't make the filter ring. Clipped samples are counted in the
+    dither generator. */
+static PaInt32 NoiseShapeSample( float value, float dither,
+        PaUtilTriangularDitherGenerator *ditherGenerator,
+        PaInt32 minimum, PaInt32 maximum )
+{
+    float shaped = value + .5f * (ditherGenerator->shapingError1
+            + ditherGenerator->shapingError1 - ditherGenerator->shapingError2);
+    float rounded = shaped + dither + .5f;
+    PaInt32 samp;
+
+    if( rounded >= (float)maximum + 1.f || rounded < (float)minimum )
+    {
+        ditherGenerator->shapingError1 = 0.f;
+        ditherGenerator->shapingError2 = 0.f;
+        ++ditherGenerator->clippedSampleCount;
+        return ( rounded < (float)minimum ) ? minimum : maximum;
+    }
+
+    samp = (PaInt32) rounded;
+    if( rounded < (float)samp ) /* truncate downwards, faster than floor() */
+        --samp;
+
+    ditherGenerator->shapingError2 = ditherGenerator->shapingError1;
+    ditherGenerator->shapingError1 = shaped - (float)samp;
+
+    return samp;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int16_NoiseShaped(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest =  (PaInt16*)destinationBuffer;
+    float dither[ PA_NOISE_SHAPING_BLOCK_SIZE_ ];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = ( count < PA_NOISE_SHAPING_BLOCK_SIZE_ ) ? count : PA_NOISE_SHAPING_BLOCK_SIZE_;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( i=0; i < blockCount; ++i )
+        {
+            *dest = (PaInt16) NoiseShapeSample( *src * (32767.0f), dither[i], ditherGenerator, -0x8000, 0x7FFF );
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= blockCount;
+    }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -660,7 +1109,7 @@ static void Float32_To_Int16_DitherClip(
 static void Float32_To_Int8(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     signed char *dest =  (signed char*)destinationBuffer;
@@ -681,7 +1130,7 @@ static void Float32_To_Int8(
 static void Float32_To_Int8_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     signed char *dest =  (signed char*)destinationBuffer;
@@ -704,21 +1153,23 @@ static void Float32_To_Int8_Dither(
 static void Float32_To_Int8_Clip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     signed char *dest =  (signed char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    unsigned long clipped = 0;
 
     while( count-- )
     {
         PaInt32 samp = (PaInt32)(*src * (127.0f));
-        PA_CLIP_( samp, -0x80, 0x7F );
+        PA_CLIP_AND_COUNT_( samp, -0x80, 0x7F, clipped );
         *dest = (signed char) samp;
 
         src += sourceStride;
         dest += destinationStride;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -726,11 +1177,11 @@ static void Float32_To_Int8_Clip(
 static void Float32_To_Int8_DitherClip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     signed char *dest =  (signed char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    unsigned long clipped = 0;
 
     while( count-- )
     {
@@ -738,12 +1189,43 @@ static void Float32_To_Int8_DitherClip(
         /* use smaller scaler to prevent overflow when we add the dither */
         float dithered = (*src * (126.0f)) + dither;
         PaInt32 samp = (PaInt32) dithered;
-        PA_CLIP_( samp, -0x80, 0x7F );
+        PA_CLIP_AND_COUNT_( samp, -0x80, 0x7F, clipped );
         *dest = (signed char) samp;
 
         src += sourceStride;
         dest += destinationStride;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int8_NoiseShaped(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    signed char *dest =  (signed char*)destinationBuffer;
+    float dither[ PA_NOISE_SHAPING_BLOCK_SIZE_ ];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = ( count < PA_NOISE_SHAPING_BLOCK_SIZE_ ) ? count : PA_NOISE_SHAPING_BLOCK_SIZE_;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( i=0; i < blockCount; ++i )
+        {
+            *dest = (signed char) NoiseShapeSample( *src * (127.0f), dither[i], ditherGenerator, -0x80, 0x7F );
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= blockCount;
+    }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -751,7 +1233,7 @@ static void Float32_To_Int8_DitherClip(
 static void Float32_To_UInt8(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     unsigned char *dest =  (unsigned char*)destinationBuffer;
@@ -772,7 +1254,7 @@ static void Float32_To_UInt8(
 static void Float32_To_UInt8_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     unsigned char *dest =  (unsigned char*)destinationBuffer;
@@ -795,21 +1277,23 @@ static void Float32_To_UInt8_Dither(
 static void Float32_To_UInt8_Clip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     unsigned char *dest =  (unsigned char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    unsigned long clipped = 0;
 
     while( count-- )
     {
         PaInt32 samp = 128 + (PaInt32)(*src * (127.0f));
-        PA_CLIP_( samp, 0x0000, 0x00FF );
+        PA_CLIP_AND_COUNT_( samp, 0x0000, 0x00FF, clipped );
         *dest = (unsigned char) samp;
 
         src += sourceStride;
         dest += destinationStride;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -817,11 +1301,11 @@ static void Float32_To_UInt8_Clip(
 static void Float32_To_UInt8_DitherClip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     float *src = (float*)sourceBuffer;
     unsigned char *dest =  (unsigned char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    unsigned long clipped = 0;
 
     while( count-- )
     {
@@ -829,48 +1313,119 @@ static void Float32_To_UInt8_DitherClip(
         /* use smaller scaler to prevent overflow when we add the dither */
         float dithered = (*src * (126.0f)) + dither;
         PaInt32 samp = 128 + (PaInt32) dithered;
-        PA_CLIP_( samp, 0x0000, 0x00FF );
+        PA_CLIP_AND_COUNT_( samp, 0x0000, 0x00FF, clipped );
         *dest = (unsigned char) samp;
 
         src += sourceStride;
         dest += destinationStride;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
 }
 
 /* -------------------------------------------------------------------------- */
 
-static void Int32_To_Float32(
+static void Float32_To_UInt8_NoiseShaped(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    PaInt32 *src = (PaInt32*)sourceBuffer;
-    float *dest =  (float*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest =  (unsigned char*)destinationBuffer;
+    float dither[ PA_NOISE_SHAPING_BLOCK_SIZE_ ];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        *dest = (float) ((double)*src * const_1_div_2147483648_);
+        blockCount = ( count < PA_NOISE_SHAPING_BLOCK_SIZE_ ) ? count : PA_NOISE_SHAPING_BLOCK_SIZE_;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
 
-        src += sourceStride;
-        dest += destinationStride;
+        for( i=0; i < blockCount; ++i )
+        {
+            *dest = (unsigned char) (128 + NoiseShapeSample( *src * (127.0f), dither[i], ditherGenerator, -0x80, 0x7F ));
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= blockCount;
     }
 }
 
 /* -------------------------------------------------------------------------- */
 
-static void Int32_To_Int24(
+static void Float32_To_Float64(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    PaInt32 *src    = (PaInt32*)sourceBuffer;
-    unsigned char *dest = (unsigned char*)destinationBuffer;
-    (void) ditherGenerator; /* unused parameter */
+    float *src = (float*)sourceBuffer;
+    double *dest =  (double*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
 
     while( count-- )
     {
-        /* REVIEW */
+        *dest = *src;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int32_To_Float32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    float *dest =  (float*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = (float) ((double)*src * const_1_div_2147483648_);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int32_To_Float64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    double *dest =  (double*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = *src * const_1_div_2147483648_;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int32_To_Int24(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src    = (PaInt32*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        /* REVIEW */
 #if defined(PA_LITTLE_ENDIAN)
         dest[0] = (unsigned char)(*src >> 8);
         dest[1] = (unsigned char)(*src >> 16);
@@ -887,10 +1442,30 @@ static void Int32_To_Int24(
 
 /* -------------------------------------------------------------------------- */
 
+static void Int32_To_Int24In32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = *src >> 8;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
 static void Int32_To_Int24_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     (void) destinationBuffer; /* unused parameters */
     (void) destinationStride; /* unused parameters */
@@ -906,7 +1481,7 @@ static void Int32_To_Int24_Dither(
 static void Int32_To_Int16(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     PaInt32 *src = (PaInt32*)sourceBuffer;
     PaInt16 *dest =  (PaInt16*)destinationBuffer;
@@ -926,7 +1501,7 @@ static void Int32_To_Int16(
 static void Int32_To_Int16_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     PaInt32 *src = (PaInt32*)sourceBuffer;
     PaInt16 *dest =  (PaInt16*)destinationBuffer;
@@ -948,7 +1523,7 @@ static void Int32_To_Int16_Dither(
 static void Int32_To_Int8(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     PaInt32 *src = (PaInt32*)sourceBuffer;
     signed char *dest =  (signed char*)destinationBuffer;
@@ -968,7 +1543,7 @@ static void Int32_To_Int8(
 static void Int32_To_Int8_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     PaInt32 *src = (PaInt32*)sourceBuffer;
     signed char *dest =  (signed char*)destinationBuffer;
@@ -990,7 +1565,7 @@ static void Int32_To_Int8_Dither(
 static void Int32_To_UInt8(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     PaInt32 *src = (PaInt32*)sourceBuffer;
     unsigned char *dest =  (unsigned char*)destinationBuffer;
@@ -1010,7 +1585,7 @@ static void Int32_To_UInt8(
 static void Int32_To_UInt8_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     /* PaInt32 *src = (PaInt32*)sourceBuffer;
     unsigned char *dest =  (unsigned char*)destinationBuffer; */
@@ -1030,7 +1605,7 @@ static void Int32_To_UInt8_Dither(
 static void Int24_To_Float32(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     unsigned char *src = (unsigned char*)sourceBuffer;
     float *dest = (float*)destinationBuffer;
@@ -1060,10 +1635,43 @@ static void Int24_To_Float32(
 
 /* -------------------------------------------------------------------------- */
 
+static void Int24_To_Float64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    double *dest = (double*)destinationBuffer;
+    PaInt32 temp;
+
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+
+#if defined(PA_LITTLE_ENDIAN)
+        temp = (((PaInt32)src[0]) << 8);
+        temp = temp | (((PaInt32)src[1]) << 16);
+        temp = temp | (((PaInt32)src[2]) << 24);
+#elif defined(PA_BIG_ENDIAN)
+        temp = (((PaInt32)src[0]) << 24);
+        temp = temp | (((PaInt32)src[1]) << 16);
+        temp = temp | (((PaInt32)src[2]) << 8);
+#endif
+
+        *dest = temp * const_1_div_2147483648_;
+
+        src += sourceStride * 3;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
 static void Int24_To_Int32(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     unsigned char *src  = (unsigned char*)sourceBuffer;
     PaInt32 *dest = (PaInt32*)  destinationBuffer;
@@ -1093,10 +1701,43 @@ static void Int24_To_Int32(
 
 /* -------------------------------------------------------------------------- */
 
+static void Int24_To_Int24In32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaInt32 temp;
+
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+
+#if defined(PA_LITTLE_ENDIAN)
+        temp = (((PaInt32)src[0]) << 8);
+        temp = temp | (((PaInt32)src[1]) << 16);
+        temp = temp | (((PaInt32)src[2]) << 24);
+#elif defined(PA_BIG_ENDIAN)
+        temp = (((PaInt32)src[0]) << 24);
+        temp = temp | (((PaInt32)src[1]) << 16);
+        temp = temp | (((PaInt32)src[2]) << 8);
+#endif
+
+        *dest = temp >> 8;
+
+        src += sourceStride * 3;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
 static void Int24_To_Int16(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     unsigned char *src = (unsigned char*)sourceBuffer;
     PaInt16 *dest = (PaInt16*)destinationBuffer;
@@ -1130,7 +1771,7 @@ static void Int24_To_Int16(
 static void Int24_To_Int16_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     unsigned char *src = (unsigned char*)sourceBuffer;
     PaInt16 *dest = (PaInt16*)destinationBuffer;
@@ -1164,7 +1805,7 @@ static void Int24_To_Int16_Dither(
 static void Int24_To_Int8(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     unsigned char *src = (unsigned char*)sourceBuffer;
     signed char  *dest = (signed char*)destinationBuffer;
@@ -1194,7 +1835,7 @@ static void Int24_To_Int8(
 static void Int24_To_Int8_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     unsigned char *src = (unsigned char*)sourceBuffer;
     signed char  *dest = (signed char*)destinationBuffer;
@@ -1228,7 +1869,7 @@ static void Int24_To_Int8_Dither(
 static void Int24_To_UInt8(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     unsigned char *src = (unsigned char*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
@@ -1258,7 +1899,7 @@ static void Int24_To_UInt8(
 static void Int24_To_UInt8_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     (void) destinationBuffer; /* unused parameters */
     (void) destinationStride; /* unused parameters */
@@ -1271,19 +1912,22 @@ static void Int24_To_UInt8_Dither(
 
 /* -------------------------------------------------------------------------- */
 
-static void Int16_To_Float32(
+static void Int24In32_To_Float32(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    PaInt16 *src = (PaInt16*)sourceBuffer;
-    float *dest =  (float*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    PaInt32 temp;
+
+    (void) ditherGenerator; /* unused parameter */
 
     while( count-- )
     {
-        float samp = *src * const_1_div_32768_; /* FIXME: i'm concerned about this being asymmetrical with float->int16 -rb */
-        *dest = samp;
+        temp = PA_INT24_IN_32_TO_INT32_( *src );
+
+        *dest = (float) ((double)temp * const_1_div_2147483648_);
 
         src += sourceStride;
         dest += destinationStride;
@@ -1292,22 +1936,22 @@ static void Int16_To_Float32(
 
 /* -------------------------------------------------------------------------- */
 
-static void Int16_To_Int32(
+static void Int24In32_To_Float64(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    PaInt16 *src = (PaInt16*)sourceBuffer;
-    PaInt32 *dest =  (PaInt32*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    double *dest = (double*)destinationBuffer;
+    PaInt32 temp;
+
+    (void) ditherGenerator; /* unused parameter */
 
     while( count-- )
     {
-        /* REVIEW: we should consider something like
-            (*src << 16) | (*src & 0xFFFF)
-        */
+        temp = PA_INT24_IN_32_TO_INT32_( *src );
 
-        *dest = *src << 16;
+        *dest = temp * const_1_div_2147483648_;
 
         src += sourceStride;
         dest += destinationStride;
@@ -1316,90 +1960,101 @@ static void Int16_To_Int32(
 
 /* -------------------------------------------------------------------------- */
 
-static void Int16_To_Int24(
+static void Int24In32_To_Int32(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    PaInt16 *src   = (PaInt16*) sourceBuffer;
-    unsigned char *dest = (unsigned char*)destinationBuffer;
-    PaInt16 temp;
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaInt32 temp;
 
     (void) ditherGenerator; /* unused parameter */
 
     while( count-- )
     {
-        temp = *src;
+        temp = PA_INT24_IN_32_TO_INT32_( *src );
 
-#if defined(PA_LITTLE_ENDIAN)
-        dest[0] = 0;
-        dest[1] = (unsigned char)(temp);
-        dest[2] = (unsigned char)(temp >> 8);
-#elif defined(PA_BIG_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 8);
-        dest[1] = (unsigned char)(temp);
-        dest[2] = 0;
-#endif
+        *dest = temp;
 
         src += sourceStride;
-        dest += destinationStride * 3;
+        dest += destinationStride;
     }
 }
 
 /* -------------------------------------------------------------------------- */
 
-static void Int16_To_Int8(
+static void Int24In32_To_Int24(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    PaInt16 *src = (PaInt16*)sourceBuffer;
-    signed char *dest =  (signed char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 temp;
+
+    (void) ditherGenerator; /* unused parameter */
 
     while( count-- )
     {
-        (*dest) = (signed char)((*src) >> 8);
+        temp = PA_INT24_IN_32_TO_INT32_( *src );
+
+#if defined(PA_LITTLE_ENDIAN)
+        dest[0] = (unsigned char)(temp >> 8);
+        dest[1] = (unsigned char)(temp >> 16);
+        dest[2] = (unsigned char)(temp >> 24);
+#elif defined(PA_BIG_ENDIAN)
+        dest[0] = (unsigned char)(temp >> 24);
+        dest[1] = (unsigned char)(temp >> 16);
+        dest[2] = (unsigned char)(temp >> 8);
+#endif
 
         src += sourceStride;
-        dest += destinationStride;
+        dest += destinationStride * 3;
     }
 }
 
 /* -------------------------------------------------------------------------- */
 
-static void Int16_To_Int8_Dither(
+static void Int24In32_To_Int16(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    /* PaInt16 *src = (PaInt16*)sourceBuffer;
-    signed char *dest =  (signed char*)destinationBuffer; */
-    (void)ditherGenerator; /* unused parameter */
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    PaInt32 temp;
+
+    (void) ditherGenerator; /* unused parameter */
 
     while( count-- )
     {
-        /* IMPLEMENT ME */
+        temp = PA_INT24_IN_32_TO_INT32_( *src );
 
-        /* src += sourceStride;
-        dest += destinationStride; */
+        *dest = (PaInt16) (temp >> 16);
+
+        src += sourceStride;
+        dest += destinationStride;
     }
 }
 
 /* -------------------------------------------------------------------------- */
 
-static void Int16_To_UInt8(
+static void Int24In32_To_Int16_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    PaInt16 *src = (PaInt16*)sourceBuffer;
-    unsigned char *dest =  (unsigned char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    PaInt32 temp, dither;
 
     while( count-- )
     {
-        (*dest) = (unsigned char)(((*src) >> 8) + 128);
+        temp = PA_INT24_IN_32_TO_INT32_( *src );
+
+        dither = PaUtil_Generate16BitTriangularDither( ditherGenerator );
+        *dest = (PaInt16) (((temp >> 1) + dither) >> 15);
 
         src += sourceStride;
         dest += destinationStride;
@@ -1408,39 +2063,45 @@ static void Int16_To_UInt8(
 
 /* -------------------------------------------------------------------------- */
 
-static void Int16_To_UInt8_Dither(
+static void Int24In32_To_Int8(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    /* PaInt16 *src = (PaInt16*)sourceBuffer;
-    unsigned char *dest =  (unsigned char*)destinationBuffer; */
-    (void)ditherGenerator; /* unused parameter */
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    signed char *dest = (signed char*)destinationBuffer;
+    PaInt32 temp;
+
+    (void) ditherGenerator; /* unused parameter */
 
     while( count-- )
     {
-        /* IMPLEMENT ME */
+        temp = PA_INT24_IN_32_TO_INT32_( *src );
 
-        /* src += sourceStride;
-        dest += destinationStride; */
+        *dest = (signed char) (temp >> 24);
+
+        src += sourceStride;
+        dest += destinationStride;
     }
 }
 
 /* -------------------------------------------------------------------------- */
 
-static void Int8_To_Float32(
+static void Int24In32_To_Int8_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    signed char *src = (signed char*)sourceBuffer;
-    float *dest =  (float*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    signed char *dest = (signed char*)destinationBuffer;
+    PaInt32 temp, dither;
 
     while( count-- )
     {
-        float samp = *src * const_1_div_128_;
-        *dest = samp;
+        temp = PA_INT24_IN_32_TO_INT32_( *src );
+
+        dither = PaUtil_Generate16BitTriangularDither( ditherGenerator );
+        *dest = (signed char) (((temp >> 1) + dither) >> 23);
 
         src += sourceStride;
         dest += destinationStride;
@@ -1449,67 +2110,936 @@ static void Int8_To_Float32(
 
 /* -------------------------------------------------------------------------- */
 
-static void Int8_To_Int32(
+static void Int24In32_To_UInt8(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    signed char *src = (signed char*)sourceBuffer;
-    PaInt32 *dest =  (PaInt32*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 temp;
+
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        temp = PA_INT24_IN_32_TO_INT32_( *src );
+
+        *dest = (unsigned char) ((temp >> 24) + 128);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int24In32_To_UInt8_Dither(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 temp, dither;
+
+    while( count-- )
+    {
+        temp = PA_INT24_IN_32_TO_INT32_( *src );
+
+        dither = PaUtil_Generate16BitTriangularDither( ditherGenerator );
+        *dest = (unsigned char) ((((temp >> 1) + dither) >> 23) + 128);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int16_To_Float32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    float *dest =  (float*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        float samp = *src * const_1_div_32768_; /* FIXME: i'm concerned about this being asymmetrical with float->int16 -rb */
+        *dest = samp;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int16_To_Float64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    double *dest =  (double*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = *src * const_1_div_32768_double_;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int16_To_Int32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    PaInt32 *dest =  (PaInt32*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        /* REVIEW: we should consider something like
+            (*src << 16) | (*src & 0xFFFF)
+        */
+
+        *dest = *src << 16;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int16_To_Int24(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src   = (PaInt16*) sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt16 temp;
+
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        temp = *src;
+
+#if defined(PA_LITTLE_ENDIAN)
+        dest[0] = 0;
+        dest[1] = (unsigned char)(temp);
+        dest[2] = (unsigned char)(temp >> 8);
+#elif defined(PA_BIG_ENDIAN)
+        dest[0] = (unsigned char)(temp >> 8);
+        dest[1] = (unsigned char)(temp);
+        dest[2] = 0;
+#endif
+
+        src += sourceStride;
+        dest += destinationStride * 3;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int16_To_Int24In32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = *src << 8;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int16_To_Int8(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    signed char *dest =  (signed char*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        (*dest) = (signed char)((*src) >> 8);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int16_To_Int8_Dither(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    /* PaInt16 *src = (PaInt16*)sourceBuffer;
+    signed char *dest =  (signed char*)destinationBuffer; */
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        /* IMPLEMENT ME */
+
+        /* src += sourceStride;
+        dest += destinationStride; */
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int16_To_UInt8(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    unsigned char *dest =  (unsigned char*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        (*dest) = (unsigned char)(((*src) >> 8) + 128);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int16_To_UInt8_Dither(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    /* PaInt16 *src = (PaInt16*)sourceBuffer;
+    unsigned char *dest =  (unsigned char*)destinationBuffer; */
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        /* IMPLEMENT ME */
+
+        /* src += sourceStride;
+        dest += destinationStride; */
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int8_To_Float32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    signed char *src = (signed char*)sourceBuffer;
+    float *dest =  (float*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        float samp = *src * const_1_div_128_;
+        *dest = samp;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int8_To_Float64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    signed char *src = (signed char*)sourceBuffer;
+    double *dest =  (double*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = *src * const_1_div_128_double_;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int8_To_Int32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    signed char *src = (signed char*)sourceBuffer;
+    PaInt32 *dest =  (PaInt32*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        (*dest) = (*src) << 24;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int8_To_Int24(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    signed char *src = (signed char*)sourceBuffer;
+    unsigned char *dest =  (unsigned char*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+
+#if defined(PA_LITTLE_ENDIAN)
+        dest[0] = 0;
+        dest[1] = 0;
+        dest[2] = (*src);
+#elif defined(PA_BIG_ENDIAN)
+        dest[0] = (*src);
+        dest[1] = 0;
+        dest[2] = 0;
+#endif
+
+        src += sourceStride;
+        dest += destinationStride * 3;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int8_To_Int24In32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    signed char *src = (signed char*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = (*src) << 16;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int8_To_Int16(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    signed char *src = (signed char*)sourceBuffer;
+    PaInt16 *dest =  (PaInt16*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        (*dest) = (PaInt16)((*src) << 8);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int8_To_UInt8(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    signed char *src = (signed char*)sourceBuffer;
+    unsigned char *dest =  (unsigned char*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        (*dest) = (unsigned char)(*src + 128);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void UInt8_To_Float32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    float *dest =  (float*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        float samp = (*src - 128) * const_1_div_128_;
+        *dest = samp;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void UInt8_To_Float64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    double *dest =  (double*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = (*src - 128) * const_1_div_128_double_;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void UInt8_To_Int32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        (*dest) = (*src - 128) << 24;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void UInt8_To_Int24(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src  = (unsigned char*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    (void) ditherGenerator; /* unused parameters */
+
+    while( count-- )
+    {
+
+#if defined(PA_LITTLE_ENDIAN)
+        dest[0] = 0;
+        dest[1] = 0;
+        dest[2] = (unsigned char)(*src - 128);
+#elif defined(PA_BIG_ENDIAN)
+        dest[0] = (unsigned char)(*src - 128);
+        dest[1] = 0;
+        dest[2] = 0;
+#endif
+
+        src += sourceStride;
+        dest += destinationStride * 3;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void UInt8_To_Int24In32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = (*src - 128) << 16;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void UInt8_To_Int16(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    PaInt16 *dest =  (PaInt16*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        (*dest) = (PaInt16)((*src - 128) << 8);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void UInt8_To_Int8(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    signed char  *dest = (signed char*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        (*dest) = (signed char)(*src - 128);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Float32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    float *dest =  (float*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = (float) *src;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt32 *dest =  (PaInt32*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        double scaled = *src * 0x7FFFFFFF;
+        *dest = (PaInt32) scaled;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int32_Dither(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt32 *dest =  (PaInt32*)destinationBuffer;
+
+    while( count-- )
+    {
+        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = (*src * (2147483646.0)) + dither;
+        *dest = (PaInt32) dithered;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int32_Clip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt32 *dest =  (PaInt32*)destinationBuffer;
+    unsigned long clipped = 0;
+
+    while( count-- )
+    {
+        double scaled = *src * 0x7FFFFFFF;
+        PA_CLIP_AND_COUNT_( scaled, -2147483648., 2147483647., clipped );
+        *dest = (PaInt32) scaled;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+
+    ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int32_DitherClip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt32 *dest =  (PaInt32*)destinationBuffer;
+    unsigned long clipped = 0;
+
+    while( count-- )
+    {
+        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = (*src * (2147483646.0)) + dither;
+        PA_CLIP_AND_COUNT_( dithered, -2147483648., 2147483647., clipped );
+        *dest = (PaInt32) dithered;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+
+    ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int24(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 temp;
+
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        /* convert to 32 bit and drop the low 8 bits */
+        double scaled = *src * 2147483647.0;
+        temp = (PaInt32) scaled;
+
+#if defined(PA_LITTLE_ENDIAN)
+        dest[0] = (unsigned char)(temp >> 8);
+        dest[1] = (unsigned char)(temp >> 16);
+        dest[2] = (unsigned char)(temp >> 24);
+#elif defined(PA_BIG_ENDIAN)
+        dest[0] = (unsigned char)(temp >> 24);
+        dest[1] = (unsigned char)(temp >> 16);
+        dest[2] = (unsigned char)(temp >> 8);
+#endif
+
+        src += sourceStride;
+        dest += destinationStride * 3;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int24_Dither(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 temp;
+
+    while( count-- )
+    {
+        /* convert to 32 bit and drop the low 8 bits */
+
+        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = (*src * (2147483646.0)) + dither;
+
+        temp = (PaInt32) dithered;
+
+#if defined(PA_LITTLE_ENDIAN)
+        dest[0] = (unsigned char)(temp >> 8);
+        dest[1] = (unsigned char)(temp >> 16);
+        dest[2] = (unsigned char)(temp >> 24);
+#elif defined(PA_BIG_ENDIAN)
+        dest[0] = (unsigned char)(temp >> 24);
+        dest[1] = (unsigned char)(temp >> 16);
+        dest[2] = (unsigned char)(temp >> 8);
+#endif
+
+        src += sourceStride;
+        dest += destinationStride * 3;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int24_Clip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 temp;
+    unsigned long clipped = 0;
+
+    while( count-- )
+    {
+        /* convert to 32 bit and drop the low 8 bits */
+        double scaled = *src * 0x7FFFFFFF;
+        PA_CLIP_AND_COUNT_( scaled, -2147483648., 2147483647., clipped );
+        temp = (PaInt32) scaled;
+
+#if defined(PA_LITTLE_ENDIAN)
+        dest[0] = (unsigned char)(temp >> 8);
+        dest[1] = (unsigned char)(temp >> 16);
+        dest[2] = (unsigned char)(temp >> 24);
+#elif defined(PA_BIG_ENDIAN)
+        dest[0] = (unsigned char)(temp >> 24);
+        dest[1] = (unsigned char)(temp >> 16);
+        dest[2] = (unsigned char)(temp >> 8);
+#endif
+
+        src += sourceStride;
+        dest += destinationStride * 3;
+    }
+
+    ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int24_DitherClip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 temp;
+    unsigned long clipped = 0;
+
+    while( count-- )
+    {
+        /* convert to 32 bit and drop the low 8 bits */
+
+        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = (*src * (2147483646.0)) + dither;
+        PA_CLIP_AND_COUNT_( dithered, -2147483648., 2147483647., clipped );
+
+        temp = (PaInt32) dithered;
+
+#if defined(PA_LITTLE_ENDIAN)
+        dest[0] = (unsigned char)(temp >> 8);
+        dest[1] = (unsigned char)(temp >> 16);
+        dest[2] = (unsigned char)(temp >> 24);
+#elif defined(PA_BIG_ENDIAN)
+        dest[0] = (unsigned char)(temp >> 24);
+        dest[1] = (unsigned char)(temp >> 16);
+        dest[2] = (unsigned char)(temp >> 8);
+#endif
+
+        src += sourceStride;
+        dest += destinationStride * 3;
+    }
+
+    ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int24In32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaInt32 temp;
+
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        /* convert to 32 bit and shift out the low 8 bits */
+        double scaled = *src * 2147483647.0;
+        temp = (PaInt32) scaled;
+
+        *dest = temp >> 8;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int24In32_Dither(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaInt32 temp;
+
+    while( count-- )
+    {
+        /* convert to 32 bit and shift out the low 8 bits */
+
+        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = (*src * (2147483646.0)) + dither;
+
+        temp = (PaInt32) dithered;
+
+        *dest = temp >> 8;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int24In32_Clip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaInt32 temp;
+    unsigned long clipped = 0;
 
     while( count-- )
     {
-        (*dest) = (*src) << 24;
+        /* convert to 32 bit and shift out the low 8 bits */
+        double scaled = *src * 0x7FFFFFFF;
+        PA_CLIP_AND_COUNT_( scaled, -2147483648., 2147483647., clipped );
+        temp = (PaInt32) scaled;
+
+        *dest = temp >> 8;
 
         src += sourceStride;
         dest += destinationStride;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
 }
 
 /* -------------------------------------------------------------------------- */
 
-static void Int8_To_Int24(
+static void Float64_To_Int24In32_DitherClip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    signed char *src = (signed char*)sourceBuffer;
-    unsigned char *dest =  (unsigned char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    double *src = (double*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaInt32 temp;
+    unsigned long clipped = 0;
 
     while( count-- )
     {
+        /* convert to 32 bit and shift out the low 8 bits */
 
-#if defined(PA_LITTLE_ENDIAN)
-        dest[0] = 0;
-        dest[1] = 0;
-        dest[2] = (*src);
-#elif defined(PA_BIG_ENDIAN)
-        dest[0] = (*src);
-        dest[1] = 0;
-        dest[2] = 0;
-#endif
+        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = (*src * (2147483646.0)) + dither;
+        PA_CLIP_AND_COUNT_( dithered, -2147483648., 2147483647., clipped );
+
+        temp = (PaInt32) dithered;
+
+        *dest = temp >> 8;
 
         src += sourceStride;
-        dest += destinationStride * 3;
+        dest += destinationStride;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
 }
 
 /* -------------------------------------------------------------------------- */
 
-static void Int8_To_Int16(
+static void Float64_To_Int16(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    signed char *src = (signed char*)sourceBuffer;
+    double *src = (double*)sourceBuffer;
     PaInt16 *dest =  (PaInt16*)destinationBuffer;
     (void)ditherGenerator; /* unused parameter */
 
     while( count-- )
     {
-        (*dest) = (PaInt16)((*src) << 8);
+        short samp = (short) (*src * (32767.0));
+        *dest = samp;
 
         src += sourceStride;
         dest += destinationStride;
@@ -1518,18 +3048,21 @@ static void Int8_To_Int16(
 
 /* -------------------------------------------------------------------------- */
 
-static void Int8_To_UInt8(
+static void Float64_To_Int16_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    signed char *src = (signed char*)sourceBuffer;
-    unsigned char *dest =  (unsigned char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    double *src = (double*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
 
     while( count-- )
     {
-        (*dest) = (unsigned char)(*src + 128);
+        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = (*src * (32766.0)) + dither;
+
+        *dest = (PaInt16) dithered;
 
         src += sourceStride;
         dest += destinationStride;
@@ -1538,18 +3071,70 @@ static void Int8_To_UInt8(
 
 /* -------------------------------------------------------------------------- */
 
-static void UInt8_To_Float32(
+static void Float64_To_Int16_Clip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    unsigned char *src = (unsigned char*)sourceBuffer;
-    float *dest =  (float*)destinationBuffer;
+    double *src = (double*)sourceBuffer;
+    PaInt16 *dest =  (PaInt16*)destinationBuffer;
+    unsigned long clipped = 0;
+
+    while( count-- )
+    {
+        long samp = (PaInt32) (*src * (32767.0));
+
+        PA_CLIP_AND_COUNT_( samp, -0x8000, 0x7FFF, clipped );
+        *dest = (PaInt16) samp;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+
+    ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int16_DitherClip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt16 *dest =  (PaInt16*)destinationBuffer;
+    unsigned long clipped = 0;
+
+    while( count-- )
+    {
+        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = (*src * (32766.0)) + dither;
+        PaInt32 samp = (PaInt32) dithered;
+        PA_CLIP_AND_COUNT_( samp, -0x8000, 0x7FFF, clipped );
+        *dest = (PaInt16) samp;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+
+    ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int8(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    signed char *dest =  (signed char*)destinationBuffer;
     (void)ditherGenerator; /* unused parameter */
 
     while( count-- )
     {
-        float samp = (*src - 128) * const_1_div_128_;
+        signed char samp = (signed char) (*src * (127.0));
         *dest = samp;
 
         src += sourceStride;
@@ -1559,18 +3144,21 @@ static void UInt8_To_Float32(
 
 /* -------------------------------------------------------------------------- */
 
-static void UInt8_To_Int32(
+static void Float64_To_Int8_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    unsigned char *src = (unsigned char*)sourceBuffer;
-    PaInt32 *dest = (PaInt32*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    double *src = (double*)sourceBuffer;
+    signed char *dest =  (signed char*)destinationBuffer;
 
     while( count-- )
     {
-        (*dest) = (*src - 128) << 24;
+        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = (*src * (126.0)) + dither;
+        PaInt32 samp = (PaInt32) dithered;
+        *dest = (signed char) samp;
 
         src += sourceStride;
         dest += destinationStride;
@@ -1579,47 +3167,70 @@ static void UInt8_To_Int32(
 
 /* -------------------------------------------------------------------------- */
 
-static void UInt8_To_Int24(
+static void Float64_To_Int8_Clip(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    unsigned char *src  = (unsigned char*)sourceBuffer;
-    unsigned char *dest = (unsigned char*)destinationBuffer;
-    (void) ditherGenerator; /* unused parameters */
+    double *src = (double*)sourceBuffer;
+    signed char *dest =  (signed char*)destinationBuffer;
+    unsigned long clipped = 0;
 
     while( count-- )
     {
+        PaInt32 samp = (PaInt32)(*src * (127.0));
+        PA_CLIP_AND_COUNT_( samp, -0x80, 0x7F, clipped );
+        *dest = (signed char) samp;
 
-#if defined(PA_LITTLE_ENDIAN)
-        dest[0] = 0;
-        dest[1] = 0;
-        dest[2] = (unsigned char)(*src - 128);
-#elif defined(PA_BIG_ENDIAN)
-        dest[0] = (unsigned char)(*src - 128);
-        dest[1] = 0;
-        dest[2] = 0;
-#endif
+        src += sourceStride;
+        dest += destinationStride;
+    }
+
+    ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int8_DitherClip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    signed char *dest =  (signed char*)destinationBuffer;
+    unsigned long clipped = 0;
+
+    while( count-- )
+    {
+        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = (*src * (126.0)) + dither;
+        PaInt32 samp = (PaInt32) dithered;
+        PA_CLIP_AND_COUNT_( samp, -0x80, 0x7F, clipped );
+        *dest = (signed char) samp;
 
         src += sourceStride;
-        dest += destinationStride * 3;
+        dest += destinationStride;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
 }
 
 /* -------------------------------------------------------------------------- */
 
-static void UInt8_To_Int16(
+static void Float64_To_UInt8(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    unsigned char *src = (unsigned char*)sourceBuffer;
-    PaInt16 *dest =  (PaInt16*)destinationBuffer;
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest =  (unsigned char*)destinationBuffer;
     (void)ditherGenerator; /* unused parameter */
 
     while( count-- )
     {
-        (*dest) = (PaInt16)((*src - 128) << 8);
+        unsigned char samp = (unsigned char)(128 + ((unsigned char) (*src * (127.0))));
+        *dest = samp;
 
         src += sourceStride;
         dest += destinationStride;
@@ -1628,22 +3239,76 @@ static void UInt8_To_Int16(
 
 /* -------------------------------------------------------------------------- */
 
-static void UInt8_To_Int8(
+static void Float64_To_UInt8_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    unsigned char *src = (unsigned char*)sourceBuffer;
-    signed char  *dest = (signed char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest =  (unsigned char*)destinationBuffer;
 
     while( count-- )
     {
-        (*dest) = (signed char)(*src - 128);
+        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = (*src * (126.0)) + dither;
+        PaInt32 samp = (PaInt32) dithered;
+        *dest = (unsigned char) (128 + samp);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_UInt8_Clip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest =  (unsigned char*)destinationBuffer;
+    unsigned long clipped = 0;
+
+    while( count-- )
+    {
+        PaInt32 samp = 128 + (PaInt32)(*src * (127.0));
+        PA_CLIP_AND_COUNT_( samp, 0x0000, 0x00FF, clipped );
+        *dest = (unsigned char) samp;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+
+    ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_UInt8_DitherClip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest =  (unsigned char*)destinationBuffer;
+    unsigned long clipped = 0;
+
+    while( count-- )
+    {
+        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        double dithered = (*src * (126.0)) + dither;
+        PaInt32 samp = 128 + (PaInt32) dithered;
+        PA_CLIP_AND_COUNT_( samp, 0x0000, 0x00FF, clipped );
+        *dest = (unsigned char) samp;
 
         src += sourceStride;
         dest += destinationStride;
     }
+
+    ditherGenerator->clippedSampleCount += clipped;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -1651,7 +3316,7 @@ static void UInt8_To_Int8(
 static void Copy_8_To_8(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     unsigned char *src = (unsigned char*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
@@ -1672,7 +3337,7 @@ static void Copy_8_To_8(
 static void Copy_16_To_16(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     PaUint16 *src = (PaUint16 *)sourceBuffer;
     PaUint16 *dest = (PaUint16 *)destinationBuffer;
@@ -1693,7 +3358,7 @@ static void Copy_16_To_16(
 static void Copy_24_To_24(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     unsigned char *src = (unsigned char*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
@@ -1716,7 +3381,7 @@ static void Copy_24_To_24(
 static void Copy_32_To_32(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
 {
     PaUint32 *dest = (PaUint32 *)destinationBuffer;
     PaUint32 *src = (PaUint32 *)sourceBuffer;
@@ -1734,6 +3399,30 @@ static void Copy_32_To_32(
 
 /* -------------------------------------------------------------------------- */
 
+static void Copy_64_To_64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    /* copied as pairs of 32 bit words so that no floating point registers are
+        involved, which could alter signalling NaNs */
+    PaUint32 *dest = (PaUint32 *)destinationBuffer;
+    PaUint32 *src = (PaUint32 *)sourceBuffer;
+
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        dest[0] = src[0];
+        dest[1] = src[1];
+
+        src += sourceStride * 2;
+        dest += destinationStride * 2;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
 PaUtilConverterTable paConverters = {
     Float32_To_Int32,              /* PaUtilConverter *Float32_To_Int32; */
     Float32_To_Int32_Dither,       /* PaUtilConverter *Float32_To_Int32_Dither; */
@@ -1745,24 +3434,36 @@ PaUtilConverterTable paConverters = {
     Float32_To_Int24_Clip,         /* PaUtilConverter *Float32_To_Int24_Clip; */
     Float32_To_Int24_DitherClip,   /* PaUtilConverter *Float32_To_Int24_DitherClip; */
 
+    Float32_To_Int24In32,          /* PaUtilConverter *Float32_To_Int24In32; */
+    Float32_To_Int24In32_Dither,   /* PaUtilConverter *Float32_To_Int24In32_Dither; */
+    Float32_To_Int24In32_Clip,     /* PaUtilConverter *Float32_To_Int24In32_Clip; */
+    Float32_To_Int24In32_DitherClip, /* PaUtilConverter *Float32_To_Int24In32_DitherClip; */
+
     Float32_To_Int16,              /* PaUtilConverter *Float32_To_Int16; */
     Float32_To_Int16_Dither,       /* PaUtilConverter *Float32_To_Int16_Dither; */
     Float32_To_Int16_Clip,         /* PaUtilConverter *Float32_To_Int16_Clip; */
     Float32_To_Int16_DitherClip,   /* PaUtilConverter *Float32_To_Int16_DitherClip; */
+    Float32_To_Int16_NoiseShaped,  /* PaUtilConverter *Float32_To_Int16_NoiseShaped; */
 
     Float32_To_Int8,               /* PaUtilConverter *Float32_To_Int8; */
     Float32_To_Int8_Dither,        /* PaUtilConverter *Float32_To_Int8_Dither; */
     Float32_To_Int8_Clip,          /* PaUtilConverter *Float32_To_Int8_Clip; */
     Float32_To_Int8_DitherClip,    /* PaUtilConverter *Float32_To_Int8_DitherClip; */
+    Float32_To_Int8_NoiseShaped,   /* PaUtilConverter *Float32_To_Int8_NoiseShaped; */
 
     Float32_To_UInt8,              /* PaUtilConverter *Float32_To_UInt8; */
     Float32_To_UInt8_Dither,       /* PaUtilConverter *Float32_To_UInt8_Dither; */
     Float32_To_UInt8_Clip,         /* PaUtilConverter *Float32_To_UInt8_Clip; */
     Float32_To_UInt8_DitherClip,   /* PaUtilConverter *Float32_To_UInt8_DitherClip; */
+    Float32_To_UInt8_NoiseShaped,  /* PaUtilConverter *Float32_To_UInt8_NoiseShaped; */
+
+    Float32_To_Float64,            /* PaUtilConverter *Float32_To_Float64; */
 
     Int32_To_Float32,              /* PaUtilConverter *Int32_To_Float32; */
+    Int32_To_Float64,              /* PaUtilConverter *Int32_To_Float64; */
     Int32_To_Int24,                /* PaUtilConverter *Int32_To_Int24; */
     Int32_To_Int24_Dither,         /* PaUtilConverter *Int32_To_Int24_Dither; */
+    Int32_To_Int24In32,            /* PaUtilConverter *Int32_To_Int24In32; */
     Int32_To_Int16,                /* PaUtilConverter *Int32_To_Int16; */
     Int32_To_Int16_Dither,         /* PaUtilConverter *Int32_To_Int16_Dither; */
     Int32_To_Int8,                 /* PaUtilConverter *Int32_To_Int8; */
@@ -1771,7 +3472,9 @@ PaUtilConverterTable paConverters = {
     Int32_To_UInt8_Dither,         /* PaUtilConverter *Int32_To_UInt8_Dither; */
 
     Int24_To_Float32,              /* PaUtilConverter *Int24_To_Float32; */
+    Int24_To_Float64,              /* PaUtilConverter *Int24_To_Float64; */
     Int24_To_Int32,                /* PaUtilConverter *Int24_To_Int32; */
+    Int24_To_Int24In32,            /* PaUtilConverter *Int24_To_Int24In32; */
     Int24_To_Int16,                /* PaUtilConverter *Int24_To_Int16; */
     Int24_To_Int16_Dither,         /* PaUtilConverter *Int24_To_Int16_Dither; */
     Int24_To_Int8,                 /* PaUtilConverter *Int24_To_Int8; */
@@ -1779,30 +3482,80 @@ PaUtilConverterTable paConverters = {
     Int24_To_UInt8,                /* PaUtilConverter *Int24_To_UInt8; */
     Int24_To_UInt8_Dither,         /* PaUtilConverter *Int24_To_UInt8_Dither; */
 
+    Int24In32_To_Float32,          /* PaUtilConverter *Int24In32_To_Float32; */
+    Int24In32_To_Float64,          /* PaUtilConverter *Int24In32_To_Float64; */
+    Int24In32_To_Int32,            /* PaUtilConverter *Int24In32_To_Int32; */
+    Int24In32_To_Int24,            /* PaUtilConverter *Int24In32_To_Int24; */
+    Int24In32_To_Int16,            /* PaUtilConverter *Int24In32_To_Int16; */
+    Int24In32_To_Int16_Dither,     /* PaUtilConverter *Int24In32_To_Int16_Dither; */
+    Int24In32_To_Int8,             /* PaUtilConverter *Int24In32_To_Int8; */
+    Int24In32_To_Int8_Dither,      /* PaUtilConverter *Int24In32_To_Int8_Dither; */
+    Int24In32_To_UInt8,            /* PaUtilConverter *Int24In32_To_UInt8; */
+    Int24In32_To_UInt8_Dither,     /* PaUtilConverter *Int24In32_To_UInt8_Dither; */
+
     Int16_To_Float32,              /* PaUtilConverter *Int16_To_Float32; */
+    Int16_To_Float64,              /* PaUtilConverter *Int16_To_Float64; */
     Int16_To_Int32,                /* PaUtilConverter *Int16_To_Int32; */
     Int16_To_Int24,                /* PaUtilConverter *Int16_To_Int24; */
+    Int16_To_Int24In32,            /* PaUtilConverter *Int16_To_Int24In32; */
     Int16_To_Int8,                 /* PaUtilConverter *Int16_To_Int8; */
     Int16_To_Int8_Dither,          /* PaUtilConverter *Int16_To_Int8_Dither; */
     Int16_To_UInt8,                /* PaUtilConverter *Int16_To_UInt8; */
     Int16_To_UInt8_Dither,         /* PaUtilConverter *Int16_To_UInt8_Dither; */
 
     Int8_To_Float32,               /* PaUtilConverter *Int8_To_Float32; */
+    Int8_To_Float64,               /* PaUtilConverter *Int8_To_Float64; */
     Int8_To_Int32,                 /* PaUtilConverter *Int8_To_Int32; */
     Int8_To_Int24,                 /* PaUtilConverter *Int8_To_Int24 */
+    Int8_To_Int24In32,             /* PaUtilConverter *Int8_To_Int24In32; */
     Int8_To_Int16,                 /* PaUtilConverter *Int8_To_Int16; */
     Int8_To_UInt8,                 /* PaUtilConverter *Int8_To_UInt8; */
 
     UInt8_To_Float32,              /* PaUtilConverter *UInt8_To_Float32; */
+    UInt8_To_Float64,              /* PaUtilConverter *UInt8_To_Float64; */
     UInt8_To_Int32,                /* PaUtilConverter *UInt8_To_Int32; */
     UInt8_To_Int24,                /* PaUtilConverter *UInt8_To_Int24; */
+    UInt8_To_Int24In32,            /* PaUtilConverter *UInt8_To_Int24In32; */
     UInt8_To_Int16,                /* PaUtilConverter *UInt8_To_Int16; */
     UInt8_To_Int8,                 /* PaUtilConverter *UInt8_To_Int8; */
 
+    Float64_To_Float32,            /* PaUtilConverter *Float64_To_Float32; */
+
+    Float64_To_Int32,              /* PaUtilConverter *Float64_To_Int32; */
+    Float64_To_Int32_Dither,       /* PaUtilConverter *Float64_To_Int32_Dither; */
+    Float64_To_Int32_Clip,         /* PaUtilConverter *Float64_To_Int32_Clip; */
+    Float64_To_Int32_DitherClip,   /* PaUtilConverter *Float64_To_Int32_DitherClip; */
+
+    Float64_To_Int24,              /* PaUtilConverter *Float64_To_Int24; */
+    Float64_To_Int24_Dither,       /* PaUtilConverter *Float64_To_Int24_Dither; */
+    Float64_To_Int24_Clip,         /* PaUtilConverter *Float64_To_Int24_Clip; */
+    Float64_To_Int24_DitherClip,   /* PaUtilConverter *Float64_To_Int24_DitherClip; */
+
+    Float64_To_Int24In32,          /* PaUtilConverter *Float64_To_Int24In32; */
+    Float64_To_Int24In32_Dither,   /* PaUtilConverter *Float64_To_Int24In32_Dither; */
+    Float64_To_Int24In32_Clip,     /* PaUtilConverter *Float64_To_Int24In32_Clip; */
+    Float64_To_Int24In32_DitherClip, /* PaUtilConverter *Float64_To_Int24In32_DitherClip; */
+
+    Float64_To_Int16,              /* PaUtilConverter *Float64_To_Int16; */
+    Float64_To_Int16_Dither,       /* PaUtilConverter *Float64_To_Int16_Dither; */
+    Float64_To_Int16_Clip,         /* PaUtilConverter *Float64_To_Int16_Clip; */
+    Float64_To_Int16_DitherClip,   /* PaUtilConverter *Float64_To_Int16_DitherClip; */
+
+    Float64_To_Int8,               /* PaUtilConverter *Float64_To_Int8; */
+    Float64_To_Int8_Dither,        /* PaUtilConverter *Float64_To_Int8_Dither; */
+    Float64_To_Int8_Clip,          /* PaUtilConverter *Float64_To_Int8_Clip; */
+    Float64_To_Int8_DitherClip,    /* PaUtilConverter *Float64_To_Int8_DitherClip; */
+
+    Float64_To_UInt8,              /* PaUtilConverter *Float64_To_UInt8; */
+    Float64_To_UInt8_Dither,       /* PaUtilConverter *Float64_To_UInt8_Dither; */
+    Float64_To_UInt8_Clip,         /* PaUtilConverter *Float64_To_UInt8_Clip; */
+    Float64_To_UInt8_DitherClip,   /* PaUtilConverter *Float64_To_UInt8_DitherClip; */
+
     Copy_8_To_8,                   /* PaUtilConverter *Copy_8_To_8; */
     Copy_16_To_16,                 /* PaUtilConverter *Copy_16_To_16; */
     Copy_24_To_24,                 /* PaUtilConverter *Copy_24_To_24; */
-    Copy_32_To_32                  /* PaUtilConverter *Copy_32_To_32; */
+    Copy_32_To_32,                 /* PaUtilConverter *Copy_32_To_32; */
+    Copy_64_To_64                  /* PaUtilConverter *Copy_64_To_64; */
 };
 
 /* -------------------------------------------------------------------------- */
@@ -1811,6 +3564,71 @@ PaUtilConverterTable paConverters = {
 
 /* -------------------------------------------------------------------------- */
 
+void PaUtil_InitializeConverters( void )
+{
+#ifndef PA_NO_STANDARD_CONVERTERS
+    PaUtilConverterTable simdConverters;
+
+    memset( &simdConverters, 0, sizeof(simdConverters) );
+    PaUtil_GetSimdConverters( &simdConverters, PaUtil_GetAvailableSimdInstructionSets() );
+
+    /* only replace the standard converters, never a user supplied one */
+#define PA_SUBSTITUTE_CONVERTER_( name ) \
+    if( simdConverters.name != 0 && paConverters.name == name ) \
+        paConverters.name = simdConverters.name;
+
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int32 )
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int32_Dither )
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int32_Clip )
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int32_DitherClip )
+
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int24 )
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int24_Dither )
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int24_Clip )
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int24_DitherClip )
+
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int24In32 )
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int24In32_Dither )
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int24In32_Clip )
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int24In32_DitherClip )
+
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int16 )
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int16_Dither )
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int16_Clip )
+    PA_SUBSTITUTE_CONVERTER_( Float32_To_Int16_DitherClip )
+
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Float32 )
+
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int32 )
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int32_Dither )
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int32_Clip )
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int32_DitherClip )
+
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int24 )
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int24_Dither )
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int24_Clip )
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int24_DitherClip )
+
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int24In32 )
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int24In32_Dither )
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int24In32_Clip )
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int24In32_DitherClip )
+
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int16 )
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int16_Dither )
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int16_Clip )
+    PA_SUBSTITUTE_CONVERTER_( Float64_To_Int16_DitherClip )
+
+    PA_SUBSTITUTE_CONVERTER_( Int32_To_Int24 )
+    PA_SUBSTITUTE_CONVERTER_( Int24_To_Float32 )
+    PA_SUBSTITUTE_CONVERTER_( Int24_To_Int32 )
+
+#undef PA_SUBSTITUTE_CONVERTER_
+#endif /* PA_NO_STANDARD_CONVERTERS */
+}
+
+/* -------------------------------------------------------------------------- */
+
 PaUtilZeroer* PaUtil_SelectZeroer( PaSampleFormat destinationFormat )
 {
     switch( destinationFormat & ~paNonInterleaved ){
@@ -1818,6 +3636,8 @@ PaUtilZeroer* PaUtil_SelectZeroer( PaSampleFormat destinationFormat )
         return paZeroers.Zero32;
     case paInt32:
         return paZeroers.Zero32;
+    case paInt24In32:
+        return paZeroers.Zero32;
     case paInt24:
         return paZeroers.Zero24;
     case paInt16:
@@ -1826,6 +3646,8 @@ PaUtilZeroer* PaUtil_SelectZeroer( PaSampleFormat destinationFormat )
         return paZeroers.Zero8;
     case paUInt8:
         return paZeroers.ZeroU8;
+    case paFloat64:
+        return paZeroers.Zero64;
     default: return 0;
     }
 }
@@ -1842,6 +3664,7 @@ PaUtilZeroerTable paZeroers = {
     0,  /* PaUtilZeroer *Zero16; */
     0,  /* PaUtilZeroer *Zero24; */
     0,  /* PaUtilZeroer *Zero32; */
+    0,  /* PaUtilZeroer *Zero64; */
 };
 
 /* -------------------------------------------------------------------------- */
@@ -1927,12 +3750,28 @@ static void Zero32( void *destinationBuffer, signed int destinationStride,
 
 /* -------------------------------------------------------------------------- */
 
+static void Zero64( void *destinationBuffer, signed int destinationStride,
+        unsigned int count )
+{
+    PaUint32 *dest = (PaUint32 *)destinationBuffer;
+
+    while( count-- )
+    {
+        dest[0] = 0;
+        dest[1] = 0;
+        dest += destinationStride * 2;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
 PaUtilZeroerTable paZeroers = {
     ZeroU8,  /* PaUtilZeroer *ZeroU8; */
     Zero8,  /* PaUtilZeroer *Zero8; */
     Zero16,  /* PaUtilZeroer *Zero16; */
     Zero24,  /* PaUtilZeroer *Zero24; */
     Zero32,  /* PaUtilZeroer *Zero32; */
+    Zero64,  /* PaUtilZeroer *Zero64; */
 };
 
 /* -------------------------------------------------------------------------- */
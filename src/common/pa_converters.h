@@ -54,9 +54,6 @@ extern "C"
 #endif /* __cplusplus */
 
 
-struct PaUtilTriangularDitherGenerator;
-
-
 /** Choose an available sample format which is most appropriate for
  representing the requested format. If the requested format is not available
  higher quality formats are considered before lower quality formats.
@@ -84,13 +81,14 @@ PaSampleFormat PaUtil_SelectClosestAvailableFormat(
     expressed in samples (not bytes.) It may be negative.
     @param count The number of samples to convert.
     @param ditherState State information used to calculate dither. Converters
-    that do not perform dithering will ignore this parameter, in which case
-    NULL or invalid dither state may be passed.
+    that do not perform dithering or clipping will ignore this parameter, in
+    which case NULL or invalid dither state may be passed. Clipping converters
+    add the number of samples they clipped to its clippedSampleCount field.
+    The state is a PaUtilTriangularDitherGenerator, whose struct is
+    PaSampleConverterState, so this is the same type as PaSampleConverter and
+    converters supplied by applications are called with their own type.
 */
-typedef void PaUtilConverter(
-    void *destinationBuffer, signed int destinationStride,
-    void *sourceBuffer, signed int sourceStride,
-    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator );
+typedef PaSampleConverter PaUtilConverter;
 
 
 /** Find a sample converter function for the given source and destinations
@@ -103,11 +101,41 @@ typedef void PaUtilConverter(
     version is returned.
     If the source and destination formats are the same, a function which
     copies data of the appropriate size will be returned.
+    A converter registered with PaUtil_RegisterConverter() for the same
+    formats and flags is returned in preference to the built-in ones.
 */
 PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
         PaSampleFormat destinationFormat, PaStreamFlags flags );
 
 
+/** Return non-zero if converter is one of the dithering or noise shaping
+    converters of paConverters, whose output depends on the order in which
+    the dither generator is consumed. NULL and converters which only
+    count clipped samples in the dither generator return 0.
+*/
+int PaUtil_ConverterDithers( PaUtilConverter *converter );
+
+
+/** Register a converter to be returned by PaUtil_SelectConverter() for the
+    given formats and flags, replacing any converter previously registered for
+    them. Only the paClipOff, paDitherOff and paNoiseShapedDither flags and the
+    formats without paNonInterleaved are compared. Passing a NULL converter
+    removes the registration. This is the implementation of
+    Pa_RegisterConverter(), which validates the parameters.
+    @return paNoError, or paInsufficientMemory if too many converters are
+    registered.
+*/
+PaError PaUtil_RegisterConverter( PaSampleFormat sourceFormat,
+        PaSampleFormat destinationFormat, PaStreamFlags flags, PaUtilConverter *converter );
+
+
+/** Return the converter registered with PaUtil_RegisterConverter() for the
+    given formats and flags, or NULL if there is none.
+*/
+PaUtilConverter* PaUtil_FindRegisteredConverter( PaSampleFormat sourceFormat,
+        PaSampleFormat destinationFormat, PaStreamFlags flags );
+
+
 /** The generic buffer zeroer prototype. Buffer zeroers copy count zeros to
     destinationBuffer. The actual type of the data pointed to varys for
     different zeroer functions.
@@ -146,24 +174,36 @@ typedef struct{
     PaUtilConverter *Float32_To_Int24_Clip;
     PaUtilConverter *Float32_To_Int24_DitherClip;
 
+    PaUtilConverter *Float32_To_Int24In32;
+    PaUtilConverter *Float32_To_Int24In32_Dither;
+    PaUtilConverter *Float32_To_Int24In32_Clip;
+    PaUtilConverter *Float32_To_Int24In32_DitherClip;
+
     PaUtilConverter *Float32_To_Int16;
     PaUtilConverter *Float32_To_Int16_Dither;
     PaUtilConverter *Float32_To_Int16_Clip;
     PaUtilConverter *Float32_To_Int16_DitherClip;
+    PaUtilConverter *Float32_To_Int16_NoiseShaped;
 
     PaUtilConverter *Float32_To_Int8;
     PaUtilConverter *Float32_To_Int8_Dither;
     PaUtilConverter *Float32_To_Int8_Clip;
     PaUtilConverter *Float32_To_Int8_DitherClip;
+    PaUtilConverter *Float32_To_Int8_NoiseShaped;
 
     PaUtilConverter *Float32_To_UInt8;
     PaUtilConverter *Float32_To_UInt8_Dither;
     PaUtilConverter *Float32_To_UInt8_Clip;
     PaUtilConverter *Float32_To_UInt8_DitherClip;
+    PaUtilConverter *Float32_To_UInt8_NoiseShaped;
+
+    PaUtilConverter *Float32_To_Float64;
 
     PaUtilConverter *Int32_To_Float32;
+    PaUtilConverter *Int32_To_Float64;
     PaUtilConverter *Int32_To_Int24;
     PaUtilConverter *Int32_To_Int24_Dither;
+    PaUtilConverter *Int32_To_Int24In32;
     PaUtilConverter *Int32_To_Int16;
     PaUtilConverter *Int32_To_Int16_Dither;
     PaUtilConverter *Int32_To_Int8;
@@ -172,7 +212,9 @@ typedef struct{
     PaUtilConverter *Int32_To_UInt8_Dither;
 
     PaUtilConverter *Int24_To_Float32;
+    PaUtilConverter *Int24_To_Float64;
     PaUtilConverter *Int24_To_Int32;
+    PaUtilConverter *Int24_To_Int24In32;
     PaUtilConverter *Int24_To_Int16;
     PaUtilConverter *Int24_To_Int16_Dither;
     PaUtilConverter *Int24_To_Int8;
@@ -180,30 +222,80 @@ typedef struct{
     PaUtilConverter *Int24_To_UInt8;
     PaUtilConverter *Int24_To_UInt8_Dither;
 
+    PaUtilConverter *Int24In32_To_Float32;
+    PaUtilConverter *Int24In32_To_Float64;
+    PaUtilConverter *Int24In32_To_Int32;
+    PaUtilConverter *Int24In32_To_Int24;
+    PaUtilConverter *Int24In32_To_Int16;
+    PaUtilConverter *Int24In32_To_Int16_Dither;
+    PaUtilConverter *Int24In32_To_Int8;
+    PaUtilConverter *Int24In32_To_Int8_Dither;
+    PaUtilConverter *Int24In32_To_UInt8;
+    PaUtilConverter *Int24In32_To_UInt8_Dither;
+
     PaUtilConverter *Int16_To_Float32;
+    PaUtilConverter *Int16_To_Float64;
     PaUtilConverter *Int16_To_Int32;
     PaUtilConverter *Int16_To_Int24;
+    PaUtilConverter *Int16_To_Int24In32;
     PaUtilConverter *Int16_To_Int8;
     PaUtilConverter *Int16_To_Int8_Dither;
     PaUtilConverter *Int16_To_UInt8;
     PaUtilConverter *Int16_To_UInt8_Dither;
 
     PaUtilConverter *Int8_To_Float32;
+    PaUtilConverter *Int8_To_Float64;
     PaUtilConverter *Int8_To_Int32;
     PaUtilConverter *Int8_To_Int24;
+    PaUtilConverter *Int8_To_Int24In32;
     PaUtilConverter *Int8_To_Int16;
     PaUtilConverter *Int8_To_UInt8;
 
     PaUtilConverter *UInt8_To_Float32;
+    PaUtilConverter *UInt8_To_Float64;
     PaUtilConverter *UInt8_To_Int32;
     PaUtilConverter *UInt8_To_Int24;
+    PaUtilConverter *UInt8_To_Int24In32;
     PaUtilConverter *UInt8_To_Int16;
     PaUtilConverter *UInt8_To_Int8;
 
+    PaUtilConverter *Float64_To_Float32;
+
+    PaUtilConverter *Float64_To_Int32;
+    PaUtilConverter *Float64_To_Int32_Dither;
+    PaUtilConverter *Float64_To_Int32_Clip;
+    PaUtilConverter *Float64_To_Int32_DitherClip;
+
+    PaUtilConverter *Float64_To_Int24;
+    PaUtilConverter *Float64_To_Int24_Dither;
+    PaUtilConverter *Float64_To_Int24_Clip;
+    PaUtilConverter *Float64_To_Int24_DitherClip;
+
+    PaUtilConverter *Float64_To_Int24In32;
+    PaUtilConverter *Float64_To_Int24In32_Dither;
+    PaUtilConverter *Float64_To_Int24In32_Clip;
+    PaUtilConverter *Float64_To_Int24In32_DitherClip;
+
+    PaUtilConverter *Float64_To_Int16;
+    PaUtilConverter *Float64_To_Int16_Dither;
+    PaUtilConverter *Float64_To_Int16_Clip;
+    PaUtilConverter *Float64_To_Int16_DitherClip;
+
+    PaUtilConverter *Float64_To_Int8;
+    PaUtilConverter *Float64_To_Int8_Dither;
+    PaUtilConverter *Float64_To_Int8_Clip;
+    PaUtilConverter *Float64_To_Int8_DitherClip;
+
+    PaUtilConverter *Float64_To_UInt8;
+    PaUtilConverter *Float64_To_UInt8_Dither;
+    PaUtilConverter *Float64_To_UInt8_Clip;
+    PaUtilConverter *Float64_To_UInt8_DitherClip;
+
     PaUtilConverter *Copy_8_To_8;       /* copy without any conversion */
     PaUtilConverter *Copy_16_To_16;     /* copy without any conversion */
     PaUtilConverter *Copy_24_To_24;     /* copy without any conversion */
     PaUtilConverter *Copy_32_To_32;     /* copy without any conversion */
+    PaUtilConverter *Copy_64_To_64;     /* copy without any conversion */
 } PaUtilConverterTable;
 
 
@@ -227,6 +319,19 @@ typedef struct{
 extern PaUtilConverterTable paConverters;
 
 
+/** Substitute optimised converters into paConverters. SIMD implementations
+    of the Float32 to Int32, Int24 and Int16 converters and of the packed
+    Int24 converters are installed when the running processor supports them
+    (see pa_simd_converters.h).
+    Fields which no longer contain the standard converters, because user
+    code has already substituted its own functions, are left untouched.
+    This function is called by Pa_Initialize().
+
+    @see paConverters, PaUtil_GetSimdConverters
+*/
+void PaUtil_InitializeConverters( void );
+
+
 /** The type used to store all buffer zeroing functions.
     @see paZeroers;
 */
@@ -236,6 +341,7 @@ typedef struct{
     PaUtilZeroer *Zero16;
     PaUtilZeroer *Zero24;
     PaUtilZeroer *Zero32;
+    PaUtilZeroer *Zero64;
 } PaUtilZeroerTable;
 
 
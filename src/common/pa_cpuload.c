@@ -41,7 +41,8 @@
  @ingroup common_src
 
  @brief Functions to assist in measuring the CPU utilization of a callback
- stream. Used to implement the Pa_GetStreamCpuLoad() function.
+ stream. Used to implement the Pa_GetStreamCpuLoad() function, and the timing
+ fields of Pa_GetStreamStatistics().
 
  @todo Dynamically calculate the coefficients used to smooth the CPU Load
  Measurements over time to provide a uniform characterisation of CPU Load
@@ -53,26 +54,77 @@
 #include "pa_cpuload.h"
 
 #include <assert.h>
+#include <math.h>
+#include <string.h> /* memset() */
 
 #include "pa_util.h"   /* for PaUtil_GetTime() */
 
 
+#define HISTOGRAM_STEPS_PER_OCTAVE  (4)
+
+
+static int GetHistogramBucket( double seconds )
+{
+    double microseconds = seconds * 1000000., mantissa;
+    int exponent, bucket;
+
+    if( microseconds < 1. )
+        return 0;
+
+    /* microseconds = mantissa * 2^exponent, 0.5 <= mantissa < 1 */
+    mantissa = frexp( microseconds, &exponent );
+    bucket = 1 + (exponent - 1) * HISTOGRAM_STEPS_PER_OCTAVE
+            + (int)((mantissa * 2. - 1.) * HISTOGRAM_STEPS_PER_OCTAVE);
+
+    return bucket < PA_CPULOAD_HISTOGRAM_BUCKETS ? bucket : PA_CPULOAD_HISTOGRAM_BUCKETS - 1;
+}
+
+
+/* the upper limit of a bucket, in seconds */
+static double GetHistogramBucketLimit( int bucket )
+{
+    if( bucket == 0 )
+        return 0.000001;
+
+    --bucket;
+    return ldexp( 1. + (double)(bucket % HISTOGRAM_STEPS_PER_OCTAVE + 1) / HISTOGRAM_STEPS_PER_OCTAVE,
+            bucket / HISTOGRAM_STEPS_PER_OCTAVE ) * 0.000001;
+}
+
+
 void PaUtil_InitializeCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer, double sampleRate )
 {
     assert( sampleRate > 0 );
 
     measurer->samplingPeriod = 1. / sampleRate;
     measurer->averageLoad = 0.;
+    measurer->previousStartTime = 0.;
+    measurer->expectedPeriod = 0.;
+    memset( &measurer->totals, 0, sizeof(measurer->totals) );
+    memset( &measurer->totalsRead, 0, sizeof(measurer->totalsRead) );
 }
 
 void PaUtil_ResetCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer )
 {
     measurer->averageLoad = 0.;
+
+    /* don't count the time the stream was stopped as jitter */
+    measurer->previousStartTime = 0.;
 }
 
 void PaUtil_BeginCpuLoadMeasurement( PaUtilCpuLoadMeasurer* measurer )
 {
-    measurer->measurementStartTime = PaUtil_GetTime();
+    double now = PaUtil_GetTime();
+
+    if( measurer->previousStartTime > 0. && measurer->expectedPeriod > 0. )
+    {
+        ++measurer->totals.jitterHistogram[ GetHistogramBucket(
+                fabs( (now - measurer->previousStartTime) - measurer->expectedPeriod ) ) ];
+    }
+    measurer->previousStartTime = now;
+    measurer->expectedPeriod = 0.;
+
+    measurer->measurementStartTime = now;
 }
 
 
@@ -88,6 +140,13 @@ void PaUtil_EndCpuLoadMeasurement( PaUtilCpuLoadMeasurer* measurer, unsigned lon
 
         measuredLoad = (measurementEndTime - measurer->measurementStartTime) / secondsFor100Percent;
 
+        ++measurer->totals.measurementCount;
+        ++measurer->totals.durationHistogram[ GetHistogramBucket(
+                measurementEndTime - measurer->measurementStartTime ) ];
+        if( measuredLoad > 1. )
+            ++measurer->totals.deadlineMissCount;
+        measurer->expectedPeriod = secondsFor100Percent;
+
         /* Low pass filter the calculated CPU load to reduce jitter using a simple IIR low pass filter. */
         /** FIXME @todo these coefficients shouldn't be hardwired see: http://www.portaudio.com/trac/ticket/113 */
 #define LOWPASS_COEFFICIENT_0   (0.9)
@@ -103,3 +162,48 @@ double PaUtil_GetCpuLoad( PaUtilCpuLoadMeasurer* measurer )
 {
     return measurer->averageLoad;
 }
+
+
+void PaUtil_ReadCpuLoadStatistics( PaUtilCpuLoadMeasurer* measurer, PaUtilCpuLoadStatistics *statistics )
+{
+    /* As with the clipped sample counts of the buffer processor, the totals
+        are only written by the measuring thread, so rather than resetting them
+        we remember where the previous read left off. PaUtilCpuLoadStatistics
+        only contains unsigned longs, so it is handled as an array of them. */
+    const volatile unsigned long *totals = (const volatile unsigned long*)&measurer->totals;
+    unsigned long *totalsRead = (unsigned long*)&measurer->totalsRead;
+    unsigned long *result = (unsigned long*)statistics;
+    size_t i;
+
+    for( i=0; i < sizeof(PaUtilCpuLoadStatistics) / sizeof(unsigned long); ++i )
+    {
+        unsigned long total = totals[i];
+
+        result[i] = total - totalsRead[i];
+        totalsRead[i] = total;
+    }
+}
+
+
+double PaUtil_GetCpuLoadHistogramPercentile( const unsigned long *histogram, double fraction )
+{
+    unsigned long count = 0, sum = 0, target;
+    int i;
+
+    for( i=0; i < PA_CPULOAD_HISTOGRAM_BUCKETS; ++i )
+        count += histogram[i];
+    if( count == 0 )
+        return 0.;
+
+    target = (unsigned long)ceil( fraction * count );
+    if( target < 1 )
+        target = 1;
+
+    for( i=0; i < PA_CPULOAD_HISTOGRAM_BUCKETS - 1; ++i )
+    {
+        sum += histogram[i];
+        if( sum >= target )
+            break;
+    }
+    return GetHistogramBucketLimit( i );
+}
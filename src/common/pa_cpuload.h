@@ -43,7 +43,8 @@
  @ingroup common_src
 
  @brief Functions to assist in measuring the CPU utilization of a callback
- stream. Used to implement the Pa_GetStreamCpuLoad() function.
+ stream. Used to implement the Pa_GetStreamCpuLoad() function, and the timing
+ fields of Pa_GetStreamStatistics().
 */
 
 
@@ -53,10 +54,32 @@ extern "C"
 #endif /* __cplusplus */
 
 
-typedef struct {
+/** The number of buckets of the histograms in PaUtilCpuLoadStatistics.
+ Bucket 0 counts times below 1 microsecond, after that each octave is split
+ into 4 buckets of equal width. The last bucket, starting at 0.92 seconds,
+ also counts all longer times.
+*/
+#define PA_CPULOAD_HISTOGRAM_BUCKETS    (80)
+
+/** Counters kept by a PaUtilCpuLoadMeasurer, see PaUtil_ReadCpuLoadStatistics(). */
+typedef struct PaUtilCpuLoadStatistics {
+    unsigned long measurementCount;
+    unsigned long deadlineMissCount; /**< measurements which took longer than the frames they processed last */
+    unsigned long durationHistogram[PA_CPULOAD_HISTOGRAM_BUCKETS]; /**< measured durations */
+    unsigned long jitterHistogram[PA_CPULOAD_HISTOGRAM_BUCKETS]; /**< deviations of the time between the
+                                                                      starts of two measurements from the
+                                                                      duration of the frames processed by
+                                                                      the first */
+} PaUtilCpuLoadStatistics;
+
+typedef struct PaUtilCpuLoadMeasurer {
     double samplingPeriod;
     double measurementStartTime;
     double averageLoad;
+    double previousStartTime; /**< 0 before the first measurement after a reset */
+    double expectedPeriod; /**< the duration of the frames processed by the previous measurement */
+    PaUtilCpuLoadStatistics totals; /**< running totals, only written by the measuring thread */
+    PaUtilCpuLoadStatistics totalsRead; /**< the totals at the previous call to PaUtil_ReadCpuLoadStatistics() */
 } PaUtilCpuLoadMeasurer; /**< @todo need better name than measurer */
 
 void PaUtil_InitializeCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer, double sampleRate );
@@ -65,6 +88,25 @@ void PaUtil_EndCpuLoadMeasurement( PaUtilCpuLoadMeasurer* measurer, unsigned lon
 void PaUtil_ResetCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer );
 double PaUtil_GetCpuLoad( PaUtilCpuLoadMeasurer* measurer );
 
+/** Retrieve the counters of a CPU load measurer accumulated since the
+ previous call, or since the measurer was initialized. May be called from any
+ thread while the stream is running, but only from one at a time.
+*/
+void PaUtil_ReadCpuLoadStatistics( PaUtilCpuLoadMeasurer* measurer, PaUtilCpuLoadStatistics *statistics );
+
+/** Estimate a percentile of the times counted in a histogram of
+ PaUtilCpuLoadStatistics.
+
+ @param histogram One of the histograms of a PaUtilCpuLoadStatistics structure.
+
+ @param fraction The fraction of the counted times, between 0 and 1, which are
+ at most the returned time. 1 estimates the maximum.
+
+ @return The upper limit of the bucket in which the percentile lies, in
+ seconds, or 0 if the histogram is empty.
+*/
+double PaUtil_GetCpuLoadHistogramPercentile( const unsigned long *histogram, double fraction );
+
 
 #ifdef __cplusplus
 }
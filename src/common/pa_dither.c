@@ -59,6 +59,21 @@ void PaUtil_InitializeTriangularDitherState( PaUtilTriangularDitherGenerator *st
     state->previous = 0;
     state->randSeed1 = 22222;
     state->randSeed2 = 5555555;
+    state->shapingError1 = 0.f;
+    state->shapingError2 = 0.f;
+    state->clippedSampleCount = 0;
+}
+
+
+void PaUtil_InitializeChannelTriangularDitherState( PaUtilTriangularDitherGenerator *state,
+        unsigned int channel )
+{
+    PaUtil_InitializeTriangularDitherState( state );
+
+    /* Both generators have a full period of 2^32, so offsetting the seeds
+        selects a different, widely separated part of the same sequence. */
+    state->randSeed1 += (PaUint32)channel * 0x9E3779B9UL;
+    state->randSeed2 += (PaUint32)channel * 0x7F4A7C15UL;
 }
 
 
@@ -112,9 +127,73 @@ float PaUtil_GenerateFloatTriangularDither( PaUtilTriangularDitherGenerator *sta
 }
 
 
+/* The number of values of the random sequence generated at once by
+    PaUtil_GenerateFloatTriangularDitherBlock(). */
+#define PA_DITHER_LANES_  (8)
+
+/* The multiplier and increment which advance the linear congruential
+    generator by PA_DITHER_LANES_ steps at once:
+    a^8 and c * (a^7 + a^6 + ... + 1) modulo 2^32 for a = 196314165,
+    c = 907633515. */
+#define PA_DITHER_LANES_MULTIPLIER_  ((PaUint32)1298576737UL)
+#define PA_DITHER_LANES_INCREMENT_   ((PaUint32)381724904UL)
+
+void PaUtil_GenerateFloatTriangularDitherBlock( PaUtilTriangularDitherGenerator *state,
+        float *dither, unsigned int count )
+{
+    PaUint32 seed1[ PA_DITHER_LANES_ ], seed2[ PA_DITHER_LANES_ ];
+    PaInt32 current[ PA_DITHER_LANES_ + 1 ]; /* current[0] is the previous value */
+    unsigned int i = 0, j;
+
+    if( count >= PA_DITHER_LANES_ )
+    {
+        /* lane j holds the seeds for the j-th value of each group */
+        seed1[0] = (state->randSeed1 * 196314165) + 907633515;
+        seed2[0] = (state->randSeed2 * 196314165) + 907633515;
+        for( j=1; j < PA_DITHER_LANES_; ++j )
+        {
+            seed1[j] = (seed1[j-1] * 196314165) + 907633515;
+            seed2[j] = (seed2[j-1] * 196314165) + 907633515;
+        }
+        current[0] = (PaInt32)state->previous;
+
+        for( ; i + PA_DITHER_LANES_ <= count; i += PA_DITHER_LANES_ )
+        {
+            for( j=0; j < PA_DITHER_LANES_; ++j )
+            {
+                current[j+1] = (((PaInt32)seed1[j])>>DITHER_SHIFT_) +
+                               (((PaInt32)seed2[j])>>DITHER_SHIFT_);
+            }
+
+            /* the high pass filter is the only dependency between values */
+            for( j=0; j < PA_DITHER_LANES_; ++j )
+                dither[i+j] = ((float)(current[j+1] - current[j])) * const_float_dither_scale_;
+            current[0] = current[ PA_DITHER_LANES_ ];
+
+            state->randSeed1 = seed1[ PA_DITHER_LANES_ - 1 ];
+            state->randSeed2 = seed2[ PA_DITHER_LANES_ - 1 ];
+            for( j=0; j < PA_DITHER_LANES_; ++j )
+            {
+                seed1[j] = (seed1[j] * PA_DITHER_LANES_MULTIPLIER_) + PA_DITHER_LANES_INCREMENT_;
+                seed2[j] = (seed2[j] * PA_DITHER_LANES_MULTIPLIER_) + PA_DITHER_LANES_INCREMENT_;
+            }
+        }
+
+        state->previous = (PaUint32)current[0];
+    }
+
+    for( ; i < count; ++i )
+        dither[i] = PaUtil_GenerateFloatTriangularDither( state );
+}
+
+
 /*
-The following alternate dither algorithms (from musicdsp.org) could be
-considered
+The noise shaped dither below (from musicdsp.org) is implemented by the
+Float32_To_Int16_NoiseShaped, Float32_To_Int8_NoiseShaped and
+Float32_To_UInt8_NoiseShaped converters in pa_converters.c, which are
+selected with the paNoiseShapedDither stream flag. They use the high pass
+triangular dither generated above and round to nearest rather than
+truncating. The first order algorithm which follows it could be considered.
 */
 
 /*Noise shaped dither  (March 2000)
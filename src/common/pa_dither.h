@@ -57,11 +57,16 @@ extern "C"
  * unsigned long so it will work on 64 bit systems.
  */
 
-/** @brief State needed to generate a dither signal */
-typedef struct PaUtilTriangularDitherGenerator{
+/** @brief State needed to generate a dither signal. It is passed to sample
+ converters, and PaSampleConverterState is its opaque name in portaudio.h.
+*/
+typedef struct PaSampleConverterState{
     PaUint32 previous;
     PaUint32 randSeed1;
     PaUint32 randSeed2;
+    float shapingError1; /**< error feedback of the noise shaping converters */
+    float shapingError2;
+    unsigned long clippedSampleCount; /**< incremented by the clipping converters for every sample they clip */
 } PaUtilTriangularDitherGenerator;
 
 
@@ -69,6 +74,16 @@ typedef struct PaUtilTriangularDitherGenerator{
 void PaUtil_InitializeTriangularDitherState( PaUtilTriangularDitherGenerator *ditherState );
 
 
+/** @brief Initialize dither state for one of several channels which are
+ dithered independently. Channel 0 is initialized exactly like
+ PaUtil_InitializeTriangularDitherState(), other channels start at
+ different points of the random sequence so that their dither signals
+ are uncorrelated.
+*/
+void PaUtil_InitializeChannelTriangularDitherState( PaUtilTriangularDitherGenerator *ditherState,
+        unsigned int channel );
+
+
 /**
  @brief Calculate 2 LSB dither signal with a triangular distribution.
  Ranged for adding to a 1 bit right-shifted 32 bit integer
@@ -99,6 +114,21 @@ PaInt32 PaUtil_Generate16BitTriangularDither( PaUtilTriangularDitherGenerator *d
 float PaUtil_GenerateFloatTriangularDither( PaUtilTriangularDitherGenerator *ditherState );
 
 
+/**
+ @brief Fill dither with count values of the signal returned by
+ PaUtil_GenerateFloatTriangularDither().
+
+ The result and the final state are identical to calling
+ PaUtil_GenerateFloatTriangularDither() count times, but several
+ independent streams of the random number generators are advanced at once
+ so the loop has no serial dependency and can be vectorized by the compiler.
+ Converters should fill a block of dither values with this function and then
+ consume them, rather than generating one value per sample.
+*/
+void PaUtil_GenerateFloatTriangularDitherBlock( PaUtilTriangularDitherGenerator *ditherState,
+        float *dither, unsigned int count );
+
+
 
 #ifdef __cplusplus
 }
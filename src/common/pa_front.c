@@ -74,6 +74,9 @@
 #include "pa_types.h"
 #include "pa_hostapi.h"
 #include "pa_stream.h"
+#include "pa_process.h"
+#include "pa_cpuload.h"
+#include "pa_converters.h"
 #include "pa_trace.h" /* still useful?*/
 #include "pa_debugprint.h"
 
@@ -381,6 +384,7 @@ PaError Pa_Initialize( void )
 
         PaUtil_InitializeClock();
         PaUtil_ResetTraceMessages();
+        PaUtil_InitializeConverters();
 
         result = InitializeHostApis();
         if( result == paNoError )
@@ -808,9 +812,11 @@ static int SampleFormatIsValid( PaSampleFormat format )
     switch( format & ~paNonInterleaved )
     {
     case paFloat32: return 1;
+    case paFloat64: return 1;
     case paInt16: return 1;
     case paInt32: return 1;
     case paInt24: return 1;
+    case paInt24In32: return 1;
     case paInt8: return 1;
     case paUInt8: return 1;
     case paCustomFormat: return 1;
@@ -1023,9 +1029,43 @@ static PaError ValidateOpenStreamParameters(
     if( (sampleRate < 1000.0) || (sampleRate > 768000.0) )
         return paInvalidSampleRate;
 
-    if( ((streamFlags & ~paPlatformSpecificFlags) & ~(paClipOff | paDitherOff | paNeverDropInput | paPrimeOutputBuffersUsingStreamCallback ) ) != 0 )
+    if( ((streamFlags & ~paPlatformSpecificFlags) & ~(paClipOff | paDitherOff | paNeverDropInput | paPrimeOutputBuffersUsingStreamCallback | paNoiseShapedDither
+            | paPipelineCallback | paPipelineLookaheadMask
+            | paConvertSampleRate | paSampleRateConversionQualityMask ) ) != 0 )
         return paInvalidFlag;
 
+    if( streamFlags & paPipelineCallback )
+    {
+        /* must be a callback stream */
+        if( !streamCallback )
+            return paInvalidFlag;
+
+        /* needs fixed size buffers */
+        if( streamFlags & paNeverDropInput )
+            return paInvalidFlag;
+    }
+    else if( streamFlags & paPipelineLookaheadMask )
+    {
+        /* a lookahead without paPipelineCallback */
+        return paInvalidFlag;
+    }
+
+    if( streamFlags & paConvertSampleRate )
+    {
+        /* the conversion runs inside the stream callback */
+        if( !streamCallback )
+            return paInvalidFlag;
+
+        /* at most one quality */
+        if( (streamFlags & paSampleRateConversionQualityMask) == paSampleRateConversionQualityMask )
+            return paInvalidFlag;
+    }
+    else if( streamFlags & paSampleRateConversionQualityMask )
+    {
+        /* a quality without paConvertSampleRate */
+        return paInvalidFlag;
+    }
+
     if( streamFlags & paNeverDropInput )
     {
         /* must be a callback stream */
@@ -1272,8 +1312,22 @@ PaError Pa_OpenStream( PaStream** stream,
                                   sampleRate, framesPerBuffer, streamFlags, streamCallback, userData );
 
     if( result == paNoError )
+    {
         AddOpenStream( *stream );
 
+        /* remembered for the bounce buffers of Pa_AcquireWriteBuffer() and Pa_AcquireReadBuffer() */
+        if( inputParameters )
+        {
+            PA_STREAM_REP(*stream)->acquiredReadBuffer.sampleFormat = inputParameters->sampleFormat;
+            PA_STREAM_REP(*stream)->acquiredReadBuffer.channelCount = inputParameters->channelCount;
+        }
+        if( outputParameters )
+        {
+            PA_STREAM_REP(*stream)->acquiredWriteBuffer.sampleFormat = outputParameters->sampleFormat;
+            PA_STREAM_REP(*stream)->acquiredWriteBuffer.channelCount = outputParameters->channelCount;
+        }
+    }
+
 
     PA_LOGAPI(("Pa_OpenStream returned:\n" ));
     PA_LOGAPI(("\t*(PaStream** stream): 0x%p\n", *stream ));
@@ -1366,6 +1420,64 @@ PaError Pa_OpenDefaultStream( PaStream** stream,
 }
 
 
+/* Bounce buffers are used by Pa_AcquireWriteBuffer() and Pa_AcquireReadBuffer()
+    when the host API can't hand out its own memory. */
+
+static void FreeBounceBuffer( PaUtilAcquiredBuffer *acquired )
+{
+    if( acquired->bounceBuffer )
+        PaUtil_FreeMemory( acquired->bounceBuffer );
+    acquired->bounceBuffer = NULL;
+    acquired->bounceBufferFrames = 0;
+}
+
+
+static PaError ReserveBounceBuffer( PaUtilAcquiredBuffer *acquired, unsigned long frames )
+{
+    PaError sampleSize = Pa_GetSampleSize( acquired->sampleFormat );
+    size_t channelPointersSize = 0;
+
+    if( sampleSize < 0 )
+        return sampleSize;
+
+    if( frames <= acquired->bounceBufferFrames )
+        return paNoError;
+
+    if( acquired->sampleFormat & paNonInterleaved )
+        channelPointersSize = acquired->channelCount * sizeof(void*);
+
+    FreeBounceBuffer( acquired );
+    acquired->bounceBuffer = PaUtil_AllocateZeroInitializedMemory(
+            (long)(channelPointersSize + frames * acquired->channelCount * sampleSize) );
+    if( !acquired->bounceBuffer )
+        return paInsufficientMemory;
+    acquired->bounceBufferFrames = frames;
+
+    return paNoError;
+}
+
+
+/* Returns the bounce buffer from the given frame on, in the form which
+    Pa_ReadStream() and Pa_WriteStream() expect. */
+static void* GetBounceBufferRegion( PaUtilAcquiredBuffer *acquired, unsigned long offset )
+{
+    int sampleSize = Pa_GetSampleSize( acquired->sampleFormat );
+    void **channels;
+    char *samples;
+    int i;
+
+    if( !(acquired->sampleFormat & paNonInterleaved) )
+        return (char*)acquired->bounceBuffer + offset * acquired->channelCount * sampleSize;
+
+    channels = (void**)acquired->bounceBuffer;
+    samples = (char*)(channels + acquired->channelCount);
+    for( i=0; i < acquired->channelCount; ++i )
+        channels[i] = samples + (i * acquired->bounceBufferFrames + offset) * sampleSize;
+
+    return channels;
+}
+
+
 PaError PaUtil_ValidateStreamPointer( PaStream* stream )
 {
     if( !PA_IS_INITIALISED_ ) return paNotInitialized;
@@ -1396,6 +1508,9 @@ PaError Pa_CloseStream( PaStream* stream )
     {
         interface = PA_STREAM_INTERFACE(stream);
 
+        FreeBounceBuffer( &PA_STREAM_REP(stream)->acquiredWriteBuffer );
+        FreeBounceBuffer( &PA_STREAM_REP(stream)->acquiredReadBuffer );
+
         /* abort the stream if it isn't stopped */
         result = interface->IsStopped( stream );
         if( result == 1 )
@@ -1458,6 +1573,10 @@ PaError Pa_StartStream( PaStream *stream )
         }
         else if( result == 1 )
         {
+            if( PA_STREAM_REP( stream )->bufferProcessor
+                    && PA_STREAM_REP( stream )->bufferProcessor->outputChannelCount > 0 )
+                PaUtil_StartBufferProcessorOutputGain( PA_STREAM_REP( stream )->bufferProcessor );
+
             result = PA_STREAM_INTERFACE(stream)->Start( stream );
         }
     }
@@ -1468,6 +1587,45 @@ PaError Pa_StartStream( PaStream *stream )
 }
 
 
+/*
+    FadeOutStream() fades the output of an active callback stream out over
+    the fade out frames set with Pa_SetStreamFades(), and returns once the
+    buffer processor has converted the end of the fade. When waitUntilPlayed
+    is set it waits for the stream's output latency as well, so that the fade
+    has been heard before the stream's buffers are discarded.
+*/
+static void FadeOutStream( PaStream *stream, int waitUntilPlayed )
+{
+    PaUtilBufferProcessor *bufferProcessor = PA_STREAM_REP( stream )->bufferProcessor;
+    PaTime outputLatency = PA_STREAM_REP( stream )->streamInfo.outputLatency;
+    unsigned long request;
+    PaTime deadline;
+
+    if( bufferProcessor == 0 || bufferProcessor->outputChannelCount == 0
+            || PA_STREAM_REP( stream )->streamCallback == 0
+            || PA_STREAM_INTERFACE(stream)->IsActive( stream ) != 1 )
+        return;
+
+    request = PaUtil_FadeOutBufferProcessorOutput( bufferProcessor );
+    if( request == 0 )
+        return;
+
+    /* give up if the stream stops being processed */
+    deadline = PaUtil_GetTime() + bufferProcessor->outputFadeOutFrames * bufferProcessor->samplePeriod
+            + outputLatency + 1.;
+
+    while( !PaUtil_IsBufferProcessorOutputGainRequestDone( bufferProcessor, request )
+            && PA_STREAM_INTERFACE(stream)->IsActive( stream ) == 1
+            && PaUtil_GetTime() < deadline )
+    {
+        Pa_Sleep( 1 );
+    }
+
+    if( waitUntilPlayed && PA_STREAM_INTERFACE(stream)->IsActive( stream ) == 1 )
+        Pa_Sleep( (long)(outputLatency * 1000.) + 1 );
+}
+
+
 PaError Pa_StopStream( PaStream *stream )
 {
     PaError result = PaUtil_ValidateStreamPointer( stream );
@@ -1480,6 +1638,8 @@ PaError Pa_StopStream( PaStream *stream )
         result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
         if( result == 0 )
         {
+            /* stopping plays the buffers, which hold the end of the fade */
+            FadeOutStream( stream, 0 );
             result = PA_STREAM_INTERFACE(stream)->Stop( stream );
         }
         else if( result == 1 )
@@ -1506,6 +1666,7 @@ PaError Pa_AbortStream( PaStream *stream )
         result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
         if( result == 0 )
         {
+            FadeOutStream( stream, 1 );
             result = PA_STREAM_INTERFACE(stream)->Abort( stream );
         }
         else if( result == 1 )
@@ -1571,6 +1732,18 @@ const PaStreamInfo* Pa_GetStreamInfo( PaStream *stream )
     }
     else
     {
+        /* a pipelined callback receives copies of the host buffers, whatever
+            the buffer processor does */
+        if( PA_STREAM_REP( stream )->bufferProcessor
+                && !(PA_STREAM_REP( stream )->streamInfo.flags & paStreamInfoPipelinedCallback) )
+        {
+            PA_STREAM_REP( stream )->streamInfo.flags =
+                    ( PA_STREAM_REP( stream )->streamInfo.flags
+                        & ~(paStreamInfoInputPassThrough | paStreamInfoOutputPassThrough
+                            | paStreamInfoAlignedBuffers) )
+                    | PaUtil_GetBufferProcessorStreamInfoFlags( PA_STREAM_REP( stream )->bufferProcessor );
+        }
+
         result = &PA_STREAM_REP( stream )->streamInfo;
 
         PA_LOGAPI(("Pa_GetStreamInfo returned:\n" ));
@@ -1581,6 +1754,7 @@ const PaStreamInfo* Pa_GetStreamInfo( PaStream *stream )
         PA_LOGAPI(("\t\tPaTime inputLatency: %f\n", result->inputLatency ));
         PA_LOGAPI(("\t\tPaTime outputLatency: %f\n", result->outputLatency ));
         PA_LOGAPI(("\t\tdouble sampleRate: %f\n", result->sampleRate ));
+        PA_LOGAPI(("\t\tPaStreamInfoFlags flags: 0x%lx\n", result->flags ));
         PA_LOGAPI(("\t}\n" ));
 
     }
@@ -1589,6 +1763,88 @@ const PaStreamInfo* Pa_GetStreamInfo( PaStream *stream )
 }
 
 
+PaError Pa_GetStreamStatistics( PaStream *stream, PaStreamStatistics *statistics )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilBufferProcessor *bufferProcessor;
+    PaUtilCpuLoadMeasurer *cpuLoadMeasurer;
+    PaUtilCpuLoadStatistics timing;
+    PaUtilXrunCounts xruns;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_GetStreamStatistics" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tPaStreamStatistics* statistics: 0x%p\n", statistics ));
+
+    if( result == paNoError )
+    {
+        if( statistics == 0 )
+        {
+            result = paBadBufferPtr;
+        }
+        else
+        {
+            bufferProcessor = PA_STREAM_REP( stream )->bufferProcessor;
+            cpuLoadMeasurer = PA_STREAM_REP( stream )->cpuLoadMeasurer;
+
+            if( bufferProcessor )
+            {
+                PaUtil_ReadBufferProcessorClippedSampleCounts( bufferProcessor,
+                        &statistics->inputClippedSamples, &statistics->outputClippedSamples );
+            }
+            else
+            {
+                statistics->inputClippedSamples = 0;
+                statistics->outputClippedSamples = 0;
+            }
+
+            /* callers compiled against version 1 don't have the fields below */
+            if( statistics->structVersion < 2 )
+            {
+                statistics->structVersion = 1;
+            }
+            else
+            {
+                statistics->structVersion = 2;
+
+                if( cpuLoadMeasurer )
+                    PaUtil_ReadCpuLoadStatistics( cpuLoadMeasurer, &timing );
+                else
+                    memset( &timing, 0, sizeof(timing) );
+
+                statistics->callbackCount = timing.measurementCount;
+                statistics->medianCallbackDuration =
+                        PaUtil_GetCpuLoadHistogramPercentile( timing.durationHistogram, .5 );
+                statistics->callbackDuration99thPercentile =
+                        PaUtil_GetCpuLoadHistogramPercentile( timing.durationHistogram, .99 );
+                statistics->maxCallbackDuration =
+                        PaUtil_GetCpuLoadHistogramPercentile( timing.durationHistogram, 1. );
+                statistics->deadlineMisses = timing.deadlineMissCount;
+                statistics->medianWakeupJitter =
+                        PaUtil_GetCpuLoadHistogramPercentile( timing.jitterHistogram, .5 );
+                statistics->wakeupJitter99thPercentile =
+                        PaUtil_GetCpuLoadHistogramPercentile( timing.jitterHistogram, .99 );
+                statistics->maxWakeupJitter =
+                        PaUtil_GetCpuLoadHistogramPercentile( timing.jitterHistogram, 1. );
+
+                if( bufferProcessor )
+                    PaUtil_ReadBufferProcessorXrunCounts( bufferProcessor, &xruns );
+                else
+                    memset( &xruns, 0, sizeof(xruns) );
+
+                statistics->inputUnderflows = xruns.inputUnderflows;
+                statistics->inputOverflows = xruns.inputOverflows;
+                statistics->outputUnderflows = xruns.outputUnderflows;
+                statistics->outputOverflows = xruns.outputOverflows;
+            }
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_GetStreamStatistics", result );
+
+    return result;
+}
+
+
 PaTime Pa_GetStreamTime( PaStream *stream )
 {
     PaError error = PaUtil_ValidateStreamPointer( stream );
@@ -1727,6 +1983,112 @@ PaError Pa_WriteStream( PaStream* stream,
     return result;
 }
 
+PaError Pa_ReadStreamTimeout( PaStream* stream,
+                              void *buffer,
+                              unsigned long frames,
+                              PaTime timeout,
+                              unsigned long *framesRead )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    unsigned long count = 0;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_ReadStreamTimeout" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tPaTime timeout: %g\n", timeout ));
+
+    if( result == paNoError )
+    {
+        if( frames == 0 )
+        {
+            result = paNoError;
+        }
+        else if( buffer == 0 )
+        {
+            result = paBadBufferPtr;
+        }
+        else if( PA_STREAM_INTERFACE(stream)->ReadTimeout == 0 )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else
+        {
+            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            if( result == 0 )
+            {
+                if( timeout < 0. )
+                    timeout = 0.;
+
+                result = PA_STREAM_INTERFACE(stream)->ReadTimeout( stream, buffer, frames, timeout, &count );
+            }
+            else if( result == 1 )
+            {
+                result = paStreamIsStopped;
+            }
+        }
+    }
+
+    if( framesRead )
+        *framesRead = count;
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_ReadStreamTimeout", result );
+
+    return result;
+}
+
+
+PaError Pa_WriteStreamTimeout( PaStream* stream,
+                               const void *buffer,
+                               unsigned long frames,
+                               PaTime timeout,
+                               unsigned long *framesWritten )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    unsigned long count = 0;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_WriteStreamTimeout" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tPaTime timeout: %g\n", timeout ));
+
+    if( result == paNoError )
+    {
+        if( frames == 0 )
+        {
+            result = paNoError;
+        }
+        else if( buffer == 0 )
+        {
+            result = paBadBufferPtr;
+        }
+        else if( PA_STREAM_INTERFACE(stream)->WriteTimeout == 0 )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else
+        {
+            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            if( result == 0 )
+            {
+                if( timeout < 0. )
+                    timeout = 0.;
+
+                result = PA_STREAM_INTERFACE(stream)->WriteTimeout( stream, buffer, frames, timeout, &count );
+            }
+            else if( result == 1 )
+            {
+                result = paStreamIsStopped;
+            }
+        }
+    }
+
+    if( framesWritten )
+        *framesWritten = count;
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_WriteStreamTimeout", result );
+
+    return result;
+}
+
+
 signed long Pa_GetStreamReadAvailable( PaStream* stream )
 {
     PaError error = PaUtil_ValidateStreamPointer( stream );
@@ -1785,6 +2147,295 @@ signed long Pa_GetStreamWriteAvailable( PaStream* stream )
 }
 
 
+PaError Pa_GetStreamReadyFileDescriptor( PaStream* stream, unsigned long frames, int *fileDescriptor )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_GetStreamReadyFileDescriptor" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tunsigned long frames: %lu\n", frames ));
+    PA_LOGAPI(("\tint* fileDescriptor: 0x%p\n", fileDescriptor ));
+
+    if( result == paNoError )
+    {
+        if( fileDescriptor == 0 )
+        {
+            result = paBadBufferPtr;
+        }
+        else if( PA_STREAM_INTERFACE(stream)->GetReadyFileDescriptor == 0 )
+        {
+            /* only set in the blocking stream interfaces */
+            result = paIncompatibleStreamHostApi;
+        }
+        else
+        {
+            if( frames == 0 )
+                frames = 1;
+
+            result = PA_STREAM_INTERFACE(stream)->GetReadyFileDescriptor( stream, frames, fileDescriptor );
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_GetStreamReadyFileDescriptor", result );
+
+    return result;
+}
+
+
+static PaError AcquireWriteRegion( PaStream* stream, PaUtilAcquiredBuffer *acquired,
+        void **buffer, unsigned long *frames )
+{
+    PaUtilStreamInterface *interface = PA_STREAM_INTERFACE(stream);
+    PaError result = paIncompatibleStreamHostApi;
+    signed long available;
+
+    if( interface->AcquireWriteBuffer )
+        result = interface->AcquireWriteBuffer( stream, buffer, frames );
+
+    acquired->isBounced = ( result == paIncompatibleStreamHostApi );
+    if( acquired->isBounced )
+    {
+        available = interface->GetWriteAvailable( stream );
+        if( available < 0 )
+            return (PaError)available;
+
+        if( *frames > (unsigned long)available )
+            *frames = available;
+
+        result = ReserveBounceBuffer( acquired, *frames );
+        if( result != paNoError )
+            return result;
+
+        *buffer = *frames > 0 ? GetBounceBufferRegion( acquired, 0 ) : NULL;
+    }
+
+    if( result == paNoError )
+        acquired->acquiredFrames = *frames;
+
+    return result;
+}
+
+
+PaError Pa_AcquireWriteBuffer( PaStream* stream, void **buffer, unsigned long *frames, int *isZeroCopy )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilAcquiredBuffer *acquired;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_AcquireWriteBuffer" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tvoid** buffer: 0x%p\n", buffer ));
+    PA_LOGAPI(("\tunsigned long* frames: 0x%p\n", frames ));
+
+    if( result == paNoError )
+    {
+        acquired = &PA_STREAM_REP(stream)->acquiredWriteBuffer;
+
+        if( buffer == 0 || frames == 0 || acquired->acquiredFrames > 0 )
+        {
+            result = paBadBufferPtr;
+        }
+        else if( acquired->channelCount == 0 )
+        {
+            result = paCanNotWriteToAnInputOnlyStream;
+        }
+        else
+        {
+            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            if( result == 0 )
+            {
+                if( *frames > 0 )
+                    result = AcquireWriteRegion( stream, acquired, buffer, frames );
+
+                if( result != paNoError )
+                    *frames = 0;
+                if( isZeroCopy )
+                    *isZeroCopy = !acquired->isBounced;
+            }
+            else if( result == 1 )
+            {
+                result = paStreamIsStopped;
+            }
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_AcquireWriteBuffer", result );
+
+    return result;
+}
+
+
+PaError Pa_CommitWriteBuffer( PaStream* stream, unsigned long frames )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilAcquiredBuffer *acquired;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_CommitWriteBuffer" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tunsigned long frames: %lu\n", frames ));
+
+    if( result == paNoError )
+    {
+        acquired = &PA_STREAM_REP(stream)->acquiredWriteBuffer;
+
+        if( frames > acquired->acquiredFrames )
+        {
+            result = paBufferTooBig;
+        }
+        else if( acquired->acquiredFrames > 0 )
+        {
+            if( !acquired->isBounced )
+                result = PA_STREAM_INTERFACE(stream)->CommitWriteBuffer( stream, frames );
+            else if( frames > 0 )
+                result = PA_STREAM_INTERFACE(stream)->Write( stream, GetBounceBufferRegion( acquired, 0 ), frames );
+
+            acquired->acquiredFrames = 0;
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_CommitWriteBuffer", result );
+
+    return result;
+}
+
+
+static PaError AcquireReadRegion( PaStream* stream, PaUtilAcquiredBuffer *acquired,
+        const void **buffer, unsigned long *frames )
+{
+    PaUtilStreamInterface *interface = PA_STREAM_INTERFACE(stream);
+    PaError result = paIncompatibleStreamHostApi;
+    signed long available;
+    unsigned long framesToRead;
+
+    /* input which is left in the bounce buffer comes first */
+    if( interface->AcquireReadBuffer && acquired->bounceFrames == 0 )
+        result = interface->AcquireReadBuffer( stream, buffer, frames );
+
+    acquired->isBounced = ( result == paIncompatibleStreamHostApi );
+    if( acquired->isBounced )
+    {
+        result = paNoError;
+
+        if( acquired->bounceFrames == 0 )
+        {
+            available = interface->GetReadAvailable( stream );
+            if( available < 0 )
+                return (PaError)available;
+
+            framesToRead = *frames < (unsigned long)available ? *frames : (unsigned long)available;
+            if( framesToRead > 0 )
+            {
+                result = ReserveBounceBuffer( acquired, framesToRead );
+                if( result != paNoError )
+                    return result;
+
+                result = interface->Read( stream, GetBounceBufferRegion( acquired, 0 ), framesToRead );
+                if( result != paNoError && result != paInputOverflowed )
+                    return result;
+
+                acquired->bounceOffset = 0;
+                acquired->bounceFrames = framesToRead;
+            }
+        }
+
+        if( *frames > acquired->bounceFrames )
+            *frames = acquired->bounceFrames;
+        *buffer = *frames > 0 ? GetBounceBufferRegion( acquired, acquired->bounceOffset ) : NULL;
+    }
+
+    if( result == paNoError || result == paInputOverflowed )
+        acquired->acquiredFrames = *frames;
+
+    return result;
+}
+
+
+PaError Pa_AcquireReadBuffer( PaStream* stream, const void **buffer, unsigned long *frames, int *isZeroCopy )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilAcquiredBuffer *acquired;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_AcquireReadBuffer" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tconst void** buffer: 0x%p\n", buffer ));
+    PA_LOGAPI(("\tunsigned long* frames: 0x%p\n", frames ));
+
+    if( result == paNoError )
+    {
+        acquired = &PA_STREAM_REP(stream)->acquiredReadBuffer;
+
+        if( buffer == 0 || frames == 0 || acquired->acquiredFrames > 0 )
+        {
+            result = paBadBufferPtr;
+        }
+        else if( acquired->channelCount == 0 )
+        {
+            result = paCanNotReadFromAnOutputOnlyStream;
+        }
+        else
+        {
+            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            if( result == 0 )
+            {
+                if( *frames > 0 )
+                    result = AcquireReadRegion( stream, acquired, buffer, frames );
+
+                if( result != paNoError && result != paInputOverflowed )
+                    *frames = 0;
+                if( isZeroCopy )
+                    *isZeroCopy = !acquired->isBounced;
+            }
+            else if( result == 1 )
+            {
+                result = paStreamIsStopped;
+            }
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_AcquireReadBuffer", result );
+
+    return result;
+}
+
+
+PaError Pa_ReleaseReadBuffer( PaStream* stream, unsigned long frames )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilAcquiredBuffer *acquired;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_ReleaseReadBuffer" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tunsigned long frames: %lu\n", frames ));
+
+    if( result == paNoError )
+    {
+        acquired = &PA_STREAM_REP(stream)->acquiredReadBuffer;
+
+        if( frames > acquired->acquiredFrames )
+        {
+            result = paBufferTooBig;
+        }
+        else if( acquired->acquiredFrames > 0 )
+        {
+            if( !acquired->isBounced )
+            {
+                result = PA_STREAM_INTERFACE(stream)->ReleaseReadBuffer( stream, frames );
+            }
+            else
+            {
+                acquired->bounceOffset += frames;
+                acquired->bounceFrames -= frames;
+            }
+
+            acquired->acquiredFrames = 0;
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_ReleaseReadBuffer", result );
+
+    return result;
+}
+
+
 PaError Pa_GetSampleSize( PaSampleFormat format )
 {
     int result;
@@ -1810,9 +2461,14 @@ PaError Pa_GetSampleSize( PaSampleFormat format )
 
     case paFloat32:
     case paInt32:
+    case paInt24In32:
         result = 4;
         break;
 
+    case paFloat64:
+        result = 8;
+        break;
+
     default:
         result = paSampleFormatNotSupported;
         break;
@@ -1822,3 +2478,263 @@ PaError Pa_GetSampleSize( PaSampleFormat format )
 
     return (PaError) result;
 }
+
+
+PaError Pa_RegisterConverter( PaSampleFormat sourceFormat, PaSampleFormat destinationFormat,
+        PaStreamFlags flags, PaSampleConverter *converter )
+{
+    PaError result;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_RegisterConverter" );
+    PA_LOGAPI(("\tPaSampleFormat sourceFormat: %d\n", sourceFormat ));
+    PA_LOGAPI(("\tPaSampleFormat destinationFormat: %d\n", destinationFormat ));
+    PA_LOGAPI(("\tPaStreamFlags flags: 0x%x\n", flags ));
+    PA_LOGAPI(("\tPaSampleConverter* converter: 0x%p\n", converter ));
+
+    if( Pa_GetSampleSize( sourceFormat ) < 0 || Pa_GetSampleSize( destinationFormat ) < 0 )
+        result = paSampleFormatNotSupported;
+    else if( flags & ~(paClipOff | paDitherOff | paNoiseShapedDither) )
+        result = paInvalidFlag;
+    else
+        result = PaUtil_RegisterConverter( sourceFormat, destinationFormat, flags, converter );
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_RegisterConverter", result );
+
+    return result;
+}
+
+
+PaError Pa_SetStreamConverters( PaStream *stream,
+        PaSampleConverter *inputConverter, PaSampleConverter *outputConverter )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilBufferProcessor *bufferProcessor;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetStreamConverters" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tPaSampleConverter* inputConverter: 0x%p\n", inputConverter ));
+    PA_LOGAPI(("\tPaSampleConverter* outputConverter: 0x%p\n", outputConverter ));
+
+    if( result == paNoError )
+    {
+        bufferProcessor = PA_STREAM_REP( stream )->bufferProcessor;
+
+        if( bufferProcessor == 0 )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else if( PA_STREAM_REP( stream )->streamInfo.flags & paStreamInfoSampleRateConverted )
+        {
+            /* the buffer processor converts to paFloat32, not the user formats */
+            result = paInvalidFlag;
+        }
+        else
+        {
+            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            if( result == 0 )
+            {
+                result = paStreamIsNotStopped;
+            }
+            else if( result == 1 )
+            {
+                PaUtil_SetBufferProcessorConverters( bufferProcessor, inputConverter, outputConverter );
+                result = paNoError;
+            }
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetStreamConverters", result );
+
+    return result;
+}
+
+
+PaError Pa_SetStreamChannelGroupCallback( PaStream *stream,
+        PaStreamChannelGroupCallback *groupCallback, int channelsPerGroup,
+        unsigned int threadCount )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilBufferProcessor *bufferProcessor;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetStreamChannelGroupCallback" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tPaStreamChannelGroupCallback* groupCallback: 0x%p\n", groupCallback ));
+    PA_LOGAPI(("\tint channelsPerGroup: %d\n", channelsPerGroup ));
+    PA_LOGAPI(("\tunsigned int threadCount: %u\n", threadCount ));
+
+    if( result == paNoError )
+    {
+        bufferProcessor = PA_STREAM_REP( stream )->bufferProcessor;
+
+        if( bufferProcessor == 0 )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else if( PA_STREAM_REP( stream )->streamCallback == 0 )
+        {
+            result = paNullCallback;
+        }
+        else if( groupCallback != 0 )
+        {
+            /* a pipelined stream calls its callback from the pipeline, and a
+                converted one from the resampling stage, not from the buffer
+                processor */
+            if( PA_STREAM_REP( stream )->streamInfo.flags
+                    & (paStreamInfoPipelinedCallback | paStreamInfoSampleRateConverted) )
+                result = paInvalidFlag;
+            else if( ( bufferProcessor->inputChannelCount > 0 && bufferProcessor->userInputIsInterleaved )
+                    || ( bufferProcessor->outputChannelCount > 0 && bufferProcessor->userOutputIsInterleaved ) )
+                result = paSampleFormatNotSupported;
+            else if( channelsPerGroup < 1 )
+                result = paInvalidChannelCount;
+        }
+
+        if( result == paNoError )
+        {
+            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            if( result == 0 )
+            {
+                result = paStreamIsNotStopped;
+            }
+            else if( result == 1 )
+            {
+                result = PaUtil_SetBufferProcessorChannelGroupCallback( bufferProcessor,
+                        groupCallback, groupCallback ? (unsigned int)channelsPerGroup : 0, threadCount );
+            }
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetStreamChannelGroupCallback", result );
+
+    return result;
+}
+
+
+PaError Pa_SetStreamOutputChannelMatrix( PaStream *stream,
+        int userChannelCount, const float *matrix )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilBufferProcessor *bufferProcessor;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetStreamOutputChannelMatrix" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tint userChannelCount: %d\n", userChannelCount ));
+    PA_LOGAPI(("\tconst float* matrix: 0x%p\n", matrix ));
+
+    if( result == paNoError )
+    {
+        bufferProcessor = PA_STREAM_REP( stream )->bufferProcessor;
+
+        if( bufferProcessor == 0 )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else if( PA_STREAM_REP( stream )->streamCallback == 0 )
+        {
+            result = paNullCallback;
+        }
+        else if( PA_STREAM_REP( stream )->streamInfo.flags
+                & (paStreamInfoPipelinedCallback | paStreamInfoSampleRateConverted) )
+        {
+            /* the pipeline and the resampling stage hold buffers of the
+                stream's channel count */
+            result = paInvalidFlag;
+        }
+        else if( bufferProcessor->outputChannelCount == 0
+                || ( matrix != 0 && userChannelCount < 1 ) )
+        {
+            result = paInvalidChannelCount;
+        }
+
+        if( result == paNoError )
+        {
+            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            if( result == 0 )
+            {
+                result = paStreamIsNotStopped;
+            }
+            else if( result == 1 )
+            {
+                result = PaUtil_SetBufferProcessorOutputChannelMatrix( bufferProcessor,
+                        matrix ? (unsigned int)userChannelCount : 0, matrix );
+            }
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetStreamOutputChannelMatrix", result );
+
+    return result;
+}
+
+
+PaError Pa_SetStreamGain( PaStream *stream, float gain, unsigned long rampFrames )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilBufferProcessor *bufferProcessor;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetStreamGain" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tfloat gain: %g\n", gain ));
+    PA_LOGAPI(("\tunsigned long rampFrames: %lu\n", rampFrames ));
+
+    if( result == paNoError )
+    {
+        bufferProcessor = PA_STREAM_REP( stream )->bufferProcessor;
+
+        if( bufferProcessor == 0 )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else if( bufferProcessor->outputChannelCount == 0 )
+        {
+            result = paInvalidChannelCount;
+        }
+        else
+        {
+            result = PaUtil_SetBufferProcessorOutputGain( bufferProcessor, gain, rampFrames );
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetStreamGain", result );
+
+    return result;
+}
+
+
+PaError Pa_SetStreamFades( PaStream *stream, unsigned long fadeInFrames, unsigned long fadeOutFrames )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilBufferProcessor *bufferProcessor;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetStreamFades" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tunsigned long fadeInFrames: %lu\n", fadeInFrames ));
+    PA_LOGAPI(("\tunsigned long fadeOutFrames: %lu\n", fadeOutFrames ));
+
+    if( result == paNoError )
+    {
+        bufferProcessor = PA_STREAM_REP( stream )->bufferProcessor;
+
+        if( bufferProcessor == 0 )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else if( bufferProcessor->outputChannelCount == 0 )
+        {
+            result = paInvalidChannelCount;
+        }
+        else if( !bufferProcessor->userOutputIsFloat32
+                && ( !bufferProcessor->outputGainSourceConverter || !bufferProcessor->outputGainConverter ) )
+        {
+            result = paSampleFormatNotSupported;
+        }
+        else
+        {
+            PaUtil_SetBufferProcessorOutputFades( bufferProcessor, fadeInFrames, fadeOutFrames );
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetStreamFades", result );
+
+    return result;
+}
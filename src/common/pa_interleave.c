@@ -0,0 +1,513 @@
+/*
+ * $Id$
+ * Portable Audio I/O Library sample conversion mechanism
+ * Block transposition converters for multichannel buffers
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief Block transposition converters for multichannel buffers.
+
+ The transposers move tiles of four frames by up to eight channels between
+ an interleaved buffer and per channel rows. Each source frame of a tile is
+ read once, and every row receives four adjacent samples, so both sides are
+ accessed a cache line at a time. The conversion itself is done on the rows
+ with unit stride, which also lets the SIMD converters run at full speed.
+
+ PaUtil_ConvertChannels() converts whole arrays of channel descriptors and
+ picks the cheapest way to do it for the buffer layouts it is given.
+*/
+
+#include <assert.h>
+
+#include "pa_interleave.h"
+#include "pa_types.h"
+
+
+#define PA_MIN_( a, b ) ( ((a)<(b)) ? (a) : (b) )
+
+/* frames per tile, the tile width is the channel count */
+#define PA_INTERLEAVE_TILE_FRAMES_     (4)
+
+/* PaUtil_ConvertChannels() converts all channels of this many bytes of
+    source and destination samples before moving to the next frames */
+#define PA_CONVERT_TILE_BYTES_         (262144)
+
+
+/*
+    A transposer copies frameCount frames between the interleaved buffer
+    and channelCount rows. rows[i] points to the first sample of channel i.
+*/
+typedef void PaUtilTransposer(
+        void *interleaved, unsigned int frameStride, void **rows,
+        unsigned int channelCount, unsigned int frameCount );
+
+/* -------------------------------------------------------------------------- */
+
+#define PA_DEFINE_TRANSPOSERS_( suffix, type )                                      \
+static void Deinterleave_##suffix( void *interleaved, unsigned int frameStride,     \
+        void **rows, unsigned int channelCount, unsigned int frameCount )           \
+{                                                                                   \
+    const type *src = (const type*)interleaved;                                     \
+    unsigned int i, frame = 0;                                                      \
+                                                                                    \
+    for( ; frame + PA_INTERLEAVE_TILE_FRAMES_ <= frameCount;                        \
+            frame += PA_INTERLEAVE_TILE_FRAMES_ )                                   \
+    {                                                                               \
+        const type *src0 = src + frame * frameStride;                               \
+        const type *src1 = src0 + frameStride;                                      \
+        const type *src2 = src1 + frameStride;                                      \
+        const type *src3 = src2 + frameStride;                                      \
+                                                                                    \
+        for( i=0; i<channelCount; ++i )                                             \
+        {                                                                           \
+            type *dest = (type*)rows[i] + frame;                                    \
+            dest[0] = src0[i];                                                      \
+            dest[1] = src1[i];                                                      \
+            dest[2] = src2[i];                                                      \
+            dest[3] = src3[i];                                                      \
+        }                                                                           \
+    }                                                                               \
+                                                                                    \
+    for( ; frame < frameCount; ++frame )                                            \
+    {                                                                               \
+        for( i=0; i<channelCount; ++i )                                             \
+            ((type*)rows[i])[frame] = src[frame * frameStride + i];                 \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static void Interleave_##suffix( void *interleaved, unsigned int frameStride,       \
+        void **rows, unsigned int channelCount, unsigned int frameCount )           \
+{                                                                                   \
+    type *dest = (type*)interleaved;                                                \
+    unsigned int i, frame = 0;                                                      \
+                                                                                    \
+    for( ; frame + PA_INTERLEAVE_TILE_FRAMES_ <= frameCount;                        \
+            frame += PA_INTERLEAVE_TILE_FRAMES_ )                                   \
+    {                                                                               \
+        type *dest0 = dest + frame * frameStride;                                   \
+        type *dest1 = dest0 + frameStride;                                          \
+        type *dest2 = dest1 + frameStride;                                          \
+        type *dest3 = dest2 + frameStride;                                          \
+                                                                                    \
+        for( i=0; i<channelCount; ++i )                                             \
+        {                                                                           \
+            const type *src = (const type*)rows[i] + frame;                         \
+            dest0[i] = src[0];                                                      \
+            dest1[i] = src[1];                                                      \
+            dest2[i] = src[2];                                                      \
+            dest3[i] = src[3];                                                      \
+        }                                                                           \
+    }                                                                               \
+                                                                                    \
+    for( ; frame < frameCount; ++frame )                                            \
+    {                                                                               \
+        for( i=0; i<channelCount; ++i )                                             \
+            dest[frame * frameStride + i] = ((const type*)rows[i])[frame];          \
+    }                                                                               \
+}
+
+/* 64 bit samples are moved as a pair of 32 bit words, see Copy_64_To_64() */
+typedef struct{ PaUint32 words[2]; } PaUtilSample64;
+
+PA_DEFINE_TRANSPOSERS_( 8, unsigned char )
+PA_DEFINE_TRANSPOSERS_( 16, PaUint16 )
+PA_DEFINE_TRANSPOSERS_( 32, PaUint32 )
+PA_DEFINE_TRANSPOSERS_( 64, PaUtilSample64 )
+
+/* -------------------------------------------------------------------------- */
+
+static void Deinterleave_24( void *interleaved, unsigned int frameStride,
+        void **rows, unsigned int channelCount, unsigned int frameCount )
+{
+    const unsigned char *src = (const unsigned char*)interleaved;
+    unsigned int i, frame;
+
+    for( frame=0; frame<frameCount; ++frame )
+    {
+        for( i=0; i<channelCount; ++i )
+        {
+            unsigned char *dest = (unsigned char*)rows[i] + frame * 3;
+            dest[0] = src[i * 3];
+            dest[1] = src[i * 3 + 1];
+            dest[2] = src[i * 3 + 2];
+        }
+
+        src += frameStride * 3;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Interleave_24( void *interleaved, unsigned int frameStride,
+        void **rows, unsigned int channelCount, unsigned int frameCount )
+{
+    unsigned char *dest = (unsigned char*)interleaved;
+    unsigned int i, frame;
+
+    for( frame=0; frame<frameCount; ++frame )
+    {
+        for( i=0; i<channelCount; ++i )
+        {
+            const unsigned char *src = (const unsigned char*)rows[i] + frame * 3;
+            dest[i * 3] = src[0];
+            dest[i * 3 + 1] = src[1];
+            dest[i * 3 + 2] = src[2];
+        }
+
+        dest += frameStride * 3;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static PaUtilTransposer* SelectDeinterleaver( unsigned int bytesPerSample )
+{
+    switch( bytesPerSample )
+    {
+    case 1: return Deinterleave_8;
+    case 2: return Deinterleave_16;
+    case 3: return Deinterleave_24;
+    case 8: return Deinterleave_64;
+    default: assert( bytesPerSample == 4 ); return Deinterleave_32;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static PaUtilTransposer* SelectInterleaver( unsigned int bytesPerSample )
+{
+    switch( bytesPerSample )
+    {
+    case 1: return Interleave_8;
+    case 2: return Interleave_16;
+    case 3: return Interleave_24;
+    case 8: return Interleave_64;
+    default: assert( bytesPerSample == 4 ); return Interleave_32;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PaUtil_DeinterleaveAndConvert( PaUtilConverter *converter,
+        void **destinationChannels, unsigned int bytesPerDestinationSample,
+        void *source, unsigned int sourceFrameStride, unsigned int bytesPerSourceSample,
+        unsigned int channelCount, unsigned int frameCount,
+        struct PaSampleConverterState *ditherGenerator )
+{
+    PaUtilSample64 scratch[ PA_UTIL_MAX_INTERLEAVE_CHANNELS * PA_UTIL_INTERLEAVE_BLOCK_FRAMES ];
+    void *rows[ PA_UTIL_MAX_INTERLEAVE_CHANNELS ];
+    PaUtilTransposer *deinterleave = SelectDeinterleaver( bytesPerSourceSample );
+    unsigned char *src = (unsigned char*)source;
+    unsigned int i, frame, framesInBlock;
+
+    assert( channelCount <= PA_UTIL_MAX_INTERLEAVE_CHANNELS );
+
+    if( !converter )
+    {
+        assert( bytesPerDestinationSample == bytesPerSourceSample );
+        deinterleave( source, sourceFrameStride, destinationChannels, channelCount, frameCount );
+        return;
+    }
+
+    for( i=0; i<channelCount; ++i )
+        rows[i] = (unsigned char*)scratch + i * bytesPerSourceSample * PA_UTIL_INTERLEAVE_BLOCK_FRAMES;
+
+    for( frame=0; frame<frameCount; frame += framesInBlock )
+    {
+        framesInBlock = PA_MIN_( PA_UTIL_INTERLEAVE_BLOCK_FRAMES, frameCount - frame );
+
+        deinterleave( src + frame * sourceFrameStride * bytesPerSourceSample, sourceFrameStride,
+                rows, channelCount, framesInBlock );
+
+        for( i=0; i<channelCount; ++i )
+        {
+            converter( (unsigned char*)destinationChannels[i] + frame * bytesPerDestinationSample, 1,
+                    rows[i], 1, framesInBlock, ditherGenerator );
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PaUtil_ConvertAndInterleave( PaUtilConverter *converter,
+        void *destination, unsigned int destinationFrameStride, unsigned int bytesPerDestinationSample,
+        void **sourceChannels, unsigned int bytesPerSourceSample,
+        unsigned int channelCount, unsigned int frameCount,
+        struct PaSampleConverterState *ditherGenerator )
+{
+    PaUtilSample64 scratch[ PA_UTIL_MAX_INTERLEAVE_CHANNELS * PA_UTIL_INTERLEAVE_BLOCK_FRAMES ];
+    void *rows[ PA_UTIL_MAX_INTERLEAVE_CHANNELS ];
+    PaUtilTransposer *interleave = SelectInterleaver( bytesPerDestinationSample );
+    unsigned char *dest = (unsigned char*)destination;
+    unsigned int i, frame, framesInBlock;
+
+    assert( channelCount <= PA_UTIL_MAX_INTERLEAVE_CHANNELS );
+
+    if( !converter )
+    {
+        assert( bytesPerDestinationSample == bytesPerSourceSample );
+        interleave( destination, destinationFrameStride, sourceChannels, channelCount, frameCount );
+        return;
+    }
+
+    for( i=0; i<channelCount; ++i )
+        rows[i] = (unsigned char*)scratch + i * bytesPerDestinationSample * PA_UTIL_INTERLEAVE_BLOCK_FRAMES;
+
+    for( frame=0; frame<frameCount; frame += framesInBlock )
+    {
+        framesInBlock = PA_MIN_( PA_UTIL_INTERLEAVE_BLOCK_FRAMES, frameCount - frame );
+
+        for( i=0; i<channelCount; ++i )
+        {
+            converter( rows[i], 1, (unsigned char*)sourceChannels[i] + frame * bytesPerSourceSample, 1,
+                    framesInBlock, ditherGenerator );
+        }
+
+        interleave( dest + frame * destinationFrameStride * bytesPerDestinationSample, destinationFrameStride,
+                rows, channelCount, framesInBlock );
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*
+    ChannelsAreInterleaved() returns non-zero if the channel descriptors
+    describe consecutive channels of a single interleaved buffer.
+*/
+static int ChannelsAreInterleaved( PaUtilChannelDescriptor *channels,
+        unsigned int channelCount, unsigned int bytesPerSample )
+{
+    unsigned int i;
+
+    if( channels[0].stride < channelCount )
+        return 0;
+
+    for( i=1; i<channelCount; ++i )
+    {
+        if( channels[i].stride != channels[0].stride ||
+                channels[i].data != ((unsigned char*)channels[0].data) + i * bytesPerSample )
+            return 0;
+    }
+
+    return 1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*
+    ChannelsAreNonInterleaved() returns non-zero if every channel descriptor
+    has unit stride.
+*/
+static int ChannelsAreNonInterleaved( PaUtilChannelDescriptor *channels,
+        unsigned int channelCount )
+{
+    unsigned int i;
+
+    for( i=0; i<channelCount; ++i )
+    {
+        if( channels[i].stride != 1 )
+            return 0;
+    }
+
+    return 1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static PaUtilConverter* SelectCopier( unsigned int bytesPerSample )
+{
+    switch( bytesPerSample )
+    {
+    case 1: return paConverters.Copy_8_To_8;
+    case 2: return paConverters.Copy_16_To_16;
+    case 3: return paConverters.Copy_24_To_24;
+    case 8: return paConverters.Copy_64_To_64;
+    default: assert( bytesPerSample == 4 ); return paConverters.Copy_32_To_32;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void DeinterleaveChannels( PaUtilConverter *converter,
+        PaUtilChannelDescriptor *destinationChannels, unsigned int bytesPerDestinationSample,
+        PaUtilChannelDescriptor *sourceChannels, unsigned int bytesPerSourceSample,
+        unsigned int channelCount, unsigned int frameCount,
+        struct PaSampleConverterState *ditherGenerator )
+{
+    void *channelPtrs[ PA_UTIL_MAX_INTERLEAVE_CHANNELS ];
+    unsigned int frameStride = sourceChannels[0].stride;
+    unsigned int i, j, channelsInGroup, frame, framesInBlock;
+
+    for( frame=0; frame<frameCount; frame += framesInBlock )
+    {
+        framesInBlock = PA_MIN_( PA_UTIL_INTERLEAVE_BLOCK_FRAMES, frameCount - frame );
+
+        for( i=0; i<channelCount; i += channelsInGroup )
+        {
+            channelsInGroup = PA_MIN_( PA_UTIL_MAX_INTERLEAVE_CHANNELS, channelCount - i );
+
+            for( j=0; j<channelsInGroup; ++j )
+            {
+                channelPtrs[j] = ((unsigned char*)destinationChannels[i + j].data) +
+                        frame * bytesPerDestinationSample;
+            }
+
+            PaUtil_DeinterleaveAndConvert( converter, channelPtrs, bytesPerDestinationSample,
+                    ((unsigned char*)sourceChannels[i].data) + frame * frameStride * bytesPerSourceSample,
+                    frameStride, bytesPerSourceSample, channelsInGroup, framesInBlock, ditherGenerator );
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void InterleaveChannels( PaUtilConverter *converter,
+        PaUtilChannelDescriptor *destinationChannels, unsigned int bytesPerDestinationSample,
+        PaUtilChannelDescriptor *sourceChannels, unsigned int bytesPerSourceSample,
+        unsigned int channelCount, unsigned int frameCount,
+        struct PaSampleConverterState *ditherGenerator )
+{
+    void *channelPtrs[ PA_UTIL_MAX_INTERLEAVE_CHANNELS ];
+    unsigned int frameStride = destinationChannels[0].stride;
+    unsigned int i, j, channelsInGroup, frame, framesInBlock;
+
+    for( frame=0; frame<frameCount; frame += framesInBlock )
+    {
+        framesInBlock = PA_MIN_( PA_UTIL_INTERLEAVE_BLOCK_FRAMES, frameCount - frame );
+
+        for( i=0; i<channelCount; i += channelsInGroup )
+        {
+            channelsInGroup = PA_MIN_( PA_UTIL_MAX_INTERLEAVE_CHANNELS, channelCount - i );
+
+            for( j=0; j<channelsInGroup; ++j )
+            {
+                channelPtrs[j] = ((unsigned char*)sourceChannels[i + j].data) +
+                        frame * bytesPerSourceSample;
+            }
+
+            PaUtil_ConvertAndInterleave( converter,
+                    ((unsigned char*)destinationChannels[i].data) + frame * frameStride * bytesPerDestinationSample,
+                    frameStride, bytesPerDestinationSample,
+                    channelPtrs, bytesPerSourceSample, channelsInGroup, framesInBlock, ditherGenerator );
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PaUtil_ConvertChannels( PaUtilConverter *converter,
+        PaUtilChannelDescriptor *destinationChannels, unsigned int bytesPerDestinationSample,
+        PaUtilChannelDescriptor *sourceChannels, unsigned int bytesPerSourceSample,
+        unsigned int channelCount, unsigned int frameCount,
+        struct PaSampleConverterState *ditherGenerator )
+{
+    PaUtilConverter *channelConverter = converter ? converter : SelectCopier( bytesPerSourceSample );
+    int dithers = PaUtil_ConverterDithers( converter );
+    int destinationIsInterleaved, sourceIsInterleaved;
+    unsigned int i, frame, framesInTile;
+
+    if( channelCount == 0 || frameCount == 0 )
+        return;
+
+    destinationIsInterleaved = ChannelsAreInterleaved( destinationChannels, channelCount, bytesPerDestinationSample );
+    sourceIsInterleaved = ChannelsAreInterleaved( sourceChannels, channelCount, bytesPerSourceSample );
+
+    /* a dithering converter must see the frames of each channel in turn, so
+        that the high-passed dither of consecutive samples of a channel comes
+        from consecutive steps of the generator */
+
+    if( !dithers && destinationIsInterleaved && destinationChannels[0].stride == channelCount
+            && sourceIsInterleaved && sourceChannels[0].stride == channelCount )
+    {
+        /* both buffers contain exactly these channels, convert them as one */
+        channelConverter( destinationChannels[0].data, 1, sourceChannels[0].data, 1,
+                frameCount * channelCount, ditherGenerator );
+        return;
+    }
+
+    /* transposing in blocks only pays for itself when there is nothing else
+        to do. when samples are converted, the tiles below keep the strided
+        side in the cache just as well without the extra pass */
+
+    if( !converter && channelCount >= PA_UTIL_MIN_BLOCK_INTERLEAVE_CHANNELS )
+    {
+        if( sourceIsInterleaved && ChannelsAreNonInterleaved( destinationChannels, channelCount ) )
+        {
+            DeinterleaveChannels( converter, destinationChannels, bytesPerDestinationSample,
+                    sourceChannels, bytesPerSourceSample, channelCount, frameCount, ditherGenerator );
+            return;
+        }
+        else if( destinationIsInterleaved && ChannelsAreNonInterleaved( sourceChannels, channelCount ) )
+        {
+            InterleaveChannels( converter, destinationChannels, bytesPerDestinationSample,
+                    sourceChannels, bytesPerSourceSample, channelCount, frameCount, ditherGenerator );
+            return;
+        }
+    }
+
+    /* convert each channel separately. unless every channel is contiguous
+        this is done a tile of frames at a time, so that all channels are
+        converted while the tile is in the cache */
+
+    framesInTile = frameCount;
+    if( !dithers && ( !ChannelsAreNonInterleaved( destinationChannels, channelCount )
+            || !ChannelsAreNonInterleaved( sourceChannels, channelCount ) ) )
+    {
+        framesInTile = PA_CONVERT_TILE_BYTES_ /
+                (channelCount * (bytesPerDestinationSample + bytesPerSourceSample));
+        if( framesInTile < PA_UTIL_INTERLEAVE_BLOCK_FRAMES )
+            framesInTile = PA_UTIL_INTERLEAVE_BLOCK_FRAMES;
+    }
+
+    for( frame=0; frame<frameCount; frame += framesInTile )
+    {
+        unsigned int framesToConvert = PA_MIN_( framesInTile, frameCount - frame );
+
+        for( i=0; i<channelCount; ++i )
+        {
+            channelConverter(
+                    ((unsigned char*)destinationChannels[i].data) +
+                            frame * destinationChannels[i].stride * bytesPerDestinationSample,
+                    destinationChannels[i].stride,
+                    ((unsigned char*)sourceChannels[i].data) +
+                            frame * sourceChannels[i].stride * bytesPerSourceSample,
+                    sourceChannels[i].stride,
+                    framesToConvert, ditherGenerator );
+        }
+    }
+}
@@ -0,0 +1,160 @@
+#ifndef PA_INTERLEAVE_H
+#define PA_INTERLEAVE_H
+/*
+ * $Id$
+ * Portable Audio I/O Library sample conversion mechanism
+ * Block transposition converters for multichannel buffers
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief Converters which interleave or deinterleave a group of channels
+ while converting them.
+
+ Converting an interleaved buffer one channel at a time walks the whole
+ buffer once per channel with a stride of channelCount samples, which
+ makes poor use of the cache once there are more than a handful of
+ channels. The functions declared here transpose a block of frames for a
+ group of channels through a small scratch buffer, so that every cache line
+ of the interleaved buffer is touched once, and then convert each channel
+ with unit stride.
+*/
+
+
+#include "pa_converters.h"
+#include "pa_process.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+/** The maximum number of channels which may be passed to
+ PaUtil_DeinterleaveAndConvert() and PaUtil_ConvertAndInterleave().
+ Callers with more channels process them in groups of this size.
+*/
+#define PA_UTIL_MAX_INTERLEAVE_CHANNELS     (8)
+
+
+/** PaUtil_ConvertChannels() only copies between interleaved and
+ non-interleaved buffers in blocks when there are at least this many
+ channels. Below that converting one channel at
+ a time is as fast.
+*/
+#define PA_UTIL_MIN_BLOCK_INTERLEAVE_CHANNELS   (8)
+
+
+/** The number of frames which are transposed at a time. Callers processing
+ several channel groups should iterate over all groups for one block of
+ this many frames before moving to the next block, so the interleaved
+ buffer stays in the cache.
+*/
+#define PA_UTIL_INTERLEAVE_BLOCK_FRAMES     (64)
+
+
+/** Convert frameCount frames from an interleaved source buffer into separate
+ channel buffers.
+
+ @param converter The converter used for each channel, or NULL if the source
+ and destination formats are equal, in which case the samples are only
+ deinterleaved. bytesPerDestinationSample must then equal
+ bytesPerSourceSample.
+
+ @param destinationChannels An array of channelCount pointers to the
+ destination channels, each of which is written with unit stride.
+
+ @param source Points to the first sample of the first channel.
+
+ @param sourceFrameStride The number of samples from one frame to the next
+ in the source buffer, at least channelCount.
+
+ @param channelCount The number of channels, at most
+ PA_UTIL_MAX_INTERLEAVE_CHANNELS.
+
+ Sample sizes of 1, 2, 3, 4 and 8 bytes are supported. The dither generator is
+ consumed frame by frame across the channels, which spoils the high-passed
+ dither of the dithering converters, so only pass converters for which
+ PaUtil_ConverterDithers() returns 0.
+*/
+void PaUtil_DeinterleaveAndConvert( PaUtilConverter *converter,
+        void **destinationChannels, unsigned int bytesPerDestinationSample,
+        void *source, unsigned int sourceFrameStride, unsigned int bytesPerSourceSample,
+        unsigned int channelCount, unsigned int frameCount,
+        struct PaSampleConverterState *ditherGenerator );
+
+
+/** Convert frameCount frames from separate channel buffers into an
+ interleaved destination buffer. The parameters mirror those of
+ PaUtil_DeinterleaveAndConvert(). Samples of the destination buffer
+ belonging to other channels (when destinationFrameStride is greater than
+ channelCount) are not written.
+*/
+void PaUtil_ConvertAndInterleave( PaUtilConverter *converter,
+        void *destination, unsigned int destinationFrameStride, unsigned int bytesPerDestinationSample,
+        void **sourceChannels, unsigned int bytesPerSourceSample,
+        unsigned int channelCount, unsigned int frameCount,
+        struct PaSampleConverterState *ditherGenerator );
+
+
+/** Convert frameCount frames of channelCount channels, each described by a
+ PaUtilChannelDescriptor, in a single call. The descriptors are not modified.
+
+ @param converter The converter for each channel, or NULL if the source and
+ destination formats are equal and the samples only need to be copied.
+
+ Depending on the buffer layouts this converts interleaved buffers holding
+ exactly channelCount channels as one block of samples, copies between
+ interleaved and non-interleaved buffers in blocks using
+ PaUtil_DeinterleaveAndConvert() and PaUtil_ConvertAndInterleave(), or
+ converts each channel separately. In the latter case strided channels are
+ processed a cache sized tile of frames at a time across all channels.
+ Dithering converters (see PaUtil_ConverterDithers()) are always called for
+ all frames of each channel in turn, so the output is the same as converting
+ the channels one after another.
+*/
+void PaUtil_ConvertChannels( PaUtilConverter *converter,
+        PaUtilChannelDescriptor *destinationChannels, unsigned int bytesPerDestinationSample,
+        PaUtilChannelDescriptor *sourceChannels, unsigned int bytesPerSourceSample,
+        unsigned int channelCount, unsigned int frameCount,
+        struct PaSampleConverterState *ditherGenerator );
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PA_INTERLEAVE_H */
@@ -48,6 +48,9 @@
 #include <string.h> /* memset() */
 
 #include "pa_process.h"
+#include "pa_interleave.h"
+#include "pa_memorybarrier.h"
+#include "pa_resampler.h"
 #include "pa_util.h"
 
 
@@ -55,6 +58,20 @@
 
 #define PA_MIN_( a, b ) ( ((a)<(b)) ? (a) : (b) )
 
+/* the scratch memory, and every buffer passed to the callback, is aligned to
+    this many bytes, the size of a cache line */
+#define PA_SCRATCH_ALIGNMENT_   (64)
+#define PA_ALIGN_UP_( n )       ( ((n) + PA_SCRATCH_ALIGNMENT_ - 1) & ~(unsigned long)(PA_SCRATCH_ALIGNMENT_ - 1) )
+
+/* values of bp->outputChannelSources[] for host channels which are not a
+    copy of one user channel */
+#define PA_MATRIX_SILENT_       (-1)
+#define PA_MATRIX_MIXED_        (-2)
+
+/* mixed host channels, and host channels to which a gain is applied, are
+    converted this many frames at a time */
+#define PA_OUTPUT_BLOCK_FRAMES_ (256)
+
 
 /* greatest common divisor - PGCD in French */
 static unsigned long GCD( unsigned long a, unsigned long b )
@@ -87,6 +104,220 @@ static unsigned long CalculateFrameShift( unsigned long M, unsigned long N )
 }
 
 
+/* The noise shaping converters keep error feedback in the dither generator,
+    so they need one generator per channel. */
+static int IsNoiseShapingConverter( PaUtilConverter *converter )
+{
+    return converter != 0 && ( converter == paConverters.Float32_To_Int16_NoiseShaped
+            || converter == paConverters.Float32_To_Int8_NoiseShaped
+            || converter == paConverters.Float32_To_UInt8_NoiseShaped );
+}
+
+
+/* paInt32 and paFloat32 samples have the same width, and the built in
+    converters between them read each sample before writing it, so they may
+    convert a buffer in place. Registered converters are not assumed to. */
+static int CanConvertInPlace( PaSampleFormat sourceFormat,
+        PaSampleFormat destinationFormat, PaStreamFlags flags )
+{
+    PaSampleFormat source = sourceFormat & ~paNonInterleaved;
+    PaSampleFormat destination = destinationFormat & ~paNonInterleaved;
+
+    return ( ( source == paInt32 && destination == paFloat32 )
+                || ( source == paFloat32 && destination == paInt32 ) )
+            && !PaUtil_FindRegisteredConverter( sourceFormat, destinationFormat, flags );
+}
+
+
+/* the number of bytes of a temp buffer channel of frameCount frames, padded to
+    a whole number of cache lines so that every channel starts aligned */
+static unsigned long TempChannelBytes( unsigned long frameCount, unsigned int bytesPerSample )
+{
+    return PA_ALIGN_UP_( frameCount * bytesPerSample );
+}
+
+
+/* Host buffers are only passed to the callback when they are as aligned as
+    the temp buffers. */
+static int IsAligned( const void *p )
+{
+    return ((size_t)p & (PA_SCRATCH_ALIGNMENT_ - 1)) == 0;
+}
+
+
+static int ChannelsAreAligned( const PaUtilChannelDescriptor *channels, unsigned int channelCount )
+{
+    unsigned int i;
+
+    for( i=0; i < channelCount; ++i )
+    {
+        if( !IsAligned( channels[i].data ) )
+            return 0;
+    }
+
+    return 1;
+}
+
+
+/*
+    The temp buffers, the channel descriptors and pointer arrays, and the per
+    channel dither generators of a buffer processor share one block of
+    memory, in which each starts on a cache line of its own.
+*/
+typedef struct ScratchMemory
+{
+    void *block;                /* as allocated, not aligned */
+    void *tempInputBuffer;
+    unsigned long tempInputBufferSize;
+    void **tempInputBufferPtrs;
+    PaUtilChannelDescriptor *inputChannels; /* host [0], host [1] and user */
+    PaUtilTriangularDitherGenerator *inputDitherGenerators;
+    void *tempOutputBuffer;
+    unsigned long tempOutputBufferSize;
+    void **tempOutputBufferPtrs;
+    PaUtilChannelDescriptor *outputChannels; /* host [0], host [1] and user */
+    PaUtilTriangularDitherGenerator *outputDitherGenerators;
+}
+ScratchMemory;
+
+
+/* Returns the aligned address for the next region of size bytes, and
+    advances offset past it. */
+static void* NextScratchRegion( unsigned char *base, unsigned long *offset, unsigned long size )
+{
+    void *result = base ? base + *offset : 0;
+
+    *offset += PA_ALIGN_UP_( size );
+    return result;
+}
+
+
+/*
+    LayoutScratchMemory() places the scratch regions of bp, for
+    userOutputChannelCount user output channels, from the aligned address
+    base, and returns their total size. With base 0 they are only measured.
+*/
+static unsigned long LayoutScratchMemory( PaUtilBufferProcessor *bp, unsigned char *base,
+        unsigned int userOutputChannelCount, int hasInputDitherGenerators,
+        int hasOutputDitherGenerators, ScratchMemory *scratch )
+{
+    unsigned long offset = 0;
+    unsigned int inputChannelCount = bp->inputChannelCount;
+    unsigned int outputChannelCount = bp->outputChannelCount;
+
+    if( inputChannelCount > 0 )
+    {
+        scratch->tempInputBufferSize = bp->userInputIsInterleaved
+                ? TempChannelBytes( bp->framesPerTempBuffer, bp->bytesPerUserInputSample * inputChannelCount )
+                : TempChannelBytes( bp->framesPerTempBuffer, bp->bytesPerUserInputSample ) * inputChannelCount;
+        scratch->tempInputBuffer = NextScratchRegion( base, &offset, scratch->tempInputBufferSize );
+
+        if( !bp->userInputIsInterleaved )
+            scratch->tempInputBufferPtrs = (void**)NextScratchRegion( base, &offset, sizeof(void*) * inputChannelCount );
+
+        scratch->inputChannels = (PaUtilChannelDescriptor*)NextScratchRegion( base, &offset,
+                sizeof(PaUtilChannelDescriptor) * inputChannelCount * 3 );
+
+        if( hasInputDitherGenerators )
+        {
+            scratch->inputDitherGenerators = (PaUtilTriangularDitherGenerator*)NextScratchRegion( base, &offset,
+                    sizeof(PaUtilTriangularDitherGenerator) * inputChannelCount );
+        }
+    }
+
+    if( outputChannelCount > 0 )
+    {
+        scratch->tempOutputBufferSize = bp->userOutputIsInterleaved
+                ? TempChannelBytes( bp->framesPerTempBuffer, bp->bytesPerUserOutputSample * userOutputChannelCount )
+                : TempChannelBytes( bp->framesPerTempBuffer, bp->bytesPerUserOutputSample ) * userOutputChannelCount;
+        scratch->tempOutputBuffer = NextScratchRegion( base, &offset, scratch->tempOutputBufferSize );
+
+        if( !bp->userOutputIsInterleaved )
+            scratch->tempOutputBufferPtrs = (void**)NextScratchRegion( base, &offset, sizeof(void*) * userOutputChannelCount );
+
+        scratch->outputChannels = (PaUtilChannelDescriptor*)NextScratchRegion( base, &offset,
+                sizeof(PaUtilChannelDescriptor) * (outputChannelCount * 2 + userOutputChannelCount) );
+
+        if( hasOutputDitherGenerators )
+        {
+            scratch->outputDitherGenerators = (PaUtilTriangularDitherGenerator*)NextScratchRegion( base, &offset,
+                    sizeof(PaUtilTriangularDitherGenerator) * outputChannelCount );
+        }
+    }
+
+    return offset;
+}
+
+
+/*
+    AllocateScratchMemory() allocates the scratch memory of bp for
+    userOutputChannelCount user output channels. It is zero initialized,
+    which the initial frames in the temp buffers rely on.
+*/
+static PaError AllocateScratchMemory( PaUtilBufferProcessor *bp, unsigned int userOutputChannelCount,
+        int hasInputDitherGenerators, int hasOutputDitherGenerators, ScratchMemory *scratch )
+{
+    ScratchMemory measured;
+    unsigned long size;
+    unsigned char *base;
+    unsigned int i;
+
+    memset( &measured, 0, sizeof(measured) );
+    size = LayoutScratchMemory( bp, 0, userOutputChannelCount,
+            hasInputDitherGenerators, hasOutputDitherGenerators, &measured );
+
+    memset( scratch, 0, sizeof(*scratch) );
+    scratch->block = PaUtil_AllocateZeroInitializedMemory( (long)(size + PA_SCRATCH_ALIGNMENT_ - 1) );
+    if( !scratch->block )
+        return paInsufficientMemory;
+
+    base = (unsigned char*)scratch->block;
+    base += ( PA_SCRATCH_ALIGNMENT_ - ((size_t)base & (PA_SCRATCH_ALIGNMENT_ - 1)) ) & (PA_SCRATCH_ALIGNMENT_ - 1);
+    LayoutScratchMemory( bp, base, userOutputChannelCount,
+            hasInputDitherGenerators, hasOutputDitherGenerators, scratch );
+
+    for( i=0; scratch->inputDitherGenerators && i < bp->inputChannelCount; ++i )
+        PaUtil_InitializeChannelTriangularDitherState( &scratch->inputDitherGenerators[i], i );
+
+    for( i=0; scratch->outputDitherGenerators && i < bp->outputChannelCount; ++i )
+        PaUtil_InitializeChannelTriangularDitherState( &scratch->outputDitherGenerators[i], i );
+
+    return paNoError;
+}
+
+
+/* Frees the scratch memory of bp, if any, and replaces it with scratch. */
+static void InstallScratchMemory( PaUtilBufferProcessor *bp, ScratchMemory *scratch )
+{
+    if( bp->scratchMemory )
+        PaUtil_FreeMemory( bp->scratchMemory );
+
+    bp->scratchMemory = scratch->block;
+
+    bp->tempInputBuffer = scratch->tempInputBuffer;
+    bp->tempInputBufferSize = scratch->tempInputBufferSize;
+    bp->tempInputBufferPtrs = scratch->tempInputBufferPtrs;
+    bp->inputDitherGenerators = scratch->inputDitherGenerators;
+    if( scratch->inputChannels )
+    {
+        bp->hostInputChannels[0] = scratch->inputChannels;
+        bp->hostInputChannels[1] = &scratch->inputChannels[bp->inputChannelCount];
+        bp->userInputChannels = &scratch->inputChannels[bp->inputChannelCount * 2];
+    }
+
+    bp->tempOutputBuffer = scratch->tempOutputBuffer;
+    bp->tempOutputBufferSize = scratch->tempOutputBufferSize;
+    bp->tempOutputBufferPtrs = scratch->tempOutputBufferPtrs;
+    bp->outputDitherGenerators = scratch->outputDitherGenerators;
+    if( scratch->outputChannels )
+    {
+        bp->hostOutputChannels[0] = scratch->outputChannels;
+        bp->hostOutputChannels[1] = &scratch->outputChannels[bp->outputChannelCount];
+        bp->userOutputChannels = &scratch->outputChannels[bp->outputChannelCount * 2];
+    }
+}
+
+
 PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
         int inputChannelCount, PaSampleFormat userInputSampleFormat,
         PaSampleFormat hostInputSampleFormat,
@@ -101,8 +332,8 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
 {
     PaError result = paNoError;
     PaError bytesPerSample;
-    unsigned long tempInputBufferSize, tempOutputBufferSize;
     PaStreamFlags tempInputStreamFlags;
+    ScratchMemory scratch;
 
     if( streamFlags & paNeverDropInput )
     {
@@ -112,10 +343,12 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
             return paInvalidFlag;
     }
 
-    /* initialize buffer ptrs to zero so they can be freed if necessary in error */
+    bp->scratchMemory = 0;
     bp->tempInputBuffer = 0;
+    bp->tempInputBufferSize = 0;
     bp->tempInputBufferPtrs = 0;
     bp->tempOutputBuffer = 0;
+    bp->tempOutputBufferSize = 0;
     bp->tempOutputBufferPtrs = 0;
 
     bp->framesPerUserBuffer = framesPerUserBuffer;
@@ -123,12 +356,56 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
 
     bp->inputChannelCount = inputChannelCount;
     bp->outputChannelCount = outputChannelCount;
+    bp->userOutputChannelCount = outputChannelCount;
+    bp->userOutputIsFloat32 = 0;
+    bp->outputChannelMatrix = 0;
+    bp->outputChannelSources = 0;
+
+    bp->outputGain = 1.f;
+    bp->outputGainTarget = 1.f;
+    bp->outputGainStep = 0.f;
+    bp->outputGainRampFrames = 0;
+    bp->outputGainIsActive = 0;
+    bp->outputGainSourceConverter = 0;
+    bp->outputGainConverter = 0;
+    bp->outputMasterGain = 1.f;
+    bp->outputFadeInFrames = 0;
+    bp->outputFadeOutFrames = 0;
+    bp->outputGainRequestCount = 0;
+    bp->outputGainRequestTarget = 1.f;
+    bp->outputGainRequestFrames = 0;
+    bp->outputGainRequestsSeen = 0;
+    bp->outputGainRampRequest = 0;
+    bp->outputGainRequestsDone = 0;
 
     bp->hostBufferSizeMode = hostBufferSizeMode;
 
     bp->hostInputChannels[0] = bp->hostInputChannels[1] = 0;
     bp->hostOutputChannels[0] = bp->hostOutputChannels[1] = 0;
 
+    bp->inputDitherGenerators = 0;
+    bp->outputDitherGenerators = 0;
+
+    bp->inputClippedSampleCount = 0;
+    bp->outputClippedSampleCount = 0;
+    bp->inputClippedSampleCountRead = 0;
+    bp->outputClippedSampleCountRead = 0;
+    memset( &bp->xrunCounts, 0, sizeof(bp->xrunCounts) );
+    memset( &bp->xrunCountsRead, 0, sizeof(bp->xrunCountsRead) );
+
+    bp->userInputConvertsInPlace = 0;
+    bp->hostInputBufferIsWritable = 0;
+    bp->userOutputConvertsInPlace = 0;
+    bp->passThroughFlags = 0;
+
+    bp->channelGroupCallback = 0;
+    bp->channelsPerGroup = 0;
+    bp->channelGroupCount = 0;
+    bp->channelGroupResults = 0;
+    bp->workerPool = 0;
+
+    bp->resamplingStage = 0;
+
     if( framesPerUserBuffer == 0 ) /* streamCallback will accept any buffer size */
     {
         bp->useNonAdaptingProcess = 1;
@@ -224,13 +501,13 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
         }
 
         /* Under the assumption that no ADC in existence delivers better than 24bits resolution,
-            we disable dithering when host input format is paInt32 and user format is paInt24,
-            since the host samples will just be padded with zeros anyway. */
+            we disable dithering when host input format is paInt32 and user format is paInt24
+            or paInt24In32, since the host samples will just be padded with zeros anyway. */
 
         tempInputStreamFlags = streamFlags;
         if( !(tempInputStreamFlags & paDitherOff) /* dither is on */
                 && (hostInputSampleFormat & paInt32) /* host input format is int32 */
-                && (userInputSampleFormat & paInt24) /* user requested format is int24 */ ){
+                && (userInputSampleFormat & (paInt24 | paInt24In32)) /* user requested format is int24 */ ){
 
             tempInputStreamFlags = tempInputStreamFlags | paDitherOff;
         }
@@ -244,44 +521,11 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
 
         bp->hostInputIsInterleaved = (hostInputSampleFormat & paNonInterleaved)?0:1;
 
-        bp->userInputSampleFormatIsEqualToHost = ((userInputSampleFormat & ~paNonInterleaved) == (hostInputSampleFormat & ~paNonInterleaved));
-
-        tempInputBufferSize =
-            bp->framesPerTempBuffer * bp->bytesPerUserInputSample * inputChannelCount;
+        /* a converter registered for equal formats replaces the copy */
+        bp->userInputSampleFormatIsEqualToHost = ((userInputSampleFormat & ~paNonInterleaved) == (hostInputSampleFormat & ~paNonInterleaved))
+                && !PaUtil_FindRegisteredConverter( hostInputSampleFormat, userInputSampleFormat, tempInputStreamFlags );
 
-        bp->tempInputBuffer = PaUtil_AllocateZeroInitializedMemory( tempInputBufferSize );
-        if( bp->tempInputBuffer == 0 )
-        {
-            result = paInsufficientMemory;
-            goto error;
-        }
-
-        if( bp->framesInTempInputBuffer > 0 )
-        {
-            /* NOTE: we depend on bp->tempInputBuffer being zero-initialized by the allocator. */
-            /* memset( bp->tempInputBuffer, 0, tempInputBufferSize ); */
-        }
-
-        if( userInputSampleFormat & paNonInterleaved )
-        {
-            bp->tempInputBufferPtrs =
-                (void **)PaUtil_AllocateZeroInitializedMemory( sizeof(void*)*inputChannelCount );
-            if( bp->tempInputBufferPtrs == 0 )
-            {
-                result = paInsufficientMemory;
-                goto error;
-            }
-        }
-
-        bp->hostInputChannels[0] = (PaUtilChannelDescriptor*)
-                PaUtil_AllocateZeroInitializedMemory( sizeof(PaUtilChannelDescriptor) * inputChannelCount * 2);
-        if( bp->hostInputChannels[0] == 0 )
-        {
-            result = paInsufficientMemory;
-            goto error;
-        }
-
-        bp->hostInputChannels[1] = &bp->hostInputChannels[0][inputChannelCount];
+        bp->userInputConvertsInPlace = CanConvertInPlace( hostInputSampleFormat, userInputSampleFormat, tempInputStreamFlags );
     }
 
     if( outputChannelCount > 0 )
@@ -315,134 +559,539 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
 
         bp->userOutputIsInterleaved = (userOutputSampleFormat & paNonInterleaved)?0:1;
 
+        bp->userOutputIsFloat32 = ((userOutputSampleFormat & ~paNonInterleaved) == paFloat32);
+
+        if( !bp->userOutputIsFloat32 )
+        {
+            /* a gain is applied to paFloat32 samples, other user formats go
+                through paFloat32. Noise shaping needs per channel generators,
+                which are only allocated for outputConverter. */
+            bp->outputGainSourceConverter =
+                PaUtil_SelectConverter( userOutputSampleFormat, paFloat32, paNoFlag );
+            bp->outputGainConverter =
+                PaUtil_SelectConverter( paFloat32, hostOutputSampleFormat, streamFlags & ~paNoiseShapedDither );
+        }
+
         bp->hostOutputIsInterleaved = (hostOutputSampleFormat & paNonInterleaved)?0:1;
 
-        bp->userOutputSampleFormatIsEqualToHost = ((userOutputSampleFormat & ~paNonInterleaved) == (hostOutputSampleFormat & ~paNonInterleaved));
+        bp->userOutputSampleFormatIsEqualToHost = ((userOutputSampleFormat & ~paNonInterleaved) == (hostOutputSampleFormat & ~paNonInterleaved))
+                && !PaUtil_FindRegisteredConverter( userOutputSampleFormat, hostOutputSampleFormat, streamFlags );
 
-        tempOutputBufferSize =
-                bp->framesPerTempBuffer * bp->bytesPerUserOutputSample * outputChannelCount;
+        bp->userOutputConvertsInPlace = CanConvertInPlace( userOutputSampleFormat, hostOutputSampleFormat, streamFlags );
+    }
 
-        bp->tempOutputBuffer = PaUtil_AllocateZeroInitializedMemory( tempOutputBufferSize );
-        if( bp->tempOutputBuffer == 0 )
-        {
-            result = paInsufficientMemory;
-            goto error;
-        }
+    result = AllocateScratchMemory( bp, outputChannelCount,
+            inputChannelCount > 0 && IsNoiseShapingConverter( bp->inputConverter ),
+            outputChannelCount > 0 && IsNoiseShapingConverter( bp->outputConverter ),
+            &scratch );
+    if( result != paNoError )
+        goto error;
 
-        if( bp->framesInTempOutputBuffer > 0 )
+    InstallScratchMemory( bp, &scratch );
+
+    PaUtil_InitializeTriangularDitherState( &bp->ditherGenerator );
+
+    bp->samplePeriod = 1. / sampleRate;
+
+    bp->streamCallback = streamCallback;
+    bp->userData = userData;
+
+    return result;
+
+error:
+    return result;
+}
+
+
+PaError PaUtil_InitializeResamplingBufferProcessor( PaUtilBufferProcessor* bp,
+        int inputChannelCount, PaSampleFormat userInputSampleFormat,
+        PaSampleFormat hostInputSampleFormat,
+        int outputChannelCount, PaSampleFormat userOutputSampleFormat,
+        PaSampleFormat hostOutputSampleFormat,
+        double userSampleRate, double hostSampleRate,
+        PaStreamFlags streamFlags,
+        unsigned long framesPerUserBuffer,
+        unsigned long framesPerHostBuffer,
+        PaUtilHostBufferSizeMode hostBufferSizeMode,
+        PaStreamCallback *streamCallback, void *userData )
+{
+    PaError result;
+    PaUtilResamplingStage *stage;
+
+    if( userSampleRate == hostSampleRate )
+    {
+        return PaUtil_InitializeBufferProcessor( bp,
+                inputChannelCount, userInputSampleFormat, hostInputSampleFormat,
+                outputChannelCount, userOutputSampleFormat, hostOutputSampleFormat,
+                hostSampleRate, streamFlags, framesPerUserBuffer, framesPerHostBuffer,
+                hostBufferSizeMode, streamCallback, userData );
+    }
+
+    /* blocking streams have no callback to run the stage in */
+    if( !streamCallback )
+        return paInvalidSampleRate;
+
+    /* the buffer processor passes host buffers of any size to the stage as
+        paFloat32, the stage converts them to the user rate and formats */
+    result = PaUtil_InitializeBufferProcessor( bp,
+            inputChannelCount, paFloat32, hostInputSampleFormat,
+            outputChannelCount, paFloat32, hostOutputSampleFormat,
+            hostSampleRate, streamFlags, paFramesPerBufferUnspecified, framesPerHostBuffer,
+            hostBufferSizeMode, PaUtil_ResamplingStageCallback, 0 );
+    if( result != paNoError )
+        return result;
+
+    result = PaUtil_CreateResamplingStage( &stage,
+            inputChannelCount, userInputSampleFormat, outputChannelCount, userOutputSampleFormat,
+            userSampleRate, hostSampleRate, streamFlags, framesPerUserBuffer, bp->framesPerTempBuffer,
+            streamCallback, userData, &bp->inputClippedSampleCount );
+    if( result != paNoError )
+    {
+        PaUtil_TerminateBufferProcessor( bp );
+        return result;
+    }
+
+    bp->resamplingStage = stage;
+    bp->userData = stage;
+
+    return paNoError;
+}
+
+
+void PaUtil_TerminateBufferProcessor( PaUtilBufferProcessor* bp )
+{
+    if( bp->scratchMemory )
+        PaUtil_FreeMemory( bp->scratchMemory );
+
+    if( bp->outputChannelMatrix )
+        PaUtil_FreeMemory( bp->outputChannelMatrix );
+
+    if( bp->outputChannelSources )
+        PaUtil_FreeMemory( bp->outputChannelSources );
+
+    PaUtil_DestroyWorkerPool( bp->workerPool );
+
+    if( bp->channelGroupResults )
+        PaUtil_FreeMemory( bp->channelGroupResults );
+
+    PaUtil_DestroyResamplingStage( bp->resamplingStage );
+}
+
+
+void PaUtil_ResetBufferProcessor( PaUtilBufferProcessor* bp )
+{
+    bp->framesInTempInputBuffer = bp->initialFramesInTempInputBuffer;
+    bp->framesInTempOutputBuffer = bp->initialFramesInTempOutputBuffer;
+
+    if( bp->framesInTempInputBuffer > 0 )
+        memset( bp->tempInputBuffer, 0, bp->tempInputBufferSize );
+
+    if( bp->framesInTempOutputBuffer > 0 )
+        memset( bp->tempOutputBuffer, 0, bp->tempOutputBufferSize );
+
+    if( bp->resamplingStage )
+        PaUtil_ResetResamplingStage( bp->resamplingStage );
+}
+
+
+unsigned long PaUtil_GetBufferProcessorInputLatencyFrames( PaUtilBufferProcessor* bp )
+{
+    return bp->initialFramesInTempInputBuffer
+            + ( bp->resamplingStage ? PaUtil_GetResamplingStageInputLatencyFrames( bp->resamplingStage ) : 0 );
+}
+
+
+unsigned long PaUtil_GetBufferProcessorOutputLatencyFrames( PaUtilBufferProcessor* bp )
+{
+    return bp->initialFramesInTempOutputBuffer
+            + ( bp->resamplingStage ? PaUtil_GetResamplingStageOutputLatencyFrames( bp->resamplingStage ) : 0 );
+}
+
+
+void PaUtil_SetBufferProcessorConverters( PaUtilBufferProcessor* bp,
+        PaUtilConverter *inputConverter, PaUtilConverter *outputConverter )
+{
+    if( inputConverter && bp->inputChannelCount > 0 )
+    {
+        bp->inputConverter = inputConverter;
+        bp->userInputSampleFormatIsEqualToHost = 0;
+        bp->userInputConvertsInPlace = 0; /* the converter may not support aliased buffers */
+    }
+
+    if( outputConverter && bp->outputChannelCount > 0 )
+    {
+        bp->outputConverter = outputConverter;
+        bp->userOutputSampleFormatIsEqualToHost = 0;
+        bp->userOutputConvertsInPlace = 0;
+    }
+}
+
+
+PaError PaUtil_SetBufferProcessorChannelGroupCallback( PaUtilBufferProcessor* bp,
+        PaStreamChannelGroupCallback *groupCallback, unsigned int channelsPerGroup,
+        unsigned int threadCount )
+{
+    PaError result = paNoError;
+    unsigned int maxChannelCount = PA_MAX_( bp->inputChannelCount, bp->userOutputChannelCount );
+    unsigned int groupCount = 0;
+    int *groupResults = 0;
+    PaUtilWorkerPool *workerPool = 0;
+
+    assert( !groupCallback || bp->inputChannelCount == 0 || !bp->userInputIsInterleaved );
+    assert( !groupCallback || bp->outputChannelCount == 0 || !bp->userOutputIsInterleaved );
+
+    if( groupCallback )
+    {
+        assert( channelsPerGroup > 0 );
+
+        groupCount = (maxChannelCount + channelsPerGroup - 1) / channelsPerGroup;
+
+        if( threadCount == 0 )
+            threadCount = PaUtil_GetProcessorCount();
+        threadCount = PA_MIN_( threadCount, groupCount );
+
+        groupResults = (int*)PaUtil_AllocateZeroInitializedMemory( sizeof(int) * groupCount );
+        if( !groupResults )
+            return paInsufficientMemory;
+
+        /* the calling thread is one of the threads */
+        result = PaUtil_CreateWorkerPool( &workerPool, threadCount > 0 ? threadCount - 1 : 0 );
+        if( result != paNoError )
         {
-            /* NOTE: we depend on bp->tempOutputBuffer being zero-initialized by the allocator. */
-            /* memset( bp->tempOutputBuffer, 0, tempOutputBufferSize ); */
+            PaUtil_FreeMemory( groupResults );
+            return result;
         }
+    }
+
+    PaUtil_DestroyWorkerPool( bp->workerPool );
+    if( bp->channelGroupResults )
+        PaUtil_FreeMemory( bp->channelGroupResults );
+
+    bp->channelGroupCallback = groupCallback;
+    bp->channelsPerGroup = channelsPerGroup;
+    bp->channelGroupCount = groupCount;
+    bp->channelGroupResults = groupResults;
+    bp->workerPool = workerPool;
+
+    return result;
+}
+
+
+PaError PaUtil_SetBufferProcessorOutputChannelMatrix( PaUtilBufferProcessor* bp,
+        unsigned int userChannelCount, const float *matrix )
+{
+    PaError result = paInsufficientMemory;
+    unsigned int hostChannelCount = bp->outputChannelCount;
+    float *channelMatrix = 0;
+    int *channelSources = 0;
+    ScratchMemory scratch;
+    int *groupResults = 0;
+    unsigned int groupCount = 0;
+    unsigned int h, u;
+
+    assert( hostChannelCount > 0 );
+    assert( !bp->resamplingStage );
+
+    scratch.block = 0;
+
+    if( matrix )
+    {
+        assert( userChannelCount > 0 );
+
+        channelMatrix = (float*)PaUtil_AllocateZeroInitializedMemory(
+                sizeof(float) * hostChannelCount * userChannelCount );
+        channelSources = (int*)PaUtil_AllocateZeroInitializedMemory( sizeof(int) * hostChannelCount );
+        if( !channelMatrix || !channelSources )
+            goto error;
 
-        if( userOutputSampleFormat & paNonInterleaved )
+        memcpy( channelMatrix, matrix, sizeof(float) * hostChannelCount * userChannelCount );
+
+        for( h=0; h < hostChannelCount; ++h )
         {
-            bp->tempOutputBufferPtrs =
-                (void **)PaUtil_AllocateZeroInitializedMemory( sizeof(void*)*outputChannelCount );
-            if( bp->tempOutputBufferPtrs == 0 )
+            const float *row = &channelMatrix[ h * userChannelCount ];
+
+            channelSources[h] = PA_MATRIX_SILENT_;
+            for( u=0; u < userChannelCount; ++u )
             {
-                result = paInsufficientMemory;
+                if( row[u] == 0.f )
+                    continue;
+
+                channelSources[h] = ( channelSources[h] == PA_MATRIX_SILENT_ && row[u] == 1.f )
+                        ? (int)u : PA_MATRIX_MIXED_;
+            }
+
+            if( channelSources[h] == PA_MATRIX_MIXED_ && !bp->userOutputIsFloat32 )
+            {
+                result = paSampleFormatNotSupported;
                 goto error;
             }
         }
+    }
+    else
+    {
+        userChannelCount = hostChannelCount;
+    }
 
-        bp->hostOutputChannels[0] = (PaUtilChannelDescriptor*)
-                PaUtil_AllocateZeroInitializedMemory( sizeof(PaUtilChannelDescriptor)*outputChannelCount * 2 );
-        if( bp->hostOutputChannels[0] == 0 )
-        {
-            result = paInsufficientMemory;
-            goto error;
-        }
+    /* the buffers which hold user channels are sized for the new count */
+    result = AllocateScratchMemory( bp, userChannelCount,
+            bp->inputDitherGenerators != 0, bp->outputDitherGenerators != 0, &scratch );
+    if( result != paNoError )
+        goto error;
+    result = paInsufficientMemory;
 
-        bp->hostOutputChannels[1] = &bp->hostOutputChannels[0][outputChannelCount];
+    if( bp->channelGroupCallback )
+    {
+        groupCount = (PA_MAX_( bp->inputChannelCount, userChannelCount ) + bp->channelsPerGroup - 1)
+                / bp->channelsPerGroup;
+        groupResults = (int*)PaUtil_AllocateZeroInitializedMemory( sizeof(int) * groupCount );
+        if( !groupResults )
+            goto error;
     }
 
-    PaUtil_InitializeTriangularDitherState( &bp->ditherGenerator );
+    if( bp->outputChannelMatrix )
+        PaUtil_FreeMemory( bp->outputChannelMatrix );
+    if( bp->outputChannelSources )
+        PaUtil_FreeMemory( bp->outputChannelSources );
 
-    bp->samplePeriod = 1. / sampleRate;
+    bp->outputChannelMatrix = channelMatrix;
+    bp->outputChannelSources = channelSources;
+    bp->userOutputChannelCount = userChannelCount;
+    InstallScratchMemory( bp, &scratch );
 
-    bp->streamCallback = streamCallback;
-    bp->userData = userData;
+    if( groupResults )
+    {
+        PaUtil_FreeMemory( bp->channelGroupResults );
+        bp->channelGroupCount = groupCount;
+        bp->channelGroupResults = groupResults;
+    }
 
-    return result;
+    return paNoError;
 
 error:
-    if( bp->tempInputBuffer )
-        PaUtil_FreeMemory( bp->tempInputBuffer );
+    if( channelMatrix )
+        PaUtil_FreeMemory( channelMatrix );
+    if( channelSources )
+        PaUtil_FreeMemory( channelSources );
+    if( scratch.block )
+        PaUtil_FreeMemory( scratch.block );
 
-    if( bp->tempInputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempInputBufferPtrs );
+    return result;
+}
 
-    if( bp->hostInputChannels[0] )
-        PaUtil_FreeMemory( bp->hostInputChannels[0] );
 
-    if( bp->tempOutputBuffer )
-        PaUtil_FreeMemory( bp->tempOutputBuffer );
+/*
+    The gain requests are passed to the processing thread through a sequence
+    lock: outputGainRequestCount is odd while a request is being written, and
+    the processing thread ignores a request which changed while it was read,
+    picking it up at the next host buffer instead.
+*/
+static unsigned long PostOutputGainRequest( PaUtilBufferProcessor* bp,
+        float gain, unsigned long rampFrames )
+{
+    unsigned long request = bp->outputGainRequestCount + 2;
 
-    if( bp->tempOutputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempOutputBufferPtrs );
+    bp->outputGainRequestCount = request - 1;
+    PaUtil_WriteMemoryBarrier();
+    bp->outputGainRequestTarget = gain;
+    bp->outputGainRequestFrames = rampFrames;
+    PaUtil_WriteMemoryBarrier();
+    bp->outputGainRequestCount = request;
 
-    if( bp->hostOutputChannels[0] )
-        PaUtil_FreeMemory( bp->hostOutputChannels[0] );
+    return request;
+}
 
-    return result;
+
+/* Starts a ramp from the current gain to target, called by the processing
+    thread or while the buffer processor is not in use. */
+static void StartOutputGainRamp( PaUtilBufferProcessor* bp, float target,
+        unsigned long rampFrames, unsigned long request )
+{
+    bp->outputGainTarget = target;
+    bp->outputGainRampRequest = request;
+
+    if( rampFrames == 0 )
+    {
+        bp->outputGain = target;
+        bp->outputGainStep = 0.f;
+        bp->outputGainRampFrames = 0;
+        bp->outputGainRequestsDone = request;
+    }
+    else
+    {
+        bp->outputGainStep = (target - bp->outputGain) / (float)rampFrames;
+        bp->outputGainRampFrames = rampFrames;
+    }
+
+    bp->outputGainIsActive = ( bp->outputGain != 1.f || bp->outputGainRampFrames != 0 );
 }
 
 
-void PaUtil_TerminateBufferProcessor( PaUtilBufferProcessor* bp )
+/* Picks up the most recent gain request, called by the processing thread at
+    the start of each host buffer. */
+static void UpdateOutputGain( PaUtilBufferProcessor* bp )
 {
-    if( bp->tempInputBuffer )
-        PaUtil_FreeMemory( bp->tempInputBuffer );
+    unsigned long request = bp->outputGainRequestCount;
+    float target;
+    unsigned long rampFrames;
 
-    if( bp->tempInputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempInputBufferPtrs );
+    if( request == bp->outputGainRequestsSeen || (request & 1) )
+        return;
 
-    if( bp->hostInputChannels[0] )
-        PaUtil_FreeMemory( bp->hostInputChannels[0] );
+    PaUtil_ReadMemoryBarrier();
+    target = bp->outputGainRequestTarget;
+    rampFrames = bp->outputGainRequestFrames;
+    PaUtil_ReadMemoryBarrier();
 
-    if( bp->tempOutputBuffer )
-        PaUtil_FreeMemory( bp->tempOutputBuffer );
+    if( bp->outputGainRequestCount != request )
+        return;
+
+    bp->outputGainRequestsSeen = request;
+    StartOutputGainRamp( bp, target, rampFrames, request );
+}
 
-    if( bp->tempOutputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempOutputBufferPtrs );
 
-    if( bp->hostOutputChannels[0] )
-        PaUtil_FreeMemory( bp->hostOutputChannels[0] );
+/* Advances the gain ramp by frameCount frames, after they were converted. */
+static void AdvanceOutputGain( PaUtilBufferProcessor* bp, unsigned long frameCount )
+{
+    if( bp->outputGainRampFrames == 0 )
+        return;
+
+    if( frameCount >= bp->outputGainRampFrames )
+    {
+        bp->outputGain = bp->outputGainTarget;
+        bp->outputGainStep = 0.f;
+        bp->outputGainRampFrames = 0;
+        bp->outputGainIsActive = ( bp->outputGain != 1.f );
+        PaUtil_WriteMemoryBarrier();
+        bp->outputGainRequestsDone = bp->outputGainRampRequest;
+    }
+    else
+    {
+        bp->outputGain += bp->outputGainStep * (float)frameCount;
+        bp->outputGainRampFrames -= frameCount;
+    }
+}
+
+
+PaError PaUtil_SetBufferProcessorOutputGain( PaUtilBufferProcessor* bp,
+        float gain, unsigned long rampFrames )
+{
+    assert( bp->outputChannelCount > 0 );
+
+    if( gain != 1.f && !bp->userOutputIsFloat32
+            && ( !bp->outputGainSourceConverter || !bp->outputGainConverter ) )
+        return paSampleFormatNotSupported;
+
+    bp->outputMasterGain = gain;
+    PostOutputGainRequest( bp, gain, rampFrames );
+
+    return paNoError;
+}
+
+
+void PaUtil_SetBufferProcessorOutputFades( PaUtilBufferProcessor* bp,
+        unsigned long fadeInFrames, unsigned long fadeOutFrames )
+{
+    bp->outputFadeInFrames = fadeInFrames;
+    bp->outputFadeOutFrames = fadeOutFrames;
+}
+
+
+void PaUtil_StartBufferProcessorOutputGain( PaUtilBufferProcessor* bp )
+{
+    /* requests posted while the stream was stopped are superseded */
+    bp->outputGainRequestsSeen = bp->outputGainRequestCount;
+    bp->outputGainRequestsDone = bp->outputGainRequestCount;
+
+    if( bp->outputFadeInFrames > 0 )
+        bp->outputGain = 0.f;
+
+    StartOutputGainRamp( bp, bp->outputMasterGain, bp->outputFadeInFrames, bp->outputGainRequestCount );
+}
+
+
+unsigned long PaUtil_FadeOutBufferProcessorOutput( PaUtilBufferProcessor* bp )
+{
+    if( bp->outputFadeOutFrames == 0 )
+        return 0;
+
+    return PostOutputGainRequest( bp, 0.f, bp->outputFadeOutFrames );
+}
+
+
+int PaUtil_IsBufferProcessorOutputGainRequestDone( PaUtilBufferProcessor* bp, unsigned long request )
+{
+    unsigned long done = bp->outputGainRequestsDone;
+
+    /* a later request also completes this one */
+    return (long)(done - request) >= 0;
+}
+
+
+void PaUtil_ReadBufferProcessorClippedSampleCounts( PaUtilBufferProcessor* bp,
+        unsigned long *inputClippedSamples, unsigned long *outputClippedSamples )
+{
+    /* The totals are only written by the processing thread, so rather than
+        resetting them we remember where the previous read left off. The
+        difference stays correct when a total wraps around. */
+    unsigned long inputTotal = *(volatile unsigned long*)&bp->inputClippedSampleCount;
+    unsigned long outputTotal = *(volatile unsigned long*)&bp->outputClippedSampleCount;
+
+    *inputClippedSamples = inputTotal - bp->inputClippedSampleCountRead;
+    *outputClippedSamples = outputTotal - bp->outputClippedSampleCountRead;
+
+    bp->inputClippedSampleCountRead = inputTotal;
+    bp->outputClippedSampleCountRead = outputTotal;
+}
+
+
+void PaUtil_CountBufferProcessorXruns( PaUtilBufferProcessor* bp, PaStreamCallbackFlags statusFlags )
+{
+    if( statusFlags & paInputUnderflow )
+        ++bp->xrunCounts.inputUnderflows;
+    if( statusFlags & paInputOverflow )
+        ++bp->xrunCounts.inputOverflows;
+    if( statusFlags & paOutputUnderflow )
+        ++bp->xrunCounts.outputUnderflows;
+    if( statusFlags & paOutputOverflow )
+        ++bp->xrunCounts.outputOverflows;
 }
 
 
-void PaUtil_ResetBufferProcessor( PaUtilBufferProcessor* bp )
+void PaUtil_ReadBufferProcessorXrunCounts( PaUtilBufferProcessor* bp, PaUtilXrunCounts *xrunCounts )
 {
-    unsigned long tempInputBufferSize, tempOutputBufferSize;
+    /* see PaUtil_ReadBufferProcessorClippedSampleCounts() */
+    const volatile PaUtilXrunCounts *totals = &bp->xrunCounts;
+    PaUtilXrunCounts current;
 
-    bp->framesInTempInputBuffer = bp->initialFramesInTempInputBuffer;
-    bp->framesInTempOutputBuffer = bp->initialFramesInTempOutputBuffer;
+    current.inputUnderflows = totals->inputUnderflows;
+    current.inputOverflows = totals->inputOverflows;
+    current.outputUnderflows = totals->outputUnderflows;
+    current.outputOverflows = totals->outputOverflows;
 
-    if( bp->framesInTempInputBuffer > 0 )
-    {
-        tempInputBufferSize =
-            bp->framesPerTempBuffer * bp->bytesPerUserInputSample * bp->inputChannelCount;
-        memset( bp->tempInputBuffer, 0, tempInputBufferSize );
-    }
+    xrunCounts->inputUnderflows = current.inputUnderflows - bp->xrunCountsRead.inputUnderflows;
+    xrunCounts->inputOverflows = current.inputOverflows - bp->xrunCountsRead.inputOverflows;
+    xrunCounts->outputUnderflows = current.outputUnderflows - bp->xrunCountsRead.outputUnderflows;
+    xrunCounts->outputOverflows = current.outputOverflows - bp->xrunCountsRead.outputOverflows;
 
-    if( bp->framesInTempOutputBuffer > 0 )
-    {
-        tempOutputBufferSize =
-            bp->framesPerTempBuffer * bp->bytesPerUserOutputSample * bp->outputChannelCount;
-        memset( bp->tempOutputBuffer, 0, tempOutputBufferSize );
-    }
+    bp->xrunCountsRead = current;
 }
 
 
-unsigned long PaUtil_GetBufferProcessorInputLatencyFrames( PaUtilBufferProcessor* bp )
+void PaUtil_SetHostInputBufferIsWritable( PaUtilBufferProcessor* bp, int isWritable )
 {
-    return bp->initialFramesInTempInputBuffer;
+    bp->hostInputBufferIsWritable = isWritable ? 1 : 0;
 }
 
 
-unsigned long PaUtil_GetBufferProcessorOutputLatencyFrames( PaUtilBufferProcessor* bp )
+PaStreamInfoFlags PaUtil_GetBufferProcessorStreamInfoFlags( PaUtilBufferProcessor* bp )
 {
-    return bp->initialFramesInTempOutputBuffer;
+    /* the stream callback never sees the host buffers through a resampling
+        stage, whose buffers are not aligned either */
+    if( bp->resamplingStage )
+        return paStreamInfoSampleRateConverted;
+
+    return *(volatile PaStreamInfoFlags*)&bp->passThroughFlags | paStreamInfoAlignedBuffers;
 }
 
 
@@ -692,12 +1341,351 @@ void PaUtil_BeginBufferProcessing( PaUtilBufferProcessor* bp,
     bp->timeInfo->outputBufferDacTime += bp->framesInTempOutputBuffer * bp->samplePeriod;
 
     bp->callbackStatusFlags = callbackStatusFlags;
+    PaUtil_CountBufferProcessorXruns( bp, callbackStatusFlags );
+
+    if( bp->outputChannelCount > 0 )
+        UpdateOutputGain( bp );
 
     bp->hostInputFrameCount[1] = 0;
     bp->hostOutputFrameCount[1] = 0;
 }
 
 
+/*
+    SetUserChannels() describes channelCount channels of a user buffer which
+    start channelStrideBytes apart in channels.
+*/
+static void SetUserChannels( PaUtilChannelDescriptor *channels, unsigned int channelCount,
+        unsigned char *bytePtr, unsigned int sampleStrideSamples, unsigned int channelStrideBytes )
+{
+    unsigned int i;
+
+    for( i=0; i<channelCount; ++i )
+    {
+        channels[i].data = bytePtr;
+        channels[i].stride = sampleStrideSamples;
+
+        bytePtr += channelStrideBytes;
+    }
+}
+
+
+/*
+    SetInPlaceChannels() describes channelCount user channels which are the
+    host channels themselves, for converting the host buffer in place.
+*/
+static void SetInPlaceChannels( PaUtilChannelDescriptor *channels,
+        PaUtilChannelDescriptor *hostChannels, unsigned int channelCount )
+{
+    unsigned int i;
+
+    for( i=0; i<channelCount; ++i )
+    {
+        channels[i].data = hostChannels[i].data;
+        channels[i].stride = hostChannels[i].stride;
+    }
+}
+
+
+/*
+    ConvertInputChannels() converts frameCount frames from the host input
+    channels into the user channels described by bp->userInputChannels, and
+    advances the host channel pointers. Samples clipped by the converter are
+    added to bp->inputClippedSampleCount.
+*/
+static void ConvertInputChannels( PaUtilBufferProcessor *bp,
+        PaUtilChannelDescriptor *hostInputChannels, unsigned long frameCount )
+{
+    unsigned int i;
+
+    if( bp->inputDitherGenerators )
+    {
+        for( i=0; i<bp->inputChannelCount; ++i )
+        {
+            bp->inputConverter( bp->userInputChannels[i].data, bp->userInputChannels[i].stride,
+                    hostInputChannels[i].data, hostInputChannels[i].stride,
+                    frameCount, &bp->inputDitherGenerators[i] );
+            bp->inputClippedSampleCount += bp->inputDitherGenerators[i].clippedSampleCount;
+            bp->inputDitherGenerators[i].clippedSampleCount = 0;
+        }
+    }
+    else
+    {
+        PaUtil_ConvertChannels( bp->userInputSampleFormatIsEqualToHost ? NULL : bp->inputConverter,
+                bp->userInputChannels, bp->bytesPerUserInputSample,
+                hostInputChannels, bp->bytesPerHostInputSample,
+                bp->inputChannelCount, frameCount, &bp->ditherGenerator );
+        bp->inputClippedSampleCount += bp->ditherGenerator.clippedSampleCount;
+        bp->ditherGenerator.clippedSampleCount = 0;
+    }
+
+    for( i=0; i<bp->inputChannelCount; ++i )
+    {
+        /* advance src ptr for next iteration */
+        hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
+                frameCount * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
+    }
+}
+
+
+/*
+    ConvertOutputChannelInBlocks() converts frameCount frames of host channel
+    hostChannel from paFloat32 blocks. A block holds the user channel source,
+    or for PA_MATRIX_MIXED_ the sum of the user channels weighted by the row
+    of bp->outputChannelMatrix, times the gain when applyGain is set. Mixing
+    requires paFloat32 user output, other user formats are converted to
+    paFloat32 first.
+*/
+static void ConvertOutputChannelInBlocks( PaUtilBufferProcessor *bp, unsigned int hostChannel,
+        int source, PaUtilChannelDescriptor *hostOutputChannel, unsigned long frameCount,
+        PaUtilTriangularDitherGenerator *ditherGenerator, int applyGain )
+{
+    PaUtilConverter *converter = bp->userOutputIsFloat32 ? bp->outputConverter : bp->outputGainConverter;
+    unsigned char *destination = (unsigned char*)hostOutputChannel->data;
+    float block[ PA_OUTPUT_BLOCK_FRAMES_ ];
+    unsigned long frame, framesInBlock, rampFramesInBlock, i;
+    unsigned int u;
+    float gain;
+
+    for( frame = 0; frame < frameCount; frame += framesInBlock )
+    {
+        framesInBlock = PA_MIN_( frameCount - frame, PA_OUTPUT_BLOCK_FRAMES_ );
+
+        if( source == PA_MATRIX_MIXED_ )
+        {
+            const float *row = &bp->outputChannelMatrix[ hostChannel * bp->userOutputChannelCount ];
+            int isFirstSource = 1;
+
+            for( u=0; u < bp->userOutputChannelCount; ++u )
+            {
+                unsigned int stride = bp->userOutputChannels[u].stride;
+                const float *sourceSamples = (const float*)bp->userOutputChannels[u].data + frame * stride;
+
+                gain = row[u];
+                if( gain == 0.f )
+                    continue;
+
+                if( isFirstSource )
+                {
+                    for( i=0; i < framesInBlock; ++i )
+                        block[i] = gain * sourceSamples[ i * stride ];
+                    isFirstSource = 0;
+                }
+                else
+                {
+                    for( i=0; i < framesInBlock; ++i )
+                        block[i] += gain * sourceSamples[ i * stride ];
+                }
+            }
+        }
+        else
+        {
+            unsigned int stride = bp->userOutputChannels[source].stride;
+            unsigned char *sourceBytes = (unsigned char*)bp->userOutputChannels[source].data
+                    + frame * stride * bp->bytesPerUserOutputSample;
+
+            if( bp->userOutputIsFloat32 )
+            {
+                for( i=0; i < framesInBlock; ++i )
+                    block[i] = ((const float*)sourceBytes)[ i * stride ];
+            }
+            else
+            {
+                bp->outputGainSourceConverter( block, 1, sourceBytes, stride, framesInBlock, ditherGenerator );
+            }
+        }
+
+        if( applyGain )
+        {
+            /* frames before the end of the ramp are interpolated, the last
+                frame of the ramp has the target gain */
+            rampFramesInBlock = 0;
+            if( bp->outputGainRampFrames > frame )
+                rampFramesInBlock = PA_MIN_( bp->outputGainRampFrames - frame, framesInBlock );
+
+            for( i=0; i < rampFramesInBlock; ++i )
+                block[i] *= bp->outputGain + bp->outputGainStep * (float)(frame + i + 1);
+
+            gain = bp->outputGainTarget;
+            for( ; i < framesInBlock; ++i )
+                block[i] *= gain;
+        }
+
+        converter( destination, hostOutputChannel->stride, block, 1, framesInBlock, ditherGenerator );
+
+        destination += framesInBlock * hostOutputChannel->stride * bp->bytesPerHostOutputSample;
+    }
+}
+
+
+/*
+    ConvertOutputChannels() converts frameCount frames from the user channels
+    described by bp->userOutputChannels into the host output channels, and
+    advances the host channel pointers. Samples clipped by the converter are
+    added to bp->outputClippedSampleCount. The output gain is applied and its
+    ramp advanced, unless the gain is 1.
+*/
+static void ConvertOutputChannels( PaUtilBufferProcessor *bp,
+        PaUtilChannelDescriptor *hostOutputChannels, unsigned long frameCount )
+{
+    PaUtilTriangularDitherGenerator *ditherGenerator;
+    unsigned int i;
+    int source;
+    int isSilent = bp->outputGainIsActive && bp->outputGain == 0.f && bp->outputGainRampFrames == 0;
+
+    if( bp->outputChannelSources || bp->outputGainIsActive )
+    {
+        /* route through the channel matrix, the conversion of each host
+            channel reads only the user channels its row refers to */
+        for( i=0; i<bp->outputChannelCount; ++i )
+        {
+            ditherGenerator = bp->outputDitherGenerators
+                    ? &bp->outputDitherGenerators[i] : &bp->ditherGenerator;
+            source = bp->outputChannelSources ? bp->outputChannelSources[i] : (int)i;
+
+            if( source == PA_MATRIX_SILENT_ || isSilent )
+            {
+                bp->outputZeroer( hostOutputChannels[i].data, hostOutputChannels[i].stride, frameCount );
+            }
+            else if( source == PA_MATRIX_MIXED_ || bp->outputGainIsActive )
+            {
+                ConvertOutputChannelInBlocks( bp, i, source, &hostOutputChannels[i], frameCount,
+                        ditherGenerator, bp->outputGainIsActive );
+            }
+            else
+            {
+                bp->outputConverter( hostOutputChannels[i].data, hostOutputChannels[i].stride,
+                        bp->userOutputChannels[source].data, bp->userOutputChannels[source].stride,
+                        frameCount, ditherGenerator );
+            }
+
+            bp->outputClippedSampleCount += ditherGenerator->clippedSampleCount;
+            ditherGenerator->clippedSampleCount = 0;
+        }
+
+        AdvanceOutputGain( bp, frameCount );
+    }
+    else if( bp->outputDitherGenerators )
+    {
+        for( i=0; i<bp->outputChannelCount; ++i )
+        {
+            bp->outputConverter( hostOutputChannels[i].data, hostOutputChannels[i].stride,
+                    bp->userOutputChannels[i].data, bp->userOutputChannels[i].stride,
+                    frameCount, &bp->outputDitherGenerators[i] );
+            bp->outputClippedSampleCount += bp->outputDitherGenerators[i].clippedSampleCount;
+            bp->outputDitherGenerators[i].clippedSampleCount = 0;
+        }
+    }
+    else
+    {
+        PaUtil_ConvertChannels( bp->userOutputSampleFormatIsEqualToHost ? NULL : bp->outputConverter,
+                hostOutputChannels, bp->bytesPerHostOutputSample,
+                bp->userOutputChannels, bp->bytesPerUserOutputSample,
+                bp->outputChannelCount, frameCount, &bp->ditherGenerator );
+        bp->outputClippedSampleCount += bp->ditherGenerator.clippedSampleCount;
+        bp->ditherGenerator.clippedSampleCount = 0;
+    }
+
+    for( i=0; i<bp->outputChannelCount; ++i )
+    {
+        /* advance dest ptr for next iteration */
+        hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
+                frameCount * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
+    }
+}
+
+
+/*
+    IsWholeUserBuffers() returns non-zero when a half duplex host buffer of
+    framesToProcess frames holds a whole number of user buffers and no frames
+    are waiting in the temp buffer, so that NonAdaptingProcess() can pass it
+    to the callback in place of the adapting processor.
+*/
+static int IsWholeUserBuffers( PaUtilBufferProcessor *bp, unsigned long framesInTempBuffer,
+        unsigned long framesToProcess, int streamCallbackResult )
+{
+    return streamCallbackResult == paContinue && framesInTempBuffer == 0
+            && framesToProcess != 0 && framesToProcess % bp->framesPerUserBuffer == 0;
+}
+
+
+/* The arguments of a call of the channel group callbacks, shared by the
+    threads which run the groups. */
+typedef struct ChannelGroupCall
+{
+    PaUtilBufferProcessor *bp;
+    const void * const *userInput;
+    void * const *userOutput;
+    unsigned long frameCount;
+}
+ChannelGroupCall;
+
+
+static void RunChannelGroup( void *context, unsigned int groupIndex )
+{
+    ChannelGroupCall *call = (ChannelGroupCall*)context;
+    PaUtilBufferProcessor *bp = call->bp;
+    unsigned int firstChannel = groupIndex * bp->channelsPerGroup;
+    PaStreamChannelGroup group;
+
+    group.groupIndex = groupIndex;
+
+    group.firstInputChannel = firstChannel;
+    group.inputChannelCount = 0;
+    group.input = 0;
+    if( call->userInput && firstChannel < bp->inputChannelCount )
+    {
+        group.inputChannelCount = PA_MIN_( bp->channelsPerGroup, bp->inputChannelCount - firstChannel );
+        group.input = call->userInput + firstChannel;
+    }
+
+    group.firstOutputChannel = firstChannel;
+    group.outputChannelCount = 0;
+    group.output = 0;
+    if( call->userOutput && firstChannel < bp->userOutputChannelCount )
+    {
+        group.outputChannelCount = PA_MIN_( bp->channelsPerGroup, bp->userOutputChannelCount - firstChannel );
+        group.output = call->userOutput + firstChannel;
+    }
+
+    bp->channelGroupResults[groupIndex] = bp->channelGroupCallback( &group, call->frameCount,
+            bp->timeInfo, bp->callbackStatusFlags, bp->userData );
+}
+
+
+/*
+    CallStreamCallback() calls the stream callback, or the channel group
+    callbacks in parallel when they are set. All groups have returned when
+    it returns, so the caller may go on to convert the output.
+*/
+static int CallStreamCallback( PaUtilBufferProcessor *bp,
+        const void *userInput, void *userOutput, unsigned long frameCount )
+{
+    ChannelGroupCall call;
+    int result = paContinue;
+    unsigned int i;
+
+    if( !bp->channelGroupCallback )
+    {
+        return bp->streamCallback( userInput, userOutput,
+                frameCount, bp->timeInfo, bp->callbackStatusFlags, bp->userData );
+    }
+
+    call.bp = bp;
+    call.userInput = (const void * const *)userInput;
+    call.userOutput = (void * const *)userOutput;
+    call.frameCount = frameCount;
+
+    PaUtil_RunWorkerPool( bp->workerPool, RunChannelGroup, &call, bp->channelGroupCount );
+
+    /* paContinue < paComplete < paAbort */
+    for( i=0; i < bp->channelGroupCount; ++i )
+        result = PA_MAX_( result, bp->channelGroupResults[i] );
+
+    return result;
+}
+
+
 /*
     NonAdaptingProcess() is a simple buffer copying adaptor that can handle
     both full and half duplex copies. It processes framesToProcess frames,
@@ -723,8 +1711,14 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
     unsigned long frameCount;
     unsigned long framesToGo = framesToProcess;
     unsigned long framesProcessed = 0;
-    int skipOutputConvert = 0;
-    int skipInputConvert = 0;
+    int skipOutputConvert;
+    int skipInputConvert;
+    int convertInputInPlace; /* the host input buffer is passed to the callback after being converted */
+    int convertOutputInPlace; /* the callback writes into the host output buffer, which is then converted */
+    int inputIsPassedThrough = bp->userInputSampleFormatIsEqualToHost
+            || ( bp->userInputConvertsInPlace && bp->hostInputBufferIsWritable );
+    int outputIsPassedThrough = !bp->outputChannelSources && !bp->outputGainIsActive
+            && ( bp->userOutputSampleFormatIsEqualToHost || bp->userOutputConvertsInPlace );
 
 
     if( *streamCallbackResult == paContinue )
@@ -733,6 +1727,13 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
         {
             frameCount = PA_MIN_( bp->framesPerTempBuffer, framesToGo );
 
+            /* the alignment of the host buffers is checked again for every
+                user buffer, so the previous one's decisions don't carry over */
+            skipInputConvert = 0;
+            skipOutputConvert = 0;
+            convertInputInPlace = 0;
+            convertOutputInPlace = 0;
+
             /* configure user input buffer and convert input data (host -> user) */
             if( bp->inputChannelCount == 0 )
             {
@@ -751,12 +1752,14 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
 
                     /* process host buffer directly, or use temp buffer if formats differ or host buffer non-interleaved,
                      * or if num channels differs between the host (set in stride) and the user (eg with some Alsa hw:) */
-                    if( bp->userInputSampleFormatIsEqualToHost && bp->hostInputIsInterleaved
-                        && bp->hostInputChannels[0][0].data && bp->inputChannelCount == hostInputChannels[0].stride )
+                    if( inputIsPassedThrough && bp->hostInputIsInterleaved
+                        && bp->hostInputChannels[0][0].data && bp->inputChannelCount == hostInputChannels[0].stride
+                        && IsAligned( hostInputChannels[0].data ) )
                     {
                         userInput = hostInputChannels[0].data;
                         destBytePtr = (unsigned char *)hostInputChannels[0].data;
                         skipInputConvert = 1;
+                        convertInputInPlace = !bp->userInputSampleFormatIsEqualToHost;
                     }
                     else
                     {
@@ -766,23 +1769,25 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                 else /* user input is not interleaved */
                 {
                     destSampleStrideSamples = 1;
-                    destChannelStrideBytes = frameCount * bp->bytesPerUserInputSample;
+                    destChannelStrideBytes = TempChannelBytes( frameCount, bp->bytesPerUserInputSample );
 
                     /* setup non-interleaved ptrs */
-                    if( bp->userInputSampleFormatIsEqualToHost && !bp->hostInputIsInterleaved && bp->hostInputChannels[0][0].data )
+                    if( inputIsPassedThrough && !bp->hostInputIsInterleaved && bp->hostInputChannels[0][0].data
+                            && ChannelsAreAligned( hostInputChannels, bp->inputChannelCount ) )
                     {
                         for( i=0; i<bp->inputChannelCount; ++i )
                         {
                             bp->tempInputBufferPtrs[i] = hostInputChannels[i].data;
                         }
                         skipInputConvert = 1;
+                        convertInputInPlace = !bp->userInputSampleFormatIsEqualToHost;
                     }
                     else
                     {
                         for( i=0; i<bp->inputChannelCount; ++i )
                         {
                             bp->tempInputBufferPtrs[i] = ((unsigned char*)bp->tempInputBuffer) +
-                                i * bp->bytesPerUserInputSample * frameCount;
+                                i * TempChannelBytes( frameCount, bp->bytesPerUserInputSample );
                         }
                     }
 
@@ -802,7 +1807,12 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                 }
                 else
                 {
-                    if( skipInputConvert )
+                    if( convertInputInPlace )
+                    {
+                        SetInPlaceChannels( bp->userInputChannels, hostInputChannels, bp->inputChannelCount );
+                        ConvertInputChannels( bp, hostInputChannels, frameCount );
+                    }
+                    else if( skipInputConvert )
                     {
                         for( i=0; i<bp->inputChannelCount; ++i )
                         {
@@ -813,19 +1823,9 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                     }
                     else
                     {
-                        for( i=0; i<bp->inputChannelCount; ++i )
-                        {
-                            bp->inputConverter( destBytePtr, destSampleStrideSamples,
-                                                    hostInputChannels[i].data,
-                                                    hostInputChannels[i].stride,
-                                                    frameCount, &bp->ditherGenerator );
-
-                            destBytePtr += destChannelStrideBytes;  /* skip to next destination channel */
-
-                            /* advance src ptr for next iteration */
-                            hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
-                                    frameCount * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
-                        }
+                        SetUserChannels( bp->userInputChannels, bp->inputChannelCount,
+                                destBytePtr, destSampleStrideSamples, destChannelStrideBytes );
+                        ConvertInputChannels( bp, hostInputChannels, frameCount );
                     }
                 }
             }
@@ -842,11 +1842,13 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                 {
                     /* process host buffer directly, or use temp buffer if formats differ or host buffer non-interleaved,
                      * or if num channels differs between the host (set in stride) and the user (eg with some Alsa hw:) */
-                    if( bp->userOutputSampleFormatIsEqualToHost && bp->hostOutputIsInterleaved
-                            && bp->outputChannelCount == hostOutputChannels[0].stride )
+                    if( outputIsPassedThrough && bp->hostOutputIsInterleaved
+                            && bp->outputChannelCount == hostOutputChannels[0].stride
+                            && IsAligned( hostOutputChannels[0].data ) )
                     {
                         userOutput = hostOutputChannels[0].data;
                         skipOutputConvert = 1;
+                        convertOutputInPlace = !bp->userOutputSampleFormatIsEqualToHost;
                     }
                     else
                     {
@@ -855,20 +1857,22 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                 }
                 else /* user output is not interleaved */
                 {
-                    if( bp->userOutputSampleFormatIsEqualToHost && !bp->hostOutputIsInterleaved )
+                    if( outputIsPassedThrough && !bp->hostOutputIsInterleaved
+                            && ChannelsAreAligned( hostOutputChannels, bp->outputChannelCount ) )
                     {
                         for( i=0; i<bp->outputChannelCount; ++i )
                         {
                             bp->tempOutputBufferPtrs[i] = hostOutputChannels[i].data;
                         }
                         skipOutputConvert = 1;
+                        convertOutputInPlace = !bp->userOutputSampleFormatIsEqualToHost;
                     }
                     else
                     {
-                        for( i=0; i<bp->outputChannelCount; ++i )
+                        for( i=0; i<bp->userOutputChannelCount; ++i )
                         {
                             bp->tempOutputBufferPtrs[i] = ((unsigned char*)bp->tempOutputBuffer) +
-                                i * bp->bytesPerUserOutputSample * frameCount;
+                                i * TempChannelBytes( frameCount, bp->bytesPerUserOutputSample );
                         }
                     }
 
@@ -876,8 +1880,10 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                 }
             }
 
-            *streamCallbackResult = bp->streamCallback( userInput, userOutput,
-                    frameCount, bp->timeInfo, bp->callbackStatusFlags, bp->userData );
+            bp->passThroughFlags = ( skipInputConvert ? paStreamInfoInputPassThrough : 0 )
+                    | ( skipOutputConvert ? paStreamInfoOutputPassThrough : 0 );
+
+            *streamCallbackResult = CallStreamCallback( bp, userInput, userOutput, frameCount );
 
             if( *streamCallbackResult == paAbort )
             {
@@ -893,7 +1899,12 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
 
                 if( bp->outputChannelCount != 0 && bp->hostOutputChannels[0][0].data )
                 {
-                    if( skipOutputConvert )
+                    if( convertOutputInPlace )
+                    {
+                        SetInPlaceChannels( bp->userOutputChannels, hostOutputChannels, bp->outputChannelCount );
+                        ConvertOutputChannels( bp, hostOutputChannels, frameCount );
+                    }
+                    else if( skipOutputConvert )
                     {
                         for( i=0; i<bp->outputChannelCount; ++i )
                         {
@@ -909,28 +1920,18 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
 
                         if( bp->userOutputIsInterleaved )
                         {
-                            srcSampleStrideSamples = bp->outputChannelCount;
+                            srcSampleStrideSamples = bp->userOutputChannelCount;
                             srcChannelStrideBytes = bp->bytesPerUserOutputSample;
                         }
                         else /* user output is not interleaved */
                         {
                             srcSampleStrideSamples = 1;
-                            srcChannelStrideBytes = frameCount * bp->bytesPerUserOutputSample;
+                            srcChannelStrideBytes = TempChannelBytes( frameCount, bp->bytesPerUserOutputSample );
                         }
 
-                        for( i=0; i<bp->outputChannelCount; ++i )
-                        {
-                            bp->outputConverter(    hostOutputChannels[i].data,
-                                                    hostOutputChannels[i].stride,
-                                                    srcBytePtr, srcSampleStrideSamples,
-                                                    frameCount, &bp->ditherGenerator );
-
-                            srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
-
-                            /* advance dest ptr for next iteration */
-                            hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
-                                        frameCount * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
-                        }
+                        SetUserChannels( bp->userOutputChannels, bp->userOutputChannelCount,
+                                srcBytePtr, srcSampleStrideSamples, srcChannelStrideBytes );
+                        ConvertOutputChannels( bp, hostOutputChannels, frameCount );
                     }
                 }
 
@@ -1016,31 +2017,21 @@ static unsigned long AdaptingInputOnlyProcess( PaUtilBufferProcessor *bp,
                     bp->bytesPerUserInputSample * bp->framesInTempInputBuffer;
 
             destSampleStrideSamples = 1;
-            destChannelStrideBytes = bp->framesPerUserBuffer * bp->bytesPerUserInputSample;
+            destChannelStrideBytes = TempChannelBytes( bp->framesPerUserBuffer, bp->bytesPerUserInputSample );
 
             /* setup non-interleaved ptrs */
             for( i=0; i<bp->inputChannelCount; ++i )
             {
                 bp->tempInputBufferPtrs[i] = ((unsigned char*)bp->tempInputBuffer) +
-                    i * bp->bytesPerUserInputSample * bp->framesPerUserBuffer;
+                    i * TempChannelBytes( bp->framesPerUserBuffer, bp->bytesPerUserInputSample );
             }
 
             userInput = bp->tempInputBufferPtrs;
         }
 
-        for( i=0; i<bp->inputChannelCount; ++i )
-        {
-            bp->inputConverter( destBytePtr, destSampleStrideSamples,
-                                    hostInputChannels[i].data,
-                                    hostInputChannels[i].stride,
-                                    frameCount, &bp->ditherGenerator );
-
-            destBytePtr += destChannelStrideBytes;  /* skip to next destination channel */
-
-            /* advance src ptr for next iteration */
-            hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
-                    frameCount * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
-        }
+        SetUserChannels( bp->userInputChannels, bp->inputChannelCount,
+                destBytePtr, destSampleStrideSamples, destChannelStrideBytes );
+        ConvertInputChannels( bp, hostInputChannels, frameCount );
 
         bp->framesInTempInputBuffer += frameCount;
 
@@ -1058,9 +2049,8 @@ static unsigned long AdaptingInputOnlyProcess( PaUtilBufferProcessor *bp,
             {
                 bp->timeInfo->outputBufferDacTime = 0;
 
-                *streamCallbackResult = bp->streamCallback( userInput, userOutput,
-                        bp->framesPerUserBuffer, bp->timeInfo,
-                        bp->callbackStatusFlags, bp->userData );
+                *streamCallbackResult = CallStreamCallback( bp, userInput, userOutput,
+                        bp->framesPerUserBuffer );
 
                 bp->timeInfo->inputBufferAdcTime += bp->framesPerUserBuffer * bp->samplePeriod;
             }
@@ -1109,10 +2099,10 @@ static unsigned long AdaptingOutputOnlyProcess( PaUtilBufferProcessor *bp,
             }
             else /* user output is not interleaved */
             {
-                for( i = 0; i < bp->outputChannelCount; ++i )
+                for( i = 0; i < bp->userOutputChannelCount; ++i )
                 {
                     bp->tempOutputBufferPtrs[i] = ((unsigned char*)bp->tempOutputBuffer) +
-                            i * bp->framesPerUserBuffer * bp->bytesPerUserOutputSample;
+                            i * TempChannelBytes( bp->framesPerUserBuffer, bp->bytesPerUserOutputSample );
                 }
 
                 userOutput = bp->tempOutputBufferPtrs;
@@ -1120,9 +2110,8 @@ static unsigned long AdaptingOutputOnlyProcess( PaUtilBufferProcessor *bp,
 
             bp->timeInfo->inputBufferAdcTime = 0;
 
-            *streamCallbackResult = bp->streamCallback( userInput, userOutput,
-                    bp->framesPerUserBuffer, bp->timeInfo,
-                    bp->callbackStatusFlags, bp->userData );
+            *streamCallbackResult = CallStreamCallback( bp, userInput, userOutput,
+                    bp->framesPerUserBuffer );
 
             if( *streamCallbackResult == paAbort )
             {
@@ -1145,10 +2134,10 @@ static unsigned long AdaptingOutputOnlyProcess( PaUtilBufferProcessor *bp,
             if( bp->userOutputIsInterleaved )
             {
                 srcBytePtr = ((unsigned char*)bp->tempOutputBuffer) +
-                        bp->bytesPerUserOutputSample * bp->outputChannelCount *
+                        bp->bytesPerUserOutputSample * bp->userOutputChannelCount *
                         (bp->framesPerUserBuffer - bp->framesInTempOutputBuffer);
 
-                srcSampleStrideSamples = bp->outputChannelCount;
+                srcSampleStrideSamples = bp->userOutputChannelCount;
                 srcChannelStrideBytes = bp->bytesPerUserOutputSample;
             }
             else /* user output is not interleaved */
@@ -1158,22 +2147,12 @@ static unsigned long AdaptingOutputOnlyProcess( PaUtilBufferProcessor *bp,
                         (bp->framesPerUserBuffer - bp->framesInTempOutputBuffer);
 
                 srcSampleStrideSamples = 1;
-                srcChannelStrideBytes = bp->framesPerUserBuffer * bp->bytesPerUserOutputSample;
+                srcChannelStrideBytes = TempChannelBytes( bp->framesPerUserBuffer, bp->bytesPerUserOutputSample );
             }
 
-            for( i=0; i<bp->outputChannelCount; ++i )
-            {
-                bp->outputConverter(    hostOutputChannels[i].data,
-                                        hostOutputChannels[i].stride,
-                                        srcBytePtr, srcSampleStrideSamples,
-                                        frameCount, &bp->ditherGenerator );
-
-                srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
-
-                /* advance dest ptr for next iteration */
-                hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
-                        frameCount * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
-            }
+            SetUserChannels( bp->userOutputChannels, bp->userOutputChannelCount,
+                    srcBytePtr, srcSampleStrideSamples, srcChannelStrideBytes );
+            ConvertOutputChannels( bp, hostOutputChannels, frameCount );
 
             bp->framesInTempOutputBuffer -= frameCount;
         }
@@ -1219,7 +2198,6 @@ static void CopyTempOutputBuffersToHostOutputBuffers( PaUtilBufferProcessor *bp)
     unsigned char *srcBytePtr;
     unsigned int srcSampleStrideSamples; /* stride from one sample to the next within a channel, in samples */
     unsigned int srcChannelStrideBytes; /* stride from one channel to the next, in bytes */
-    unsigned int i;
 
     /* copy frames from user to host output buffers */
     while( bp->framesInTempOutputBuffer > 0 &&
@@ -1242,10 +2220,10 @@ static void CopyTempOutputBuffersToHostOutputBuffers( PaUtilBufferProcessor *bp)
         if( bp->userOutputIsInterleaved )
         {
             srcBytePtr = ((unsigned char*)bp->tempOutputBuffer) +
-                    bp->bytesPerUserOutputSample * bp->outputChannelCount *
+                    bp->bytesPerUserOutputSample * bp->userOutputChannelCount *
                     (bp->framesPerUserBuffer - bp->framesInTempOutputBuffer);
 
-            srcSampleStrideSamples = bp->outputChannelCount;
+            srcSampleStrideSamples = bp->userOutputChannelCount;
             srcChannelStrideBytes = bp->bytesPerUserOutputSample;
         }
         else /* user output is not interleaved */
@@ -1255,23 +2233,13 @@ static void CopyTempOutputBuffersToHostOutputBuffers( PaUtilBufferProcessor *bp)
                     (bp->framesPerUserBuffer - bp->framesInTempOutputBuffer);
 
             srcSampleStrideSamples = 1;
-            srcChannelStrideBytes = bp->framesPerUserBuffer * bp->bytesPerUserOutputSample;
+            srcChannelStrideBytes = TempChannelBytes( bp->framesPerUserBuffer, bp->bytesPerUserOutputSample );
         }
 
-        for( i=0; i<bp->outputChannelCount; ++i )
-        {
-            assert( hostOutputChannels[i].data != NULL );
-            bp->outputConverter(    hostOutputChannels[i].data,
-                                    hostOutputChannels[i].stride,
-                                    srcBytePtr, srcSampleStrideSamples,
-                                    frameCount, &bp->ditherGenerator );
-
-            srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
-
-            /* advance dest ptr for next iteration */
-            hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
-                    frameCount * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
-        }
+        assert( hostOutputChannels[0].data != NULL );
+        SetUserChannels( bp->userOutputChannels, bp->userOutputChannelCount,
+                srcBytePtr, srcSampleStrideSamples, srcChannelStrideBytes );
+        ConvertOutputChannels( bp, hostOutputChannels, frameCount );
 
         if( bp->hostOutputFrameCount[0] > 0 )
             bp->hostOutputFrameCount[0] -= frameCount;
@@ -1383,22 +2351,12 @@ static unsigned long AdaptingProcess( PaUtilBufferProcessor *bp,
                         bp->bytesPerUserInputSample * bp->framesInTempInputBuffer;
 
                 destSampleStrideSamples = 1;
-                destChannelStrideBytes = bp->framesPerUserBuffer * bp->bytesPerUserInputSample;
+                destChannelStrideBytes = TempChannelBytes( bp->framesPerUserBuffer, bp->bytesPerUserInputSample );
             }
 
-            for( i=0; i<bp->inputChannelCount; ++i )
-            {
-                bp->inputConverter( destBytePtr, destSampleStrideSamples,
-                                        hostInputChannels[i].data,
-                                        hostInputChannels[i].stride,
-                                        frameCount, &bp->ditherGenerator );
-
-                destBytePtr += destChannelStrideBytes;  /* skip to next destination channel */
-
-                /* advance src ptr for next iteration */
-                hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
-                        frameCount * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
-            }
+            SetUserChannels( bp->userInputChannels, bp->inputChannelCount,
+                    destBytePtr, destSampleStrideSamples, destChannelStrideBytes );
+            ConvertInputChannels( bp, hostInputChannels, frameCount );
 
             if( bp->hostInputFrameCount[0] > 0 )
                 bp->hostInputFrameCount[0] -= frameCount;
@@ -1430,7 +2388,7 @@ static unsigned long AdaptingProcess( PaUtilBufferProcessor *bp,
                     for( i = 0; i < bp->inputChannelCount; ++i )
                     {
                         bp->tempInputBufferPtrs[i] = ((unsigned char*)bp->tempInputBuffer) +
-                                i * bp->framesPerUserBuffer * bp->bytesPerUserInputSample;
+                                i * TempChannelBytes( bp->framesPerUserBuffer, bp->bytesPerUserInputSample );
                     }
 
                     userInput = bp->tempInputBufferPtrs;
@@ -1443,10 +2401,10 @@ static unsigned long AdaptingProcess( PaUtilBufferProcessor *bp,
                 }
                 else /* user output is not interleaved */
                 {
-                    for( i = 0; i < bp->outputChannelCount; ++i )
+                    for( i = 0; i < bp->userOutputChannelCount; ++i )
                     {
                         bp->tempOutputBufferPtrs[i] = ((unsigned char*)bp->tempOutputBuffer) +
-                                i * bp->framesPerUserBuffer * bp->bytesPerUserOutputSample;
+                                i * TempChannelBytes( bp->framesPerUserBuffer, bp->bytesPerUserOutputSample );
                     }
 
                     userOutput = bp->tempOutputBufferPtrs;
@@ -1454,9 +2412,8 @@ static unsigned long AdaptingProcess( PaUtilBufferProcessor *bp,
 
                 /* call streamCallback */
 
-                *streamCallbackResult = bp->streamCallback( userInput, userOutput,
-                        bp->framesPerUserBuffer, bp->timeInfo,
-                        bp->callbackStatusFlags, bp->userData );
+                *streamCallbackResult = CallStreamCallback( bp, userInput, userOutput,
+                        bp->framesPerUserBuffer );
 
                 bp->timeInfo->inputBufferAdcTime += bp->framesPerUserBuffer * bp->samplePeriod;
                 bp->timeInfo->outputBufferDacTime += bp->framesPerUserBuffer * bp->samplePeriod;
@@ -1491,6 +2448,7 @@ unsigned long PaUtil_EndBufferProcessing( PaUtilBufferProcessor* bp, int *stream
 {
     unsigned long framesToProcess, framesToGo;
     unsigned long framesProcessed = 0;
+    int i;
 
     if( bp->inputChannelCount != 0 && bp->outputChannelCount != 0
             && bp->hostInputChannels[0][0].data /* input was supplied (see PaUtil_SetNoInput) */
@@ -1607,6 +2565,7 @@ unsigned long PaUtil_EndBufferProcessing( PaUtilBufferProcessor* bp, int *stream
     }
     else /* block adaption necessary*/
     {
+        bp->passThroughFlags = 0;
 
         if( bp->inputChannelCount != 0 && bp->outputChannelCount != 0 )
         {
@@ -1625,32 +2584,45 @@ unsigned long PaUtil_EndBufferProcessing( PaUtilBufferProcessor* bp, int *stream
         }
         else if( bp->inputChannelCount != 0 )
         {
-            /* input only */
-            framesToProcess = bp->hostInputFrameCount[0];
-
-            framesProcessed = AdaptingInputOnlyProcess( bp, streamCallbackResult,
-                        bp->hostInputChannels[0], framesToProcess );
-
-            framesToProcess = bp->hostInputFrameCount[1];
-            if( framesToProcess > 0 )
+            /* input only, host buffers which hold whole user buffers are
+                processed without going through the temp buffer */
+            for( i=0; i<2; ++i )
             {
-                framesProcessed += AdaptingInputOnlyProcess( bp, streamCallbackResult,
-                        bp->hostInputChannels[1], framesToProcess );
+                framesToProcess = bp->hostInputFrameCount[i];
+                if( i == 0 || framesToProcess > 0 )
+                {
+                    if( IsWholeUserBuffers( bp, bp->framesInTempInputBuffer, framesToProcess, *streamCallbackResult ) )
+                    {
+                        framesProcessed += NonAdaptingProcess( bp, streamCallbackResult,
+                                bp->hostInputChannels[i], 0, framesToProcess );
+                    }
+                    else
+                    {
+                        framesProcessed += AdaptingInputOnlyProcess( bp, streamCallbackResult,
+                                bp->hostInputChannels[i], framesToProcess );
+                    }
+                }
             }
         }
         else
         {
-            /* output only */
-            framesToProcess = bp->hostOutputFrameCount[0];
-
-            framesProcessed = AdaptingOutputOnlyProcess( bp, streamCallbackResult,
-                        bp->hostOutputChannels[0], framesToProcess );
-
-            framesToProcess = bp->hostOutputFrameCount[1];
-            if( framesToProcess > 0 )
+            /* output only, see above */
+            for( i=0; i<2; ++i )
             {
-                framesProcessed += AdaptingOutputOnlyProcess( bp, streamCallbackResult,
-                        bp->hostOutputChannels[1], framesToProcess );
+                framesToProcess = bp->hostOutputFrameCount[i];
+                if( i == 0 || framesToProcess > 0 )
+                {
+                    if( IsWholeUserBuffers( bp, bp->framesInTempOutputBuffer, framesToProcess, *streamCallbackResult ) )
+                    {
+                        framesProcessed += NonAdaptingProcess( bp, streamCallbackResult,
+                                0, bp->hostOutputChannels[i], framesToProcess );
+                    }
+                    else
+                    {
+                        framesProcessed += AdaptingOutputOnlyProcess( bp, streamCallbackResult,
+                                bp->hostOutputChannels[i], framesToProcess );
+                    }
+                }
             }
         }
     }
@@ -1686,19 +2658,9 @@ unsigned long PaUtil_CopyInput( PaUtilBufferProcessor* bp,
         destSampleStrideSamples = bp->inputChannelCount;
         destChannelStrideBytes = bp->bytesPerUserInputSample;
 
-        for( i=0; i<bp->inputChannelCount; ++i )
-        {
-            bp->inputConverter( destBytePtr, destSampleStrideSamples,
-                                hostInputChannels[i].data,
-                                hostInputChannels[i].stride,
-                                framesToCopy, &bp->ditherGenerator );
-
-            destBytePtr += destChannelStrideBytes;  /* skip to next dest channel */
-
-            /* advance source ptr for next iteration */
-            hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
-                    framesToCopy * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
-        }
+        SetUserChannels( bp->userInputChannels, bp->inputChannelCount,
+                destBytePtr, destSampleStrideSamples, destChannelStrideBytes );
+        ConvertInputChannels( bp, hostInputChannels, framesToCopy );
 
         /* advance callers dest pointer (buffer) */
         *buffer = ((unsigned char *)*buffer) +
@@ -1710,24 +2672,19 @@ unsigned long PaUtil_CopyInput( PaUtilBufferProcessor* bp,
 
         nonInterleavedDestPtrs = (void**)*buffer;
 
-        destSampleStrideSamples = 1;
-
         for( i=0; i<bp->inputChannelCount; ++i )
         {
-            destBytePtr = (unsigned char*)nonInterleavedDestPtrs[i];
+            bp->userInputChannels[i].data = nonInterleavedDestPtrs[i];
+            bp->userInputChannels[i].stride = 1;
+        }
 
-            bp->inputConverter( destBytePtr, destSampleStrideSamples,
-                                hostInputChannels[i].data,
-                                hostInputChannels[i].stride,
-                                framesToCopy, &bp->ditherGenerator );
+        ConvertInputChannels( bp, hostInputChannels, framesToCopy );
 
+        for( i=0; i<bp->inputChannelCount; ++i )
+        {
             /* advance callers dest pointer (nonInterleavedDestPtrs[i]) */
-            destBytePtr += bp->bytesPerUserInputSample * framesToCopy;
-            nonInterleavedDestPtrs[i] = destBytePtr;
-
-            /* advance source ptr for next iteration */
-            hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
-                    framesToCopy * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
+            nonInterleavedDestPtrs[i] = ((unsigned char*)nonInterleavedDestPtrs[i]) +
+                    bp->bytesPerUserInputSample * framesToCopy;
         }
     }
 
@@ -1750,30 +2707,22 @@ unsigned long PaUtil_CopyOutput( PaUtilBufferProcessor* bp,
     hostOutputChannels = bp->hostOutputChannels[0];
     framesToCopy = PA_MIN_( bp->hostOutputFrameCount[0], frameCount );
 
+    UpdateOutputGain( bp );
+
     if( bp->userOutputIsInterleaved )
     {
         srcBytePtr = (unsigned char*)*buffer;
 
-        srcSampleStrideSamples = bp->outputChannelCount;
+        srcSampleStrideSamples = bp->userOutputChannelCount;
         srcChannelStrideBytes = bp->bytesPerUserOutputSample;
 
-        for( i=0; i<bp->outputChannelCount; ++i )
-        {
-            bp->outputConverter(    hostOutputChannels[i].data,
-                                    hostOutputChannels[i].stride,
-                                    srcBytePtr, srcSampleStrideSamples,
-                                    framesToCopy, &bp->ditherGenerator );
-
-            srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
-
-            /* advance dest ptr for next iteration */
-            hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
-                    framesToCopy * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
-        }
+        SetUserChannels( bp->userOutputChannels, bp->userOutputChannelCount,
+                srcBytePtr, srcSampleStrideSamples, srcChannelStrideBytes );
+        ConvertOutputChannels( bp, hostOutputChannels, framesToCopy );
 
         /* advance callers source pointer (buffer) */
         *buffer = ((unsigned char *)*buffer) +
-                framesToCopy * bp->outputChannelCount * bp->bytesPerUserOutputSample;
+                framesToCopy * bp->userOutputChannelCount * bp->bytesPerUserOutputSample;
 
     }
     else
@@ -1782,25 +2731,19 @@ unsigned long PaUtil_CopyOutput( PaUtilBufferProcessor* bp,
 
         nonInterleavedSrcPtrs = (void**)*buffer;
 
-        srcSampleStrideSamples = 1;
-
-        for( i=0; i<bp->outputChannelCount; ++i )
+        for( i=0; i<bp->userOutputChannelCount; ++i )
         {
-            srcBytePtr = (unsigned char*)nonInterleavedSrcPtrs[i];
-
-            bp->outputConverter(    hostOutputChannels[i].data,
-                                    hostOutputChannels[i].stride,
-                                    srcBytePtr, srcSampleStrideSamples,
-                                    framesToCopy, &bp->ditherGenerator );
+            bp->userOutputChannels[i].data = nonInterleavedSrcPtrs[i];
+            bp->userOutputChannels[i].stride = 1;
+        }
 
+        ConvertOutputChannels( bp, hostOutputChannels, framesToCopy );
 
+        for( i=0; i<bp->userOutputChannelCount; ++i )
+        {
             /* advance callers source pointer (nonInterleavedSrcPtrs[i]) */
-            srcBytePtr += bp->bytesPerUserOutputSample * framesToCopy;
-            nonInterleavedSrcPtrs[i] = srcBytePtr;
-
-            /* advance dest ptr for next iteration */
-            hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
-                    framesToCopy * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
+            nonInterleavedSrcPtrs[i] = ((unsigned char*)nonInterleavedSrcPtrs[i]) +
+                    bp->bytesPerUserOutputSample * framesToCopy;
         }
     }
 
@@ -245,12 +245,22 @@ typedef struct PaUtilChannelDescriptor{
 }PaUtilChannelDescriptor;
 
 
+/** @brief The number of times each kind of xrun was reported to a buffer
+ processor, see PaUtil_CountBufferProcessorXruns(). */
+typedef struct PaUtilXrunCounts{
+    unsigned long inputUnderflows;
+    unsigned long inputOverflows;
+    unsigned long outputUnderflows;
+    unsigned long outputOverflows;
+}PaUtilXrunCounts;
+
+
 /** @brief The main buffer processor data structure.
 
  Allocate one of these, initialize it with PaUtil_InitializeBufferProcessor
  and terminate it with PaUtil_TerminateBufferProcessor.
 */
-typedef struct {
+typedef struct PaUtilBufferProcessor {
     unsigned long framesPerUserBuffer;
     unsigned long framesPerHostBuffer;
 
@@ -271,17 +281,25 @@ typedef struct {
     unsigned int bytesPerHostOutputSample;
     unsigned int bytesPerUserOutputSample;
     int userOutputIsInterleaved;
+    int userOutputIsFloat32;
     PaUtilConverter *outputConverter;
     PaUtilZeroer *outputZeroer;
 
     unsigned long initialFramesInTempInputBuffer;
     unsigned long initialFramesInTempOutputBuffer;
 
-    void *tempInputBuffer;          /**< used for slips, block adaption, and conversion. */
+    void *scratchMemory;            /**< the single allocation holding the temp buffers, the channel descriptors
+                                         and the per channel dither generators, each aligned to a cache line */
+
+    void *tempInputBuffer;          /**< used for slips, block adaption, and conversion. Non-interleaved
+                                         channels are padded to a whole number of cache lines */
+    unsigned long tempInputBufferSize; /**< in bytes, including the padding */
     void **tempInputBufferPtrs;     /**< storage for non-interleaved buffer pointers, NULL for interleaved user input */
     unsigned long framesInTempInputBuffer; /**< frames remaining in input buffer from previous adaption iteration */
 
-    void *tempOutputBuffer;         /**< used for slips, block adaption, and conversion. */
+    void *tempOutputBuffer;         /**< used for slips, block adaption, and conversion. Non-interleaved
+                                         channels are padded to a whole number of cache lines */
+    unsigned long tempOutputBufferSize; /**< in bytes, including the padding */
     void **tempOutputBufferPtrs;    /**< storage for non-interleaved buffer pointers, NULL for interleaved user output */
     unsigned long framesInTempOutputBuffer; /**< frames remaining in input buffer from previous adaption iteration */
 
@@ -296,6 +314,8 @@ typedef struct {
                                                         hostInputChannels[i].data is NULL when the caller
                                                         calls PaUtil_SetNoInput()
                                                         */
+    PaUtilChannelDescriptor *userInputChannels; /**< describes the user side of each conversion,
+                                                     shares its allocation with hostInputChannels */
     int hostOutputIsInterleaved;
     unsigned long hostOutputFrameCount[2];
     PaUtilChannelDescriptor *hostOutputChannels[2]; /**< pointers to arrays of channel descriptors.
@@ -303,13 +323,72 @@ typedef struct {
                                                          hostOutputChannels[i].data is NULL when the caller
                                                          calls PaUtil_SetNoOutput()
                                                          */
+    PaUtilChannelDescriptor *userOutputChannels; /**< describes the user side of each conversion,
+                                                      shares its allocation with hostOutputChannels */
+    unsigned int userOutputChannelCount; /**< the channels of the user output buffer, equal to
+                                              outputChannelCount unless a channel matrix is set */
+    float *outputChannelMatrix;     /**< see PaUtil_SetBufferProcessorOutputChannelMatrix(), outputChannelCount
+                                         rows of userOutputChannelCount gains, NULL when there is none */
+    int *outputChannelSources;      /**< for each host channel, the user channel copied to it, or
+                                         one of the PA_MATRIX_ values of pa_process.c */
+
+    float outputGain;               /**< the gain of the most recently converted output frame */
+    float outputGainTarget;         /**< the gain at the end of the ramp */
+    float outputGainStep;           /**< the change of the gain from one frame to the next during the ramp */
+    unsigned long outputGainRampFrames; /**< frames left until outputGainTarget is reached */
+    int outputGainIsActive;         /**< the gain is not 1 or is ramping, otherwise it is not applied */
+    PaUtilConverter *outputGainSourceConverter; /**< user format to paFloat32, NULL for paFloat32 user output */
+    PaUtilConverter *outputGainConverter; /**< paFloat32 to host format, used in place of outputConverter
+                                               while a gain is applied to user output which is not paFloat32 */
+    float outputMasterGain;         /**< see PaUtil_SetBufferProcessorOutputGain() */
+    unsigned long outputFadeInFrames; /**< see PaUtil_SetBufferProcessorOutputFades() */
+    unsigned long outputFadeOutFrames;
+    volatile unsigned long outputGainRequestCount; /**< twice the number of gain requests, odd while one
+                                                        is being written */
+    volatile float outputGainRequestTarget;
+    volatile unsigned long outputGainRequestFrames;
+    unsigned long outputGainRequestsSeen; /**< the request count when a request was last picked up */
+    unsigned long outputGainRampRequest; /**< the request which started the current ramp */
+    volatile unsigned long outputGainRequestsDone; /**< the most recent request whose ramp has ended */
 
     PaUtilTriangularDitherGenerator ditherGenerator;
+    PaUtilTriangularDitherGenerator *inputDitherGenerators; /**< one per channel when the input converter
+                                                                 shapes the noise, otherwise NULL */
+    PaUtilTriangularDitherGenerator *outputDitherGenerators; /**< one per channel when the output converter
+                                                                  shapes the noise, otherwise NULL */
+    unsigned long inputClippedSampleCount; /**< running totals of the samples clipped by the converters,
+                                                only written by the processing thread */
+    unsigned long outputClippedSampleCount;
+    unsigned long inputClippedSampleCountRead; /**< the totals at the previous call to
+                                                    PaUtil_ReadBufferProcessorClippedSampleCounts() */
+    unsigned long outputClippedSampleCountRead;
+    PaUtilXrunCounts xrunCounts; /**< running totals, only written by the processing thread */
+    PaUtilXrunCounts xrunCountsRead; /**< the totals at the previous call to
+                                          PaUtil_ReadBufferProcessorXrunCounts() */
+
+    int userInputConvertsInPlace; /**< the host input format is paInt32 and the user format paFloat32,
+                                       so the host buffer may be converted where it is */
+    int hostInputBufferIsWritable; /**< see PaUtil_SetHostInputBufferIsWritable() */
+    int userOutputConvertsInPlace; /**< the user output format is paFloat32 and the host format paInt32,
+                                        so the callback may write into the host buffer */
+    PaStreamInfoFlags passThroughFlags; /**< how the most recent host buffer was processed, a
+                                             combination of paStreamInfoInputPassThrough and
+                                             paStreamInfoOutputPassThrough */
 
     double samplePeriod;
 
     PaStreamCallback *streamCallback;
     void *userData;
+
+    PaStreamChannelGroupCallback *channelGroupCallback; /**< see PaUtil_SetBufferProcessorChannelGroupCallback(),
+                                                             NULL when streamCallback is called */
+    unsigned int channelsPerGroup;
+    unsigned int channelGroupCount;
+    int *channelGroupResults;       /**< the result of each group for the current buffer */
+    struct PaUtilWorkerPool *workerPool; /**< runs the channel groups, NULL when there are none */
+
+    struct PaUtilResamplingStage *resamplingStage; /**< see PaUtil_InitializeResamplingBufferProcessor(),
+                                                        NULL when the rates are equal */
 } PaUtilBufferProcessor;
 
 
@@ -387,6 +466,42 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bufferProcessor
             PaStreamCallback *streamCallback, void *userData );
 
 
+/** Initialize a buffer processor for a stream whose callback runs at a
+ different sample rate than the host API, as requested with
+ paConvertSampleRate. When the rates differ, the buffer processor passes the
+ host buffers as paFloat32 to a resampling stage, which calls streamCallback
+ at userSampleRate with the user sample formats and framesPerUserBuffer
+ frames, or a fixed size close to the host buffer size when framesPerUserBuffer
+ is 0. The latency of the stage is included in
+ PaUtil_GetBufferProcessorInputLatencyFrames() and
+ PaUtil_GetBufferProcessorOutputLatencyFrames(), in host frames.
+
+ The parameters are those of PaUtil_InitializeBufferProcessor(), except for
+ the sample rates.
+
+ @param userSampleRate The sample rate passed to Pa_OpenStream.
+
+ @param hostSampleRate The sample rate the host API runs at. When it equals
+ userSampleRate this function is the same as PaUtil_InitializeBufferProcessor().
+
+ @return As PaUtil_InitializeBufferProcessor(), or paInvalidSampleRate for a
+ blocking stream when the rates differ.
+
+ @see PaUtil_InitializeBufferProcessor, paConvertSampleRate
+*/
+PaError PaUtil_InitializeResamplingBufferProcessor( PaUtilBufferProcessor* bufferProcessor,
+            int inputChannelCount, PaSampleFormat userInputSampleFormat,
+            PaSampleFormat hostInputSampleFormat,
+            int outputChannelCount, PaSampleFormat userOutputSampleFormat,
+            PaSampleFormat hostOutputSampleFormat,
+            double userSampleRate, double hostSampleRate,
+            PaStreamFlags streamFlags,
+            unsigned long framesPerUserBuffer, /* 0 indicates don't care */
+            unsigned long framesPerHostBuffer,
+            PaUtilHostBufferSizeMode hostBufferSizeMode,
+            PaStreamCallback *streamCallback, void *userData );
+
+
 /** Terminate a buffer processor's representation. Deallocates any temporary
  buffers allocated by PaUtil_InitializeBufferProcessor.
 
@@ -426,6 +541,195 @@ unsigned long PaUtil_GetBufferProcessorInputLatencyFrames( PaUtilBufferProcessor
 */
 unsigned long PaUtil_GetBufferProcessorOutputLatencyFrames( PaUtilBufferProcessor* bufferProcessor );
 
+/** Replace the converters which were selected when the buffer processor was
+ initialized. Must not be called while the buffer processor is in use.
+
+ @param bufferProcessor The buffer processor to modify.
+
+ @param inputConverter The new input converter, or NULL to keep the current
+ one. Ignored when the buffer processor has no input channels.
+
+ @param outputConverter The new output converter, or NULL to keep the current
+ one. Ignored when the buffer processor has no output channels.
+*/
+void PaUtil_SetBufferProcessorConverters( PaUtilBufferProcessor* bufferProcessor,
+        PaUtilConverter *inputConverter, PaUtilConverter *outputConverter );
+
+/** Call groupCallback for groups of channelsPerGroup channels in place of
+ the stream callback, running the groups of each buffer in parallel on the
+ calling thread and a pool of threadCount - 1 worker threads. Must not be
+ called while the buffer processor is in use. The user buffers must be
+ non-interleaved.
+
+ @param bufferProcessor The buffer processor to modify.
+
+ @param groupCallback The group callback, or NULL to call the stream callback
+ again and release the worker threads.
+
+ @param channelsPerGroup The number of input and of output channels in a
+ group, at least 1.
+
+ @param threadCount The number of threads which process groups, including the
+ calling thread, or 0 for one per processor. It is limited to the number of
+ groups.
+
+ @return paNoError, or paInsufficientMemory or paUnanticipatedHostError if
+ the worker pool could not be created, in which case the buffer processor
+ is unchanged.
+
+ @see Pa_SetStreamChannelGroupCallback
+*/
+PaError PaUtil_SetBufferProcessorChannelGroupCallback( PaUtilBufferProcessor* bufferProcessor,
+        PaStreamChannelGroupCallback *groupCallback, unsigned int channelsPerGroup,
+        unsigned int threadCount );
+
+/** Route userChannelCount user output channels to the host output channels
+ through a matrix of gains. Must not be called while the buffer processor is
+ in use. The user output buffers then hold userChannelCount channels, which
+ may be more or fewer than the host channels.
+
+ The matrix is applied as part of the output conversion. A host channel
+ whose row is all zeros is filled by the zeroer without reading the user
+ buffer, and one whose row holds a single gain of 1 is converted directly
+ from its user channel. Other rows are mixed, which requires paFloat32 user
+ output.
+
+ @param bufferProcessor The buffer processor to modify. It must have output
+ channels and must not use a resampling stage.
+
+ @param userChannelCount The number of user output channels, at least 1.
+ Ignored when matrix is NULL.
+
+ @param matrix outputChannelCount rows of userChannelCount gains, the gain of
+ user channel u in host channel h being matrix[ h * userChannelCount + u ].
+ It is copied. NULL removes the matrix, and the user output channels are the
+ host channels again.
+
+ @return paNoError, paSampleFormatNotSupported if a row needs mixing and the
+ user output format is not paFloat32, or paInsufficientMemory, in which case
+ the buffer processor is unchanged.
+
+ @see Pa_SetStreamOutputChannelMatrix
+*/
+PaError PaUtil_SetBufferProcessorOutputChannelMatrix( PaUtilBufferProcessor* bufferProcessor,
+        unsigned int userChannelCount, const float *matrix );
+
+/** Set the gain applied to the output of a buffer processor as it is converted
+ to the host format. May be called from any thread while the buffer processor
+ is in use, but only from one thread at a time. The processing thread picks
+ the gain up at the start of the next host buffer, or the next call of
+ PaUtil_CopyOutput(), and ramps linearly to it over rampFrames frames, so
+ that the last frame of the ramp has the new gain. A gain of 1 which is not
+ ramping costs nothing, and a gain of 0 fills the host buffers with the
+ zeroer.
+
+ @param bufferProcessor The buffer processor to modify. It must have output
+ channels.
+
+ @param gain The new gain. It also becomes the gain which is faded in by
+ PaUtil_StartBufferProcessorOutputGain().
+
+ @param rampFrames The length of the ramp in frames, 0 to apply the gain at
+ once.
+
+ @return paNoError, or paSampleFormatNotSupported if gain is not 1 and the
+ user output format can not be converted to and from paFloat32.
+*/
+PaError PaUtil_SetBufferProcessorOutputGain( PaUtilBufferProcessor* bufferProcessor,
+        float gain, unsigned long rampFrames );
+
+/** Set the lengths of the fades applied by PaUtil_StartBufferProcessorOutputGain()
+ and PaUtil_FadeOutBufferProcessorOutput(). Only read by the thread which
+ starts and stops the stream. 0 disables a fade.
+*/
+void PaUtil_SetBufferProcessorOutputFades( PaUtilBufferProcessor* bufferProcessor,
+        unsigned long fadeInFrames, unsigned long fadeOutFrames );
+
+/** Prepare the output gain for a stream start: gain requests which were not
+ picked up are discarded, and the output fades in from silence to the gain
+ of the last PaUtil_SetBufferProcessorOutputGain() if a fade in is set.
+ Must not be called while the buffer processor is in use.
+*/
+void PaUtil_StartBufferProcessorOutputGain( PaUtilBufferProcessor* bufferProcessor );
+
+/** Ramp the output gain down to 0 over the fade out frames of
+ PaUtil_SetBufferProcessorOutputFades(), without changing the gain the next
+ start fades in to.
+
+ @return A request number to pass to PaUtil_IsBufferProcessorOutputGainRequestDone(),
+ or 0 if no fade out is set.
+*/
+unsigned long PaUtil_FadeOutBufferProcessorOutput( PaUtilBufferProcessor* bufferProcessor );
+
+/** Determine whether the processing thread has converted the last frame of
+ the ramp of a gain request, or of a later one. May be called from any
+ thread.
+*/
+int PaUtil_IsBufferProcessorOutputGainRequestDone( PaUtilBufferProcessor* bufferProcessor,
+        unsigned long request );
+
+/** Retrieve the number of samples clipped by the buffer processor's input and
+ output converters since the previous call, or since the buffer processor was
+ initialized. May be called from any thread while the stream is running.
+
+ @param bufferProcessor The buffer processor to examine.
+
+ @param inputClippedSamples Receives the number of clipped input samples.
+
+ @param outputClippedSamples Receives the number of clipped output samples.
+*/
+void PaUtil_ReadBufferProcessorClippedSampleCounts( PaUtilBufferProcessor* bufferProcessor,
+        unsigned long *inputClippedSamples, unsigned long *outputClippedSamples );
+
+/** Count the xruns flagged in statusFlags. PaUtil_BeginBufferProcessing()
+ counts the flags it is passed, host APIs call this for xruns of blocking
+ streams which don't go through it. Must be called by the processing thread.
+
+ @param bufferProcessor The buffer processor to update.
+
+ @param statusFlags A combination of paInputUnderflow, paInputOverflow,
+ paOutputUnderflow and paOutputOverflow. Other flags are ignored.
+*/
+void PaUtil_CountBufferProcessorXruns( PaUtilBufferProcessor* bufferProcessor,
+        PaStreamCallbackFlags statusFlags );
+
+/** Retrieve the number of xruns counted by PaUtil_CountBufferProcessorXruns()
+ since the previous call, or since the buffer processor was initialized. May be
+ called from any thread while the stream is running.
+
+ @param bufferProcessor The buffer processor to examine.
+
+ @param xrunCounts Receives the counts.
+*/
+void PaUtil_ReadBufferProcessorXrunCounts( PaUtilBufferProcessor* bufferProcessor,
+        PaUtilXrunCounts *xrunCounts );
+
+/** Allow the buffer processor to modify the host input buffers. When the host
+ input format is paInt32 and the user input format is paFloat32 the samples are
+ then converted in place and the stream callback receives a pointer into the
+ host buffer. Only host APIs which own their input buffers should allow this;
+ a buffer which is shared with other clients, such as a JACK port buffer or an
+ ALSA dsnoop mmap area, must not be modified. The default is not writable.
+
+ @param bufferProcessor The buffer processor to modify.
+
+ @param isWritable Non-zero if the host input buffers may be modified.
+*/
+void PaUtil_SetHostInputBufferIsWritable( PaUtilBufferProcessor* bufferProcessor,
+        int isWritable );
+
+/** Retrieve the PaStreamInfoFlags describing how the buffers most recently
+ passed to PaUtil_EndBufferProcessing() were processed. May be called from any
+ thread while the stream is running.
+
+ @param bufferProcessor The buffer processor to examine.
+
+ @return paStreamInfoAlignedBuffers combined with paStreamInfoInputPassThrough
+ and paStreamInfoOutputPassThrough, or paStreamInfoSampleRateConverted for a
+ buffer processor with a resampling stage.
+*/
+PaStreamInfoFlags PaUtil_GetBufferProcessorStreamInfoFlags( PaUtilBufferProcessor* bufferProcessor );
+
 /*@}*/
 
 
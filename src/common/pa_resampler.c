@@ -0,0 +1,875 @@
+/*
+ * $Id$
+ * Portable Audio I/O Library sample rate conversion
+ * Polyphase sample rate converter
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief Polyphase sample rate converter and the resampling stage of the
+ buffer processor.
+
+ The filter is a Kaiser windowed sinc, designed for the quality's stopband
+ attenuation at a 1:1 ratio and widened in proportion to the ratio when
+ decimating, so that its cutoff follows the lower of the two Nyquist
+ frequencies. The read position is kept in 32.32 fixed point so that it does
+ not drift however long the stream runs.
+
+ Kernels are compiled for SSE2 and AVX2 on x86 (selected at runtime using
+ CPUID), and for any architecture using the GCC/Clang vector extensions.
+ Define PA_NO_SIMD_CONVERTERS to compile none of them.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "pa_resampler.h"
+#include "pa_simd_converters.h"
+#include "pa_util.h"
+
+
+#ifndef PA_NO_SIMD_CONVERTERS
+
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__)) && \
+        (defined(__x86_64__) || defined(__i386__))
+#define PA_SIMD_X86_
+#define PA_SIMD_TARGET_SSE2_ __attribute__((target("sse2")))
+#define PA_SIMD_TARGET_AVX2_ __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (_MSC_VER >= 1800) && (defined(_M_X64) || defined(_M_IX86))
+#define PA_SIMD_X86_
+#define PA_SIMD_TARGET_SSE2_
+#define PA_SIMD_TARGET_AVX2_
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__has_builtin)
+#if __has_builtin(__builtin_convertvector)
+#define PA_SIMD_GENERIC_
+#endif
+#endif
+
+#endif /* PA_NO_SIMD_CONVERTERS */
+
+
+#define PA_MIN_( a, b ) ( ((a)<(b)) ? (a) : (b) )
+#define PA_MAX_( a, b ) ( ((a)>(b)) ? (a) : (b) )
+
+#define PA_RESAMPLER_TAP_ALIGN_     (8)
+
+#ifndef M_PI
+#define M_PI  (3.14159265358979323846)
+#endif
+
+typedef struct PaUtilResamplerPreset
+{
+    unsigned int tapCount;          /* at a 1:1 ratio */
+    double attenuation;             /* stopband attenuation in dB */
+    unsigned int log2PhaseCount;
+}
+PaUtilResamplerPreset;
+
+/* The phase counts keep the error of the linear interpolation between phases
+    below the stopband attenuation. */
+static const PaUtilResamplerPreset resamplerPresets_[] =
+{
+    { 16, 60., 5 },
+    { 48, 85., 7 },
+    { 96, 105., 8 }
+};
+
+/* -------------------------------------------------------------------------- */
+
+static float ScalarKernel( const float *x, const float *c, const float *d,
+        float f, unsigned int tapCount )
+{
+    float sum0 = 0.f, sum1 = 0.f, sum2 = 0.f, sum3 = 0.f;
+    unsigned int k;
+
+    for( k=0; k < tapCount; k += 4 )
+    {
+        sum0 += x[k] * (c[k] + f * d[k]);
+        sum1 += x[k+1] * (c[k+1] + f * d[k+1]);
+        sum2 += x[k+2] * (c[k+2] + f * d[k+2]);
+        sum3 += x[k+3] * (c[k+3] + f * d[k+3]);
+    }
+
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+#ifdef PA_SIMD_GENERIC_
+
+typedef float PaSimdFloat4 __attribute__((vector_size(16)));
+
+/* vectors are transferred with memcpy() to avoid alignment and aliasing
+    assumptions, compilers turn these into single unaligned loads */
+
+static float GenericKernel( const float *x, const float *c, const float *d,
+        float f, unsigned int tapCount )
+{
+    PaSimdFloat4 sum0 = { 0.f, 0.f, 0.f, 0.f }, sum1 = { 0.f, 0.f, 0.f, 0.f };
+    unsigned int k;
+
+    for( k=0; k < tapCount; k += 8 )
+    {
+        PaSimdFloat4 x0, x1, c0, c1, d0, d1;
+
+        memcpy( &x0, x + k, sizeof(x0) );
+        memcpy( &x1, x + k + 4, sizeof(x1) );
+        memcpy( &c0, c + k, sizeof(c0) );
+        memcpy( &c1, c + k + 4, sizeof(c1) );
+        memcpy( &d0, d + k, sizeof(d0) );
+        memcpy( &d1, d + k + 4, sizeof(d1) );
+        sum0 += x0 * (c0 + f * d0);
+        sum1 += x1 * (c1 + f * d1);
+    }
+
+    sum0 += sum1;
+    return (sum0[0] + sum0[1]) + (sum0[2] + sum0[3]);
+}
+
+#endif /* PA_SIMD_GENERIC_ */
+
+#ifdef PA_SIMD_X86_
+
+PA_SIMD_TARGET_SSE2_
+static float Sse2Kernel( const float *x, const float *c, const float *d,
+        float f, unsigned int tapCount )
+{
+    const __m128 fraction = _mm_set1_ps( f );
+    __m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+    float lanes[4];
+    unsigned int k;
+
+    for( k=0; k < tapCount; k += 8 )
+    {
+        __m128 c0 = _mm_add_ps( _mm_loadu_ps( c + k ), _mm_mul_ps( fraction, _mm_loadu_ps( d + k ) ) );
+        __m128 c1 = _mm_add_ps( _mm_loadu_ps( c + k + 4 ), _mm_mul_ps( fraction, _mm_loadu_ps( d + k + 4 ) ) );
+        sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( x + k ), c0 ) );
+        sum1 = _mm_add_ps( sum1, _mm_mul_ps( _mm_loadu_ps( x + k + 4 ), c1 ) );
+    }
+
+    _mm_storeu_ps( lanes, _mm_add_ps( sum0, sum1 ) );
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+PA_SIMD_TARGET_AVX2_
+static float Avx2Kernel( const float *x, const float *c, const float *d,
+        float f, unsigned int tapCount )
+{
+    const __m256 fraction = _mm256_set1_ps( f );
+    __m256 sum = _mm256_setzero_ps();
+    __m128 half;
+    float lanes[4];
+    unsigned int k;
+
+    for( k=0; k < tapCount; k += 8 )
+    {
+        __m256 coefficients = _mm256_add_ps( _mm256_loadu_ps( c + k ),
+                _mm256_mul_ps( fraction, _mm256_loadu_ps( d + k ) ) );
+        sum = _mm256_add_ps( sum, _mm256_mul_ps( _mm256_loadu_ps( x + k ), coefficients ) );
+    }
+
+    half = _mm_add_ps( _mm256_castps256_ps128( sum ), _mm256_extractf128_ps( sum, 1 ) );
+    _mm_storeu_ps( lanes, half );
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+#endif /* PA_SIMD_X86_ */
+
+/* -------------------------------------------------------------------------- */
+
+/* The zeroth order modified Bessel function of the first kind. */
+static double BesselI0( double x )
+{
+    double sum = 1., term = 1., halfX = x * .5;
+    int k;
+
+    for( k=1; k < 64 && term > sum * 1e-12; ++k )
+    {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+    }
+
+    return sum;
+}
+
+static void DesignFilter( PaUtilResampler *resampler, const PaUtilResamplerPreset *preset )
+{
+    unsigned int tapCount = resampler->tapCount, phaseCount = resampler->phaseCount;
+    double beta = 0.1102 * (preset->attenuation - 8.7);
+    double transition = (preset->attenuation - 8.) / (2.285 * 2. * M_PI * preset->tapCount);
+    double cutoff = (.5 - transition * .5) * PA_MIN_( 1., 1. / resampler->step );
+    double halfLength = tapCount * .5;
+    double i0Beta = BesselI0( beta );
+    unsigned int p, k;
+
+    /* phaseCount + 1 rows, the last one is only used for the differences */
+    for( p=0; p <= phaseCount; ++p )
+    {
+        float *row = resampler->coefficients + p * tapCount;
+        double delay = (double)p / phaseCount;
+        double sum = 0.;
+
+        for( k=0; k < tapCount; ++k )
+        {
+            double t = (double)k - (halfLength - 1.) - delay;
+            double x = t / halfLength;
+            double h = 2. * cutoff;
+
+            if( t != 0. )
+                h = sin( 2. * M_PI * cutoff * t ) / (M_PI * t);
+            h *= (x >= -1. && x <= 1.) ? BesselI0( beta * sqrt( 1. - x * x ) ) / i0Beta : 0.;
+
+            row[k] = (float)h;
+            sum += h;
+        }
+
+        /* unity gain at DC for every phase */
+        for( k=0; k < tapCount; ++k )
+            row[k] = (float)(row[k] / sum);
+    }
+
+    for( p=0; p < phaseCount; ++p )
+    {
+        for( k=0; k < tapCount; ++k )
+        {
+            resampler->differences[ p * tapCount + k ] =
+                    resampler->coefficients[ (p + 1) * tapCount + k ]
+                    - resampler->coefficients[ p * tapCount + k ];
+        }
+    }
+}
+
+
+/* when decimating the filter is stretched to the destination rate */
+static unsigned int GetTapCount( PaUtilResamplerQuality quality, double step )
+{
+    unsigned int tapCount = (unsigned int)ceil( resamplerPresets_[ quality ].tapCount * PA_MAX_( 1., step ) );
+
+    return (tapCount + PA_RESAMPLER_TAP_ALIGN_ - 1) & ~(PA_RESAMPLER_TAP_ALIGN_ - 1);
+}
+
+
+PaError PaUtil_InitializeResampler( PaUtilResampler *resampler, unsigned int channelCount,
+        double sourceSampleRate, double destinationSampleRate,
+        PaUtilResamplerQuality quality, unsigned long capacityFrames )
+{
+    const PaUtilResamplerPreset *preset = &resamplerPresets_[ quality ];
+    double stepFraction;
+
+    memset( resampler, 0, sizeof(PaUtilResampler) );
+
+    resampler->channelCount = channelCount;
+    resampler->step = sourceSampleRate / destinationSampleRate;
+    resampler->stepInteger = (unsigned long)floor( resampler->step );
+    stepFraction = floor( (resampler->step - resampler->stepInteger) * 4294967296. + .5 );
+    if( stepFraction >= 4294967296. )
+    {
+        ++resampler->stepInteger;
+        stepFraction = 0.;
+    }
+    resampler->stepFraction = (PaUint32)stepFraction;
+
+    resampler->tapCount = GetTapCount( quality, resampler->step );
+    resampler->phaseCount = 1 << preset->log2PhaseCount;
+    resampler->phaseShift = 32 - preset->log2PhaseCount;
+
+    resampler->coefficients = (float*)PaUtil_AllocateZeroInitializedMemory(
+            (long)(sizeof(float) * resampler->tapCount * (2 * resampler->phaseCount + 1)) );
+    if( !resampler->coefficients )
+        return paInsufficientMemory;
+    resampler->differences = resampler->coefficients + (resampler->phaseCount + 1) * resampler->tapCount;
+
+    resampler->historyCapacity = capacityFrames + resampler->tapCount + resampler->stepInteger + 2;
+    resampler->history = (float*)PaUtil_AllocateZeroInitializedMemory(
+            (long)(sizeof(float) * resampler->historyCapacity * channelCount) );
+    if( !resampler->history )
+    {
+        PaUtil_FreeMemory( resampler->coefficients );
+        resampler->coefficients = NULL;
+        return paInsufficientMemory;
+    }
+
+    DesignFilter( resampler, preset );
+    PaUtil_SelectResamplerKernel( resampler, PaUtil_GetAvailableSimdInstructionSets() );
+    PaUtil_ResetResampler( resampler );
+
+    return paNoError;
+}
+
+
+void PaUtil_TerminateResampler( PaUtilResampler *resampler )
+{
+    PaUtil_FreeMemory( resampler->coefficients );
+    PaUtil_FreeMemory( resampler->history );
+    resampler->coefficients = NULL;
+    resampler->differences = NULL;
+    resampler->history = NULL;
+}
+
+
+void PaUtil_ResetResampler( PaUtilResampler *resampler )
+{
+    unsigned int c;
+
+    /* the first destination frame is centred on the first source frame */
+    resampler->historyFrames = resampler->tapCount / 2 - 1;
+    for( c=0; c < resampler->channelCount; ++c )
+    {
+        memset( resampler->history + c * resampler->historyCapacity, 0,
+                sizeof(float) * resampler->historyFrames );
+    }
+
+    resampler->positionIndex = 0;
+    resampler->positionFraction = 0;
+}
+
+
+void PaUtil_SelectResamplerKernel( PaUtilResampler *resampler, unsigned int instructionSets )
+{
+    instructionSets &= PaUtil_GetAvailableSimdInstructionSets();
+
+    /* from slowest to fastest */
+    resampler->kernel = ScalarKernel;
+#ifdef PA_SIMD_GENERIC_
+    if( instructionSets & paUtilSimdGeneric )
+        resampler->kernel = GenericKernel;
+#endif
+#ifdef PA_SIMD_X86_
+    if( instructionSets & paUtilSimdSse2 )
+        resampler->kernel = Sse2Kernel;
+    if( instructionSets & paUtilSimdAvx2 )
+        resampler->kernel = Avx2Kernel;
+#endif
+}
+
+
+unsigned long PaUtil_GetResamplerWriteAvailable( PaUtilResampler *resampler )
+{
+    unsigned long consumed = PA_MIN_( resampler->positionIndex, resampler->historyFrames );
+
+    return resampler->historyCapacity - (resampler->historyFrames - consumed);
+}
+
+
+void PaUtil_WriteResampler( PaUtilResampler *resampler, const float *source, unsigned long frameCount )
+{
+    unsigned int channelCount = resampler->channelCount;
+    unsigned int c;
+    unsigned long i;
+
+    if( resampler->historyFrames + frameCount > resampler->historyCapacity )
+    {
+        /* discard the frames which no destination frame needs any more */
+        unsigned long consumed = PA_MIN_( resampler->positionIndex, resampler->historyFrames );
+
+        for( c=0; c < channelCount; ++c )
+        {
+            float *history = resampler->history + c * resampler->historyCapacity;
+            memmove( history, history + consumed, sizeof(float) * (resampler->historyFrames - consumed) );
+        }
+        resampler->historyFrames -= consumed;
+        resampler->positionIndex -= consumed;
+    }
+
+    for( c=0; c < channelCount; ++c )
+    {
+        float *history = resampler->history + c * resampler->historyCapacity + resampler->historyFrames;
+
+        if( source )
+        {
+            for( i=0; i < frameCount; ++i )
+                history[i] = source[ i * channelCount + c ];
+        }
+        else
+        {
+            memset( history, 0, sizeof(float) * frameCount );
+        }
+    }
+    resampler->historyFrames += frameCount;
+}
+
+
+unsigned long PaUtil_GetResamplerReadAvailable( PaUtilResampler *resampler )
+{
+    unsigned long index = resampler->positionIndex;
+    PaUint32 fraction = resampler->positionFraction;
+    unsigned long result = 0;
+
+    while( index + resampler->tapCount <= resampler->historyFrames )
+    {
+        PaUint32 next = fraction + resampler->stepFraction;
+
+        index += resampler->stepInteger + (next < fraction ? 1 : 0);
+        fraction = next;
+        ++result;
+    }
+
+    return result;
+}
+
+
+unsigned long PaUtil_ReadResampler( PaUtilResampler *resampler, float *destination, unsigned long frameCount )
+{
+    unsigned int channelCount = resampler->channelCount;
+    unsigned int tapCount = resampler->tapCount;
+    PaUint32 fractionMask = (PaUint32)(0xFFFFFFFFUL >> (32 - resampler->phaseShift));
+    float fractionScale = 1.f / (float)(fractionMask + 1.);
+    unsigned long n;
+    unsigned int c;
+
+    for( n=0; n < frameCount && resampler->positionIndex + tapCount <= resampler->historyFrames; ++n )
+    {
+        PaUint32 phase = resampler->positionFraction >> resampler->phaseShift;
+        float f = (float)(resampler->positionFraction & fractionMask) * fractionScale;
+        const float *coefficients = resampler->coefficients + phase * tapCount;
+        const float *differences = resampler->differences + phase * tapCount;
+        PaUint32 next;
+
+        for( c=0; c < channelCount; ++c )
+        {
+            destination[ n * channelCount + c ] = resampler->kernel(
+                    resampler->history + c * resampler->historyCapacity + resampler->positionIndex,
+                    coefficients, differences, f, tapCount );
+        }
+
+        next = resampler->positionFraction + resampler->stepFraction;
+        resampler->positionIndex += resampler->stepInteger + (next < resampler->positionFraction ? 1 : 0);
+        resampler->positionFraction = next;
+    }
+
+    return n;
+}
+
+
+double PaUtil_GetResamplerDelay( PaUtilResampler *resampler )
+{
+    return resampler->tapCount * .5;
+}
+
+
+PaUtilResamplerQuality PaUtil_GetResamplerQuality( PaStreamFlags streamFlags )
+{
+    switch( streamFlags & paSampleRateConversionQualityMask )
+    {
+    case paSampleRateConversionFast:
+        return paUtilResamplerFast;
+    case paSampleRateConversionBest:
+        return paUtilResamplerBest;
+    default:
+        return paUtilResamplerMedium;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* One direction of a resampling stage. */
+typedef struct PaUtilResamplingStageDirection
+{
+    int channelCount;
+    PaUtilResampler resampler;
+    float *buffer;                  /**< one user buffer of interleaved paFloat32 frames */
+    void *userBuffer;               /**< one user buffer in the user's sample format */
+    void **userChannels;            /**< the channels of userBuffer, NULL if it is interleaved */
+    unsigned int bytesPerUserSample;
+    PaUtilConverter *converter;
+}
+PaUtilResamplingStageDirection;
+
+struct PaUtilResamplingStage
+{
+    PaStreamCallback *streamCallback;
+    void *userData;
+    unsigned long framesPerUserBuffer;
+    double hostSamplePeriod;
+
+    PaUtilResamplingStageDirection input;
+    PaUtilResamplingStageDirection output;
+    PaUtilTriangularDitherGenerator ditherGenerator;
+    unsigned long *inputClippedSampleCount; /**< the buffer processor's total */
+
+    unsigned long inputPrimingFrames;   /**< silence ahead of the input of a full duplex stream */
+    unsigned long inputLatencyFrames;
+    unsigned long outputLatencyFrames;
+
+    PaStreamCallbackFlags statusFlags;  /**< to be passed to the next stream callback */
+    int callbackResult;
+    unsigned long tailFramesRemaining;  /**< silence to write behind the last output buffer */
+};
+
+
+static PaError InitializeDirection( PaUtilResamplingStageDirection *direction,
+        int channelCount, PaSampleFormat userSampleFormat, int isInput,
+        double sourceSampleRate, double destinationSampleRate, PaStreamFlags streamFlags,
+        unsigned long framesPerUserBuffer, unsigned long capacityFrames )
+{
+    PaError result;
+    int c;
+
+    direction->channelCount = channelCount;
+    if( channelCount == 0 )
+        return paNoError;
+
+    direction->converter = isInput
+            ? PaUtil_SelectConverter( paFloat32, userSampleFormat & ~paNonInterleaved, streamFlags )
+            : PaUtil_SelectConverter( userSampleFormat & ~paNonInterleaved, paFloat32, streamFlags );
+    if( !direction->converter )
+        return paSampleFormatNotSupported;
+
+    result = Pa_GetSampleSize( userSampleFormat & ~paNonInterleaved );
+    if( result < 0 )
+        return result;
+    direction->bytesPerUserSample = (unsigned int)result;
+
+    result = PaUtil_InitializeResampler( &direction->resampler, (unsigned int)channelCount,
+            sourceSampleRate, destinationSampleRate, PaUtil_GetResamplerQuality( streamFlags ),
+            capacityFrames );
+    if( result != paNoError )
+        return result;
+
+    direction->buffer = (float*)PaUtil_AllocateZeroInitializedMemory(
+            (long)(sizeof(float) * framesPerUserBuffer * channelCount) );
+    direction->userBuffer = PaUtil_AllocateZeroInitializedMemory(
+            (long)(direction->bytesPerUserSample * framesPerUserBuffer * channelCount) );
+    if( !direction->buffer || !direction->userBuffer )
+        return paInsufficientMemory;
+
+    if( userSampleFormat & paNonInterleaved )
+    {
+        direction->userChannels = (void**)PaUtil_AllocateZeroInitializedMemory(
+                (long)(sizeof(void*) * channelCount) );
+        if( !direction->userChannels )
+            return paInsufficientMemory;
+
+        for( c=0; c < channelCount; ++c )
+        {
+            direction->userChannels[c] = (unsigned char*)direction->userBuffer
+                    + c * framesPerUserBuffer * direction->bytesPerUserSample;
+        }
+    }
+
+    return paNoError;
+}
+
+
+static void TerminateDirection( PaUtilResamplingStageDirection *direction )
+{
+    if( direction->channelCount == 0 )
+        return;
+
+    PaUtil_TerminateResampler( &direction->resampler );
+    PaUtil_FreeMemory( direction->buffer );
+    PaUtil_FreeMemory( direction->userBuffer );
+    PaUtil_FreeMemory( direction->userChannels );
+}
+
+
+PaError PaUtil_CreateResamplingStage( PaUtilResamplingStage **stage,
+        int inputChannelCount, PaSampleFormat userInputSampleFormat,
+        int outputChannelCount, PaSampleFormat userOutputSampleFormat,
+        double userSampleRate, double hostSampleRate, PaStreamFlags streamFlags,
+        unsigned long framesPerUserBuffer, unsigned long maxFramesPerHostBuffer,
+        PaStreamCallback *streamCallback, void *userData,
+        unsigned long *inputClippedSampleCount )
+{
+    PaUtilResamplingStage *result;
+    double hostFramesPerUserFrame = hostSampleRate / userSampleRate;
+    unsigned long userFramesInHostBuffer, hostFramesInUserBuffer, inputCapacity, outputCapacity;
+    PaError error;
+
+    *stage = NULL;
+
+    result = (PaUtilResamplingStage*)PaUtil_AllocateZeroInitializedMemory( sizeof(PaUtilResamplingStage) );
+    if( !result )
+        return paInsufficientMemory;
+
+    if( framesPerUserBuffer == paFramesPerBufferUnspecified )
+    {
+        framesPerUserBuffer = (unsigned long)floor( maxFramesPerHostBuffer / hostFramesPerUserFrame + .5 );
+        if( framesPerUserBuffer == 0 )
+            framesPerUserBuffer = 1;
+    }
+
+    result->streamCallback = streamCallback;
+    result->userData = userData;
+    result->inputClippedSampleCount = inputClippedSampleCount;
+    result->framesPerUserBuffer = framesPerUserBuffer;
+    result->hostSamplePeriod = 1. / hostSampleRate;
+    PaUtil_InitializeTriangularDitherState( &result->ditherGenerator );
+
+    userFramesInHostBuffer = (unsigned long)ceil( maxFramesPerHostBuffer / hostFramesPerUserFrame );
+    hostFramesInUserBuffer = (unsigned long)ceil( framesPerUserBuffer * hostFramesPerUserFrame );
+
+    /* the output resampler holds less than a host buffer and its filter
+        history when the callback is called, plus what the callback writes */
+    outputCapacity = 2 * framesPerUserBuffer + userFramesInHostBuffer + 2;
+    error = InitializeDirection( &result->output, outputChannelCount, userOutputSampleFormat, 0,
+            userSampleRate, hostSampleRate, streamFlags, framesPerUserBuffer, outputCapacity );
+    if( error != paNoError )
+        goto error;
+
+    if( inputChannelCount > 0 && outputChannelCount > 0 )
+    {
+        /* Full duplex callbacks are paced by the output, which may ask for a
+            user buffer before the input resampler has one. The input is
+            delayed by enough silence to cover a user buffer and both filters. */
+        result->inputPrimingFrames = (unsigned long)ceil( (result->output.resampler.tapCount + framesPerUserBuffer)
+                * hostFramesPerUserFrame ) + GetTapCount( PaUtil_GetResamplerQuality( streamFlags ),
+                hostFramesPerUserFrame ) + 2;
+    }
+
+    inputCapacity = result->inputPrimingFrames + 2 * maxFramesPerHostBuffer + 2 * hostFramesInUserBuffer + 2;
+    error = InitializeDirection( &result->input, inputChannelCount, userInputSampleFormat, 1,
+            hostSampleRate, userSampleRate, streamFlags, framesPerUserBuffer, inputCapacity );
+    if( error != paNoError )
+        goto error;
+
+    if( result->inputPrimingFrames > 0 )
+    {
+        result->inputLatencyFrames = result->inputPrimingFrames;
+    }
+    else if( inputChannelCount > 0 )
+    {
+        result->inputLatencyFrames = (unsigned long)ceil( PaUtil_GetResamplerDelay( &result->input.resampler ) )
+                + hostFramesInUserBuffer;
+    }
+
+    if( outputChannelCount > 0 )
+    {
+        result->outputLatencyFrames = (unsigned long)ceil( PaUtil_GetResamplerDelay( &result->output.resampler )
+                * hostFramesPerUserFrame ) + hostFramesInUserBuffer;
+    }
+
+    PaUtil_ResetResamplingStage( result );
+    *stage = result;
+    return paNoError;
+
+error:
+    PaUtil_DestroyResamplingStage( result );
+    return error;
+}
+
+
+void PaUtil_DestroyResamplingStage( PaUtilResamplingStage *stage )
+{
+    if( !stage )
+        return;
+
+    TerminateDirection( &stage->input );
+    TerminateDirection( &stage->output );
+    PaUtil_FreeMemory( stage );
+}
+
+
+void PaUtil_ResetResamplingStage( PaUtilResamplingStage *stage )
+{
+    if( stage->input.channelCount > 0 )
+    {
+        PaUtil_ResetResampler( &stage->input.resampler );
+        PaUtil_WriteResampler( &stage->input.resampler, NULL, stage->inputPrimingFrames );
+    }
+    if( stage->output.channelCount > 0 )
+        PaUtil_ResetResampler( &stage->output.resampler );
+
+    stage->statusFlags = 0;
+    stage->callbackResult = paContinue;
+    stage->tailFramesRemaining = 0;
+}
+
+
+unsigned long PaUtil_GetResamplingStageFramesPerUserBuffer( PaUtilResamplingStage *stage )
+{
+    return stage->framesPerUserBuffer;
+}
+
+
+unsigned long PaUtil_GetResamplingStageInputLatencyFrames( PaUtilResamplingStage *stage )
+{
+    return stage->inputLatencyFrames;
+}
+
+
+unsigned long PaUtil_GetResamplingStageOutputLatencyFrames( PaUtilResamplingStage *stage )
+{
+    return stage->outputLatencyFrames;
+}
+
+
+/* Calls the stream callback for one user buffer, taking its input from the
+    input resampler and writing its output to the output resampler. */
+static void CallStreamCallback( PaUtilResamplingStage *stage, const PaStreamCallbackTimeInfo *timeInfo )
+{
+    unsigned long frameCount = stage->framesPerUserBuffer;
+    const void *userInput = NULL;
+    void *userOutput = NULL;
+    int c;
+
+    if( stage->input.channelCount > 0 )
+    {
+        PaUtilResamplingStageDirection *input = &stage->input;
+        unsigned long framesRead = PaUtil_ReadResampler( &input->resampler, input->buffer, frameCount );
+
+        if( framesRead < frameCount )
+        {
+            memset( input->buffer + framesRead * input->channelCount, 0,
+                    sizeof(float) * (frameCount - framesRead) * input->channelCount );
+            stage->statusFlags |= paInputUnderflow;
+        }
+
+        for( c=0; c < input->channelCount; ++c )
+        {
+            if( input->userChannels )
+            {
+                input->converter( input->userChannels[c], 1, input->buffer + c, input->channelCount,
+                        frameCount, &stage->ditherGenerator );
+            }
+            else
+            {
+                input->converter( (unsigned char*)input->userBuffer + c * input->bytesPerUserSample,
+                        input->channelCount, input->buffer + c, input->channelCount,
+                        frameCount, &stage->ditherGenerator );
+            }
+        }
+
+        *stage->inputClippedSampleCount += stage->ditherGenerator.clippedSampleCount;
+        stage->ditherGenerator.clippedSampleCount = 0;
+
+        userInput = input->userChannels ? (void*)input->userChannels : input->userBuffer;
+    }
+
+    if( stage->output.channelCount > 0 )
+        userOutput = stage->output.userChannels ? (void*)stage->output.userChannels : stage->output.userBuffer;
+
+    stage->callbackResult = stage->streamCallback( userInput, userOutput, frameCount, timeInfo,
+            stage->statusFlags, stage->userData );
+    stage->statusFlags = 0;
+
+    if( stage->output.channelCount > 0 && stage->callbackResult != paAbort )
+    {
+        PaUtilResamplingStageDirection *output = &stage->output;
+
+        for( c=0; c < output->channelCount; ++c )
+        {
+            if( output->userChannels )
+            {
+                output->converter( output->buffer + c, output->channelCount, output->userChannels[c], 1,
+                        frameCount, &stage->ditherGenerator );
+            }
+            else
+            {
+                output->converter( output->buffer + c, output->channelCount,
+                        (unsigned char*)output->userBuffer + c * output->bytesPerUserSample,
+                        output->channelCount, frameCount, &stage->ditherGenerator );
+            }
+        }
+
+        PaUtil_WriteResampler( &output->resampler, output->buffer, frameCount );
+
+        /* the last buffer is played out through the filter */
+        if( stage->callbackResult == paComplete )
+            stage->tailFramesRemaining = output->resampler.tapCount;
+    }
+}
+
+
+int PaUtil_ResamplingStageCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    PaUtilResamplingStage *stage = (PaUtilResamplingStage*)userData;
+    PaStreamCallbackTimeInfo userTimeInfo = *timeInfo;
+
+    stage->statusFlags |= statusFlags;
+    userTimeInfo.inputBufferAdcTime -= stage->inputLatencyFrames * stage->hostSamplePeriod;
+    userTimeInfo.outputBufferDacTime += stage->outputLatencyFrames * stage->hostSamplePeriod;
+
+    if( stage->input.channelCount > 0 )
+    {
+        unsigned long writeAvailable = PaUtil_GetResamplerWriteAvailable( &stage->input.resampler );
+
+        if( frameCount > writeAvailable )
+            stage->statusFlags |= paInputOverflow;
+        PaUtil_WriteResampler( &stage->input.resampler, (const float*)input, PA_MIN_( frameCount, writeAvailable ) );
+    }
+
+    if( stage->output.channelCount > 0 )
+    {
+        PaUtilResampler *resampler = &stage->output.resampler;
+        unsigned long framesRead;
+
+        while( PaUtil_GetResamplerReadAvailable( resampler ) < frameCount )
+        {
+            unsigned long writeAvailable = PaUtil_GetResamplerWriteAvailable( resampler );
+
+            if( stage->callbackResult == paContinue && writeAvailable >= stage->framesPerUserBuffer )
+            {
+                CallStreamCallback( stage, &userTimeInfo );
+            }
+            else if( stage->callbackResult == paComplete && stage->tailFramesRemaining > 0 && writeAvailable > 0 )
+            {
+                writeAvailable = PA_MIN_( writeAvailable, stage->tailFramesRemaining );
+                PaUtil_WriteResampler( resampler, NULL, writeAvailable );
+                stage->tailFramesRemaining -= writeAvailable;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        framesRead = PaUtil_ReadResampler( resampler, (float*)output, frameCount );
+        if( framesRead < frameCount )
+        {
+            memset( (float*)output + framesRead * stage->output.channelCount, 0,
+                    sizeof(float) * (frameCount - framesRead) * stage->output.channelCount );
+        }
+
+        /* keep going until the tail has been played */
+        if( stage->callbackResult == paComplete
+                && (stage->tailFramesRemaining > 0 || PaUtil_GetResamplerReadAvailable( resampler ) > 0) )
+            return paContinue;
+    }
+    else
+    {
+        while( stage->callbackResult == paContinue
+                && PaUtil_GetResamplerReadAvailable( &stage->input.resampler ) >= stage->framesPerUserBuffer )
+            CallStreamCallback( stage, &userTimeInfo );
+    }
+
+    return stage->callbackResult;
+}
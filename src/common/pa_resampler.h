@@ -0,0 +1,237 @@
+#ifndef PA_RESAMPLER_H
+#define PA_RESAMPLER_H
+/*
+ * $Id$
+ * Portable Audio I/O Library sample rate conversion
+ * Polyphase sample rate converter
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief A polyphase sample rate converter, and the resampling stage which
+ lets the buffer processor run a stream at a different rate than the host.
+
+ PaUtilResampler converts interleaved paFloat32 frames between two arbitrary
+ sample rates with a windowed sinc filter. The filter is tabulated for a
+ number of fractional delays (phases), and the coefficients for the
+ position of each output frame are interpolated linearly between the two
+ nearest phases. The history is kept per channel so that the filter is a
+ dot product over contiguous samples, which is computed with SIMD
+ instructions where available.
+
+ PaUtilResamplingStage sits between the buffer processor and the stream
+ callback. It is set up by PaUtil_InitializeResamplingBufferProcessor().
+*/
+
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_dither.h"
+#include "pa_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+/** Trade-offs between the quality of the conversion and its cost. */
+typedef enum PaUtilResamplerQuality
+{
+    paUtilResamplerFast = 0,    /**< about 60 dB of stopband attenuation, 16 taps at 1:1 */
+    paUtilResamplerMedium,      /**< about 85 dB, 48 taps at 1:1 */
+    paUtilResamplerBest         /**< about 105 dB, 96 taps at 1:1 */
+} PaUtilResamplerQuality;
+
+
+/** Computes the sum over tapCount samples of x[k] * (c[k] + f * d[k]). */
+typedef float PaUtilResamplerKernel( const float *x, const float *c, const float *d,
+        float f, unsigned int tapCount );
+
+
+/** The state of a sample rate converter. The fields are private. */
+typedef struct PaUtilResampler
+{
+    unsigned int channelCount;
+    double step;                    /**< source frames per destination frame */
+    unsigned long stepInteger;      /**< step in 32.32 fixed point */
+    PaUint32 stepFraction;
+    unsigned int tapCount;          /**< a multiple of 8 */
+    unsigned int phaseCount;        /**< a power of 2 */
+    unsigned int phaseShift;        /**< positionFraction >> phaseShift is the phase */
+    float *coefficients;            /**< phaseCount rows of tapCount coefficients */
+    float *differences;             /**< the difference from each row to the next */
+    PaUtilResamplerKernel *kernel;
+
+    float *history;                 /**< historyCapacity frames per channel, one channel after the other */
+    unsigned long historyCapacity;
+    unsigned long historyFrames;    /**< the number of frames held */
+    unsigned long positionIndex;    /**< the first history frame of the next destination frame */
+    PaUint32 positionFraction;      /**< and its fractional delay */
+} PaUtilResampler;
+
+
+/** Initialize a resampler.
+
+ @param channelCount The number of interleaved channels.
+
+ @param sourceSampleRate The sample rate of the frames written.
+
+ @param destinationSampleRate The sample rate of the frames read.
+
+ @param quality The filter quality.
+
+ @param capacityFrames The number of source frames the resampler can hold
+ which have not been consumed yet, in addition to the filter history.
+
+ @return paNoError or paInsufficientMemory.
+*/
+PaError PaUtil_InitializeResampler( PaUtilResampler *resampler, unsigned int channelCount,
+        double sourceSampleRate, double destinationSampleRate,
+        PaUtilResamplerQuality quality, unsigned long capacityFrames );
+
+
+/** Free the memory allocated by PaUtil_InitializeResampler(). */
+void PaUtil_TerminateResampler( PaUtilResampler *resampler );
+
+
+/** Discard all frames and fill the filter history with silence. */
+void PaUtil_ResetResampler( PaUtilResampler *resampler );
+
+
+/** Use the kernel of the fastest available instruction set of
+ instructionSets, a combination of PaUtilSimdInstructionSet values. 0 selects
+ the scalar kernel. PaUtil_InitializeResampler() selects the fastest
+ available kernel; this function is intended for tests and benchmarks.
+*/
+void PaUtil_SelectResamplerKernel( PaUtilResampler *resampler, unsigned int instructionSets );
+
+
+/** The number of source frames which may be written. */
+unsigned long PaUtil_GetResamplerWriteAvailable( PaUtilResampler *resampler );
+
+
+/** Append frameCount interleaved source frames, at most
+ PaUtil_GetResamplerWriteAvailable(). source may be NULL to append silence.
+*/
+void PaUtil_WriteResampler( PaUtilResampler *resampler, const float *source, unsigned long frameCount );
+
+
+/** The number of destination frames which can be read with the source frames
+ written so far.
+*/
+unsigned long PaUtil_GetResamplerReadAvailable( PaUtilResampler *resampler );
+
+
+/** Convert up to frameCount frames to destination, interleaved.
+ @return The number of frames written to destination.
+*/
+unsigned long PaUtil_ReadResampler( PaUtilResampler *resampler, float *destination, unsigned long frameCount );
+
+
+/** The delay of the filter, in source frames. Destination frame n
+ corresponds to source time n * sourceSampleRate / destinationSampleRate,
+ but can only be read once this many source frames past it have been written.
+*/
+double PaUtil_GetResamplerDelay( PaUtilResampler *resampler );
+
+
+/** Return the resampler quality selected by the
+ paSampleRateConversionQualityMask bits of streamFlags.
+*/
+PaUtilResamplerQuality PaUtil_GetResamplerQuality( PaStreamFlags streamFlags );
+
+
+/** The state of a resampling stage, private to pa_resampler.c. */
+typedef struct PaUtilResamplingStage PaUtilResamplingStage;
+
+
+/** Create a stage which converts the sample rate between the host side of a
+ buffer processor and a stream callback.
+
+ The buffer processor must deliver interleaved paFloat32 frames at
+ hostSampleRate, at most maxFramesPerHostBuffer at a time. The stage
+ converts them to userSampleRate and the user's sample formats, and calls
+ streamCallback with framesPerUserBuffer frames, or a size derived from
+ maxFramesPerHostBuffer when it is paFramesPerBufferUnspecified.
+
+ The samples clipped while converting the input to the user's sample format
+ are added to *inputClippedSampleCount.
+
+ @return paNoError, paInsufficientMemory or paSampleFormatNotSupported.
+*/
+PaError PaUtil_CreateResamplingStage( PaUtilResamplingStage **stage,
+        int inputChannelCount, PaSampleFormat userInputSampleFormat,
+        int outputChannelCount, PaSampleFormat userOutputSampleFormat,
+        double userSampleRate, double hostSampleRate, PaStreamFlags streamFlags,
+        unsigned long framesPerUserBuffer, unsigned long maxFramesPerHostBuffer,
+        PaStreamCallback *streamCallback, void *userData,
+        unsigned long *inputClippedSampleCount );
+
+
+/** Free a stage. stage may be NULL. */
+void PaUtil_DestroyResamplingStage( PaUtilResamplingStage *stage );
+
+
+/** Discard all buffered frames, as PaUtil_ResetBufferProcessor() does. */
+void PaUtil_ResetResamplingStage( PaUtilResamplingStage *stage );
+
+
+/** The number of frames passed to the stream callback. */
+unsigned long PaUtil_GetResamplingStageFramesPerUserBuffer( PaUtilResamplingStage *stage );
+
+
+/** The input latency added by the stage, in host frames. */
+unsigned long PaUtil_GetResamplingStageInputLatencyFrames( PaUtilResamplingStage *stage );
+
+
+/** The output latency added by the stage, in host frames. */
+unsigned long PaUtil_GetResamplingStageOutputLatencyFrames( PaUtilResamplingStage *stage );
+
+
+/** The stream callback which the buffer processor calls, with the stage as
+ userData.
+*/
+int PaUtil_ResamplingStageCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData );
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PA_RESAMPLER_H */
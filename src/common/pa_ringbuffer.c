@@ -52,6 +52,10 @@
  @ingroup common_src
 */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* for syscall() and MAP_ANONYMOUS */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
@@ -59,6 +63,118 @@
 #include <string.h>
 #include "pa_memorybarrier.h"
 
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(SYS_memfd_create)
+#define PA_RINGBUFFER_USE_MIRRORING_
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#endif
+#endif
+
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+#define PA_RINGBUFFER_USE_C11_ATOMICS_
+#include <stdatomic.h>
+
+/* The indices are declared volatile rather than _Atomic in pa_ringbuffer.h
+   so that the structure can be used from C++ and pre-C11 code. */
+typedef volatile _Atomic ring_buffer_size_t PaUtilRingBufferAtomicIndex;
+
+typedef char PaUtilRingBufferAtomicIndexSizeCheck[
+        (sizeof(PaUtilRingBufferAtomicIndex) == sizeof(ring_buffer_size_t)) ? 1 : -1 ];
+#endif
+
+/***************************************************************************
+** Index access.
+** An index may only be stored by its owner (writeIndex by the producer,
+** readIndex by the consumer). The owner reads its own index with
+** LoadIndex(). The other side reads it with LoadIndexAcquire() before
+** touching the elements which it describes, and the owner publishes it
+** with StoreIndexRelease() once it is done with them.
+*/
+static ring_buffer_size_t LoadIndex( const volatile ring_buffer_size_t *index )
+{
+#ifdef PA_RINGBUFFER_USE_C11_ATOMICS_
+    return atomic_load_explicit( (PaUtilRingBufferAtomicIndex*)index, memory_order_relaxed );
+#else
+    return *index;
+#endif
+}
+
+static ring_buffer_size_t LoadIndexAcquire( const volatile ring_buffer_size_t *index )
+{
+#ifdef PA_RINGBUFFER_USE_C11_ATOMICS_
+    return atomic_load_explicit( (PaUtilRingBufferAtomicIndex*)index, memory_order_acquire );
+#else
+    ring_buffer_size_t result = *index;
+    /* the elements may be read (read-after-read) or written
+       (write-after-read) next => full barrier */
+    PaUtil_FullMemoryBarrier();
+    return result;
+#endif
+}
+
+static void StoreIndex( volatile ring_buffer_size_t *index, ring_buffer_size_t value )
+{
+#ifdef PA_RINGBUFFER_USE_C11_ATOMICS_
+    atomic_store_explicit( (PaUtilRingBufferAtomicIndex*)index, value, memory_order_relaxed );
+#else
+    *index = value;
+#endif
+}
+
+static void StoreIndexRelease( volatile ring_buffer_size_t *index, ring_buffer_size_t value )
+{
+#ifdef PA_RINGBUFFER_USE_C11_ATOMICS_
+    atomic_store_explicit( (PaUtilRingBufferAtomicIndex*)index, value, memory_order_release );
+#else
+    /* ensure that previous reads or writes of the elements are complete
+       before the index is updated => full barrier */
+    PaUtil_FullMemoryBarrier();
+    *index = value;
+#endif
+}
+
+#if defined(PA_RINGBUFFER_USE_C11_ATOMICS_) || defined(__GNUC__) \
+        || ((_MSC_VER >= 1400) && !defined(_WIN32_WCE))
+#define PA_RINGBUFFER_HAVE_COMPARE_AND_SWAP_
+#endif
+
+/* Store desired in *index if it still holds expected. Returns non-zero if
+   it did. The multi-producer ring buffer only uses it to claim elements, the
+   elements themselves are synchronized through their sequence numbers. */
+static int CompareAndSwapIndex( volatile ring_buffer_size_t *index, ring_buffer_size_t expected, ring_buffer_size_t desired )
+{
+#if defined(PA_RINGBUFFER_USE_C11_ATOMICS_)
+    return atomic_compare_exchange_strong_explicit( (PaUtilRingBufferAtomicIndex*)index, &expected, desired,
+            memory_order_relaxed, memory_order_relaxed );
+#elif defined(__GNUC__)
+    return __sync_bool_compare_and_swap( index, expected, desired );
+#elif defined(PA_RINGBUFFER_HAVE_COMPARE_AND_SWAP_)
+    return _InterlockedCompareExchange( (volatile long*)index, desired, expected ) == expected;
+#else
+    (void)index;
+    (void)expected;
+    (void)desired;
+    return 0;
+#endif
+}
+
+/* The multi-producer indices and sequence numbers count up without masking,
+   so their arithmetic wraps around explicitly. */
+static ring_buffer_size_t AddToIndex( ring_buffer_size_t index, ring_buffer_size_t count )
+{
+    return (ring_buffer_size_t)((unsigned long)index + (unsigned long)count);
+}
+
+static ring_buffer_size_t IndexDistance( ring_buffer_size_t to, ring_buffer_size_t from )
+{
+    return (ring_buffer_size_t)((unsigned long)to - (unsigned long)from);
+}
+
 /***************************************************************************
  * Initialize FIFO.
  * elementCount must be power of 2, returns -1 if not.
@@ -72,14 +188,90 @@ ring_buffer_size_t PaUtil_InitializeRingBuffer( PaUtilRingBuffer *rbuf, ring_buf
     rbuf->bigMask = (elementCount*2)-1;
     rbuf->smallMask = (elementCount)-1;
     rbuf->elementSizeBytes = elementSizeBytes;
+    rbuf->mirroredSizeBytes = 0;
     return 0;
 }
 
+/***************************************************************************
+ * Initialize FIFO in memory which is mapped twice in a row.
+ * Returns -1 if elementCount isn't a power of 2, the buffer isn't a whole
+ * number of pages or the mappings can't be created.
+ */
+ring_buffer_size_t PaUtil_InitializeMirroredRingBuffer( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementSizeBytes, ring_buffer_size_t elementCount )
+{
+#ifdef PA_RINGBUFFER_USE_MIRRORING_
+    long pageSize = sysconf( _SC_PAGESIZE );
+    size_t sizeBytes = (size_t)elementCount * elementSizeBytes;
+    char *address;
+    int fd;
+
+    if( ((elementCount-1) & elementCount) != 0) return -1; /* Not Power of two. */
+    if( pageSize <= 0 || sizeBytes == 0 || (sizeBytes % (size_t)pageSize) != 0 ) return -1;
+
+    fd = (int)syscall( SYS_memfd_create, "portaudio-ringbuffer", MFD_CLOEXEC );
+    if( fd < 0 ) return -1;
+    if( ftruncate( fd, (off_t)sizeBytes ) != 0 )
+    {
+        close( fd );
+        return -1;
+    }
+
+    /* reserve the address range for both copies, then map the file over
+       each half of it */
+    address = (char *)mmap( NULL, sizeBytes * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( address == MAP_FAILED )
+    {
+        close( fd );
+        return -1;
+    }
+    if( mmap( address, sizeBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0 ) == MAP_FAILED
+            || mmap( address + sizeBytes, sizeBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0 ) == MAP_FAILED )
+    {
+        munmap( address, sizeBytes * 2 );
+        close( fd );
+        return -1;
+    }
+    close( fd ); /* the mappings keep the memory alive */
+
+    PaUtil_InitializeRingBuffer( rbuf, elementSizeBytes, elementCount, address );
+    rbuf->mirroredSizeBytes = (ring_buffer_size_t)sizeBytes;
+    return 0;
+#else
+    (void)rbuf;
+    (void)elementSizeBytes;
+    (void)elementCount;
+    return -1;
+#endif
+}
+
+/***************************************************************************
+*/
+void PaUtil_TerminateMirroredRingBuffer( PaUtilRingBuffer *rbuf )
+{
+#ifdef PA_RINGBUFFER_USE_MIRRORING_
+    if( rbuf->mirroredSizeBytes != 0 )
+    {
+        munmap( rbuf->buffer, (size_t)rbuf->mirroredSizeBytes * 2 );
+        rbuf->buffer = NULL;
+        rbuf->mirroredSizeBytes = 0;
+    }
+#else
+    (void)rbuf;
+#endif
+}
+
+/***************************************************************************
+*/
+int PaUtil_IsRingBufferMirrored( const PaUtilRingBuffer *rbuf )
+{
+    return rbuf->mirroredSizeBytes != 0;
+}
+
 /***************************************************************************
 ** Return number of elements available for reading. */
 ring_buffer_size_t PaUtil_GetRingBufferReadAvailable( const PaUtilRingBuffer *rbuf )
 {
-    return ( (rbuf->writeIndex - rbuf->readIndex) & rbuf->bigMask );
+    return ( (LoadIndex( &rbuf->writeIndex ) - LoadIndex( &rbuf->readIndex )) & rbuf->bigMask );
 }
 /***************************************************************************
 ** Return number of elements available for writing. */
@@ -92,12 +284,17 @@ ring_buffer_size_t PaUtil_GetRingBufferWriteAvailable( const PaUtilRingBuffer *r
 ** Clear buffer. Should only be called when buffer is NOT being read or written. */
 void PaUtil_FlushRingBuffer( PaUtilRingBuffer *rbuf )
 {
-    rbuf->writeIndex = rbuf->readIndex = 0;
+    StoreIndex( &rbuf->writeIndex, 0 );
+    StoreIndex( &rbuf->readIndex, 0 );
+    rbuf->cachedReadIndex = 0;
+    rbuf->cachedWriteIndex = 0;
+    PaUtil_FullMemoryBarrier();
 }
 
 /***************************************************************************
 ** Get address of region(s) to which we can write data.
-** If the region is contiguous, size2 will be zero.
+** If the region is contiguous, size2 will be zero. It always is for a mirrored
+** buffer, where the first region may extend into the second mapping.
 ** If non-contiguous, size2 will be the size of second region.
 ** Returns room available to be written or elementCount, whichever is smaller.
 */
@@ -106,11 +303,19 @@ ring_buffer_size_t PaUtil_GetRingBufferWriteRegions( PaUtilRingBuffer *rbuf, rin
                                        void **dataPtr2, ring_buffer_size_t *sizePtr2 )
 {
     ring_buffer_size_t   index;
-    ring_buffer_size_t   available = PaUtil_GetRingBufferWriteAvailable( rbuf );
-    if( elementCount > available ) elementCount = available;
+    ring_buffer_size_t   writeIndex = LoadIndex( &rbuf->writeIndex );
+    ring_buffer_size_t   available = rbuf->bufferSize - ((writeIndex - rbuf->cachedReadIndex) & rbuf->bigMask);
+    if( elementCount > available )
+    {
+        /* only look at the consumer's cache line when our last view of it
+           doesn't leave enough room */
+        rbuf->cachedReadIndex = LoadIndexAcquire( &rbuf->readIndex );
+        available = rbuf->bufferSize - ((writeIndex - rbuf->cachedReadIndex) & rbuf->bigMask);
+        if( elementCount > available ) elementCount = available;
+    }
     /* Check to see if write is not contiguous. */
-    index = rbuf->writeIndex & rbuf->smallMask;
-    if( (index + elementCount) > rbuf->bufferSize )
+    index = writeIndex & rbuf->smallMask;
+    if( (index + elementCount) > rbuf->bufferSize && rbuf->mirroredSizeBytes == 0 )
     {
         /* Write data in two blocks that wrap the buffer. */
         ring_buffer_size_t   firstHalf = rbuf->bufferSize - index;
@@ -127,9 +332,6 @@ ring_buffer_size_t PaUtil_GetRingBufferWriteRegions( PaUtilRingBuffer *rbuf, rin
         *sizePtr2 = 0;
     }
 
-    if( available )
-        PaUtil_FullMemoryBarrier(); /* (write-after-read) => full barrier */
-
     return elementCount;
 }
 
@@ -138,16 +340,16 @@ ring_buffer_size_t PaUtil_GetRingBufferWriteRegions( PaUtilRingBuffer *rbuf, rin
 */
 ring_buffer_size_t PaUtil_AdvanceRingBufferWriteIndex( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementCount )
 {
-    /* ensure that previous writes are seen before we update the write index
-       (write after write)
-    */
-    PaUtil_WriteMemoryBarrier();
-    return rbuf->writeIndex = (rbuf->writeIndex + elementCount) & rbuf->bigMask;
+    ring_buffer_size_t writeIndex = (LoadIndex( &rbuf->writeIndex ) + elementCount) & rbuf->bigMask;
+    /* ensure that previous writes are seen before we update the write index */
+    StoreIndexRelease( &rbuf->writeIndex, writeIndex );
+    return writeIndex;
 }
 
 /***************************************************************************
 ** Get address of region(s) from which we can read data.
-** If the region is contiguous, size2 will be zero.
+** If the region is contiguous, size2 will be zero. It always is for a mirrored
+** buffer, where the first region may extend into the second mapping.
 ** If non-contiguous, size2 will be the size of second region.
 ** Returns room available to be read or elementCount, whichever is smaller.
 */
@@ -156,11 +358,19 @@ ring_buffer_size_t PaUtil_GetRingBufferReadRegions( PaUtilRingBuffer *rbuf, ring
                                 void **dataPtr2, ring_buffer_size_t *sizePtr2 )
 {
     ring_buffer_size_t   index;
-    ring_buffer_size_t   available = PaUtil_GetRingBufferReadAvailable( rbuf ); /* doesn't use memory barrier */
-    if( elementCount > available ) elementCount = available;
+    ring_buffer_size_t   readIndex = LoadIndex( &rbuf->readIndex );
+    ring_buffer_size_t   available = (rbuf->cachedWriteIndex - readIndex) & rbuf->bigMask;
+    if( elementCount > available )
+    {
+        /* only look at the producer's cache line when our last view of it
+           doesn't show enough elements */
+        rbuf->cachedWriteIndex = LoadIndexAcquire( &rbuf->writeIndex );
+        available = (rbuf->cachedWriteIndex - readIndex) & rbuf->bigMask;
+        if( elementCount > available ) elementCount = available;
+    }
     /* Check to see if read is not contiguous. */
-    index = rbuf->readIndex & rbuf->smallMask;
-    if( (index + elementCount) > rbuf->bufferSize )
+    index = readIndex & rbuf->smallMask;
+    if( (index + elementCount) > rbuf->bufferSize && rbuf->mirroredSizeBytes == 0 )
     {
         /* Write data in two blocks that wrap the buffer. */
         ring_buffer_size_t firstHalf = rbuf->bufferSize - index;
@@ -177,20 +387,17 @@ ring_buffer_size_t PaUtil_GetRingBufferReadRegions( PaUtilRingBuffer *rbuf, ring
         *sizePtr2 = 0;
     }
 
-    if( available )
-        PaUtil_ReadMemoryBarrier(); /* (read-after-read) => read barrier */
-
     return elementCount;
 }
 /***************************************************************************
 */
 ring_buffer_size_t PaUtil_AdvanceRingBufferReadIndex( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementCount )
 {
-    /* ensure that previous reads (copies out of the ring buffer) are always completed before updating (writing) the read index.
-       (write-after-read) => full barrier
-    */
-    PaUtil_FullMemoryBarrier();
-    return rbuf->readIndex = (rbuf->readIndex + elementCount) & rbuf->bigMask;
+    ring_buffer_size_t readIndex = (LoadIndex( &rbuf->readIndex ) + elementCount) & rbuf->bigMask;
+    /* ensure that previous reads (copies out of the ring buffer) are always
+       completed before updating (writing) the read index */
+    StoreIndexRelease( &rbuf->readIndex, readIndex );
+    return readIndex;
 }
 
 /***************************************************************************
@@ -235,3 +442,170 @@ ring_buffer_size_t PaUtil_ReadRingBuffer( PaUtilRingBuffer *rbuf, void *data, ri
     PaUtil_AdvanceRingBufferReadIndex( rbuf, numRead );
     return numRead;
 }
+
+/***************************************************************************
+ * Initialize multi-producer FIFO.
+ * elementCount must be power of 2, returns -1 if not.
+ */
+ring_buffer_size_t PaUtil_InitializeMultiRingBuffer( PaUtilMultiRingBuffer *rbuf, ring_buffer_size_t elementSizeBytes,
+                                       ring_buffer_size_t elementCount, void *dataPtr, ring_buffer_size_t *sequencePtr,
+                                       PaUtilMultiRingBufferMode mode )
+{
+    if( ((elementCount-1) & elementCount) != 0) return -1; /* Not Power of two. */
+#ifndef PA_RINGBUFFER_HAVE_COMPARE_AND_SWAP_
+    return -1;
+#endif
+    rbuf->bufferSize = elementCount;
+    rbuf->smallMask = elementCount-1;
+    rbuf->elementSizeBytes = elementSizeBytes;
+    rbuf->mode = mode;
+    rbuf->buffer = (char *)dataPtr;
+    rbuf->sequences = sequencePtr;
+    PaUtil_FlushMultiRingBuffer( rbuf );
+    return 0;
+}
+
+/***************************************************************************
+** Clear buffer. Should only be called when buffer is NOT being read or written. */
+void PaUtil_FlushMultiRingBuffer( PaUtilMultiRingBuffer *rbuf )
+{
+    ring_buffer_size_t i;
+
+    /* element i is free for the producer which claims index i */
+    for( i=0; i < rbuf->bufferSize; ++i )
+        StoreIndex( &rbuf->sequences[i], i );
+    StoreIndex( &rbuf->enqueueIndex, 0 );
+    StoreIndex( &rbuf->dequeueIndex, 0 );
+    PaUtil_FullMemoryBarrier();
+}
+
+/***************************************************************************
+** Return number of elements claimed for writing but not for reading. */
+ring_buffer_size_t PaUtil_GetMultiRingBufferReadAvailable( const PaUtilMultiRingBuffer *rbuf )
+{
+    ring_buffer_size_t dequeueIndex = LoadIndex( &rbuf->dequeueIndex );
+    ring_buffer_size_t available = IndexDistance( LoadIndex( &rbuf->enqueueIndex ), dequeueIndex );
+
+    /* the two loads aren't a consistent snapshot */
+    if( available < 0 ) return 0;
+    if( available > rbuf->bufferSize ) return rbuf->bufferSize;
+    return available;
+}
+
+/***************************************************************************
+** Count the consecutive elements from index on whose sequence number is
+** index + lap, up to maxCount. lap is 0 for elements which are free to be
+** written and 1 for elements which are ready to be read. If the first
+** element isn't, *distance tells how far its sequence number is ahead of
+** (positive) or behind (negative) the one we are looking for.
+*/
+static ring_buffer_size_t CountMultiRingBufferElements( const PaUtilMultiRingBuffer *rbuf, ring_buffer_size_t index,
+                                          ring_buffer_size_t lap, ring_buffer_size_t maxCount, ring_buffer_size_t *distance )
+{
+    ring_buffer_size_t count = 0;
+
+    *distance = 0;
+    while( count < maxCount )
+    {
+        ring_buffer_size_t wanted = AddToIndex( index, count + lap );
+        ring_buffer_size_t d = IndexDistance( LoadIndexAcquire( &rbuf->sequences[AddToIndex( index, count ) & rbuf->smallMask] ), wanted );
+        if( d != 0 )
+        {
+            if( count == 0 ) *distance = d;
+            break;
+        }
+        ++count;
+    }
+    return count;
+}
+
+/***************************************************************************
+** Copy count elements starting at index between the buffer and data,
+** splitting the copy where it wraps. */
+static void CopyMultiRingBufferElements( PaUtilMultiRingBuffer *rbuf, ring_buffer_size_t index,
+                                          ring_buffer_size_t count, void *data, int toBuffer )
+{
+    ring_buffer_size_t first = index & rbuf->smallMask;
+    ring_buffer_size_t size1 = (first + count > rbuf->bufferSize) ? rbuf->bufferSize - first : count;
+    char *region = &rbuf->buffer[first * rbuf->elementSizeBytes];
+    char *rest = (char *)data + size1 * rbuf->elementSizeBytes;
+
+    if( toBuffer )
+    {
+        memcpy( region, data, size1 * rbuf->elementSizeBytes );
+        memcpy( rbuf->buffer, rest, (count - size1) * rbuf->elementSizeBytes );
+    }
+    else
+    {
+        memcpy( data, region, size1 * rbuf->elementSizeBytes );
+        memcpy( rest, rbuf->buffer, (count - size1) * rbuf->elementSizeBytes );
+    }
+}
+
+/***************************************************************************
+** Return elements written. */
+ring_buffer_size_t PaUtil_WriteMultiRingBuffer( PaUtilMultiRingBuffer *rbuf, const void *data, ring_buffer_size_t elementCount )
+{
+    ring_buffer_size_t index, count, distance, i;
+
+    if( elementCount <= 0 ) return 0;
+
+    index = LoadIndex( &rbuf->enqueueIndex );
+    for( ;; )
+    {
+        /* an element is free when its sequence number equals its index. While
+           it is, only the producer which moves enqueueIndex past it can use
+           it, so all free elements found here are ours if the swap succeeds */
+        count = CountMultiRingBufferElements( rbuf, index, 0, elementCount, &distance );
+        if( count == 0 && distance < 0 )
+            return 0; /* the element from the last lap hasn't been read yet, buffer is full */
+        if( count > 0 && CompareAndSwapIndex( &rbuf->enqueueIndex, index, AddToIndex( index, count ) ) )
+            break;
+        index = LoadIndex( &rbuf->enqueueIndex ); /* another producer got there first */
+    }
+
+    CopyMultiRingBufferElements( rbuf, index, count, (void *)data, 1 );
+
+    /* publish the elements to the consumers */
+    for( i=0; i < count; ++i )
+        StoreIndexRelease( &rbuf->sequences[AddToIndex( index, i ) & rbuf->smallMask], AddToIndex( index, i + 1 ) );
+
+    return count;
+}
+
+/***************************************************************************
+** Return elements read. */
+ring_buffer_size_t PaUtil_ReadMultiRingBuffer( PaUtilMultiRingBuffer *rbuf, void *data, ring_buffer_size_t elementCount )
+{
+    ring_buffer_size_t index, count, distance, i;
+
+    if( elementCount <= 0 ) return 0;
+
+    index = LoadIndex( &rbuf->dequeueIndex );
+    for( ;; )
+    {
+        count = CountMultiRingBufferElements( rbuf, index, 1, elementCount, &distance );
+        if( count == 0 && distance < 0 )
+            return 0; /* the next element hasn't been published yet */
+        if( count > 0 )
+        {
+            if( rbuf->mode == paUtilMultiProducerSingleConsumer )
+            {
+                /* nobody else reads, no need to compete for the elements */
+                StoreIndex( &rbuf->dequeueIndex, AddToIndex( index, count ) );
+                break;
+            }
+            if( CompareAndSwapIndex( &rbuf->dequeueIndex, index, AddToIndex( index, count ) ) )
+                break;
+        }
+        index = LoadIndex( &rbuf->dequeueIndex ); /* another consumer got there first */
+    }
+
+    CopyMultiRingBufferElements( rbuf, index, count, data, 0 );
+
+    /* hand the elements back to the producers of the next lap */
+    for( i=0; i < count; ++i )
+        StoreIndexRelease( &rbuf->sequences[AddToIndex( index, i ) & rbuf->smallMask], AddToIndex( index, i + rbuf->bufferSize ) );
+
+    return count;
+}
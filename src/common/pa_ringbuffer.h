@@ -50,7 +50,8 @@
 
 /** @file
  @ingroup common_src
- @brief Single-reader single-writer lock-free ring buffer
+ @brief Single-reader single-writer lock-free ring buffer, and a variant
+ for several writers
 
  PaUtilRingBuffer is a ring buffer used to transport samples between
  different execution contexts (threads, OS callbacks, interrupt handlers)
@@ -64,7 +65,22 @@
 
  The memory area used to store the buffer elements must be allocated by
  the client prior to calling PaUtil_InitializeRingBuffer() and must outlive
- the use of the ring buffer.
+ the use of the ring buffer. Alternatively PaUtil_InitializeMirroredRingBuffer()
+ maps the buffer memory twice in a row, so that every region returned by
+ PaUtil_GetRingBufferWriteRegions() and PaUtil_GetRingBufferReadRegions() is
+ contiguous and can be used in place without handling the wrap.
+
+ PaUtilMultiRingBuffer is a variant for several writers (and optionally
+ several readers). It uses the same element-size and power-of-two model, but
+ every element carries a sequence number, so that a writer can fill the
+ elements it has claimed while other writers fill theirs.
+
+ When the compiler supports C11 atomics the indices are published with
+ acquire/release operations, otherwise the barriers from pa_memorybarrier.h
+ are used. The write index and the read index are kept on separate cache
+ lines, and each side keeps a private copy of the other side's index which
+ is only refreshed when it doesn't show enough elements, so the producer and
+ the consumer rarely touch each other's cache line.
 
  @note The ring buffer functions are not normally exposed in the PortAudio libraries.
  If you want to call them then you will need to add pa_ringbuffer.c to your application source code.
@@ -90,15 +106,29 @@ extern "C"
 {
 #endif /* __cplusplus */
 
+/** The number of bytes which separate the fields written by the producer
+ from those written by the consumer, so that they never share a cache line.
+*/
+#define PA_RINGBUFFER_CACHE_LINE_SIZE (64)
+
 typedef struct PaUtilRingBuffer
 {
     ring_buffer_size_t  bufferSize; /**< Number of elements in FIFO. Power of 2. Set by PaUtil_InitRingBuffer. */
-    volatile ring_buffer_size_t  writeIndex; /**< Index of next writable element. Set by PaUtil_AdvanceRingBufferWriteIndex. */
-    volatile ring_buffer_size_t  readIndex;  /**< Index of next readable element. Set by PaUtil_AdvanceRingBufferReadIndex. */
     ring_buffer_size_t  bigMask;    /**< Used for wrapping indices with extra bit to distinguish full/empty. */
     ring_buffer_size_t  smallMask;  /**< Used for fitting indices to buffer. */
     ring_buffer_size_t  elementSizeBytes; /**< Number of bytes per element. */
     char  *buffer;    /**< Pointer to the buffer containing the actual data. */
+    ring_buffer_size_t  mirroredSizeBytes; /**< Size of each of the two mappings of a mirrored buffer, 0 otherwise. */
+
+    char  producerPadding[PA_RINGBUFFER_CACHE_LINE_SIZE];
+    volatile ring_buffer_size_t  writeIndex; /**< Index of next writable element. Set by PaUtil_AdvanceRingBufferWriteIndex. */
+    ring_buffer_size_t  cachedReadIndex; /**< The producer's last view of readIndex. Only accessed by the producer. */
+
+    char  consumerPadding[PA_RINGBUFFER_CACHE_LINE_SIZE];
+    volatile ring_buffer_size_t  readIndex;  /**< Index of next readable element. Set by PaUtil_AdvanceRingBufferReadIndex. */
+    ring_buffer_size_t  cachedWriteIndex; /**< The consumer's last view of writeIndex. Only accessed by the consumer. */
+
+    char  trailingPadding[PA_RINGBUFFER_CACHE_LINE_SIZE];
 }PaUtilRingBuffer;
 
 /** Initialize Ring Buffer to empty state ready to have elements written to it.
@@ -116,6 +146,45 @@ typedef struct PaUtilRingBuffer
 */
 ring_buffer_size_t PaUtil_InitializeRingBuffer( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementSizeBytes, ring_buffer_size_t elementCount, void *dataPtr );
 
+/** Initialize a mirrored Ring Buffer to empty state ready to have elements
+ written to it. The buffer memory is allocated by the ring buffer and mapped
+ twice at consecutive addresses, so that an element range which wraps around
+ the end of the buffer is also readable and writable as one contiguous block.
+ Mirrored ring buffers are currently only available on Linux.
+
+ @param rbuf The ring buffer.
+
+ @param elementSizeBytes The size of a single data element in bytes.
+
+ @param elementCount The number of elements in the buffer (must be a power of
+ 2). elementCount * elementSizeBytes must be a multiple of the system page size.
+
+ @return -1 if elementCount is not a power of 2, the buffer size is not a
+ multiple of the page size or the buffer could not be mapped, otherwise 0.
+ Callers can fall back to PaUtil_InitializeRingBuffer() if -1 is returned.
+
+ @see PaUtil_TerminateMirroredRingBuffer
+*/
+ring_buffer_size_t PaUtil_InitializeMirroredRingBuffer( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementSizeBytes, ring_buffer_size_t elementCount );
+
+/** Release the memory of a ring buffer initialized with
+ PaUtil_InitializeMirroredRingBuffer(). Does nothing if the ring buffer is
+ not mirrored.
+
+ @param rbuf The ring buffer.
+*/
+void PaUtil_TerminateMirroredRingBuffer( PaUtilRingBuffer *rbuf );
+
+/** Determine whether a ring buffer was initialized with
+ PaUtil_InitializeMirroredRingBuffer(), in which case the regions returned
+ for reading and writing are always contiguous.
+
+ @param rbuf The ring buffer.
+
+ @return Non-zero if the ring buffer is mirrored, otherwise 0.
+*/
+int PaUtil_IsRingBufferMirrored( const PaUtilRingBuffer *rbuf );
+
 /** Reset buffer to empty. Should only be called when buffer is NOT being read or written.
 
  @param rbuf The ring buffer.
@@ -175,7 +244,8 @@ ring_buffer_size_t PaUtil_ReadRingBuffer( PaUtilRingBuffer *rbuf, void *data, ri
  stored.
 
  @param dataPtr2 The address where the second region pointer will be stored if
- the first region is too small to satisfy elementCount.
+ the first region is too small to satisfy elementCount. The second region is
+ always empty for a mirrored ring buffer.
 
  @param sizePtr2 The address where the second region length will be stored if
  the first region is too small to satisfy elementCount.
@@ -209,7 +279,8 @@ ring_buffer_size_t PaUtil_AdvanceRingBufferWriteIndex( PaUtilRingBuffer *rbuf, r
  stored.
 
  @param dataPtr2 The address where the second region pointer will be stored if
- the first region is too small to satisfy elementCount.
+ the first region is too small to satisfy elementCount. The second region is
+ always empty for a mirrored ring buffer.
 
  @param sizePtr2 The address where the second region length will be stored if
  the first region is too small to satisfy elementCount.
@@ -230,6 +301,114 @@ ring_buffer_size_t PaUtil_GetRingBufferReadRegions( PaUtilRingBuffer *rbuf, ring
 */
 ring_buffer_size_t PaUtil_AdvanceRingBufferReadIndex( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementCount );
 
+/** Whether a PaUtilMultiRingBuffer may be read by more than one thread.
+ A single consumer doesn't need to compete for elements, which makes reading
+ cheaper.
+*/
+typedef enum PaUtilMultiRingBufferMode
+{
+    paUtilMultiProducerSingleConsumer = 0,
+    paUtilMultiProducerMultiConsumer
+} PaUtilMultiRingBufferMode;
+
+/** A bounded lock-free queue of fixed-size elements for several producers.
+
+ Producers claim a run of free elements by advancing enqueueIndex, copy them
+ in and then publish each one by advancing its sequence number. Consumers
+ claim published elements by advancing dequeueIndex, copy them out and
+ advance their sequence numbers by the buffer size to hand them back to the
+ producers.
+*/
+typedef struct PaUtilMultiRingBuffer
+{
+    ring_buffer_size_t  bufferSize; /**< Number of elements in FIFO. Power of 2. */
+    ring_buffer_size_t  smallMask;  /**< Used for fitting indices to buffer. */
+    ring_buffer_size_t  elementSizeBytes; /**< Number of bytes per element. */
+    PaUtilMultiRingBufferMode  mode;
+    char  *buffer;    /**< Pointer to the buffer containing the actual data. */
+    volatile ring_buffer_size_t  *sequences; /**< Sequence number of each element. */
+
+    char  producerPadding[PA_RINGBUFFER_CACHE_LINE_SIZE];
+    volatile ring_buffer_size_t  enqueueIndex; /**< Index of the next element to be claimed by a producer. */
+
+    char  consumerPadding[PA_RINGBUFFER_CACHE_LINE_SIZE];
+    volatile ring_buffer_size_t  dequeueIndex; /**< Index of the next element to be claimed by a consumer. */
+
+    char  trailingPadding[PA_RINGBUFFER_CACHE_LINE_SIZE];
+}PaUtilMultiRingBuffer;
+
+/** Initialize a multi-producer Ring Buffer to empty state ready to have
+ elements written to it.
+
+ @param rbuf The ring buffer.
+
+ @param elementSizeBytes The size of a single data element in bytes.
+
+ @param elementCount The number of elements in the buffer (must be a power of 2).
+
+ @param dataPtr A pointer to a previously allocated area where the data
+ will be maintained. It must be elementCount*elementSizeBytes long.
+
+ @param sequencePtr A pointer to a previously allocated array of elementCount
+ ring_buffer_size_t values, used to hold the sequence numbers.
+
+ @param mode Whether the ring buffer will be read by one or several threads.
+
+ @return -1 if elementCount is not a power of 2 or the platform has no atomic
+ compare-and-swap, otherwise 0.
+*/
+ring_buffer_size_t PaUtil_InitializeMultiRingBuffer( PaUtilMultiRingBuffer *rbuf, ring_buffer_size_t elementSizeBytes,
+                                       ring_buffer_size_t elementCount, void *dataPtr, ring_buffer_size_t *sequencePtr,
+                                       PaUtilMultiRingBufferMode mode );
+
+/** Reset buffer to empty. Should only be called when buffer is NOT being read or written.
+
+ @param rbuf The ring buffer.
+*/
+void PaUtil_FlushMultiRingBuffer( PaUtilMultiRingBuffer *rbuf );
+
+/** Retrieve the number of elements in the ring buffer which have been
+ claimed by producers but not yet by consumers. The value is only a snapshot
+ when other threads are using the buffer, and includes elements which are
+ still being copied in.
+
+ @param rbuf The ring buffer.
+
+ @return The number of elements available for reading.
+*/
+ring_buffer_size_t PaUtil_GetMultiRingBufferReadAvailable( const PaUtilMultiRingBuffer *rbuf );
+
+/** Write data to the ring buffer. May be called from several threads at once.
+ The elements written by one call are consecutive in the ring buffer, but may
+ be fewer than requested, in which case the remaining elements can end up
+ after those of other threads.
+
+ @param rbuf The ring buffer.
+
+ @param data The address of new data to write to the buffer.
+
+ @param elementCount The number of elements to be written.
+
+ @return The number of elements written, which is less than elementCount if
+ the ring buffer became full.
+*/
+ring_buffer_size_t PaUtil_WriteMultiRingBuffer( PaUtilMultiRingBuffer *rbuf, const void *data, ring_buffer_size_t elementCount );
+
+/** Read data from the ring buffer. May only be called from several threads
+ at once if the ring buffer was initialized with
+ paUtilMultiProducerMultiConsumer.
+
+ @param rbuf The ring buffer.
+
+ @param data The address where the data should be stored.
+
+ @param elementCount The number of elements to be read.
+
+ @return The number of elements read, which is less than elementCount if no
+ more elements were ready.
+*/
+ring_buffer_size_t PaUtil_ReadMultiRingBuffer( PaUtilMultiRingBuffer *rbuf, void *data, ring_buffer_size_t elementCount );
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
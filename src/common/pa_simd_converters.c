@@ -0,0 +1,1645 @@
+/*
+ * $Id$
+ * Portable Audio I/O Library sample conversion mechanism
+ * SIMD implementations of selected sample converters
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief SIMD implementations of the Float32 and Float64 to Int32, Int24,
+ Int24In32 and Int16 converters, Float64 to Float32 and the packed Int24
+ converters.
+
+ Each instruction set supplies a small set of kernels which convert a block
+ of floats or doubles to 32 bit integers. The converters defined here gather strided
+ source samples into blocks, generate dither for the whole block using the
+ same generator (and in the same order) as the reference converters, run the
+ kernel and scatter the results to the destination format. This keeps the
+ results bit-identical to pa_converters.c while letting the arithmetic run
+ several samples at a time.
+
+ Packed 3 byte samples are split and assembled with byte shuffles, 16
+ samples (three 128 bit vectors) or 32 samples (three 256 bit vectors) at a
+ time, with a scalar tail.
+
+ Kernels are compiled for SSE2, SSSE3 and AVX2 on x86 (selected at runtime
+ using CPUID), and for any architecture using the GCC/Clang vector extensions.
+
+ Define PA_NO_SIMD_CONVERTERS to compile none of them.
+*/
+
+#include <string.h>
+
+#include "pa_simd_converters.h"
+#include "pa_dither.h"
+#include "pa_endianness.h"
+#include "pa_types.h"
+
+
+#ifndef PA_NO_SIMD_CONVERTERS
+
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__)) && \
+        (defined(__x86_64__) || defined(__i386__))
+#define PA_SIMD_X86_
+#define PA_SIMD_TARGET_SSE2_ __attribute__((target("sse2")))
+#define PA_SIMD_TARGET_SSSE3_ __attribute__((target("ssse3")))
+#define PA_SIMD_TARGET_AVX2_ __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (_MSC_VER >= 1800) && (defined(_M_X64) || defined(_M_IX86))
+#define PA_SIMD_X86_
+#define PA_SIMD_TARGET_SSE2_
+#define PA_SIMD_TARGET_SSSE3_
+#define PA_SIMD_TARGET_AVX2_
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__has_builtin)
+#if __has_builtin(__builtin_convertvector)
+#define PA_SIMD_GENERIC_
+#endif
+#endif
+
+#endif /* PA_NO_SIMD_CONVERTERS */
+
+
+#if defined(PA_SIMD_X86_) || defined(PA_SIMD_GENERIC_)
+
+/* -------------------------------------------------------------------------- */
+
+/* The Float32 kernels convert count floats from in to out. count is always
+    a multiple of PA_SIMD_KERNEL_ALIGN_. The Int24 kernels accept any count and
+    finish with a scalar tail. No pointer needs to be aligned.
+*/
+
+#define PA_SIMD_KERNEL_ALIGN_   (8)
+#define PA_SIMD_BLOCK_SIZE_     (64)
+
+#define PA_SIMD_DITHER_         (0x01)
+#define PA_SIMD_CLIP_           (0x02)
+#define PA_SIMD_INT24_IN_32_    (0x04) /* Int32 converters: shift right by 8 bits */
+
+/* The integer kernels return the number of samples which were out of range,
+    counted as the reference converters do (see PA_CLIP_AND_COUNT_ in
+    pa_converters.c): a sample is counted when truncating it would overflow,
+    NaNs included. The clipping kernels only count when clip is non-zero. */
+
+typedef struct PaUtilSimdKernels
+{
+    /* out[i] = (PaInt32)(in[i] * scale + dither[i]) evaluated in single
+        precision. When clip is non-zero the result is clamped to the Int16
+        range. dither may be NULL. */
+    unsigned int (*Float32ToInt16Range)( PaInt32 *out, const float *in, const float *dither,
+            unsigned int count, float scale, int clip );
+
+    /* out[i] = (PaInt32)(in[i] * 2147483648.f) saturated to the Int32 range. */
+    unsigned int (*Float32ToInt32Saturate)( PaInt32 *out, const float *in, unsigned int count );
+
+    /* out[i] = (PaInt32)((double)in[i] * scale + dither[i]) evaluated in
+        double precision. When clip is non-zero the result is clamped to the
+        Int32 range. dither may be NULL. */
+    unsigned int (*Float32ToInt32Double)( PaInt32 *out, const float *in, const float *dither,
+            unsigned int count, double scale, int clip );
+
+    /* out[i] = (PaInt32)(in[i] * scale + dither[i]) evaluated in double
+        precision. When clip is non-zero the result is clamped to
+        [minimum, maximum]. dither may be NULL. */
+    unsigned int (*Float64ToInt32)( PaInt32 *out, const double *in, const float *dither,
+            unsigned int count, double scale, double minimum, double maximum, int clip );
+
+    /* out[i] = (float)in[i] */
+    void (*Float64ToFloat32)( float *out, const double *in, unsigned int count );
+
+    /* Packed little endian 3 byte samples to and from left aligned 32 bit
+        integers. NULL for kernel sets without byte shuffles. */
+    void (*UnpackInt24)( PaInt32 *out, const unsigned char *in, unsigned int count );
+    void (*UnpackInt24ToFloat32)( float *out, const unsigned char *in, unsigned int count );
+    void (*PackInt24)( unsigned char *out, const PaInt32 *in, unsigned int count );
+} PaUtilSimdKernels;
+
+
+static void PackInt24Scalar( unsigned char *out, const PaInt32 *in, unsigned int count )
+{
+    PaInt32 temp;
+
+    while( count-- )
+    {
+        temp = *in++;
+#if defined(PA_LITTLE_ENDIAN)
+        out[0] = (unsigned char)(temp >> 8);
+        out[1] = (unsigned char)(temp >> 16);
+        out[2] = (unsigned char)(temp >> 24);
+#elif defined(PA_BIG_ENDIAN)
+        out[0] = (unsigned char)(temp >> 24);
+        out[1] = (unsigned char)(temp >> 16);
+        out[2] = (unsigned char)(temp >> 8);
+#endif
+        out += 3;
+    }
+}
+
+#endif /* PA_SIMD_X86_ || PA_SIMD_GENERIC_ */
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef PA_SIMD_X86_
+
+static void UnpackInt24Scalar( PaInt32 *out, const unsigned char *in, unsigned int count )
+{
+    PaInt32 temp;
+
+    while( count-- )
+    {
+#if defined(PA_LITTLE_ENDIAN)
+        temp = (((PaInt32)in[0]) << 8);
+        temp = temp | (((PaInt32)in[1]) << 16);
+        temp = temp | (((PaInt32)in[2]) << 24);
+#elif defined(PA_BIG_ENDIAN)
+        temp = (((PaInt32)in[0]) << 24);
+        temp = temp | (((PaInt32)in[1]) << 16);
+        temp = temp | (((PaInt32)in[2]) << 8);
+#endif
+        *out++ = temp;
+        in += 3;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* The clipped sample counts are accumulated by subtracting compare masks
+    (-1 per lane) from a vector. 64 bit lanes hold counts far below 2^32, so
+    summing them as 32 bit lanes gives the same result. */
+PA_SIMD_TARGET_SSE2_
+static unsigned int Sse2_Sum( __m128i counts )
+{
+    PaInt32 lanes[4];
+
+    _mm_storeu_si128( (__m128i*)lanes, counts );
+    return (unsigned int)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+
+PA_SIMD_TARGET_SSE2_
+static unsigned int Sse2_Float32ToInt16Range( PaInt32 *out, const float *in, const float *dither,
+        unsigned int count, float scale, int clip )
+{
+    const __m128 s = _mm_set1_ps( scale );
+    const __m128 lo = _mm_set1_ps( -32768.f );
+    const __m128 hi = _mm_set1_ps( 32767.f );
+    const __m128 below = _mm_set1_ps( -32769.f );
+    const __m128 above = _mm_set1_ps( 32768.f );
+    __m128i clipped = _mm_setzero_si128();
+    unsigned int i;
+
+    for( i=0; i < count; i += 4 )
+    {
+        __m128 v = _mm_mul_ps( _mm_loadu_ps( in + i ), s );
+        if( dither )
+            v = _mm_add_ps( v, _mm_loadu_ps( dither + i ) );
+        if( clip ) /* max() maps NaN to lo, as the reference converters do on x86 */
+        {
+            clipped = _mm_sub_epi32( clipped, _mm_castps_si128( _mm_or_ps(
+                    _mm_cmpngt_ps( v, below ), _mm_cmpge_ps( v, above ) ) ) );
+            v = _mm_min_ps( _mm_max_ps( v, lo ), hi );
+        }
+        _mm_storeu_si128( (__m128i*)(out + i), _mm_cvttps_epi32( v ) );
+    }
+
+    return Sse2_Sum( clipped );
+}
+
+PA_SIMD_TARGET_SSE2_
+static unsigned int Sse2_Float32ToInt32Saturate( PaInt32 *out, const float *in, unsigned int count )
+{
+    const __m128 s = _mm_set1_ps( 2147483648.f );
+    const __m128 lo = _mm_set1_ps( -2147483648.f );
+    __m128i clipped = _mm_setzero_si128();
+    unsigned int i;
+
+    for( i=0; i < count; i += 4 )
+    {
+        __m128 v = _mm_mul_ps( _mm_loadu_ps( in + i ), s );
+        __m128 overflow = _mm_cmpge_ps( v, s );
+        /* cvttps returns 0x80000000 for all out of range values, flipping
+            the bits of the positive overflows gives 0x7FFFFFFF */
+        __m128i r = _mm_cvttps_epi32( v );
+        r = _mm_xor_si128( r, _mm_castps_si128( overflow ) );
+        _mm_storeu_si128( (__m128i*)(out + i), r );
+        clipped = _mm_sub_epi32( clipped, _mm_castps_si128(
+                _mm_or_ps( overflow, _mm_cmpnge_ps( v, lo ) ) ) );
+    }
+
+    return Sse2_Sum( clipped );
+}
+
+PA_SIMD_TARGET_SSE2_
+static unsigned int Sse2_Float32ToInt32Double( PaInt32 *out, const float *in, const float *dither,
+        unsigned int count, double scale, int clip )
+{
+    const __m128d s = _mm_set1_pd( scale );
+    const __m128d lo = _mm_set1_pd( -2147483648. );
+    const __m128d hi = _mm_set1_pd( 2147483647. );
+    const __m128d below = _mm_set1_pd( -2147483649. );
+    const __m128d above = _mm_set1_pd( 2147483648. );
+    __m128i clipped = _mm_setzero_si128();
+    unsigned int i;
+
+    for( i=0; i < count; i += 4 )
+    {
+        __m128 f = _mm_loadu_ps( in + i );
+        __m128d d0 = _mm_mul_pd( _mm_cvtps_pd( f ), s );
+        __m128d d1 = _mm_mul_pd( _mm_cvtps_pd( _mm_movehl_ps( f, f ) ), s );
+        if( dither )
+        {
+            __m128 g = _mm_loadu_ps( dither + i );
+            d0 = _mm_add_pd( d0, _mm_cvtps_pd( g ) );
+            d1 = _mm_add_pd( d1, _mm_cvtps_pd( _mm_movehl_ps( g, g ) ) );
+        }
+        if( clip )
+        {
+            clipped = _mm_sub_epi64( clipped, _mm_castpd_si128( _mm_or_pd(
+                    _mm_cmpngt_pd( d0, below ), _mm_cmpge_pd( d0, above ) ) ) );
+            clipped = _mm_sub_epi64( clipped, _mm_castpd_si128( _mm_or_pd(
+                    _mm_cmpngt_pd( d1, below ), _mm_cmpge_pd( d1, above ) ) ) );
+            d0 = _mm_min_pd( _mm_max_pd( d0, lo ), hi );
+            d1 = _mm_min_pd( _mm_max_pd( d1, lo ), hi );
+        }
+        _mm_storeu_si128( (__m128i*)(out + i),
+                _mm_unpacklo_epi64( _mm_cvttpd_epi32( d0 ), _mm_cvttpd_epi32( d1 ) ) );
+    }
+
+    return Sse2_Sum( clipped );
+}
+
+PA_SIMD_TARGET_SSE2_
+static unsigned int Sse2_Float64ToInt32( PaInt32 *out, const double *in, const float *dither,
+        unsigned int count, double scale, double minimum, double maximum, int clip )
+{
+    const __m128d s = _mm_set1_pd( scale );
+    const __m128d lo = _mm_set1_pd( minimum );
+    const __m128d hi = _mm_set1_pd( maximum );
+    const __m128d below = _mm_set1_pd( minimum - 1. );
+    const __m128d above = _mm_set1_pd( maximum + 1. );
+    __m128i clipped = _mm_setzero_si128();
+    unsigned int i;
+
+    for( i=0; i < count; i += 4 )
+    {
+        __m128d d0 = _mm_mul_pd( _mm_loadu_pd( in + i ), s );
+        __m128d d1 = _mm_mul_pd( _mm_loadu_pd( in + i + 2 ), s );
+        if( dither )
+        {
+            __m128 g = _mm_loadu_ps( dither + i );
+            d0 = _mm_add_pd( d0, _mm_cvtps_pd( g ) );
+            d1 = _mm_add_pd( d1, _mm_cvtps_pd( _mm_movehl_ps( g, g ) ) );
+        }
+        if( clip )
+        {
+            clipped = _mm_sub_epi64( clipped, _mm_castpd_si128( _mm_or_pd(
+                    _mm_cmpngt_pd( d0, below ), _mm_cmpge_pd( d0, above ) ) ) );
+            clipped = _mm_sub_epi64( clipped, _mm_castpd_si128( _mm_or_pd(
+                    _mm_cmpngt_pd( d1, below ), _mm_cmpge_pd( d1, above ) ) ) );
+            d0 = _mm_min_pd( _mm_max_pd( d0, lo ), hi );
+            d1 = _mm_min_pd( _mm_max_pd( d1, lo ), hi );
+        }
+        _mm_storeu_si128( (__m128i*)(out + i),
+                _mm_unpacklo_epi64( _mm_cvttpd_epi32( d0 ), _mm_cvttpd_epi32( d1 ) ) );
+    }
+
+    return Sse2_Sum( clipped );
+}
+
+PA_SIMD_TARGET_SSE2_
+static void Sse2_Float64ToFloat32( float *out, const double *in, unsigned int count )
+{
+    unsigned int i;
+
+    for( i=0; i < count; i += 4 )
+    {
+        _mm_storeu_ps( out + i, _mm_movelh_ps( _mm_cvtpd_ps( _mm_loadu_pd( in + i ) ),
+                _mm_cvtpd_ps( _mm_loadu_pd( in + i + 2 ) ) ) );
+    }
+}
+
+static const PaUtilSimdKernels Sse2Kernels_ = {
+    Sse2_Float32ToInt16Range,
+    Sse2_Float32ToInt32Saturate,
+    Sse2_Float32ToInt32Double,
+    Sse2_Float64ToInt32,
+    Sse2_Float64ToFloat32,
+    NULL,
+    NULL,
+    NULL
+};
+
+/* -------------------------------------------------------------------------- */
+
+/* pshufb mask expanding four packed 3 byte samples in the low 12 bytes to
+    four left aligned 32 bit integers (-1 produces a zero byte) */
+#define PA_SIMD_UNPACK_INT24_MASK_ \
+    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11
+
+/* the inverse, leaving the upper 4 bytes zero */
+#define PA_SIMD_PACK_INT24_MASK_ \
+    1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1
+
+PA_SIMD_TARGET_SSSE3_
+static void Ssse3_UnpackInt24( PaInt32 *out, const unsigned char *in, unsigned int count )
+{
+    const __m128i mask = _mm_setr_epi8( PA_SIMD_UNPACK_INT24_MASK_ );
+
+    /* 16 samples are exactly three vectors */
+    for( ; count >= 16; count -= 16 )
+    {
+        __m128i a = _mm_loadu_si128( (const __m128i*)in );
+        __m128i b = _mm_loadu_si128( (const __m128i*)(in + 16) );
+        __m128i c = _mm_loadu_si128( (const __m128i*)(in + 32) );
+
+        _mm_storeu_si128( (__m128i*)out, _mm_shuffle_epi8( a, mask ) );
+        _mm_storeu_si128( (__m128i*)(out + 4), _mm_shuffle_epi8( _mm_alignr_epi8( b, a, 12 ), mask ) );
+        _mm_storeu_si128( (__m128i*)(out + 8), _mm_shuffle_epi8( _mm_alignr_epi8( c, b, 8 ), mask ) );
+        _mm_storeu_si128( (__m128i*)(out + 12), _mm_shuffle_epi8( _mm_srli_si128( c, 4 ), mask ) );
+
+        in += 48;
+        out += 16;
+    }
+
+    UnpackInt24Scalar( out, in, count );
+}
+
+PA_SIMD_TARGET_SSSE3_
+static void Ssse3_UnpackInt24ToFloat32( float *out, const unsigned char *in, unsigned int count )
+{
+    PaInt32 block[16];
+    const __m128 scale = _mm_set1_ps( 1.f / 2147483648.f );
+    unsigned int i;
+
+    while( count > 0 )
+    {
+        unsigned int n = ( count < 16 ) ? count : 16;
+
+        Ssse3_UnpackInt24( block, in, n );
+        /* 24 significant bits and a power of two scale, so this is exact
+            and matches the double precision reference */
+        for( i=0; i + 4 <= n; i += 4 )
+            _mm_storeu_ps( out + i, _mm_mul_ps( _mm_cvtepi32_ps(
+                    _mm_loadu_si128( (const __m128i*)(block + i) ) ), scale ) );
+        for( ; i < n; ++i )
+            out[i] = (float)((double)block[i] * (1.0 / 2147483648.0));
+
+        in += n * 3;
+        out += n;
+        count -= n;
+    }
+}
+
+PA_SIMD_TARGET_SSSE3_
+static void Ssse3_PackInt24( unsigned char *out, const PaInt32 *in, unsigned int count )
+{
+    const __m128i mask = _mm_setr_epi8( PA_SIMD_PACK_INT24_MASK_ );
+
+    for( ; count >= 16; count -= 16 )
+    {
+        __m128i a = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)in ), mask );
+        __m128i b = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(in + 4) ), mask );
+        __m128i c = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(in + 8) ), mask );
+        __m128i d = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(in + 12) ), mask );
+
+        _mm_storeu_si128( (__m128i*)out, _mm_or_si128( a, _mm_slli_si128( b, 12 ) ) );
+        _mm_storeu_si128( (__m128i*)(out + 16), _mm_or_si128( _mm_srli_si128( b, 4 ), _mm_slli_si128( c, 8 ) ) );
+        _mm_storeu_si128( (__m128i*)(out + 32), _mm_or_si128( _mm_srli_si128( c, 8 ), _mm_slli_si128( d, 4 ) ) );
+
+        in += 16;
+        out += 48;
+    }
+
+    PackInt24Scalar( out, in, count );
+}
+
+static const PaUtilSimdKernels Ssse3Kernels_ = {
+    Sse2_Float32ToInt16Range,
+    Sse2_Float32ToInt32Saturate,
+    Sse2_Float32ToInt32Double,
+    Sse2_Float64ToInt32,
+    Sse2_Float64ToFloat32,
+    Ssse3_UnpackInt24,
+    Ssse3_UnpackInt24ToFloat32,
+    Ssse3_PackInt24
+};
+
+/* -------------------------------------------------------------------------- */
+
+PA_SIMD_TARGET_AVX2_
+static unsigned int Avx2_Sum( __m256i counts )
+{
+    return Sse2_Sum( _mm_add_epi32( _mm256_castsi256_si128( counts ),
+            _mm256_extracti128_si256( counts, 1 ) ) );
+}
+
+PA_SIMD_TARGET_AVX2_
+static unsigned int Avx2_Float32ToInt16Range( PaInt32 *out, const float *in, const float *dither,
+        unsigned int count, float scale, int clip )
+{
+    const __m256 s = _mm256_set1_ps( scale );
+    const __m256 lo = _mm256_set1_ps( -32768.f );
+    const __m256 hi = _mm256_set1_ps( 32767.f );
+    const __m256 below = _mm256_set1_ps( -32769.f );
+    const __m256 above = _mm256_set1_ps( 32768.f );
+    __m256i clipped = _mm256_setzero_si256();
+    unsigned int i;
+
+    for( i=0; i < count; i += 8 )
+    {
+        __m256 v = _mm256_mul_ps( _mm256_loadu_ps( in + i ), s );
+        if( dither )
+            v = _mm256_add_ps( v, _mm256_loadu_ps( dither + i ) );
+        if( clip )
+        {
+            clipped = _mm256_sub_epi32( clipped, _mm256_castps_si256( _mm256_or_ps(
+                    _mm256_cmp_ps( v, below, _CMP_NGT_UQ ), _mm256_cmp_ps( v, above, _CMP_GE_OQ ) ) ) );
+            v = _mm256_min_ps( _mm256_max_ps( v, lo ), hi );
+        }
+        _mm256_storeu_si256( (__m256i*)(out + i), _mm256_cvttps_epi32( v ) );
+    }
+
+    return Avx2_Sum( clipped );
+}
+
+PA_SIMD_TARGET_AVX2_
+static unsigned int Avx2_Float32ToInt32Saturate( PaInt32 *out, const float *in, unsigned int count )
+{
+    const __m256 s = _mm256_set1_ps( 2147483648.f );
+    const __m256 lo = _mm256_set1_ps( -2147483648.f );
+    __m256i clipped = _mm256_setzero_si256();
+    unsigned int i;
+
+    for( i=0; i < count; i += 8 )
+    {
+        __m256 v = _mm256_mul_ps( _mm256_loadu_ps( in + i ), s );
+        __m256 overflow = _mm256_cmp_ps( v, s, _CMP_GE_OQ );
+        __m256i r = _mm256_cvttps_epi32( v );
+        r = _mm256_xor_si256( r, _mm256_castps_si256( overflow ) );
+        _mm256_storeu_si256( (__m256i*)(out + i), r );
+        clipped = _mm256_sub_epi32( clipped, _mm256_castps_si256(
+                _mm256_or_ps( overflow, _mm256_cmp_ps( v, lo, _CMP_NGE_UQ ) ) ) );
+    }
+
+    return Avx2_Sum( clipped );
+}
+
+PA_SIMD_TARGET_AVX2_
+static unsigned int Avx2_Float32ToInt32Double( PaInt32 *out, const float *in, const float *dither,
+        unsigned int count, double scale, int clip )
+{
+    const __m256d s = _mm256_set1_pd( scale );
+    const __m256d lo = _mm256_set1_pd( -2147483648. );
+    const __m256d hi = _mm256_set1_pd( 2147483647. );
+    const __m256d below = _mm256_set1_pd( -2147483649. );
+    const __m256d above = _mm256_set1_pd( 2147483648. );
+    __m256i clipped = _mm256_setzero_si256();
+    unsigned int i;
+
+    for( i=0; i < count; i += 4 )
+    {
+        __m256d d = _mm256_mul_pd( _mm256_cvtps_pd( _mm_loadu_ps( in + i ) ), s );
+        if( dither )
+            d = _mm256_add_pd( d, _mm256_cvtps_pd( _mm_loadu_ps( dither + i ) ) );
+        if( clip )
+        {
+            clipped = _mm256_sub_epi64( clipped, _mm256_castpd_si256( _mm256_or_pd(
+                    _mm256_cmp_pd( d, below, _CMP_NGT_UQ ), _mm256_cmp_pd( d, above, _CMP_GE_OQ ) ) ) );
+            d = _mm256_min_pd( _mm256_max_pd( d, lo ), hi );
+        }
+        _mm_storeu_si128( (__m128i*)(out + i), _mm256_cvttpd_epi32( d ) );
+    }
+
+    return Avx2_Sum( clipped );
+}
+
+PA_SIMD_TARGET_AVX2_
+static unsigned int Avx2_Float64ToInt32( PaInt32 *out, const double *in, const float *dither,
+        unsigned int count, double scale, double minimum, double maximum, int clip )
+{
+    const __m256d s = _mm256_set1_pd( scale );
+    const __m256d lo = _mm256_set1_pd( minimum );
+    const __m256d hi = _mm256_set1_pd( maximum );
+    const __m256d below = _mm256_set1_pd( minimum - 1. );
+    const __m256d above = _mm256_set1_pd( maximum + 1. );
+    __m256i clipped = _mm256_setzero_si256();
+    unsigned int i;
+
+    for( i=0; i < count; i += 4 )
+    {
+        __m256d d = _mm256_mul_pd( _mm256_loadu_pd( in + i ), s );
+        if( dither )
+            d = _mm256_add_pd( d, _mm256_cvtps_pd( _mm_loadu_ps( dither + i ) ) );
+        if( clip )
+        {
+            clipped = _mm256_sub_epi64( clipped, _mm256_castpd_si256( _mm256_or_pd(
+                    _mm256_cmp_pd( d, below, _CMP_NGT_UQ ), _mm256_cmp_pd( d, above, _CMP_GE_OQ ) ) ) );
+            d = _mm256_min_pd( _mm256_max_pd( d, lo ), hi );
+        }
+        _mm_storeu_si128( (__m128i*)(out + i), _mm256_cvttpd_epi32( d ) );
+    }
+
+    return Avx2_Sum( clipped );
+}
+
+PA_SIMD_TARGET_AVX2_
+static void Avx2_Float64ToFloat32( float *out, const double *in, unsigned int count )
+{
+    unsigned int i;
+
+    for( i=0; i < count; i += 8 )
+    {
+        _mm256_storeu_ps( out + i, _mm256_insertf128_ps( _mm256_castps128_ps256(
+                _mm256_cvtpd_ps( _mm256_loadu_pd( in + i ) ) ),
+                _mm256_cvtpd_ps( _mm256_loadu_pd( in + i + 4 ) ), 1 ) );
+    }
+}
+
+/* Each group of 8 samples occupies 24 bytes. A 32 byte load at the start
+    of the group followed by a dword permutation gives each 128 bit lane the
+    12 bytes it needs for an in-lane pshufb. The last group of a 32 sample
+    block is loaded 8 bytes early so that nothing is read past the block. */
+
+PA_SIMD_TARGET_AVX2_
+static void Avx2_UnpackInt24( PaInt32 *out, const unsigned char *in, unsigned int count )
+{
+    const __m256i mask = _mm256_setr_epi8( PA_SIMD_UNPACK_INT24_MASK_, PA_SIMD_UNPACK_INT24_MASK_ );
+    const __m256i spread = _mm256_setr_epi32( 0, 1, 2, 0, 3, 4, 5, 0 );
+    const __m256i spreadLast = _mm256_setr_epi32( 2, 3, 4, 0, 5, 6, 7, 0 );
+
+    for( ; count >= 32; count -= 32 )
+    {
+        __m256i a = _mm256_loadu_si256( (const __m256i*)in );
+        __m256i b = _mm256_loadu_si256( (const __m256i*)(in + 24) );
+        __m256i c = _mm256_loadu_si256( (const __m256i*)(in + 48) );
+        __m256i d = _mm256_loadu_si256( (const __m256i*)(in + 64) );
+
+        _mm256_storeu_si256( (__m256i*)out, _mm256_shuffle_epi8( _mm256_permutevar8x32_epi32( a, spread ), mask ) );
+        _mm256_storeu_si256( (__m256i*)(out + 8), _mm256_shuffle_epi8( _mm256_permutevar8x32_epi32( b, spread ), mask ) );
+        _mm256_storeu_si256( (__m256i*)(out + 16), _mm256_shuffle_epi8( _mm256_permutevar8x32_epi32( c, spread ), mask ) );
+        _mm256_storeu_si256( (__m256i*)(out + 24), _mm256_shuffle_epi8( _mm256_permutevar8x32_epi32( d, spreadLast ), mask ) );
+
+        in += 96;
+        out += 32;
+    }
+
+    Ssse3_UnpackInt24( out, in, count );
+}
+
+PA_SIMD_TARGET_AVX2_
+static void Avx2_UnpackInt24ToFloat32( float *out, const unsigned char *in, unsigned int count )
+{
+    PaInt32 block[32];
+    const __m256 scale = _mm256_set1_ps( 1.f / 2147483648.f );
+    unsigned int i;
+
+    while( count > 0 )
+    {
+        unsigned int n = ( count < 32 ) ? count : 32;
+
+        Avx2_UnpackInt24( block, in, n );
+        for( i=0; i + 8 <= n; i += 8 )
+            _mm256_storeu_ps( out + i, _mm256_mul_ps( _mm256_cvtepi32_ps(
+                    _mm256_loadu_si256( (const __m256i*)(block + i) ) ), scale ) );
+        for( ; i < n; ++i )
+            out[i] = (float)((double)block[i] * (1.0 / 2147483648.0));
+
+        in += n * 3;
+        out += n;
+        count -= n;
+    }
+}
+
+PA_SIMD_TARGET_AVX2_
+static void Avx2_PackInt24( unsigned char *out, const PaInt32 *in, unsigned int count )
+{
+    const __m256i mask = _mm256_setr_epi8( PA_SIMD_PACK_INT24_MASK_, PA_SIMD_PACK_INT24_MASK_ );
+    const __m256i gather = _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 3, 7 );
+
+    for( ; count >= 8; count -= 8 )
+    {
+        __m256i v = _mm256_permutevar8x32_epi32(
+                _mm256_shuffle_epi8( _mm256_loadu_si256( (const __m256i*)in ), mask ), gather );
+
+        /* 24 bytes: store exactly that many */
+        _mm_storeu_si128( (__m128i*)out, _mm256_castsi256_si128( v ) );
+        _mm_storel_epi64( (__m128i*)(out + 16), _mm256_extracti128_si256( v, 1 ) );
+
+        in += 8;
+        out += 24;
+    }
+
+    PackInt24Scalar( out, in, count );
+}
+
+static const PaUtilSimdKernels Avx2Kernels_ = {
+    Avx2_Float32ToInt16Range,
+    Avx2_Float32ToInt32Saturate,
+    Avx2_Float32ToInt32Double,
+    Avx2_Float64ToInt32,
+    Avx2_Float64ToFloat32,
+    Avx2_UnpackInt24,
+    Avx2_UnpackInt24ToFloat32,
+    Avx2_PackInt24
+};
+
+/* -------------------------------------------------------------------------- */
+
+static unsigned int DetectX86InstructionSets( void )
+{
+    unsigned int result = 0;
+
+#if defined(_MSC_VER)
+    int info[4];
+    int maximumLeaf;
+
+    __cpuid( info, 0 );
+    maximumLeaf = info[0];
+
+    __cpuid( info, 1 );
+    if( info[3] & (1 << 26) )
+        result |= paUtilSimdSse2;
+    if( info[2] & (1 << 9) )
+        result |= paUtilSimdSsse3;
+
+    /* AVX2 also requires the OS to save the upper halves of the YMM registers */
+    if( maximumLeaf >= 7 && (info[2] & (1 << 27)) && (info[2] & (1 << 28)) )
+    {
+        if( (_xgetbv( 0 ) & 0x6) == 0x6 )
+        {
+            __cpuidex( info, 7, 0 );
+            if( info[1] & (1 << 5) )
+                result |= paUtilSimdAvx2;
+        }
+    }
+#else
+    __builtin_cpu_init();
+
+    if( __builtin_cpu_supports( "sse2" ) )
+        result |= paUtilSimdSse2;
+    if( __builtin_cpu_supports( "ssse3" ) )
+        result |= paUtilSimdSsse3;
+    if( __builtin_cpu_supports( "avx2" ) )
+        result |= paUtilSimdAvx2;
+#endif
+
+    return result;
+}
+
+#endif /* PA_SIMD_X86_ */
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef PA_SIMD_GENERIC_
+
+typedef float PaSimdFloat4 __attribute__((vector_size(16)));
+typedef int PaSimdInt4 __attribute__((vector_size(16)));
+typedef double PaSimdDouble4 __attribute__((vector_size(32)));
+typedef long long PaSimdInt64x4 __attribute__((vector_size(32)));
+
+/* vectors are transferred with memcpy() to avoid alignment and aliasing
+    assumptions, compilers turn these into single unaligned loads/stores */
+
+static unsigned int Generic_Float32ToInt16Range( PaInt32 *out, const float *in, const float *dither,
+        unsigned int count, float scale, int clip )
+{
+    const PaSimdFloat4 lo = { -32768.f, -32768.f, -32768.f, -32768.f };
+    const PaSimdFloat4 hi = { 32767.f, 32767.f, 32767.f, 32767.f };
+    const PaSimdFloat4 below = { -32769.f, -32769.f, -32769.f, -32769.f };
+    const PaSimdFloat4 above = { 32768.f, 32768.f, 32768.f, 32768.f };
+    PaSimdInt4 clipped = { 0, 0, 0, 0 };
+    unsigned int i;
+
+    for( i=0; i < count; i += 4 )
+    {
+        PaSimdFloat4 v;
+        PaSimdInt4 r, m;
+
+        memcpy( &v, in + i, sizeof(v) );
+        v *= scale;
+        if( dither )
+        {
+            PaSimdFloat4 d;
+            memcpy( &d, dither + i, sizeof(d) );
+            v += d;
+        }
+        if( clip )
+        {
+            clipped -= ~(v > below) | (v >= above);
+            m = ~(v >= lo); /* also true for NaN */
+            v = (PaSimdFloat4)(((PaSimdInt4)v & ~m) | ((PaSimdInt4)lo & m));
+            m = v > hi;
+            v = (PaSimdFloat4)(((PaSimdInt4)v & ~m) | ((PaSimdInt4)hi & m));
+        }
+        r = __builtin_convertvector( v, PaSimdInt4 );
+        memcpy( out + i, &r, sizeof(r) );
+    }
+
+    return (unsigned int)(clipped[0] + clipped[1] + clipped[2] + clipped[3]);
+}
+
+static unsigned int Generic_Float32ToInt32Saturate( PaInt32 *out, const float *in, unsigned int count )
+{
+    /* 2147483520.f is the largest float below 2^31 */
+    const PaSimdFloat4 lo = { -2147483648.f, -2147483648.f, -2147483648.f, -2147483648.f };
+    const PaSimdFloat4 hi = { 2147483520.f, 2147483520.f, 2147483520.f, 2147483520.f };
+    const PaSimdInt4 intMax = { 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF };
+    PaSimdInt4 clipped = { 0, 0, 0, 0 };
+    unsigned int i;
+
+    for( i=0; i < count; i += 4 )
+    {
+        PaSimdFloat4 v;
+        PaSimdInt4 r, m, overflow;
+
+        memcpy( &v, in + i, sizeof(v) );
+        v *= 2147483648.f;
+        overflow = v > hi;
+        m = ~(v >= lo);
+        clipped -= overflow | m;
+        v = (PaSimdFloat4)(((PaSimdInt4)v & ~m) | ((PaSimdInt4)lo & m));
+        v = (PaSimdFloat4)(((PaSimdInt4)v & ~overflow) | ((PaSimdInt4)hi & overflow));
+        r = __builtin_convertvector( v, PaSimdInt4 );
+        r = (r & ~overflow) | (intMax & overflow);
+        memcpy( out + i, &r, sizeof(r) );
+    }
+
+    return (unsigned int)(clipped[0] + clipped[1] + clipped[2] + clipped[3]);
+}
+
+static unsigned int Generic_Float32ToInt32Double( PaInt32 *out, const float *in, const float *dither,
+        unsigned int count, double scale, int clip )
+{
+    const PaSimdDouble4 lo = { -2147483648., -2147483648., -2147483648., -2147483648. };
+    const PaSimdDouble4 hi = { 2147483647., 2147483647., 2147483647., 2147483647. };
+    const PaSimdDouble4 below = { -2147483649., -2147483649., -2147483649., -2147483649. };
+    const PaSimdDouble4 above = { 2147483648., 2147483648., 2147483648., 2147483648. };
+    PaSimdInt64x4 clipped = { 0, 0, 0, 0 };
+    unsigned int i;
+
+    for( i=0; i < count; i += 4 )
+    {
+        PaSimdFloat4 f;
+        PaSimdDouble4 d;
+        PaSimdInt64x4 m;
+        PaSimdInt4 r;
+
+        memcpy( &f, in + i, sizeof(f) );
+        d = __builtin_convertvector( f, PaSimdDouble4 ) * scale;
+        if( dither )
+        {
+            memcpy( &f, dither + i, sizeof(f) );
+            d += __builtin_convertvector( f, PaSimdDouble4 );
+        }
+        if( clip )
+        {
+            clipped -= ~(d > below) | (d >= above);
+            m = ~(d >= lo);
+            d = (PaSimdDouble4)(((PaSimdInt64x4)d & ~m) | ((PaSimdInt64x4)lo & m));
+            m = d > hi;
+            d = (PaSimdDouble4)(((PaSimdInt64x4)d & ~m) | ((PaSimdInt64x4)hi & m));
+        }
+        r = __builtin_convertvector( d, PaSimdInt4 );
+        memcpy( out + i, &r, sizeof(r) );
+    }
+
+    return (unsigned int)(clipped[0] + clipped[1] + clipped[2] + clipped[3]);
+}
+
+static unsigned int Generic_Float64ToInt32( PaInt32 *out, const double *in, const float *dither,
+        unsigned int count, double scale, double minimum, double maximum, int clip )
+{
+    const PaSimdDouble4 lo = { minimum, minimum, minimum, minimum };
+    const PaSimdDouble4 hi = { maximum, maximum, maximum, maximum };
+    const PaSimdDouble4 below = lo - 1.;
+    const PaSimdDouble4 above = hi + 1.;
+    PaSimdInt64x4 clipped = { 0, 0, 0, 0 };
+    unsigned int i;
+
+    for( i=0; i < count; i += 4 )
+    {
+        PaSimdFloat4 f;
+        PaSimdDouble4 d;
+        PaSimdInt64x4 m;
+        PaSimdInt4 r;
+
+        memcpy( &d, in + i, sizeof(d) );
+        d *= scale;
+        if( dither )
+        {
+            memcpy( &f, dither + i, sizeof(f) );
+            d += __builtin_convertvector( f, PaSimdDouble4 );
+        }
+        if( clip )
+        {
+            clipped -= ~(d > below) | (d >= above);
+            m = ~(d >= lo);
+            d = (PaSimdDouble4)(((PaSimdInt64x4)d & ~m) | ((PaSimdInt64x4)lo & m));
+            m = d > hi;
+            d = (PaSimdDouble4)(((PaSimdInt64x4)d & ~m) | ((PaSimdInt64x4)hi & m));
+        }
+        r = __builtin_convertvector( d, PaSimdInt4 );
+        memcpy( out + i, &r, sizeof(r) );
+    }
+
+    return (unsigned int)(clipped[0] + clipped[1] + clipped[2] + clipped[3]);
+}
+
+static void Generic_Float64ToFloat32( float *out, const double *in, unsigned int count )
+{
+    unsigned int i;
+
+    for( i=0; i < count; i += 4 )
+    {
+        PaSimdDouble4 d;
+        PaSimdFloat4 f;
+
+        memcpy( &d, in + i, sizeof(d) );
+        f = __builtin_convertvector( d, PaSimdFloat4 );
+        memcpy( out + i, &f, sizeof(f) );
+    }
+}
+
+static const PaUtilSimdKernels GenericKernels_ = {
+    Generic_Float32ToInt16Range,
+    Generic_Float32ToInt32Saturate,
+    Generic_Float32ToInt32Double,
+    Generic_Float64ToInt32,
+    Generic_Float64ToFloat32,
+    NULL,
+    NULL,
+    NULL
+};
+
+#endif /* PA_SIMD_GENERIC_ */
+
+/* -------------------------------------------------------------------------- */
+
+#if defined(PA_SIMD_X86_) || defined(PA_SIMD_GENERIC_)
+
+/* Return a pointer to paddedCount contiguous source samples. Strided or
+    partial blocks are copied into block and padded with zeros.
+*/
+static const float* GatherFloat32( float *block, const float *src, signed int sourceStride,
+        unsigned int count, unsigned int paddedCount )
+{
+    unsigned int i;
+
+    if( sourceStride == 1 && count == paddedCount )
+        return src;
+
+    for( i=0; i < count; ++i )
+    {
+        block[i] = *src;
+        src += sourceStride;
+    }
+    for( ; i < paddedCount; ++i )
+        block[i] = 0.f;
+
+    return block;
+}
+
+static const double* GatherFloat64( double *block, const double *src, signed int sourceStride,
+        unsigned int count, unsigned int paddedCount )
+{
+    unsigned int i;
+
+    if( sourceStride == 1 && count == paddedCount )
+        return src;
+
+    for( i=0; i < count; ++i )
+    {
+        block[i] = *src;
+        src += sourceStride;
+    }
+    for( ; i < paddedCount; ++i )
+        block[i] = 0.;
+
+    return block;
+}
+
+/* The block generator produces the same sequence as the reference converters,
+    which call PaUtil_GenerateFloatTriangularDither() once per sample, so both
+    consume the generator identically. */
+static const float* GenerateDither( float *block,
+        PaUtilTriangularDitherGenerator *ditherGenerator,
+        unsigned int count, unsigned int paddedCount )
+{
+    unsigned int i;
+
+    PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, block, count );
+    for( i=count; i < paddedCount; ++i )
+        block[i] = 0.f;
+
+    return block;
+}
+
+#define PA_SIMD_BLOCK_COUNT_( count ) \
+    (((count) < PA_SIMD_BLOCK_SIZE_) ? (count) : PA_SIMD_BLOCK_SIZE_)
+
+#define PA_SIMD_PADDED_COUNT_( count ) \
+    (((count) + (PA_SIMD_KERNEL_ALIGN_ - 1)) & ~(PA_SIMD_KERNEL_ALIGN_ - 1))
+
+/* -------------------------------------------------------------------------- */
+
+static void SimdFloat32_To_Int32( const PaUtilSimdKernels *kernels,
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator,
+    int mode )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    float sourceBlock[PA_SIMD_BLOCK_SIZE_];
+    float ditherBlock[PA_SIMD_BLOCK_SIZE_];
+    PaInt32 resultBlock[PA_SIMD_BLOCK_SIZE_];
+    unsigned int clipped = 0;
+    unsigned int i;
+
+    while( count > 0 )
+    {
+        unsigned int blockCount = PA_SIMD_BLOCK_COUNT_( count );
+        unsigned int paddedCount = PA_SIMD_PADDED_COUNT_( blockCount );
+        const float *in = GatherFloat32( sourceBlock, src, sourceStride, blockCount, paddedCount );
+        PaInt32 *out = ( destinationStride == 1 && blockCount == paddedCount ) ? dest : resultBlock;
+
+        if( mode & PA_SIMD_DITHER_ )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            clipped += kernels->Float32ToInt32Double( out, in,
+                    GenerateDither( ditherBlock, ditherGenerator, blockCount, paddedCount ),
+                    paddedCount, 2147483646.0, mode & PA_SIMD_CLIP_ );
+        }
+        else if( (mode & (PA_SIMD_INT24_IN_32_ | PA_SIMD_CLIP_)) == PA_SIMD_INT24_IN_32_ )
+        {
+            /* Float32_To_Int24In32 scales in double precision like Float32_To_Int24 */
+            kernels->Float32ToInt32Double( out, in, NULL, paddedCount, 2147483647.0, 0 );
+        }
+        else if( mode & PA_SIMD_CLIP_ )
+        {
+            clipped += kernels->Float32ToInt32Saturate( out, in, paddedCount );
+        }
+        else
+        {
+            kernels->Float32ToInt32Saturate( out, in, paddedCount );
+        }
+
+        if( mode & PA_SIMD_INT24_IN_32_ )
+        {
+            for( i=0; i < blockCount; ++i )
+                out[i] >>= 8;
+        }
+
+        if( out == dest )
+        {
+            dest += blockCount;
+        }
+        else
+        {
+            for( i=0; i < blockCount; ++i )
+            {
+                *dest = resultBlock[i];
+                dest += destinationStride;
+            }
+        }
+
+        src += (signed int)blockCount * sourceStride;
+        count -= blockCount;
+    }
+
+    if( mode & PA_SIMD_CLIP_ )
+        ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void SimdFloat32_To_Int24In32( const PaUtilSimdKernels *kernels,
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator,
+    int mode )
+{
+    SimdFloat32_To_Int32( kernels, destinationBuffer, destinationStride,
+            sourceBuffer, sourceStride, count, ditherGenerator, mode | PA_SIMD_INT24_IN_32_ );
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void SimdFloat32_To_Int24( const PaUtilSimdKernels *kernels,
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator,
+    int mode )
+{
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    float sourceBlock[PA_SIMD_BLOCK_SIZE_];
+    float ditherBlock[PA_SIMD_BLOCK_SIZE_];
+    PaInt32 resultBlock[PA_SIMD_BLOCK_SIZE_];
+    unsigned int clipped = 0;
+    unsigned int i;
+
+    while( count > 0 )
+    {
+        unsigned int blockCount = PA_SIMD_BLOCK_COUNT_( count );
+        unsigned int paddedCount = PA_SIMD_PADDED_COUNT_( blockCount );
+        const float *in = GatherFloat32( sourceBlock, src, sourceStride, blockCount, paddedCount );
+
+        /* convert to 32 bit and drop the low 8 bits */
+        if( mode & PA_SIMD_DITHER_ )
+        {
+            clipped += kernels->Float32ToInt32Double( resultBlock, in,
+                    GenerateDither( ditherBlock, ditherGenerator, blockCount, paddedCount ),
+                    paddedCount, 2147483646.0, mode & PA_SIMD_CLIP_ );
+        }
+        else if( mode & PA_SIMD_CLIP_ )
+        {
+            clipped += kernels->Float32ToInt32Saturate( resultBlock, in, paddedCount );
+        }
+        else
+        {
+            kernels->Float32ToInt32Double( resultBlock, in, NULL, paddedCount, 2147483647.0, 0 );
+        }
+
+        if( destinationStride == 1 )
+        {
+            if( kernels->PackInt24 )
+                kernels->PackInt24( dest, resultBlock, blockCount );
+            else
+                PackInt24Scalar( dest, resultBlock, blockCount );
+            dest += blockCount * 3;
+        }
+        else
+        {
+            for( i=0; i < blockCount; ++i )
+            {
+                PackInt24Scalar( dest, resultBlock + i, 1 );
+                dest += destinationStride * 3;
+            }
+        }
+
+        src += (signed int)blockCount * sourceStride;
+        count -= blockCount;
+    }
+
+    if( mode & PA_SIMD_CLIP_ )
+        ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void SimdFloat32_To_Int16( const PaUtilSimdKernels *kernels,
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator,
+    int mode )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    float sourceBlock[PA_SIMD_BLOCK_SIZE_];
+    float ditherBlock[PA_SIMD_BLOCK_SIZE_];
+    PaInt32 resultBlock[PA_SIMD_BLOCK_SIZE_];
+    unsigned int clipped = 0;
+    unsigned int i;
+
+    while( count > 0 )
+    {
+        unsigned int blockCount = PA_SIMD_BLOCK_COUNT_( count );
+        unsigned int paddedCount = PA_SIMD_PADDED_COUNT_( blockCount );
+        const float *in = GatherFloat32( sourceBlock, src, sourceStride, blockCount, paddedCount );
+
+        if( mode & PA_SIMD_DITHER_ )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            clipped += kernels->Float32ToInt16Range( resultBlock, in,
+                    GenerateDither( ditherBlock, ditherGenerator, blockCount, paddedCount ),
+                    paddedCount, 32766.0f, mode & PA_SIMD_CLIP_ );
+        }
+        else
+        {
+            clipped += kernels->Float32ToInt16Range( resultBlock, in, NULL,
+                    paddedCount, 32767.0f, mode & PA_SIMD_CLIP_ );
+        }
+
+        for( i=0; i < blockCount; ++i )
+        {
+            *dest = (PaInt16)resultBlock[i];
+            dest += destinationStride;
+        }
+
+        src += (signed int)blockCount * sourceStride;
+        count -= blockCount;
+    }
+
+    if( mode & PA_SIMD_CLIP_ )
+        ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Float64 to Int32 or Int24In32 (bytesPerSample 4), Int24 (bytesPerSample 3)
+    and Int16 (bytesPerSample 2).
+    All conversions are performed in double precision like the reference
+    converters, Int24 is converted to 32 bit and then packed. */
+static void SimdFloat64_To_Integer( const PaUtilSimdKernels *kernels,
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator,
+    int mode, int bytesPerSample )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    double sourceBlock[PA_SIMD_BLOCK_SIZE_];
+    float ditherBlock[PA_SIMD_BLOCK_SIZE_];
+    PaInt32 resultBlock[PA_SIMD_BLOCK_SIZE_];
+    /* use smaller scaler to prevent overflow when we add the dither */
+    double scale = ( bytesPerSample == 2 )
+            ? (( mode & PA_SIMD_DITHER_ ) ? 32766.0 : 32767.0)
+            : (( mode & PA_SIMD_DITHER_ ) ? 2147483646.0 : 2147483647.0);
+    double minimum = ( bytesPerSample == 2 ) ? -32768.0 : -2147483648.0;
+    double maximum = ( bytesPerSample == 2 ) ? 32767.0 : 2147483647.0;
+    unsigned int clipped = 0;
+    unsigned int i;
+
+    while( count > 0 )
+    {
+        unsigned int blockCount = PA_SIMD_BLOCK_COUNT_( count );
+        unsigned int paddedCount = PA_SIMD_PADDED_COUNT_( blockCount );
+        const double *in = GatherFloat64( sourceBlock, src, sourceStride, blockCount, paddedCount );
+        PaInt32 *out = ( bytesPerSample == 4 && destinationStride == 1 && blockCount == paddedCount )
+                ? (PaInt32*)dest : resultBlock;
+
+        clipped += kernels->Float64ToInt32( out, in, ( mode & PA_SIMD_DITHER_ )
+                    ? GenerateDither( ditherBlock, ditherGenerator, blockCount, paddedCount ) : NULL,
+                paddedCount, scale, minimum, maximum, mode & PA_SIMD_CLIP_ );
+
+        if( mode & PA_SIMD_INT24_IN_32_ )
+        {
+            for( i=0; i < blockCount; ++i )
+                out[i] >>= 8;
+        }
+
+        if( out != resultBlock )
+        {
+            dest += blockCount * 4;
+        }
+        else if( bytesPerSample == 4 )
+        {
+            for( i=0; i < blockCount; ++i )
+            {
+                *(PaInt32*)dest = resultBlock[i];
+                dest += destinationStride * 4;
+            }
+        }
+        else if( bytesPerSample == 3 )
+        {
+            if( destinationStride == 1 && kernels->PackInt24 )
+            {
+                kernels->PackInt24( dest, resultBlock, blockCount );
+                dest += blockCount * 3;
+            }
+            else
+            {
+                for( i=0; i < blockCount; ++i )
+                {
+                    PackInt24Scalar( dest, resultBlock + i, 1 );
+                    dest += destinationStride * 3;
+                }
+            }
+        }
+        else
+        {
+            for( i=0; i < blockCount; ++i )
+            {
+                *(PaInt16*)dest = (PaInt16)resultBlock[i];
+                dest += destinationStride * 2;
+            }
+        }
+
+        src += (signed int)blockCount * sourceStride;
+        count -= blockCount;
+    }
+
+    if( mode & PA_SIMD_CLIP_ )
+        ditherGenerator->clippedSampleCount += clipped;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void SimdFloat64_To_Float32( const PaUtilSimdKernels *kernels,
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count )
+{
+    double *src = (double*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    double sourceBlock[PA_SIMD_BLOCK_SIZE_];
+    float resultBlock[PA_SIMD_BLOCK_SIZE_];
+    unsigned int i;
+
+    while( count > 0 )
+    {
+        unsigned int blockCount = PA_SIMD_BLOCK_COUNT_( count );
+        unsigned int paddedCount = PA_SIMD_PADDED_COUNT_( blockCount );
+        const double *in = GatherFloat64( sourceBlock, src, sourceStride, blockCount, paddedCount );
+        float *out = ( destinationStride == 1 && blockCount == paddedCount ) ? dest : resultBlock;
+
+        kernels->Float64ToFloat32( out, in, paddedCount );
+
+        if( out == dest )
+        {
+            dest += blockCount;
+        }
+        else
+        {
+            for( i=0; i < blockCount; ++i )
+            {
+                *dest = resultBlock[i];
+                dest += destinationStride;
+            }
+        }
+
+        src += (signed int)blockCount * sourceStride;
+        count -= blockCount;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef PA_SIMD_X86_ /* only the x86 kernels provide byte shuffles */
+
+/* Return a pointer to count contiguous packed Int24 source samples, copying
+    them into block if the source is strided. */
+static const unsigned char* GatherInt24( unsigned char *block, const unsigned char *src,
+        signed int sourceStride, unsigned int count )
+{
+    unsigned int i;
+
+    if( sourceStride == 1 )
+        return src;
+
+    for( i=0; i < count; ++i )
+    {
+        block[i * 3] = src[0];
+        block[i * 3 + 1] = src[1];
+        block[i * 3 + 2] = src[2];
+        src += sourceStride * 3;
+    }
+
+    return block;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void SimdInt24_To_Float32( const PaUtilSimdKernels *kernels,
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    unsigned char sourceBlock[PA_SIMD_BLOCK_SIZE_ * 3];
+    float resultBlock[PA_SIMD_BLOCK_SIZE_];
+    unsigned int i;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        kernels->UnpackInt24ToFloat32( dest, src, count );
+        return;
+    }
+
+    while( count > 0 )
+    {
+        unsigned int blockCount = PA_SIMD_BLOCK_COUNT_( count );
+        const unsigned char *in = GatherInt24( sourceBlock, src, sourceStride, blockCount );
+
+        if( destinationStride == 1 )
+        {
+            kernels->UnpackInt24ToFloat32( dest, in, blockCount );
+            dest += blockCount;
+        }
+        else
+        {
+            kernels->UnpackInt24ToFloat32( resultBlock, in, blockCount );
+            for( i=0; i < blockCount; ++i )
+            {
+                *dest = resultBlock[i];
+                dest += destinationStride;
+            }
+        }
+
+        src += (signed int)blockCount * sourceStride * 3;
+        count -= blockCount;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void SimdInt24_To_Int32( const PaUtilSimdKernels *kernels,
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    unsigned char sourceBlock[PA_SIMD_BLOCK_SIZE_ * 3];
+    PaInt32 resultBlock[PA_SIMD_BLOCK_SIZE_];
+    unsigned int i;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        kernels->UnpackInt24( dest, src, count );
+        return;
+    }
+
+    while( count > 0 )
+    {
+        unsigned int blockCount = PA_SIMD_BLOCK_COUNT_( count );
+        const unsigned char *in = GatherInt24( sourceBlock, src, sourceStride, blockCount );
+
+        if( destinationStride == 1 )
+        {
+            kernels->UnpackInt24( dest, in, blockCount );
+            dest += blockCount;
+        }
+        else
+        {
+            kernels->UnpackInt24( resultBlock, in, blockCount );
+            for( i=0; i < blockCount; ++i )
+            {
+                *dest = resultBlock[i];
+                dest += destinationStride;
+            }
+        }
+
+        src += (signed int)blockCount * sourceStride * 3;
+        count -= blockCount;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void SimdInt32_To_Int24( const PaUtilSimdKernels *kernels,
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 sourceBlock[PA_SIMD_BLOCK_SIZE_];
+    unsigned int i;
+
+    if( destinationStride != 1 )
+    {
+        /* strided 3 byte stores gain nothing from the shuffle */
+        while( count-- )
+        {
+            PackInt24Scalar( dest, src, 1 );
+            src += sourceStride;
+            dest += destinationStride * 3;
+        }
+        return;
+    }
+
+    if( sourceStride == 1 )
+    {
+        kernels->PackInt24( dest, src, count );
+        return;
+    }
+
+    while( count > 0 )
+    {
+        unsigned int blockCount = PA_SIMD_BLOCK_COUNT_( count );
+
+        for( i=0; i < blockCount; ++i )
+        {
+            sourceBlock[i] = *src;
+            src += sourceStride;
+        }
+        kernels->PackInt24( dest, sourceBlock, blockCount );
+
+        dest += blockCount * 3;
+        count -= blockCount;
+    }
+}
+
+#endif /* PA_SIMD_X86_ */
+
+/* -------------------------------------------------------------------------- */
+
+/* Define the PaUtilConverter entry points for one set of kernels. */
+
+#define PA_DEFINE_SIMD_CONVERTER_( isa, destination, suffix, mode ) \
+    static void Float32_To_##destination##suffix##_##isa( \
+        void *destinationBuffer, signed int destinationStride, \
+        void *sourceBuffer, signed int sourceStride, \
+        unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator ) \
+    { \
+        SimdFloat32_To_##destination( &isa##Kernels_, destinationBuffer, destinationStride, \
+                sourceBuffer, sourceStride, count, ditherGenerator, mode ); \
+    }
+
+#define PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, destination, suffix, mode, bytesPerSample ) \
+    static void Float64_To_##destination##suffix##_##isa( \
+        void *destinationBuffer, signed int destinationStride, \
+        void *sourceBuffer, signed int sourceStride, \
+        unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator ) \
+    { \
+        SimdFloat64_To_Integer( &isa##Kernels_, destinationBuffer, destinationStride, \
+                sourceBuffer, sourceStride, count, ditherGenerator, mode, bytesPerSample ); \
+    }
+
+/* Converters without dither, see PA_DEFINE_SIMD_CONVERTERS_ and
+    PA_DEFINE_SIMD_INT24_CONVERTERS_. */
+#define PA_DEFINE_SIMD_PLAIN_CONVERTER_( isa, name ) \
+    static void name##_##isa( \
+        void *destinationBuffer, signed int destinationStride, \
+        void *sourceBuffer, signed int sourceStride, \
+        unsigned int count, PaUtilTriangularDitherGenerator *ditherGenerator ) \
+    { \
+        (void) ditherGenerator; /* unused parameter */ \
+        Simd##name( &isa##Kernels_, destinationBuffer, destinationStride, \
+                sourceBuffer, sourceStride, count ); \
+    }
+
+#define PA_DEFINE_SIMD_CONVERTERS_( isa ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int32, , 0 ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int32, _Dither, PA_SIMD_DITHER_ ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int32, _Clip, PA_SIMD_CLIP_ ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int32, _DitherClip, PA_SIMD_DITHER_ | PA_SIMD_CLIP_ ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int24, , 0 ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int24, _Dither, PA_SIMD_DITHER_ ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int24, _Clip, PA_SIMD_CLIP_ ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int24, _DitherClip, PA_SIMD_DITHER_ | PA_SIMD_CLIP_ ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int24In32, , 0 ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int24In32, _Dither, PA_SIMD_DITHER_ ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int24In32, _Clip, PA_SIMD_CLIP_ ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int24In32, _DitherClip, PA_SIMD_DITHER_ | PA_SIMD_CLIP_ ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int16, , 0 ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int16, _Dither, PA_SIMD_DITHER_ ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int16, _Clip, PA_SIMD_CLIP_ ) \
+    PA_DEFINE_SIMD_CONVERTER_( isa, Int16, _DitherClip, PA_SIMD_DITHER_ | PA_SIMD_CLIP_ ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int32, , 0, 4 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int32, _Dither, PA_SIMD_DITHER_, 4 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int32, _Clip, PA_SIMD_CLIP_, 4 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int32, _DitherClip, PA_SIMD_DITHER_ | PA_SIMD_CLIP_, 4 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int24, , 0, 3 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int24, _Dither, PA_SIMD_DITHER_, 3 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int24, _Clip, PA_SIMD_CLIP_, 3 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int24, _DitherClip, PA_SIMD_DITHER_ | PA_SIMD_CLIP_, 3 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int24In32, , PA_SIMD_INT24_IN_32_, 4 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int24In32, _Dither, PA_SIMD_INT24_IN_32_ | PA_SIMD_DITHER_, 4 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int24In32, _Clip, PA_SIMD_INT24_IN_32_ | PA_SIMD_CLIP_, 4 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int24In32, _DitherClip, PA_SIMD_INT24_IN_32_ | PA_SIMD_DITHER_ | PA_SIMD_CLIP_, 4 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int16, , 0, 2 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int16, _Dither, PA_SIMD_DITHER_, 2 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int16, _Clip, PA_SIMD_CLIP_, 2 ) \
+    PA_DEFINE_SIMD_FLOAT64_CONVERTER_( isa, Int16, _DitherClip, PA_SIMD_DITHER_ | PA_SIMD_CLIP_, 2 ) \
+    PA_DEFINE_SIMD_PLAIN_CONVERTER_( isa, Float64_To_Float32 )
+
+/* Packed Int24 converters, only for kernel sets which provide shuffles. */
+
+#define PA_DEFINE_SIMD_INT24_CONVERTERS_( isa ) \
+    PA_DEFINE_SIMD_PLAIN_CONVERTER_( isa, Int24_To_Float32 ) \
+    PA_DEFINE_SIMD_PLAIN_CONVERTER_( isa, Int24_To_Int32 ) \
+    PA_DEFINE_SIMD_PLAIN_CONVERTER_( isa, Int32_To_Int24 )
+
+#define PA_STORE_SIMD_INT24_CONVERTERS_( table, isa ) \
+    { \
+        (table)->Int24_To_Float32 = Int24_To_Float32_##isa; \
+        (table)->Int24_To_Int32 = Int24_To_Int32_##isa; \
+        (table)->Int32_To_Int24 = Int32_To_Int24_##isa; \
+    }
+
+#define PA_STORE_SIMD_CONVERTERS_( table, isa ) \
+    { \
+        (table)->Float32_To_Int32 = Float32_To_Int32_##isa; \
+        (table)->Float32_To_Int32_Dither = Float32_To_Int32_Dither_##isa; \
+        (table)->Float32_To_Int32_Clip = Float32_To_Int32_Clip_##isa; \
+        (table)->Float32_To_Int32_DitherClip = Float32_To_Int32_DitherClip_##isa; \
+        (table)->Float32_To_Int24 = Float32_To_Int24_##isa; \
+        (table)->Float32_To_Int24_Dither = Float32_To_Int24_Dither_##isa; \
+        (table)->Float32_To_Int24_Clip = Float32_To_Int24_Clip_##isa; \
+        (table)->Float32_To_Int24_DitherClip = Float32_To_Int24_DitherClip_##isa; \
+        (table)->Float32_To_Int24In32 = Float32_To_Int24In32_##isa; \
+        (table)->Float32_To_Int24In32_Dither = Float32_To_Int24In32_Dither_##isa; \
+        (table)->Float32_To_Int24In32_Clip = Float32_To_Int24In32_Clip_##isa; \
+        (table)->Float32_To_Int24In32_DitherClip = Float32_To_Int24In32_DitherClip_##isa; \
+        (table)->Float32_To_Int16 = Float32_To_Int16_##isa; \
+        (table)->Float32_To_Int16_Dither = Float32_To_Int16_Dither_##isa; \
+        (table)->Float32_To_Int16_Clip = Float32_To_Int16_Clip_##isa; \
+        (table)->Float32_To_Int16_DitherClip = Float32_To_Int16_DitherClip_##isa; \
+        (table)->Float64_To_Float32 = Float64_To_Float32_##isa; \
+        (table)->Float64_To_Int32 = Float64_To_Int32_##isa; \
+        (table)->Float64_To_Int32_Dither = Float64_To_Int32_Dither_##isa; \
+        (table)->Float64_To_Int32_Clip = Float64_To_Int32_Clip_##isa; \
+        (table)->Float64_To_Int32_DitherClip = Float64_To_Int32_DitherClip_##isa; \
+        (table)->Float64_To_Int24 = Float64_To_Int24_##isa; \
+        (table)->Float64_To_Int24_Dither = Float64_To_Int24_Dither_##isa; \
+        (table)->Float64_To_Int24_Clip = Float64_To_Int24_Clip_##isa; \
+        (table)->Float64_To_Int24_DitherClip = Float64_To_Int24_DitherClip_##isa; \
+        (table)->Float64_To_Int24In32 = Float64_To_Int24In32_##isa; \
+        (table)->Float64_To_Int24In32_Dither = Float64_To_Int24In32_Dither_##isa; \
+        (table)->Float64_To_Int24In32_Clip = Float64_To_Int24In32_Clip_##isa; \
+        (table)->Float64_To_Int24In32_DitherClip = Float64_To_Int24In32_DitherClip_##isa; \
+        (table)->Float64_To_Int16 = Float64_To_Int16_##isa; \
+        (table)->Float64_To_Int16_Dither = Float64_To_Int16_Dither_##isa; \
+        (table)->Float64_To_Int16_Clip = Float64_To_Int16_Clip_##isa; \
+        (table)->Float64_To_Int16_DitherClip = Float64_To_Int16_DitherClip_##isa; \
+    }
+
+#ifdef PA_SIMD_X86_
+PA_DEFINE_SIMD_CONVERTERS_( Sse2 )
+PA_DEFINE_SIMD_CONVERTERS_( Ssse3 )
+PA_DEFINE_SIMD_CONVERTERS_( Avx2 )
+PA_DEFINE_SIMD_INT24_CONVERTERS_( Ssse3 )
+PA_DEFINE_SIMD_INT24_CONVERTERS_( Avx2 )
+#endif
+
+#ifdef PA_SIMD_GENERIC_
+PA_DEFINE_SIMD_CONVERTERS_( Generic )
+#endif
+
+#endif /* PA_SIMD_X86_ || PA_SIMD_GENERIC_ */
+
+/* -------------------------------------------------------------------------- */
+
+unsigned int PaUtil_GetAvailableSimdInstructionSets( void )
+{
+    unsigned int result = 0;
+
+#ifdef PA_SIMD_X86_
+    result |= DetectX86InstructionSets();
+#endif
+
+#ifdef PA_SIMD_GENERIC_
+    result |= paUtilSimdGeneric;
+#endif
+
+    return result;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PaUtil_GetSimdConverters( PaUtilConverterTable *table, unsigned int instructionSets )
+{
+    instructionSets &= PaUtil_GetAvailableSimdInstructionSets();
+
+    /* from slowest to fastest, later sets overwrite earlier ones */
+#ifdef PA_SIMD_GENERIC_
+    if( instructionSets & paUtilSimdGeneric )
+        PA_STORE_SIMD_CONVERTERS_( table, Generic );
+#endif
+#ifdef PA_SIMD_X86_
+    if( instructionSets & paUtilSimdSse2 )
+        PA_STORE_SIMD_CONVERTERS_( table, Sse2 );
+    if( instructionSets & paUtilSimdSsse3 )
+    {
+        PA_STORE_SIMD_CONVERTERS_( table, Ssse3 );
+        PA_STORE_SIMD_INT24_CONVERTERS_( table, Ssse3 );
+    }
+    if( instructionSets & paUtilSimdAvx2 )
+    {
+        PA_STORE_SIMD_CONVERTERS_( table, Avx2 );
+        PA_STORE_SIMD_INT24_CONVERTERS_( table, Avx2 );
+    }
+#endif
+
+    (void)table; /* unused if no instruction sets were compiled in */
+}
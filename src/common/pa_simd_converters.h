@@ -0,0 +1,108 @@
+#ifndef PA_SIMD_CONVERTERS_H
+#define PA_SIMD_CONVERTERS_H
+/*
+ * $Id$
+ * Portable Audio I/O Library sample conversion mechanism
+ * SIMD implementations of selected sample converters
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief SIMD implementations of the most frequently used sample converters.
+
+ The converters in pa_converters.c remain the reference implementations.
+ The functions declared here only provide vectorised equivalents which
+ PaUtil_InitializeConverters() substitutes into paConverters when the
+ running processor supports the required instruction set.
+*/
+
+
+#include "pa_converters.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+/** Instruction sets for which SIMD converters may be available.
+ Values may be combined with bitwise or.
+*/
+typedef enum PaUtilSimdInstructionSet
+{
+    paUtilSimdNone = 0,
+    paUtilSimdGeneric = 0x01, /**< compiler vector extensions, any architecture */
+    paUtilSimdSse2 = 0x02,
+    paUtilSimdSsse3 = 0x04,
+    paUtilSimdAvx2 = 0x08
+} PaUtilSimdInstructionSet;
+
+
+/** Query which instruction sets were compiled in and are supported by the
+ processor we are running on. Detection is performed with CPUID on x86.
+ @return A bitwise or of PaUtilSimdInstructionSet values.
+*/
+unsigned int PaUtil_GetAvailableSimdInstructionSets( void );
+
+
+/** Store SIMD converters in table. Converters from each of the given
+ instruction sets which is also available are stored in order of increasing
+ speed, so each field ends up with the fastest available implementation.
+ Only the fields for which a SIMD implementation exists are written, all
+ others are left untouched, so callers usually pass a zeroed table and merge
+ the non-NULL fields. Pass a single PaUtilSimdInstructionSet value to
+ retrieve the converters of one instruction set only.
+
+ Float32 and Float64 to Int32, Int24, Int24In32 and Int16 converters and
+ Float64_To_Float32 are provided for every instruction set. Int24_To_Float32, Int24_To_Int32 and Int32_To_Int24 use
+ byte shuffles and are only provided for SSSE3 and AVX2.
+
+ The SIMD converters produce bit-identical results to the reference
+ converters for all inputs for which the reference converters are defined
+ (ie. where the scaled value is representable as a 32 bit integer). Inputs
+ which overflow the reference converters are saturated by the clipping SIMD
+ converters. Converters built on the generic vector extensions may differ
+ by one LSB on targets where the compiler contracts multiply-add into fused
+ instructions differently for vector and scalar code.
+*/
+void PaUtil_GetSimdConverters( PaUtilConverterTable *table, unsigned int instructionSets );
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PA_SIMD_CONVERTERS_H */
@@ -45,6 +45,8 @@
 */
 
 
+#include <string.h>
+
 #include "pa_stream.h"
 
 
@@ -74,6 +76,13 @@ void PaUtil_InitializeStreamInterface( PaUtilStreamInterface *streamInterface,
     streamInterface->Write = Write;
     streamInterface->GetReadAvailable = GetReadAvailable;
     streamInterface->GetWriteAvailable = GetWriteAvailable;
+    streamInterface->GetReadyFileDescriptor = 0;
+    streamInterface->AcquireWriteBuffer = 0;
+    streamInterface->CommitWriteBuffer = 0;
+    streamInterface->AcquireReadBuffer = 0;
+    streamInterface->ReleaseReadBuffer = 0;
+    streamInterface->ReadTimeout = 0;
+    streamInterface->WriteTimeout = 0;
 }
 
 
@@ -90,9 +99,17 @@ void PaUtil_InitializeStreamRepresentation( PaUtilStreamRepresentation *streamRe
 
     streamRepresentation->userData = userData;
 
+    streamRepresentation->streamInfo.structVersion = 2;
     streamRepresentation->streamInfo.inputLatency = 0.;
     streamRepresentation->streamInfo.outputLatency = 0.;
     streamRepresentation->streamInfo.sampleRate = 0.;
+    streamRepresentation->streamInfo.flags = 0;
+
+    streamRepresentation->bufferProcessor = 0;
+    streamRepresentation->cpuLoadMeasurer = 0;
+
+    memset( &streamRepresentation->acquiredWriteBuffer, 0, sizeof(PaUtilAcquiredBuffer) );
+    memset( &streamRepresentation->acquiredReadBuffer, 0, sizeof(PaUtilAcquiredBuffer) );
 }
 
 
@@ -77,10 +77,35 @@ typedef struct {
     PaError (*Write)( PaStream* stream, const void *buffer, unsigned long frames );
     signed long (*GetReadAvailable)( PaStream* stream );
     signed long (*GetWriteAvailable)( PaStream* stream );
+    /** Optional, used by Pa_GetStreamReadyFileDescriptor(). Set to NULL by
+     PaUtil_InitializeStreamInterface(), host APIs which support it set it
+     afterwards. */
+    PaError (*GetReadyFileDescriptor)( PaStream* stream, unsigned long frames, int *fileDescriptor );
+    /** Optional, used by Pa_AcquireWriteBuffer() and Pa_AcquireReadBuffer()
+     to hand out the host API's own memory. On entry *frames is at least 1,
+     on exit it is the number of contiguous frames at *buffer, which may be 0.
+     They never block, and only return interleaved buffers. Returning
+     paIncompatibleStreamHostApi makes pa_front use a bounce buffer and the
+     Write or Read function instead, for example when the user sample format
+     differs from the host format. Set to NULL by
+     PaUtil_InitializeStreamInterface(). */
+    PaError (*AcquireWriteBuffer)( PaStream* stream, void **buffer, unsigned long *frames );
+    PaError (*CommitWriteBuffer)( PaStream* stream, unsigned long frames );
+    PaError (*AcquireReadBuffer)( PaStream* stream, const void **buffer, unsigned long *frames );
+    PaError (*ReleaseReadBuffer)( PaStream* stream, unsigned long frames );
+    /** Optional, used by Pa_ReadStreamTimeout() and Pa_WriteStreamTimeout().
+     Like Read and Write, but return paTimedOut once timeout seconds have
+     passed. The number of frames transferred is stored in all cases. Set to
+     NULL by PaUtil_InitializeStreamInterface(). */
+    PaError (*ReadTimeout)( PaStream* stream, void *buffer, unsigned long frames,
+            PaTime timeout, unsigned long *framesRead );
+    PaError (*WriteTimeout)( PaStream* stream, const void *buffer, unsigned long frames,
+            PaTime timeout, unsigned long *framesWritten );
 } PaUtilStreamInterface;
 
 
-/** Initialize the fields of a PaUtilStreamInterface structure.
+/** Initialize the fields of a PaUtilStreamInterface structure. The optional
+ fields are set to NULL.
 */
 void PaUtil_InitializeStreamInterface( PaUtilStreamInterface *streamInterface,
     PaError (*Close)( PaStream* ),
@@ -141,6 +166,22 @@ signed long PaUtil_DummyGetWriteAvailable( PaStream* stream );
 double PaUtil_DummyGetCpuLoad( PaStream* stream );
 
 
+/** State of Pa_AcquireWriteBuffer() or Pa_AcquireReadBuffer() for one
+ direction of a stream. Maintained by pa_front.
+*/
+typedef struct PaUtilAcquiredBuffer {
+    PaSampleFormat sampleFormat;    /**< the user sample format, set by Pa_OpenStream() */
+    int channelCount;               /**< set by Pa_OpenStream(), 0 if the stream lacks this direction */
+    unsigned long acquiredFrames;   /**< frames handed out and not committed or released yet */
+    int isBounced;                  /**< whether the acquired frames are in bounceBuffer */
+    void *bounceBuffer;             /**< for non-interleaved formats an array of channel pointers
+                                         followed by the samples. Allocated on first use */
+    unsigned long bounceBufferFrames;
+    unsigned long bounceOffset;     /**< input frames which were read into bounceBuffer... */
+    unsigned long bounceFrames;     /**< ...but not released yet */
+} PaUtilAcquiredBuffer;
+
+
 /** Non host specific data for a stream. This data is used by pa_front to
  forward to the appropriate functions in the streamInterface structure.
 */
@@ -152,6 +193,12 @@ typedef struct PaUtilStreamRepresentation {
     PaStreamFinishedCallback *streamFinishedCallback;
     void *userData;
     PaStreamInfo streamInfo;
+    struct PaUtilBufferProcessor *bufferProcessor; /**< the stream's buffer processor, set by host APIs
+                                                        which use one. Used by Pa_GetStreamStatistics() */
+    struct PaUtilCpuLoadMeasurer *cpuLoadMeasurer; /**< the stream's CPU load measurer, set by host APIs
+                                                        which use one. Used by Pa_GetStreamStatistics() */
+    PaUtilAcquiredBuffer acquiredWriteBuffer;
+    PaUtilAcquiredBuffer acquiredReadBuffer;
 } PaUtilStreamRepresentation;
 
 
@@ -165,6 +165,52 @@ void PaUtil_InitializeClock( void );
 double PaUtil_GetTime( void );
 
 
+/** Return the number of processors which are online, at least 1. */
+int PaUtil_GetProcessorCount( void );
+
+
+/** A pool of threads which run a number of jobs in parallel with the thread
+ which calls PaUtil_RunWorkerPool(). Used by the buffer processor to run
+ channel group callbacks.
+
+ @see PaUtil_CreateWorkerPool
+*/
+typedef struct PaUtilWorkerPool PaUtilWorkerPool;
+
+
+/** A job run by a worker pool. Called once for each jobIndex from 0 to the
+ jobCount passed to PaUtil_RunWorkerPool(), less 1, in no particular order
+ and on any of the pool's threads or the calling thread.
+*/
+typedef void PaUtilWorkerPoolJob( void *context, unsigned int jobIndex );
+
+
+/** Create a pool of threadCount threads. Where the platform allows, the
+ threads are scheduled with real-time priority and each is pinned to its
+ own processor. A threadCount of 0 is valid, jobs are then run by the
+ calling thread alone. Platforms without a pool implementation may also
+ create fewer threads than requested.
+
+ @return paNoError, paInsufficientMemory, or paUnanticipatedHostError if a
+ thread could not be created.
+
+ @see PaUtil_DestroyWorkerPool
+*/
+PaError PaUtil_CreateWorkerPool( PaUtilWorkerPool **pool, unsigned int threadCount );
+
+
+/** Stop the threads of a pool and release it. pool may be NULL. */
+void PaUtil_DestroyWorkerPool( PaUtilWorkerPool *pool );
+
+
+/** Run job for every jobIndex from 0 to jobCount - 1 and return once all
+ calls have returned. The calling thread runs jobs too. Must not be called
+ by more than one thread at a time for the same pool.
+*/
+void PaUtil_RunWorkerPool( PaUtilWorkerPool *pool, PaUtilWorkerPoolJob *job,
+        void *context, unsigned int jobCount );
+
+
 /* void Pa_Sleep( long msec );  must also be implemented in per-platform .c file */
 
 
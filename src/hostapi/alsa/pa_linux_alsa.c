@@ -69,6 +69,8 @@
 #include "portaudio.h"
 #include "pa_util.h"
 #include "pa_unix_util.h"
+#include "pa_unix_callback_pipeline.h"
+#include "pa_unix_ready_event.h"
 #include "pa_allocation.h"
 #include "pa_hostapi.h"
 #include "pa_stream.h"
@@ -656,10 +658,17 @@ typedef struct PaAlsaStream
     PaUnixMutex stateMtx;                   /* Used to synchronize access to stream state */
 
     int neverDropInput;
+    int convertSampleRate;         /* bool: may the devices run at another rate than the stream callback? */
+    double hostSampleRate;         /* the rate the devices run at */
+
+    int pipelined;                 /* bool: does the user callback run on the pipeline's worker thread? */
+    PaUnixCallbackPipeline pipeline;
 
     PaTime underrun;
     PaTime overrun;
 
+    PaUnixReadyEvent readyEvent;   /* watches the device descriptors for Pa_GetStreamReadyFileDescriptor() */
+
     PaAlsaStreamComponent capture, playback;
 }
 PaAlsaStream;
@@ -724,8 +733,17 @@ static void *CallbackThreadFunc( void *userData );
 /* Blocking prototypes */
 static signed long GetStreamReadAvailable( PaStream* s );
 static signed long GetStreamWriteAvailable( PaStream* s );
+static PaError GetReadyFileDescriptor( PaStream* s, unsigned long frames, int *fileDescriptor );
+static PaError AcquireWriteBuffer( PaStream* s, void **buffer, unsigned long *frames );
+static PaError CommitWriteBuffer( PaStream* s, unsigned long frames );
+static PaError AcquireReadBuffer( PaStream* s, const void **buffer, unsigned long *frames );
+static PaError ReleaseReadBuffer( PaStream* s, unsigned long frames );
 static PaError ReadStream( PaStream* stream, void *buffer, unsigned long frames );
 static PaError WriteStream( PaStream* stream, const void *buffer, unsigned long frames );
+static PaError ReadStreamTimeout( PaStream* stream, void *buffer, unsigned long frames, PaTime timeout,
+        unsigned long *framesRead );
+static PaError WriteStreamTimeout( PaStream* stream, const void *buffer, unsigned long frames, PaTime timeout,
+        unsigned long *framesWritten );
 
 
 static const PaAlsaDeviceInfo *GetDeviceInfo( const PaUtilHostApiRepresentation *hostApi, int device )
@@ -788,6 +806,13 @@ PaError PaAlsa_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex
                                       ReadStream, WriteStream,
                                       GetStreamReadAvailable,
                                       GetStreamWriteAvailable );
+    alsaHostApi->blockingStreamInterface.GetReadyFileDescriptor = GetReadyFileDescriptor;
+    alsaHostApi->blockingStreamInterface.AcquireWriteBuffer = AcquireWriteBuffer;
+    alsaHostApi->blockingStreamInterface.CommitWriteBuffer = CommitWriteBuffer;
+    alsaHostApi->blockingStreamInterface.AcquireReadBuffer = AcquireReadBuffer;
+    alsaHostApi->blockingStreamInterface.ReleaseReadBuffer = ReleaseReadBuffer;
+    alsaHostApi->blockingStreamInterface.ReadTimeout = ReadStreamTimeout;
+    alsaHostApi->blockingStreamInterface.WriteTimeout = WriteStreamTimeout;
 
     PA_ENSURE( PaUnixThreading_Initialize() );
 
@@ -1564,6 +1589,10 @@ static PaSampleFormat GetAvailableFormats( snd_pcm_t *pcm )
         available |= paInt24;
 #endif
 
+    /* 24 bit samples in a native endian 32 bit container */
+    if( alsa_snd_pcm_hw_params_test_format( pcm, hwParams, SND_PCM_FORMAT_S24 ) >= 0)
+        available |= paInt24In32;
+
     if( alsa_snd_pcm_hw_params_test_format( pcm, hwParams, SND_PCM_FORMAT_S16 ) >= 0)
         available |= paInt16;
 
@@ -1718,6 +1747,9 @@ static snd_pcm_format_t Pa2AlsaFormat( PaSampleFormat paFormat )
         case paInt32:
             return SND_PCM_FORMAT_S32;
 
+        case paInt24In32:
+            return SND_PCM_FORMAT_S24;
+
         case paInt8:
             return SND_PCM_FORMAT_S8;
 
@@ -1976,7 +2008,7 @@ static int nearbyint_(float value) {
  *
  */
 static PaError PaAlsaStreamComponent_InitialConfigure( PaAlsaStreamComponent *self, const PaStreamParameters *params,
-        int primeBuffers, snd_pcm_hw_params_t *hwParams, double *sampleRate )
+        int primeBuffers, int convertSampleRate, snd_pcm_hw_params_t *hwParams, double *sampleRate )
 {
     /* Configuration consists of setting all of ALSA's parameters.
      * These parameters come in two flavors: hardware parameters
@@ -2064,8 +2096,12 @@ static PaError PaAlsaStreamComponent_InitialConfigure( PaAlsaStreamComponent *se
         ENSURE_( GetExactSampleRate( hwParams, &sr ), paUnanticipatedHostError );
         if( result == paInvalidSampleRate ) /* From the SetApproximateSampleRate() call above */
         { /* The sample rate was returned as 'out of tolerance' of the one requested */
-            PA_DEBUG(( "%s: Wanted %.3f, closest sample rate was %.3f\n", __FUNCTION__, sampleRate, sr ));
-            PA_ENSURE( paInvalidSampleRate );
+            PA_DEBUG(( "%s: Wanted %.3f, closest sample rate was %.3f\n", __FUNCTION__, *sampleRate, sr ));
+            if( !convertSampleRate )
+                PA_ENSURE( paInvalidSampleRate );
+
+            /* the buffer processor converts from the closest rate */
+            result = paNoError;
         }
     }
     else
@@ -2179,6 +2215,7 @@ static PaError PaAlsaStream_Initialize( PaAlsaStream *self, PaAlsaHostApiReprese
 
     self->framesPerUserBuffer = framesPerUserBuffer;
     self->neverDropInput = streamFlags & paNeverDropInput;
+    self->convertSampleRate = NULL != callback && (streamFlags & paConvertSampleRate);
     /* XXX: Ignore paPrimeOutputBuffersUsingStreamCallback until buffer priming is fully supported in pa_process.c */
     /*
     if( outParams & streamFlags & paPrimeOutputBuffersUsingStreamCallback )
@@ -2186,6 +2223,7 @@ static PaError PaAlsaStream_Initialize( PaAlsaStream *self, PaAlsaHostApiReprese
         */
     memset( &self->capture, 0, sizeof (PaAlsaStreamComponent) );
     memset( &self->playback, 0, sizeof (PaAlsaStreamComponent) );
+    PaUnixReadyEvent_Initialize( &self->readyEvent );
     if( inParams )
     {
         PA_ENSURE( PaAlsaStreamComponent_Initialize( &self->capture, alsaApi, inParams, StreamDirection_In, NULL != callback ) );
@@ -2224,6 +2262,12 @@ static void PaAlsaStream_Terminate( PaAlsaStream *self )
         PaAlsaStreamComponent_Terminate( &self->playback );
     }
 
+    if( self->pipelined )
+    {
+        PaUnixCallbackPipeline_Terminate( &self->pipeline );
+    }
+
+    PaUnixReadyEvent_Terminate( &self->readyEvent );
     PaUtil_FreeMemory( self->pfds );
     ASSERT_CALL_( PaUnixMutex_Terminate( &self->stateMtx ), paNoError );
 
@@ -2237,9 +2281,9 @@ static void PaAlsaStream_Terminate( PaAlsaStream *self )
  */
 static int CalculatePollTimeout( const PaAlsaStream *stream, unsigned long frames )
 {
-    assert( stream->streamRepresentation.streamInfo.sampleRate > 0.0 );
+    assert( stream->hostSampleRate > 0.0 );
     /* Period in msecs, rounded up */
-    return (int)ceil( 1000 * frames / stream->streamRepresentation.streamInfo.sampleRate );
+    return (int)ceil( 1000 * frames / stream->hostSampleRate );
 }
 
 /** Align value in backward direction.
@@ -2736,11 +2780,11 @@ static PaError PaAlsaStream_Configure( PaAlsaStream *self, const PaStreamParamet
     alsa_snd_pcm_hw_params_alloca( &hwParamsPlayback );
 
     if( self->capture.pcm )
-        PA_ENSURE( PaAlsaStreamComponent_InitialConfigure( &self->capture, inParams, self->primeBuffers, hwParamsCapture,
-                    &realSr ) );
+        PA_ENSURE( PaAlsaStreamComponent_InitialConfigure( &self->capture, inParams, self->primeBuffers,
+                    self->convertSampleRate, hwParamsCapture, &realSr ) );
     if( self->playback.pcm )
-        PA_ENSURE( PaAlsaStreamComponent_InitialConfigure( &self->playback, outParams, self->primeBuffers, hwParamsPlayback,
-                    &realSr ) );
+        PA_ENSURE( PaAlsaStreamComponent_InitialConfigure( &self->playback, outParams, self->primeBuffers,
+                    self->convertSampleRate, hwParamsPlayback, &realSr ) );
 
     PA_ENSURE( PaAlsaStream_DetermineFramesPerBuffer( self, realSr, inParams, outParams, framesPerUserBuffer,
                 hwParamsCapture, hwParamsPlayback, hostBufferSizeMode ) );
@@ -2762,6 +2806,7 @@ static PaError PaAlsaStream_Configure( PaAlsaStream *self, const PaStreamParamet
 
     /* Should be exact now */
     self->streamRepresentation.streamInfo.sampleRate = realSr;
+    self->hostSampleRate = realSr;
 
     /* this will cause the two streams to automatically start/stop/prepare in sync.
      * We only need to execute these operations on one of the pair.
@@ -2827,6 +2872,9 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     PaSampleFormat inputSampleFormat = 0, outputSampleFormat = 0;
     int numInputChannels = 0, numOutputChannels = 0;
     PaTime inputLatency, outputLatency;
+    double hostSampleRate = sampleRate;
+    PaStreamCallback *bufferProcessorCallback = callback;
+    void *bufferProcessorUserData = userData;
     /* Operate with fixed host buffer size by default, since other modes will invariably lead to block adaption */
     /* XXX: Use Bounded by default? Output tends to get stuttery with Fixed ... */
     PaUtilHostBufferSizeMode hostBufferSizeMode = paUtilFixedHostBufferSize;
@@ -2865,19 +2913,51 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     hostInputSampleFormat = stream->capture.hostSampleFormat | (!stream->capture.hostInterleaved ? paNonInterleaved : 0);
     hostOutputSampleFormat = stream->playback.hostSampleFormat | (!stream->playback.hostInterleaved ? paNonInterleaved : 0);
 
-    PA_ENSURE( PaUtil_InitializeBufferProcessor( &stream->bufferProcessor,
+    /* Within the tolerance of SetApproximateSampleRate() the devices are considered to run at the requested rate */
+    if( stream->convertSampleRate && fabs( stream->hostSampleRate - sampleRate ) * RATE_MAX_DEVIATE_RATIO > sampleRate )
+        hostSampleRate = stream->hostSampleRate;
+
+    if( streamFlags & paPipelineCallback )
+    {
+        /* the pipeline needs fixed size user buffers */
+        if( framesPerBuffer == paFramesPerBufferUnspecified )
+            framesPerBuffer = stream->maxFramesPerHostBuffer;
+
+        PA_ENSURE( PaUnixCallbackPipeline_Initialize( &stream->pipeline,
+                        numInputChannels, inputSampleFormat, numOutputChannels, outputSampleFormat,
+                        sampleRate, framesPerBuffer, PaUnixCallbackPipeline_GetLookahead( streamFlags ),
+                        callback, userData ) );
+        stream->pipelined = 1;
+        stream->streamRepresentation.streamInfo.flags |= paStreamInfoPipelinedCallback;
+
+        bufferProcessorCallback = PaUnixCallbackPipeline_Callback;
+        bufferProcessorUserData = &stream->pipeline;
+    }
+
+    PA_ENSURE( PaUtil_InitializeResamplingBufferProcessor( &stream->bufferProcessor,
                     numInputChannels, inputSampleFormat, hostInputSampleFormat,
                     numOutputChannels, outputSampleFormat, hostOutputSampleFormat,
-                    sampleRate, streamFlags, framesPerBuffer, stream->maxFramesPerHostBuffer,
-                    hostBufferSizeMode, callback, userData ) );
+                    sampleRate, hostSampleRate, streamFlags, framesPerBuffer, stream->maxFramesPerHostBuffer,
+                    hostBufferSizeMode, bufferProcessorCallback, bufferProcessorUserData ) );
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
+
+    if( stream->bufferProcessor.resamplingStage )
+    {
+        /* the stream callback runs at the requested rate, the devices at the closest one */
+        stream->streamRepresentation.streamInfo.sampleRate = sampleRate;
+        stream->streamRepresentation.streamInfo.flags |= paStreamInfoSampleRateConverted;
+        PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, hostSampleRate );
+    }
 
     /* Ok, buffer processor is initialized, now we can deduce it's latency */
     if( numInputChannels > 0 )
         stream->streamRepresentation.streamInfo.inputLatency = inputLatency + (PaTime)(
-                PaUtil_GetBufferProcessorInputLatencyFrames( &stream->bufferProcessor ) / sampleRate);
+                PaUtil_GetBufferProcessorInputLatencyFrames( &stream->bufferProcessor ) / hostSampleRate);
     if( numOutputChannels > 0 )
         stream->streamRepresentation.streamInfo.outputLatency = outputLatency + (PaTime)(
-                PaUtil_GetBufferProcessorOutputLatencyFrames( &stream->bufferProcessor ) / sampleRate);
+                PaUtil_GetBufferProcessorOutputLatencyFrames( &stream->bufferProcessor ) / hostSampleRate)
+                + ( stream->pipelined ? PaUnixCallbackPipeline_GetOutputLatency( &stream->pipeline ) : 0. );
 
     PA_DEBUG(( "%s: Stream: framesPerBuffer = %lu, maxFramesPerHostBuffer = %lu, latency i=%f, o=%f\n", __FUNCTION__, framesPerBuffer, stream->maxFramesPerHostBuffer, stream->streamRepresentation.streamInfo.inputLatency, stream->streamRepresentation.streamInfo.outputLatency));
 
@@ -3016,6 +3096,10 @@ static PaError StartStream( PaStream *s )
 
     if( stream->callbackMode )
     {
+        if( stream->pipelined )
+        {
+            PA_ENSURE( PaUnixCallbackPipeline_Start( &stream->pipeline, stream->rtSched ) );
+        }
         PA_ENSURE( PaUnixThread_New( &stream->thread, &CallbackThreadFunc, stream, 1., stream->rtSched ) );
     }
     else
@@ -3031,6 +3115,10 @@ error:
     {
         AbortStream( stream );
     }
+    if( stream->pipelined )
+    {
+        PaUnixCallbackPipeline_Stop( &stream->pipeline );
+    }
     stream->isActive = 0;
 
     goto end;
@@ -3125,6 +3213,10 @@ static PaError RealStop( PaAlsaStream *stream, int abort )
         {
             PA_DEBUG(( "Callback thread returned: %d\n", threadRes ));
         }
+        if( stream->pipelined )
+        {
+            PA_ENSURE( PaUnixCallbackPipeline_Stop( &stream->pipeline ) );
+        }
 #if 0
         if( watchdogRes != paNoError )
             PA_DEBUG(( "Watchdog thread returned: %d\n", watchdogRes ));
@@ -3316,6 +3408,9 @@ static PaError PaAlsaStream_HandleXrun( PaAlsaStream *self )
         {
             alsa_snd_pcm_status_get_trigger_tstamp( st, &t );
             self->underrun = ( now - StatusToTime( st, 1, NULL ) ) * 1000;
+            /* callback streams count it when passing the status flag to the buffer processor */
+            if( !self->callbackMode )
+                PaUtil_CountBufferProcessorXruns( &self->bufferProcessor, paOutputUnderflow );
 
             if( !self->playback.canMmap )
             {
@@ -3335,6 +3430,8 @@ static PaError PaAlsaStream_HandleXrun( PaAlsaStream *self )
         if( alsa_snd_pcm_status_get_state( st ) == SND_PCM_STATE_XRUN )
         {
             self->overrun = ( now - StatusToTime( st, 1, NULL ) ) * 1000;
+            if( !self->callbackMode )
+                PaUtil_CountBufferProcessorXruns( &self->bufferProcessor, paInputOverflow );
 
             if (!self->capture.canMmap)
             {
@@ -3460,7 +3557,7 @@ static void CalculateTimeInfo( PaAlsaStream *stream, PaStreamCallbackTimeInfo *t
 
         timeInfo->currentTime = capture_time;
         timeInfo->inputBufferAdcTime = capture_time -
-            (PaTime)capture_delay / stream->streamRepresentation.streamInfo.sampleRate;
+            (PaTime)capture_delay / stream->hostSampleRate;
     }
     if( stream->playback.pcm )
     {
@@ -3481,7 +3578,7 @@ static void CalculateTimeInfo( PaAlsaStream *stream, PaStreamCallbackTimeInfo *t
             timeInfo->currentTime = playback_time;
 
         timeInfo->outputBufferDacTime = timeInfo->currentTime +
-            (PaTime)playback_delay / stream->streamRepresentation.streamInfo.sampleRate;
+            (PaTime)playback_delay / stream->hostSampleRate;
     }
 }
 
@@ -3794,10 +3891,12 @@ error:
  *
  * @concern Xruns Both polling and querying available frames can report an xrun condition.
  *
+ * @param deadline Time (PaUtil_GetTime() base) after which to give up with paTimedOut, or 0 to wait indefinitely
  * @param framesAvail Return the number of available frames
  * @param xrunOccurred Return whether an xrun has occurred
  */
-static PaError PaAlsaStream_WaitForFrames( PaAlsaStream *self, unsigned long *framesAvail, int *xrunOccurred )
+static PaError PaAlsaStream_WaitForFrames( PaAlsaStream *self, PaTime deadline, unsigned long *framesAvail,
+        int *xrunOccurred )
 {
     PaError result = paNoError;
     int pollPlayback = self->playback.pcm != NULL, pollCapture = self->capture.pcm != NULL;
@@ -3832,12 +3931,24 @@ static PaError PaAlsaStream_WaitForFrames( PaAlsaStream *self, unsigned long *fr
 
     while( pollPlayback || pollCapture )
     {
-        int totalFds = 0;
+        int totalFds = 0, timeout = pollTimeout;
         struct pollfd *capturePfds = NULL, *playbackPfds = NULL;
 
 #ifdef PTHREAD_CANCELED
         pthread_testcancel();
 #endif
+        if( deadline > 0. )
+        {
+            PaTime remaining = deadline - PaUtil_GetTime();
+            if( remaining <= 0. )
+            {
+                *framesAvail = 0;
+                result = paTimedOut;
+                goto end;
+            }
+            if( remaining * 1000. < timeout )
+                timeout = (int)(remaining * 1000.) + 1;
+        }
         if( pollCapture )
         {
             capturePfds = self->pfds;
@@ -3870,7 +3981,7 @@ static PaError PaAlsaStream_WaitForFrames( PaAlsaStream *self, unsigned long *fr
         }
 #endif
 
-        pollResults = poll( self->pfds, totalFds, pollTimeout );
+        pollResults = poll( self->pfds, totalFds, timeout );
 
 #ifdef PTHREAD_CANCELED
         if( self->callbackMode )
@@ -4332,7 +4443,7 @@ static void *CallbackThreadFunc( void *userData )
         /* Wait for data to become available, this comes down to polling the ALSA file descriptors until we have
          * a number of available frames.
          */
-        PA_ENSURE( PaAlsaStream_WaitForFrames( stream, &framesAvail, &xrun ) );
+        PA_ENSURE( PaAlsaStream_WaitForFrames( stream, 0., &framesAvail, &xrun ) );
         if( xrun )
         {
             assert( 0 == framesAvail );
@@ -4440,10 +4551,11 @@ error:
 
 /* Blocking interface */
 
-static PaError ReadStream( PaStream* s, void *buffer, unsigned long frames )
+/* Read into buffer until frames have been read or deadline (0 for none) has passed */
+static PaError ReadStreamUntil( PaAlsaStream *stream, void *buffer, unsigned long frames, PaTime deadline,
+        unsigned long *framesRead )
 {
     PaError result = paNoError;
-    PaAlsaStream *stream = (PaAlsaStream*)s;
     unsigned long framesGot, framesAvail;
     void *userBuffer;
     snd_pcm_t *save = stream->playback.pcm;
@@ -4481,7 +4593,13 @@ static PaError ReadStream( PaStream* s, void *buffer, unsigned long frames )
     while( frames > 0 )
     {
         int xrun = 0;
-        PA_ENSURE( PaAlsaStream_WaitForFrames( stream, &framesAvail, &xrun ) );
+        PaError waitResult = PaAlsaStream_WaitForFrames( stream, deadline, &framesAvail, &xrun );
+        if( waitResult == paTimedOut )
+        {
+            result = paTimedOut;
+            goto end;
+        }
+        PA_ENSURE( waitResult );
         framesGot = PA_MIN( framesAvail, frames );
 
         PA_ENSURE( PaAlsaStream_SetUpBuffers( stream, &framesGot, &xrun ) );
@@ -4490,6 +4608,7 @@ static PaError ReadStream( PaStream* s, void *buffer, unsigned long frames )
             framesGot = PaUtil_CopyInput( &stream->bufferProcessor, &userBuffer, framesGot );
             PA_ENSURE( PaAlsaStream_EndProcessing( stream, framesGot, &xrun ) );
             frames -= framesGot;
+            *framesRead += framesGot;
         }
     }
 
@@ -4500,11 +4619,44 @@ error:
     goto end;
 }
 
-static PaError WriteStream( PaStream* s, const void *buffer, unsigned long frames )
+static PaError ReadStream( PaStream* s, void *buffer, unsigned long frames )
+{
+    unsigned long framesRead = 0;
+    return ReadStreamUntil( (PaAlsaStream*)s, buffer, frames, 0., &framesRead );
+}
+
+static PaError ReadStreamTimeout( PaStream* s, void *buffer, unsigned long frames, PaTime timeout,
+        unsigned long *framesRead )
+{
+    return ReadStreamUntil( (PaAlsaStream*)s, buffer, frames, PaUtil_GetTime() + timeout, framesRead );
+}
+
+/* Start the playback pcm after one period of samples worth */
+static PaError StartPlaybackWhenPrimed( PaAlsaStream *stream )
 {
     PaError result = paNoError;
     signed long err;
-    PaAlsaStream *stream = (PaAlsaStream*)s;
+    snd_pcm_uframes_t hwAvail;
+
+    /* Frames residing in buffer */
+    PA_ENSURE( err = GetStreamWriteAvailable( stream ) );
+    hwAvail = stream->playback.alsaBufferSize - err;
+
+    if( alsa_snd_pcm_state( stream->playback.pcm ) == SND_PCM_STATE_PREPARED &&
+            hwAvail >= stream->playback.framesPerPeriod )
+    {
+        ENSURE_( alsa_snd_pcm_start( stream->playback.pcm ), paUnanticipatedHostError );
+    }
+
+error:
+    return result;
+}
+
+/* Write from buffer until frames have been written or deadline (0 for none) has passed */
+static PaError WriteStreamUntil( PaAlsaStream *stream, const void *buffer, unsigned long frames, PaTime deadline,
+        unsigned long *framesWritten )
+{
+    PaError result = paNoError;
     snd_pcm_uframes_t framesGot, framesAvail;
     const void *userBuffer;
     snd_pcm_t *save = stream->capture.pcm;
@@ -4533,9 +4685,13 @@ static PaError WriteStream( PaStream* s, const void *buffer, unsigned long frame
     while( frames > 0 )
     {
         int xrun = 0;
-        snd_pcm_uframes_t hwAvail;
-
-        PA_ENSURE( PaAlsaStream_WaitForFrames( stream, &framesAvail, &xrun ) );
+        PaError waitResult = PaAlsaStream_WaitForFrames( stream, deadline, &framesAvail, &xrun );
+        if( waitResult == paTimedOut )
+        {
+            result = paTimedOut;
+            goto end;
+        }
+        PA_ENSURE( waitResult );
         framesGot = PA_MIN( framesAvail, frames );
 
         PA_ENSURE( PaAlsaStream_SetUpBuffers( stream, &framesGot, &xrun ) );
@@ -4544,20 +4700,10 @@ static PaError WriteStream( PaStream* s, const void *buffer, unsigned long frame
             framesGot = PaUtil_CopyOutput( &stream->bufferProcessor, &userBuffer, framesGot );
             PA_ENSURE( PaAlsaStream_EndProcessing( stream, framesGot, &xrun ) );
             frames -= framesGot;
+            *framesWritten += framesGot;
         }
 
-        /* Start stream after one period of samples worth */
-
-        /* Frames residing in buffer */
-        PA_ENSURE( err = GetStreamWriteAvailable( stream ) );
-        framesAvail = err;
-        hwAvail = stream->playback.alsaBufferSize - framesAvail;
-
-        if( alsa_snd_pcm_state( stream->playback.pcm ) == SND_PCM_STATE_PREPARED &&
-                hwAvail >= stream->playback.framesPerPeriod )
-        {
-            ENSURE_( alsa_snd_pcm_start( stream->playback.pcm ), paUnanticipatedHostError );
-        }
+        PA_ENSURE( StartPlaybackWhenPrimed( stream ) );
     }
 
 end:
@@ -4567,6 +4713,18 @@ error:
     goto end;
 }
 
+static PaError WriteStream( PaStream* s, const void *buffer, unsigned long frames )
+{
+    unsigned long framesWritten = 0;
+    return WriteStreamUntil( (PaAlsaStream*)s, buffer, frames, 0., &framesWritten );
+}
+
+static PaError WriteStreamTimeout( PaStream* s, const void *buffer, unsigned long frames, PaTime timeout,
+        unsigned long *framesWritten )
+{
+    return WriteStreamUntil( (PaAlsaStream*)s, buffer, frames, PaUtil_GetTime() + timeout, framesWritten );
+}
+
 /* Return frames available for reading. In the event of an overflow, the capture pcm will be restarted */
 static signed long GetStreamReadAvailable( PaStream* s )
 {
@@ -4617,6 +4775,165 @@ error:
     return result;
 }
 
+/* The mmap area is only handed out when the user's samples can be stored there as they are */
+static int CanAcquireHostBuffer( const PaAlsaStreamComponent *self, int userFormatIsEqualToHost )
+{
+    return self->canMmap && self->userInterleaved && self->hostInterleaved &&
+        self->numUserChannels == self->numHostChannels && userFormatIsEqualToHost;
+}
+
+/* Commit frames of the mmap area acquired by AcquireWriteBuffer() or AcquireReadBuffer() */
+static PaError CommitHostBuffer( PaAlsaStream *stream, PaAlsaStreamComponent *self, unsigned long frames )
+{
+    PaError result = paNoError;
+    snd_pcm_sframes_t res = alsa_snd_pcm_mmap_commit( self->pcm, self->offset, frames );
+
+    if( res == -EPIPE )
+    {
+        PA_ENSURE( PaAlsaStream_HandleXrun( stream ) );
+    }
+#if defined(ESTRPIPE) && ESTRPIPE != EPIPE
+    else if( res == -ESTRPIPE )
+    {
+        PA_ENSURE( PaAlsaStream_HandleXrun( stream ) );
+    }
+#endif
+    else
+    {
+        ENSURE_( res, paUnanticipatedHostError );
+    }
+
+error:
+    return result;
+}
+
+static PaError AcquireWriteBuffer( PaStream* s, void **buffer, unsigned long *frames )
+{
+    PaError result = paNoError;
+    PaAlsaStream *stream = (PaAlsaStream*)s;
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t framesGot = *frames;
+    signed long framesAvail;
+
+    *frames = 0;
+    PA_UNLESS( stream->playback.pcm, paCanNotWriteToAnInputOnlyStream );
+    if( !CanAcquireHostBuffer( &stream->playback, stream->bufferProcessor.userOutputSampleFormatIsEqualToHost ) )
+        return paIncompatibleStreamHostApi;
+
+    /* This also updates the available frames, which mmap_begin relies on */
+    PA_ENSURE( framesAvail = GetStreamWriteAvailable( s ) );
+    framesGot = PA_MIN( framesGot, (snd_pcm_uframes_t)framesAvail );
+    if( framesGot > 0 )
+    {
+        ENSURE_( alsa_snd_pcm_mmap_begin( stream->playback.pcm, &areas, &stream->playback.offset, &framesGot ),
+                paUnanticipatedHostError );
+        *buffer = ExtractAddress( areas, stream->playback.offset );
+    }
+    *frames = framesGot;
+
+error:
+    return result;
+}
+
+static PaError CommitWriteBuffer( PaStream* s, unsigned long frames )
+{
+    PaError result = paNoError;
+    PaAlsaStream *stream = (PaAlsaStream*)s;
+
+    PA_ENSURE( CommitHostBuffer( stream, &stream->playback, frames ) );
+    PA_ENSURE( StartPlaybackWhenPrimed( stream ) );
+
+    if( stream->underrun > 0. )
+    {
+        result = paOutputUnderflowed;
+        stream->underrun = 0.0;
+    }
+
+error:
+    return result;
+}
+
+static PaError AcquireReadBuffer( PaStream* s, const void **buffer, unsigned long *frames )
+{
+    PaError result = paNoError;
+    PaAlsaStream *stream = (PaAlsaStream*)s;
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t framesGot = *frames;
+    signed long framesAvail;
+
+    *frames = 0;
+    PA_UNLESS( stream->capture.pcm, paCanNotReadFromAnOutputOnlyStream );
+    if( !CanAcquireHostBuffer( &stream->capture, stream->bufferProcessor.userInputSampleFormatIsEqualToHost ) )
+        return paIncompatibleStreamHostApi;
+
+    /* Start stream if in prepared state */
+    if( alsa_snd_pcm_state( stream->capture.pcm ) == SND_PCM_STATE_PREPARED )
+    {
+        ENSURE_( alsa_snd_pcm_start( stream->capture.pcm ), paUnanticipatedHostError );
+    }
+
+    /* This also updates the available frames, which mmap_begin relies on */
+    PA_ENSURE( framesAvail = GetStreamReadAvailable( s ) );
+    framesGot = PA_MIN( framesGot, (snd_pcm_uframes_t)framesAvail );
+    if( framesGot > 0 )
+    {
+        ENSURE_( alsa_snd_pcm_mmap_begin( stream->capture.pcm, &areas, &stream->capture.offset, &framesGot ),
+                paUnanticipatedHostError );
+        *buffer = ExtractAddress( areas, stream->capture.offset );
+    }
+    *frames = framesGot;
+
+    if( stream->overrun > 0. )
+    {
+        result = paInputOverflowed;
+        stream->overrun = 0.0;
+    }
+
+error:
+    return result;
+}
+
+static PaError ReleaseReadBuffer( PaStream* s, unsigned long frames )
+{
+    PaAlsaStream *stream = (PaAlsaStream*)s;
+
+    return CommitHostBuffer( stream, &stream->capture, frames );
+}
+
+/* The device descriptors wake up at avail_min, which is also the least that
+ * PaAlsaStream_WaitForFrames() waits for. Full-duplex streams are paced by their input.
+ */
+static PaError GetReadyFileDescriptor( PaStream* s, unsigned long frames, int *fileDescriptor )
+{
+    PaError result = paNoError;
+    PaAlsaStream *stream = (PaAlsaStream*)s;
+    PaAlsaStreamComponent *component = stream->capture.pcm ? &stream->capture : &stream->playback;
+    snd_pcm_sw_params_t* swParams;
+    struct pollfd *pfds = NULL;
+
+    alsa_snd_pcm_sw_params_alloca( &swParams );
+
+    ENSURE_( alsa_snd_pcm_sw_params_current( component->pcm, swParams ), paUnanticipatedHostError );
+    ENSURE_( alsa_snd_pcm_sw_params_set_avail_min( component->pcm, swParams,
+                PA_MIN( frames, component->alsaBufferSize ) ), paUnanticipatedHostError );
+    ENSURE_( alsa_snd_pcm_sw_params( component->pcm, swParams ), paUnanticipatedHostError );
+
+    if( !PaUnixReadyEvent_IsCreated( &stream->readyEvent ) )
+    {
+        PA_UNLESS( pfds = (struct pollfd*)PaUtil_AllocateZeroInitializedMemory( component->nfds * sizeof (struct pollfd) ),
+                paInsufficientMemory );
+        PA_UNLESS( alsa_snd_pcm_poll_descriptors( component->pcm, pfds, component->nfds ) == (int)component->nfds,
+                paUnanticipatedHostError );
+        PA_ENSURE( PaUnixReadyEvent_CreateFromDescriptors( &stream->readyEvent, pfds, component->nfds ) );
+    }
+
+    *fileDescriptor = stream->readyEvent.fd;
+
+error:
+    PaUtil_FreeMemory( pfds );
+    return result;
+}
+
 /* Extensions */
 
 void PaAlsa_InitializeStreamInfo( PaAlsaStreamInfo *info )
@@ -1801,6 +1801,8 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
                 sampleRate, streamFlags,
                 framesPerBuffer, framesPerHostBuffer, paUtilFixedHostBufferSize,
                 streamCallback, userData ) );
+    stream->baseStreamRep.bufferProcessor = &stream->bufferProcessor;
+    stream->baseStreamRep.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
     stream->baseStreamRep.streamInfo.structVersion = 1;
     stream->baseStreamRep.streamInfo.sampleRate = sampleRate;
@@ -2492,6 +2492,8 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
             goto error;
         }
         callbackBufferProcessorInited = TRUE;
+        stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+        stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
         /* Initialize the blocking i/o buffer processor. */
         result = PaUtil_InitializeBufferProcessor(&stream->blockingState->bufferProcessor,
@@ -2709,6 +2711,8 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
             goto error;
         }
         callbackBufferProcessorInited = TRUE;
+        stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+        stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
         stream->streamRepresentation.streamInfo.inputLatency =
                 (double)( PaUtil_GetBufferProcessorInputLatencyFrames(&stream->bufferProcessor)
@@ -727,6 +727,8 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     if( result != paNoError )
         goto error;
 
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
     stream->streamRepresentation.streamInfo.inputLatency = inputLatency;
     stream->streamRepresentation.streamInfo.outputLatency = outputLatency;
     stream->streamRepresentation.streamInfo.sampleRate = sampleRate;
@@ -2010,6 +2010,8 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
             goto error;
     }
     stream->bufferProcessorIsInitialized = TRUE;
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
     // Calculate actual latency from the sum of individual latencies.
     if( inputParameters )
@@ -2064,6 +2064,8 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
         goto error;
 
     bufferProcessorIsInitialized = 1;
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
 
 /* DirectSound specific initialization */
@@ -58,6 +58,7 @@
 #include <math.h>
 #include <pthread.h>
 #include <semaphore.h>
+#include <time.h>
 
 #include <jack/types.h>
 #include <jack/jack.h>
@@ -71,6 +72,8 @@
 #include "pa_cpuload.h"
 #include "pa_ringbuffer.h"
 #include "pa_debugprint.h"
+#include "pa_unix_callback_pipeline.h"
+#include "pa_unix_ready_event.h"
 
 #include "pa_jack.h"
 
@@ -229,6 +232,12 @@ typedef struct PaJackStream
     sem_t                   data_semaphore;
     int                     bytesPerFrame;
     int                     samplesPerFrame;
+    PaUnixReadyEvent        readyEvent;
+
+    /* Set when the user callback runs on the pipeline's worker thread */
+
+    int                     isPipelined;
+    PaUnixCallbackPipeline  pipeline;
 
     struct PaJackStream *next;
 }
@@ -256,11 +265,14 @@ static int JackCallback( jack_nframes_t frames, void *userData );
 
 /* ---- blocking emulation layer ---- */
 
-/* Allocate buffer. */
+/* Allocate buffer. A mirrored buffer is used where available, so that
+   transfers which wrap around the end of the FIFO are a single copy. */
 static PaError BlockingInitFIFO( PaUtilRingBuffer *rbuf, long numFrames, long bytesPerFrame )
 {
     long numBytes = numFrames * bytesPerFrame;
-    char *buffer = (char *) malloc( numBytes );
+    char *buffer;
+    if( PaUtil_InitializeMirroredRingBuffer( rbuf, 1, numBytes ) == 0 ) return paNoError;
+    buffer = (char *) malloc( numBytes );
     if( buffer == NULL ) return paInsufficientMemory;
     memset( buffer, 0, numBytes );
     return (PaError) PaUtil_InitializeRingBuffer( rbuf, 1, numBytes, buffer );
@@ -269,11 +281,16 @@ static PaError BlockingInitFIFO( PaUtilRingBuffer *rbuf, long numFrames, long by
 /* Free buffer. */
 static PaError BlockingTermFIFO( PaUtilRingBuffer *rbuf )
 {
-    if( rbuf->buffer ) free( rbuf->buffer );
+    if( PaUtil_IsRingBufferMirrored( rbuf ) )
+        PaUtil_TerminateMirroredRingBuffer( rbuf );
+    else if( rbuf->buffer )
+        free( rbuf->buffer );
     rbuf->buffer = NULL;
     return paNoError;
 }
 
+static signed long BlockingGetReadyFrames( PaStream* s );
+
 static int
 BlockingCallback( const void                      *inputBuffer,
                   void                            *outputBuffer,
@@ -302,6 +319,7 @@ BlockingCallback( const void                      *inputBuffer,
         stream->data_available = 1;
         sem_post( &stream->data_semaphore );
     }
+    PaUnixReadyEvent_Update( &stream->readyEvent, (PaStream *)stream, BlockingGetReadyFrames );
     return paContinue;
 }
 
@@ -313,6 +331,8 @@ BlockingBegin( PaJackStream *stream, int minimum_buffer_size )
     PaError result = paNoError;
     long    numFrames;
 
+    PaUnixReadyEvent_Initialize( &stream->readyEvent );
+
     doRead = stream->local_input_ports != NULL;
     doWrite = stream->local_output_ports != NULL;
     /* <FIXME> */
@@ -352,9 +372,48 @@ BlockingEnd( PaJackStream *stream )
     BlockingTermFIFO( &stream->outFIFO );
 
     sem_destroy( &stream->data_semaphore );
+    PaUnixReadyEvent_Terminate( &stream->readyEvent );
 }
 
-static PaError BlockingReadStream( PaStream* s, void *data, unsigned long numFrames )
+/* Wait until the process callback has moved data, or until deadline (CLOCK_REALTIME) when it isn't NULL */
+static PaError BlockingWaitForData( PaJackStream *stream, const struct timespec *deadline )
+{
+    if( stream->data_available )
+    {
+        stream->data_available = 0;
+    }
+    else if( deadline == NULL )
+    {
+        sem_wait( &stream->data_semaphore );
+    }
+    else
+    {
+        while( sem_timedwait( &stream->data_semaphore, deadline ) != 0 )
+        {
+            if( errno == ETIMEDOUT )
+                return paTimedOut;
+            if( errno != EINTR )
+                return paInternalError;
+        }
+    }
+    return paNoError;
+}
+
+/* Return the CLOCK_REALTIME time timeout seconds from now, for sem_timedwait() */
+static void BlockingGetDeadline( PaTime timeout, struct timespec *deadline )
+{
+    clock_gettime( CLOCK_REALTIME, deadline );
+    deadline->tv_sec += (time_t)timeout;
+    deadline->tv_nsec += (long)((timeout - (time_t)timeout) * 1e9);
+    if( deadline->tv_nsec >= 1000000000 )
+    {
+        deadline->tv_sec += 1;
+        deadline->tv_nsec -= 1000000000;
+    }
+}
+
+static PaError BlockingReadStreamUntil( PaStream* s, void *data, unsigned long numFrames,
+                                        const struct timespec *deadline, unsigned long *framesRead )
 {
     PaError result = paNoError;
     PaJackStream *stream = (PaJackStream *)s;
@@ -370,22 +429,24 @@ static PaError BlockingReadStream( PaStream* s, void *data, unsigned long numFra
         if( numBytes > 0 )
         {
             /* see write for an explanation */
-            if( stream->data_available )
-                stream->data_available = 0;
-            else
-                sem_wait( &stream->data_semaphore );
+            result = BlockingWaitForData( stream, deadline );
+            if( result != paNoError )
+                break;
         }
     }
+    *framesRead = (p - (char *) data) / stream->bytesPerFrame;
+    PaUnixReadyEvent_Update( &stream->readyEvent, s, BlockingGetReadyFrames );
 
     return result;
 }
 
-static PaError BlockingWriteStream( PaStream* s, const void *data, unsigned long numFrames )
+static PaError BlockingWriteStreamUntil( PaStream* s, const void *data, unsigned long numFrames,
+                                         const struct timespec *deadline, unsigned long *framesWritten )
 {
     PaError result = paNoError;
     PaJackStream *stream = (PaJackStream *)s;
     long bytesWritten;
-    char *p = (char *) data;
+    const char *p = (const char *) data;
     long numBytes = stream->bytesPerFrame * numFrames;
     while( numBytes > 0 )
     {
@@ -408,16 +469,47 @@ static PaError BlockingWriteStream( PaStream* s, const void *data, unsigned long
              * on the semaphore; however, it doesn't matter, because if we block in (4),
              * we also do it in a loop
              */
-            if( stream->data_available )
-                stream->data_available = 0;
-            else
-                sem_wait( &stream->data_semaphore );
+            result = BlockingWaitForData( stream, deadline );
+            if( result != paNoError )
+                break;
         }
     }
+    *framesWritten = (p - (const char *) data) / stream->bytesPerFrame;
+    PaUnixReadyEvent_Update( &stream->readyEvent, s, BlockingGetReadyFrames );
 
     return result;
 }
 
+static PaError BlockingReadStream( PaStream* s, void *data, unsigned long numFrames )
+{
+    unsigned long framesRead;
+    return BlockingReadStreamUntil( s, data, numFrames, NULL, &framesRead );
+}
+
+static PaError BlockingWriteStream( PaStream* s, const void *data, unsigned long numFrames )
+{
+    unsigned long framesWritten;
+    return BlockingWriteStreamUntil( s, data, numFrames, NULL, &framesWritten );
+}
+
+static PaError BlockingReadStreamTimeout( PaStream* s, void *data, unsigned long numFrames,
+                                          PaTime timeout, unsigned long *framesRead )
+{
+    struct timespec deadline;
+
+    BlockingGetDeadline( timeout, &deadline );
+    return BlockingReadStreamUntil( s, data, numFrames, &deadline, framesRead );
+}
+
+static PaError BlockingWriteStreamTimeout( PaStream* s, const void *data, unsigned long numFrames,
+                                           PaTime timeout, unsigned long *framesWritten )
+{
+    struct timespec deadline;
+
+    BlockingGetDeadline( timeout, &deadline );
+    return BlockingWriteStreamUntil( s, data, numFrames, &deadline, framesWritten );
+}
+
 static signed long
 BlockingGetStreamReadAvailable( PaStream* s )
 {
@@ -436,6 +528,102 @@ BlockingGetStreamWriteAvailable( PaStream* s )
     return bytesEmpty / stream->bytesPerFrame;
 }
 
+/* Streams with input are paced by it, as Pa_ReadStream() waits for the
+   same callback which makes room for Pa_WriteStream(). */
+static signed long
+BlockingGetReadyFrames( PaStream* s )
+{
+    PaJackStream *stream = (PaJackStream *)s;
+
+    if( stream->inFIFO.buffer )
+        return BlockingGetStreamReadAvailable( s );
+    return BlockingGetStreamWriteAvailable( s );
+}
+
+static PaError
+BlockingGetReadyFileDescriptor( PaStream* s, unsigned long frames, int *fileDescriptor )
+{
+    PaError result = paNoError;
+    PaJackStream *stream = (PaJackStream *)s;
+    PaUtilRingBuffer *fifo = stream->inFIFO.buffer ? &stream->inFIFO : &stream->outFIFO;
+    unsigned long fifoFrames = fifo->bufferSize / stream->bytesPerFrame;
+
+    stream->readyEvent.frames = frames < fifoFrames ? frames : fifoFrames;
+    if( !PaUnixReadyEvent_IsCreated( &stream->readyEvent ) )
+        ENSURE_PA( PaUnixReadyEvent_CreateSignalled( &stream->readyEvent ) );
+    PaUnixReadyEvent_Update( &stream->readyEvent, s, BlockingGetReadyFrames );
+
+    *fileDescriptor = stream->readyEvent.fd;
+
+error:
+    return result;
+}
+
+/* The FIFOs hold frames in the user's format, so they can be handed out
+   unless the user's buffers are non-interleaved. */
+static PaError
+BlockingAcquireWriteBuffer( PaStream* s, void **buffer, unsigned long *frames )
+{
+    PaJackStream *stream = (PaJackStream *)s;
+    unsigned long fifoFrames = stream->outFIFO.bufferSize / stream->bytesPerFrame;
+    ring_buffer_size_t size1, size2;
+    void *data2;
+
+    if( !stream->outFIFO.buffer )
+        return paCanNotWriteToAnInputOnlyStream;
+    if( !stream->bufferProcessor.userOutputIsInterleaved )
+        return paIncompatibleStreamHostApi;
+
+    if( *frames > fifoFrames )
+        *frames = fifoFrames;
+    PaUtil_GetRingBufferWriteRegions( &stream->outFIFO, *frames * stream->bytesPerFrame,
+                                      buffer, &size1, &data2, &size2 );
+    *frames = size1 / stream->bytesPerFrame;
+    return paNoError;
+}
+
+static PaError
+BlockingCommitWriteBuffer( PaStream* s, unsigned long frames )
+{
+    PaJackStream *stream = (PaJackStream *)s;
+
+    PaUtil_AdvanceRingBufferWriteIndex( &stream->outFIFO, frames * stream->bytesPerFrame );
+    PaUnixReadyEvent_Update( &stream->readyEvent, s, BlockingGetReadyFrames );
+    return paNoError;
+}
+
+static PaError
+BlockingAcquireReadBuffer( PaStream* s, const void **buffer, unsigned long *frames )
+{
+    PaJackStream *stream = (PaJackStream *)s;
+    unsigned long fifoFrames = stream->inFIFO.bufferSize / stream->bytesPerFrame;
+    ring_buffer_size_t size1, size2;
+    void *data1, *data2;
+
+    if( !stream->inFIFO.buffer )
+        return paCanNotReadFromAnOutputOnlyStream;
+    if( !stream->bufferProcessor.userInputIsInterleaved )
+        return paIncompatibleStreamHostApi;
+
+    if( *frames > fifoFrames )
+        *frames = fifoFrames;
+    PaUtil_GetRingBufferReadRegions( &stream->inFIFO, *frames * stream->bytesPerFrame,
+                                     &data1, &size1, &data2, &size2 );
+    *buffer = data1;
+    *frames = size1 / stream->bytesPerFrame;
+    return paNoError;
+}
+
+static PaError
+BlockingReleaseReadBuffer( PaStream* s, unsigned long frames )
+{
+    PaJackStream *stream = (PaJackStream *)s;
+
+    PaUtil_AdvanceRingBufferReadIndex( &stream->inFIFO, frames * stream->bytesPerFrame );
+    PaUnixReadyEvent_Update( &stream->readyEvent, s, BlockingGetReadyFrames );
+    return paNoError;
+}
+
 static PaError
 BlockingWaitEmpty( PaStream *s )
 {
@@ -821,6 +1009,13 @@ PaError PaJack_Initialize( PaUtilHostApiRepresentation **hostApi,
                                       GetStreamTime, PaUtil_DummyGetCpuLoad,
                                       BlockingReadStream, BlockingWriteStream,
                                       BlockingGetStreamReadAvailable, BlockingGetStreamWriteAvailable );
+    jackHostApi->blockingStreamInterface.GetReadyFileDescriptor = BlockingGetReadyFileDescriptor;
+    jackHostApi->blockingStreamInterface.AcquireWriteBuffer = BlockingAcquireWriteBuffer;
+    jackHostApi->blockingStreamInterface.CommitWriteBuffer = BlockingCommitWriteBuffer;
+    jackHostApi->blockingStreamInterface.AcquireReadBuffer = BlockingAcquireReadBuffer;
+    jackHostApi->blockingStreamInterface.ReleaseReadBuffer = BlockingReleaseReadBuffer;
+    jackHostApi->blockingStreamInterface.ReadTimeout = BlockingReadStreamTimeout;
+    jackHostApi->blockingStreamInterface.WriteTimeout = BlockingWriteStreamTimeout;
 
     jackHostApi->inputBase = jackHostApi->outputBase = 0;
     jackHostApi->xrun = 0;
@@ -1026,6 +1221,8 @@ static void CleanUpStream( PaJackStream *stream, int terminateStreamRepresentati
 
     if( stream->isBlockingStream )
         BlockingEnd( stream );
+    if( stream->isPipelined )
+        PaUnixCallbackPipeline_Terminate( &stream->pipeline );
 
     for( i = 0; i < stream->num_incoming_connections; ++i )
     {
@@ -1346,6 +1543,23 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
         UNLESS( i == outputChannelCount, paInternalError );
     }
 
+    if( streamFlags & paPipelineCallback )
+    {
+        /* The pipeline needs fixed size user buffers */
+        if( framesPerBuffer == paFramesPerBufferUnspecified )
+            framesPerBuffer = jack_get_buffer_size( jackHostApi->jack_client );
+
+        ENSURE_PA( PaUnixCallbackPipeline_Initialize( &stream->pipeline,
+                      inputChannelCount, inputSampleFormat, outputChannelCount, outputSampleFormat,
+                      jackSr, framesPerBuffer, PaUnixCallbackPipeline_GetLookahead( streamFlags ),
+                      streamCallback, userData ) );
+        stream->isPipelined = 1;
+        stream->streamRepresentation.streamInfo.flags |= paStreamInfoPipelinedCallback;
+
+        streamCallback = PaUnixCallbackPipeline_Callback;
+        userData = &stream->pipeline;
+    }
+
     ENSURE_PA( PaUtil_InitializeBufferProcessor(
                   &stream->bufferProcessor,
                   inputChannelCount,
@@ -1362,6 +1576,8 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
                   streamCallback,
                   userData ) );
     bpInitialized = 1;
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
     if( stream->num_incoming_connections > 0 )
         stream->streamRepresentation.streamInfo.inputLatency = (jack_port_get_latency( stream->remote_output_ports[0] )
@@ -1370,7 +1586,8 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     if( stream->num_outgoing_connections > 0 )
         stream->streamRepresentation.streamInfo.outputLatency = (jack_port_get_latency( stream->remote_input_ports[0] )
                 - jack_get_buffer_size( jackHostApi->jack_client )  /* One buffer is not counted as latency */
-            + PaUtil_GetBufferProcessorOutputLatencyFrames( &stream->bufferProcessor )) / sampleRate;
+            + PaUtil_GetBufferProcessorOutputLatencyFrames( &stream->bufferProcessor )) / sampleRate
+            + ( stream->isPipelined ? PaUnixCallbackPipeline_GetOutputLatency( &stream->pipeline ) : 0. );
 
     stream->streamRepresentation.streamInfo.sampleRate = jackSr;
     stream->t0 = jack_frame_time( jackHostApi->jack_client );   /* A: Time should run from Pa_OpenStream */
@@ -1690,6 +1907,9 @@ static PaError StartStream( PaStream *s )
 
     stream->xrun = FALSE;
 
+    if( stream->isPipelined )
+        ENSURE_PA( PaUnixCallbackPipeline_Start( &stream->pipeline, jack_is_realtime( stream->jack_client ) ) );
+
     /* Enable processing */
 
     ASSERT_CALL( pthread_mutex_lock( &stream->hostApi->mtx ), 0 );
@@ -1710,6 +1930,9 @@ static PaError StartStream( PaStream *s )
     }
     ASSERT_CALL( pthread_mutex_unlock( &stream->hostApi->mtx ), 0 );
 
+    if( result != paNoError && stream->isPipelined )
+        PaUnixCallbackPipeline_Stop( &stream->pipeline );
+
     ENSURE_PA( result );
 
     stream->is_running = TRUE;
@@ -1745,6 +1968,10 @@ static PaError RealStop( PaJackStream *stream, int abort )
 error:
     stream->is_running = FALSE;
 
+    /* The process callback no longer calls the pipeline */
+    if( stream->isPipelined )
+        PaUnixCallbackPipeline_Stop( &stream->pipeline );
+
     /* Disconnect ports belonging to this stream */
 
     if( !stream->hostApi->jackIsDown )  /* XXX: Well? */
@@ -88,6 +88,8 @@
 #include "pa_cpuload.h"
 #include "pa_process.h"
 #include "pa_unix_util.h"
+#include "pa_unix_callback_pipeline.h"
+#include "pa_unix_ready_event.h"
 #include "pa_debugprint.h"
 
 static int sysErr_;
@@ -182,7 +184,8 @@ typedef struct PaOssStream
 
     int framesProcessed;
 
-    double sampleRate;
+    double sampleRate;  /* The rate the devices run at */
+    int convertSampleRate;  /* May the devices run at another rate than the stream callback? */
 
     int callbackMode;
     volatile int callbackStop, callbackAbort;
@@ -190,6 +193,11 @@ typedef struct PaOssStream
     PaOssStreamComponent *capture, *playback;
     unsigned long pollTimeout;
     sem_t semaphore;
+
+    int pipelined;  /* Does the user callback run on the pipeline's worker thread? */
+    PaUnixCallbackPipeline pipeline;
+
+    PaUnixReadyEvent readyEvent;    /* Watches the device for Pa_GetStreamReadyFileDescriptor() */
 }
 PaOssStream;
 
@@ -226,6 +234,11 @@ static PaError ReadStream( PaStream* stream, void *buffer, unsigned long frames
 static PaError WriteStream( PaStream* stream, const void *buffer, unsigned long frames );
 static signed long GetStreamReadAvailable( PaStream* stream );
 static signed long GetStreamWriteAvailable( PaStream* stream );
+static PaError ReadStreamTimeout( PaStream* stream, void *buffer, unsigned long frames, PaTime timeout,
+        unsigned long *framesRead );
+static PaError WriteStreamTimeout( PaStream* stream, const void *buffer, unsigned long frames, PaTime timeout,
+        unsigned long *framesWritten );
+static PaError GetReadyFileDescriptor( PaStream* stream, unsigned long frames, int *fileDescriptor );
 static PaError BuildDeviceList( PaOSSHostApiRepresentation *hostApi );
 
 
@@ -270,6 +283,9 @@ PaError PaOSS_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex
                                       StopStream, AbortStream, IsStreamStopped, IsStreamActive,
                                       GetStreamTime, PaUtil_DummyGetCpuLoad,
                                       ReadStream, WriteStream, GetStreamReadAvailable, GetStreamWriteAvailable );
+    ossHostApi->blockingStreamInterface.GetReadyFileDescriptor = GetReadyFileDescriptor;
+    ossHostApi->blockingStreamInterface.ReadTimeout = ReadStreamTimeout;
+    ossHostApi->blockingStreamInterface.WriteTimeout = WriteStreamTimeout;
 
     mainThread_ = pthread_self();
 
@@ -861,6 +877,8 @@ static PaError PaOssStream_Initialize( PaOssStream *stream, const PaStreamParame
 
     memset( stream, 0, sizeof (PaOssStream) );
     stream->isStopped = 1;
+    PaUnixReadyEvent_Initialize( &stream->readyEvent );
+    stream->convertSampleRate = callback != NULL && (streamFlags & paConvertSampleRate);
 
     PA_ENSURE( PaUtil_InitializeThreading( &stream->threading ) );
 
@@ -915,8 +933,11 @@ static void PaOssStream_Terminate( PaOssStream *stream )
         PaOssStreamComponent_Terminate( stream->capture );
     if( stream->playback )
         PaOssStreamComponent_Terminate( stream->playback );
+    if( stream->pipelined )
+        PaUnixCallbackPipeline_Terminate( &stream->pipeline );
 
     sem_destroy( &stream->semaphore );
+    PaUnixReadyEvent_Terminate( &stream->readyEvent );
 
     PaUtil_FreeMemory( stream );
 }
@@ -941,6 +962,11 @@ static PaError Pa2OssFormat( PaSampleFormat paFormat, int *ossFormat )
         case paInt32:
             *ossFormat = AFMT_S32_NE;
             break;
+#endif
+#ifdef AFMT_S24_NE
+        case paInt24In32:
+            *ossFormat = AFMT_S24_NE; /* 24 bits in a 32 bit container */
+            break;
 #endif
         default:
             return paInternalError;     /* This shouldn't happen */
@@ -968,6 +994,10 @@ static PaError GetAvailableFormats( PaOssStreamComponent *component, PaSampleFor
 #ifdef AFMT_S32_NE
     if( mask & AFMT_S32_NE )
         frmts |= paInt32;
+#endif
+#ifdef AFMT_S24_NE
+    if( mask & AFMT_S24_NE )
+        frmts |= paInt24In32;
 #endif
     if( frmts == 0 )
         result = paSampleFormatNotSupported;
@@ -992,13 +1022,15 @@ static unsigned long PaOssStreamComponent_BufferSize( PaOssStreamComponent *comp
 }
 
 /** Configure stream component device parameters.
+ *
+ * If convertSampleRate is set a device rate further than 1% from *sampleRate is accepted and returned in *sampleRate.
  */
-static PaError PaOssStreamComponent_Configure( PaOssStreamComponent *component, double sampleRate, unsigned long
-        framesPerBuffer, StreamMode streamMode, PaOssStreamComponent *master )
+static PaError PaOssStreamComponent_Configure( PaOssStreamComponent *component, double *sampleRate, unsigned long
+        framesPerBuffer, StreamMode streamMode, PaOssStreamComponent *master, int convertSampleRate )
 {
     PaError result = paNoError;
     int temp, nativeFormat;
-    int sr = (int)sampleRate;
+    int sr = (int)*sampleRate;
     PaSampleFormat availableFormats = 0, hostFormat = 0;
     int chans = component->userChannelCount;
     int frgmt;
@@ -1018,13 +1050,13 @@ static PaError PaOssStreamComponent_Configure( PaOssStreamComponent *component,
         if( framesPerBuffer == paFramesPerBufferUnspecified )
         {
             /* Aim for 4 fragments in the complete buffer; the latency comes from 3 of these */
-            fragSz = (unsigned long)(component->latency * sampleRate / 3);
+            fragSz = (unsigned long)(component->latency * *sampleRate / 3);
             bufSz = fragSz * 4;
         }
         else
         {
             fragSz = framesPerBuffer;
-            bufSz = (unsigned long)(component->latency * sampleRate) + fragSz; /* Latency + 1 buffer */
+            bufSz = (unsigned long)(component->latency * *sampleRate) + fragSz; /* Latency + 1 buffer */
         }
 
         PA_ENSURE( GetAvailableFormats( component, &availableFormats ) );
@@ -1058,11 +1090,13 @@ static PaError PaOssStreamComponent_Configure( PaOssStreamComponent *component,
         /* try to set the sample rate */
         ENSURE_( ioctl( component->fd, SNDCTL_DSP_SPEED, &sr ), paInvalidSampleRate );
 
-        /* reject if there's no sample rate within 1% of the one requested */
-        if( (fabs( sampleRate - sr ) / sampleRate) > 0.01 )
+        /* reject if there's no sample rate within 1% of the one requested, unless the buffer processor converts */
+        if( (fabs( *sampleRate - sr ) / *sampleRate) > 0.01 )
         {
-            PA_DEBUG(("%s: Wanted %f, closest sample rate was %d\n", __FUNCTION__, sampleRate, sr ));
-            PA_ENSURE( paInvalidSampleRate );
+            PA_DEBUG(("%s: Wanted %f, closest sample rate was %d\n", __FUNCTION__, *sampleRate, sr ));
+            if( !convertSampleRate )
+                PA_ENSURE( paInvalidSampleRate );
+            *sampleRate = sr;
         }
 
         ENSURE_( ioctl( component->fd, streamMode == StreamMode_In ? SNDCTL_DSP_GETISPACE : SNDCTL_DSP_GETOSPACE, &bufInfo ),
@@ -1130,6 +1164,7 @@ static PaError PaOssStream_Configure( PaOssStream *stream, double sampleRate, un
     PaError result = paNoError;
     int duplex = stream->capture && stream->playback;
     unsigned long framesPerHostBuffer = 0;
+    double hostSampleRate = sampleRate;
 
     /* We should request full duplex first thing after opening the device */
     if( duplex && stream->sharedDevice )
@@ -1138,24 +1173,25 @@ static PaError PaOssStream_Configure( PaOssStream *stream, double sampleRate, un
     if( stream->capture )
     {
         PaOssStreamComponent *component = stream->capture;
-        PA_ENSURE( PaOssStreamComponent_Configure( component, sampleRate, framesPerBuffer, StreamMode_In,
-                    NULL ) );
+        PA_ENSURE( PaOssStreamComponent_Configure( component, &hostSampleRate, framesPerBuffer, StreamMode_In,
+                    NULL, stream->convertSampleRate ) );
 
         assert( component->hostChannelCount > 0 );
         assert( component->hostFrames > 0 );
 
-        *inputLatency = (component->hostFrames * (component->numBufs - 1)) / sampleRate;
+        *inputLatency = (component->hostFrames * (component->numBufs - 1)) / hostSampleRate;
     }
     if( stream->playback )
     {
         PaOssStreamComponent *component = stream->playback, *master = stream->sharedDevice ? stream->capture : NULL;
-        PA_ENSURE( PaOssStreamComponent_Configure( component, sampleRate, framesPerBuffer, StreamMode_Out,
-                    master ) );
+        /* in full duplex both devices must run at the capture device's rate */
+        PA_ENSURE( PaOssStreamComponent_Configure( component, &hostSampleRate, framesPerBuffer, StreamMode_Out,
+                    master, stream->convertSampleRate && !stream->capture ) );
 
         assert( component->hostChannelCount > 0 );
         assert( component->hostFrames > 0 );
 
-        *outputLatency = (component->hostFrames * (component->numBufs - 1)) / sampleRate;
+        *outputLatency = (component->hostFrames * (component->numBufs - 1)) / hostSampleRate;
     }
 
     if( duplex )
@@ -1166,9 +1202,10 @@ static PaError PaOssStream_Configure( PaOssStream *stream, double sampleRate, un
         framesPerHostBuffer = stream->playback->hostFrames;
 
     stream->framesPerHostBuffer = framesPerHostBuffer;
-    stream->pollTimeout = (int) ceil( 1e6 * framesPerHostBuffer / sampleRate );    /* Period in usecs, rounded up */
+    stream->pollTimeout = (int) ceil( 1e6 * framesPerHostBuffer / hostSampleRate );    /* Period in usecs, rounded up */
 
-    stream->sampleRate = stream->streamRepresentation.streamInfo.sampleRate = sampleRate;
+    stream->sampleRate = hostSampleRate;
+    stream->streamRepresentation.streamInfo.sampleRate = sampleRate;
 
 error:
     return result;
@@ -1258,30 +1295,59 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
 
     PA_ENSURE( PaOssStream_Configure( stream, sampleRate, framesPerBuffer, &inLatency, &outLatency ) );
 
-    PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+    PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, stream->sampleRate );
 
     if( inputParameters )
-    {
         inputHostFormat = stream->capture->hostFormat;
-        stream->streamRepresentation.streamInfo.inputLatency = inLatency +
-            PaUtil_GetBufferProcessorInputLatencyFrames( &stream->bufferProcessor ) / sampleRate;
-    }
     if( outputParameters )
-    {
         outputHostFormat = stream->playback->hostFormat;
-        stream->streamRepresentation.streamInfo.outputLatency = outLatency +
-            PaUtil_GetBufferProcessorOutputLatencyFrames( &stream->bufferProcessor ) / sampleRate;
+
+    if( streamFlags & paPipelineCallback )
+    {
+        /* The pipeline calls the user callback with fixed size buffers, the buffer processor calls
+         * the pipeline's proxy callback in its place.
+         */
+        if( framesPerBuffer == paFramesPerBufferUnspecified )
+            framesPerBuffer = stream->framesPerHostBuffer;
+
+        PA_ENSURE( PaUnixCallbackPipeline_Initialize( &stream->pipeline, inputChannelCount, inputSampleFormat,
+                  outputChannelCount, outputSampleFormat, sampleRate, framesPerBuffer,
+                  PaUnixCallbackPipeline_GetLookahead( streamFlags ), streamCallback, userData ) );
+        stream->pipelined = 1;
+        stream->streamRepresentation.streamInfo.flags |= paStreamInfoPipelinedCallback;
+
+        streamCallback = PaUnixCallbackPipeline_Callback;
+        userData = &stream->pipeline;
     }
 
     /* Initialize buffer processor with fixed host buffer size.
      * Aspect StreamSampleFormat: Here we commit the user and host sample formats, PA infrastructure will
      * convert between the two.
      */
-    PA_ENSURE( PaUtil_InitializeBufferProcessor( &stream->bufferProcessor,
+    PA_ENSURE( PaUtil_InitializeResamplingBufferProcessor( &stream->bufferProcessor,
               inputChannelCount, inputSampleFormat, inputHostFormat, outputChannelCount, outputSampleFormat,
-              outputHostFormat, sampleRate, streamFlags, framesPerBuffer, stream->framesPerHostBuffer,
+              outputHostFormat, sampleRate, stream->sampleRate, streamFlags, framesPerBuffer, stream->framesPerHostBuffer,
               paUtilFixedHostBufferSize, streamCallback, userData ) );
     bpInitialized = 1;
+    /* the capture buffer is ours and is refilled by each read() */
+    PaUtil_SetHostInputBufferIsWritable( &stream->bufferProcessor, 1 );
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
+    if( stream->bufferProcessor.resamplingStage )
+        stream->streamRepresentation.streamInfo.flags |= paStreamInfoSampleRateConverted;
+
+    /* The buffer processor's latency is in host frames */
+    if( inputParameters )
+    {
+        stream->streamRepresentation.streamInfo.inputLatency = inLatency +
+            PaUtil_GetBufferProcessorInputLatencyFrames( &stream->bufferProcessor ) / stream->sampleRate;
+    }
+    if( outputParameters )
+    {
+        stream->streamRepresentation.streamInfo.outputLatency = outLatency +
+            PaUtil_GetBufferProcessorOutputLatencyFrames( &stream->bufferProcessor ) / stream->sampleRate
+            + ( stream->pipelined ? PaUnixCallbackPipeline_GetOutputLatency( &stream->pipeline ) : 0. );
+    }
 
     *s = (PaStream*)stream;
 
@@ -1817,13 +1883,19 @@ static PaError StartStream( PaStream *s )
     /* only use the thread for callback streams */
     if( stream->bufferProcessor.streamCallback )
     {
+        if( stream->pipelined )
+            PA_ENSURE( PaUnixCallbackPipeline_Start( &stream->pipeline, 0 ) );
         PA_ENSURE( PaUtil_StartThreading( &stream->threading, &PaOSS_AudioThreadProc, stream ) );
         sem_wait( &stream->semaphore );
     }
     else
         PA_ENSURE( PaOssStream_Prepare( stream ) );
 
+    return result;
+
 error:
+    if( stream->pipelined )
+        PaUnixCallbackPipeline_Stop( &stream->pipeline );
     return result;
 }
 
@@ -1839,6 +1911,8 @@ static PaError RealStop( PaOssStream *stream, int abort )
             stream->callbackStop = 1;
 
         PA_ENSURE( PaUtil_CancelThreading( &stream->threading, !abort, NULL ) );
+        if( stream->pipelined )
+            PA_ENSURE( PaUnixCallbackPipeline_Stop( &stream->pipeline ) );
 
         stream->callbackStop = stream->callbackAbort = 0;
     }
@@ -1932,14 +2006,38 @@ static double GetStreamCpuLoad( PaStream* s )
 */
 
 
-static PaError ReadStream( PaStream* s,
-                           void *buffer,
-                           unsigned long frames )
+/** Wait until fd is ready for events, or deadline has passed (paTimedOut).
+ * Returning paNoError doesn't guarantee that fd is ready, the caller checks again.
+ */
+static PaError WaitForDescriptor( int fd, short events, PaTime deadline )
+{
+    struct pollfd pfd;
+    PaTime remaining = deadline - PaUtil_GetTime();
+
+    if( remaining <= 0. )
+        return paTimedOut;
+
+    pfd.fd = fd;
+    pfd.events = events;
+    pfd.revents = 0;
+    if( poll( &pfd, 1, (int)(remaining * 1000.) + 1 ) < 0 && errno != EINTR )
+        return paUnanticipatedHostError;
+
+    return paNoError;
+}
+
+
+/** Read frames, giving up with paTimedOut at deadline unless it is 0 */
+static PaError ReadStreamUntil( PaOssStream *stream,
+                                void *buffer,
+                                unsigned long frames,
+                                PaTime deadline,
+                                unsigned long *framesRead )
 {
     PaError result = paNoError;
-    PaOssStream *stream = (PaOssStream*)s;
     int bytesRequested, bytesRead;
     unsigned long framesRequested;
+    signed long framesAvailable;
     void *userBuffer;
 
     /* If user input is non-interleaved, PaUtil_CopyInput will manipulate the channel pointers,
@@ -1956,6 +2054,20 @@ static PaError ReadStream( PaStream* s,
     {
         framesRequested = PA_MIN( frames, stream->capture->hostFrames );
 
+        if( deadline > 0. )
+        {
+            /* Only read what won't block */
+            PA_ENSURE( framesAvailable = GetStreamReadAvailable( (PaStream*)stream ) );
+            if( framesAvailable == 0 )
+            {
+                /* paTimedOut is expected here, so PA_ENSURE's debug print is skipped */
+                if( (result = WaitForDescriptor( stream->capture->fd, POLLIN, deadline )) != paNoError )
+                    goto error;
+                continue;
+            }
+            framesRequested = PA_MIN( framesRequested, (unsigned long)framesAvailable );
+        }
+
         bytesRequested = framesRequested * PaOssStreamComponent_FrameSize( stream->capture );
         ENSURE_( (bytesRead = read( stream->capture->fd, stream->capture->buffer, bytesRequested )),
                     paUnanticipatedHostError );
@@ -1969,6 +2081,7 @@ static PaError ReadStream( PaStream* s,
         PaUtil_SetInterleavedInputChannels( &stream->bufferProcessor, 0, stream->capture->buffer, stream->capture->hostChannelCount );
         PaUtil_CopyInput( &stream->bufferProcessor, &userBuffer, framesRequested );
         frames -= framesRequested;
+        *framesRead += framesRequested;
     }
 
 error:
@@ -1976,12 +2089,36 @@ error:
 }
 
 
-static PaError WriteStream( PaStream *s, const void *buffer, unsigned long frames )
+static PaError ReadStream( PaStream* s,
+                           void *buffer,
+                           unsigned long frames )
+{
+    unsigned long framesRead = 0;
+    return ReadStreamUntil( (PaOssStream*)s, buffer, frames, 0., &framesRead );
+}
+
+
+static PaError ReadStreamTimeout( PaStream* s,
+                                  void *buffer,
+                                  unsigned long frames,
+                                  PaTime timeout,
+                                  unsigned long *framesRead )
+{
+    return ReadStreamUntil( (PaOssStream*)s, buffer, frames, PaUtil_GetTime() + timeout, framesRead );
+}
+
+
+/** Write frames, giving up with paTimedOut at deadline unless it is 0 */
+static PaError WriteStreamUntil( PaOssStream *stream,
+                                 const void *buffer,
+                                 unsigned long frames,
+                                 PaTime deadline,
+                                 unsigned long *framesWritten )
 {
     PaError result = paNoError;
-    PaOssStream *stream = (PaOssStream*)s;
     int bytesRequested, bytesWritten;
-    unsigned long framesConverted;
+    unsigned long framesConverted, framesRequested;
+    signed long framesAvailable;
     const void *userBuffer;
 
     /* If user output is non-interleaved, PaUtil_CopyOutput will manipulate the channel pointers,
@@ -1997,10 +2134,26 @@ static PaError WriteStream( PaStream *s, const void *buffer, unsigned long frame
 
     while( frames )
     {
+        framesRequested = frames;
+
+        if( deadline > 0. )
+        {
+            /* Only write what won't block */
+            PA_ENSURE( framesAvailable = GetStreamWriteAvailable( (PaStream*)stream ) );
+            if( framesAvailable == 0 )
+            {
+                /* paTimedOut is expected here, so PA_ENSURE's debug print is skipped */
+                if( (result = WaitForDescriptor( stream->playback->fd, POLLOUT, deadline )) != paNoError )
+                    goto error;
+                continue;
+            }
+            framesRequested = PA_MIN( framesRequested, (unsigned long)framesAvailable );
+        }
+
         PaUtil_SetOutputFrameCount( &stream->bufferProcessor, stream->playback->hostFrames );
         PaUtil_SetInterleavedOutputChannels( &stream->bufferProcessor, 0, stream->playback->buffer, stream->playback->hostChannelCount );
 
-        framesConverted = PaUtil_CopyOutput( &stream->bufferProcessor, &userBuffer, frames );
+        framesConverted = PaUtil_CopyOutput( &stream->bufferProcessor, &userBuffer, framesRequested );
         frames -= framesConverted;
 
         bytesRequested = framesConverted * PaOssStreamComponent_FrameSize( stream->playback );
@@ -2012,6 +2165,7 @@ static PaError WriteStream( PaStream *s, const void *buffer, unsigned long frame
             PA_DEBUG(( "Requested %d bytes, wrote %d\n", bytesRequested, bytesWritten ));
             return paUnanticipatedHostError;
         }
+        *framesWritten += framesConverted;
     }
 
 error:
@@ -2019,6 +2173,23 @@ error:
 }
 
 
+static PaError WriteStream( PaStream *s, const void *buffer, unsigned long frames )
+{
+    unsigned long framesWritten = 0;
+    return WriteStreamUntil( (PaOssStream*)s, buffer, frames, 0., &framesWritten );
+}
+
+
+static PaError WriteStreamTimeout( PaStream *s,
+                                   const void *buffer,
+                                   unsigned long frames,
+                                   PaTime timeout,
+                                   unsigned long *framesWritten )
+{
+    return WriteStreamUntil( (PaOssStream*)s, buffer, frames, PaUtil_GetTime() + timeout, framesWritten );
+}
+
+
 static signed long GetStreamReadAvailable( PaStream* s )
 {
     PaError result = paNoError;
@@ -2050,3 +2221,36 @@ error:
     return result;
 #endif
 }
+
+
+/** Without SNDCTL_DSP_LOW_WATER the device wakes up once a fragment is available,
+ * whatever the number of frames. Full-duplex streams are paced by their input.
+ */
+static PaError GetReadyFileDescriptor( PaStream* s, unsigned long frames, int *fileDescriptor )
+{
+    PaError result = paNoError;
+    PaOssStream *stream = (PaOssStream*)s;
+    PaOssStreamComponent *component = stream->capture ? stream->capture : stream->playback;
+    struct pollfd pfd;
+#ifdef SNDCTL_DSP_LOW_WATER
+    int lowWater = PA_MIN( frames, PaOssStreamComponent_BufferSize( component ) / PaOssStreamComponent_FrameSize( component ) )
+            * PaOssStreamComponent_FrameSize( component );
+
+    ENSURE_( ioctl( component->fd, SNDCTL_DSP_LOW_WATER, &lowWater ), paUnanticipatedHostError );
+#else
+    (void) frames;
+#endif
+
+    if( !PaUnixReadyEvent_IsCreated( &stream->readyEvent ) )
+    {
+        pfd.fd = component->fd;
+        pfd.events = component == stream->capture ? POLLIN : POLLOUT;
+        pfd.revents = 0;
+        PA_ENSURE( PaUnixReadyEvent_CreateFromDescriptors( &stream->readyEvent, &pfd, 1 ) );
+    }
+
+    *fileDescriptor = stream->readyEvent.fd;
+
+error:
+    return result;
+}
@@ -526,6 +526,12 @@ void PaPulseAudio_StreamStateCb( pa_stream * s,
 
             break;
     }
+
+    /* Let blocked reads and writes notice the new state */
+    if( stream )
+    {
+        PaPulseAudio_SignalBlockingEvent( stream );
+    }
 }
 
 /* If stream is underflowed then this callback is called
@@ -548,6 +554,10 @@ void PaPulseAudio_StreamUnderflowCb( pa_stream *s,
     }
 
     stream->outputUnderflows++;
+    /* The stream callback isn't told about underflows, so they are only
+     * counted here, by the mainloop thread which also runs the callback.
+     */
+    PaUtil_CountBufferProcessorXruns( &stream->bufferProcessor, paOutputUnderflow );
     pulseaudioOutputSampleSpec = (pa_buffer_attr *)pa_stream_get_buffer_attr(s);
     PA_DEBUG( ("Portaudio %s: PulseAudio '%s' with delay: %ld stream has underflowed\n",
                __FUNCTION__,
@@ -776,7 +786,21 @@ PaError PaPulseAudio_Initialize( PaUtilHostApiRepresentation ** hostApi,
                                       PaPulseAudio_ReadStreamBlock,
                                       PaPulseAudio_WriteStreamBlock,
                                       PaPulseAudio_GetStreamReadAvailableBlock,
-                                      PaUtil_DummyGetWriteAvailable );
+                                      PaPulseAudio_GetStreamWriteAvailableBlock );
+    pulseaudioHostApi->blockingStreamInterface.GetReadyFileDescriptor =
+        PaPulseAudio_GetReadyFileDescriptorBlock;
+    pulseaudioHostApi->blockingStreamInterface.AcquireWriteBuffer =
+        PaPulseAudio_AcquireWriteBufferBlock;
+    pulseaudioHostApi->blockingStreamInterface.CommitWriteBuffer =
+        PaPulseAudio_CommitWriteBufferBlock;
+    pulseaudioHostApi->blockingStreamInterface.AcquireReadBuffer =
+        PaPulseAudio_AcquireReadBufferBlock;
+    pulseaudioHostApi->blockingStreamInterface.ReleaseReadBuffer =
+        PaPulseAudio_ReleaseReadBufferBlock;
+    pulseaudioHostApi->blockingStreamInterface.ReadTimeout =
+        PaPulseAudio_ReadStreamTimeoutBlock;
+    pulseaudioHostApi->blockingStreamInterface.WriteTimeout =
+        PaPulseAudio_WriteStreamTimeoutBlock;
 
     PaPulseAudio_UnLock( pulseaudioHostApi->mainloop );
     lockTaken = 0;
@@ -953,13 +977,23 @@ PaError PaPulseAudio_ConvertPortaudioFormatToPaPulseAudio_( PaSampleFormat porta
 }
 
 
-/* Allocate buffer. */
+/* Allocate buffer. Prefer a mirrored buffer, so that the callback can
+ * process input in place even when it wraps around the end of the buffer.
+ */
 PaError PaPulseAudio_BlockingInitRingBuffer( PaUtilRingBuffer * rbuf,
                                              int size )
 {
-    char *ringbufferBuffer = (char *) malloc( size );
+    char *ringbufferBuffer = NULL;
     PaError ret = paNoError;
 
+    if( PaUtil_InitializeMirroredRingBuffer( rbuf,
+                                             1,
+                                             size ) == 0 )
+    {
+        return paNoError;
+    }
+
+    ringbufferBuffer = (char *) malloc( size );
     if( ringbufferBuffer == NULL )
     {
         PA_PULSEAUDIO_SET_LAST_HOST_ERROR( 0,
@@ -990,6 +1024,20 @@ PaError PaPulseAudio_BlockingInitRingBuffer( PaUtilRingBuffer * rbuf,
     return paNoError;
 }
 
+/* Free buffer. */
+void PaPulseAudio_BlockingTermRingBuffer( PaUtilRingBuffer * rbuf )
+{
+    if( PaUtil_IsRingBufferMirrored( rbuf ) )
+    {
+        PaUtil_TerminateMirroredRingBuffer( rbuf );
+    }
+    else
+    {
+        free( rbuf->buffer );
+    }
+    rbuf->buffer = NULL;
+}
+
 /* see pa_hostapi.h for a list of validity guarantees made about OpenStream parameters */
 
 PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
@@ -1038,6 +1086,12 @@ PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
         goto openstream_error;
     }
 
+    result = PaPulseAudio_InitializeBlockingEvents( stream );
+    if( result != paNoError )
+    {
+        goto openstream_error;
+    }
+
     /* Allocate memory for source and sink names. */
     const char defaultSourceStreamName[] = "Portaudio source";
     const char defaultSinkStreamName[] = "Portaudio sink";
@@ -1338,6 +1392,9 @@ PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
         goto openstream_error;
     }
 
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
+
     /* inputLatency is specified in _seconds_ */
     stream->streamRepresentation.streamInfo.inputLatency =
         (PaTime) PaUtil_GetBufferProcessorInputLatencyFrames(
@@ -1363,6 +1420,8 @@ PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
 
     if( stream )
     {
+        PaPulseAudio_BlockingTermRingBuffer( &stream->inputRing );
+        PaPulseAudio_TerminateBlockingEvents( stream );
         PaUtil_FreeMemory( stream->inputStreamName );
         PaUtil_FreeMemory( stream->outputStreamName );
         PaUtil_FreeMemory( stream );
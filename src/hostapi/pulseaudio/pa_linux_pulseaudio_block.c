@@ -50,7 +50,8 @@
 */
 
 #include "pa_linux_pulseaudio_block_internal.h"
-#include <unistd.h>
+
+#include <errno.h>
 
 /*
     As separate stream interfaces are used for blocking and callback
@@ -58,140 +59,585 @@
     for blocking streams.
 */
 
-PaError PaPulseAudio_ReadStreamBlock( PaStream * s,
-                                      void *buffer,
-                                      unsigned long frames )
+/* Called with the mainloop locked. Streams with input are paced by
+ * their input, like in Pa_GetStreamReadyFileDescriptor().
+ */
+static signed long GetReadyFrames( PaStream * s )
+{
+    PaPulseAudio_Stream *pulseaudioStream = (PaPulseAudio_Stream *) s;
+    size_t pulseaudioWritable = 0;
+
+    if( pulseaudioStream->isStopped )
+    {
+        return paStreamIsStopped;
+    }
+
+    if( pulseaudioStream->inputStream )
+    {
+        return ( PaUtil_GetRingBufferReadAvailable( &pulseaudioStream->inputRing ) /
+                 pulseaudioStream->inputFrameSize );
+    }
+
+    if( !PA_STREAM_IS_GOOD( pa_stream_get_state( pulseaudioStream->outputStream ) ) )
+    {
+        return paUnanticipatedHostError;
+    }
+
+    /* Not connected yet */
+    pulseaudioWritable = pa_stream_writable_size( pulseaudioStream->outputStream );
+    if( pulseaudioWritable == (size_t) -1 )
+    {
+        return 0;
+    }
+    return pulseaudioWritable / pulseaudioStream->outputFrameSize;
+}
+
+
+PaError PaPulseAudio_InitializeBlockingEvents( PaPulseAudio_Stream * stream )
+{
+    pthread_condattr_t conditionAttributes;
+
+    PaUnixReadyEvent_Initialize( &stream->readyEvent );
+
+    if( pthread_mutex_init( &stream->blockingMutex, NULL ) != 0 )
+    {
+        return paUnanticipatedHostError;
+    }
+
+    /* Timed waits use a monotonic clock where there is one */
+    if( pthread_condattr_init( &conditionAttributes ) != 0 )
+    {
+        pthread_mutex_destroy( &stream->blockingMutex );
+        return paUnanticipatedHostError;
+    }
+    stream->blockingClockId = PaPthreadUtil_NegotiateCondAttrClock( &conditionAttributes );
+
+    if( pthread_cond_init( &stream->blockingCondition, &conditionAttributes ) != 0 )
+    {
+        pthread_condattr_destroy( &conditionAttributes );
+        pthread_mutex_destroy( &stream->blockingMutex );
+        return paUnanticipatedHostError;
+    }
+    pthread_condattr_destroy( &conditionAttributes );
+
+    stream->blockingEventCount = 0;
+    stream->blockingEventsInitialized = 1;
+    return paNoError;
+}
+
+
+void PaPulseAudio_TerminateBlockingEvents( PaPulseAudio_Stream * stream )
+{
+    if( stream->blockingEventsInitialized )
+    {
+        pthread_cond_destroy( &stream->blockingCondition );
+        pthread_mutex_destroy( &stream->blockingMutex );
+        PaUnixReadyEvent_Terminate( &stream->readyEvent );
+        stream->blockingEventsInitialized = 0;
+    }
+}
+
+
+/* Called from the mainloop thread, and when the stream is stopped,
+ * to wake up a thread waiting in PaPulseAudio_ReadStreamBlock()
+ * or PaPulseAudio_WriteStreamBlock(). The mainloop is locked in
+ * both cases, which the ready descriptor relies on.
+ */
+void PaPulseAudio_SignalBlockingEvent( PaPulseAudio_Stream * stream )
+{
+    if( !stream->blockingEventsInitialized )
+    {
+        return;
+    }
+
+    pthread_mutex_lock( &stream->blockingMutex );
+    stream->blockingEventCount++;
+    pthread_cond_broadcast( &stream->blockingCondition );
+    pthread_mutex_unlock( &stream->blockingMutex );
+
+    PaUnixReadyEvent_Update( &stream->readyEvent, (PaStream *) stream, GetReadyFrames );
+}
+
+
+/* Take the event count before looking at the ring buffer or the
+ * stream, so that an event which happens after we have looked is
+ * not missed by WaitForBlockingEvent().
+ */
+static unsigned long GetBlockingEventCount( PaPulseAudio_Stream * stream )
+{
+    unsigned long eventCount;
+
+    pthread_mutex_lock( &stream->blockingMutex );
+    eventCount = stream->blockingEventCount;
+    pthread_mutex_unlock( &stream->blockingMutex );
+
+    return eventCount;
+}
+
+
+/* Returns paTimedOut if deadline, on the blockingClockId clock,
+ * passes first. A NULL deadline waits indefinitely.
+ */
+static PaError WaitForBlockingEvent( PaPulseAudio_Stream * stream,
+                                     unsigned long eventCount,
+                                     const struct timespec *deadline )
+{
+    PaError result = paNoError;
+
+    pthread_mutex_lock( &stream->blockingMutex );
+    while( stream->blockingEventCount == eventCount )
+    {
+        if( deadline == NULL )
+        {
+            pthread_cond_wait( &stream->blockingCondition, &stream->blockingMutex );
+        }
+        else if( pthread_cond_timedwait( &stream->blockingCondition, &stream->blockingMutex,
+                                         deadline ) == ETIMEDOUT )
+        {
+            result = paTimedOut;
+            break;
+        }
+    }
+    pthread_mutex_unlock( &stream->blockingMutex );
+
+    return result;
+}
+
+
+/* Turn a timeout in seconds into a deadline for WaitForBlockingEvent() */
+static PaError GetBlockingDeadline( PaPulseAudio_Stream * stream,
+                                    PaTime timeout,
+                                    struct timespec *deadline )
+{
+    if( PaPthreadUtil_GetTime( stream->blockingClockId, deadline ) != 0 )
+    {
+        return paInternalError;
+    }
+
+    deadline->tv_sec += (time_t) timeout;
+    deadline->tv_nsec += (long) ((timeout - (time_t) timeout) * 1e9);
+    if( deadline->tv_nsec >= 1000000000 )
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000;
+    }
+    return paNoError;
+}
+
+
+static PaError ReadStreamUntil( PaStream * s,
+                               void *buffer,
+                               unsigned long frames,
+                               const struct timespec *deadline,
+                               unsigned long *framesRead )
 {
     PaPulseAudio_Stream *pulseaudioStream = (PaPulseAudio_Stream *) s;
-    PaPulseAudio_HostApiRepresentation *pulseaudioHostApi =
-        pulseaudioStream->hostapi;
-    PaError ret = 0;
     uint8_t *readableBuffer = (uint8_t *) buffer;
     long bufferLeftToRead = (frames * pulseaudioStream->inputFrameSize);
+    unsigned long eventCount = 0;
 
     while( bufferLeftToRead > 0 )
     {
+        eventCount = GetBlockingEventCount( pulseaudioStream );
+
         PA_PULSEAUDIO_IS_ERROR( pulseaudioStream, paStreamIsStopped )
 
         PaPulseAudio_Lock( pulseaudioStream->mainloop );
         long l_read = PaUtil_ReadRingBuffer( &pulseaudioStream->inputRing, readableBuffer,
                                              bufferLeftToRead );
+        PaUnixReadyEvent_Update( &pulseaudioStream->readyEvent, s, GetReadyFrames );
+        PaPulseAudio_UnLock( pulseaudioStream->mainloop );
+
         readableBuffer += l_read;
         bufferLeftToRead -= l_read;
-        if( bufferLeftToRead > 0 )
-            pa_threaded_mainloop_wait( pulseaudioStream->mainloop );
-
-        PaPulseAudio_UnLock( pulseaudioStream->mainloop );
+        *framesRead += l_read / pulseaudioStream->inputFrameSize;
 
         if( bufferLeftToRead > 0 )
         {
-            /* Sleep small amount of time not burn CPU
-            * we block anyway so this is bearable
-            */
-            usleep(100);
+            /* Sleep until the record callback has put
+             * more data in the ring buffer
+             */
+            if( WaitForBlockingEvent( pulseaudioStream, eventCount, deadline ) == paTimedOut )
+            {
+                return paTimedOut;
+            }
         }
     }
     return paNoError;
 }
 
 
-PaError PaPulseAudio_WriteStreamBlock( PaStream * s,
-                                       const void *buffer,
-                                       unsigned long frames )
+PaError PaPulseAudio_ReadStreamBlock( PaStream * s,
+                                      void *buffer,
+                                      unsigned long frames )
+{
+    unsigned long framesRead = 0;
+
+    return ReadStreamUntil( s, buffer, frames, NULL, &framesRead );
+}
+
+
+PaError PaPulseAudio_ReadStreamTimeoutBlock( PaStream * s,
+                                             void *buffer,
+                                             unsigned long frames,
+                                             PaTime timeout,
+                                             unsigned long *framesRead )
+{
+    struct timespec deadline;
+    PaError result = GetBlockingDeadline( (PaPulseAudio_Stream *) s, timeout, &deadline );
+
+    if( result != paNoError )
+    {
+        return result;
+    }
+    return ReadStreamUntil( s, buffer, frames, &deadline, framesRead );
+}
+
+
+static PaError WriteStreamUntil( PaStream * s,
+                                 const void *buffer,
+                                 unsigned long frames,
+                                 const struct timespec *deadline,
+                                 unsigned long *framesWritten )
 {
     PaPulseAudio_Stream *pulseaudioStream = (PaPulseAudio_Stream *) s;
-    int ret = 0;
     size_t pulseaudioWritable = 0;
     uint8_t *writableBuffer = (uint8_t *) buffer;
     long bufferLeftToWrite = (frames * pulseaudioStream->outputFrameSize);
     pa_operation *pulseaudioOperation = NULL;
+    unsigned long eventCount = 0;
+    PaError result = paNoError;
 
     PaUtil_BeginCpuLoadMeasurement( &pulseaudioStream->cpuLoadMeasurer );
 
     while( bufferLeftToWrite > 0)
     {
+        eventCount = GetBlockingEventCount( pulseaudioStream );
+
         PA_PULSEAUDIO_IS_ERROR( pulseaudioStream, paStreamIsStopped )
 
         PaPulseAudio_Lock( pulseaudioStream->mainloop );
         pulseaudioWritable = pa_stream_writable_size( pulseaudioStream->outputStream );
-        PaPulseAudio_UnLock( pulseaudioStream->mainloop );
 
-        if( pulseaudioWritable > 0 )
+        if( pulseaudioWritable > 0 && pulseaudioWritable != (size_t) -1 )
         {
             if( bufferLeftToWrite < pulseaudioWritable )
             {
                 pulseaudioWritable = bufferLeftToWrite;
             }
-            PaPulseAudio_Lock( pulseaudioStream->mainloop );
-            ret = pa_stream_write( pulseaudioStream->outputStream,
-                                     writableBuffer,
-                                     pulseaudioWritable,
-                                     NULL,
-                                     0,
-                                     PA_SEEK_RELATIVE );
-
+            pa_stream_write( pulseaudioStream->outputStream,
+                             writableBuffer,
+                             pulseaudioWritable,
+                             NULL,
+                             0,
+                             PA_SEEK_RELATIVE );
+
+            /* Timing is updated automatically and interpolated,
+             * this just makes sure that it includes the write.
+             * There is no need to wait for the server to answer.
+             */
             pulseaudioOperation = pa_stream_update_timing_info( pulseaudioStream->outputStream,
                                                                 NULL,
                                                                 NULL );
+            if( pulseaudioOperation != NULL )
+            {
+                pa_operation_unref( pulseaudioOperation );
+            }
+            PaUnixReadyEvent_Update( &pulseaudioStream->readyEvent, s, GetReadyFrames );
             PaPulseAudio_UnLock( pulseaudioStream->mainloop );
 
-            ret = 0;
-
             if( pulseaudioOperation == NULL )
             {
                 return paInsufficientMemory;
             }
 
-            while( pa_operation_get_state( pulseaudioOperation ) == PA_OPERATION_RUNNING )
+            writableBuffer += pulseaudioWritable;
+            bufferLeftToWrite -= pulseaudioWritable;
+            *framesWritten += pulseaudioWritable / pulseaudioStream->outputFrameSize;
+        }
+        else
+        {
+            PaPulseAudio_UnLock( pulseaudioStream->mainloop );
+
+            /* Sleep until the playback callback tells
+             * that PulseAudio wants more data
+             */
+            if( WaitForBlockingEvent( pulseaudioStream, eventCount, deadline ) == paTimedOut )
             {
-                ret ++;
-                PA_PULSEAUDIO_IS_ERROR( pulseaudioStream, paStreamIsStopped )
+                result = paTimedOut;
+                break;
+            }
+        }
+    }
+    PaUtil_EndCpuLoadMeasurement( &pulseaudioStream->cpuLoadMeasurer,
+                                  *framesWritten );
 
-                /* As this shouldn never happen it's error if it does */
-                if( ret >= 10000 )
-                {
-                    return paStreamIsStopped;
-                }
+    return result;
+}
 
-                usleep(100);
-            }
 
-            PaPulseAudio_Lock( pulseaudioStream->mainloop );
+PaError PaPulseAudio_WriteStreamBlock( PaStream * s,
+                                       const void *buffer,
+                                       unsigned long frames )
+{
+    unsigned long framesWritten = 0;
 
-            pa_operation_unref( pulseaudioOperation );
-            pulseaudioOperation = NULL;
+    return WriteStreamUntil( s, buffer, frames, NULL, &framesWritten );
+}
 
-            PaPulseAudio_UnLock( pulseaudioStream->mainloop );
 
-            writableBuffer += pulseaudioWritable;
-            bufferLeftToWrite -= pulseaudioWritable;
+PaError PaPulseAudio_WriteStreamTimeoutBlock( PaStream * s,
+                                              const void *buffer,
+                                              unsigned long frames,
+                                              PaTime timeout,
+                                              unsigned long *framesWritten )
+{
+    struct timespec deadline;
+    PaError result = GetBlockingDeadline( (PaPulseAudio_Stream *) s, timeout, &deadline );
+
+    if( result != paNoError )
+    {
+        return result;
+    }
+    return WriteStreamUntil( s, buffer, frames, &deadline, framesWritten );
+}
+
+
+signed long PaPulseAudio_GetStreamReadAvailableBlock( PaStream * s )
+{
+    PaPulseAudio_Stream *pulseaudioStream = (PaPulseAudio_Stream *) s;
+
+    if( pulseaudioStream->inputStream == NULL )
+    {
+        return 0;
+    }
+
+    return ( PaUtil_GetRingBufferReadAvailable( &pulseaudioStream->inputRing ) /
+             pulseaudioStream->inputFrameSize );
+}
+
+
+signed long PaPulseAudio_GetStreamWriteAvailableBlock( PaStream * s )
+{
+    PaPulseAudio_Stream *pulseaudioStream = (PaPulseAudio_Stream *) s;
+    size_t pulseaudioWritable = 0;
+
+    if( pulseaudioStream->outputStream == NULL )
+    {
+        return 0;
+    }
+
+    PaPulseAudio_Lock( pulseaudioStream->mainloop );
+    pulseaudioWritable = pa_stream_writable_size( pulseaudioStream->outputStream );
+    PaPulseAudio_UnLock( pulseaudioStream->mainloop );
+
+    /* The stream isn't connected until it has been started */
+    if( pulseaudioWritable == (size_t) -1 )
+    {
+        return 0;
+    }
+    return pulseaudioWritable / pulseaudioStream->outputFrameSize;
+}
+
+
+PaError PaPulseAudio_GetReadyFileDescriptorBlock( PaStream * s,
+                                                  unsigned long frames,
+                                                  int *fileDescriptor )
+{
+    PaPulseAudio_Stream *pulseaudioStream = (PaPulseAudio_Stream *) s;
+    const pa_buffer_attr *pulseaudioBufferAttr = NULL;
+    unsigned long bufferFrames = 0;
+    PaError result = paNoError;
+
+    PaPulseAudio_Lock( pulseaudioStream->mainloop );
+
+    /* Never wait for more than the buffer can hold */
+    if( pulseaudioStream->inputStream )
+    {
+        bufferFrames = pulseaudioStream->inputRing.bufferSize / pulseaudioStream->inputFrameSize;
+    }
+    else
+    {
+        pulseaudioBufferAttr = pa_stream_get_buffer_attr( pulseaudioStream->outputStream );
+        if( pulseaudioBufferAttr != NULL )
+        {
+            bufferFrames = pulseaudioBufferAttr->tlength / pulseaudioStream->outputFrameSize;
         }
+    }
+    if( bufferFrames > 0 && frames > bufferFrames )
+    {
+        frames = bufferFrames;
+    }
+    pulseaudioStream->readyEvent.frames = frames;
+
+    if( !PaUnixReadyEvent_IsCreated( &pulseaudioStream->readyEvent ) )
+    {
+        result = PaUnixReadyEvent_CreateSignalled( &pulseaudioStream->readyEvent );
+    }
+    if( result == paNoError )
+    {
+        PaUnixReadyEvent_Update( &pulseaudioStream->readyEvent, s, GetReadyFrames );
+        *fileDescriptor = pulseaudioStream->readyEvent.fd;
+    }
+
+    PaPulseAudio_UnLock( pulseaudioStream->mainloop );
+    return result;
+}
+
+
+/* Blocking streams are opened with the user's sample format, so output
+ * can be rendered straight into memory of the server
+ */
+PaError PaPulseAudio_AcquireWriteBufferBlock( PaStream * s,
+                                              void **buffer,
+                                              unsigned long *frames )
+{
+    PaPulseAudio_Stream *pulseaudioStream = (PaPulseAudio_Stream *) s;
+    size_t pulseaudioWritable = 0;
+    size_t bytes = 0;
+    PaError result = paNoError;
+
+    PA_PULSEAUDIO_IS_ERROR( pulseaudioStream, paStreamIsStopped )
+
+    if( pulseaudioStream->outputStream == NULL )
+    {
+        return paCanNotWriteToAnInputOnlyStream;
+    }
+
+    PaPulseAudio_Lock( pulseaudioStream->mainloop );
+
+    pulseaudioWritable = pa_stream_writable_size( pulseaudioStream->outputStream );
+    bytes = *frames * pulseaudioStream->outputFrameSize;
+    if( pulseaudioWritable == (size_t) -1 )
+    {
+        bytes = 0;
+    }
+    else if( bytes > pulseaudioWritable )
+    {
+        bytes = pulseaudioWritable;
+    }
+    *frames = bytes / pulseaudioStream->outputFrameSize;
 
-        if( bufferLeftToWrite > 0 )
+    if( *frames > 0 )
+    {
+        bytes = *frames * pulseaudioStream->outputFrameSize;
+        pulseaudioStream->acquiredWriteBuffer = NULL;
+        if( pa_stream_begin_write( pulseaudioStream->outputStream,
+                                   &pulseaudioStream->acquiredWriteBuffer,
+                                   &bytes ) != 0 )
         {
-            /* Sleep small amount of time not burn CPU
-            * we block anyway so this is bearable
-            */
-            usleep(100);
+            result = paUnanticipatedHostError;
+            *frames = 0;
+        }
+        else
+        {
+            /* The server may offer less than was asked for */
+            *frames = bytes / pulseaudioStream->outputFrameSize;
+            if( *frames == 0 )
+            {
+                pa_stream_cancel_write( pulseaudioStream->outputStream );
+            }
+            *buffer = pulseaudioStream->acquiredWriteBuffer;
         }
+    }
+
+    PaPulseAudio_UnLock( pulseaudioStream->mainloop );
+    return result;
+}
+
+
+PaError PaPulseAudio_CommitWriteBufferBlock( PaStream * s,
+                                             unsigned long frames )
+{
+    PaPulseAudio_Stream *pulseaudioStream = (PaPulseAudio_Stream *) s;
+    pa_operation *pulseaudioOperation = NULL;
+    PaError result = paNoError;
 
+    PaPulseAudio_Lock( pulseaudioStream->mainloop );
+
+    if( frames == 0 )
+    {
+        pa_stream_cancel_write( pulseaudioStream->outputStream );
     }
-    PaUtil_EndCpuLoadMeasurement( &pulseaudioStream->cpuLoadMeasurer,
-                                  frames );
+    else if( pa_stream_write( pulseaudioStream->outputStream,
+                              pulseaudioStream->acquiredWriteBuffer,
+                              frames * pulseaudioStream->outputFrameSize,
+                              NULL,
+                              0,
+                              PA_SEEK_RELATIVE ) != 0 )
+    {
+        result = paUnanticipatedHostError;
+    }
+    else
+    {
+        /* See PaPulseAudio_WriteStreamBlock() */
+        pulseaudioOperation = pa_stream_update_timing_info( pulseaudioStream->outputStream,
+                                                            NULL,
+                                                            NULL );
+        if( pulseaudioOperation != NULL )
+        {
+            pa_operation_unref( pulseaudioOperation );
+        }
+    }
+    pulseaudioStream->acquiredWriteBuffer = NULL;
 
-    return paNoError;
+    PaUnixReadyEvent_Update( &pulseaudioStream->readyEvent, s, GetReadyFrames );
+    PaPulseAudio_UnLock( pulseaudioStream->mainloop );
+    return result;
 }
 
 
-signed long PaPulseAudio_GetStreamReadAvailableBlock( PaStream * s )
+PaError PaPulseAudio_AcquireReadBufferBlock( PaStream * s,
+                                             const void **buffer,
+                                             unsigned long *frames )
 {
     PaPulseAudio_Stream *pulseaudioStream = (PaPulseAudio_Stream *) s;
+    unsigned long ringFrames = 0;
+    ring_buffer_size_t size1, size2;
+    void *data1, *data2;
+
+    PA_PULSEAUDIO_IS_ERROR( pulseaudioStream, paStreamIsStopped )
 
     if( pulseaudioStream->inputStream == NULL )
     {
-        return 0;
+        return paCanNotReadFromAnOutputOnlyStream;
     }
 
-    return ( PaUtil_GetRingBufferReadAvailable( &pulseaudioStream->inputRing ) /
-             pulseaudioStream->inputFrameSize );
+    ringFrames = pulseaudioStream->inputRing.bufferSize / pulseaudioStream->inputFrameSize;
+    if( *frames > ringFrames )
+    {
+        *frames = ringFrames;
+    }
+
+    PaPulseAudio_Lock( pulseaudioStream->mainloop );
+    PaUtil_GetRingBufferReadRegions( &pulseaudioStream->inputRing,
+                                     *frames * pulseaudioStream->inputFrameSize,
+                                     &data1, &size1, &data2, &size2 );
+    PaPulseAudio_UnLock( pulseaudioStream->mainloop );
+
+    /* A frame which is split by the end of the ring buffer can't be
+     * handed out, let pa_front read it into its bounce buffer
+     */
+    if( size1 < pulseaudioStream->inputFrameSize && size2 > 0 )
+    {
+        return paIncompatibleStreamHostApi;
+    }
+
+    *buffer = data1;
+    *frames = size1 / pulseaudioStream->inputFrameSize;
+    return paNoError;
+}
+
+
+PaError PaPulseAudio_ReleaseReadBufferBlock( PaStream * s,
+                                             unsigned long frames )
+{
+    PaPulseAudio_Stream *pulseaudioStream = (PaPulseAudio_Stream *) s;
+
+    PaPulseAudio_Lock( pulseaudioStream->mainloop );
+    PaUtil_AdvanceRingBufferReadIndex( &pulseaudioStream->inputRing,
+                                       frames * pulseaudioStream->inputFrameSize );
+    PaUnixReadyEvent_Update( &pulseaudioStream->readyEvent, s, GetReadyFrames );
+    PaPulseAudio_UnLock( pulseaudioStream->mainloop );
+    return paNoError;
 }
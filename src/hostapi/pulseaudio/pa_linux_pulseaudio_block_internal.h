@@ -81,8 +81,40 @@ PaError PaPulseAudio_WriteStreamBlock( PaStream * stream,
                                        const void *buffer,
                                        unsigned long frames );
 
+PaError PaPulseAudio_ReadStreamTimeoutBlock( PaStream * stream,
+                                             void *buffer,
+                                             unsigned long frames,
+                                             PaTime timeout,
+                                             unsigned long *framesRead );
+
+PaError PaPulseAudio_WriteStreamTimeoutBlock( PaStream * stream,
+                                              const void *buffer,
+                                              unsigned long frames,
+                                              PaTime timeout,
+                                              unsigned long *framesWritten );
+
 signed long PaPulseAudio_GetStreamReadAvailableBlock( PaStream * stream );
 
+signed long PaPulseAudio_GetStreamWriteAvailableBlock( PaStream * stream );
+
+PaError PaPulseAudio_GetReadyFileDescriptorBlock( PaStream * stream,
+                                                  unsigned long frames,
+                                                  int *fileDescriptor );
+
+PaError PaPulseAudio_AcquireWriteBufferBlock( PaStream * stream,
+                                              void **buffer,
+                                              unsigned long *frames );
+
+PaError PaPulseAudio_CommitWriteBufferBlock( PaStream * stream,
+                                             unsigned long frames );
+
+PaError PaPulseAudio_AcquireReadBufferBlock( PaStream * stream,
+                                             const void **buffer,
+                                             unsigned long *frames );
+
+PaError PaPulseAudio_ReleaseReadBufferBlock( PaStream * stream,
+                                             unsigned long frames );
+
 #ifdef __cplusplus
 }
 #endif                          /* __cplusplus */
@@ -189,6 +189,7 @@ static int _PaPulseAudio_ProcessAudio(PaPulseAudio_Stream *stream,
     int ret = paContinue;
     void *bufferData = NULL;
     size_t pulseaudioOutputWritten = 0;
+    ring_buffer_size_t inputBytesInRing = 0;
 
     /* If there is no specified per host buffer then
      * just generate one or but correct one in place
@@ -325,13 +326,34 @@ static int _PaPulseAudio_ProcessAudio(PaPulseAudio_Stream *stream,
         /* Read of ther is something to read */
         if( isInputCb )
         {
-            PaUtil_ReadRingBuffer( &stream->inputRing,
-                                   pulseaudioSampleBuffer,
-                                   pulseaudioInputBytes);
+            void *inputData = pulseaudioSampleBuffer;
+
+            /* A mirrored ring buffer is always contiguous so the
+             * buffer processor can read the input in place. The
+             * read index is advanced once it's done with it.
+             */
+            if( PaUtil_IsRingBufferMirrored( &stream->inputRing ) )
+            {
+                void *unusedData = NULL;
+                ring_buffer_size_t unusedSize = 0;
+
+                PaUtil_GetRingBufferReadRegions( &stream->inputRing,
+                                                 pulseaudioInputBytes,
+                                                 &inputData,
+                                                 &inputBytesInRing,
+                                                 &unusedData,
+                                                 &unusedSize );
+            }
+            else
+            {
+                PaUtil_ReadRingBuffer( &stream->inputRing,
+                                       pulseaudioSampleBuffer,
+                                       pulseaudioInputBytes);
+            }
 
             PaUtil_SetInterleavedInputChannels( &stream->bufferProcessor,
                                                 0,
-                                                pulseaudioSampleBuffer,
+                                                inputData,
                                                 stream->inputSampleSpec.channels );
 
             PaUtil_SetInputFrameCount( &stream->bufferProcessor,
@@ -380,6 +402,13 @@ static int _PaPulseAudio_ProcessAudio(PaPulseAudio_Stream *stream,
             PaUtil_EndBufferProcessing( &stream->bufferProcessor,
                                         &ret );
 
+        if( inputBytesInRing )
+        {
+            PaUtil_AdvanceRingBufferReadIndex( &stream->inputRing,
+                                               inputBytesInRing );
+            inputBytesInRing = 0;
+        }
+
         PaUtil_EndCpuLoadMeasurement( &stream->cpuLoadMeasurer,
                                       hostFrameCount );
     }
@@ -404,6 +433,10 @@ void PaPulseAudio_StreamRecordCb( pa_stream * s,
     {
         _PaPulseAudio_ProcessAudio( pulseaudioStream, length );
     }
+    else
+    {
+        PaPulseAudio_SignalBlockingEvent( pulseaudioStream );
+    }
 
     pa_threaded_mainloop_signal( pulseaudioStream->mainloop,
                                  0 );
@@ -419,6 +452,10 @@ void PaPulseAudio_StreamPlaybackCb( pa_stream * s,
     {
         _PaPulseAudio_ProcessAudio( pulseaudioStream, length );
     }
+    else
+    {
+        PaPulseAudio_SignalBlockingEvent( pulseaudioStream );
+    }
 
     pa_threaded_mainloop_signal( pulseaudioStream->mainloop,
                                  0 );
@@ -581,6 +618,9 @@ PaError PaPulseAudio_CloseStreamCb( PaStream * s )
     PaUtil_TerminateBufferProcessor( &stream->bufferProcessor );
     PaUtil_TerminateStreamRepresentation( &stream->streamRepresentation );
 
+    PaPulseAudio_BlockingTermRingBuffer( &stream->inputRing );
+    PaPulseAudio_TerminateBlockingEvents( stream );
+
     PaUtil_FreeMemory( stream->inputStreamName );
     PaUtil_FreeMemory( stream->outputStreamName );
     PaUtil_FreeMemory( stream );
@@ -809,9 +849,11 @@ PaError PaPulseAudio_StartStreamCb( PaStream * s )
 
                 /* This is only needed when making non duplex
                  * as when duplexing then input should feed
-                 * output and we don't need playback callback
+                 * output and we don't need playback callback.
+                 * Blocking streams always need it to know when
+                 * they can write again.
                  */
-                if( !stream->inputStream )
+                if( !stream->inputStream || !stream->bufferProcessor.streamCallback )
                 {
                     pa_stream_set_write_callback( stream->outputStream,
                                                   PaPulseAudio_StreamPlaybackCb,
@@ -908,6 +950,9 @@ static PaError RequestStop( PaPulseAudio_Stream * stream,
 
     stream->missedBytes = 0;
 
+    /* Wake up blocked reads and writes so they can return */
+    PaPulseAudio_SignalBlockingEvent( stream );
+
     /* Test if there is something that we can play */
     if( stream->outputStream
         && pa_stream_get_state( stream->outputStream ) == PA_STREAM_READY
@@ -51,6 +51,8 @@
 #include "pa_process.h"
 
 #include "pa_unix_util.h"
+#include "pa_unix_ready_event.h"
+#include "pa_pthread_util.h"
 #include "pa_ringbuffer.h"
 #include "pa_debugprint.h"
 
@@ -171,6 +173,27 @@ typedef struct PaPulseAudio_Stream
     volatile sig_atomic_t pulseaudioIsActive;
     volatile sig_atomic_t pulseaudioIsStopped;
 
+    /* Wakes up a thread which is blocked in Pa_ReadStream() or
+     * Pa_WriteStream() on this stream. The mainloop is shared by
+     * all streams, so waiting on it would wake up every blocked
+     * stream for every event. blockingEventCount is incremented
+     * whenever data arrives, space becomes available or the state
+     * of the stream changes.
+     */
+    pthread_mutex_t blockingMutex;
+    pthread_cond_t blockingCondition;
+    PaUtilClockId blockingClockId;
+    unsigned long blockingEventCount;
+    int blockingEventsInitialized;
+
+    /* Returned by Pa_GetStreamReadyFileDescriptor(). Updated together
+     * with the blocking event, with the mainloop locked.
+     */
+    PaUnixReadyEvent readyEvent;
+
+    /* Server memory handed out by Pa_AcquireWriteBuffer() */
+    void *acquiredWriteBuffer;
+
 }
 PaPulseAudio_Stream;
 
@@ -237,6 +260,14 @@ void PaPulseAudio_Free( PaPulseAudio_HostApiRepresentation * ptr );
 
 int PaPulseAudio_CheckConnection( PaPulseAudio_HostApiRepresentation * ptr );
 
+PaError PaPulseAudio_BlockingInitRingBuffer( PaUtilRingBuffer * rbuf,
+                                             int size );
+void PaPulseAudio_BlockingTermRingBuffer( PaUtilRingBuffer * rbuf );
+
+PaError PaPulseAudio_InitializeBlockingEvents( PaPulseAudio_Stream * stream );
+void PaPulseAudio_TerminateBlockingEvents( PaPulseAudio_Stream * stream );
+void PaPulseAudio_SignalBlockingEvent( PaPulseAudio_Stream * stream );
+
 void PaPulseAudio_CheckContextStateCb( pa_context * c,
                                        void *userdata );
 void PaPulseAudio_ServerInfoCb( pa_context *c,
@@ -382,6 +382,9 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi, PaStream
         sio_close( hdl );
         return err;
     }
+    sndioStream->base.bufferProcessor = &sndioStream->bufferProcessor;
+    /* rbuf is refilled by each sio_read() */
+    PaUtil_SetHostInputBufferIsWritable( &sndioStream->bufferProcessor, 1 );
     if( mode & SIO_REC )
     {
         sndioStream->rbuf = malloc( par.round * par.rchan * par.bps );
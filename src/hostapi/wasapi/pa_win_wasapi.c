@@ -4113,6 +4113,8 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
             LogPaError(result);
             goto error;
         }
+        stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+        stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
     }
 
     // Set Input latency
@@ -4801,6 +4801,8 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
             max(stream->capture.framesPerBuffer, stream->render.framesPerBuffer));
         goto error;
     }
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
     /* Allocate/get all the buffers for host I/O */
     if (stream->userInputChannels > 0)
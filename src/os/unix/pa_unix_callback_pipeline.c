@@ -0,0 +1,523 @@
+/*
+ * $Id$
+ * Portable Audio I/O Library
+ * UNIX stream callback pipeline
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2000 Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup unix_src
+
+ @brief Runs the stream callback on a worker thread ahead of the host API.
+ @see pa_unix_callback_pipeline.h
+*/
+
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+
+#include "pa_unix_callback_pipeline.h"
+#include "pa_unix_util.h"
+#include "pa_converters.h"
+#include "pa_memorybarrier.h"
+#include "pa_debugprint.h"
+
+
+/* Each queued request starts with this header, followed by the input
+    buffer, if any. */
+typedef struct PipelineRequest
+{
+    PaStreamCallbackTimeInfo timeInfo;
+    PaStreamCallbackFlags statusFlags;
+}
+PipelineRequest;
+
+/* keep the samples following the header aligned */
+#define PIPELINE_REQUEST_HEADER_BYTES_  ((sizeof(PipelineRequest) + 15) & ~((size_t)15))
+
+
+static long NextPowerOfTwo( long n )
+{
+    long result = 1;
+
+    while( result < n )
+        result <<= 1;
+
+    return result;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Points channelPointers at the channels of a non-interleaved buffer, which
+    are stored one after the other. */
+static void SetChannelPointers( void **channelPointers, unsigned char *buffer,
+        unsigned int channelCount, unsigned long bytesPerChannel )
+{
+    unsigned int i;
+
+    for( i=0; i < channelCount; ++i )
+        channelPointers[i] = buffer + i * bytesPerChannel;
+}
+
+/* ------------------------------------------------------------------------- */
+
+PaError PaUnixCallbackPipeline_Initialize( PaUnixCallbackPipeline *pipeline,
+        unsigned int inputChannelCount, PaSampleFormat inputSampleFormat,
+        unsigned int outputChannelCount, PaSampleFormat outputSampleFormat,
+        double sampleRate, unsigned long framesPerBuffer, unsigned int lookaheadBuffers,
+        PaStreamCallback *streamCallback, void *userData )
+{
+    PaError result = paNoError;
+    long bufferCount = NextPowerOfTwo( 2 * ((long)lookaheadBuffers + 1) );
+    long bytesPerRequest, bytesPerOutputBuffer;
+    int bytesPerSample;
+
+    memset( pipeline, 0, sizeof (PaUnixCallbackPipeline) );
+
+    PA_UNLESS( framesPerBuffer > 0 && lookaheadBuffers > 0, paInternalError );
+
+    pipeline->streamCallback = streamCallback;
+    pipeline->userData = userData;
+    pipeline->framesPerBuffer = framesPerBuffer;
+    pipeline->lookaheadBuffers = lookaheadBuffers;
+    pipeline->samplePeriod = 1. / sampleRate;
+    pipeline->callbackResult = paContinue;
+
+    pipeline->inputChannelCount = inputChannelCount;
+    pipeline->inputSampleFormat = inputSampleFormat;
+    pipeline->outputChannelCount = outputChannelCount;
+    pipeline->outputSampleFormat = outputSampleFormat;
+
+    bytesPerRequest = PIPELINE_REQUEST_HEADER_BYTES_;
+    if( inputChannelCount > 0 )
+    {
+        PA_ENSURE( bytesPerSample = Pa_GetSampleSize( inputSampleFormat ) );
+        pipeline->bytesPerInputSample = bytesPerSample;
+        bytesPerRequest += (long)(framesPerBuffer * inputChannelCount * pipeline->bytesPerInputSample);
+
+        if( inputSampleFormat & paNonInterleaved )
+        {
+            PA_UNLESS( pipeline->inputChannelPointers = (void**)
+                    PaUtil_AllocateZeroInitializedMemory( sizeof(void*) * inputChannelCount ), paInsufficientMemory );
+        }
+    }
+
+    /* output only streams still queue requests, which carry the timing
+        information and tell the worker when to run */
+    PA_UNLESS( pipeline->requestData = PaUtil_AllocateZeroInitializedMemory( bytesPerRequest * bufferCount ),
+            paInsufficientMemory );
+    PA_UNLESS( PaUtil_InitializeRingBuffer( &pipeline->requests, bytesPerRequest, bufferCount,
+            pipeline->requestData ) == 0, paInternalError );
+
+    if( outputChannelCount > 0 )
+    {
+        PA_ENSURE( bytesPerSample = Pa_GetSampleSize( outputSampleFormat ) );
+        pipeline->bytesPerOutputSample = bytesPerSample;
+        bytesPerOutputBuffer = (long)(framesPerBuffer * outputChannelCount * pipeline->bytesPerOutputSample);
+
+        PA_UNLESS( pipeline->outputData = PaUtil_AllocateZeroInitializedMemory( bytesPerOutputBuffer * bufferCount ),
+                paInsufficientMemory );
+        PA_UNLESS( PaUtil_InitializeRingBuffer( &pipeline->outputs, bytesPerOutputBuffer, bufferCount,
+                pipeline->outputData ) == 0, paInternalError );
+
+        if( outputSampleFormat & paNonInterleaved )
+        {
+            PA_UNLESS( pipeline->outputChannelPointers = (void**)
+                    PaUtil_AllocateZeroInitializedMemory( sizeof(void*) * outputChannelCount ), paInsufficientMemory );
+        }
+    }
+
+    PA_UNLESS( !sem_init( &pipeline->wakeup, 0, 0 ), paInternalError );
+
+    return result;
+
+error:
+    PaUtil_FreeMemory( pipeline->requestData );
+    PaUtil_FreeMemory( pipeline->outputData );
+    PaUtil_FreeMemory( pipeline->inputChannelPointers );
+    PaUtil_FreeMemory( pipeline->outputChannelPointers );
+    pipeline->requestData = 0;
+    pipeline->outputData = 0;
+    pipeline->inputChannelPointers = 0;
+    pipeline->outputChannelPointers = 0;
+
+    return result;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void PaUnixCallbackPipeline_Terminate( PaUnixCallbackPipeline *pipeline )
+{
+    assert( !pipeline->threadRunning );
+
+    sem_destroy( &pipeline->wakeup );
+
+    PaUtil_FreeMemory( pipeline->requestData );
+    PaUtil_FreeMemory( pipeline->outputData );
+    PaUtil_FreeMemory( pipeline->inputChannelPointers );
+    PaUtil_FreeMemory( pipeline->outputChannelPointers );
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Runs the stream callback for the oldest queued request. Called by the
+    worker thread. */
+static void ProcessRequest( PaUnixCallbackPipeline *pipeline )
+{
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2;
+    PipelineRequest *request;
+    unsigned char *requestInput;
+    const void *input = 0;
+    void *output = 0;
+    int result;
+
+    PaUtil_GetRingBufferReadRegions( &pipeline->requests, 1, &data1, &size1, &data2, &size2 );
+    request = (PipelineRequest*)data1;
+    requestInput = (unsigned char*)data1 + PIPELINE_REQUEST_HEADER_BYTES_;
+
+    /* there is always space for the output unless the audio thread has
+        stalled, in which case the request is dropped */
+    if( pipeline->callbackResult == paContinue
+            && ( pipeline->outputChannelCount == 0 || PaUtil_GetRingBufferWriteAvailable( &pipeline->outputs ) > 0 ) )
+    {
+        if( pipeline->inputChannelCount > 0 )
+        {
+            if( pipeline->inputChannelPointers )
+            {
+                SetChannelPointers( pipeline->inputChannelPointers, requestInput, pipeline->inputChannelCount,
+                        pipeline->framesPerBuffer * pipeline->bytesPerInputSample );
+                input = pipeline->inputChannelPointers;
+            }
+            else
+            {
+                input = requestInput;
+            }
+        }
+
+        if( pipeline->outputChannelCount > 0 )
+        {
+            PaUtil_GetRingBufferWriteRegions( &pipeline->outputs, 1, &data1, &size1, &data2, &size2 );
+            if( pipeline->outputChannelPointers )
+            {
+                SetChannelPointers( pipeline->outputChannelPointers, (unsigned char*)data1, pipeline->outputChannelCount,
+                        pipeline->framesPerBuffer * pipeline->bytesPerOutputSample );
+                output = pipeline->outputChannelPointers;
+            }
+            else
+            {
+                output = data1;
+            }
+        }
+
+        result = pipeline->streamCallback( input, output, pipeline->framesPerBuffer,
+                &request->timeInfo, request->statusFlags, pipeline->userData );
+
+        if( pipeline->outputChannelCount > 0 && result != paAbort )
+        {
+            PaUtil_AdvanceRingBufferWriteIndex( &pipeline->outputs, 1 );
+            ++pipeline->outputBuffersProduced;
+        }
+
+        if( result != paContinue )
+        {
+            pipeline->finalOutputBuffer = pipeline->outputBuffersProduced;
+            PaUtil_WriteMemoryBarrier();
+            pipeline->callbackResult = result;
+        }
+    }
+
+    PaUtil_AdvanceRingBufferReadIndex( &pipeline->requests, 1 );
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void *WorkerThreadFunc( void *userData )
+{
+    PaUnixCallbackPipeline *pipeline = (PaUnixCallbackPipeline*)userData;
+
+    for( ;; )
+    {
+        /* the semaphore is posted once for every request, but all queued
+            requests are processed after each wakeup, so the queue may be
+            found empty */
+        while( sem_wait( &pipeline->wakeup ) != 0 && errno == EINTR )
+            ;
+
+        if( pipeline->stopWorker )
+            break;
+
+        while( PaUtil_GetRingBufferReadAvailable( &pipeline->requests ) > 0 )
+            ProcessRequest( pipeline );
+    }
+
+    return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+PaError PaUnixCallbackPipeline_Start( PaUnixCallbackPipeline *pipeline, int rtSched )
+{
+    PaError result = paNoError;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2;
+    unsigned int i;
+
+    assert( !pipeline->threadRunning );
+
+    PaUtil_FlushRingBuffer( &pipeline->requests );
+
+    pipeline->pendingStatusFlags = 0;
+    pipeline->lateOutputBuffers = 0;
+    pipeline->outputBuffersConsumed = 0;
+    pipeline->outputBuffersProduced = 0;
+    pipeline->finalOutputBuffer = 0;
+    pipeline->callbackResult = paContinue;
+    pipeline->stopWorker = 0;
+
+    if( pipeline->outputChannelCount > 0 )
+    {
+        PaUtilZeroer *zeroer = PaUtil_SelectZeroer( pipeline->outputSampleFormat );
+
+        PaUtil_FlushRingBuffer( &pipeline->outputs );
+
+        /* the silence played while the worker computes its first buffers */
+        for( i=0; i < pipeline->lookaheadBuffers; ++i )
+        {
+            PaUtil_GetRingBufferWriteRegions( &pipeline->outputs, 1, &data1, &size1, &data2, &size2 );
+            zeroer( data1, 1, pipeline->framesPerBuffer * pipeline->outputChannelCount );
+            PaUtil_AdvanceRingBufferWriteIndex( &pipeline->outputs, 1 );
+        }
+        pipeline->outputBuffersProduced = pipeline->lookaheadBuffers;
+    }
+
+    PA_UNLESS( !pthread_create( &pipeline->thread, NULL, &WorkerThreadFunc, pipeline ), paInternalError );
+    pipeline->threadRunning = 1;
+
+    if( rtSched )
+    {
+        /* the same priority as PaUnixThread_New() gives the audio thread */
+        struct sched_param spm;
+        memset( &spm, 0, sizeof (spm) );
+        spm.sched_priority = 1;
+
+        if( pthread_setschedparam( pipeline->thread, SCHED_FIFO, &spm ) != 0 )
+        {
+            PA_DEBUG(( "%s: Failed bumping priority\n", __FUNCTION__ ));
+        }
+    }
+
+error:
+    return result;
+}
+
+/* ------------------------------------------------------------------------- */
+
+PaError PaUnixCallbackPipeline_Stop( PaUnixCallbackPipeline *pipeline )
+{
+    PaError result = paNoError;
+
+    if( !pipeline->threadRunning )
+        return paNoError;
+
+    pipeline->stopWorker = 1;
+    sem_post( &pipeline->wakeup );
+
+    pipeline->threadRunning = 0;
+    PA_UNLESS( !pthread_join( pipeline->thread, NULL ), paInternalError );
+
+error:
+    return result;
+}
+
+/* ------------------------------------------------------------------------- */
+
+PaTime PaUnixCallbackPipeline_GetOutputLatency( PaUnixCallbackPipeline *pipeline )
+{
+    if( pipeline->outputChannelCount == 0 )
+        return 0.;
+
+    return pipeline->lookaheadBuffers * pipeline->framesPerBuffer * pipeline->samplePeriod;
+}
+
+/* ------------------------------------------------------------------------- */
+
+unsigned int PaUnixCallbackPipeline_GetLookahead( PaStreamFlags streamFlags )
+{
+    unsigned int lookahead = (unsigned int)((streamFlags & paPipelineLookaheadMask) >> 8);
+
+    return lookahead ? lookahead : PA_UNIX_DEFAULT_PIPELINE_LOOKAHEAD;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Copies frameCount frames between a user buffer, which is an array of
+    channel pointers when non-interleaved, and a pipeline buffer, which holds
+    non-interleaved channels one after the other. */
+static void CopyToPipeline( unsigned char *destination, const void *source, int nonInterleaved,
+        unsigned int channelCount, unsigned long bytesPerChannel )
+{
+    unsigned int i;
+
+    if( nonInterleaved )
+    {
+        for( i=0; i < channelCount; ++i )
+            memcpy( destination + i * bytesPerChannel, ((const void * const *)source)[i], bytesPerChannel );
+    }
+    else
+    {
+        memcpy( destination, source, channelCount * bytesPerChannel );
+    }
+}
+
+static void CopyFromPipeline( void *destination, const unsigned char *source, int nonInterleaved,
+        unsigned int channelCount, unsigned long bytesPerChannel )
+{
+    unsigned int i;
+
+    if( nonInterleaved )
+    {
+        for( i=0; i < channelCount; ++i )
+            memcpy( ((void **)destination)[i], source + i * bytesPerChannel, bytesPerChannel );
+    }
+    else
+    {
+        memcpy( destination, source, channelCount * bytesPerChannel );
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+int PaUnixCallbackPipeline_Callback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    PaUnixCallbackPipeline *pipeline = (PaUnixCallbackPipeline*)userData;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2;
+    PipelineRequest *request;
+    unsigned int i;
+    int result;
+
+    assert( frameCount == pipeline->framesPerBuffer );
+
+    /* queue the input and timing information for the worker */
+    if( PaUtil_GetRingBufferWriteAvailable( &pipeline->requests ) > 0 )
+    {
+        PaUtil_GetRingBufferWriteRegions( &pipeline->requests, 1, &data1, &size1, &data2, &size2 );
+        request = (PipelineRequest*)data1;
+
+        request->timeInfo = *timeInfo;
+        if( pipeline->outputChannelCount > 0 )
+            request->timeInfo.outputBufferDacTime += PaUnixCallbackPipeline_GetOutputLatency( pipeline );
+        request->statusFlags = statusFlags | pipeline->pendingStatusFlags;
+        pipeline->pendingStatusFlags = 0;
+
+        if( pipeline->inputChannelCount > 0 )
+        {
+            CopyToPipeline( (unsigned char*)data1 + PIPELINE_REQUEST_HEADER_BYTES_, input,
+                    pipeline->inputChannelPointers != 0, pipeline->inputChannelCount,
+                    frameCount * pipeline->bytesPerInputSample );
+        }
+
+        PaUtil_AdvanceRingBufferWriteIndex( &pipeline->requests, 1 );
+
+        /* unlike signalling a condition variable, posting the semaphore takes
+            no lock which the worker could hold while it is preempted */
+        sem_post( &pipeline->wakeup );
+    }
+    else
+    {
+        /* the worker has stalled. The dropped request will not produce an
+            output buffer, which makes up for a late one */
+        if( pipeline->inputChannelCount > 0 )
+            pipeline->pendingStatusFlags |= paInputOverflow;
+        if( pipeline->lateOutputBuffers > 0 )
+            --pipeline->lateOutputBuffers;
+    }
+
+    /* return an output buffer computed earlier */
+    if( pipeline->outputChannelCount > 0 )
+    {
+        unsigned long bytesPerChannel = frameCount * pipeline->bytesPerOutputSample;
+
+        while( pipeline->lateOutputBuffers > 0 && PaUtil_GetRingBufferReadAvailable( &pipeline->outputs ) > 0 )
+        {
+            PaUtil_AdvanceRingBufferReadIndex( &pipeline->outputs, 1 );
+            --pipeline->lateOutputBuffers;
+            ++pipeline->outputBuffersConsumed;
+        }
+
+        if( PaUtil_GetRingBufferReadAvailable( &pipeline->outputs ) > 0 )
+        {
+            PaUtil_GetRingBufferReadRegions( &pipeline->outputs, 1, &data1, &size1, &data2, &size2 );
+            CopyFromPipeline( output, (const unsigned char*)data1, pipeline->outputChannelPointers != 0,
+                    pipeline->outputChannelCount, bytesPerChannel );
+            PaUtil_AdvanceRingBufferReadIndex( &pipeline->outputs, 1 );
+            ++pipeline->outputBuffersConsumed;
+        }
+        else
+        {
+            PaUtilZeroer *zeroer = PaUtil_SelectZeroer( pipeline->outputSampleFormat );
+
+            if( pipeline->outputChannelPointers )
+            {
+                for( i=0; i < pipeline->outputChannelCount; ++i )
+                    zeroer( ((void **)output)[i], 1, frameCount );
+            }
+            else
+            {
+                zeroer( output, 1, frameCount * pipeline->outputChannelCount );
+            }
+
+            if( pipeline->callbackResult == paContinue )
+            {
+                pipeline->pendingStatusFlags |= paOutputUnderflow;
+                ++pipeline->lateOutputBuffers;
+            }
+        }
+    }
+
+    result = pipeline->callbackResult;
+    if( result == paComplete && pipeline->outputChannelCount > 0 )
+    {
+        /* keep going until the final output buffer has been played */
+        PaUtil_ReadMemoryBarrier();
+        if( pipeline->outputBuffersConsumed < pipeline->finalOutputBuffer )
+            result = paContinue;
+    }
+
+    return result;
+}
@@ -0,0 +1,172 @@
+#ifndef PA_UNIX_CALLBACK_PIPELINE_H
+#define PA_UNIX_CALLBACK_PIPELINE_H
+/*
+ * $Id$
+ * Portable Audio I/O Library
+ * UNIX stream callback pipeline
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2000 Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup unix_src
+
+ @brief Runs the stream callback on a worker thread, a configurable number of
+ buffers ahead of the host API's audio thread.
+
+ A host API which supports paPipelineCallback passes
+ PaUnixCallbackPipeline_Callback() and the pipeline to
+ PaUtil_InitializeBufferProcessor() in place of the user's callback. Each
+ time it is called on the audio thread, the proxy callback queues the input
+ buffer and the timing information for the worker, and returns an output
+ buffer which the worker computed earlier. Both queues are PaUtilRingBuffers,
+ each with a single reader and a single writer, and the audio thread wakes
+ the worker by posting a semaphore, so it never waits for the worker. When the stream starts the output queue is primed with
+ lookaheadBuffers buffers of silence, which is the latency added to the
+ stream.
+
+ When the worker falls behind the audio thread plays silence, sets
+ paOutputUnderflow for the next callback, and later drops as many late output
+ buffers so that the latency does not grow.
+*/
+
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "portaudio.h"
+#include "pa_ringbuffer.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+/** The lookahead used when paPipelineCallback is given without
+ paPipelineLookahead().
+*/
+#define PA_UNIX_DEFAULT_PIPELINE_LOOKAHEAD  (2)
+
+
+typedef struct PaUnixCallbackPipeline
+{
+    PaStreamCallback *streamCallback;
+    void *userData;
+    unsigned long framesPerBuffer;
+    unsigned int lookaheadBuffers;
+    double samplePeriod;
+
+    unsigned int inputChannelCount;
+    PaSampleFormat inputSampleFormat;
+    unsigned int bytesPerInputSample;
+    unsigned int outputChannelCount;
+    PaSampleFormat outputSampleFormat;
+    unsigned int bytesPerOutputSample;
+
+    PaUtilRingBuffer requests;      /**< timing information and input, audio thread -> worker */
+    void *requestData;
+    PaUtilRingBuffer outputs;       /**< output buffers, worker -> audio thread */
+    void *outputData;
+    void **inputChannelPointers;    /**< non-interleaved user buffers, NULL when interleaved */
+    void **outputChannelPointers;
+
+    /* only accessed by the audio thread */
+    PaStreamCallbackFlags pendingStatusFlags; /**< underflows and overflows to report to the next callback */
+    unsigned long lateOutputBuffers;          /**< output buffers to drop when they arrive */
+    unsigned long outputBuffersConsumed;
+
+    /* only written by the worker */
+    unsigned long outputBuffersProduced;
+    unsigned long finalOutputBuffer;          /**< outputBuffersProduced when the callback finished */
+    volatile int callbackResult;
+
+    pthread_t thread;
+    sem_t wakeup;                             /**< posted when a request is queued or the worker is stopped */
+    volatile int stopWorker;
+    int threadRunning;
+} PaUnixCallbackPipeline;
+
+
+/** Initialize a callback pipeline. The pipeline buffers are in the user
+ sample formats, so the formats may include paNonInterleaved.
+
+ @param lookaheadBuffers The number of buffers by which the stream callback
+ runs ahead, at least 1.
+
+ @param framesPerBuffer The number of frames passed to the stream callback,
+ which must also be passed as framesPerUserBuffer to
+ PaUtil_InitializeBufferProcessor().
+*/
+PaError PaUnixCallbackPipeline_Initialize( PaUnixCallbackPipeline *pipeline,
+        unsigned int inputChannelCount, PaSampleFormat inputSampleFormat,
+        unsigned int outputChannelCount, PaSampleFormat outputSampleFormat,
+        double sampleRate, unsigned long framesPerBuffer, unsigned int lookaheadBuffers,
+        PaStreamCallback *streamCallback, void *userData );
+
+/** Free the resources of a pipeline which is not running. */
+void PaUnixCallbackPipeline_Terminate( PaUnixCallbackPipeline *pipeline );
+
+/** Prime the output queue with silence and start the worker thread. Call
+ before the host API starts calling the proxy callback.
+
+ @param rtSched Whether the worker thread should use realtime scheduling.
+*/
+PaError PaUnixCallbackPipeline_Start( PaUnixCallbackPipeline *pipeline, int rtSched );
+
+/** Stop the worker thread. Call after the host API has stopped calling the
+ proxy callback. Buffers which are still queued are discarded.
+*/
+PaError PaUnixCallbackPipeline_Stop( PaUnixCallbackPipeline *pipeline );
+
+/** The latency added to the output of the stream, in seconds. */
+PaTime PaUnixCallbackPipeline_GetOutputLatency( PaUnixCallbackPipeline *pipeline );
+
+/** Return the lookahead requested by the paPipelineLookahead() bits of
+ streamFlags, or PA_UNIX_DEFAULT_PIPELINE_LOOKAHEAD if there are none.
+*/
+unsigned int PaUnixCallbackPipeline_GetLookahead( PaStreamFlags streamFlags );
+
+/** The proxy stream callback, called by the buffer processor on the host
+ API's audio thread with the pipeline as userData.
+*/
+int PaUnixCallbackPipeline_Callback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData );
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PA_UNIX_CALLBACK_PIPELINE_H */
@@ -0,0 +1,281 @@
+/*
+ * $Id$
+ * Portable Audio I/O Library
+ * UNIX stream readiness descriptors
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2000 Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup unix_src
+
+ @brief Readiness descriptors for blocking streams.
+ @see pa_unix_ready_event.h
+*/
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* for EFD_CLOEXEC and EPOLL_CLOEXEC with older C libraries */
+#endif
+
+#include <errno.h>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#define PA_READY_EVENT_USE_EVENTFD_
+#define PA_READY_EVENT_USE_EPOLL_
+#endif
+
+#include "pa_unix_ready_event.h"
+#include "pa_debugprint.h"
+
+
+void PaUnixReadyEvent_Initialize( PaUnixReadyEvent *self )
+{
+    self->fd = -1;
+    self->signalFd = -1;
+    self->signalled = 0;
+    self->frames = 1;
+}
+
+
+int PaUnixReadyEvent_IsCreated( const PaUnixReadyEvent *self )
+{
+    return self->fd >= 0;
+}
+
+
+#if !defined(_WIN32)
+
+void PaUnixReadyEvent_Terminate( PaUnixReadyEvent *self )
+{
+    if( self->signalFd >= 0 && self->signalFd != self->fd )
+        close( self->signalFd );
+    if( self->fd >= 0 )
+        close( self->fd );
+    self->fd = -1;
+    self->signalFd = -1;
+    self->signalled = 0;
+}
+
+
+PaError PaUnixReadyEvent_CreateSignalled( PaUnixReadyEvent *self )
+{
+#ifdef PA_READY_EVENT_USE_EVENTFD_
+    if( (self->fd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC )) < 0 )
+    {
+        PA_DEBUG(( "%s: eventfd failed: %d\n", __FUNCTION__, errno ));
+        return paUnanticipatedHostError;
+    }
+    self->signalFd = self->fd;
+#else
+    int fds[2], i;
+
+    if( pipe( fds ) != 0 )
+    {
+        PA_DEBUG(( "%s: pipe failed: %d\n", __FUNCTION__, errno ));
+        return paUnanticipatedHostError;
+    }
+    for( i=0; i < 2; ++i )
+    {
+        fcntl( fds[i], F_SETFL, fcntl( fds[i], F_GETFL ) | O_NONBLOCK );
+        fcntl( fds[i], F_SETFD, FD_CLOEXEC );
+    }
+    self->fd = fds[0];
+    self->signalFd = fds[1];
+#endif
+    self->signalled = 0;
+    return paNoError;
+}
+
+
+PaError PaUnixReadyEvent_CreateFromDescriptors( PaUnixReadyEvent *self,
+        const struct pollfd *pfds, int count )
+{
+#ifdef PA_READY_EVENT_USE_EPOLL_
+    struct epoll_event event;
+    int i;
+
+    if( (self->fd = epoll_create1( EPOLL_CLOEXEC )) < 0 )
+    {
+        PA_DEBUG(( "%s: epoll_create1 failed: %d\n", __FUNCTION__, errno ));
+        return paUnanticipatedHostError;
+    }
+
+    for( i=0; i < count; ++i )
+    {
+        event.events = 0;
+        if( pfds[i].events & POLLIN )
+            event.events |= EPOLLIN;
+        if( pfds[i].events & POLLOUT )
+            event.events |= EPOLLOUT;
+        if( pfds[i].events & POLLPRI )
+            event.events |= EPOLLPRI;
+        event.data.fd = pfds[i].fd;
+
+        /* a device may use the same descriptor twice */
+        if( epoll_ctl( self->fd, EPOLL_CTL_ADD, pfds[i].fd, &event ) != 0 && errno != EEXIST )
+        {
+            PA_DEBUG(( "%s: epoll_ctl failed: %d\n", __FUNCTION__, errno ));
+            PaUnixReadyEvent_Terminate( self );
+            return paUnanticipatedHostError;
+        }
+    }
+    return paNoError;
+#else
+    (void) self;
+    (void) pfds;
+    (void) count;
+    return paIncompatibleStreamHostApi;
+#endif
+}
+
+
+static int ExchangeSignalled( PaUnixReadyEvent *self, int signalled )
+{
+    return __atomic_exchange_n( &self->signalled, signalled, __ATOMIC_ACQ_REL );
+}
+
+
+void PaUnixReadyEvent_Signal( PaUnixReadyEvent *self )
+{
+#ifdef PA_READY_EVENT_USE_EVENTFD_
+    uint64_t value = 1;
+#else
+    char value = 1;
+#endif
+
+    if( self->signalFd < 0 )
+        return;
+
+    if( !ExchangeSignalled( self, 1 ) )
+    {
+        /* can only fail when the counter or the pipe is full, which leaves
+            the descriptor readable anyway */
+        if( write( self->signalFd, &value, sizeof(value) ) < 0 )
+        {
+            PA_DEBUG(( "%s: write failed: %d\n", __FUNCTION__, errno ));
+        }
+    }
+}
+
+
+static void Clear( PaUnixReadyEvent *self )
+{
+#ifdef PA_READY_EVENT_USE_EVENTFD_
+    uint64_t value;
+#else
+    char value[16];
+#endif
+
+    /* The descriptor is drained before the flag is cleared. The other way
+        round, a Signal() from another thread in between would set the flag
+        and write, the write would be drained, and the flag would stay set
+        with the descriptor unreadable, so that no later Signal() writes.
+        Now a Signal() which finds the flag still set is caught when Update()
+        reads the available frames again. An eventfd is reset by a single
+        read, a pipe may hold several bytes. */
+    while( read( self->fd, &value, sizeof(value) ) > 0 )
+        ;
+    ExchangeSignalled( self, 0 );
+}
+
+
+void PaUnixReadyEvent_Update( PaUnixReadyEvent *self, PaStream *stream,
+        signed long (*GetAvailable)( PaStream *stream ) )
+{
+    signed long available;
+
+    if( self->signalFd < 0 )
+        return;
+
+    available = GetAvailable( stream );
+    if( available < 0 || (unsigned long)available >= self->frames )
+    {
+        PaUnixReadyEvent_Signal( self );
+        return;
+    }
+
+    Clear( self );
+
+    available = GetAvailable( stream );
+    if( available < 0 || (unsigned long)available >= self->frames )
+        PaUnixReadyEvent_Signal( self );
+}
+
+#else /* _WIN32 */
+
+/* JACK may be built on Windows, which has no descriptors to offer */
+
+void PaUnixReadyEvent_Terminate( PaUnixReadyEvent *self )
+{
+    self->fd = -1;
+}
+
+PaError PaUnixReadyEvent_CreateSignalled( PaUnixReadyEvent *self )
+{
+    (void) self;
+    return paIncompatibleStreamHostApi;
+}
+
+PaError PaUnixReadyEvent_CreateFromDescriptors( PaUnixReadyEvent *self,
+        const struct pollfd *pfds, int count )
+{
+    (void) self;
+    (void) pfds;
+    (void) count;
+    return paIncompatibleStreamHostApi;
+}
+
+void PaUnixReadyEvent_Signal( PaUnixReadyEvent *self )
+{
+    (void) self;
+}
+
+void PaUnixReadyEvent_Update( PaUnixReadyEvent *self, PaStream *stream,
+        signed long (*GetAvailable)( PaStream *stream ) )
+{
+    (void) self;
+    (void) stream;
+    (void) GetAvailable;
+}
+
+#endif /* _WIN32 */
@@ -0,0 +1,132 @@
+#ifndef PA_UNIX_READY_EVENT_H
+#define PA_UNIX_READY_EVENT_H
+/*
+ * $Id$
+ * Portable Audio I/O Library
+ * UNIX stream readiness descriptors
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2000 Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup unix_src
+
+ @brief A file descriptor which becomes readable when a blocking stream can
+ be read or written without blocking, returned by
+ Pa_GetStreamReadyFileDescriptor().
+
+ Host APIs whose devices have pollable descriptors, such as ALSA and OSS,
+ use PaUnixReadyEvent_CreateFromDescriptors(). The returned descriptor is an
+ epoll instance watching the device descriptors, and the host API makes the
+ device wake up at the requested number of frames.
+
+ Host APIs which move the samples themselves, such as JACK and PulseAudio,
+ use PaUnixReadyEvent_CreateSignalled() and call PaUnixReadyEvent_Update()
+ whenever the number of available frames has changed: from their audio
+ thread after a transfer, and from Pa_ReadStream() or Pa_WriteStream().
+ The returned descriptor is an eventfd, or the read end of a pipe where
+ there is no eventfd.
+
+ In both cases the descriptor may become readable spuriously, so the
+ application is expected to check the available frames before reading or
+ writing.
+*/
+
+
+#include "portaudio.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+typedef struct PaUnixReadyEvent
+{
+    int fd;                         /**< the descriptor returned to the application, -1 until created */
+    int signalFd;                   /**< written to make fd readable, -1 for descriptor sets */
+    int signalled;                  /**< whether signalFd holds an event which wasn't read, accessed atomically */
+    volatile unsigned long frames;  /**< the number of frames at which fd becomes readable */
+} PaUnixReadyEvent;
+
+struct pollfd;
+
+
+/** Initialize a ready event without creating a descriptor, so that it can be
+ terminated whether or not a descriptor was created later.
+*/
+void PaUnixReadyEvent_Initialize( PaUnixReadyEvent *self );
+
+/** Free the descriptors of a ready event, if any. */
+void PaUnixReadyEvent_Terminate( PaUnixReadyEvent *self );
+
+/** Whether one of the create functions has succeeded. */
+int PaUnixReadyEvent_IsCreated( const PaUnixReadyEvent *self );
+
+/** Create a descriptor which is made readable by PaUnixReadyEvent_Signal()
+ and PaUnixReadyEvent_Update().
+
+ @return paNoError, or paUnanticipatedHostError if no descriptor could be
+ created.
+*/
+PaError PaUnixReadyEvent_CreateSignalled( PaUnixReadyEvent *self );
+
+/** Create a descriptor which is readable while any of the given poll
+ descriptors has one of its requested events or an error.
+
+ @return paNoError, paIncompatibleStreamHostApi where this is not supported
+ (epoll is required), or paUnanticipatedHostError.
+*/
+PaError PaUnixReadyEvent_CreateFromDescriptors( PaUnixReadyEvent *self,
+        const struct pollfd *pfds, int count );
+
+/** Make a signalled descriptor readable. Safe to call from the audio thread:
+ it only makes a system call when the descriptor was not readable already.
+*/
+void PaUnixReadyEvent_Signal( PaUnixReadyEvent *self );
+
+/** Make a signalled descriptor readable if GetAvailable( stream ) returns at
+ least self->frames or an error, otherwise make it not readable. When it is
+ cleared the available frames are read again, so that frames which arrived
+ from another thread in between are not missed. Does nothing for descriptor
+ sets, or before the descriptor is created.
+*/
+void PaUnixReadyEvent_Update( PaUnixReadyEvent *self, PaStream *stream,
+        signed long (*GetAvailable)( PaStream *stream ) );
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PA_UNIX_READY_EVENT_H */
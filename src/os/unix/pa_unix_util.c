@@ -41,7 +41,12 @@
  @ingroup unix_src
 */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* for pthread_setaffinity_np() */
+#endif
+
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <time.h>
@@ -177,6 +182,192 @@ PaTime PaUtil_GetTime( void )
 #endif
 }
 
+int PaUtil_GetProcessorCount( void )
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long count = sysconf( _SC_NPROCESSORS_ONLN );
+    return count > 0 ? (int)count : 1;
+#else
+    return 1;
+#endif
+}
+
+struct PaUtilWorkerPool
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t jobsAvailable;
+    pthread_cond_t jobsDone;
+    pthread_t *threads;
+    unsigned int threadCount;
+    int stop;
+
+    PaUtilWorkerPoolJob *job;
+    void *context;
+    unsigned int jobCount;
+    unsigned int nextJob;
+    unsigned int jobsRemaining;
+};
+
+/* Claims and runs jobs until none are left. Called with the mutex held,
+    returns with it held. */
+static void RunWorkerPoolJobs( PaUtilWorkerPool *pool )
+{
+    unsigned int jobIndex;
+
+    while( pool->nextJob < pool->jobCount )
+    {
+        jobIndex = pool->nextJob++;
+        pthread_mutex_unlock( &pool->mutex );
+
+        pool->job( pool->context, jobIndex );
+
+        pthread_mutex_lock( &pool->mutex );
+        if( --pool->jobsRemaining == 0 )
+            pthread_cond_signal( &pool->jobsDone );
+    }
+}
+
+static void *WorkerPoolThreadFunc( void *userData )
+{
+    PaUtilWorkerPool *pool = (PaUtilWorkerPool*)userData;
+
+    pthread_mutex_lock( &pool->mutex );
+    for( ;; )
+    {
+        while( !pool->stop && pool->nextJob >= pool->jobCount )
+            pthread_cond_wait( &pool->jobsAvailable, &pool->mutex );
+
+        if( pool->stop )
+            break;
+
+        RunWorkerPoolJobs( pool );
+    }
+    pthread_mutex_unlock( &pool->mutex );
+
+    return NULL;
+}
+
+/* Gives a pool thread the same real-time priority BoostPriority() gives the
+    audio thread, and pins it to a processor of its own. Failures only cost
+    performance. */
+static void SetWorkerPoolThreadScheduling( pthread_t thread, unsigned int threadIndex )
+{
+    struct sched_param spm;
+#ifdef __linux__
+    cpu_set_t cpus;
+    int processorCount = PaUtil_GetProcessorCount();
+#endif
+
+    memset( &spm, 0, sizeof (spm) );
+    spm.sched_priority = 1;
+    if( pthread_setschedparam( thread, SCHED_FIFO, &spm ) != 0 )
+    {
+        PA_DEBUG(( "%s: Failed bumping priority of pool thread %u\n", __FUNCTION__, threadIndex ));
+    }
+
+#ifdef __linux__
+    /* processor 0 is left to the thread which runs the pool */
+    if( (int)threadIndex + 1 < processorCount )
+    {
+        CPU_ZERO( &cpus );
+        CPU_SET( threadIndex + 1, &cpus );
+        if( pthread_setaffinity_np( thread, sizeof (cpus), &cpus ) != 0 )
+        {
+            PA_DEBUG(( "%s: Failed pinning pool thread %u\n", __FUNCTION__, threadIndex ));
+        }
+    }
+#endif
+}
+
+PaError PaUtil_CreateWorkerPool( PaUtilWorkerPool **pool, unsigned int threadCount )
+{
+    PaError result = paNoError;
+    PaUtilWorkerPool *newPool;
+    unsigned int i;
+
+    newPool = (PaUtilWorkerPool*)PaUtil_AllocateZeroInitializedMemory( sizeof (PaUtilWorkerPool) );
+    PA_UNLESS( newPool, paInsufficientMemory );
+
+    pthread_mutex_init( &newPool->mutex, NULL );
+    pthread_cond_init( &newPool->jobsAvailable, NULL );
+    pthread_cond_init( &newPool->jobsDone, NULL );
+
+    if( threadCount > 0 )
+    {
+        newPool->threads = (pthread_t*)PaUtil_AllocateZeroInitializedMemory( sizeof (pthread_t) * threadCount );
+        PA_UNLESS( newPool->threads, paInsufficientMemory );
+    }
+
+    for( i=0; i < threadCount; ++i )
+    {
+        PA_UNLESS( !pthread_create( &newPool->threads[i], NULL, &WorkerPoolThreadFunc, newPool ),
+                paUnanticipatedHostError );
+        ++newPool->threadCount;
+
+        SetWorkerPoolThreadScheduling( newPool->threads[i], i );
+    }
+
+    *pool = newPool;
+    return result;
+
+error:
+    PaUtil_DestroyWorkerPool( newPool );
+    return result;
+}
+
+void PaUtil_DestroyWorkerPool( PaUtilWorkerPool *pool )
+{
+    unsigned int i;
+
+    if( !pool )
+        return;
+
+    pthread_mutex_lock( &pool->mutex );
+    pool->stop = 1;
+    pthread_cond_broadcast( &pool->jobsAvailable );
+    pthread_mutex_unlock( &pool->mutex );
+
+    for( i=0; i < pool->threadCount; ++i )
+        pthread_join( pool->threads[i], NULL );
+
+    pthread_cond_destroy( &pool->jobsDone );
+    pthread_cond_destroy( &pool->jobsAvailable );
+    pthread_mutex_destroy( &pool->mutex );
+
+    PaUtil_FreeMemory( pool->threads );
+    PaUtil_FreeMemory( pool );
+}
+
+void PaUtil_RunWorkerPool( PaUtilWorkerPool *pool, PaUtilWorkerPoolJob *job,
+        void *context, unsigned int jobCount )
+{
+    unsigned int i;
+
+    if( pool->threadCount == 0 || jobCount < 2 )
+    {
+        for( i=0; i < jobCount; ++i )
+            job( context, i );
+        return;
+    }
+
+    pthread_mutex_lock( &pool->mutex );
+
+    pool->job = job;
+    pool->context = context;
+    pool->jobCount = jobCount;
+    pool->nextJob = 0;
+    pool->jobsRemaining = jobCount;
+    pthread_cond_broadcast( &pool->jobsAvailable );
+
+    RunWorkerPoolJobs( pool );
+
+    /* the barrier: wait for the jobs claimed by the pool threads */
+    while( pool->jobsRemaining > 0 )
+        pthread_cond_wait( &pool->jobsDone, &pool->mutex );
+
+    pthread_mutex_unlock( &pool->mutex );
+}
+
 PaError PaUtil_InitializeThreading( PaUtilThreading *threading )
 {
     (void) paUtilErr_;
@@ -159,6 +159,50 @@ double PaUtil_GetTime( void )
     }
 }
 
+int PaUtil_GetProcessorCount( void )
+{
+    SYSTEM_INFO systemInfo;
+
+    GetSystemInfo( &systemInfo );
+    return systemInfo.dwNumberOfProcessors > 0 ? (int)systemInfo.dwNumberOfProcessors : 1;
+}
+
+
+/* There is no threaded pool implementation for Windows yet, the jobs are run
+    one after the other by the calling thread. */
+struct PaUtilWorkerPool
+{
+    unsigned int threadCount;
+};
+
+
+PaError PaUtil_CreateWorkerPool( PaUtilWorkerPool **pool, unsigned int threadCount )
+{
+    (void) threadCount;
+
+    *pool = (PaUtilWorkerPool*)PaUtil_AllocateZeroInitializedMemory( sizeof (PaUtilWorkerPool) );
+    return *pool ? paNoError : paInsufficientMemory;
+}
+
+
+void PaUtil_DestroyWorkerPool( PaUtilWorkerPool *pool )
+{
+    PaUtil_FreeMemory( pool );
+}
+
+
+void PaUtil_RunWorkerPool( PaUtilWorkerPool *pool, PaUtilWorkerPoolJob *job,
+        void *context, unsigned int jobCount )
+{
+    unsigned int i;
+
+    (void) pool;
+
+    for( i=0; i < jobCount; ++i )
+        job( context, i );
+}
+
+
 void PaWinUtil_SetLastSystemErrorInfo( PaHostApiTypeId hostApiType, long winError )
 {
     wchar_t wide_msg[1024]; //PA_LAST_HOST_ERROR_TEXT_LENGTH_
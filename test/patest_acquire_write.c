@@ -0,0 +1,160 @@
+/** @file patest_acquire_write.c
+    @ingroup test_src
+    @brief Play a sine wave by rendering it straight into the regions returned
+    by Pa_AcquireWriteBuffer(), and report how many of them were host API
+    memory rather than a bounce buffer.
+
+    Pass --non-interleaved to open the stream with non-interleaved buffers,
+    which always go through a bounce buffer.
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "portaudio.h"
+
+#define NUM_SECONDS         (4)
+#define SAMPLE_RATE         (44100)
+#define FRAMES_PER_BUFFER   (256)
+#define LEFT_FREQUENCY      (440.)
+#define RIGHT_FREQUENCY     (660.)
+
+#ifndef M_PI
+#define M_PI  (3.14159265)
+#endif
+
+int main( int argc, char **argv );
+int main( int argc, char **argv )
+{
+    PaStreamParameters outputParameters;
+    PaStream *stream;
+    PaError err;
+    int nonInterleaved = ( argc == 2 && strcmp( argv[1], "--non-interleaved" ) == 0 );
+    unsigned long framesLeft = NUM_SECONDS * SAMPLE_RATE, frames, i;
+    unsigned long regionCount = 0, zeroCopyCount = 0, phase = 0;
+    void *region;
+    float *left, *right;
+    int isZeroCopy;
+
+    printf( "PortAudio Test: render a sine wave into acquired write buffers. SR = %d, %s\n",
+            SAMPLE_RATE, nonInterleaved ? "non-interleaved" : "interleaved" );
+
+    err = Pa_Initialize();
+    if( err != paNoError ) goto error;
+
+    outputParameters.device = Pa_GetDefaultOutputDevice(); /* default output device */
+    if( outputParameters.device == paNoDevice )
+    {
+        fprintf( stderr, "Error: No default output device.\n" );
+        goto error;
+    }
+    outputParameters.channelCount = 2;
+    outputParameters.sampleFormat = paFloat32 | ( nonInterleaved ? paNonInterleaved : 0 );
+    outputParameters.suggestedLatency = Pa_GetDeviceInfo( outputParameters.device )->defaultHighOutputLatency;
+    outputParameters.hostApiSpecificStreamInfo = NULL;
+
+    err = Pa_OpenStream( &stream, NULL, &outputParameters, SAMPLE_RATE, FRAMES_PER_BUFFER,
+                         paClipOff, NULL, NULL );
+    if( err != paNoError ) goto error;
+
+    err = Pa_StartStream( stream );
+    if( err != paNoError ) goto error;
+
+    while( framesLeft > 0 )
+    {
+        frames = framesLeft;
+        err = Pa_AcquireWriteBuffer( stream, &region, &frames, &isZeroCopy );
+        if( err != paNoError ) goto error;
+
+        if( frames == 0 )
+        {
+            /* the acquire functions never block */
+            Pa_Sleep( 1000 * FRAMES_PER_BUFFER / SAMPLE_RATE );
+            continue;
+        }
+
+        for( i=0; i < frames; ++i, ++phase )
+        {
+            float l = (float) (0.2 * sin( 2. * M_PI * LEFT_FREQUENCY * phase / SAMPLE_RATE ));
+            float r = (float) (0.2 * sin( 2. * M_PI * RIGHT_FREQUENCY * phase / SAMPLE_RATE ));
+
+            if( nonInterleaved )
+            {
+                left = ((float**)region)[0];
+                right = ((float**)region)[1];
+                left[i] = l;
+                right[i] = r;
+            }
+            else
+            {
+                ((float*)region)[i * 2] = l;
+                ((float*)region)[i * 2 + 1] = r;
+            }
+        }
+
+        err = Pa_CommitWriteBuffer( stream, frames );
+        if( err == paOutputUnderflowed )
+            printf( "output underflowed\n" );
+        else if( err != paNoError ) goto error;
+
+        framesLeft -= frames;
+        ++regionCount;
+        if( isZeroCopy )
+            ++zeroCopyCount;
+    }
+
+    err = Pa_StopStream( stream );
+    if( err != paNoError ) goto error;
+
+    err = Pa_CloseStream( stream );
+    if( err != paNoError ) goto error;
+
+    Pa_Terminate();
+    printf( "%lu regions, %lu of them zero-copy\n", regionCount, zeroCopyCount );
+    printf( "Test finished.\n" );
+    return 0;
+
+error:
+    Pa_Terminate();
+    fprintf( stderr, "An error occurred while using the portaudio stream\n" );
+    fprintf( stderr, "Error number: %d\n", err );
+    fprintf( stderr, "Error message: %s\n", Pa_GetErrorText( err ) );
+    return err;
+}
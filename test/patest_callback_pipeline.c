@@ -0,0 +1,330 @@
+/** @file patest_callback_pipeline.c
+    @ingroup test_src
+    @brief Drive the UNIX callback pipeline used for paPipelineCallback
+    streams the way a host API's audio thread does, and verify that the
+    stream callback runs ahead on the worker thread by the configured number
+    of buffers, that its output is delayed by exactly that many buffers, that
+    late buffers are reported as output underflows, and that paComplete is
+    only returned once the final buffer has been played.
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "portaudio.h"
+#include "pa_ringbuffer.h"
+#include "pa_unix_callback_pipeline.h"
+
+#define SAMPLE_RATE         (44100)
+#define CHANNEL_COUNT       (2)
+#define FRAMES_PER_BUFFER   (64)
+#define LOOKAHEAD           (3)
+#define BUFFER_COUNT        (12)
+#define COMPLETE_BUFFER     (7)
+
+typedef struct
+{
+    volatile unsigned long callCount;
+    unsigned long completeAt;       /* return paComplete from this call, or 0 */
+    volatile int delayCallback;     /* sleep in the callback while set */
+    PaTime dacTimes[BUFFER_COUNT];
+    PaStreamCallbackFlags statusFlags[BUFFER_COUNT];
+    float inputValues[BUFFER_COUNT];
+}
+TestData;
+
+/* Writes the number of the call to every output sample, and records the
+    timing information and the first input sample. */
+static int TestCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    TestData *data = (TestData*)userData;
+    unsigned long call = data->callCount;
+    unsigned long i;
+
+    while( data->delayCallback )
+        Pa_Sleep( 1 );
+
+    if( call < BUFFER_COUNT )
+    {
+        data->dacTimes[call] = timeInfo->outputBufferDacTime;
+        data->statusFlags[call] = statusFlags;
+        data->inputValues[call] = input ? ((const float*)input)[0] : 0.f;
+    }
+
+    if( output )
+    {
+        for( i=0; i < frameCount * CHANNEL_COUNT; ++i )
+            ((float*)output)[i] = (float)(call + 1);
+    }
+
+    data->callCount = call + 1;
+    return (data->completeAt != 0 && call + 1 == data->completeAt) ? paComplete : paContinue;
+}
+
+/* Waits until the worker has produced the output for every queued request. */
+static int WaitForWorker( PaUnixCallbackPipeline *pipeline, TestData *data, unsigned long callCount )
+{
+    int i;
+
+    for( i=0; i < 2000; ++i )
+    {
+        if( data->callCount >= callCount
+                && PaUtil_GetRingBufferReadAvailable( &pipeline->requests ) == 0 )
+            return 1;
+        Pa_Sleep( 1 );
+    }
+    return 0;
+}
+
+static int OutputIs( const float *output, float value )
+{
+    int i;
+
+    for( i=0; i < FRAMES_PER_BUFFER * CHANNEL_COUNT; ++i )
+    {
+        if( output[i] != value )
+            return 0;
+    }
+    return 1;
+}
+
+static int TestPipeline( const char *name, int duplex )
+{
+    PaUnixCallbackPipeline pipeline;
+    PaStreamCallbackTimeInfo timeInfo;
+    TestData data;
+    float input[FRAMES_PER_BUFFER * CHANNEL_COUNT];
+    float output[FRAMES_PER_BUFFER * CHANNEL_COUNT];
+    PaTime latency;
+    int result = paContinue;
+    int ok = 1;
+    unsigned long b, i;
+
+    memset( &data, 0, sizeof (data) );
+    data.completeAt = COMPLETE_BUFFER;
+
+    if( PaUnixCallbackPipeline_Initialize( &pipeline,
+            duplex ? CHANNEL_COUNT : 0, paFloat32, CHANNEL_COUNT, paFloat32,
+            SAMPLE_RATE, FRAMES_PER_BUFFER, LOOKAHEAD, TestCallback, &data ) != paNoError )
+    {
+        printf( "%s: PaUnixCallbackPipeline_Initialize failed\n", name );
+        return 0;
+    }
+
+    latency = PaUnixCallbackPipeline_GetOutputLatency( &pipeline );
+    if( fabs( latency - (double)(LOOKAHEAD * FRAMES_PER_BUFFER) / SAMPLE_RATE ) > 1e-9 )
+    {
+        printf( "%s: the output latency is %g seconds\n", name, latency );
+        ok = 0;
+    }
+
+    if( PaUnixCallbackPipeline_Start( &pipeline, 0 ) != paNoError )
+    {
+        printf( "%s: PaUnixCallbackPipeline_Start failed\n", name );
+        PaUnixCallbackPipeline_Terminate( &pipeline );
+        return 0;
+    }
+
+    memset( &timeInfo, 0, sizeof (timeInfo) );
+    for( b=0; b < BUFFER_COUNT && result == paContinue; ++b )
+    {
+        for( i=0; i < FRAMES_PER_BUFFER * CHANNEL_COUNT; ++i )
+            input[i] = (float)(b + 100);
+        timeInfo.outputBufferDacTime = (PaTime)b;
+
+        result = PaUnixCallbackPipeline_Callback( duplex ? input : NULL, output,
+                FRAMES_PER_BUFFER, &timeInfo, 0, &pipeline );
+
+        /* the primed silence, then the output of the call LOOKAHEAD buffers earlier */
+        if( !OutputIs( output, b < LOOKAHEAD ? 0.f : (float)(b - LOOKAHEAD + 1) ) )
+        {
+            printf( "%s: buffer %lu holds %g\n", name, b, output[0] );
+            ok = 0;
+        }
+
+        /* completes once the output of the final call has been played */
+        if( (result == paComplete) != (b == COMPLETE_BUFFER - 1 + LOOKAHEAD) )
+        {
+            printf( "%s: buffer %lu returned %d\n", name, b, result );
+            ok = 0;
+        }
+
+        if( b < COMPLETE_BUFFER && !WaitForWorker( &pipeline, &data, b + 1 ) )
+        {
+            printf( "%s: the worker did not process buffer %lu\n", name, b );
+            ok = 0;
+            break;
+        }
+    }
+
+    PaUnixCallbackPipeline_Stop( &pipeline );
+    PaUnixCallbackPipeline_Terminate( &pipeline );
+
+    if( data.callCount != COMPLETE_BUFFER )
+    {
+        printf( "%s: the callback was called %lu times\n", name, data.callCount );
+        ok = 0;
+    }
+
+    for( b=0; b < COMPLETE_BUFFER && b < data.callCount; ++b )
+    {
+        if( fabs( data.dacTimes[b] - (b + latency) ) > 1e-9 )
+        {
+            printf( "%s: call %lu received outputBufferDacTime %g\n", name, b, data.dacTimes[b] );
+            ok = 0;
+        }
+        if( data.statusFlags[b] != 0 )
+        {
+            printf( "%s: call %lu received status flags 0x%lx\n", name, b, data.statusFlags[b] );
+            ok = 0;
+        }
+        if( data.inputValues[b] != (duplex ? (float)(b + 100) : 0.f) )
+        {
+            printf( "%s: call %lu received input %g\n", name, b, data.inputValues[b] );
+            ok = 0;
+        }
+    }
+
+    printf( "%s: %s\n", name, ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+/* Stalls the stream callback until the primed buffers have been played, then
+    lets it catch up. The late buffers must be replaced by silence, reported
+    as an underflow, and dropped once they arrive so the output is again
+    LOOKAHEAD buffers behind. */
+static int TestUnderflow( void )
+{
+    const char *name = "underflow";
+    PaUnixCallbackPipeline pipeline;
+    PaStreamCallbackTimeInfo timeInfo;
+    TestData data;
+    float output[FRAMES_PER_BUFFER * CHANNEL_COUNT];
+    int ok = 1;
+    unsigned long b, stalled = LOOKAHEAD + 2;
+
+    memset( &data, 0, sizeof (data) );
+    memset( &timeInfo, 0, sizeof (timeInfo) );
+    data.delayCallback = 1;
+
+    if( PaUnixCallbackPipeline_Initialize( &pipeline, 0, paFloat32, CHANNEL_COUNT, paFloat32,
+            SAMPLE_RATE, FRAMES_PER_BUFFER, LOOKAHEAD, TestCallback, &data ) != paNoError
+            || PaUnixCallbackPipeline_Start( &pipeline, 0 ) != paNoError )
+    {
+        printf( "%s: the pipeline could not be started\n", name );
+        return 0;
+    }
+
+    for( b=0; b < stalled; ++b )
+    {
+        PaUnixCallbackPipeline_Callback( NULL, output, FRAMES_PER_BUFFER, &timeInfo, 0, &pipeline );
+        if( !OutputIs( output, 0.f ) )
+        {
+            printf( "%s: stalled buffer %lu is not silent\n", name, b );
+            ok = 0;
+        }
+    }
+
+    data.delayCallback = 0;
+    if( !WaitForWorker( &pipeline, &data, stalled ) )
+    {
+        printf( "%s: the worker did not catch up\n", name );
+        ok = 0;
+    }
+
+    /* the outputs of the calls which would have been played during the stall
+        are dropped */
+    PaUnixCallbackPipeline_Callback( NULL, output, FRAMES_PER_BUFFER, &timeInfo, 0, &pipeline );
+    if( !OutputIs( output, (float)(stalled - LOOKAHEAD + 1) ) )
+    {
+        printf( "%s: the first buffer after the stall holds %g\n", name, output[0] );
+        ok = 0;
+    }
+
+    if( !WaitForWorker( &pipeline, &data, stalled + 1 ) )
+        ok = 0;
+
+    PaUnixCallbackPipeline_Stop( &pipeline );
+    PaUnixCallbackPipeline_Terminate( &pipeline );
+
+    /* the request queued after the stall carries the underflow */
+    if( data.callCount <= stalled || !(data.statusFlags[stalled] & paOutputUnderflow) )
+    {
+        printf( "%s: the underflow was not reported\n", name );
+        ok = 0;
+    }
+    if( data.statusFlags[0] != 0 )
+    {
+        printf( "%s: the first call received status flags 0x%lx\n", name, data.statusFlags[0] );
+        ok = 0;
+    }
+
+    printf( "%s: %s\n", name, ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+int main( void )
+{
+    int failures = 0;
+
+    printf( "patest_callback_pipeline: lookahead %d, %d frames per buffer\n", LOOKAHEAD, FRAMES_PER_BUFFER );
+
+    if( PaUnixCallbackPipeline_GetLookahead( 0 ) != PA_UNIX_DEFAULT_PIPELINE_LOOKAHEAD
+            || PaUnixCallbackPipeline_GetLookahead( paPipelineCallback | paPipelineLookahead(5) ) != 5 )
+    {
+        printf( "lookahead flags: FAILED\n" );
+        ++failures;
+    }
+
+    if( !TestPipeline( "output only", 0 ) )
+        ++failures;
+    if( !TestPipeline( "full duplex", 1 ) )
+        ++failures;
+    if( !TestUnderflow() )
+        ++failures;
+
+    printf( "%d failures\n", failures );
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,296 @@
+/** @file patest_channel_groups.c
+    @ingroup test_src
+    @brief Verify that a buffer processor with a channel group callback calls
+    it once per group and user buffer with the right channels, whatever the
+    number of threads, that the group results are combined into the stream
+    callback result, and that clearing the group callback brings back the
+    stream callback.
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_process.h"
+
+#define INPUT_CHANNELS      (40)
+#define OUTPUT_CHANNELS     (36)
+#define CHANNELS_PER_GROUP  (8)
+#define GROUP_COUNT         (5)
+#define USER_FRAMES         (64)
+#define HOST_FRAMES         (128)
+#define HOST_BUFFERS        (4)
+
+typedef struct
+{
+    unsigned long callCounts[GROUP_COUNT];  /* each group only writes its own entries */
+    int groupIsCorrect[GROUP_COUNT];
+    int results[GROUP_COUNT];               /* returned by each group */
+    unsigned long streamCallbackCount;
+}
+TestData;
+
+static float InputSample( int channel, unsigned long frame )
+{
+    return (float)(channel * 1000 + (int)(frame % HOST_FRAMES));
+}
+
+/* Writes twice the input of each channel to the output channel with the
+    same number, or the negative channel number where there is no input. */
+static int GroupCallback( const PaStreamChannelGroup *group, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    TestData *data = (TestData*)userData;
+    unsigned int g = group->groupIndex;
+    int expectedInputs, expectedOutputs, c;
+    unsigned long i;
+
+    (void) timeInfo; /* Prevent unused variable warnings. */
+    (void) statusFlags;
+
+    if( g >= GROUP_COUNT )
+        return paAbort;
+
+    expectedInputs = INPUT_CHANNELS - (int)g * CHANNELS_PER_GROUP;
+    expectedInputs = expectedInputs < 0 ? 0 : (expectedInputs > CHANNELS_PER_GROUP ? CHANNELS_PER_GROUP : expectedInputs);
+    expectedOutputs = OUTPUT_CHANNELS - (int)g * CHANNELS_PER_GROUP;
+    expectedOutputs = expectedOutputs < 0 ? 0 : (expectedOutputs > CHANNELS_PER_GROUP ? CHANNELS_PER_GROUP : expectedOutputs);
+
+    if( frameCount != USER_FRAMES
+            || group->firstInputChannel != (int)g * CHANNELS_PER_GROUP
+            || group->firstOutputChannel != (int)g * CHANNELS_PER_GROUP
+            || group->inputChannelCount != expectedInputs
+            || group->outputChannelCount != expectedOutputs
+            || (group->input == NULL) != (expectedInputs == 0)
+            || (group->output == NULL) != (expectedOutputs == 0) )
+    {
+        data->groupIsCorrect[g] = 0;
+        return paAbort;
+    }
+
+    for( c=0; c < group->inputChannelCount; ++c )
+    {
+        const float *in = (const float*)group->input[c];
+        for( i=0; i < frameCount; ++i )
+        {
+            /* the frame within the host buffer is unknown, only check the channel */
+            if( (int)in[i] / 1000 != group->firstInputChannel + c )
+                data->groupIsCorrect[g] = 0;
+        }
+    }
+
+    for( c=0; c < group->outputChannelCount; ++c )
+    {
+        float *out = (float*)group->output[c];
+        for( i=0; i < frameCount; ++i )
+        {
+            out[i] = c < group->inputChannelCount
+                    ? 2.f * ((const float*)group->input[c])[i]
+                    : -(float)(group->firstOutputChannel + c);
+        }
+    }
+
+    ++data->callCounts[g];
+    return data->results[g];
+}
+
+static int StreamCallback( const void *input, void *output, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    TestData *data = (TestData*)userData;
+
+    (void) input; /* Prevent unused variable warnings. */
+    (void) output;
+    (void) frameCount;
+    (void) timeInfo;
+    (void) statusFlags;
+
+    ++data->streamCallbackCount;
+    return paContinue;
+}
+
+/* Runs HOST_BUFFERS interleaved full duplex host buffers through a buffer
+    processor, returning the last callback result. */
+static int ProcessHostBuffers( PaUtilBufferProcessor *bp, float *hostOutput )
+{
+    static float hostInput[ HOST_FRAMES * INPUT_CHANNELS ];
+    PaStreamCallbackTimeInfo timeInfo;
+    int callbackResult = paContinue;
+    unsigned long i;
+    int b, c;
+
+    for( i=0; i < HOST_FRAMES; ++i )
+    {
+        for( c=0; c < INPUT_CHANNELS; ++c )
+            hostInput[ i * INPUT_CHANNELS + c ] = InputSample( c, i );
+    }
+
+    memset( &timeInfo, 0, sizeof(timeInfo) );
+    for( b=0; b < HOST_BUFFERS && callbackResult == paContinue; ++b )
+    {
+        memset( hostOutput, 0, sizeof(float) * HOST_FRAMES * OUTPUT_CHANNELS );
+
+        PaUtil_BeginBufferProcessing( bp, &timeInfo, 0 );
+        PaUtil_SetInputFrameCount( bp, HOST_FRAMES );
+        PaUtil_SetOutputFrameCount( bp, HOST_FRAMES );
+        PaUtil_SetInterleavedInputChannels( bp, 0, hostInput, INPUT_CHANNELS );
+        PaUtil_SetInterleavedOutputChannels( bp, 0, hostOutput, OUTPUT_CHANNELS );
+        PaUtil_EndBufferProcessing( bp, &callbackResult );
+    }
+
+    return callbackResult;
+}
+
+static int TestGroups( const char *name, unsigned int threadCount )
+{
+    static float hostOutput[ HOST_FRAMES * OUTPUT_CHANNELS ];
+    PaUtilBufferProcessor bp;
+    TestData data;
+    unsigned long i;
+    int c, g, ok = 1;
+
+    memset( &data, 0, sizeof(data) );
+    for( g=0; g < GROUP_COUNT; ++g )
+        data.groupIsCorrect[g] = 1;
+
+    if( PaUtil_InitializeBufferProcessor( &bp, INPUT_CHANNELS, paFloat32 | paNonInterleaved, paFloat32,
+            OUTPUT_CHANNELS, paFloat32 | paNonInterleaved, paFloat32,
+            44100., paNoFlag, USER_FRAMES, HOST_FRAMES,
+            paUtilFixedHostBufferSize, StreamCallback, &data ) != paNoError )
+    {
+        printf( "%s: PaUtil_InitializeBufferProcessor failed\n", name );
+        return 0;
+    }
+
+    if( PaUtil_SetBufferProcessorChannelGroupCallback( &bp, GroupCallback,
+            CHANNELS_PER_GROUP, threadCount ) != paNoError )
+    {
+        printf( "%s: PaUtil_SetBufferProcessorChannelGroupCallback failed\n", name );
+        PaUtil_TerminateBufferProcessor( &bp );
+        return 0;
+    }
+
+    if( ProcessHostBuffers( &bp, hostOutput ) != paContinue )
+    {
+        printf( "%s: the callback result is not paContinue\n", name );
+        ok = 0;
+    }
+
+    for( g=0; g < GROUP_COUNT; ++g )
+    {
+        if( data.callCounts[g] != HOST_BUFFERS * HOST_FRAMES / USER_FRAMES || !data.groupIsCorrect[g] )
+        {
+            printf( "%s: group %d was called %lu times%s\n", name, g, data.callCounts[g],
+                    data.groupIsCorrect[g] ? "" : " with the wrong channels" );
+            ok = 0;
+        }
+    }
+
+    for( i=0; i < HOST_FRAMES && ok; ++i )
+    {
+        for( c=0; c < OUTPUT_CHANNELS; ++c )
+        {
+            if( hostOutput[ i * OUTPUT_CHANNELS + c ] != 2.f * InputSample( c, i ) )
+            {
+                printf( "%s: frame %lu of output channel %d holds %g\n", name, i, c,
+                        hostOutput[ i * OUTPUT_CHANNELS + c ] );
+                ok = 0;
+                break;
+            }
+        }
+    }
+
+    if( data.streamCallbackCount != 0 )
+    {
+        printf( "%s: the stream callback was called\n", name );
+        ok = 0;
+    }
+
+    /* the results of the groups are combined */
+    data.results[3] = paComplete;
+    if( ProcessHostBuffers( &bp, hostOutput ) != paComplete )
+    {
+        printf( "%s: a completing group did not complete the stream\n", name );
+        ok = 0;
+    }
+    data.results[1] = paAbort;
+    if( ProcessHostBuffers( &bp, hostOutput ) != paAbort )
+    {
+        printf( "%s: an aborting group did not abort the stream\n", name );
+        ok = 0;
+    }
+
+    /* back to the stream callback */
+    PaUtil_SetBufferProcessorChannelGroupCallback( &bp, NULL, 0, 0 );
+    ProcessHostBuffers( &bp, hostOutput );
+    if( data.streamCallbackCount != HOST_BUFFERS * HOST_FRAMES / USER_FRAMES )
+    {
+        printf( "%s: the stream callback was called %lu times after the groups were cleared\n",
+                name, data.streamCallbackCount );
+        ok = 0;
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    printf( "%s: %s\n", name, ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+int main( void )
+{
+    int failures = 0;
+
+    printf( "patest_channel_groups: %d input and %d output channels in groups of %d\n",
+            INPUT_CHANNELS, OUTPUT_CHANNELS, CHANNELS_PER_GROUP );
+
+    if( !TestGroups( "one thread", 1 ) )
+        ++failures;
+    if( !TestGroups( "three threads", 3 ) )
+        ++failures;
+    if( !TestGroups( "one thread per processor", 0 ) )
+        ++failures;
+    if( !TestGroups( "more threads than groups", 16 ) )
+        ++failures;
+
+    printf( "%d failures\n", failures );
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,306 @@
+/** @file patest_channel_matrix.c
+    @ingroup test_src
+    @brief Verify that a buffer processor with an output channel matrix
+    copies, mixes and silences the host channels as the matrix says, for
+    interleaved and non-interleaved user buffers, that rows which mix are
+    refused for formats other than paFloat32, and that removing the matrix
+    brings back one user channel per host channel.
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_process.h"
+
+#define USER_CHANNELS       (6)     /* 5.1: L R C LFE Ls Rs */
+#define HOST_CHANNELS       (8)
+#define USER_FRAMES         (64)
+#define HOST_FRAMES         (160)   /* not a multiple of USER_FRAMES */
+#define HOST_BUFFERS        (4)
+#define GARBAGE             (1234)
+
+/* The host channels are L R C LFE Ls Rs, a stereo downmix, and one unused
+    channel. */
+static const float matrix_[ HOST_CHANNELS * USER_CHANNELS ] =
+{
+    1.f, 0.f, 0.f,    0.f, 0.f,    0.f,
+    0.f, 1.f, 0.f,    0.f, 0.f,    0.f,
+    0.f, 0.f, 1.f,    0.f, 0.f,    0.f,
+    0.f, 0.f, 0.f,    1.f, 0.f,    0.f,
+    0.f, 0.f, 0.f,    0.f, 1.f,    0.f,
+    0.f, 0.f, 0.f,    0.f, 0.f,    1.f,
+    .5f, 0.f, .25f, 0.f, .125f, 0.f,
+    0.f, 0.f, 0.f,    0.f, 0.f,    0.f
+};
+
+typedef struct
+{
+    int nonInterleaved;
+    int channelCount;       /* the channels the callback renders */
+    unsigned long frame;    /* of the user output */
+}
+CallbackData;
+
+static float UserSample( int channel, unsigned long frame )
+{
+    return (float)((channel + 1) * 1000 + (int)(frame % 1000)) / 16384.f;
+}
+
+static int StreamCallback( const void *input, void *output, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    CallbackData *data = (CallbackData*)userData;
+    unsigned long i;
+    int c;
+
+    (void) input; /* Prevent unused variable warnings. */
+    (void) timeInfo;
+    (void) statusFlags;
+
+    for( i=0; i < frameCount; ++i )
+    {
+        for( c=0; c < data->channelCount; ++c )
+        {
+            if( data->nonInterleaved )
+                ((float**)output)[c][i] = UserSample( c, data->frame + i );
+            else
+                ((float*)output)[ i * data->channelCount + c ] = UserSample( c, data->frame + i );
+        }
+    }
+    data->frame += frameCount;
+
+    return paContinue;
+}
+
+static float ExpectedSample( int hostChannel, unsigned long frame, int hasMatrix )
+{
+    const float *row = &matrix_[ hostChannel * USER_CHANNELS ];
+    float sum = 0.f;
+    int u;
+
+    if( !hasMatrix )
+        return UserSample( hostChannel, frame );
+
+    for( u=0; u < USER_CHANNELS; ++u )
+    {
+        if( row[u] != 0.f )
+            sum += row[u] * UserSample( u, frame );
+    }
+    return sum;
+}
+
+/* Runs HOST_BUFFERS output only host buffers through a buffer processor with
+    paFloat32 output, and compares them with the matrix, or with the user
+    channels when hasMatrix is zero. */
+static int CheckOutput( const char *name, PaUtilBufferProcessor *bp, CallbackData *data, int hasMatrix )
+{
+    static float hostOutput[ HOST_FRAMES * HOST_CHANNELS ];
+    PaStreamCallbackTimeInfo timeInfo;
+    int callbackResult = paContinue;
+    unsigned long i, frame = 0;
+    int b, c;
+
+    data->frame = 0;
+    memset( &timeInfo, 0, sizeof(timeInfo) );
+    for( b=0; b < HOST_BUFFERS; ++b )
+    {
+        for( i=0; i < HOST_FRAMES * HOST_CHANNELS; ++i )
+            hostOutput[i] = GARBAGE;
+
+        PaUtil_BeginBufferProcessing( bp, &timeInfo, 0 );
+        PaUtil_SetOutputFrameCount( bp, HOST_FRAMES );
+        PaUtil_SetInterleavedOutputChannels( bp, 0, hostOutput, HOST_CHANNELS );
+        PaUtil_EndBufferProcessing( bp, &callbackResult );
+
+        for( i=0; i < HOST_FRAMES; ++i, ++frame )
+        {
+            for( c=0; c < HOST_CHANNELS; ++c )
+            {
+                float expected = ExpectedSample( c, frame, hasMatrix );
+                float sample = hostOutput[ i * HOST_CHANNELS + c ];
+
+                if( sample < expected - 1e-6f || sample > expected + 1e-6f )
+                {
+                    printf( "%s: frame %lu of host channel %d holds %g instead of %g\n",
+                            name, frame, c, sample, expected );
+                    return 0;
+                }
+            }
+        }
+    }
+
+    return 1;
+}
+
+static int TestFloat32( const char *name, PaSampleFormat userFormat )
+{
+    PaUtilBufferProcessor bp;
+    CallbackData data;
+    int ok = 1;
+
+    memset( &data, 0, sizeof(data) );
+    data.nonInterleaved = (userFormat & paNonInterleaved) ? 1 : 0;
+    data.channelCount = USER_CHANNELS;
+
+    if( PaUtil_InitializeBufferProcessor( &bp, 0, 0, 0,
+            HOST_CHANNELS, userFormat, paFloat32,
+            44100., paNoFlag, USER_FRAMES, HOST_FRAMES,
+            paUtilUnknownHostBufferSize, StreamCallback, &data ) != paNoError )
+    {
+        printf( "%s: PaUtil_InitializeBufferProcessor failed\n", name );
+        return 0;
+    }
+
+    if( PaUtil_SetBufferProcessorOutputChannelMatrix( &bp, USER_CHANNELS, matrix_ ) != paNoError )
+    {
+        printf( "%s: PaUtil_SetBufferProcessorOutputChannelMatrix failed\n", name );
+        ok = 0;
+    }
+    else
+    {
+        ok = CheckOutput( name, &bp, &data, 1 );
+    }
+
+    /* back to one user channel per host channel */
+    if( ok )
+    {
+        PaUtil_SetBufferProcessorOutputChannelMatrix( &bp, 0, NULL );
+        PaUtil_ResetBufferProcessor( &bp );
+        data.channelCount = HOST_CHANNELS;
+        ok = CheckOutput( name, &bp, &data, 0 );
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    printf( "%s: %s\n", name, ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+/* Sparse maps work with any format, mixing only with paFloat32. */
+static int TestInt16( void )
+{
+    static const float stereoTo4[ 4 * 2 ] = { 1.f, 0.f,  0.f, 1.f,  0.f, 0.f,  0.f, 1.f };
+    static const float stereoTo4Mixed[ 4 * 2 ] = { 1.f, 0.f,  0.f, 1.f,  .5f, .5f,  0.f, 1.f };
+    static short hostOutput[ HOST_FRAMES * 4 ];
+    const char *name = "paInt16 sparse map";
+    PaUtilBufferProcessor bp;
+    unsigned long i;
+    int ok = 1;
+
+    if( PaUtil_InitializeBufferProcessor( &bp, 0, 0, 0,
+            4, paInt16, paInt16,
+            44100., paNoFlag, HOST_FRAMES, HOST_FRAMES,
+            paUtilFixedHostBufferSize, NULL, NULL ) != paNoError )
+    {
+        printf( "%s: PaUtil_InitializeBufferProcessor failed\n", name );
+        return 0;
+    }
+
+    if( PaUtil_SetBufferProcessorOutputChannelMatrix( &bp, 2, stereoTo4Mixed ) != paSampleFormatNotSupported )
+    {
+        printf( "%s: a mixing matrix was accepted\n", name );
+        ok = 0;
+    }
+    if( PaUtil_SetBufferProcessorOutputChannelMatrix( &bp, 2, stereoTo4 ) != paNoError )
+    {
+        printf( "%s: PaUtil_SetBufferProcessorOutputChannelMatrix failed\n", name );
+        ok = 0;
+    }
+
+    if( ok )
+    {
+        static short userOutput[ HOST_FRAMES * 2 ];
+        const void *source = userOutput;
+
+        for( i=0; i < HOST_FRAMES * 2; ++i )
+            userOutput[i] = (short)(i + 1);
+        for( i=0; i < HOST_FRAMES * 4; ++i )
+            hostOutput[i] = GARBAGE;
+
+        PaUtil_SetOutputFrameCount( &bp, HOST_FRAMES );
+        PaUtil_SetInterleavedOutputChannels( &bp, 0, hostOutput, 4 );
+        PaUtil_CopyOutput( &bp, &source, HOST_FRAMES );
+
+        for( i=0; i < HOST_FRAMES && ok; ++i )
+        {
+            if( hostOutput[ i * 4 ] != userOutput[ i * 2 ]
+                    || hostOutput[ i * 4 + 1 ] != userOutput[ i * 2 + 1 ]
+                    || hostOutput[ i * 4 + 2 ] != 0
+                    || hostOutput[ i * 4 + 3 ] != userOutput[ i * 2 + 1 ] )
+            {
+                printf( "%s: frame %lu holds %d %d %d %d\n", name, i, hostOutput[ i * 4 ],
+                        hostOutput[ i * 4 + 1 ], hostOutput[ i * 4 + 2 ], hostOutput[ i * 4 + 3 ] );
+                ok = 0;
+            }
+        }
+        if( ok && (const short*)source != userOutput + HOST_FRAMES * 2 )
+        {
+            printf( "%s: the source pointer was not advanced by 2 channels\n", name );
+            ok = 0;
+        }
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    printf( "%s: %s\n", name, ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+int main( void )
+{
+    int failures = 0;
+
+    printf( "patest_channel_matrix: %d user channels to %d host channels\n",
+            USER_CHANNELS, HOST_CHANNELS );
+
+    if( !TestFloat32( "interleaved paFloat32", paFloat32 ) )
+        ++failures;
+    if( !TestFloat32( "non-interleaved paFloat32", paFloat32 | paNonInterleaved ) )
+        ++failures;
+    if( !TestInt16() )
+        ++failures;
+
+    printf( "%d failures\n", failures );
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+/** @file patest_clip_statistics.c
+    @ingroup test_src
+    @brief Verify that the clipping converters count the samples they clip,
+    and that the buffer processor reports the counts through
+    PaUtil_ReadBufferProcessorClippedSampleCounts(), which backs
+    Pa_GetStreamStatistics().
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_process.h"
+#include "pa_dither.h"
+
+#define SAMPLE_COUNT        (1000)
+#define CLIP_INTERVAL       (7) /* every 7th sample is out of range */
+#define CHANNEL_COUNT       (2)
+#define HOST_FRAMES         (256)
+#define HOST_BUFFER_COUNT   (4)
+
+static const struct { PaSampleFormat format; const char *name; } destinations_[] = {
+    { paInt32, "Int32" },
+    { paInt24, "Int24" },
+    { paInt24In32, "Int24In32" },
+    { paInt16, "Int16" },
+    { paInt8, "Int8" },
+    { paUInt8, "UInt8" }
+};
+
+static const struct { PaStreamFlags flags; const char *name; int clips; } flags_[] = {
+    { paNoFlag, "default", 1 },
+    { paDitherOff, "paDitherOff", 1 },
+    { paNoiseShapedDither, "paNoiseShapedDither", 1 },
+    { paClipOff, "paClipOff", 0 },
+    { paClipOff | paDitherOff, "paClipOff|paDitherOff", 0 }
+};
+
+/* in range samples stay well inside full scale, so that dither can't clip
+    them. Returns the number of out of range samples. */
+static unsigned long GenerateSignal( float *buffer, int count )
+{
+    unsigned long clipped = 0;
+    int i;
+
+    for( i=0; i < count; ++i )
+    {
+        if( (i % CLIP_INTERVAL) == 0 )
+        {
+            buffer[i] = ( i & 1 ) ? -1.5f : 1.5f;
+            ++clipped;
+        }
+        else
+        {
+            buffer[i] = .9f * (float)((i * 37) % 200 - 100) / 100.f;
+        }
+    }
+
+    return clipped;
+}
+
+static int TestConverters( const char *tableName )
+{
+    static float source[ SAMPLE_COUNT ];
+    static double source64[ SAMPLE_COUNT ];
+    static double destination[ SAMPLE_COUNT ]; /* large enough for any format */
+    PaUtilTriangularDitherGenerator ditherState;
+    unsigned long expected = GenerateSignal( source, SAMPLE_COUNT );
+    int d, f, i, ok = 1;
+
+    for( i=0; i < SAMPLE_COUNT; ++i )
+        source64[i] = source[i];
+
+    for( d=0; d < (int)(sizeof(destinations_) / sizeof(destinations_[0])); ++d )
+    {
+        for( f=0; f < (int)(sizeof(flags_) / sizeof(flags_[0])); ++f )
+        {
+            PaUtilConverter *converter = PaUtil_SelectConverter( paFloat32,
+                    destinations_[d].format, flags_[f].flags );
+            PaUtilConverter *converter64 = PaUtil_SelectConverter( paFloat64,
+                    destinations_[d].format, flags_[f].flags );
+            unsigned long wanted = flags_[f].clips ? expected : 0;
+            unsigned long counted, counted64;
+
+            PaUtil_InitializeTriangularDitherState( &ditherState );
+            converter( destination, 1, source, 1, SAMPLE_COUNT, &ditherState );
+            counted = ditherState.clippedSampleCount;
+
+            PaUtil_InitializeTriangularDitherState( &ditherState );
+            converter64( destination, 1, source64, 1, SAMPLE_COUNT, &ditherState );
+            counted64 = ditherState.clippedSampleCount;
+
+            if( counted != wanted || counted64 != wanted )
+            {
+                printf( "%s Float32/Float64 to %s, %s: counted %lu/%lu clipped samples, expected %lu\n",
+                        tableName, destinations_[d].name, flags_[f].name, counted, counted64, wanted );
+                ok = 0;
+            }
+        }
+    }
+
+    printf( "%s converter clip counts: %s\n", tableName, ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+typedef struct
+{
+    const float *signal;
+    unsigned long framesPlayed;
+}
+StreamData;
+
+static int StreamCallback( const void *input, void *output, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    StreamData *data = (StreamData*)userData;
+    float *out = (float*)output;
+    unsigned long f;
+    int c;
+
+    (void) input; /* Prevent unused variable warnings. */
+    (void) timeInfo;
+    (void) statusFlags;
+
+    for( f=0; f < frameCount; ++f )
+    {
+        for( c=0; c < CHANNEL_COUNT; ++c )
+            *out++ = data->signal[ ((data->framesPlayed + f) * CHANNEL_COUNT + c) % SAMPLE_COUNT ];
+    }
+
+    data->framesPlayed += frameCount;
+
+    return paContinue;
+}
+
+static int TestBufferProcessor( void )
+{
+    static float signal[ SAMPLE_COUNT ];
+    static float hostInput[ HOST_FRAMES * CHANNEL_COUNT ];
+    static PaInt16 hostOutput[ HOST_FRAMES * CHANNEL_COUNT ];
+    PaUtilBufferProcessor bp;
+    PaStreamCallbackTimeInfo timeInfo;
+    StreamData data;
+    unsigned long expectedInput = 0, expectedOutput = 0, inputClipped, outputClipped;
+    int callbackResult = paContinue;
+    int b, i, ok = 1;
+
+    GenerateSignal( signal, SAMPLE_COUNT );
+    data.signal = signal;
+    data.framesPlayed = 0;
+
+    /* host input is float and user input Int16, so the input converter clips too */
+    if( PaUtil_InitializeBufferProcessor( &bp, CHANNEL_COUNT, paInt16, paFloat32,
+            CHANNEL_COUNT, paFloat32, paInt16,
+            44100., paNoFlag, HOST_FRAMES, HOST_FRAMES,
+            paUtilFixedHostBufferSize, StreamCallback, &data ) != paNoError )
+    {
+        printf( "PaUtil_InitializeBufferProcessor failed\n" );
+        return 0;
+    }
+
+    for( b=0; b < HOST_BUFFER_COUNT; ++b )
+    {
+        for( i=0; i < HOST_FRAMES * CHANNEL_COUNT; ++i )
+        {
+            int sample = (b * HOST_FRAMES * CHANNEL_COUNT + i) % SAMPLE_COUNT;
+            hostInput[i] = signal[ sample ];
+            if( (sample % CLIP_INTERVAL) == 0 )
+            {
+                ++expectedInput;
+                ++expectedOutput;
+            }
+        }
+
+        memset( &timeInfo, 0, sizeof(timeInfo) );
+        PaUtil_BeginBufferProcessing( &bp, &timeInfo, 0 );
+        PaUtil_SetInputFrameCount( &bp, HOST_FRAMES );
+        PaUtil_SetInterleavedInputChannels( &bp, 0, hostInput, CHANNEL_COUNT );
+        PaUtil_SetOutputFrameCount( &bp, HOST_FRAMES );
+        PaUtil_SetInterleavedOutputChannels( &bp, 0, hostOutput, CHANNEL_COUNT );
+        PaUtil_EndBufferProcessing( &bp, &callbackResult );
+
+        if( b == 1 )
+        {
+            /* reading resets the counts */
+            PaUtil_ReadBufferProcessorClippedSampleCounts( &bp, &inputClipped, &outputClipped );
+            if( inputClipped != expectedInput || outputClipped != expectedOutput )
+            {
+                printf( "after %d buffers: counted %lu input and %lu output clipped samples, expected %lu and %lu\n",
+                        b + 1, inputClipped, outputClipped, expectedInput, expectedOutput );
+                ok = 0;
+            }
+            expectedInput = 0;
+            expectedOutput = 0;
+        }
+    }
+
+    PaUtil_ReadBufferProcessorClippedSampleCounts( &bp, &inputClipped, &outputClipped );
+    if( inputClipped != expectedInput || outputClipped != expectedOutput )
+    {
+        printf( "at the end: counted %lu input and %lu output clipped samples, expected %lu and %lu\n",
+                inputClipped, outputClipped, expectedInput, expectedOutput );
+        ok = 0;
+    }
+
+    PaUtil_ReadBufferProcessorClippedSampleCounts( &bp, &inputClipped, &outputClipped );
+    if( inputClipped != 0 || outputClipped != 0 )
+    {
+        printf( "counts were not reset by reading them\n" );
+        ok = 0;
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    printf( "buffer processor clip counts: %s\n", ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+int main( void )
+{
+    int failures = 0;
+
+    /* the converter table initially holds the reference converters,
+        PaUtil_InitializeConverters() substitutes the SIMD ones */
+    if( !TestConverters( "reference" ) )
+        ++failures;
+    PaUtil_InitializeConverters();
+    if( !TestConverters( "SIMD" ) )
+        ++failures;
+    if( !TestBufferProcessor() )
+        ++failures;
+
+    printf( "%d failures\n", failures );
+
+    return (failures == 0) ? 0 : 1;
+}
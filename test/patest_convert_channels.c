@@ -0,0 +1,285 @@
+/** @file patest_convert_channels.c
+    @ingroup test_src
+    @brief Verify PaUtil_ConvertChannels() and compare its speed with
+    converting one channel at a time.
+
+    PaUtil_ConvertChannels() is first checked against calling the converter
+    for each channel over the whole buffer, for every combination of
+    interleaved and non-interleaved source and destination. Then both ways of
+    converting are timed for 2, 8, 64 and 256 channels with small buffers.
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_interleave.h"
+#include "pa_process.h"
+#include "pa_dither.h"
+#include "pa_util.h"
+
+#define MAX_CHANNELS        (256)
+#define EXTRA_STRIDE        (2)
+#define MAX_FRAMES          (300)
+#define MAX_BYTES           (MAX_FRAMES * (MAX_CHANNELS + EXTRA_STRIDE) * 4)
+
+#define BENCHMARK_FRAMES    (256)
+#define BENCHMARK_SAMPLES   (4000000) /* samples converted per measurement */
+
+typedef struct
+{
+    PaSampleFormat source, destination;
+    int sourceIsInterleaved, destinationIsInterleaved;
+} Layout;
+
+/* host to user for input, user to host for output */
+static const Layout layouts_[] = {
+    { paInt16, paFloat32, 1, 1 },  /* interleaved host, interleaved user */
+    { paInt32, paFloat32, 1, 0 },  /* interleaved host, non-interleaved user */
+    { paInt32, paInt32, 1, 0 },  /* interleaved host, non-interleaved user */
+    { paFloat32, paInt32, 0, 1 },  /* non-interleaved user, interleaved host */
+    { paFloat32, paInt16, 1, 0 },  /* interleaved user, non-interleaved host */
+    { paFloat32, paInt16, 1, 1 },  /* interleaved user, interleaved host */
+    { paFloat32, paFloat32, 0, 1 },  /* non-interleaved host, interleaved user */
+    { paInt24, paFloat32, 0, 0 }   /* non-interleaved host, non-interleaved user */
+};
+
+#define LAYOUT_COUNT ((int)(sizeof(layouts_) / sizeof(layouts_[0])))
+
+static unsigned char source_[ MAX_BYTES ];
+static unsigned char expected_[ MAX_BYTES ];
+static unsigned char actual_[ MAX_BYTES ];
+static PaUtilChannelDescriptor sourceChannels_[ MAX_CHANNELS ];
+static PaUtilChannelDescriptor destinationChannels_[ MAX_CHANNELS ];
+
+static void GenerateSamples( void *buffer, int count, PaSampleFormat format )
+{
+    unsigned long seed = 22222;
+    int i;
+
+    for( i=0; i < count * Pa_GetSampleSize( format ); ++i )
+    {
+        seed = (seed * 196314165) + 907633515;
+        if( format == paFloat32 && (i % 4) == 0 )
+            ((float*)buffer)[i / 4] = ((float)((seed >> 8) & 0xFFFF) / 32768.f) - 1.f;
+        else if( format != paFloat32 )
+            ((unsigned char*)buffer)[i] = (unsigned char)(seed >> 16);
+    }
+}
+
+/* describe channelCount channels of buffer, interleaved with a frame stride
+    of frameStride samples or non-interleaved with one channel after another */
+static void SetChannels( PaUtilChannelDescriptor *channels, void *buffer, int isInterleaved,
+        int channelCount, int frameStride, int bytesPerSample )
+{
+    int i;
+
+    for( i=0; i < channelCount; ++i )
+    {
+        if( isInterleaved )
+        {
+            channels[i].data = (unsigned char*)buffer + i * bytesPerSample;
+            channels[i].stride = frameStride;
+        }
+        else
+        {
+            channels[i].data = (unsigned char*)buffer + i * MAX_FRAMES * bytesPerSample;
+            channels[i].stride = 1;
+        }
+    }
+}
+
+static void ConvertEachChannel( PaUtilConverter *converter,
+        PaUtilChannelDescriptor *destinationChannels, PaUtilChannelDescriptor *sourceChannels,
+        int channelCount, int frameCount, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    int i;
+
+    for( i=0; i < channelCount; ++i )
+    {
+        converter( destinationChannels[i].data, destinationChannels[i].stride,
+                sourceChannels[i].data, sourceChannels[i].stride, frameCount, ditherGenerator );
+    }
+}
+
+/* with dithering converters the output must be identical too, as the order
+    in which the dither generator is consumed shapes the dither's spectrum */
+static int TestConvertChannels( PaStreamFlags flags )
+{
+    static const int channelCounts[] = { 1, 2, 7, 8, 20, MAX_CHANNELS };
+    static const int frameCounts[] = { 0, 1, 63, 64, 65, MAX_FRAMES };
+    PaUtilTriangularDitherGenerator dither;
+    int i, j, k, extraStride, failures = 0;
+
+    for( i=0; i < LAYOUT_COUNT; ++i )
+    {
+        const Layout *layout = &layouts_[i];
+        PaUtilConverter *converter = PaUtil_SelectConverter( layout->source, layout->destination, flags );
+        int sourceBytes = Pa_GetSampleSize( layout->source );
+        int destinationBytes = Pa_GetSampleSize( layout->destination );
+        int ok = 1;
+
+        GenerateSamples( source_, MAX_FRAMES * (MAX_CHANNELS + EXTRA_STRIDE), layout->source );
+
+        for( j=0; j < (int)(sizeof(channelCounts) / sizeof(channelCounts[0])); ++j )
+        {
+            for( extraStride=0; extraStride <= EXTRA_STRIDE; extraStride += EXTRA_STRIDE )
+            {
+                int channelCount = channelCounts[j];
+                int frameStride = channelCount + extraStride;
+
+                for( k=0; k < (int)(sizeof(frameCounts) / sizeof(frameCounts[0])); ++k )
+                {
+                    SetChannels( sourceChannels_, source_, layout->sourceIsInterleaved,
+                            channelCount, frameStride, sourceBytes );
+
+                    memset( expected_, 0xA5, sizeof(expected_) );
+                    SetChannels( destinationChannels_, expected_, layout->destinationIsInterleaved,
+                            channelCount, frameStride, destinationBytes );
+                    PaUtil_InitializeTriangularDitherState( &dither );
+                    ConvertEachChannel( converter, destinationChannels_, sourceChannels_,
+                            channelCount, frameCounts[k], &dither );
+
+                    memset( actual_, 0xA5, sizeof(actual_) );
+                    SetChannels( destinationChannels_, actual_, layout->destinationIsInterleaved,
+                            channelCount, frameStride, destinationBytes );
+                    PaUtil_InitializeTriangularDitherState( &dither );
+                    PaUtil_ConvertChannels( (layout->source == layout->destination) ? NULL : converter,
+                            destinationChannels_, destinationBytes, sourceChannels_, sourceBytes,
+                            channelCount, frameCounts[k], &dither );
+
+                    if( memcmp( expected_, actual_, sizeof(expected_) ) != 0 )
+                        ok = 0;
+                }
+            }
+        }
+
+        printf( "0x%02lX %-15s to 0x%02lX %-15s %-9s: %s\n",
+                (unsigned long)layout->source, layout->sourceIsInterleaved ? "interleaved" : "non-interleaved",
+                (unsigned long)layout->destination, layout->destinationIsInterleaved ? "interleaved" : "non-interleaved",
+                (flags & paDitherOff) ? "" : "dithered", ok ? "PASSED" : "FAILED" );
+        if( !ok )
+            ++failures;
+    }
+
+    return failures;
+}
+
+static void Benchmark( void )
+{
+    static const int channelCounts[] = { 2, 8, 64, MAX_CHANNELS };
+    PaUtilTriangularDitherGenerator dither;
+    int i, j, n;
+
+    printf( "\nnanoseconds per sample, %d frame buffers\n", BENCHMARK_FRAMES );
+    printf( "%-45s %8s %10s %10s %8s\n", "layout", "channels", "per chan.", "all chan.", "speedup" );
+
+    for( i=0; i < LAYOUT_COUNT; ++i )
+    {
+        const Layout *layout = &layouts_[i];
+        PaUtilConverter *converter = PaUtil_SelectConverter( layout->source, layout->destination,
+                paClipOff | paDitherOff );
+        int sourceBytes = Pa_GetSampleSize( layout->source );
+        int destinationBytes = Pa_GetSampleSize( layout->destination );
+
+        GenerateSamples( source_, MAX_FRAMES * (MAX_CHANNELS + EXTRA_STRIDE), layout->source );
+
+        for( j=0; j < (int)(sizeof(channelCounts) / sizeof(channelCounts[0])); ++j )
+        {
+            int channelCount = channelCounts[j];
+            int iterations = BENCHMARK_SAMPLES / (channelCount * BENCHMARK_FRAMES);
+            double start, eachChannel, allChannels;
+            char name[64];
+
+            SetChannels( sourceChannels_, source_, layout->sourceIsInterleaved,
+                    channelCount, channelCount, sourceBytes );
+            SetChannels( destinationChannels_, actual_, layout->destinationIsInterleaved,
+                    channelCount, channelCount, destinationBytes );
+            PaUtil_InitializeTriangularDitherState( &dither );
+
+            start = PaUtil_GetTime();
+            for( n=0; n < iterations; ++n )
+            {
+                ConvertEachChannel( converter, destinationChannels_, sourceChannels_,
+                        channelCount, BENCHMARK_FRAMES, &dither );
+            }
+            eachChannel = PaUtil_GetTime() - start;
+
+            start = PaUtil_GetTime();
+            for( n=0; n < iterations; ++n )
+            {
+                PaUtil_ConvertChannels( (layout->source == layout->destination) ? NULL : converter,
+                        destinationChannels_, destinationBytes, sourceChannels_, sourceBytes,
+                        channelCount, BENCHMARK_FRAMES, &dither );
+            }
+            allChannels = PaUtil_GetTime() - start;
+
+            sprintf( name, "0x%02lX %s to 0x%02lX %s", (unsigned long)layout->source,
+                    layout->sourceIsInterleaved ? "int." : "non-int.", (unsigned long)layout->destination,
+                    layout->destinationIsInterleaved ? "int." : "non-int." );
+            printf( "%-45s %8d %10.3f %10.3f %7.2fx\n", name, channelCount,
+                    eachChannel * 1e9 / ((double)iterations * channelCount * BENCHMARK_FRAMES),
+                    allChannels * 1e9 / ((double)iterations * channelCount * BENCHMARK_FRAMES),
+                    (allChannels > 0.) ? eachChannel / allChannels : 0. );
+        }
+    }
+}
+
+/*******************************************************************/
+
+int main( void )
+{
+    int failures;
+
+    PaUtil_InitializeClock();
+    PaUtil_InitializeConverters(); /* use the fastest converters, as Pa_Initialize() would */
+
+    failures = TestConvertChannels( paClipOff | paDitherOff );
+    failures += TestConvertChannels( paClipOff );
+    Benchmark();
+
+    printf( "%d failures\n", failures );
+
+    return (failures == 0) ? 0 : 1;
+}
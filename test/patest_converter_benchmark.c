@@ -0,0 +1,472 @@
+/** @file patest_converter_benchmark.c
+    @ingroup test_src
+    @brief Measure the throughput of the sample converters and zeroers.
+
+    Every converter returned by PaUtil_SelectConverter() for the standard
+    sample formats and stream flags, and every zeroer returned by
+    PaUtil_SelectZeroer(), is timed for strides of 1, 2 and N samples and for
+    buffers of 16 to 8192 frames. Flag combinations which select the same
+    converter as an earlier combination for the same formats are measured
+    only once. Results are printed in samples per nanosecond as CSV or JSON.
+
+    Usage:
+    @code
+    patest_converter_benchmark [--json] [--reference] [--stride N] [--quick] > run.csv
+    patest_converter_benchmark --compare old.csv new.csv [--threshold 0.1]
+    @endcode
+
+    --reference measures the converters in pa_converters.c instead of the
+    SIMD converters which Pa_Initialize() would substitute. --compare reads
+    two CSV files produced by this program and lists every measurement which
+    is slower in the second file by more than the threshold (a fraction,
+    default 0.1). It returns 1 if it found any regressions.
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_dither.h"
+#include "pa_util.h"
+
+#ifndef M_PI
+#define M_PI  (3.14159265)
+#endif
+
+#define MIN_FRAME_COUNT     (16)
+#define MAX_FRAME_COUNT     (8192)
+#define DEFAULT_STRIDE      (8)
+#define MAX_STRIDE          (64)
+#define MAX_SAMPLE_SIZE     (8)
+
+#define MINIMUM_DURATION    (0.002) /* seconds per timing run */
+#define QUICK_DURATION      (0.0002)
+#define RUN_COUNT           (3)     /* the fastest run is reported */
+
+#define MAX_NAME_LENGTH     (32)
+
+static const struct { PaSampleFormat format; const char *name; } formats_[] = {
+    { paFloat64, "Float64" },
+    { paFloat32, "Float32" },
+    { paInt32, "Int32" },
+    { paInt24In32, "Int24In32" },
+    { paInt24, "Int24" },
+    { paInt16, "Int16" },
+    { paInt8, "Int8" },
+    { paUInt8, "UInt8" }
+};
+
+#define FORMAT_COUNT ((int)(sizeof(formats_) / sizeof(formats_[0])))
+
+static const struct { PaStreamFlags flags; const char *name; } flags_[] = {
+    { paNoFlag, "default" },
+    { paClipOff, "ClipOff" },
+    { paDitherOff, "DitherOff" },
+    { paClipOff | paDitherOff, "ClipOff|DitherOff" },
+    { paNoiseShapedDither, "NoiseShapedDither" }
+};
+
+#define FLAG_COUNT ((int)(sizeof(flags_) / sizeof(flags_[0])))
+
+typedef struct
+{
+    char kind[MAX_NAME_LENGTH];
+    char source[MAX_NAME_LENGTH];
+    char destination[MAX_NAME_LENGTH];
+    char flags[MAX_NAME_LENGTH];
+    int stride;
+    unsigned int frames;
+    double samplesPerNs;
+} Measurement;
+
+static double minimumDuration_ = MINIMUM_DURATION;
+static int json_ = 0;
+static int measurementCount_ = 0;
+
+/* -------------------------------------------------------------------------- */
+
+static void PrintMeasurement( const Measurement *m )
+{
+    if( json_ )
+    {
+        printf( "%s\n  { \"kind\": \"%s\", \"source\": \"%s\", \"destination\": \"%s\", "
+                "\"flags\": \"%s\", \"stride\": %d, \"frames\": %u, \"samplesPerNs\": %.6f }",
+                (measurementCount_ == 0) ? "" : ",", m->kind, m->source, m->destination,
+                m->flags, m->stride, m->frames, m->samplesPerNs );
+    }
+    else
+    {
+        printf( "%s,%s,%s,%s,%d,%u,%.6f\n", m->kind, m->source, m->destination,
+                m->flags, m->stride, m->frames, m->samplesPerNs );
+    }
+    ++measurementCount_;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Fill buffer with a sine wave in format, which is valid input for every
+    converter, including those which don't clip. */
+static void GenerateSource( void *buffer, PaSampleFormat format, unsigned int count )
+{
+    double *sine = (double*)malloc( count * sizeof(double) );
+    PaUtilTriangularDitherGenerator ditherGenerator;
+    PaUtilConverter *converter;
+    unsigned int i;
+
+    for( i=0; i < count; ++i )
+        sine[i] = .9 * sin( ((double)i / 441.) * 2. * M_PI );
+
+    PaUtil_InitializeTriangularDitherState( &ditherGenerator );
+    if( format == paFloat64 )
+        memcpy( buffer, sine, count * sizeof(double) );
+    else if( (converter = PaUtil_SelectConverter( paFloat64, format, paDitherOff )) != NULL )
+        converter( buffer, 1, sine, 1, count, &ditherGenerator );
+
+    free( sine );
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Return the best throughput of RUN_COUNT runs in samples per nanosecond.
+    Either converter or zeroer is non-NULL. */
+static double Measure( PaUtilConverter *converter, PaUtilZeroer *zeroer,
+        void *destination, void *source, int stride, unsigned int frames )
+{
+    PaUtilTriangularDitherGenerator ditherGenerator;
+    double best = 0., start, elapsed;
+    unsigned long iterations = 1, n;
+    int run;
+
+    PaUtil_InitializeTriangularDitherState( &ditherGenerator );
+
+    for( run=0; run < RUN_COUNT; ++run )
+    {
+        do
+        {
+            start = PaUtil_GetTime();
+            for( n=0; n < iterations; ++n )
+            {
+                if( converter )
+                    converter( destination, stride, source, stride, frames, &ditherGenerator );
+                else
+                    zeroer( destination, stride, frames );
+            }
+            elapsed = PaUtil_GetTime() - start;
+
+            if( elapsed < minimumDuration_ )
+                iterations *= 2; /* too short to be timed reliably, try again */
+
+        }while( elapsed < minimumDuration_ );
+
+        if( (double)frames * iterations / (elapsed * 1e9) > best )
+            best = (double)frames * iterations / (elapsed * 1e9);
+    }
+
+    return best;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void RunBenchmark( int n, int quick )
+{
+    static const unsigned int quickFrameCounts[] = { MIN_FRAME_COUNT, 256, MAX_FRAME_COUNT };
+    size_t bufferSize = (size_t)MAX_FRAME_COUNT * ((n > 2) ? n : 2) * MAX_SAMPLE_SIZE;
+    void *source = malloc( bufferSize );
+    void *destination = malloc( bufferSize );
+    int strides[3];
+    int s, f, i, j, k, strideCount;
+    unsigned int frames;
+    Measurement m;
+
+    strides[0] = 1;
+    strides[1] = 2;
+    strides[2] = n;
+    strideCount = (n > 2) ? 3 : 2;
+
+    memset( destination, 0, bufferSize );
+
+    if( json_ )
+        printf( "[" );
+    else
+        printf( "kind,source,destination,flags,stride,frames,samplesPerNs\n" );
+
+    for( i=0; i < FORMAT_COUNT; ++i )
+    {
+        for( j=0; j < FORMAT_COUNT; ++j )
+        {
+            PaUtilConverter *measured[FLAG_COUNT];
+
+            for( k=0; k < FLAG_COUNT; ++k )
+            {
+                PaUtilConverter *converter = PaUtil_SelectConverter(
+                        formats_[i].format, formats_[j].format, flags_[k].flags );
+                int l;
+
+                measured[k] = converter;
+                for( l=0; l < k; ++l )
+                {
+                    if( measured[l] == converter )
+                        converter = NULL; /* already measured with other flags */
+                }
+                if( converter == NULL )
+                    continue;
+
+                for( s=0; s < strideCount; ++s )
+                {
+                    GenerateSource( source, formats_[i].format, MAX_FRAME_COUNT * strides[s] );
+
+                    for( f=0; quick ? f < 3 : (MIN_FRAME_COUNT << f) <= MAX_FRAME_COUNT; ++f )
+                    {
+                        frames = quick ? quickFrameCounts[f] : (unsigned int)(MIN_FRAME_COUNT << f);
+
+                        strcpy( m.kind, "converter" );
+                        strcpy( m.source, formats_[i].name );
+                        strcpy( m.destination, formats_[j].name );
+                        strcpy( m.flags, flags_[k].name );
+                        m.stride = strides[s];
+                        m.frames = frames;
+                        m.samplesPerNs = Measure( converter, NULL, destination, source, strides[s], frames );
+                        PrintMeasurement( &m );
+                    }
+                }
+            }
+        }
+    }
+
+    for( j=0; j < FORMAT_COUNT; ++j )
+    {
+        PaUtilZeroer *zeroer = PaUtil_SelectZeroer( formats_[j].format );
+
+        if( zeroer == NULL )
+            continue;
+
+        for( s=0; s < strideCount; ++s )
+        {
+            for( f=0; quick ? f < 3 : (MIN_FRAME_COUNT << f) <= MAX_FRAME_COUNT; ++f )
+            {
+                frames = quick ? quickFrameCounts[f] : (unsigned int)(MIN_FRAME_COUNT << f);
+
+                strcpy( m.kind, "zeroer" );
+                strcpy( m.source, "-" );
+                strcpy( m.destination, formats_[j].name );
+                strcpy( m.flags, "-" );
+                m.stride = strides[s];
+                m.frames = frames;
+                m.samplesPerNs = Measure( NULL, zeroer, destination, NULL, strides[s], frames );
+                PrintMeasurement( &m );
+            }
+        }
+    }
+
+    if( json_ )
+        printf( "\n]\n" );
+
+    free( source );
+    free( destination );
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Read the measurements from a CSV file written by RunBenchmark(). Returns
+    the number of measurements, or -1 if the file could not be read. */
+static int ReadMeasurements( const char *fileName, Measurement **result )
+{
+    FILE *file = fopen( fileName, "r" );
+    char line[256];
+    int count = 0, capacity = 0;
+    Measurement m, *measurements = NULL;
+
+    if( file == NULL )
+    {
+        fprintf( stderr, "can't open %s\n", fileName );
+        return -1;
+    }
+
+    while( fgets( line, sizeof(line), file ) != NULL )
+    {
+        if( sscanf( line, "%31[^,],%31[^,],%31[^,],%31[^,],%d,%u,%lf", m.kind, m.source,
+                m.destination, m.flags, &m.stride, &m.frames, &m.samplesPerNs ) != 7 )
+            continue; /* header */
+
+        if( count == capacity )
+        {
+            Measurement *grown;
+
+            capacity = capacity ? capacity * 2 : 1024;
+            grown = (Measurement*)realloc( measurements, capacity * sizeof(Measurement) );
+            if( grown == NULL )
+            {
+                free( measurements );
+                fclose( file );
+                return -1;
+            }
+            measurements = grown;
+        }
+        measurements[count++] = m;
+    }
+
+    fclose( file );
+    *result = measurements;
+    return count;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static int SameKey( const Measurement *a, const Measurement *b )
+{
+    return strcmp( a->kind, b->kind ) == 0 && strcmp( a->source, b->source ) == 0
+            && strcmp( a->destination, b->destination ) == 0 && strcmp( a->flags, b->flags ) == 0
+            && a->stride == b->stride && a->frames == b->frames;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static int Compare( const char *oldFileName, const char *newFileName, double threshold )
+{
+    Measurement *oldMeasurements = NULL, *newMeasurements = NULL;
+    int oldCount = ReadMeasurements( oldFileName, &oldMeasurements );
+    int newCount = ReadMeasurements( newFileName, &newMeasurements );
+    int i, j, compared = 0, regressions = 0, improvements = 0;
+
+    if( oldCount < 0 || newCount < 0 )
+    {
+        free( oldMeasurements );
+        free( newMeasurements );
+        return 2;
+    }
+
+    for( i=0; i < newCount; ++i )
+    {
+        const Measurement *n = &newMeasurements[i];
+
+        for( j=0; j < oldCount; ++j )
+        {
+            const Measurement *o = &oldMeasurements[j];
+
+            if( !SameKey( o, n ) )
+                continue;
+
+            ++compared;
+            if( n->samplesPerNs < o->samplesPerNs * (1. - threshold) )
+            {
+                printf( "REGRESSION %s %s to %s (%s) stride %d, %u frames: %.4f -> %.4f samples/ns (%+.1f%%)\n",
+                        n->kind, n->source, n->destination, n->flags, n->stride, n->frames,
+                        o->samplesPerNs, n->samplesPerNs, 100. * (n->samplesPerNs / o->samplesPerNs - 1.) );
+                ++regressions;
+            }
+            else if( n->samplesPerNs > o->samplesPerNs * (1. + threshold) )
+            {
+                ++improvements;
+            }
+            break;
+        }
+    }
+
+    printf( "%d measurements compared, %d regressions, %d improvements (threshold %.0f%%)\n",
+            compared, regressions, improvements, threshold * 100. );
+
+    free( oldMeasurements );
+    free( newMeasurements );
+
+    return (regressions == 0) ? 0 : 1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void PrintUsage( void )
+{
+    fprintf( stderr, "usage: patest_converter_benchmark [--json] [--reference] [--stride N] [--quick]\n"
+            "       patest_converter_benchmark --compare old.csv new.csv [--threshold fraction]\n" );
+}
+
+int main( int argc, char **argv )
+{
+    const char *oldFileName = NULL, *newFileName = NULL;
+    double threshold = 0.1;
+    int stride = DEFAULT_STRIDE, reference = 0, quick = 0;
+    int i;
+
+    for( i=1; i < argc; ++i )
+    {
+        if( strcmp( argv[i], "--json" ) == 0 )
+            json_ = 1;
+        else if( strcmp( argv[i], "--reference" ) == 0 )
+            reference = 1;
+        else if( strcmp( argv[i], "--quick" ) == 0 )
+            quick = 1;
+        else if( strcmp( argv[i], "--stride" ) == 0 && i + 1 < argc )
+            stride = atoi( argv[++i] );
+        else if( strcmp( argv[i], "--threshold" ) == 0 && i + 1 < argc )
+            threshold = atof( argv[++i] );
+        else if( strcmp( argv[i], "--compare" ) == 0 && i + 2 < argc )
+        {
+            oldFileName = argv[++i];
+            newFileName = argv[++i];
+        }
+        else
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    if( oldFileName )
+        return Compare( oldFileName, newFileName, threshold );
+
+    if( stride < 1 || stride > MAX_STRIDE )
+    {
+        fprintf( stderr, "stride must be between 1 and %d\n", MAX_STRIDE );
+        return 2;
+    }
+
+    PaUtil_InitializeClock();
+    if( !reference )
+        PaUtil_InitializeConverters(); /* use the converters Pa_Initialize() would */
+    if( quick )
+        minimumDuration_ = QUICK_DURATION;
+
+    RunBenchmark( stride, quick );
+
+    return 0;
+}
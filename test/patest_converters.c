@@ -63,17 +63,17 @@
 #define MAX_CHANNEL_COUNT               (8)
 
 
-#define SAMPLE_FORMAT_COUNT (6)
+#define SAMPLE_FORMAT_COUNT (7)
 
 static PaSampleFormat sampleFormats_[ SAMPLE_FORMAT_COUNT ] =
-    { paFloat32, paInt32, paInt24, paInt16, paInt8, paUInt8 }; /* all standard PA sample formats */
+    { paFloat64, paFloat32, paInt32, paInt24, paInt16, paInt8, paUInt8 }; /* all standard PA sample formats */
 
 static const char* sampleFormatNames_[SAMPLE_FORMAT_COUNT] =
-    { "paFloat32", "paInt32", "paInt24", "paInt16", "paInt8", "paUInt8" };
+    { "paFloat64", "paFloat32", "paInt32", "paInt24", "paInt16", "paInt8", "paUInt8" };
 
 
 static const char* abbreviatedSampleFormatNames_[SAMPLE_FORMAT_COUNT] =
-    { "f32", "i32", "i24", "i16", " i8", "ui8" };
+    { "f64", "f32", "i32", "i24", "i16", " i8", "ui8" };
 
 
 PaError My_Pa_GetSampleSize( PaSampleFormat format );
@@ -114,6 +114,16 @@ static void GenerateOneCycleSine( PaSampleFormat format, void *buffer, int frame
 {
     switch( format ){
 
+        case paFloat64:
+            {
+                int i;
+                double *out = (double*)buffer;
+                for( i=0; i < frameCount; ++i ){
+                    *out = .9 * sin( ((double)i/(double)frameCount) * 2. * M_PI );
+                    out += strideFrames;
+                }
+            }
+            break;
         case paFloat32:
             {
                 int i;
@@ -238,10 +248,10 @@ int main( int argc, const char **argv )
 
     PaUtil_InitializeTriangularDitherState( &ditherState );
 
-    /* allocate more than enough space, we use sizeof(float) but we need to fit any 32 bit datum */
+    /* allocate more than enough space, we use sizeof(double) but we need to fit any 64 bit datum */
 
-    destinationBuffer = (void*)malloc( MAX_PER_CHANNEL_FRAME_COUNT * MAX_CHANNEL_COUNT * sizeof(float) );
-    sourceBuffer = (void*)malloc( MAX_PER_CHANNEL_FRAME_COUNT * MAX_CHANNEL_COUNT * sizeof(float) );
+    destinationBuffer = (void*)malloc( MAX_PER_CHANNEL_FRAME_COUNT * MAX_CHANNEL_COUNT * sizeof(double) );
+    sourceBuffer = (void*)malloc( MAX_PER_CHANNEL_FRAME_COUNT * MAX_CHANNEL_COUNT * sizeof(double) );
     referenceBuffer = (void*)malloc( MAX_PER_CHANNEL_FRAME_COUNT * MAX_CHANNEL_COUNT * sizeof(float) );
 
 
@@ -389,6 +399,10 @@ PaError My_Pa_GetSampleSize( PaSampleFormat format )
         result = 4;
         break;
 
+    case paFloat64:
+        result = 8;
+        break;
+
     default:
         result = paSampleFormatNotSupported;
         break;
@@ -0,0 +1,398 @@
+/** @file patest_interleave.c
+    @ingroup test_src
+    @brief Verify the block (de)interleaving converters in pa_interleave.c and
+    their use by the buffer processor.
+
+    The block converters are compared against converting each channel
+    separately for a range of channel counts, frame strides and frame counts.
+    Then streams with many channels are run through the buffer processor with
+    interleaved host buffers and non-interleaved user buffers, and the other
+    way around, and the samples are checked to arrive unchanged.
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_interleave.h"
+#include "pa_process.h"
+#include "pa_dither.h"
+#include "pa_types.h"
+
+#define MAX_CHANNELS        (PA_UTIL_MAX_INTERLEAVE_CHANNELS)
+#define MAX_EXTRA_STRIDE    (3)
+#define MAX_FRAMES          (200)
+#define MAX_BYTES           (MAX_FRAMES * (MAX_CHANNELS + MAX_EXTRA_STRIDE) * 4)
+
+#define STREAM_MAX_CHANNELS (20)
+#define HOST_FRAMES         (256)
+#define HOST_BUFFER_COUNT   (6)
+#define STREAM_FRAMES       (HOST_FRAMES * HOST_BUFFER_COUNT)
+#define STREAM_SAMPLES      (STREAM_FRAMES * (STREAM_MAX_CHANNELS + MAX_EXTRA_STRIDE))
+
+static const struct { PaSampleFormat source, destination; } formats_[] = {
+    { paInt16, paFloat32 },
+    { paFloat32, paInt16 },
+    { paInt24, paInt32 },
+    { paFloat32, paInt24 },
+    { paInt8, paInt16 },
+    { paInt8, paInt8 },
+    { paInt16, paInt16 },
+    { paInt24, paInt24 },
+    { paFloat32, paFloat32 }
+};
+
+#define FORMAT_COUNT ((int)(sizeof(formats_) / sizeof(formats_[0])))
+
+static const unsigned int frameCounts_[] = { 0, 1, 5, 64, 67, MAX_FRAMES };
+
+static unsigned long seed_ = 22222;
+
+static unsigned long Random( void )
+{
+    seed_ = (seed_ * 196314165) + 907633515;
+    return seed_ >> 8;
+}
+
+/* fill with random samples, floats are kept within [-1, 1) */
+static void GenerateSamples( void *buffer, int count, PaSampleFormat format )
+{
+    int i;
+
+    if( format == paFloat32 )
+    {
+        for( i=0; i < count; ++i )
+            ((float*)buffer)[i] = ((float)(Random() & 0xFFFF) / 32768.f) - 1.f;
+    }
+    else
+    {
+        for( i=0; i < count * Pa_GetSampleSize( format ); ++i )
+            ((unsigned char*)buffer)[i] = (unsigned char)Random();
+    }
+}
+
+static int TestBlockConverters( void )
+{
+    static unsigned char source[ MAX_BYTES ];
+    static unsigned char expected[ MAX_BYTES ];
+    static unsigned char actual[ MAX_BYTES ];
+    void *expectedChannels[ MAX_CHANNELS ], *actualChannels[ MAX_CHANNELS ], *sourceChannels[ MAX_CHANNELS ];
+    PaUtilTriangularDitherGenerator dither;
+    int i, f, failures = 0;
+    unsigned int channelCount, extraStride, c;
+
+    for( i=0; i < FORMAT_COUNT; ++i )
+    {
+        PaUtilConverter *converter = PaUtil_SelectConverter( formats_[i].source, formats_[i].destination,
+                paClipOff | paDitherOff );
+        PaUtilConverter *blockConverter = (formats_[i].source == formats_[i].destination) ? NULL : converter;
+        unsigned int sourceBytes = Pa_GetSampleSize( formats_[i].source );
+        unsigned int destinationBytes = Pa_GetSampleSize( formats_[i].destination );
+        int ok = 1;
+
+        for( channelCount=1; channelCount <= MAX_CHANNELS; ++channelCount )
+        {
+            for( extraStride=0; extraStride <= MAX_EXTRA_STRIDE; extraStride += MAX_EXTRA_STRIDE )
+            {
+                unsigned int frameStride = channelCount + extraStride;
+
+                for( f=0; f < (int)(sizeof(frameCounts_) / sizeof(frameCounts_[0])); ++f )
+                {
+                    unsigned int frameCount = frameCounts_[f];
+
+                    /* interleaved source, non-interleaved destination */
+                    GenerateSamples( source, MAX_FRAMES * frameStride, formats_[i].source );
+                    memset( expected, 0xA5, sizeof(expected) );
+                    memset( actual, 0xA5, sizeof(actual) );
+
+                    PaUtil_InitializeTriangularDitherState( &dither );
+                    for( c=0; c < channelCount; ++c )
+                    {
+                        expectedChannels[c] = expected + c * (MAX_FRAMES + 1) * destinationBytes;
+                        actualChannels[c] = actual + c * (MAX_FRAMES + 1) * destinationBytes;
+                        converter( expectedChannels[c], 1, source + c * sourceBytes, frameStride,
+                                frameCount, &dither );
+                    }
+
+                    PaUtil_InitializeTriangularDitherState( &dither );
+                    PaUtil_DeinterleaveAndConvert( blockConverter, actualChannels, destinationBytes,
+                            source, frameStride, sourceBytes, channelCount, frameCount, &dither );
+
+                    if( memcmp( expected, actual, sizeof(expected) ) != 0 )
+                        ok = 0;
+
+                    /* non-interleaved source, interleaved destination */
+                    GenerateSamples( source, MAX_FRAMES * MAX_CHANNELS, formats_[i].source );
+                    memset( expected, 0xA5, sizeof(expected) );
+                    memset( actual, 0xA5, sizeof(actual) );
+
+                    PaUtil_InitializeTriangularDitherState( &dither );
+                    for( c=0; c < channelCount; ++c )
+                    {
+                        sourceChannels[c] = source + c * MAX_FRAMES * sourceBytes;
+                        converter( expected + c * destinationBytes, frameStride, sourceChannels[c], 1,
+                                frameCount, &dither );
+                    }
+
+                    PaUtil_InitializeTriangularDitherState( &dither );
+                    PaUtil_ConvertAndInterleave( blockConverter, actual, frameStride, destinationBytes,
+                            sourceChannels, sourceBytes, channelCount, frameCount, &dither );
+
+                    if( memcmp( expected, actual, sizeof(expected) ) != 0 )
+                        ok = 0;
+                }
+            }
+        }
+
+        printf( "block converter format 0x%02lX to 0x%02lX: %s\n", (unsigned long)formats_[i].source,
+                (unsigned long)formats_[i].destination, ok ? "PASSED" : "FAILED" );
+        if( !ok )
+            ++failures;
+    }
+
+    return failures;
+}
+
+/*******************************************************************/
+
+typedef struct
+{
+    int channelCount;
+    PaSampleFormat userFormat; /* paInt16 or paInt32 */
+    int userIsInterleaved;
+    PaInt16 *capture;
+    const PaInt16 *playback;
+    int framesCaptured;
+    int framesPlayed;
+} StreamData;
+
+static PaInt16 GetUserSample( const StreamData *data, const void *buffer, int frame, int channel )
+{
+    int index = frame;
+
+    if( data->userIsInterleaved )
+        index = frame * data->channelCount + channel;
+    else
+        buffer = ((const void* const*)buffer)[channel];
+
+    if( data->userFormat == paInt32 )
+        return (PaInt16)(((const PaInt32*)buffer)[index] >> 16);
+    else
+        return ((const PaInt16*)buffer)[index];
+}
+
+static void SetUserSample( const StreamData *data, void *buffer, int frame, int channel, PaInt16 value )
+{
+    int index = frame;
+
+    if( data->userIsInterleaved )
+        index = frame * data->channelCount + channel;
+    else
+        buffer = ((void**)buffer)[channel];
+
+    if( data->userFormat == paInt32 )
+        ((PaInt32*)buffer)[index] = (PaInt32)value * 65536;
+    else
+        ((PaInt16*)buffer)[index] = value;
+}
+
+static int StreamCallback( const void *input, void *output, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    StreamData *data = (StreamData*)userData;
+    int f, c;
+
+    (void) timeInfo; /* Prevent unused variable warnings. */
+    (void) statusFlags;
+
+    for( f=0; f < (int)frameCount; ++f )
+    {
+        for( c=0; c < data->channelCount; ++c )
+        {
+            if( data->framesCaptured + f < STREAM_FRAMES )
+                data->capture[ (data->framesCaptured + f) * data->channelCount + c ] =
+                        GetUserSample( data, input, f, c );
+            SetUserSample( data, output, f, c,
+                    data->playback[ ((data->framesPlayed + f) % STREAM_FRAMES) * data->channelCount + c ] );
+        }
+    }
+
+    data->framesCaptured += frameCount;
+    data->framesPlayed += frameCount;
+
+    return paContinue;
+}
+
+/* host samples are addressed as [frame * stride + channel] when interleaved,
+    and as [channel * STREAM_FRAMES + frame] otherwise */
+static PaInt16 *HostSample( PaInt16 *buffer, int hostIsInterleaved, int stride, int frame, int channel )
+{
+    return hostIsInterleaved ? &buffer[ frame * stride + channel ] : &buffer[ channel * STREAM_FRAMES + frame ];
+}
+
+static int TestBufferProcessor( int channelCount, int hostIsInterleaved, int extraStride,
+        PaSampleFormat userFormat, unsigned long framesPerUserBuffer )
+{
+    static PaInt16 hostInput[ STREAM_SAMPLES ], hostOutput[ STREAM_SAMPLES ];
+    static PaInt16 capture[ STREAM_SAMPLES ], playback[ STREAM_SAMPLES ];
+    PaUtilBufferProcessor bp;
+    PaStreamCallbackTimeInfo timeInfo;
+    StreamData data;
+    int stride = channelCount + extraStride;
+    int callbackResult = paContinue;
+    int b, f, c, ok = 1;
+    unsigned long inputLatency, outputLatency;
+
+    GenerateSamples( hostInput, STREAM_SAMPLES, paInt16 );
+    GenerateSamples( playback, STREAM_SAMPLES, paInt16 );
+    memset( hostOutput, 0, sizeof(hostOutput) );
+    memset( capture, 0, sizeof(capture) );
+
+    data.channelCount = channelCount;
+    data.userFormat = userFormat;
+    data.userIsInterleaved = hostIsInterleaved ? 0 : 1;
+    data.capture = capture;
+    data.playback = playback;
+    data.framesCaptured = 0;
+    data.framesPlayed = 0;
+
+    if( PaUtil_InitializeBufferProcessor( &bp,
+            channelCount, userFormat | (data.userIsInterleaved ? 0 : paNonInterleaved),
+            paInt16 | (hostIsInterleaved ? 0 : paNonInterleaved),
+            channelCount, userFormat | (data.userIsInterleaved ? 0 : paNonInterleaved),
+            paInt16 | (hostIsInterleaved ? 0 : paNonInterleaved),
+            44100., paClipOff | paDitherOff, framesPerUserBuffer, HOST_FRAMES,
+            paUtilFixedHostBufferSize, StreamCallback, &data ) != paNoError )
+    {
+        printf( "PaUtil_InitializeBufferProcessor failed\n" );
+        return 0;
+    }
+
+    inputLatency = PaUtil_GetBufferProcessorInputLatencyFrames( &bp );
+    outputLatency = PaUtil_GetBufferProcessorOutputLatencyFrames( &bp );
+
+    for( b=0; b < HOST_BUFFER_COUNT; ++b )
+    {
+        memset( &timeInfo, 0, sizeof(timeInfo) );
+        PaUtil_BeginBufferProcessing( &bp, &timeInfo, 0 );
+
+        PaUtil_SetInputFrameCount( &bp, HOST_FRAMES );
+        PaUtil_SetOutputFrameCount( &bp, HOST_FRAMES );
+        for( c=0; c < channelCount; ++c )
+        {
+            PaUtil_SetInputChannel( &bp, c,
+                    HostSample( hostInput, hostIsInterleaved, stride, b * HOST_FRAMES, c ),
+                    hostIsInterleaved ? stride : 1 );
+            PaUtil_SetOutputChannel( &bp, c,
+                    HostSample( hostOutput, hostIsInterleaved, stride, b * HOST_FRAMES, c ),
+                    hostIsInterleaved ? stride : 1 );
+        }
+
+        PaUtil_EndBufferProcessing( &bp, &callbackResult );
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    for( f=0; f + (int)inputLatency < data.framesCaptured && f + (int)inputLatency < STREAM_FRAMES; ++f )
+    {
+        for( c=0; c < channelCount; ++c )
+        {
+            if( capture[ (f + inputLatency) * channelCount + c ] !=
+                    *HostSample( hostInput, hostIsInterleaved, stride, f, c ) )
+                ok = 0;
+        }
+    }
+
+    for( f=0; f + (int)outputLatency < STREAM_FRAMES; ++f )
+    {
+        for( c=0; c < stride; ++c )
+        {
+            if( hostIsInterleaved && c >= channelCount )
+            {
+                if( hostOutput[ f * stride + c ] != 0 )
+                    ok = 0; /* samples of other channels must not be written */
+            }
+            else if( c < channelCount && *HostSample( hostOutput, hostIsInterleaved, stride, f + outputLatency, c ) !=
+                    playback[ f * channelCount + c ] )
+            {
+                ok = 0;
+            }
+        }
+    }
+
+    printf( "buffer processor %2d channels, host %s (stride %d), user 0x%02lX, %3lu frames per buffer: %s\n",
+            channelCount, hostIsInterleaved ? "interleaved" : "non-interleaved", stride,
+            (unsigned long)userFormat, framesPerUserBuffer, ok ? "PASSED" : "FAILED" );
+
+    return ok;
+}
+
+/*******************************************************************/
+
+int main( void )
+{
+    static const int channelCounts[] = { 2, 8, STREAM_MAX_CHANNELS };
+    static const PaSampleFormat userFormats[] = { paInt16, paInt32 };
+    static const unsigned long framesPerUserBuffer[] = { 0, 100 };
+    int i, j, k, hostIsInterleaved, failures;
+
+    failures = TestBlockConverters();
+
+    for( i=0; i < (int)(sizeof(channelCounts) / sizeof(channelCounts[0])); ++i )
+        for( hostIsInterleaved=0; hostIsInterleaved <= 1; ++hostIsInterleaved )
+            for( j=0; j < (int)(sizeof(userFormats) / sizeof(userFormats[0])); ++j )
+                for( k=0; k < (int)(sizeof(framesPerUserBuffer) / sizeof(framesPerUserBuffer[0])); ++k )
+                {
+                    if( !TestBufferProcessor( channelCounts[i], hostIsInterleaved, 0,
+                            userFormats[j], framesPerUserBuffer[k] ) )
+                        ++failures;
+                    if( hostIsInterleaved && !TestBufferProcessor( channelCounts[i], hostIsInterleaved,
+                            MAX_EXTRA_STRIDE, userFormats[j], framesPerUserBuffer[k] ) )
+                        ++failures;
+                }
+
+    printf( "%d failures\n", failures );
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+/** @file patest_mirrored_ringbuffer.c
+    @ingroup test_src
+    @brief Verify that a mirrored PaUtilRingBuffer returns contiguous regions
+    across the wrap point, that both mappings show the same memory, and that
+    data written and read through the regular functions stays in order.
+
+    Platforms without mirrored ring buffers only check that initialization
+    fails, so that callers can fall back to PaUtil_InitializeRingBuffer().
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_ringbuffer.h"
+
+#define ELEMENT_SIZE    (8)     /* one stereo float frame */
+#define ELEMENT_COUNT   (4096)  /* a whole number of pages for any usual page size */
+#define CHUNK           (1000)  /* not a divisor of ELEMENT_COUNT, so transfers wrap */
+#define TRANSFER_COUNT  (ELEMENT_COUNT * 5)
+
+static int failureCount_ = 0;
+
+#define CHECK( condition, message ) \
+    do{ if( !(condition) ){ printf( "FAIL: %s\n", message ); ++failureCount_; } }while(0)
+
+static void FillChunk( float *chunk, long first, long count )
+{
+    long i;
+
+    for( i=0; i < count; ++i )
+    {
+        chunk[i * 2] = (float)(first + i);
+        chunk[i * 2 + 1] = -(float)(first + i);
+    }
+}
+
+static void TestRegularFunctions( PaUtilRingBuffer *rbuf )
+{
+    static float chunk[CHUNK * 2];
+    long written = 0, read = 0, i;
+    ring_buffer_size_t count;
+    int ok = 1;
+
+    while( read < TRANSFER_COUNT )
+    {
+        FillChunk( chunk, written, CHUNK );
+        count = PaUtil_WriteRingBuffer( rbuf, chunk, CHUNK );
+        written += count;
+
+        count = PaUtil_ReadRingBuffer( rbuf, chunk, CHUNK - 7 );
+        for( i=0; i < count; ++i )
+        {
+            if( chunk[i * 2] != (float)(read + i) || chunk[i * 2 + 1] != -(float)(read + i) )
+                ok = 0;
+        }
+        read += count;
+    }
+    CHECK( ok, "elements read back out of order" );
+}
+
+static void TestContiguousRegions( PaUtilRingBuffer *rbuf )
+{
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2, count, i;
+    float *region;
+    int ok = 1, wrapped = 0;
+    long written = 0, read = 0;
+
+    PaUtil_FlushRingBuffer( rbuf );
+    while( read < TRANSFER_COUNT )
+    {
+        count = PaUtil_GetRingBufferWriteRegions( rbuf, CHUNK, &data1, &size1, &data2, &size2 );
+        if( size2 != 0 || data2 != NULL || size1 != count )
+            ok = 0;
+        if( (char*)data1 + count * ELEMENT_SIZE > rbuf->buffer + ELEMENT_COUNT * ELEMENT_SIZE )
+            wrapped = 1;
+        FillChunk( (float*)data1, written, count );
+        PaUtil_AdvanceRingBufferWriteIndex( rbuf, count );
+        written += count;
+
+        count = PaUtil_GetRingBufferReadRegions( rbuf, CHUNK - 7, &data1, &size1, &data2, &size2 );
+        if( size2 != 0 || data2 != NULL || size1 != count )
+            ok = 0;
+        region = (float*)data1;
+        for( i=0; i < count; ++i )
+        {
+            if( region[i * 2] != (float)(read + i) )
+                ok = 0;
+        }
+        PaUtil_AdvanceRingBufferReadIndex( rbuf, count );
+        read += count;
+    }
+    CHECK( ok, "a region was split or read back wrongly" );
+    CHECK( wrapped, "no region extended into the second mapping" );
+
+    /* writing through the second mapping must change the first one */
+    rbuf->buffer[ELEMENT_COUNT * ELEMENT_SIZE + 3] = 0x5a;
+    CHECK( rbuf->buffer[3] == 0x5a, "mappings don't share memory" );
+    rbuf->buffer[5] = 0x3c;
+    CHECK( rbuf->buffer[ELEMENT_COUNT * ELEMENT_SIZE + 5] == 0x3c, "mappings don't share memory" );
+}
+
+int main(void);
+int main(void)
+{
+    PaUtilRingBuffer rbuf;
+
+    memset( &rbuf, 0, sizeof(rbuf) );
+    CHECK( PaUtil_InitializeMirroredRingBuffer( &rbuf, ELEMENT_SIZE, ELEMENT_COUNT - 1 ) == -1,
+            "accepted an element count which isn't a power of 2" );
+    CHECK( PaUtil_InitializeMirroredRingBuffer( &rbuf, 6, 8 ) == -1,
+            "accepted a buffer which isn't a whole number of pages" );
+    CHECK( !PaUtil_IsRingBufferMirrored( &rbuf ), "failed initialization left the buffer mirrored" );
+
+    if( PaUtil_InitializeMirroredRingBuffer( &rbuf, ELEMENT_SIZE, ELEMENT_COUNT ) != 0 )
+    {
+#if defined(__linux__)
+        CHECK( 0, "couldn't create a mirrored ring buffer" );
+#else
+        printf( "mirrored ring buffers are not supported on this platform\n" );
+#endif
+    }
+    else
+    {
+        CHECK( PaUtil_IsRingBufferMirrored( &rbuf ), "initialized buffer isn't mirrored" );
+        CHECK( PaUtil_GetRingBufferWriteAvailable( &rbuf ) == ELEMENT_COUNT, "buffer isn't empty" );
+        TestRegularFunctions( &rbuf );
+        TestContiguousRegions( &rbuf );
+
+        PaUtil_TerminateMirroredRingBuffer( &rbuf );
+        CHECK( !PaUtil_IsRingBufferMirrored( &rbuf ) && rbuf.buffer == NULL, "buffer wasn't released" );
+    }
+
+    printf( "%d failures\n", failureCount_ );
+    return failureCount_ ? 1 : 0;
+}
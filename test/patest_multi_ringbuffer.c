@@ -0,0 +1,369 @@
+/** @file patest_multi_ringbuffer.c
+    @ingroup test_src
+    @brief Stress test and measure the throughput of PaUtilMultiRingBuffer
+    with several producer threads and one or several consumer threads.
+
+    Every producer writes a numbered sequence of elements. The consumers
+    check that every element arrives exactly once, that the elements of each
+    producer arrive in order, and that no element was torn by a concurrent
+    copy. The same workload is also run through a PaUtilRingBuffer guarded by
+    a mutex, which is how a single-producer ring buffer has to be shared.
+    Results are printed as CSV in elements per microsecond.
+
+    Build with -fsanitize=thread to have ThreadSanitizer check the
+    synchronization of the ring buffers.
+
+    Usage:
+        patest_multi_ringbuffer [--quick]
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "portaudio.h"
+#include "pa_ringbuffer.h"
+#include "pa_util.h"
+
+#define ELEMENT_COUNT       (256)   /* ring buffer capacity */
+#define PAYLOAD_WORDS       (6)
+#define CHUNK               (8)     /* elements per read or write call */
+#define MAX_PRODUCERS       (4)
+#define MAX_CONSUMERS       (3)
+
+#define ELEMENTS_PER_PRODUCER       (1 << 18)
+#define QUICK_ELEMENTS_PER_PRODUCER (1 << 14)
+
+typedef struct
+{
+    unsigned int producer;
+    unsigned int sequence;
+    unsigned int payload[PAYLOAD_WORDS]; /* derived from the above, to detect torn copies */
+}
+Element;
+
+typedef enum { MUTEX_QUEUE, MPSC_QUEUE, MPMC_QUEUE } QueueKind;
+
+static const char *queueNames_[] = { "mutex", "mpsc", "mpmc" };
+
+typedef struct
+{
+    QueueKind kind;
+    PaUtilRingBuffer ringBuffer;    /* MUTEX_QUEUE */
+    pthread_mutex_t writeMutex;
+    pthread_mutex_t readMutex;
+    PaUtilMultiRingBuffer multiRingBuffer;
+    Element data[ELEMENT_COUNT];
+    ring_buffer_size_t sequences[ELEMENT_COUNT];
+
+    unsigned int elementsPerProducer;
+    unsigned char *received[MAX_PRODUCERS]; /* one flag per element */
+
+    pthread_mutex_t doneMutex;
+    int producersDone;
+    unsigned long errorCount;       /* protected by doneMutex */
+}
+Test;
+
+typedef struct
+{
+    Test *test;
+    unsigned int id;
+}
+ThreadData;
+
+static unsigned int Payload( unsigned int producer, unsigned int sequence, int word )
+{
+    return (producer + 1) * 2654435761u ^ (sequence * 40503u + (unsigned int)word);
+}
+
+static ring_buffer_size_t Write( Test *test, const Element *elements, ring_buffer_size_t count )
+{
+    ring_buffer_size_t result;
+
+    if( test->kind != MUTEX_QUEUE )
+        return PaUtil_WriteMultiRingBuffer( &test->multiRingBuffer, elements, count );
+
+    pthread_mutex_lock( &test->writeMutex );
+    result = PaUtil_WriteRingBuffer( &test->ringBuffer, elements, count );
+    pthread_mutex_unlock( &test->writeMutex );
+    return result;
+}
+
+static ring_buffer_size_t Read( Test *test, Element *elements, ring_buffer_size_t count )
+{
+    ring_buffer_size_t result;
+
+    if( test->kind != MUTEX_QUEUE )
+        return PaUtil_ReadMultiRingBuffer( &test->multiRingBuffer, elements, count );
+
+    pthread_mutex_lock( &test->readMutex );
+    result = PaUtil_ReadRingBuffer( &test->ringBuffer, elements, count );
+    pthread_mutex_unlock( &test->readMutex );
+    return result;
+}
+
+static void *ProducerThread( void *userData )
+{
+    ThreadData *thread = (ThreadData*)userData;
+    Test *test = thread->test;
+    Element chunk[CHUNK];
+    unsigned int sent = 0;
+    ring_buffer_size_t i, count, written;
+    int word;
+
+    while( sent < test->elementsPerProducer )
+    {
+        count = CHUNK;
+        if( (unsigned int)count > test->elementsPerProducer - sent )
+            count = (ring_buffer_size_t)(test->elementsPerProducer - sent);
+        for( i=0; i < count; ++i )
+        {
+            chunk[i].producer = thread->id;
+            chunk[i].sequence = sent + (unsigned int)i;
+            for( word=0; word < PAYLOAD_WORDS; ++word )
+                chunk[i].payload[word] = Payload( thread->id, sent + (unsigned int)i, word );
+        }
+
+        written = Write( test, chunk, count );
+        while( written < count )
+        {
+            sched_yield();
+            written += Write( test, &chunk[written], count - written );
+        }
+        sent += (unsigned int)count;
+    }
+    return NULL;
+}
+
+static int ProducersDone( Test *test )
+{
+    int result;
+
+    pthread_mutex_lock( &test->doneMutex );
+    result = test->producersDone;
+    pthread_mutex_unlock( &test->doneMutex );
+    return result;
+}
+
+static void *ConsumerThread( void *userData )
+{
+    ThreadData *thread = (ThreadData*)userData;
+    Test *test = thread->test;
+    Element chunk[CHUNK];
+    long lastSequence[MAX_PRODUCERS];
+    unsigned long errorCount = 0;
+    ring_buffer_size_t i, count;
+    const Element *e;
+    int word;
+
+    for( i=0; i < MAX_PRODUCERS; ++i )
+        lastSequence[i] = -1;
+
+    for( ;; )
+    {
+        count = Read( test, chunk, CHUNK );
+        if( count == 0 )
+        {
+            if( ProducersDone( test ) )
+            {
+                /* everything has been published, check once more */
+                if( (count = Read( test, chunk, CHUNK )) == 0 )
+                    break;
+            }
+            else
+            {
+                sched_yield();
+                continue;
+            }
+        }
+
+        for( i=0; i < count; ++i )
+        {
+            e = &chunk[i];
+            if( e->producer >= MAX_PRODUCERS || e->sequence >= test->elementsPerProducer
+                    || (long)e->sequence <= lastSequence[e->producer] )
+            {
+                ++errorCount; /* corrupt, or out of order for this consumer */
+                continue;
+            }
+            lastSequence[e->producer] = (long)e->sequence;
+            for( word=0; word < PAYLOAD_WORDS; ++word )
+            {
+                if( e->payload[word] != Payload( e->producer, e->sequence, word ) )
+                    ++errorCount;
+            }
+            if( test->received[e->producer][e->sequence]++ != 0 )
+                ++errorCount; /* received twice */
+        }
+    }
+
+    pthread_mutex_lock( &test->doneMutex );
+    test->errorCount += errorCount;
+    pthread_mutex_unlock( &test->doneMutex );
+    return NULL;
+}
+
+/* Returns the throughput in elements per microsecond, or a negative value if
+    the elements didn't arrive intact. */
+static double Run( QueueKind kind, int producerCount, int consumerCount, unsigned int elementsPerProducer )
+{
+    static Test test;
+    pthread_t producers[MAX_PRODUCERS], consumers[MAX_CONSUMERS];
+    ThreadData producerData[MAX_PRODUCERS], consumerData[MAX_CONSUMERS];
+    double start, elapsed;
+    unsigned int j;
+    int i, missing = 0;
+
+    memset( &test, 0, sizeof(test) );
+    test.kind = kind;
+    test.elementsPerProducer = elementsPerProducer;
+    pthread_mutex_init( &test.writeMutex, NULL );
+    pthread_mutex_init( &test.readMutex, NULL );
+    pthread_mutex_init( &test.doneMutex, NULL );
+    for( i=0; i < producerCount; ++i )
+        test.received[i] = (unsigned char*)calloc( elementsPerProducer, 1 );
+
+    if( kind == MUTEX_QUEUE )
+        PaUtil_InitializeRingBuffer( &test.ringBuffer, sizeof(Element), ELEMENT_COUNT, test.data );
+    else if( PaUtil_InitializeMultiRingBuffer( &test.multiRingBuffer, sizeof(Element), ELEMENT_COUNT,
+            test.data, test.sequences, (kind == MPMC_QUEUE) ? paUtilMultiProducerMultiConsumer
+            : paUtilMultiProducerSingleConsumer ) != 0 )
+    {
+        printf( "FAIL: couldn't initialize the multi-producer ring buffer\n" );
+        return -1.;
+    }
+
+    start = PaUtil_GetTime();
+    for( i=0; i < consumerCount; ++i )
+    {
+        consumerData[i].test = &test;
+        consumerData[i].id = (unsigned int)i;
+        pthread_create( &consumers[i], NULL, ConsumerThread, &consumerData[i] );
+    }
+    for( i=0; i < producerCount; ++i )
+    {
+        producerData[i].test = &test;
+        producerData[i].id = (unsigned int)i;
+        pthread_create( &producers[i], NULL, ProducerThread, &producerData[i] );
+    }
+    for( i=0; i < producerCount; ++i )
+        pthread_join( producers[i], NULL );
+
+    pthread_mutex_lock( &test.doneMutex );
+    test.producersDone = 1;
+    pthread_mutex_unlock( &test.doneMutex );
+
+    for( i=0; i < consumerCount; ++i )
+        pthread_join( consumers[i], NULL );
+    elapsed = PaUtil_GetTime() - start;
+
+    for( i=0; i < producerCount; ++i )
+    {
+        for( j=0; j < elementsPerProducer; ++j )
+        {
+            if( test.received[i][j] != 1 )
+                ++missing;
+        }
+        free( test.received[i] );
+    }
+
+    pthread_mutex_destroy( &test.writeMutex );
+    pthread_mutex_destroy( &test.readMutex );
+    pthread_mutex_destroy( &test.doneMutex );
+
+    if( test.errorCount != 0 || missing != 0 )
+    {
+        printf( "FAIL: %s queue, %d producers, %d consumers: %lu bad elements, %d missing\n",
+                queueNames_[kind], producerCount, consumerCount, test.errorCount, missing );
+        return -1.;
+    }
+
+    return (double)elementsPerProducer * producerCount / (elapsed * 1e6);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int main( int argc, char **argv );
+int main( int argc, char **argv )
+{
+    static const struct { QueueKind kind; int consumerCount; } configurations[] = {
+        { MUTEX_QUEUE, 1 },
+        { MPSC_QUEUE, 1 },
+        { MUTEX_QUEUE, MAX_CONSUMERS },
+        { MPMC_QUEUE, MAX_CONSUMERS }
+    };
+    unsigned int elementsPerProducer = ELEMENTS_PER_PRODUCER;
+    int i, producerCount, failureCount = 0;
+    double throughput;
+
+    if( argc == 2 && strcmp( argv[1], "--quick" ) == 0 )
+        elementsPerProducer = QUICK_ELEMENTS_PER_PRODUCER;
+    else if( argc != 1 )
+    {
+        printf( "usage: %s [--quick]\n", argv[0] );
+        return 2;
+    }
+
+    PaUtil_InitializeClock();
+
+    printf( "queue,producers,consumers,elementsPerUs\n" );
+    for( i=0; i < (int)(sizeof(configurations) / sizeof(configurations[0])); ++i )
+    {
+        for( producerCount = 1; producerCount <= MAX_PRODUCERS; producerCount *= 2 )
+        {
+            throughput = Run( configurations[i].kind, producerCount,
+                    configurations[i].consumerCount, elementsPerProducer );
+            if( throughput < 0. )
+            {
+                ++failureCount;
+                continue;
+            }
+            printf( "%s,%d,%d,%.3f\n", queueNames_[configurations[i].kind], producerCount,
+                    configurations[i].consumerCount, throughput );
+        }
+    }
+
+    printf( "%d failures\n", failureCount );
+    return failureCount ? 1 : 0;
+}
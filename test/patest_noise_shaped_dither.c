@@ -0,0 +1,283 @@
+/** @file patest_noise_shaped_dither.c
+    @ingroup test_src
+    @brief Verify the block dither generator and the noise shaped dither
+    converters selected with paNoiseShapedDither.
+
+    PaUtil_GenerateFloatTriangularDitherBlock() must produce exactly the
+    sequence of PaUtil_GenerateFloatTriangularDither(). The noise shaped
+    converters must clip, have no DC error, and move the error out of the
+    low frequencies compared to plain dithered rounding. Finally a stereo
+    output stream is run through the buffer processor to check that each
+    channel is dithered with its own generator.
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_process.h"
+#include "pa_dither.h"
+#include "pa_types.h"
+
+#define MAX_DITHER_COUNT    (1031)
+#define SIGNAL_FRAMES       (65536)
+#define LOW_PASS_LENGTH     (64) /* boxcar, passes roughly below sampleRate / 128 */
+#define CHANNEL_COUNT       (2)
+#define HOST_FRAMES         (256)
+#define HOST_BUFFER_COUNT   (8)
+#define STREAM_FRAMES       (HOST_FRAMES * HOST_BUFFER_COUNT)
+
+static int TestBlockGenerator( void )
+{
+    static float expected[ MAX_DITHER_COUNT ], actual[ MAX_DITHER_COUNT ];
+    static const unsigned int counts[] = { 0, 1, 7, 8, 9, 15, 16, 17, 64, 100, MAX_DITHER_COUNT };
+    PaUtilTriangularDitherGenerator expectedState, actualState;
+    unsigned int i, j, k;
+    int ok = 1;
+
+    PaUtil_InitializeTriangularDitherState( &expectedState );
+    PaUtil_InitializeTriangularDitherState( &actualState );
+
+    /* consecutive calls of different lengths must continue the same sequence */
+    for( k=0; k < 3; ++k )
+    {
+        for( i=0; i < sizeof(counts) / sizeof(counts[0]); ++i )
+        {
+            for( j=0; j < counts[i]; ++j )
+                expected[j] = PaUtil_GenerateFloatTriangularDither( &expectedState );
+            PaUtil_GenerateFloatTriangularDitherBlock( &actualState, actual, counts[i] );
+
+            if( memcmp( expected, actual, counts[i] * sizeof(float) ) != 0
+                    || memcmp( &expectedState, &actualState, sizeof(expectedState) ) != 0 )
+                ok = 0;
+        }
+    }
+
+    printf( "block dither generator: %s\n", ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+static void GenerateSignal( float *buffer, int count )
+{
+    int i;
+
+    /* a sine a few LSB high, where the dither and quantization noise matter */
+    for( i=0; i < count; ++i )
+        buffer[i] = (float)(3.3 / 32767. * sin( i * 2. * 3.14159265358979 * 441. / 44100. ));
+}
+
+/* returns the power of error low pass filtered and the mean of error */
+static double LowFrequencyPower( const double *error, int count, double *mean )
+{
+    double sum = 0., power = 0., window = 0.;
+    int i;
+
+    for( i=0; i < count; ++i )
+    {
+        sum += error[i];
+        window += error[i];
+        if( i >= LOW_PASS_LENGTH )
+            window -= error[ i - LOW_PASS_LENGTH ];
+        if( i >= LOW_PASS_LENGTH - 1 )
+            power += (window / LOW_PASS_LENGTH) * (window / LOW_PASS_LENGTH);
+    }
+
+    *mean = sum / count;
+    return power / (count - LOW_PASS_LENGTH + 1);
+}
+
+static int TestNoiseShaping( void )
+{
+    static float source[ SIGNAL_FRAMES ];
+    static PaInt16 shaped[ SIGNAL_FRAMES ];
+    static double shapedError[ SIGNAL_FRAMES ], plainError[ SIGNAL_FRAMES ];
+    static const float clipping[] = { 2.f, 1.f, 0.f, -1.f, -2.f, 0.f };
+    PaInt16 clipped[ sizeof(clipping) / sizeof(clipping[0]) ];
+    PaUtilConverter *converter = PaUtil_SelectConverter( paFloat32, paInt16, paNoiseShapedDither );
+    PaUtilTriangularDitherGenerator ditherState;
+    double shapedPower, plainPower, shapedMean, plainMean;
+    int i, ok = 1;
+
+    if( converter != paConverters.Float32_To_Int16_NoiseShaped
+            || PaUtil_SelectConverter( paFloat32, paInt16, paNoiseShapedDither | paDitherOff ) != paConverters.Float32_To_Int16_Clip
+            || PaUtil_SelectConverter( paFloat32, paInt8, paNoiseShapedDither ) != paConverters.Float32_To_Int8_NoiseShaped
+            || PaUtil_SelectConverter( paFloat32, paUInt8, paNoiseShapedDither ) != paConverters.Float32_To_UInt8_NoiseShaped
+            || PaUtil_SelectConverter( paFloat32, paInt32, paNoiseShapedDither ) != paConverters.Float32_To_Int32_DitherClip )
+    {
+        printf( "converter selection: FAILED\n" );
+        return 0;
+    }
+
+    GenerateSignal( source, SIGNAL_FRAMES );
+
+    PaUtil_InitializeTriangularDitherState( &ditherState );
+    converter( shaped, 1, source, 1, SIGNAL_FRAMES, &ditherState );
+
+    /* the reference is rounding with the same dither but without feedback */
+    PaUtil_InitializeTriangularDitherState( &ditherState );
+    for( i=0; i < SIGNAL_FRAMES; ++i )
+    {
+        double value = source[i] * 32767.;
+        shapedError[i] = shaped[i] - value;
+        plainError[i] = floor( value + PaUtil_GenerateFloatTriangularDither( &ditherState ) + .5 ) - value;
+    }
+
+    shapedPower = LowFrequencyPower( shapedError, SIGNAL_FRAMES, &shapedMean );
+    plainPower = LowFrequencyPower( plainError, SIGNAL_FRAMES, &plainMean );
+
+    printf( "low frequency error: noise shaped %.2f dB relative to plain dither, DC %.4f LSB\n",
+            10. * log10( shapedPower / plainPower ), shapedMean );
+    if( shapedPower > .5 * plainPower || fabs( shapedMean ) > .01 )
+        ok = 0;
+
+    PaUtil_InitializeTriangularDitherState( &ditherState );
+    converter( clipped, 1, (void*)clipping, 1, sizeof(clipping) / sizeof(clipping[0]), &ditherState );
+    if( clipped[0] != 32767 || clipped[1] < 32765 || clipped[2] < -3 || clipped[2] > 3
+            || clipped[3] > -32765 || clipped[4] != -32768 || clipped[5] < -3 || clipped[5] > 3 )
+        ok = 0;
+
+    printf( "noise shaped Float32_To_Int16: %s\n", ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+typedef struct
+{
+    const float *signal;
+    int framesPlayed;
+} StreamData;
+
+static int StreamCallback( const void *input, void *output, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    StreamData *data = (StreamData*)userData;
+    float *out = (float*)output;
+    int f, c;
+
+    (void) input; /* Prevent unused variable warnings. */
+    (void) timeInfo;
+    (void) statusFlags;
+
+    for( f=0; f < (int)frameCount; ++f )
+    {
+        for( c=0; c < CHANNEL_COUNT; ++c )
+            *out++ = data->signal[ data->framesPlayed + f ];
+    }
+
+    data->framesPlayed += frameCount;
+
+    return paContinue;
+}
+
+static int TestBufferProcessor( void )
+{
+    static float signal[ STREAM_FRAMES ];
+    static PaInt16 hostOutput[ STREAM_FRAMES * CHANNEL_COUNT ];
+    static PaInt16 expected[ STREAM_FRAMES ];
+    PaUtilBufferProcessor bp;
+    PaStreamCallbackTimeInfo timeInfo;
+    PaUtilTriangularDitherGenerator ditherState;
+    StreamData data;
+    int callbackResult = paContinue;
+    int b, f, c, ok = 1, channelsDiffer = 0;
+
+    GenerateSignal( signal, STREAM_FRAMES );
+    data.signal = signal;
+    data.framesPlayed = 0;
+
+    if( PaUtil_InitializeBufferProcessor( &bp, 0, 0, 0,
+            CHANNEL_COUNT, paFloat32, paInt16,
+            44100., paNoiseShapedDither, HOST_FRAMES, HOST_FRAMES,
+            paUtilFixedHostBufferSize, StreamCallback, &data ) != paNoError )
+    {
+        printf( "PaUtil_InitializeBufferProcessor failed\n" );
+        return 0;
+    }
+
+    for( b=0; b < HOST_BUFFER_COUNT; ++b )
+    {
+        memset( &timeInfo, 0, sizeof(timeInfo) );
+        PaUtil_BeginBufferProcessing( &bp, &timeInfo, 0 );
+        PaUtil_SetOutputFrameCount( &bp, HOST_FRAMES );
+        PaUtil_SetInterleavedOutputChannels( &bp, 0, &hostOutput[ b * HOST_FRAMES * CHANNEL_COUNT ], CHANNEL_COUNT );
+        PaUtil_EndBufferProcessing( &bp, &callbackResult );
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    for( c=0; c < CHANNEL_COUNT; ++c )
+    {
+        PaUtil_InitializeChannelTriangularDitherState( &ditherState, c );
+        paConverters.Float32_To_Int16_NoiseShaped( expected, 1, signal, 1, STREAM_FRAMES, &ditherState );
+
+        for( f=0; f < STREAM_FRAMES; ++f )
+        {
+            if( hostOutput[ f * CHANNEL_COUNT + c ] != expected[f] )
+                ok = 0;
+            if( hostOutput[ f * CHANNEL_COUNT + c ] != hostOutput[ f * CHANNEL_COUNT ] )
+                channelsDiffer = 1;
+        }
+    }
+
+    if( !channelsDiffer )
+        ok = 0;
+
+    printf( "buffer processor with per channel dither: %s\n", ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+int main( void )
+{
+    int failures = 0;
+
+    if( !TestBlockGenerator() )
+        ++failures;
+    if( !TestNoiseShaping() )
+        ++failures;
+    if( !TestBufferProcessor() )
+        ++failures;
+
+    printf( "%d failures\n", failures );
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,493 @@
+/** @file patest_pass_through.c
+    @ingroup test_src
+    @brief Verify that the buffer processor passes host buffers directly to
+    the stream callback when no copy is needed, converts paInt32 host buffers
+    to and from paFloat32 in place, and reports this through
+    PaUtil_GetBufferProcessorStreamInfoFlags(), which backs the flags field
+    of PaStreamInfo. Host buffers which are not aligned to 64 bytes are
+    not passed through, and the callback's buffers always are.
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_process.h"
+
+#define CHANNEL_COUNT       (2)
+#define USER_FRAMES         (64)
+#define HOST_FRAMES         (128)
+#define INPUT_VALUE         (0.25f)
+#define OUTPUT_VALUE        (0.5f)
+#define ALIGNMENT           (64)
+
+/* the first address of storage aligned to ALIGNMENT, plus offset samples */
+#define ALIGNED_BUFFER( type, storage, offset ) \
+    ((type*)(((size_t)(storage) + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1)) + (offset))
+
+typedef struct
+{
+    const void *input;  /* the buffers the callback was last called with */
+    void *output;
+    int nonInterleaved;
+    int inputIsCorrect;
+    int buffersAreAligned;
+    unsigned long callCount;
+}
+CallbackData;
+
+static int IsAligned( const void *p )
+{
+    return ((size_t)p & (ALIGNMENT - 1)) == 0;
+}
+
+static int StreamCallback( const void *input, void *output, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    CallbackData *data = (CallbackData*)userData;
+    unsigned long i, sampleCount = frameCount * CHANNEL_COUNT;
+    int c;
+
+    (void) timeInfo; /* Prevent unused variable warnings. */
+    (void) statusFlags;
+
+    data->input = data->nonInterleaved && input ? ((const void * const *)input)[0] : input;
+    data->output = data->nonInterleaved && output ? ((void **)output)[0] : output;
+    ++data->callCount;
+
+    for( c=0; c < (data->nonInterleaved ? CHANNEL_COUNT : 1); ++c )
+    {
+        if( ( input && !IsAligned( data->nonInterleaved ? ((const void * const *)input)[c] : input ) )
+                || ( output && !IsAligned( data->nonInterleaved ? ((void **)output)[c] : output ) ) )
+            data->buffersAreAligned = 0;
+    }
+
+    if( input )
+    {
+        for( c=0; c < (data->nonInterleaved ? CHANNEL_COUNT : 1); ++c )
+        {
+            const float *in = data->nonInterleaved ? ((const float * const *)input)[c] : (const float*)input;
+            for( i=0; i < (data->nonInterleaved ? frameCount : sampleCount); ++i )
+            {
+                if( in[i] != INPUT_VALUE )
+                    data->inputIsCorrect = 0;
+            }
+        }
+    }
+
+    if( output )
+    {
+        for( c=0; c < (data->nonInterleaved ? CHANNEL_COUNT : 1); ++c )
+        {
+            float *out = data->nonInterleaved ? ((float **)output)[c] : (float*)output;
+            for( i=0; i < (data->nonInterleaved ? frameCount : sampleCount); ++i )
+                out[i] = OUTPUT_VALUE;
+        }
+    }
+
+    return paContinue;
+}
+
+/* fills a host buffer of HOST_FRAMES frames with value in the given format */
+static void FillHostBuffer( void *buffer, PaSampleFormat format, float value )
+{
+    int i;
+
+    for( i=0; i < HOST_FRAMES * CHANNEL_COUNT; ++i )
+    {
+        if( (format & ~paNonInterleaved) == paInt32 )
+            ((PaInt32*)buffer)[i] = (PaInt32)(value * 2147483648.f);
+        else
+            ((float*)buffer)[i] = value;
+    }
+}
+
+static int HostBufferHolds( void *buffer, PaSampleFormat format, float value, unsigned long frameCount )
+{
+    unsigned long i;
+
+    for( i=0; i < frameCount * CHANNEL_COUNT; ++i )
+    {
+        if( (format & ~paNonInterleaved) == paInt32 )
+        {
+            /* allow for dither */
+            PaInt32 expected = (PaInt32)(value * 2147483648.f);
+            PaInt32 difference = ((PaInt32*)buffer)[i] - expected;
+            if( difference < -256 || difference > 256 )
+                return 0;
+        }
+        else if( ((float*)buffer)[i] != value )
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Runs one full duplex host buffer of HOST_FRAMES frames through a buffer
+    processor with the given formats. Checks where the callback's buffers
+    pointed and the flags reported afterwards. */
+static int TestFullDuplex( const char *name, PaSampleFormat userFormat, PaSampleFormat hostFormat,
+        int inputIsWritable, int hostOffset, int expectInputPassThrough, int expectOutputPassThrough )
+{
+    static PaInt32 hostInputStorage[ HOST_FRAMES * CHANNEL_COUNT + ALIGNMENT ];
+    static PaInt32 hostOutputStorage[ HOST_FRAMES * CHANNEL_COUNT + ALIGNMENT ];
+    PaInt32 *hostInput = ALIGNED_BUFFER( PaInt32, hostInputStorage, hostOffset );
+    PaInt32 *hostOutput = ALIGNED_BUFFER( PaInt32, hostOutputStorage, hostOffset );
+    PaUtilBufferProcessor bp;
+    PaStreamCallbackTimeInfo timeInfo;
+    CallbackData data;
+    PaStreamInfoFlags flags, expectedFlags;
+    int callbackResult = paContinue;
+    int c, ok = 1;
+
+    memset( &data, 0, sizeof(data) );
+    data.nonInterleaved = (userFormat & paNonInterleaved) ? 1 : 0;
+    data.inputIsCorrect = 1;
+    data.buffersAreAligned = 1;
+
+    if( PaUtil_InitializeBufferProcessor( &bp, CHANNEL_COUNT, userFormat, hostFormat,
+            CHANNEL_COUNT, userFormat, hostFormat,
+            44100., paNoFlag, USER_FRAMES, HOST_FRAMES,
+            paUtilFixedHostBufferSize, StreamCallback, &data ) != paNoError )
+    {
+        printf( "%s: PaUtil_InitializeBufferProcessor failed\n", name );
+        return 0;
+    }
+    PaUtil_SetHostInputBufferIsWritable( &bp, inputIsWritable );
+
+    FillHostBuffer( hostInput, hostFormat, INPUT_VALUE );
+    FillHostBuffer( hostOutput, hostFormat, 0.f );
+
+    memset( &timeInfo, 0, sizeof(timeInfo) );
+    PaUtil_BeginBufferProcessing( &bp, &timeInfo, 0 );
+    PaUtil_SetInputFrameCount( &bp, HOST_FRAMES );
+    PaUtil_SetOutputFrameCount( &bp, HOST_FRAMES );
+    if( hostFormat & paNonInterleaved )
+    {
+        for( c=0; c < CHANNEL_COUNT; ++c )
+        {
+            PaUtil_SetNonInterleavedInputChannel( &bp, c, hostInput + c * HOST_FRAMES );
+            PaUtil_SetNonInterleavedOutputChannel( &bp, c, hostOutput + c * HOST_FRAMES );
+        }
+    }
+    else
+    {
+        PaUtil_SetInterleavedInputChannels( &bp, 0, hostInput, CHANNEL_COUNT );
+        PaUtil_SetInterleavedOutputChannels( &bp, 0, hostOutput, CHANNEL_COUNT );
+    }
+    PaUtil_EndBufferProcessing( &bp, &callbackResult );
+
+    flags = PaUtil_GetBufferProcessorStreamInfoFlags( &bp );
+    expectedFlags = (expectInputPassThrough ? paStreamInfoInputPassThrough : 0)
+            | (expectOutputPassThrough ? paStreamInfoOutputPassThrough : 0)
+            | paStreamInfoAlignedBuffers;
+
+    if( data.callCount != HOST_FRAMES / USER_FRAMES )
+    {
+        printf( "%s: the callback was called %lu times\n", name, data.callCount );
+        ok = 0;
+    }
+    if( flags != expectedFlags )
+    {
+        printf( "%s: flags are 0x%lx, expected 0x%lx\n", name, flags, expectedFlags );
+        ok = 0;
+    }
+    /* the last callback received the second user buffer of the host buffer */
+    if( (data.input == (const void*)(hostInput + USER_FRAMES * (data.nonInterleaved ? 1 : CHANNEL_COUNT)))
+            != expectInputPassThrough )
+    {
+        printf( "%s: input buffer %s the host buffer\n", name, expectInputPassThrough ? "is not" : "is" );
+        ok = 0;
+    }
+    if( (data.output == (void*)(hostOutput + USER_FRAMES * (data.nonInterleaved ? 1 : CHANNEL_COUNT)))
+            != expectOutputPassThrough )
+    {
+        printf( "%s: output buffer %s the host buffer\n", name, expectOutputPassThrough ? "is not" : "is" );
+        ok = 0;
+    }
+    if( !data.inputIsCorrect )
+    {
+        printf( "%s: the callback received wrong input samples\n", name );
+        ok = 0;
+    }
+    if( !data.buffersAreAligned )
+    {
+        printf( "%s: the callback received buffers which are not aligned\n", name );
+        ok = 0;
+    }
+    if( !HostBufferHolds( hostOutput, hostFormat, OUTPUT_VALUE, HOST_FRAMES ) )
+    {
+        printf( "%s: the host output buffer holds wrong samples\n", name );
+        ok = 0;
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    printf( "%s: %s\n", name, ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+/* An output only stream with a bounded host buffer size uses the adapting
+    processor, but host buffers which hold whole user buffers are still
+    passed through. */
+static int TestBoundedOutput( void )
+{
+    static float hostOutputStorage[ HOST_FRAMES * CHANNEL_COUNT + ALIGNMENT ];
+    float *hostOutput = ALIGNED_BUFFER( float, hostOutputStorage, 0 );
+    static const unsigned long hostFrameCounts[] = { HOST_FRAMES, USER_FRAMES / 2, USER_FRAMES / 2, USER_FRAMES };
+    static const int expectPassThrough[] = { 1, 0, 0, 1 };
+    PaUtilBufferProcessor bp;
+    PaStreamCallbackTimeInfo timeInfo;
+    CallbackData data;
+    int callbackResult = paContinue;
+    unsigned long framesProcessed;
+    int b, ok = 1;
+
+    memset( &data, 0, sizeof(data) );
+    data.inputIsCorrect = 1;
+
+    if( PaUtil_InitializeBufferProcessor( &bp, 0, 0, 0,
+            CHANNEL_COUNT, paFloat32, paFloat32,
+            44100., paNoFlag, USER_FRAMES, HOST_FRAMES,
+            paUtilBoundedHostBufferSize, StreamCallback, &data ) != paNoError )
+    {
+        printf( "bounded output: PaUtil_InitializeBufferProcessor failed\n" );
+        return 0;
+    }
+
+    for( b=0; b < (int)(sizeof(hostFrameCounts) / sizeof(hostFrameCounts[0])); ++b )
+    {
+        FillHostBuffer( hostOutput, paFloat32, 0.f );
+        data.output = 0;
+
+        memset( &timeInfo, 0, sizeof(timeInfo) );
+        PaUtil_BeginBufferProcessing( &bp, &timeInfo, 0 );
+        PaUtil_SetOutputFrameCount( &bp, hostFrameCounts[b] );
+        PaUtil_SetInterleavedOutputChannels( &bp, 0, hostOutput, CHANNEL_COUNT );
+        framesProcessed = PaUtil_EndBufferProcessing( &bp, &callbackResult );
+
+        if( framesProcessed != hostFrameCounts[b]
+                || !HostBufferHolds( hostOutput, paFloat32, OUTPUT_VALUE, hostFrameCounts[b] ) )
+        {
+            printf( "bounded output: host buffer %d was not filled\n", b );
+            ok = 0;
+        }
+        if( ((PaUtil_GetBufferProcessorStreamInfoFlags( &bp ) & paStreamInfoOutputPassThrough) != 0)
+                != expectPassThrough[b] )
+        {
+            printf( "bounded output: host buffer %d was %spassed through\n", b, expectPassThrough[b] ? "not " : "" );
+            ok = 0;
+        }
+        if( expectPassThrough[b] && data.output != (void*)(hostOutput +
+                (hostFrameCounts[b] - USER_FRAMES) * CHANNEL_COUNT) )
+        {
+            printf( "bounded output: the callback did not write host buffer %d\n", b );
+            ok = 0;
+        }
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    printf( "bounded output: %s\n", ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+/* User buffers of 100 stereo Int16 frames are 400 bytes long, so only the
+    first of the two in a host buffer is cache line aligned. The second one
+    goes through the temporary buffers, and must still be converted. */
+#define MARKER_USER_FRAMES  (100)
+#define MARKER_HOST_FRAMES  (200)
+#define MARKER_HOST_BUFFERS (3)
+
+typedef struct
+{
+    unsigned long framesDone;   /* frames passed to the callback so far */
+    int inputIsCorrect;
+}
+MarkerData;
+
+/* a distinct value for every sample of the stream */
+static PaInt16 Marker( unsigned long frame, int channel, int isOutput )
+{
+    return (PaInt16)((frame * CHANNEL_COUNT + channel) * (isOutput ? -1 : 1) % 30000);
+}
+
+static int MarkerCallback( const void *input, void *output, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    MarkerData *data = (MarkerData*)userData;
+    const PaInt16 *in = (const PaInt16*)input;
+    PaInt16 *out = (PaInt16*)output;
+    unsigned long f;
+    int c;
+
+    (void) timeInfo; /* Prevent unused variable warnings. */
+    (void) statusFlags;
+
+    for( f=0; f < frameCount; ++f )
+    {
+        for( c=0; c < CHANNEL_COUNT; ++c )
+        {
+            if( in[f * CHANNEL_COUNT + c] != Marker( data->framesDone + f, c, 0 ) )
+                data->inputIsCorrect = 0;
+            out[f * CHANNEL_COUNT + c] = Marker( data->framesDone + f, c, 1 );
+        }
+    }
+    data->framesDone += frameCount;
+
+    return paContinue;
+}
+
+static int TestUnalignedUserBuffers( void )
+{
+    static PaInt16 hostInputStorage[ MARKER_HOST_FRAMES * CHANNEL_COUNT + ALIGNMENT ];
+    static PaInt16 hostOutputStorage[ MARKER_HOST_FRAMES * CHANNEL_COUNT + ALIGNMENT ];
+    PaInt16 *hostInput = ALIGNED_BUFFER( PaInt16, hostInputStorage, 0 );
+    PaInt16 *hostOutput = ALIGNED_BUFFER( PaInt16, hostOutputStorage, 0 );
+    PaUtilBufferProcessor bp;
+    PaStreamCallbackTimeInfo timeInfo;
+    MarkerData data;
+    int callbackResult = paContinue;
+    unsigned long f, firstFrame, wrongSamples = 0;
+    int b, c, ok = 1;
+
+    memset( &data, 0, sizeof(data) );
+    data.inputIsCorrect = 1;
+
+    if( PaUtil_InitializeBufferProcessor( &bp, CHANNEL_COUNT, paInt16, paInt16,
+            CHANNEL_COUNT, paInt16, paInt16,
+            44100., paNoFlag, MARKER_USER_FRAMES, MARKER_HOST_FRAMES,
+            paUtilFixedHostBufferSize, MarkerCallback, &data ) != paNoError )
+    {
+        printf( "unaligned user buffers: PaUtil_InitializeBufferProcessor failed\n" );
+        return 0;
+    }
+
+    for( b=0; b < MARKER_HOST_BUFFERS; ++b )
+    {
+        firstFrame = b * MARKER_HOST_FRAMES;
+        for( f=0; f < MARKER_HOST_FRAMES; ++f )
+        {
+            for( c=0; c < CHANNEL_COUNT; ++c )
+            {
+                hostInput[f * CHANNEL_COUNT + c] = Marker( firstFrame + f, c, 0 );
+                hostOutput[f * CHANNEL_COUNT + c] = 0;
+            }
+        }
+
+        memset( &timeInfo, 0, sizeof(timeInfo) );
+        PaUtil_BeginBufferProcessing( &bp, &timeInfo, 0 );
+        PaUtil_SetInputFrameCount( &bp, MARKER_HOST_FRAMES );
+        PaUtil_SetInterleavedInputChannels( &bp, 0, hostInput, CHANNEL_COUNT );
+        PaUtil_SetOutputFrameCount( &bp, MARKER_HOST_FRAMES );
+        PaUtil_SetInterleavedOutputChannels( &bp, 0, hostOutput, CHANNEL_COUNT );
+        PaUtil_EndBufferProcessing( &bp, &callbackResult );
+
+        for( f=0; f < MARKER_HOST_FRAMES; ++f )
+        {
+            for( c=0; c < CHANNEL_COUNT; ++c )
+            {
+                if( hostOutput[f * CHANNEL_COUNT + c] != Marker( firstFrame + f, c, 1 ) )
+                    ++wrongSamples;
+            }
+        }
+    }
+
+    if( data.framesDone != MARKER_HOST_FRAMES * MARKER_HOST_BUFFERS )
+    {
+        printf( "unaligned user buffers: the callback processed %lu frames\n", data.framesDone );
+        ok = 0;
+    }
+    if( !data.inputIsCorrect )
+    {
+        printf( "unaligned user buffers: the callback received wrong input samples\n" );
+        ok = 0;
+    }
+    if( wrongSamples )
+    {
+        printf( "unaligned user buffers: %lu of %d output samples are wrong\n", wrongSamples,
+                MARKER_HOST_FRAMES * MARKER_HOST_BUFFERS * CHANNEL_COUNT );
+        ok = 0;
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    printf( "unaligned user buffers: %s\n", ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+int main( void )
+{
+    int failures = 0;
+
+    PaUtil_InitializeConverters();
+
+    if( !TestFullDuplex( "Float32", paFloat32, paFloat32, 0, 0, 1, 1 ) )
+        ++failures;
+    if( !TestFullDuplex( "non-interleaved Float32", paFloat32 | paNonInterleaved,
+            paFloat32 | paNonInterleaved, 0, 0, 1, 1 ) )
+        ++failures;
+    if( !TestFullDuplex( "Float32 to interleaved Float32", paFloat32 | paNonInterleaved, paFloat32, 0, 0, 0, 0 ) )
+        ++failures;
+    if( !TestFullDuplex( "Int32 read only input", paFloat32, paInt32, 0, 0, 0, 1 ) )
+        ++failures;
+    if( !TestFullDuplex( "Int32 in place", paFloat32, paInt32, 1, 0, 1, 1 ) )
+        ++failures;
+    if( !TestFullDuplex( "non-interleaved Int32 in place", paFloat32 | paNonInterleaved,
+            paInt32 | paNonInterleaved, 1, 0, 1, 1 ) )
+        ++failures;
+    if( !TestFullDuplex( "misaligned Float32", paFloat32, paFloat32, 0, 1, 0, 0 ) )
+        ++failures;
+    if( !TestFullDuplex( "misaligned non-interleaved Float32", paFloat32 | paNonInterleaved,
+            paFloat32 | paNonInterleaved, 0, 1, 0, 0 ) )
+        ++failures;
+    if( !TestBoundedOutput() )
+        ++failures;
+    if( !TestUnalignedUserBuffers() )
+        ++failures;
+
+    printf( "%d failures\n", failures );
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+/** @file patest_pulseaudio_blocking.c
+    @ingroup test_src
+    @brief Measure the CPU usage and wakeup jitter of blocking Pa_WriteStream()
+    calls on the PulseAudio host API.
+
+    One or more blocking output streams write silence for a few seconds, each
+    from its own thread. The program prints the process CPU time as a
+    percentage of the elapsed time, and for every stream the mean and worst
+    deviation of the intervals between Pa_WriteStream() returns from the
+    buffer period.
+
+    Run it against a null sink so that no audio hardware is involved and the
+    numbers only reflect the client side:
+
+        pactl load-module module-null-sink sink_name=patest
+        PULSE_SINK=patest ./patest_pulseaudio_blocking --streams 4
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "portaudio.h"
+
+#define SAMPLE_RATE         (48000)
+#define CHANNEL_COUNT       (2)
+#define FRAMES_PER_BUFFER   (256)
+#define NUM_SECONDS         (5)
+#define MAX_STREAMS         (16)
+
+typedef struct
+{
+    PaStream *stream;
+    unsigned long writeCount;
+    double intervalSum;         /* seconds */
+    double worstDeviation;      /* seconds */
+    PaError error;
+}
+StreamBenchmark;
+
+static double GetMonotonicTime( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double GetProcessCpuTime( void )
+{
+    struct rusage usage;
+
+    getrusage( RUSAGE_SELF, &usage );
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6
+            + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+}
+
+static void *WriterThread( void *userData )
+{
+    StreamBenchmark *b = (StreamBenchmark*)userData;
+    static const float silence[FRAMES_PER_BUFFER * CHANNEL_COUNT];
+    const double period = (double)FRAMES_PER_BUFFER / SAMPLE_RATE;
+    unsigned long i, bufferCount = (unsigned long)(NUM_SECONDS * SAMPLE_RATE / FRAMES_PER_BUFFER);
+    double previous, now;
+
+    previous = GetMonotonicTime();
+    for( i=0; i < bufferCount; ++i )
+    {
+        b->error = Pa_WriteStream( b->stream, silence, FRAMES_PER_BUFFER );
+        if( b->error != paNoError && b->error != paOutputUnderflowed )
+            break;
+        b->error = paNoError;
+
+        now = GetMonotonicTime();
+        /* the first writes only fill the server buffer and return at once */
+        if( i >= bufferCount / 10 )
+        {
+            b->intervalSum += now - previous;
+            if( fabs( (now - previous) - period ) > b->worstDeviation )
+                b->worstDeviation = fabs( (now - previous) - period );
+            ++b->writeCount;
+        }
+        previous = now;
+    }
+    return NULL;
+}
+
+int main( int argc, char **argv );
+int main( int argc, char **argv )
+{
+    static StreamBenchmark benchmarks[MAX_STREAMS];
+    pthread_t threads[MAX_STREAMS];
+    PaStreamParameters outputParameters;
+    const PaHostApiInfo *hostApiInfo;
+    PaHostApiIndex hostApi;
+    PaError err;
+    int i, streamCount = 1, openCount = 0, result = 0;
+    double startTime, startCpu, elapsed, cpu;
+
+    if( argc == 3 && strcmp( argv[1], "--streams" ) == 0 )
+        streamCount = atoi( argv[2] );
+    else if( argc != 1 )
+    {
+        printf( "usage: %s [--streams N]\n", argv[0] );
+        return 2;
+    }
+    if( streamCount < 1 || streamCount > MAX_STREAMS )
+    {
+        printf( "the stream count must be between 1 and %d\n", MAX_STREAMS );
+        return 2;
+    }
+
+    err = Pa_Initialize();
+    if( err != paNoError )
+        goto error;
+
+    hostApi = Pa_HostApiTypeIdToHostApiIndex( paPulseAudio );
+    if( hostApi < 0 )
+    {
+        printf( "PulseAudio host API not available.\n" );
+        Pa_Terminate();
+        return 1;
+    }
+    hostApiInfo = Pa_GetHostApiInfo( hostApi );
+    if( hostApiInfo->defaultOutputDevice == paNoDevice )
+    {
+        printf( "No PulseAudio output device.\n" );
+        Pa_Terminate();
+        return 1;
+    }
+
+    memset( &outputParameters, 0, sizeof(outputParameters) );
+    outputParameters.device = hostApiInfo->defaultOutputDevice;
+    outputParameters.channelCount = CHANNEL_COUNT;
+    outputParameters.sampleFormat = paFloat32;
+    outputParameters.suggestedLatency = Pa_GetDeviceInfo( outputParameters.device )->defaultLowOutputLatency;
+    outputParameters.hostApiSpecificStreamInfo = NULL;
+
+    for( openCount=0; openCount < streamCount; ++openCount )
+    {
+        err = Pa_OpenStream( &benchmarks[openCount].stream, NULL, &outputParameters, SAMPLE_RATE,
+                FRAMES_PER_BUFFER, paClipOff, NULL, NULL );
+        if( err != paNoError )
+            goto error;
+        err = Pa_StartStream( benchmarks[openCount].stream );
+        if( err != paNoError )
+        {
+            Pa_CloseStream( benchmarks[openCount].stream );
+            goto error;
+        }
+    }
+
+    printf( "%d stream(s), %d frames per buffer at %d Hz on %s\n", streamCount,
+            FRAMES_PER_BUFFER, SAMPLE_RATE, Pa_GetDeviceInfo( outputParameters.device )->name );
+
+    startTime = GetMonotonicTime();
+    startCpu = GetProcessCpuTime();
+    for( i=0; i < streamCount; ++i )
+        pthread_create( &threads[i], NULL, WriterThread, &benchmarks[i] );
+    for( i=0; i < streamCount; ++i )
+        pthread_join( threads[i], NULL );
+    elapsed = GetMonotonicTime() - startTime;
+    cpu = GetProcessCpuTime() - startCpu;
+
+    printf( "cpu: %.2f%% of one core over %.2f s\n", 100. * cpu / elapsed, elapsed );
+    printf( "stream,writes,meanIntervalMs,periodMs,worstDeviationMs\n" );
+    for( i=0; i < streamCount; ++i )
+    {
+        StreamBenchmark *b = &benchmarks[i];
+
+        if( b->error != paNoError )
+        {
+            printf( "FAIL: stream %d: %s\n", i, Pa_GetErrorText( b->error ) );
+            result = 1;
+            continue;
+        }
+        printf( "%d,%lu,%.3f,%.3f,%.3f\n", i, b->writeCount,
+                b->writeCount ? 1000. * b->intervalSum / b->writeCount : 0.,
+                1000. * FRAMES_PER_BUFFER / SAMPLE_RATE, 1000. * b->worstDeviation );
+    }
+
+    for( i=0; i < streamCount; ++i )
+    {
+        Pa_StopStream( benchmarks[i].stream );
+        Pa_CloseStream( benchmarks[i].stream );
+    }
+    Pa_Terminate();
+    return result;
+
+error:
+    for( i=0; i < openCount; ++i )
+        Pa_CloseStream( benchmarks[i].stream );
+    Pa_Terminate();
+    fprintf( stderr, "An error occurred while using the portaudio stream\n" );
+    fprintf( stderr, "Error number: %d\n", err );
+    fprintf( stderr, "Error message: %s\n", Pa_GetErrorText( err ) );
+    return 1;
+}
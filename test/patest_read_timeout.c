@@ -0,0 +1,221 @@
+/** @file patest_read_timeout.c
+    @ingroup test_src
+    @brief Check that Pa_ReadStreamTimeout() and Pa_WriteStreamTimeout() give
+    up after the timeout with a partial frame count, and complete normally
+    when there is enough time.
+
+    The default input and output devices are used. Host APIs which don't
+    support timeouts are reported and skipped.
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "portaudio.h"
+
+#define SAMPLE_RATE         (44100)
+#define FRAMES_PER_BUFFER   (512)
+#define LONG_FRAMES         (SAMPLE_RATE * 10)  /* far more than any host buffer */
+#define SHORT_FRAMES        (SAMPLE_RATE / 10)
+#define TIMEOUT             (0.2)
+
+static int failureCount_ = 0;
+
+#define CHECK( condition, message ) \
+    do{ if( !(condition) ){ printf( "FAIL: %s\n", message ); ++failureCount_; } }while(0)
+
+static float samples_[LONG_FRAMES];
+
+/* paInputOverflowed and paOutputUnderflowed aren't failures here */
+static int IsTransferError( PaError err )
+{
+    return err != paNoError && err != paInputOverflowed && err != paOutputUnderflowed;
+}
+
+static PaError TestInput( void )
+{
+    PaStreamParameters inputParameters;
+    PaStream *stream;
+    unsigned long framesRead = 1;
+    PaTime start, elapsed;
+    PaError err;
+
+    memset( &inputParameters, 0, sizeof(inputParameters) );
+    inputParameters.device = Pa_GetDefaultInputDevice();
+    if( inputParameters.device == paNoDevice )
+    {
+        printf( "No default input device, skipping reads.\n" );
+        return paNoError;
+    }
+    inputParameters.channelCount = 1;
+    inputParameters.sampleFormat = paFloat32;
+    inputParameters.suggestedLatency = Pa_GetDeviceInfo( inputParameters.device )->defaultLowInputLatency;
+
+    err = Pa_OpenStream( &stream, &inputParameters, NULL, SAMPLE_RATE, FRAMES_PER_BUFFER, paClipOff, NULL, NULL );
+    if( err != paNoError )
+        return err;
+    err = Pa_StartStream( stream );
+    if( err != paNoError )
+        goto done;
+
+    /* A zero timeout only takes what is already there */
+    start = Pa_GetStreamTime( stream );
+    err = Pa_ReadStreamTimeout( stream, samples_, LONG_FRAMES, 0., &framesRead );
+    if( err == paIncompatibleStreamHostApi )
+    {
+        printf( "Read timeouts aren't supported by %s.\n",
+                Pa_GetHostApiInfo( Pa_GetDeviceInfo( inputParameters.device )->hostApi )->name );
+        CHECK( framesRead == 0, "frame count wasn't cleared" );
+        err = paNoError;
+        goto done;
+    }
+    elapsed = Pa_GetStreamTime( stream ) - start;
+    printf( "read, timeout 0: %s, %lu frames in %.3f s\n", Pa_GetErrorText( err ), framesRead, elapsed );
+    CHECK( err == paTimedOut, "zero timeout read didn't time out" );
+    CHECK( framesRead < LONG_FRAMES, "zero timeout read returned too many frames" );
+    CHECK( elapsed < TIMEOUT, "zero timeout read blocked" );
+
+    start = Pa_GetStreamTime( stream );
+    err = Pa_ReadStreamTimeout( stream, samples_, LONG_FRAMES, TIMEOUT, &framesRead );
+    elapsed = Pa_GetStreamTime( stream ) - start;
+    printf( "read, timeout %.3f: %s, %lu frames in %.3f s\n", TIMEOUT, Pa_GetErrorText( err ), framesRead, elapsed );
+    CHECK( err == paTimedOut, "long read didn't time out" );
+    CHECK( framesRead > 0 && framesRead < LONG_FRAMES, "timed out read returned a wrong frame count" );
+    CHECK( elapsed >= TIMEOUT * 0.9 && elapsed < TIMEOUT * 3, "timed out read took a wrong time" );
+
+    err = Pa_ReadStreamTimeout( stream, samples_, SHORT_FRAMES, 1., NULL );
+    printf( "read, timeout 1.000: %s\n", Pa_GetErrorText( err ) );
+    CHECK( !IsTransferError( err ), "short read failed" );
+
+    err = Pa_StopStream( stream );
+
+done:
+    Pa_CloseStream( stream );
+    return err;
+}
+
+static PaError TestOutput( void )
+{
+    PaStreamParameters outputParameters;
+    PaStream *stream;
+    unsigned long framesWritten = 1;
+    PaTime start, elapsed;
+    PaError err;
+
+    memset( &outputParameters, 0, sizeof(outputParameters) );
+    outputParameters.device = Pa_GetDefaultOutputDevice();
+    if( outputParameters.device == paNoDevice )
+    {
+        printf( "No default output device, skipping writes.\n" );
+        return paNoError;
+    }
+    outputParameters.channelCount = 1;
+    outputParameters.sampleFormat = paFloat32;
+    outputParameters.suggestedLatency = Pa_GetDeviceInfo( outputParameters.device )->defaultLowOutputLatency;
+
+    err = Pa_OpenStream( &stream, NULL, &outputParameters, SAMPLE_RATE, FRAMES_PER_BUFFER, paClipOff, NULL, NULL );
+    if( err != paNoError )
+        return err;
+    err = Pa_StartStream( stream );
+    if( err != paNoError )
+        goto done;
+
+    memset( samples_, 0, sizeof(samples_) );
+    start = Pa_GetStreamTime( stream );
+    err = Pa_WriteStreamTimeout( stream, samples_, LONG_FRAMES, TIMEOUT, &framesWritten );
+    if( err == paIncompatibleStreamHostApi )
+    {
+        printf( "Write timeouts aren't supported by %s.\n",
+                Pa_GetHostApiInfo( Pa_GetDeviceInfo( outputParameters.device )->hostApi )->name );
+        CHECK( framesWritten == 0, "frame count wasn't cleared" );
+        err = paNoError;
+        goto done;
+    }
+    elapsed = Pa_GetStreamTime( stream ) - start;
+    printf( "write, timeout %.3f: %s, %lu frames in %.3f s\n", TIMEOUT, Pa_GetErrorText( err ), framesWritten, elapsed );
+    CHECK( err == paTimedOut, "long write didn't time out" );
+    CHECK( framesWritten > 0 && framesWritten < LONG_FRAMES, "timed out write returned a wrong frame count" );
+    CHECK( elapsed < TIMEOUT * 3, "timed out write took too long" );
+
+    /* the buffer is full now, so nothing fits without waiting */
+    err = Pa_WriteStreamTimeout( stream, samples_, LONG_FRAMES, 0., &framesWritten );
+    printf( "write, timeout 0: %s, %lu frames\n", Pa_GetErrorText( err ), framesWritten );
+    CHECK( err == paTimedOut, "zero timeout write didn't time out" );
+    CHECK( framesWritten < LONG_FRAMES, "zero timeout write returned too many frames" );
+
+    err = Pa_WriteStreamTimeout( stream, samples_, SHORT_FRAMES, 1., NULL );
+    printf( "write, timeout 1.000: %s\n", Pa_GetErrorText( err ) );
+    CHECK( !IsTransferError( err ), "short write failed" );
+
+    err = Pa_StopStream( stream );
+
+done:
+    Pa_CloseStream( stream );
+    return err;
+}
+
+int main(void);
+int main(void)
+{
+    PaError err;
+
+    err = Pa_Initialize();
+    if( err != paNoError )
+        goto error;
+
+    err = TestInput();
+    if( err != paNoError )
+        goto error;
+
+    err = TestOutput();
+    if( err != paNoError )
+        goto error;
+
+    Pa_Terminate();
+    printf( "%d failures\n", failureCount_ );
+    return failureCount_ ? 1 : 0;
+
+error:
+    Pa_Terminate();
+    fprintf( stderr, "An error occurred while using the portaudio stream\n" );
+    fprintf( stderr, "Error number: %d\n", err );
+    fprintf( stderr, "Error message: %s\n", Pa_GetErrorText( err ) );
+    return 1;
+}
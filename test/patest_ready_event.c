@@ -0,0 +1,253 @@
+/** @file patest_ready_event.c
+    @ingroup test_src
+    @brief Verify the UNIX stream readiness descriptors behind
+    Pa_GetStreamReadyFileDescriptor(): that a signalled descriptor follows
+    the available frame count through PaUnixReadyEvent_Update(), that
+    repeated signals collapse into a single readable state, that no wakeup is
+    lost when the audio thread signals while the application clears, and
+    that a descriptor created from poll descriptors becomes readable with
+    them.
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "portaudio.h"
+#include "pa_unix_ready_event.h"
+
+static int failureCount_ = 0;
+
+#define CHECK( condition, message ) \
+    do{ if( !(condition) ){ printf( "FAIL: %s\n", message ); ++failureCount_; } }while(0)
+
+static signed long available_ = 0;
+
+static signed long GetAvailable( PaStream *stream )
+{
+    (void) stream;
+    return __atomic_load_n( &available_, __ATOMIC_ACQUIRE );
+}
+
+static int IsReadable( int fd )
+{
+    struct pollfd pfd;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return poll( &pfd, 1, 0 ) == 1 && (pfd.revents & POLLIN);
+}
+
+static void TestSignalled( void )
+{
+    PaUnixReadyEvent event;
+
+    PaUnixReadyEvent_Initialize( &event );
+    CHECK( !PaUnixReadyEvent_IsCreated( &event ), "initialized event has a descriptor" );
+    PaUnixReadyEvent_Update( &event, NULL, GetAvailable ); /* must be harmless */
+
+    if( PaUnixReadyEvent_CreateSignalled( &event ) != paNoError )
+    {
+        CHECK( 0, "couldn't create a signalled descriptor" );
+        return;
+    }
+    CHECK( PaUnixReadyEvent_IsCreated( &event ), "created event has no descriptor" );
+    CHECK( !IsReadable( event.fd ), "new descriptor is readable" );
+
+    event.frames = 256;
+    available_ = 255;
+    PaUnixReadyEvent_Update( &event, NULL, GetAvailable );
+    CHECK( !IsReadable( event.fd ), "readable below the threshold" );
+
+    available_ = 256;
+    PaUnixReadyEvent_Update( &event, NULL, GetAvailable );
+    CHECK( IsReadable( event.fd ), "not readable at the threshold" );
+
+    /* signalling again must not queue up a second event */
+    PaUnixReadyEvent_Signal( &event );
+    PaUnixReadyEvent_Update( &event, NULL, GetAvailable );
+    available_ = 10;
+    PaUnixReadyEvent_Update( &event, NULL, GetAvailable );
+    CHECK( !IsReadable( event.fd ), "still readable after the frames were consumed" );
+
+    available_ = paStreamIsStopped;
+    PaUnixReadyEvent_Update( &event, NULL, GetAvailable );
+    CHECK( IsReadable( event.fd ), "not readable for a stopped stream" );
+
+    available_ = 0;
+    PaUnixReadyEvent_Update( &event, NULL, GetAvailable );
+    CHECK( !IsReadable( event.fd ), "not cleared after the stream restarted" );
+
+    PaUnixReadyEvent_Terminate( &event );
+    CHECK( !PaUnixReadyEvent_IsCreated( &event ), "terminated event has a descriptor" );
+}
+
+#define STRESS_FRAMES       (256)
+#define STRESS_BUFFERS      (200000)
+
+static volatile int stopProducer_ = 0;
+
+/* plays the audio thread of JACK or PulseAudio, which adds frames and
+    updates the event while the application consumes them */
+static void *ProducerThreadFunc( void *userData )
+{
+    PaUnixReadyEvent *event = (PaUnixReadyEvent*)userData;
+
+    /* refill as soon as the application has consumed a buffer, which is
+        when it clears the event */
+    while( !stopProducer_ )
+    {
+        if( GetAvailable( NULL ) < STRESS_FRAMES )
+            __atomic_add_fetch( &available_, STRESS_FRAMES, __ATOMIC_RELEASE );
+        PaUnixReadyEvent_Update( event, NULL, GetAvailable );
+    }
+
+    return NULL;
+}
+
+/* Consumes buffers as an application polling the descriptor would, so that
+    the audio thread's updates race with the application's clears. Once a
+    wakeup is lost the descriptor stays unreadable with frames available. */
+static void TestConcurrentUpdates( void )
+{
+    PaUnixReadyEvent event;
+    pthread_t producer;
+    struct pollfd pfd;
+    int buffers, lostWakeups = 0;
+
+    PaUnixReadyEvent_Initialize( &event );
+    if( PaUnixReadyEvent_CreateSignalled( &event ) != paNoError )
+    {
+        CHECK( 0, "couldn't create a signalled descriptor" );
+        return;
+    }
+    event.frames = STRESS_FRAMES;
+    available_ = 0;
+    stopProducer_ = 0;
+
+    if( pthread_create( &producer, NULL, ProducerThreadFunc, &event ) != 0 )
+    {
+        CHECK( 0, "couldn't create the producer thread" );
+        PaUnixReadyEvent_Terminate( &event );
+        return;
+    }
+
+    for( buffers=0; buffers < STRESS_BUFFERS && !lostWakeups; )
+    {
+        pfd.fd = event.fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if( poll( &pfd, 1, 1000 ) == 0 && GetAvailable( NULL ) >= STRESS_FRAMES )
+            ++lostWakeups;
+
+        if( GetAvailable( NULL ) >= STRESS_FRAMES )
+        {
+            __atomic_sub_fetch( &available_, STRESS_FRAMES, __ATOMIC_RELEASE );
+            ++buffers;
+        }
+        PaUnixReadyEvent_Update( &event, NULL, GetAvailable );
+    }
+
+    stopProducer_ = 1;
+    pthread_join( producer, NULL );
+
+    printf( "%d buffers consumed by polling\n", buffers );
+    CHECK( !lostWakeups, "a wakeup was lost, the descriptor isn't readable with frames available" );
+
+    PaUnixReadyEvent_Terminate( &event );
+}
+
+static void TestFromDescriptors( void )
+{
+    PaUnixReadyEvent event;
+    struct pollfd pfds[2];
+    int fds[2];
+    char c = 0;
+    PaError err;
+
+    if( pipe( fds ) != 0 )
+    {
+        CHECK( 0, "couldn't create a pipe" );
+        return;
+    }
+
+    /* the same descriptor twice, as some devices report it */
+    pfds[0].fd = pfds[1].fd = fds[0];
+    pfds[0].events = pfds[1].events = POLLIN;
+
+    PaUnixReadyEvent_Initialize( &event );
+    err = PaUnixReadyEvent_CreateFromDescriptors( &event, pfds, 2 );
+    if( err == paIncompatibleStreamHostApi )
+    {
+        printf( "descriptor sets are not supported on this platform\n" );
+    }
+    else if( err != paNoError )
+    {
+        CHECK( 0, "couldn't create a descriptor set" );
+    }
+    else
+    {
+        CHECK( !IsReadable( event.fd ), "readable before the pipe was written" );
+        CHECK( write( fds[1], &c, 1 ) == 1, "couldn't write to the pipe" );
+        CHECK( IsReadable( event.fd ), "not readable after the pipe was written" );
+        CHECK( read( fds[0], &c, 1 ) == 1, "couldn't read from the pipe" );
+        CHECK( !IsReadable( event.fd ), "still readable after the pipe was read" );
+
+        PaUnixReadyEvent_Terminate( &event );
+    }
+
+    close( fds[0] );
+    close( fds[1] );
+}
+
+int main(void);
+int main(void)
+{
+    TestSignalled();
+    TestConcurrentUpdates();
+    TestFromDescriptors();
+
+    printf( "%d failures\n", failureCount_ );
+    return failureCount_ ? 1 : 0;
+}
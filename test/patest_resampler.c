@@ -0,0 +1,462 @@
+/** @file patest_resampler.c
+    @ingroup test_src
+    @brief Verify that the polyphase sample rate converter reproduces a sine
+    wave within the accuracy of each quality, rejects aliases when
+    decimating, gives the same results with every SIMD kernel, and that a
+    buffer processor with a resampling stage calls the stream callback at
+    the user rate, reports its latency and plays the last buffer out after
+    the callback completes.
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "portaudio.h"
+#include "pa_process.h"
+#include "pa_resampler.h"
+#include "pa_simd_converters.h"
+
+#ifndef M_PI
+#define M_PI  (3.14159265358979323846)
+#endif
+
+#define SOURCE_FRAMES       (44100)
+#define WRITE_FRAMES        (441)
+#define MAX_OUTPUT_FRAMES   (3 * SOURCE_FRAMES)
+
+#define HOST_RATE           (48000.)
+#define USER_RATE           (44100.)
+#define HOST_FRAMES         (256)
+#define USER_FRAMES         (64)
+#define HOST_BUFFERS        (200)
+#define CHANNELS            (2)
+
+static float output_[ MAX_OUTPUT_FRAMES ];
+
+/* Converts SOURCE_FRAMES frames of a sine wave, written WRITE_FRAMES at a time,
+    to output_ with the given kernels and returns the number of frames read. */
+static unsigned long Convert( double sourceRate, double destinationRate, double frequency,
+        PaUtilResamplerQuality quality, unsigned int instructionSets, unsigned long *delay )
+{
+    PaUtilResampler resampler;
+    float source[ WRITE_FRAMES ];
+    unsigned long written = 0, read = 0, i;
+
+    if( PaUtil_InitializeResampler( &resampler, 1, sourceRate, destinationRate, quality,
+            WRITE_FRAMES ) != paNoError )
+        return 0;
+    PaUtil_SelectResamplerKernel( &resampler, instructionSets );
+    *delay = (unsigned long)ceil( PaUtil_GetResamplerDelay( &resampler ) );
+
+    while( written < SOURCE_FRAMES )
+    {
+        unsigned long available;
+
+        for( i=0; i < WRITE_FRAMES; ++i )
+            source[i] = (float)(.5 * sin( 2. * M_PI * frequency * (written + i) / sourceRate ));
+        if( PaUtil_GetResamplerWriteAvailable( &resampler ) < WRITE_FRAMES )
+        {
+            read = 0;
+            break;
+        }
+        PaUtil_WriteResampler( &resampler, source, WRITE_FRAMES );
+        written += WRITE_FRAMES;
+
+        available = PaUtil_GetResamplerReadAvailable( &resampler );
+        if( read + available > MAX_OUTPUT_FRAMES
+                || PaUtil_ReadResampler( &resampler, output_ + read, available ) != available
+                || PaUtil_GetResamplerReadAvailable( &resampler ) != 0 )
+        {
+            read = 0;
+            break;
+        }
+        read += available;
+    }
+
+    PaUtil_TerminateResampler( &resampler );
+    return read;
+}
+
+static int TestSine( const char *name, PaUtilResamplerQuality quality, double maxError )
+{
+    unsigned long delay, read, expected, n;
+    double error = 0.;
+
+    read = Convert( USER_RATE, HOST_RATE, 1000., quality, 0, &delay );
+
+    /* every destination frame whose filter is covered by the source */
+    expected = (unsigned long)floor( (SOURCE_FRAMES - delay) * HOST_RATE / USER_RATE );
+    if( read < expected - 1 || read > expected + 1 )
+    {
+        printf( "%s: read %lu frames, expected %lu\n", name, read, expected );
+        return 0;
+    }
+
+    /* skip the frames which depend on the silence before the sine */
+    for( n = 2 * delay; n < read; ++n )
+    {
+        double e = fabs( output_[n] - .5 * sin( 2. * M_PI * 1000. * n / HOST_RATE ) );
+        if( e > error )
+            error = e;
+    }
+
+    printf( "%s: maximum error %.1f dB\n", name, 20. * log10( error / .5 ) );
+    return error <= maxError;
+}
+
+/* A 30 kHz tone sampled at 96 kHz has no place below the 22.05 kHz Nyquist
+    frequency of 44.1 kHz, what is left of it is aliasing. */
+static int TestAliasRejection( const char *name, PaUtilResamplerQuality quality, double minRejection )
+{
+    unsigned long delay, read, n;
+    double peak = 0., rejection;
+
+    read = Convert( 96000., USER_RATE, 30000., quality, 0, &delay );
+    if( read == 0 )
+    {
+        printf( "%s: the conversion failed\n", name );
+        return 0;
+    }
+
+    for( n = 2 * delay; n < read; ++n )
+        peak = fabs( output_[n] ) > peak ? fabs( output_[n] ) : peak;
+
+    rejection = -20. * log10( peak / .5 + 1e-20 );
+    printf( "%s: alias rejection %.1f dB\n", name, rejection );
+    return rejection >= minRejection;
+}
+
+static int TestKernels( void )
+{
+    static const struct { unsigned int set; const char *name; } sets[] = {
+        { paUtilSimdGeneric, "generic" },
+        { paUtilSimdSse2, "SSE2" },
+        { paUtilSimdAvx2, "AVX2" }
+    };
+    static float reference[ MAX_OUTPUT_FRAMES ];
+    unsigned int available = PaUtil_GetAvailableSimdInstructionSets();
+    unsigned long delay, read, n;
+    int s, ok = 1;
+
+    read = Convert( HOST_RATE, USER_RATE, 1000., paUtilResamplerBest, 0, &delay );
+    memcpy( reference, output_, sizeof(float) * read );
+
+    for( s=0; s < 3; ++s )
+    {
+        double error = 0.;
+
+        if( !(available & sets[s].set) )
+        {
+            printf( "%s kernel: not available\n", sets[s].name );
+            continue;
+        }
+
+        if( Convert( HOST_RATE, USER_RATE, 1000., paUtilResamplerBest, sets[s].set, &delay ) != read )
+        {
+            printf( "%s kernel: the frame count differs\n", sets[s].name );
+            ok = 0;
+            continue;
+        }
+
+        for( n=0; n < read; ++n )
+            error = fabs( output_[n] - reference[n] ) > error ? fabs( output_[n] - reference[n] ) : error;
+
+        printf( "%s kernel: maximum difference from the scalar kernel %g\n", sets[s].name, error );
+        if( error > 1e-6 )
+            ok = 0;
+    }
+
+    return ok;
+}
+
+typedef struct
+{
+    unsigned long callCount;
+    int wrongFrameCount;
+    PaStreamCallbackFlags statusFlags;
+    unsigned long completeAtCall;   /**< return paComplete from this call, 0 for never */
+    unsigned long outputFrame;
+}
+StageData;
+
+/* Copies the input to the output of a full duplex stream, or writes a
+    1 kHz sine to non-interleaved paInt16 output. */
+static int StageCallback( const void *input, void *output, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    StageData *data = (StageData*)userData;
+    unsigned long i;
+    int c;
+
+    (void) timeInfo; /* Prevent unused variable warnings. */
+
+    if( frameCount != USER_FRAMES )
+        data->wrongFrameCount = 1;
+    data->statusFlags |= statusFlags;
+
+    if( input )
+    {
+        memcpy( output, input, sizeof(float) * CHANNELS * frameCount );
+    }
+    else
+    {
+        for( c=0; c < CHANNELS; ++c )
+        {
+            short *out = ((short**)output)[c];
+            for( i=0; i < frameCount; ++i )
+                out[i] = (short)(16384. * sin( 2. * M_PI * 1000. * (data->outputFrame + i) / USER_RATE ));
+        }
+        data->outputFrame += frameCount;
+    }
+
+    return ++data->callCount == data->completeAtCall ? paComplete : paContinue;
+}
+
+/* Runs host buffers through a buffer processor until the callback result is
+    not paContinue, and returns the number of buffers processed. The output
+    power after the first second is returned in *power. */
+static int ProcessHostBuffers( PaUtilBufferProcessor *bp, int hasInput, int buffers, double *power )
+{
+    static float hostInput[ HOST_FRAMES * CHANNELS ], hostOutput[ HOST_FRAMES * CHANNELS ];
+    PaStreamCallbackTimeInfo timeInfo;
+    int callbackResult = paContinue;
+    unsigned long frame = 0, i, powerFrames = 0;
+    int b, c;
+
+    *power = 0.;
+    memset( &timeInfo, 0, sizeof(timeInfo) );
+    for( b=0; b < buffers && callbackResult == paContinue; ++b )
+    {
+        for( i=0; i < HOST_FRAMES; ++i, ++frame )
+        {
+            for( c=0; c < CHANNELS; ++c )
+                hostInput[ i * CHANNELS + c ] = (float)(.5 * sin( 2. * M_PI * 1000. * frame / HOST_RATE ));
+        }
+
+        PaUtil_BeginBufferProcessing( bp, &timeInfo, 0 );
+        if( hasInput )
+        {
+            PaUtil_SetInputFrameCount( bp, HOST_FRAMES );
+            PaUtil_SetInterleavedInputChannels( bp, 0, hostInput, CHANNELS );
+        }
+        PaUtil_SetOutputFrameCount( bp, HOST_FRAMES );
+        PaUtil_SetInterleavedOutputChannels( bp, 0, hostOutput, CHANNELS );
+        PaUtil_EndBufferProcessing( bp, &callbackResult );
+
+        if( frame > HOST_RATE )
+        {
+            for( i=0; i < HOST_FRAMES * CHANNELS; ++i )
+                *power += hostOutput[i] * hostOutput[i];
+            powerFrames += HOST_FRAMES;
+        }
+    }
+
+    if( powerFrames > 0 )
+        *power /= powerFrames * CHANNELS;
+    return b;
+}
+
+static int TestStage( const char *name, int hasInput )
+{
+    PaUtilBufferProcessor bp;
+    StageData data;
+    double power, expectedPower;
+    unsigned long expectedCalls;
+    int buffers, ok = 1;
+
+    memset( &data, 0, sizeof(data) );
+
+    if( PaUtil_InitializeResamplingBufferProcessor( &bp,
+            hasInput ? CHANNELS : 0, paFloat32, paFloat32,
+            CHANNELS, hasInput ? paFloat32 : (paInt16 | paNonInterleaved), paFloat32,
+            USER_RATE, HOST_RATE, paConvertSampleRate, USER_FRAMES, HOST_FRAMES,
+            paUtilFixedHostBufferSize, StageCallback, &data ) != paNoError )
+    {
+        printf( "%s: PaUtil_InitializeResamplingBufferProcessor failed\n", name );
+        return 0;
+    }
+    PaUtil_ResetBufferProcessor( &bp );
+
+    if( PaUtil_GetBufferProcessorStreamInfoFlags( &bp ) != paStreamInfoSampleRateConverted
+            || PaUtil_GetBufferProcessorOutputLatencyFrames( &bp ) == 0
+            || (hasInput && PaUtil_GetBufferProcessorInputLatencyFrames( &bp ) == 0) )
+    {
+        printf( "%s: the stream info flags or the latency are wrong\n", name );
+        ok = 0;
+    }
+
+    ProcessHostBuffers( &bp, hasInput, HOST_BUFFERS, &power );
+
+    /* the callback runs ahead by at most a user buffer and the output filter */
+    expectedCalls = (unsigned long)(HOST_BUFFERS * HOST_FRAMES * USER_RATE / HOST_RATE / USER_FRAMES);
+    if( data.callCount < expectedCalls || data.callCount > expectedCalls + 3 || data.wrongFrameCount )
+    {
+        printf( "%s: the callback was called %lu times, expected %lu%s\n", name, data.callCount,
+                expectedCalls, data.wrongFrameCount ? " with the wrong frame count" : "" );
+        ok = 0;
+    }
+
+    if( data.statusFlags != 0 )
+    {
+        printf( "%s: the callback received the status flags 0x%lx\n", name, data.statusFlags );
+        ok = 0;
+    }
+
+    /* a sine of amplitude .5 */
+    expectedPower = .125;
+    if( fabs( power - expectedPower ) > expectedPower * .01 )
+    {
+        printf( "%s: output power %g, expected %g\n", name, power, expectedPower );
+        ok = 0;
+    }
+
+    /* the callback is not called again after it completes, and the stream
+        completes once the last user buffer and the filter tail have been
+        played, which fit in one or two host buffers */
+    data.completeAtCall = data.callCount + 1;
+    buffers = ProcessHostBuffers( &bp, hasInput, HOST_BUFFERS, &power );
+    if( data.callCount != data.completeAtCall || buffers > 2 )
+    {
+        printf( "%s: the stream completed after %d buffers and %lu calls\n", name, buffers, data.callCount );
+        ok = 0;
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    printf( "%s: %s\n", name, ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+static int SilentCallback( const void *input, void *output, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    (void) input; /* Prevent unused variable warnings. */
+    (void) output;
+    (void) frameCount;
+    (void) timeInfo;
+    (void) statusFlags;
+    (void) userData;
+
+    return paContinue;
+}
+
+/* The stage converts the input to the user's sample format, so the samples
+    it clips must be counted by the buffer processor. */
+static int TestClippedInput( void )
+{
+    static float hostInput[ HOST_FRAMES * CHANNELS ];
+    PaUtilBufferProcessor bp;
+    PaStreamCallbackTimeInfo timeInfo;
+    int callbackResult = paContinue;
+    unsigned long inputClipped, outputClipped, i;
+    int b, ok = 1;
+
+    if( PaUtil_InitializeResamplingBufferProcessor( &bp,
+            CHANNELS, paInt16, paFloat32, 0, 0, 0,
+            USER_RATE, HOST_RATE, paConvertSampleRate, USER_FRAMES, HOST_FRAMES,
+            paUtilFixedHostBufferSize, SilentCallback, NULL ) != paNoError )
+    {
+        printf( "clipped input: PaUtil_InitializeResamplingBufferProcessor failed\n" );
+        return 0;
+    }
+    PaUtil_ResetBufferProcessor( &bp );
+
+    for( i=0; i < HOST_FRAMES * CHANNELS; ++i )
+        hostInput[i] = 2.f;
+
+    memset( &timeInfo, 0, sizeof(timeInfo) );
+    for( b=0; b < 10; ++b )
+    {
+        PaUtil_BeginBufferProcessing( &bp, &timeInfo, 0 );
+        PaUtil_SetInputFrameCount( &bp, HOST_FRAMES );
+        PaUtil_SetInterleavedInputChannels( &bp, 0, hostInput, CHANNELS );
+        PaUtil_EndBufferProcessing( &bp, &callbackResult );
+    }
+
+    PaUtil_ReadBufferProcessorClippedSampleCounts( &bp, &inputClipped, &outputClipped );
+    if( inputClipped == 0 || outputClipped != 0 )
+    {
+        printf( "clipped input: %lu input and %lu output samples were counted as clipped\n",
+                inputClipped, outputClipped );
+        ok = 0;
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    printf( "clipped input: %s\n", ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+int main( void )
+{
+    int failures = 0;
+
+    printf( "patest_resampler\n" );
+
+    if( !TestSine( "fast 44.1 to 48 kHz", paUtilResamplerFast, 1e-3 ) )
+        ++failures;
+    if( !TestSine( "medium 44.1 to 48 kHz", paUtilResamplerMedium, 1e-4 ) )
+        ++failures;
+    if( !TestSine( "best 44.1 to 48 kHz", paUtilResamplerBest, 1e-5 ) )
+        ++failures;
+
+    if( !TestAliasRejection( "fast 96 to 44.1 kHz", paUtilResamplerFast, 60. ) )
+        ++failures;
+    if( !TestAliasRejection( "medium 96 to 44.1 kHz", paUtilResamplerMedium, 85. ) )
+        ++failures;
+    if( !TestAliasRejection( "best 96 to 44.1 kHz", paUtilResamplerBest, 105. ) )
+        ++failures;
+
+    if( !TestKernels() )
+        ++failures;
+
+    if( !TestStage( "full duplex stage", 1 ) )
+        ++failures;
+    if( !TestStage( "output stage", 0 ) )
+        ++failures;
+    if( !TestClippedInput() )
+        ++failures;
+
+    printf( "%d failures\n", failures );
+
+    return (failures == 0) ? 0 : 1;
+}
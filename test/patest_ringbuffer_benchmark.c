@@ -0,0 +1,315 @@
+/** @file patest_ringbuffer_benchmark.c
+    @ingroup test_src
+    @brief Measure the throughput of PaUtilRingBuffer with a producer and a
+    consumer thread contending for it.
+
+    A producer thread writes a counting sequence into the ring buffer in
+    chunks while a consumer thread reads it back and checks that every
+    element arrives in order. Each configuration is run with PaUtilRingBuffer
+    and with a copy of the previous implementation, which kept both indices
+    on one cache line and used a full memory barrier for every transfer.
+    Results are printed as CSV in elements per microsecond.
+
+    Usage:
+        patest_ringbuffer_benchmark [--quick]
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "portaudio.h"
+#include "pa_ringbuffer.h"
+#include "pa_memorybarrier.h"
+#include "pa_util.h"
+
+#define ELEMENT_COUNT       (1024)  /* ring buffer capacity */
+#define MAX_ELEMENT_SIZE    (64)
+#define MAX_CHUNK           (256)
+
+#define TRANSFER_COUNT      (1 << 24)   /* elements per timing run */
+#define QUICK_TRANSFER_COUNT (1 << 18)
+#define RUN_COUNT           (3)         /* the fastest run is reported */
+
+/* -------------------------------------------------------------------------- */
+
+/* The ring buffer as it was before the indices were moved to separate cache
+    lines: both indices share a line and every transfer issues a full barrier
+    on GCC. Only the region functions used by the benchmark are kept. */
+typedef struct
+{
+    ring_buffer_size_t bufferSize;
+    volatile ring_buffer_size_t writeIndex;
+    volatile ring_buffer_size_t readIndex;
+    ring_buffer_size_t bigMask;
+    ring_buffer_size_t smallMask;
+    ring_buffer_size_t elementSizeBytes;
+    char *buffer;
+}
+LegacyRingBuffer;
+
+static void LegacyInitialize( LegacyRingBuffer *rbuf, ring_buffer_size_t elementSizeBytes,
+        ring_buffer_size_t elementCount, void *dataPtr )
+{
+    rbuf->bufferSize = elementCount;
+    rbuf->buffer = (char *)dataPtr;
+    rbuf->writeIndex = rbuf->readIndex = 0;
+    rbuf->bigMask = (elementCount*2)-1;
+    rbuf->smallMask = (elementCount)-1;
+    rbuf->elementSizeBytes = elementSizeBytes;
+}
+
+static ring_buffer_size_t LegacyRegions( LegacyRingBuffer *rbuf, ring_buffer_size_t index,
+        ring_buffer_size_t available, ring_buffer_size_t elementCount,
+        void **dataPtr1, ring_buffer_size_t *sizePtr1, void **dataPtr2, ring_buffer_size_t *sizePtr2 )
+{
+    if( elementCount > available ) elementCount = available;
+    index &= rbuf->smallMask;
+    *dataPtr1 = &rbuf->buffer[index*rbuf->elementSizeBytes];
+    if( (index + elementCount) > rbuf->bufferSize )
+    {
+        *sizePtr1 = rbuf->bufferSize - index;
+        *dataPtr2 = &rbuf->buffer[0];
+        *sizePtr2 = elementCount - *sizePtr1;
+    }
+    else
+    {
+        *sizePtr1 = elementCount;
+        *dataPtr2 = NULL;
+        *sizePtr2 = 0;
+    }
+    return elementCount;
+}
+
+static ring_buffer_size_t LegacyWrite( LegacyRingBuffer *rbuf, const void *data, ring_buffer_size_t elementCount )
+{
+    ring_buffer_size_t available = rbuf->bufferSize - ((rbuf->writeIndex - rbuf->readIndex) & rbuf->bigMask);
+    ring_buffer_size_t size1, size2;
+    void *data1, *data2;
+
+    elementCount = LegacyRegions( rbuf, rbuf->writeIndex, available, elementCount, &data1, &size1, &data2, &size2 );
+    if( available )
+        PaUtil_FullMemoryBarrier();
+    memcpy( data1, data, size1*rbuf->elementSizeBytes );
+    if( size2 > 0 )
+        memcpy( data2, (const char *)data + size1*rbuf->elementSizeBytes, size2*rbuf->elementSizeBytes );
+    PaUtil_WriteMemoryBarrier();
+    rbuf->writeIndex = (rbuf->writeIndex + elementCount) & rbuf->bigMask;
+    return elementCount;
+}
+
+static ring_buffer_size_t LegacyRead( LegacyRingBuffer *rbuf, void *data, ring_buffer_size_t elementCount )
+{
+    ring_buffer_size_t available = (rbuf->writeIndex - rbuf->readIndex) & rbuf->bigMask;
+    ring_buffer_size_t size1, size2;
+    void *data1, *data2;
+
+    elementCount = LegacyRegions( rbuf, rbuf->readIndex, available, elementCount, &data1, &size1, &data2, &size2 );
+    if( available )
+        PaUtil_ReadMemoryBarrier();
+    memcpy( data, data1, size1*rbuf->elementSizeBytes );
+    if( size2 > 0 )
+        memcpy( (char *)data + size1*rbuf->elementSizeBytes, data2, size2*rbuf->elementSizeBytes );
+    PaUtil_FullMemoryBarrier();
+    rbuf->readIndex = (rbuf->readIndex + elementCount) & rbuf->bigMask;
+    return elementCount;
+}
+
+/* -------------------------------------------------------------------------- */
+
+typedef struct
+{
+    int legacy;
+    PaUtilRingBuffer ringBuffer;
+    LegacyRingBuffer legacyRingBuffer;
+    ring_buffer_size_t elementSize;
+    ring_buffer_size_t chunk;
+    unsigned long transferCount;
+    unsigned long errorCount;
+}
+Benchmark;
+
+static ring_buffer_size_t Write( Benchmark *b, const void *data, ring_buffer_size_t elementCount )
+{
+    return b->legacy ? LegacyWrite( &b->legacyRingBuffer, data, elementCount )
+            : PaUtil_WriteRingBuffer( &b->ringBuffer, data, elementCount );
+}
+
+static ring_buffer_size_t Read( Benchmark *b, void *data, ring_buffer_size_t elementCount )
+{
+    return b->legacy ? LegacyRead( &b->legacyRingBuffer, data, elementCount )
+            : PaUtil_ReadRingBuffer( &b->ringBuffer, data, elementCount );
+}
+
+/* The first word of every element holds its sequence number. */
+static void *ProducerThread( void *userData )
+{
+    Benchmark *b = (Benchmark*)userData;
+    unsigned char chunk[MAX_CHUNK * MAX_ELEMENT_SIZE];
+    unsigned long sent = 0;
+    ring_buffer_size_t i, count, written;
+
+    memset( chunk, 0, sizeof(chunk) );
+    while( sent < b->transferCount )
+    {
+        count = b->chunk;
+        if( (unsigned long)count > b->transferCount - sent )
+            count = (ring_buffer_size_t)(b->transferCount - sent);
+        for( i=0; i < count; ++i )
+            *(unsigned long*)&chunk[i * b->elementSize] = sent + i;
+
+        written = Write( b, chunk, count );
+        while( written < count )
+        {
+            sched_yield();
+            written += Write( b, &chunk[written * b->elementSize], count - written );
+        }
+        sent += count;
+    }
+    return NULL;
+}
+
+static void *ConsumerThread( void *userData )
+{
+    Benchmark *b = (Benchmark*)userData;
+    unsigned char chunk[MAX_CHUNK * MAX_ELEMENT_SIZE];
+    unsigned long received = 0;
+    ring_buffer_size_t i, count;
+
+    while( received < b->transferCount )
+    {
+        count = Read( b, chunk, b->chunk );
+        if( count == 0 )
+        {
+            sched_yield();
+            continue;
+        }
+        for( i=0; i < count; ++i )
+        {
+            if( *(unsigned long*)&chunk[i * b->elementSize] != received + i )
+                ++b->errorCount;
+        }
+        received += count;
+    }
+    return NULL;
+}
+
+/* Return the best throughput of RUN_COUNT runs in elements per microsecond,
+    or a negative value if elements were lost or reordered. */
+static double Measure( int legacy, ring_buffer_size_t elementSize, ring_buffer_size_t chunk,
+        unsigned long transferCount )
+{
+    static Benchmark b;
+    static unsigned char data[ELEMENT_COUNT * MAX_ELEMENT_SIZE];
+    pthread_t producer, consumer;
+    double best = 0., start, elapsed;
+    int run;
+
+    for( run=0; run < RUN_COUNT; ++run )
+    {
+        memset( &b, 0, sizeof(b) );
+        b.legacy = legacy;
+        b.elementSize = elementSize;
+        b.chunk = chunk;
+        b.transferCount = transferCount;
+        PaUtil_InitializeRingBuffer( &b.ringBuffer, elementSize, ELEMENT_COUNT, data );
+        LegacyInitialize( &b.legacyRingBuffer, elementSize, ELEMENT_COUNT, data );
+
+        start = PaUtil_GetTime();
+        pthread_create( &consumer, NULL, ConsumerThread, &b );
+        pthread_create( &producer, NULL, ProducerThread, &b );
+        pthread_join( producer, NULL );
+        pthread_join( consumer, NULL );
+        elapsed = PaUtil_GetTime() - start;
+
+        if( b.errorCount != 0 )
+            return -1.;
+        if( transferCount / (elapsed * 1e6) > best )
+            best = transferCount / (elapsed * 1e6);
+    }
+
+    return best;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int main( int argc, char **argv );
+int main( int argc, char **argv )
+{
+    static const ring_buffer_size_t elementSizes[] = { sizeof(unsigned long), MAX_ELEMENT_SIZE };
+    static const ring_buffer_size_t chunks[] = { 1, 16, MAX_CHUNK };
+    unsigned long transferCount = TRANSFER_COUNT;
+    double legacy, current;
+    int i, j, result = 0;
+
+    if( argc == 2 && strcmp( argv[1], "--quick" ) == 0 )
+        transferCount = QUICK_TRANSFER_COUNT;
+    else if( argc != 1 )
+    {
+        printf( "usage: %s [--quick]\n", argv[0] );
+        return 2;
+    }
+
+    PaUtil_InitializeClock();
+
+    printf( "elementBytes,chunk,legacyElementsPerUs,elementsPerUs,speedup\n" );
+    for( i=0; i < (int)(sizeof(elementSizes) / sizeof(elementSizes[0])); ++i )
+    {
+        for( j=0; j < (int)(sizeof(chunks) / sizeof(chunks[0])); ++j )
+        {
+            legacy = Measure( 1, elementSizes[i], chunks[j], transferCount );
+            current = Measure( 0, elementSizes[i], chunks[j], transferCount );
+            if( legacy < 0. || current < 0. )
+            {
+                printf( "FAIL: %s ring buffer lost or reordered elements (%ld bytes, chunk %ld)\n",
+                        (current < 0.) ? "new" : "legacy", (long)elementSizes[i], (long)chunks[j] );
+                result = 1;
+                continue;
+            }
+            printf( "%ld,%ld,%.3f,%.3f,%.2f\n", (long)elementSizes[i], (long)chunks[j],
+                    legacy, current, current / legacy );
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,330 @@
+/** @file patest_simd_converters.c
+    @ingroup test_src
+    @brief Verify that the SIMD converters in pa_simd_converters.c produce the
+    same output as the reference converters in pa_converters.c.
+
+    Every available instruction set is compared against the reference for a
+    range of strides and sample counts. The x86 converters must be bit-exact.
+    The converters built on the generic vector extensions may differ by one
+    LSB (see pa_simd_converters.h).
+
+    Link with pa_dither.c, pa_converters.c and pa_simd_converters.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_simd_converters.h"
+#include "pa_dither.h"
+#include "pa_types.h"
+#include "pa_endianness.h"
+
+#define MAX_SAMPLE_COUNT    (1031)
+#define MAX_STRIDE          (3)
+
+/* source kinds */
+#define FLOAT_SOURCE            (0) /* non-clipping converters are only tested with in-range input */
+#define CLIPPING_FLOAT_SOURCE   (1)
+#define INTEGER_SOURCE          (2) /* random bytes */
+#define FLOAT64_SOURCE          (3)
+#define CLIPPING_FLOAT64_SOURCE (4)
+
+typedef struct
+{
+    const char *name;
+    size_t offset;
+    int sourceKind;
+    int bytesPerSample; /* destination */
+} ConverterEntry;
+
+#define CONVERTER_ENTRY( name, sourceKind, bytesPerSample ) \
+    { #name, offsetof( PaUtilConverterTable, name ), sourceKind, bytesPerSample }
+
+static const ConverterEntry converters_[] = {
+    CONVERTER_ENTRY( Float32_To_Int32, FLOAT_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float32_To_Int32_Dither, FLOAT_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float32_To_Int32_Clip, CLIPPING_FLOAT_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float32_To_Int32_DitherClip, CLIPPING_FLOAT_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float32_To_Int24, FLOAT_SOURCE, 3 ),
+    CONVERTER_ENTRY( Float32_To_Int24_Dither, FLOAT_SOURCE, 3 ),
+    CONVERTER_ENTRY( Float32_To_Int24_Clip, CLIPPING_FLOAT_SOURCE, 3 ),
+    CONVERTER_ENTRY( Float32_To_Int24_DitherClip, CLIPPING_FLOAT_SOURCE, 3 ),
+    CONVERTER_ENTRY( Float32_To_Int24In32, FLOAT_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float32_To_Int24In32_Dither, FLOAT_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float32_To_Int24In32_Clip, CLIPPING_FLOAT_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float32_To_Int24In32_DitherClip, CLIPPING_FLOAT_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float32_To_Int16, FLOAT_SOURCE, 2 ),
+    CONVERTER_ENTRY( Float32_To_Int16_Dither, FLOAT_SOURCE, 2 ),
+    CONVERTER_ENTRY( Float32_To_Int16_Clip, CLIPPING_FLOAT_SOURCE, 2 ),
+    CONVERTER_ENTRY( Float32_To_Int16_DitherClip, CLIPPING_FLOAT_SOURCE, 2 ),
+    CONVERTER_ENTRY( Int32_To_Int24, INTEGER_SOURCE, 3 ),
+    CONVERTER_ENTRY( Int24_To_Float32, INTEGER_SOURCE, 4 ), /* compared bitwise */
+    CONVERTER_ENTRY( Int24_To_Int32, INTEGER_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float64_To_Float32, CLIPPING_FLOAT64_SOURCE, 4 ), /* compared bitwise */
+    CONVERTER_ENTRY( Float64_To_Int32, FLOAT64_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float64_To_Int32_Dither, FLOAT64_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float64_To_Int32_Clip, CLIPPING_FLOAT64_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float64_To_Int32_DitherClip, CLIPPING_FLOAT64_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float64_To_Int24, FLOAT64_SOURCE, 3 ),
+    CONVERTER_ENTRY( Float64_To_Int24_Dither, FLOAT64_SOURCE, 3 ),
+    CONVERTER_ENTRY( Float64_To_Int24_Clip, CLIPPING_FLOAT64_SOURCE, 3 ),
+    CONVERTER_ENTRY( Float64_To_Int24_DitherClip, CLIPPING_FLOAT64_SOURCE, 3 ),
+    CONVERTER_ENTRY( Float64_To_Int24In32, FLOAT64_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float64_To_Int24In32_Dither, FLOAT64_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float64_To_Int24In32_Clip, CLIPPING_FLOAT64_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float64_To_Int24In32_DitherClip, CLIPPING_FLOAT64_SOURCE, 4 ),
+    CONVERTER_ENTRY( Float64_To_Int16, FLOAT64_SOURCE, 2 ),
+    CONVERTER_ENTRY( Float64_To_Int16_Dither, FLOAT64_SOURCE, 2 ),
+    CONVERTER_ENTRY( Float64_To_Int16_Clip, CLIPPING_FLOAT64_SOURCE, 2 ),
+    CONVERTER_ENTRY( Float64_To_Int16_DitherClip, CLIPPING_FLOAT64_SOURCE, 2 )
+};
+
+#define CONVERTER_COUNT ((int)(sizeof(converters_) / sizeof(converters_[0])))
+
+static const struct { PaUtilSimdInstructionSet instructionSet; const char *name; int tolerance; }
+instructionSets_[] = {
+    { paUtilSimdGeneric, "generic", 1 },
+    { paUtilSimdSse2, "SSE2", 0 },
+    { paUtilSimdSsse3, "SSSE3", 0 },
+    { paUtilSimdAvx2, "AVX2", 0 }
+};
+
+#define INSTRUCTION_SET_COUNT ((int)(sizeof(instructionSets_) / sizeof(instructionSets_[0])))
+
+static const unsigned int counts_[] = { 0, 1, 3, 7, 8, 9, 63, 64, 65, 200, MAX_SAMPLE_COUNT };
+static const int strides_[][2] = { { 1, 1 }, { 2, 1 }, { 1, 2 }, { MAX_STRIDE, 2 } }; /* { source, destination } */
+
+static PaUtilConverter* GetConverter( const PaUtilConverterTable *table, int index )
+{
+    return *(PaUtilConverter* const*)((const char*)table + converters_[index].offset);
+}
+
+static PaInt32 DecodeSample( const unsigned char *p, int bytesPerSample )
+{
+    PaInt32 result;
+
+    switch( bytesPerSample )
+    {
+    case 2:
+        result = *(const PaInt16*)p;
+        break;
+    case 3:
+#if defined(PA_LITTLE_ENDIAN)
+        result = (PaInt32)(((unsigned long)p[0] << 8) | ((unsigned long)p[1] << 16) | ((unsigned long)p[2] << 24)) >> 8;
+#elif defined(PA_BIG_ENDIAN)
+        result = (PaInt32)(((unsigned long)p[2] << 8) | ((unsigned long)p[1] << 16) | ((unsigned long)p[0] << 24)) >> 8;
+#endif
+        break;
+    default:
+        result = *(const PaInt32*)p;
+        break;
+    }
+
+    return result;
+}
+
+static void GenerateRandomBytes( unsigned char *buffer, int count )
+{
+    unsigned long seed = 33333;
+    int i;
+
+    for( i=0; i < count; ++i )
+    {
+        seed = (seed * 196314165) + 907633515;
+        buffer[i] = (unsigned char)(seed >> 16);
+    }
+}
+
+/* fill with pseudo random values in [-range, range) plus a few edge cases */
+static void GenerateInput( float *buffer, int count, float range )
+{
+    static const float edges[] = { 0.f, -0.f, 1.f, -1.f, .5f, -.5f, 0.999f, -0.999f,
+            1.0001f, -1.0001f, 2.f, -2.f, 1.f / 32768.f, -1.f / 32768.f };
+    unsigned long seed = 22222;
+    int i;
+
+    for( i=0; i < count; ++i )
+    {
+        seed = (seed * 196314165) + 907633515;
+        buffer[i] = range * (((float)((seed >> 8) & 0xFFFF) / 32768.f) - 1.f);
+    }
+
+    for( i=0; i < (int)(sizeof(edges) / sizeof(edges[0])) && i < count; ++i )
+    {
+        if( edges[i] <= range && edges[i] >= -range )
+            buffer[ (i * 37) % count ] = edges[i];
+    }
+}
+
+/* compares the fields one by one, as the struct may contain padding */
+static int DitherStatesAreEqual( const PaUtilTriangularDitherGenerator *a,
+        const PaUtilTriangularDitherGenerator *b )
+{
+    return a->previous == b->previous
+            && a->randSeed1 == b->randSeed1
+            && a->randSeed2 == b->randSeed2
+            && a->shapingError1 == b->shapingError1
+            && a->shapingError2 == b->shapingError2
+            && a->clippedSampleCount == b->clippedSampleCount;
+}
+
+/* as GenerateInput() but with values which are not representable as floats */
+static void GenerateFloat64Input( double *buffer, int count, double range )
+{
+    static const double edges[] = { 0., -0., 1., -1., .5, -.5, 0.999, -0.999,
+            1.0001, -1.0001, 2., -2., 1. / 32768., -1. / 32768., 1. / 2147483648. };
+    unsigned long seed = 22222;
+    int i;
+
+    for( i=0; i < count; ++i )
+    {
+        seed = (seed * 196314165) + 907633515;
+        buffer[i] = range * (((double)((seed >> 4) & 0x0FFFFFFFUL) / 134217728.) - 1.);
+    }
+
+    for( i=0; i < (int)(sizeof(edges) / sizeof(edges[0])) && i < count; ++i )
+    {
+        if( edges[i] <= range && edges[i] >= -range )
+            buffer[ (i * 37) % count ] = edges[i];
+    }
+}
+
+int main( void )
+{
+    static double sourceBuffer[ MAX_SAMPLE_COUNT * MAX_STRIDE ]; /* also holds the float sources */
+    float *source = (float*)sourceBuffer;
+    static unsigned char expected[ MAX_SAMPLE_COUNT * MAX_STRIDE * 4 ];
+    static unsigned char actual[ MAX_SAMPLE_COUNT * MAX_STRIDE * 4 ];
+    PaUtilConverterTable reference = paConverters; /* Pa_Initialize() has not been called */
+    PaUtilConverterTable simd;
+    PaUtilTriangularDitherGenerator expectedDither, actualDither;
+    unsigned int available = PaUtil_GetAvailableSimdInstructionSets();
+    int i, j, s, c, k, failures = 0, tested = 0;
+
+    printf( "Available SIMD instruction sets: 0x%X\n", available );
+
+    for( i=0; i < INSTRUCTION_SET_COUNT; ++i )
+    {
+        if( (available & instructionSets_[i].instructionSet) == 0 )
+        {
+            printf( "%s: not available, skipped\n", instructionSets_[i].name );
+            continue;
+        }
+
+        memset( &simd, 0, sizeof(simd) );
+        PaUtil_GetSimdConverters( &simd, instructionSets_[i].instructionSet );
+
+        for( j=0; j < CONVERTER_COUNT; ++j )
+        {
+            PaUtilConverter *expectedConverter = GetConverter( &reference, j );
+            PaUtilConverter *actualConverter = GetConverter( &simd, j );
+            int bytesPerSample = converters_[j].bytesPerSample;
+            int maxDifference = 0;
+            int ok = 1;
+
+            if( actualConverter == NULL )
+                continue; /* not implemented for this instruction set */
+
+            if( converters_[j].sourceKind == INTEGER_SOURCE )
+                GenerateRandomBytes( (unsigned char*)sourceBuffer, sizeof(sourceBuffer) );
+            else if( converters_[j].sourceKind >= FLOAT64_SOURCE )
+                GenerateFloat64Input( sourceBuffer, MAX_SAMPLE_COUNT * MAX_STRIDE,
+                        (converters_[j].sourceKind == CLIPPING_FLOAT64_SOURCE) ? 2.5 : 0.999 );
+            else
+                GenerateInput( source, MAX_SAMPLE_COUNT * MAX_STRIDE,
+                        (converters_[j].sourceKind == CLIPPING_FLOAT_SOURCE) ? 2.5f : 0.999f );
+
+            for( s=0; s < (int)(sizeof(strides_) / sizeof(strides_[0])); ++s )
+            {
+                int sourceStride = strides_[s][0];
+                int destinationStride = strides_[s][1];
+
+                for( c=0; c < (int)(sizeof(counts_) / sizeof(counts_[0])); ++c )
+                {
+                    unsigned int count = counts_[c];
+
+                    memset( expected, 0xA5, sizeof(expected) );
+                    memset( actual, 0xA5, sizeof(actual) );
+                    PaUtil_InitializeTriangularDitherState( &expectedDither );
+                    PaUtil_InitializeTriangularDitherState( &actualDither );
+
+                    expectedConverter( expected, destinationStride, source, sourceStride, count, &expectedDither );
+                    actualConverter( actual, destinationStride, source, sourceStride, count, &actualDither );
+
+                    if( !DitherStatesAreEqual( &expectedDither, &actualDither ) )
+                        ok = 0; /* dither generator must be consumed identically */
+
+                    for( k=0; k < (int)(count * destinationStride); ++k )
+                    {
+                        PaInt32 e = DecodeSample( expected + k * bytesPerSample, bytesPerSample );
+                        PaInt32 a = DecodeSample( actual + k * bytesPerSample, bytesPerSample );
+                        PaInt32 difference = (e > a) ? e - a : a - e;
+
+                        if( (k % destinationStride) != 0 && e != a )
+                            ok = 0; /* samples between the strided ones must not be written */
+                        if( difference > maxDifference )
+                            maxDifference = difference;
+                    }
+                    if( memcmp( expected + count * destinationStride * bytesPerSample,
+                            actual + count * destinationStride * bytesPerSample,
+                            sizeof(expected) - count * destinationStride * bytesPerSample ) != 0 )
+                        ok = 0; /* nothing may be written past the end */
+
+                    ++tested;
+                }
+            }
+
+            if( maxDifference > instructionSets_[i].tolerance )
+                ok = 0;
+
+            printf( "%s %-30s max difference %d LSB: %s\n", instructionSets_[i].name,
+                    converters_[j].name, maxDifference, ok ? "PASSED" : "FAILED" );
+            if( !ok )
+                ++failures;
+        }
+    }
+
+    printf( "%d comparisons, %d failures\n", tested, failures );
+
+    return (failures == 0) ? 0 : 1;
+}
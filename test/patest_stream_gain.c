@@ -0,0 +1,269 @@
+/** @file patest_stream_gain.c
+    @ingroup test_src
+    @brief Verify that the output gain of a buffer processor scales the
+    output, ramps linearly and sample accurately to a new gain, fades in on
+    start and out on request, works for formats other than paFloat32, and
+    that a gain of 1 leaves the output pass-through.
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_process.h"
+
+#define CHANNEL_COUNT       (2)
+#define HOST_FRAMES         (300)   /* more than one block of the gain stage */
+#define RAMP_FRAMES         (450)
+#define VALUE               (0.5f)
+
+static int StreamCallback( const void *input, void *output, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    unsigned long i;
+
+    (void) input; /* Prevent unused variable warnings. */
+    (void) timeInfo;
+    (void) statusFlags;
+    (void) userData;
+
+    for( i=0; i < frameCount * CHANNEL_COUNT; ++i )
+        ((float*)output)[i] = VALUE;
+
+    return paContinue;
+}
+
+/* Runs one host buffer through bp and checks that frame i of every channel
+    holds VALUE * gains[i]. */
+static int CheckHostBuffer( const char *name, PaUtilBufferProcessor *bp, const float *gains )
+{
+    static float hostOutputStorage[ HOST_FRAMES * CHANNEL_COUNT + 16 ];
+    /* host buffers are only passed through when they are aligned to 64 bytes */
+    float *hostOutput = (float*)(((size_t)hostOutputStorage + 63) & ~(size_t)63);
+    PaStreamCallbackTimeInfo timeInfo;
+    int callbackResult = paContinue;
+    unsigned long i;
+    int c;
+
+    memset( &timeInfo, 0, sizeof(timeInfo) );
+    for( i=0; i < HOST_FRAMES * CHANNEL_COUNT; ++i )
+        hostOutput[i] = 1234.f;
+
+    PaUtil_BeginBufferProcessing( bp, &timeInfo, 0 );
+    PaUtil_SetOutputFrameCount( bp, HOST_FRAMES );
+    PaUtil_SetInterleavedOutputChannels( bp, 0, hostOutput, CHANNEL_COUNT );
+    PaUtil_EndBufferProcessing( bp, &callbackResult );
+
+    for( i=0; i < HOST_FRAMES; ++i )
+    {
+        for( c=0; c < CHANNEL_COUNT; ++c )
+        {
+            float expected = VALUE * gains[i];
+            float sample = hostOutput[ i * CHANNEL_COUNT + c ];
+
+            if( sample < expected - 1e-5f || sample > expected + 1e-5f )
+            {
+                printf( "%s: frame %lu of channel %d holds %g instead of %g\n", name, i, c, sample, expected );
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+static void ConstantGains( float *gains, float gain )
+{
+    int i;
+
+    for( i=0; i < HOST_FRAMES; ++i )
+        gains[i] = gain;
+}
+
+static int TestFloat32( void )
+{
+    const char *name = "paFloat32";
+    PaUtilBufferProcessor bp;
+    float gains[ HOST_FRAMES ];
+    unsigned long request;
+    int i, ok = 1;
+
+    if( PaUtil_InitializeBufferProcessor( &bp, 0, 0, 0,
+            CHANNEL_COUNT, paFloat32, paFloat32,
+            44100., paNoFlag, 0, HOST_FRAMES,
+            paUtilFixedHostBufferSize, StreamCallback, NULL ) != paNoError )
+    {
+        printf( "%s: PaUtil_InitializeBufferProcessor failed\n", name );
+        return 0;
+    }
+
+    /* unity gain leaves the host buffer to the callback */
+    ConstantGains( gains, 1.f );
+    ok = CheckHostBuffer( name, &bp, gains );
+    if( ok && !(PaUtil_GetBufferProcessorStreamInfoFlags( &bp ) & paStreamInfoOutputPassThrough) )
+    {
+        printf( "%s: unity gain is not passed through\n", name );
+        ok = 0;
+    }
+
+    /* a constant gain, then a ramp over 1.5 host buffers down to 0.25 */
+    PaUtil_SetBufferProcessorOutputGain( &bp, .5f, 0 );
+    ConstantGains( gains, .5f );
+    ok = ok && CheckHostBuffer( name, &bp, gains );
+
+    PaUtil_SetBufferProcessorOutputGain( &bp, .25f, RAMP_FRAMES );
+    for( i=0; i < HOST_FRAMES; ++i )
+        gains[i] = .5f - .25f * (float)(i + 1) / RAMP_FRAMES;
+    ok = ok && CheckHostBuffer( name, &bp, gains );
+    for( i=0; i < HOST_FRAMES; ++i )
+        gains[i] = i + HOST_FRAMES < RAMP_FRAMES ? .5f - .25f * (float)(i + HOST_FRAMES + 1) / RAMP_FRAMES : .25f;
+    ok = ok && CheckHostBuffer( name, &bp, gains );
+
+    /* fade in from silence on start, then fade out */
+    PaUtil_SetBufferProcessorOutputFades( &bp, HOST_FRAMES, HOST_FRAMES / 2 );
+    PaUtil_StartBufferProcessorOutputGain( &bp );
+    for( i=0; i < HOST_FRAMES; ++i )
+        gains[i] = .25f * (float)(i + 1) / HOST_FRAMES;
+    ok = ok && CheckHostBuffer( name, &bp, gains );
+
+    request = PaUtil_FadeOutBufferProcessorOutput( &bp );
+    if( ok && PaUtil_IsBufferProcessorOutputGainRequestDone( &bp, request ) )
+    {
+        printf( "%s: the fade out is done before it was processed\n", name );
+        ok = 0;
+    }
+    for( i=0; i < HOST_FRAMES; ++i )
+        gains[i] = i < HOST_FRAMES / 2 ? .25f - .25f * (float)(i + 1) / (HOST_FRAMES / 2) : 0.f;
+    ok = ok && CheckHostBuffer( name, &bp, gains );
+    if( ok && !PaUtil_IsBufferProcessorOutputGainRequestDone( &bp, request ) )
+    {
+        printf( "%s: the fade out is not done\n", name );
+        ok = 0;
+    }
+
+    /* silence, and the gain of the next start is the one set last */
+    ConstantGains( gains, 0.f );
+    ok = ok && CheckHostBuffer( name, &bp, gains );
+    PaUtil_SetBufferProcessorOutputFades( &bp, 0, 0 );
+    PaUtil_StartBufferProcessorOutputGain( &bp );
+    ConstantGains( gains, .25f );
+    ok = ok && CheckHostBuffer( name, &bp, gains );
+
+    /* back to unity */
+    PaUtil_SetBufferProcessorOutputGain( &bp, 1.f, 0 );
+    ConstantGains( gains, 1.f );
+    ok = ok && CheckHostBuffer( name, &bp, gains );
+    if( ok && !(PaUtil_GetBufferProcessorStreamInfoFlags( &bp ) & paStreamInfoOutputPassThrough) )
+    {
+        printf( "%s: unity gain is not passed through after a gain was applied\n", name );
+        ok = 0;
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    printf( "%s: %s\n", name, ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+static int TestInt16( void )
+{
+    const char *name = "paInt16";
+    PaUtilBufferProcessor bp;
+    static short userOutput[ HOST_FRAMES * CHANNEL_COUNT ];
+    static short hostOutput[ HOST_FRAMES * CHANNEL_COUNT ];
+    const void *source = userOutput;
+    int i, ok = 1;
+
+    if( PaUtil_InitializeBufferProcessor( &bp, 0, 0, 0,
+            CHANNEL_COUNT, paInt16, paInt16,
+            44100., paDitherOff, 0, HOST_FRAMES,
+            paUtilFixedHostBufferSize, NULL, NULL ) != paNoError )
+    {
+        printf( "%s: PaUtil_InitializeBufferProcessor failed\n", name );
+        return 0;
+    }
+
+    if( PaUtil_SetBufferProcessorOutputGain( &bp, .5f, 0 ) != paNoError )
+    {
+        printf( "%s: PaUtil_SetBufferProcessorOutputGain failed\n", name );
+        ok = 0;
+    }
+
+    for( i=0; i < HOST_FRAMES * CHANNEL_COUNT; ++i )
+        userOutput[i] = (short)(i * 64 - 16000);
+
+    PaUtil_SetOutputFrameCount( &bp, HOST_FRAMES );
+    PaUtil_SetInterleavedOutputChannels( &bp, 0, hostOutput, CHANNEL_COUNT );
+    PaUtil_CopyOutput( &bp, &source, HOST_FRAMES );
+
+    for( i=0; i < HOST_FRAMES * CHANNEL_COUNT && ok; ++i )
+    {
+        /* allow for rounding */
+        int difference = hostOutput[i] - userOutput[i] / 2;
+        if( difference < -1 || difference > 1 )
+        {
+            printf( "%s: sample %d holds %d instead of %d\n", name, i, hostOutput[i], userOutput[i] / 2 );
+            ok = 0;
+        }
+    }
+
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    printf( "%s: %s\n", name, ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+int main( void )
+{
+    int failures = 0;
+
+    printf( "patest_stream_gain: %d channels, host buffers of %d frames\n", CHANNEL_COUNT, HOST_FRAMES );
+
+    if( !TestFloat32() )
+        ++failures;
+    if( !TestInt16() )
+        ++failures;
+
+    printf( "%d failures\n", failures );
+
+    return (failures == 0) ? 0 : 1;
+}
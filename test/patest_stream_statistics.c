@@ -0,0 +1,205 @@
+/** @file patest_stream_statistics.c
+    @ingroup test_src
+    @brief Check the callback timing histograms and deadline miss count of
+    PaUtilCpuLoadMeasurer, and the xrun counts of the buffer processor, which
+    are reported by Pa_GetStreamStatistics().
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_cpuload.h"
+#include "pa_process.h"
+
+#define SAMPLE_RATE         (48000.)
+#define FRAMES              (480)   /* 10 ms */
+#define CALLBACK_COUNT      (20)
+#define SLOW_CALLBACK       (7)     /* this one sleeps past its deadline */
+#define CHANNEL_COUNT       (2)
+
+static int failureCount_ = 0;
+
+#define CHECK( condition, message ) \
+    do{ if( !(condition) ){ printf( "FAIL: %s\n", message ); ++failureCount_; } }while(0)
+
+static int IsNear( double value, double expected )
+{
+    return value > expected * .999999 && value < expected * 1.000001;
+}
+
+static void TestPercentiles( void )
+{
+    unsigned long histogram[PA_CPULOAD_HISTOGRAM_BUCKETS];
+
+    memset( histogram, 0, sizeof(histogram) );
+    CHECK( PaUtil_GetCpuLoadHistogramPercentile( histogram, .5 ) == 0., "empty histogram has a percentile" );
+
+    histogram[0] = 1;
+    CHECK( IsNear( PaUtil_GetCpuLoadHistogramPercentile( histogram, 1. ), .000001 ), "wrong limit of bucket 0" );
+
+    /* bucket 5 holds 2 to 2.5 microseconds, bucket 9 4 to 5 */
+    histogram[0] = 0;
+    histogram[5] = 99;
+    histogram[9] = 1;
+    CHECK( IsNear( PaUtil_GetCpuLoadHistogramPercentile( histogram, .5 ), .0000025 ), "wrong median" );
+    CHECK( IsNear( PaUtil_GetCpuLoadHistogramPercentile( histogram, .99 ), .0000025 ), "wrong 99th percentile" );
+    CHECK( IsNear( PaUtil_GetCpuLoadHistogramPercentile( histogram, 1. ), .000005 ), "wrong maximum" );
+}
+
+static void TestCpuLoadMeasurer( void )
+{
+    PaUtilCpuLoadMeasurer measurer;
+    PaUtilCpuLoadStatistics statistics;
+    double median, maximum, jitter;
+    int i;
+
+    PaUtil_InitializeCpuLoadMeasurer( &measurer, SAMPLE_RATE );
+
+    /* the callbacks return at once, except for the slow one, and start again
+        10 ms after the previous start */
+    for( i=0; i < CALLBACK_COUNT; ++i )
+    {
+        PaUtil_BeginCpuLoadMeasurement( &measurer );
+        Pa_Sleep( i == SLOW_CALLBACK ? 15 : 0 );
+        PaUtil_EndCpuLoadMeasurement( &measurer, FRAMES );
+        if( i != SLOW_CALLBACK )
+            Pa_Sleep( 10 );
+    }
+
+    PaUtil_ReadCpuLoadStatistics( &measurer, &statistics );
+    median = PaUtil_GetCpuLoadHistogramPercentile( statistics.durationHistogram, .5 );
+    maximum = PaUtil_GetCpuLoadHistogramPercentile( statistics.durationHistogram, 1. );
+    jitter = PaUtil_GetCpuLoadHistogramPercentile( statistics.jitterHistogram, 1. );
+    printf( "%lu measurements, %lu deadline misses, median %.6f s, max %.6f s, max jitter %.6f s\n",
+            statistics.measurementCount, statistics.deadlineMissCount, median, maximum, jitter );
+
+    CHECK( statistics.measurementCount == CALLBACK_COUNT, "wrong measurement count" );
+    CHECK( statistics.deadlineMissCount == 1, "wrong deadline miss count" );
+    CHECK( median < .005, "median duration is too long" );
+    CHECK( maximum >= .015, "maximum duration is too short" );
+    CHECK( jitter >= .004, "the slow callback's late start wasn't counted as jitter" );
+
+    /* reading resets the counters */
+    PaUtil_ReadCpuLoadStatistics( &measurer, &statistics );
+    CHECK( statistics.measurementCount == 0 && statistics.deadlineMissCount == 0,
+            "counters weren't reset" );
+    CHECK( PaUtil_GetCpuLoadHistogramPercentile( statistics.durationHistogram, 1. ) == 0.,
+            "duration histogram wasn't reset" );
+
+    /* the time the stream was stopped isn't jitter */
+    PaUtil_ResetCpuLoadMeasurer( &measurer );
+    PaUtil_BeginCpuLoadMeasurement( &measurer );
+    PaUtil_EndCpuLoadMeasurement( &measurer, FRAMES );
+    PaUtil_ReadCpuLoadStatistics( &measurer, &statistics );
+    CHECK( statistics.measurementCount == 1, "measurement after a reset wasn't counted" );
+    CHECK( PaUtil_GetCpuLoadHistogramPercentile( statistics.jitterHistogram, 1. ) == 0.,
+            "jitter counted across a reset" );
+}
+
+static int StreamCallback( const void *input, void *output, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    (void) input; /* Prevent unused variable warnings. */
+    (void) timeInfo;
+    (void) statusFlags;
+    (void) userData;
+
+    memset( output, 0, frameCount * CHANNEL_COUNT * sizeof(float) );
+    return paContinue;
+}
+
+static void TestXrunCounts( void )
+{
+    static const PaStreamCallbackFlags flags[] = {
+        paOutputUnderflow, 0, paInputOverflow | paOutputUnderflow, paPrimingOutput, paInputUnderflow
+    };
+    static float hostOutput[ FRAMES * CHANNEL_COUNT ];
+    PaUtilBufferProcessor bp;
+    PaStreamCallbackTimeInfo timeInfo;
+    PaUtilXrunCounts counts;
+    int callbackResult = paContinue;
+    int i;
+
+    if( PaUtil_InitializeBufferProcessor( &bp, 0, 0, 0,
+            CHANNEL_COUNT, paFloat32, paFloat32,
+            SAMPLE_RATE, paNoFlag, FRAMES, FRAMES,
+            paUtilFixedHostBufferSize, StreamCallback, NULL ) != paNoError )
+    {
+        CHECK( 0, "PaUtil_InitializeBufferProcessor failed" );
+        return;
+    }
+
+    for( i=0; i < (int)(sizeof(flags) / sizeof(flags[0])); ++i )
+    {
+        memset( &timeInfo, 0, sizeof(timeInfo) );
+        PaUtil_BeginBufferProcessing( &bp, &timeInfo, flags[i] );
+        PaUtil_SetOutputFrameCount( &bp, FRAMES );
+        PaUtil_SetInterleavedOutputChannels( &bp, 0, hostOutput, CHANNEL_COUNT );
+        PaUtil_EndBufferProcessing( &bp, &callbackResult );
+    }
+
+    /* as done by host APIs for blocking streams */
+    PaUtil_CountBufferProcessorXruns( &bp, paOutputOverflow );
+
+    PaUtil_ReadBufferProcessorXrunCounts( &bp, &counts );
+    printf( "xruns: %lu input underflows, %lu input overflows, %lu output underflows, %lu output overflows\n",
+            counts.inputUnderflows, counts.inputOverflows, counts.outputUnderflows, counts.outputOverflows );
+    CHECK( counts.inputUnderflows == 1 && counts.inputOverflows == 1
+            && counts.outputUnderflows == 2 && counts.outputOverflows == 1, "wrong xrun counts" );
+
+    PaUtil_ReadBufferProcessorXrunCounts( &bp, &counts );
+    CHECK( counts.inputUnderflows == 0 && counts.inputOverflows == 0
+            && counts.outputUnderflows == 0 && counts.outputOverflows == 0, "xrun counts weren't reset" );
+
+    PaUtil_TerminateBufferProcessor( &bp );
+}
+
+int main(void);
+int main(void)
+{
+    TestPercentiles();
+    TestCpuLoadMeasurer();
+    TestXrunCounts();
+
+    printf( "%d failures\n", failureCount_ );
+    return failureCount_ ? 1 : 0;
+}
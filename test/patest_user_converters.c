@@ -0,0 +1,236 @@
+/** @file patest_user_converters.c
+    @ingroup test_src
+    @brief Verify that converters registered with Pa_RegisterConverter() or
+    installed with PaUtil_SetBufferProcessorConverters() are used by the
+    buffer processor in place of the built-in ones.
+
+    Link with the PortAudio library built with private symbols.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_process.h"
+
+#define CHANNEL_COUNT       (2)
+#define HOST_FRAMES         (64)
+
+/* a fused gain and copy */
+static void HalfGain_Float32( void *destinationBuffer, signed int destinationStride,
+        void *sourceBuffer, signed int sourceStride,
+        unsigned int count, struct PaSampleConverterState *state )
+{
+    float *src = (float*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    (void) state; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = *src * .5f;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+static void Constant_Int16( void *destinationBuffer, signed int destinationStride,
+        void *sourceBuffer, signed int sourceStride,
+        unsigned int count, struct PaSampleConverterState *state )
+{
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    (void) sourceBuffer; /* unused parameters */
+    (void) sourceStride;
+    (void) state;
+
+    while( count-- )
+    {
+        *dest = 1234;
+        dest += destinationStride;
+    }
+}
+
+static int StreamCallback( const void *input, void *output, unsigned long frameCount,
+        const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    float *out = (float*)output;
+    unsigned long i;
+
+    (void) input; /* Prevent unused variable warnings. */
+    (void) timeInfo;
+    (void) statusFlags;
+    (void) userData;
+
+    for( i=0; i < frameCount * CHANNEL_COUNT; ++i )
+        out[i] = 1.f;
+
+    return paContinue;
+}
+
+/* run one host buffer through an output only buffer processor */
+static void RunBufferProcessor( PaUtilBufferProcessor *bp, void *hostOutput )
+{
+    PaStreamCallbackTimeInfo timeInfo;
+    int callbackResult = paContinue;
+
+    memset( &timeInfo, 0, sizeof(timeInfo) );
+    PaUtil_BeginBufferProcessing( bp, &timeInfo, 0 );
+    PaUtil_SetOutputFrameCount( bp, HOST_FRAMES );
+    PaUtil_SetInterleavedOutputChannels( bp, 0, hostOutput, CHANNEL_COUNT );
+    PaUtil_EndBufferProcessing( bp, &callbackResult );
+}
+
+static int TestSelection( void )
+{
+    int ok = 1, count = 0;
+    PaSampleFormat source, destination;
+
+    if( Pa_RegisterConverter( paFloat32, paInt16, paNoFlag, Constant_Int16 ) != paNoError
+            || PaUtil_SelectConverter( paFloat32, paInt16 | paNonInterleaved, paNoFlag ) != Constant_Int16
+            || PaUtil_SelectConverter( paFloat32, paInt16, paPrimeOutputBuffersUsingStreamCallback ) != Constant_Int16
+            || PaUtil_SelectConverter( paFloat32, paInt16, paClipOff ) != paConverters.Float32_To_Int16_Dither
+            || PaUtil_SelectConverter( paFloat32, paInt32, paNoFlag ) != paConverters.Float32_To_Int32_DitherClip )
+        ok = 0;
+
+    if( Pa_RegisterConverter( paFloat32, paInt16, paNoFlag, NULL ) != paNoError
+            || PaUtil_SelectConverter( paFloat32, paInt16, paNoFlag ) != paConverters.Float32_To_Int16_DitherClip )
+        ok = 0;
+
+    if( Pa_RegisterConverter( paCustomFormat, paInt16, paNoFlag, Constant_Int16 ) != paSampleFormatNotSupported
+            || Pa_RegisterConverter( paFloat32, paInt16 | paInt8, paNoFlag, Constant_Int16 ) != paSampleFormatNotSupported
+            || Pa_RegisterConverter( paFloat32, paInt16, paNeverDropInput, Constant_Int16 ) != paInvalidFlag )
+        ok = 0;
+
+    /* fill the table, then empty it again */
+    for( source=paFloat32; source <= paInt24In32; source <<= 1 )
+    {
+        for( destination=paFloat32; destination <= paInt24In32; destination <<= 1 )
+        {
+            PaError error = Pa_RegisterConverter( source, destination, paNoFlag, Constant_Int16 );
+
+            if( error == paNoError )
+                ++count;
+            else if( error != paInsufficientMemory )
+                ok = 0;
+        }
+    }
+    if( count == 0 || count == 64 )
+        ok = 0; /* the table is not expected to hold every combination */
+    for( source=paFloat32; source <= paInt24In32; source <<= 1 )
+    {
+        for( destination=paFloat32; destination <= paInt24In32; destination <<= 1 )
+            Pa_RegisterConverter( source, destination, paNoFlag, NULL );
+    }
+    if( PaUtil_SelectConverter( paFloat32, paFloat32, paNoFlag ) != paConverters.Copy_32_To_32 )
+        ok = 0;
+
+    printf( "converter registration: %s\n", ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+static int TestBufferProcessor( void )
+{
+    static float floatOutput[ HOST_FRAMES * CHANNEL_COUNT ];
+    static PaInt16 int16Output[ HOST_FRAMES * CHANNEL_COUNT ];
+    PaUtilBufferProcessor bp;
+    int i, ok = 1;
+
+    /* a converter registered for equal formats replaces the copy */
+    Pa_RegisterConverter( paFloat32, paFloat32, paNoFlag, HalfGain_Float32 );
+    if( PaUtil_InitializeBufferProcessor( &bp, 0, 0, 0,
+            CHANNEL_COUNT, paFloat32, paFloat32,
+            44100., paNoFlag, HOST_FRAMES, HOST_FRAMES,
+            paUtilFixedHostBufferSize, StreamCallback, NULL ) != paNoError )
+    {
+        printf( "PaUtil_InitializeBufferProcessor failed\n" );
+        return 0;
+    }
+    Pa_RegisterConverter( paFloat32, paFloat32, paNoFlag, NULL );
+
+    RunBufferProcessor( &bp, floatOutput );
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    for( i=0; i < HOST_FRAMES * CHANNEL_COUNT; ++i )
+    {
+        if( floatOutput[i] != .5f )
+            ok = 0;
+    }
+
+    /* replacing the converter of an open buffer processor */
+    if( PaUtil_InitializeBufferProcessor( &bp, 0, 0, 0,
+            CHANNEL_COUNT, paFloat32, paInt16,
+            44100., paNoFlag, HOST_FRAMES, HOST_FRAMES,
+            paUtilFixedHostBufferSize, StreamCallback, NULL ) != paNoError )
+    {
+        printf( "PaUtil_InitializeBufferProcessor failed\n" );
+        return 0;
+    }
+
+    RunBufferProcessor( &bp, int16Output );
+    if( int16Output[0] < 32765 ) /* 1.0 with dither */
+        ok = 0;
+
+    PaUtil_SetBufferProcessorConverters( &bp, NULL, Constant_Int16 );
+    RunBufferProcessor( &bp, int16Output );
+    PaUtil_TerminateBufferProcessor( &bp );
+
+    for( i=0; i < HOST_FRAMES * CHANNEL_COUNT; ++i )
+    {
+        if( int16Output[i] != 1234 )
+            ok = 0;
+    }
+
+    printf( "buffer processor with user converters: %s\n", ok ? "PASSED" : "FAILED" );
+    return ok;
+}
+
+int main( void )
+{
+    int failures = 0;
+
+    if( !TestSelection() )
+        ++failures;
+    if( !TestBufferProcessor() )
+        ++failures;
+
+    printf( "%d failures\n", failures );
+
+    return (failures == 0) ? 0 : 1;
+}